@@ -19,10 +19,13 @@
 #define __itkAdaBoost_h
 
 #include "itkCSVArray2DDataObject.h"
+#include "itkMultiThreader.h"
 #include "itkObject.h"
 #include "itkProcessObject.h"
 #include "itkVectorContainer.h"
 
+#include "vnl/vnl_vector.h"
+
 #include <vector>
 
 namespace itk
@@ -247,6 +250,12 @@ private:
 
 /** \class AdaBoost
  *
+ * Each feature column of the training observations is sorted once before
+ * training into a column-major index, so that every boosting iteration
+ * only has to sweep the presorted columns with the current weights.  The
+ * features are swept in parallel.  For very large numbers of observations
+ * the columns can instead be binned once into equal-frequency histograms
+ * and the thresholds are then only searched at the bin boundaries.
  */
 
 template<class TStrongClassifier>
@@ -286,6 +295,20 @@ public:
   itkSetMacro( NumberOfIterations, unsigned int );
   itkGetConstMacro( NumberOfIterations, unsigned int );
 
+  /** Set/Get the number of threads used to search the features. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
+  /** Set/Get whether the thresholds are searched at the bin boundaries of
+   * equal-frequency histograms instead of at every observation. */
+  itkSetMacro( UseHistogramApproximation, bool );
+  itkGetConstMacro( UseHistogramApproximation, bool );
+  itkBooleanMacro( UseHistogramApproximation );
+
+  /** Set/Get the number of histogram bins per feature. */
+  itkSetClampMacro( NumberOfHistogramBins, unsigned int, 2, 65535 );
+  itkGetConstMacro( NumberOfHistogramBins, unsigned int );
+
   /** Add a single training observation (presumably with multiple features) */
   void AddTrainingObservation( MembershipSignType, SingleObservationContainerType & );
 
@@ -303,6 +326,45 @@ protected:
 
   void PrintSelf( std::ostream& os, Indent indent ) const;
 
+  typedef vnl_vector<RealType>                                WeightsType;
+
+  /** Sort (or bin) the column of a single feature. */
+  void PresortFeature( unsigned int );
+
+  /** Find the best threshold of a single feature for the current weights. */
+  void FindOptimalThreshold( unsigned int, const WeightsType &, RealType,
+    RealType &, MembershipSignType &, RealType & ) const;
+
+  /** Same as above at the histogram bin boundaries only. */
+  void FindOptimalHistogramThreshold( unsigned int, const WeightsType &, RealType,
+    RealType &, MembershipSignType &, RealType & ) const;
+
+  /** Static functions used by the multi-threaded passes. */
+  static ITK_THREAD_RETURN_TYPE PresortThreaderCallback( void *arg );
+  static ITK_THREAD_RETURN_TYPE FindOptimalThresholdsThreaderCallback( void *arg );
+
+  /** Internal structure used for passing the state to the threads. */
+  struct TrainingThreadStruct
+  {
+    Self                                         *AdaBoost;
+    unsigned int                                  NumberOfFeatures;
+    const WeightsType                            *Weights;
+    RealType                                      SumOfForegroundWeights;
+    std::vector<RealType>                         Thresholds;
+    std::vector<MembershipSignType>               MembershipSigns;
+    std::vector<RealType>                         WeightedRates;
+  };
+
+  /** Orders observation indices by the value of a single feature. */
+  struct FeatureValueCompare
+  {
+    const RealType *Values;
+    bool operator()( unsigned int i, unsigned int j ) const
+      {
+      return( this->Values[i] < this->Values[j] );
+      }
+  };
+
 private:
 
   AdaBoost( const Self & ); // purposely not implemented
@@ -314,6 +376,28 @@ private:
   unsigned int                                   m_NumberOfIterations;
 
   typename StrongClassifierType::Pointer         m_StrongClassifier;
+
+  MultiThreader::Pointer                         m_MultiThreader;
+  unsigned int                                   m_NumberOfThreads;
+
+  bool                                           m_UseHistogramApproximation;
+  unsigned int                                   m_NumberOfHistogramBins;
+
+  /**
+   * Column-major presorted features, i.e. the observation indices and the
+   * values of feature j in increasing order are stored in
+   * [j * numberOfObservations, ( j + 1 ) * numberOfObservations).
+   */
+  std::vector<unsigned int>                      m_SortedObservationIndices;
+  std::vector<RealType>                          m_SortedFeatureValues;
+
+  /**
+   * Column-major histogram bin of each observation (in observation order)
+   * and the largest value of each bin, stored per feature in
+   * [j * numberOfHistogramBins, ( j + 1 ) * numberOfHistogramBins).
+   */
+  std::vector<unsigned short>                    m_HistogramBinIndices;
+  std::vector<RealType>                          m_HistogramBinThresholds;
 };
 
 } // end namespace itk
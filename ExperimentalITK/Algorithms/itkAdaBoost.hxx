@@ -347,6 +347,12 @@ AdaBoost<TStrongClassifier>
   this->m_MembershipSigns.clear();
 
   this->m_StrongClassifier = StrongClassifierType::New();
+
+  this->m_MultiThreader = MultiThreader::New();
+  this->m_NumberOfThreads = this->m_MultiThreader->GetNumberOfThreads();
+
+  this->m_UseHistogramApproximation = false;
+  this->m_NumberOfHistogramBins = 256;
 }
 
 template<class TStrongClassifier>
@@ -414,44 +420,72 @@ AdaBoost<TStrongClassifier>
     itkExceptionMacro( "All training observations are from a single membership." );
     }
 
-  vnl_vector<RealType> weights( numberOfObservations, 1.0 / static_cast<RealType>( numberOfObservations ) );
-
-  /** Train */
+  WeightsType weights( numberOfObservations, 1.0 / static_cast<RealType>( numberOfObservations ) );
 
   unsigned int numberOfFeatures = this->m_TrainingObservations[0].size();
 
-  for( unsigned int i = 0; i < this->m_NumberOfIterations; i++ )
+  /** Sort or bin each feature column once for all the iterations */
+
+  TrainingThreadStruct str;
+  str.AdaBoost = this;
+  str.NumberOfFeatures = numberOfFeatures;
+  str.Weights = &weights;
+  str.SumOfForegroundWeights = 0.0;
+  str.Thresholds.resize( numberOfFeatures );
+  str.MembershipSigns.resize( numberOfFeatures );
+  str.WeightedRates.resize( numberOfFeatures );
+
+  // The presorted columns can exceed the range of unsigned int.
+  const SizeValueType numberOfEntries =
+    static_cast<SizeValueType>( numberOfFeatures ) * numberOfObservations;
+  if( this->m_UseHistogramApproximation )
     {
-    typename WeakClassifierType::Pointer optimalWeakClassifier = WeakClassifierType::New();
+    this->m_SortedObservationIndices.clear();
+    this->m_SortedFeatureValues.clear();
+    this->m_HistogramBinIndices.resize( numberOfEntries );
+    this->m_HistogramBinThresholds.resize( static_cast<SizeValueType>(
+      numberOfFeatures ) * this->m_NumberOfHistogramBins );
+    }
+  else
+    {
+    this->m_SortedObservationIndices.resize( numberOfEntries );
+    this->m_SortedFeatureValues.resize( numberOfEntries );
+    this->m_HistogramBinIndices.clear();
+    this->m_HistogramBinThresholds.clear();
+    }
 
-    for( unsigned int j = 0; j < numberOfFeatures; j++ )
-      {
-      SingleFeatureObservationsContainerType singleFeatureObservations;
+  this->m_MultiThreader->SetNumberOfThreads(
+    vnl_math_min( this->m_NumberOfThreads, numberOfFeatures ) );
+  this->m_MultiThreader->SetSingleMethod( this->PresortThreaderCallback, &str );
+  this->m_MultiThreader->SingleMethodExecute();
 
-      typename std::vector<SingleObservationContainerType>::const_iterator it;
-      for( it = this->m_TrainingObservations.begin(); it != this->m_TrainingObservations.end(); ++it )
-        {
-        unsigned int index = it - this->m_TrainingObservations.begin();
+  /** Train */
 
-        typename FeatureNodeType::Pointer node = FeatureNodeType::New();
-        node->SetValue( ( *it )[j] );
-        node->SetMembershipSign( this->m_MembershipSigns[index] );
-        node->SetWeight( weights[index] );
+  std::vector<RealType> strongHypotheses( numberOfObservations, 0.0 );
 
-        singleFeatureObservations.push_back( node );
+  for( unsigned int i = 0; i < this->m_NumberOfIterations; i++ )
+    {
+    str.SumOfForegroundWeights = 0.0;
+    for( unsigned int n = 0; n < numberOfObservations; n++ )
+      {
+      if( this->m_MembershipSigns[n] == FeatureNodeType::FOREGROUND )
+        {
+        str.SumOfForegroundWeights += weights[n];
         }
-      std::sort( singleFeatureObservations.begin(), singleFeatureObservations.end() );
+      }
 
-      typename WeakClassifierType::Pointer weakClassifier = WeakClassifierType::New();
-      weakClassifier->SetFeatureID( j );
-      weakClassifier->SetSingleFeatureObservations( singleFeatureObservations );
-      weakClassifier->DoWeakLearn();
+    this->m_MultiThreader->SetSingleMethod( this->FindOptimalThresholdsThreaderCallback, &str );
+    this->m_MultiThreader->SingleMethodExecute();
+
+    typename WeakClassifierType::Pointer optimalWeakClassifier = WeakClassifierType::New();
 
-      if( weakClassifier->GetWeightedRate() > optimalWeakClassifier->GetWeightedRate() )
+    for( unsigned int j = 0; j < numberOfFeatures; j++ )
+      {
+      if( str.WeightedRates[j] > optimalWeakClassifier->GetWeightedRate() )
         {
-        optimalWeakClassifier->SetMembershipSign( weakClassifier->GetMembershipSign() );
-        optimalWeakClassifier->SetWeightedRate( weakClassifier->GetWeightedRate() );
-        optimalWeakClassifier->SetThreshold( weakClassifier->GetThreshold() );
+        optimalWeakClassifier->SetMembershipSign( str.MembershipSigns[j] );
+        optimalWeakClassifier->SetWeightedRate( str.WeightedRates[j] );
+        optimalWeakClassifier->SetThreshold( str.Thresholds[j] );
         optimalWeakClassifier->SetFeatureID( j );
         }
       }
@@ -459,21 +493,20 @@ AdaBoost<TStrongClassifier>
     RealType optimalWeightedRate = optimalWeakClassifier->GetWeightedRate();
     MembershipSignType optimalMembershipSign = optimalWeakClassifier->GetMembershipSign();
     RealType optimalThreshold = optimalWeakClassifier->GetThreshold();
+    unsigned int optimalFeatureID = optimalWeakClassifier->GetFeatureID();
 
     RealType alpha = 0.5 * vcl_log( optimalWeightedRate / ( 1.0 - optimalWeightedRate ) );
     RealType weightedError = 1.0;
     RealType trueError = 0.0;
-    RealType CH = 0.0;              // real value either -1 or +1
     RealType H = 0.0;
-    RealType F = 0.0;
 
     typename std::vector<SingleObservationContainerType>::const_iterator it;
     for( it = this->m_TrainingObservations.begin(); it != this->m_TrainingObservations.end(); ++it )
       {
       unsigned int index = it - this->m_TrainingObservations.begin();
 
-      if( ( optimalMembershipSign == FeatureNodeType::FOREGROUND && ( *it )[index] > optimalThreshold ) ||
-        ( optimalMembershipSign == FeatureNodeType::BACKGROUND && ( *it )[index] <= optimalThreshold ) )
+      if( ( optimalMembershipSign == FeatureNodeType::FOREGROUND && ( *it )[optimalFeatureID] > optimalThreshold ) ||
+        ( optimalMembershipSign == FeatureNodeType::BACKGROUND && ( *it )[optimalFeatureID] <= optimalThreshold ) )
         {
         H = 1.0;
         }
@@ -487,17 +520,16 @@ AdaBoost<TStrongClassifier>
         weightedError -= weights[index];
         }
 
+      strongHypotheses[index] += alpha * H;
 
-      CH += alpha * H;
-
-      if( CH * static_cast<RealType>( this->m_MembershipSigns[index] ) < 0.0 )
+      if( strongHypotheses[index] * static_cast<RealType>( this->m_MembershipSigns[index] ) < 0.0 )
         {
         trueError += 1.0 / static_cast<RealType>( numberOfObservations );
         }
       weights[index] *= vcl_exp( -alpha * H * static_cast<RealType>( this->m_MembershipSigns[index] ) );
       }
 
-    std::cout << i << ": " << optimalThreshold << ", " << weightedError << ", " << trueError << ", " << CH << std::endl;
+    std::cout << i << ": " << optimalThreshold << ", " << weightedError << ", " << trueError << std::endl;
 
     weights /= weights.sum();
 
@@ -509,6 +541,247 @@ AdaBoost<TStrongClassifier>
     }
 }
 
+template<class TStrongClassifier>
+void
+AdaBoost<TStrongClassifier>
+::PresortFeature( unsigned int feature )
+{
+  unsigned int numberOfObservations = this->m_TrainingObservations.size();
+
+  std::vector<RealType> values( numberOfObservations );
+  std::vector<unsigned int> indices( numberOfObservations );
+  for( unsigned int n = 0; n < numberOfObservations; n++ )
+    {
+    values[n] = this->m_TrainingObservations[n][feature];
+    indices[n] = n;
+    }
+
+  FeatureValueCompare compare;
+  compare.Values = &values[0];
+  std::sort( indices.begin(), indices.end(), compare );
+
+  const SizeValueType offset =
+    static_cast<SizeValueType>( feature ) * numberOfObservations;
+  if( !this->m_UseHistogramApproximation )
+    {
+    for( unsigned int n = 0; n < numberOfObservations; n++ )
+      {
+      this->m_SortedObservationIndices[offset + n] = indices[n];
+      this->m_SortedFeatureValues[offset + n] = values[indices[n]];
+      }
+    return;
+    }
+
+  /**
+   * Equal-frequency bins.  Equal values are kept in the same bin so that
+   * each bin boundary is a valid threshold.
+   */
+  unsigned int numberOfBins = this->m_NumberOfHistogramBins;
+  unsigned short *bins = &this->m_HistogramBinIndices[offset];
+  RealType *thresholds = &this->m_HistogramBinThresholds[
+    static_cast<SizeValueType>( feature ) * numberOfBins];
+
+  std::fill( thresholds, thresholds + numberOfBins, values[indices[0]] );
+
+  unsigned int bin = 0;
+  for( unsigned int n = 0; n < numberOfObservations; n++ )
+    {
+    if( n == 0 || values[indices[n]] != values[indices[n - 1]] )
+      {
+      bin = vnl_math_max( bin, static_cast<unsigned int>(
+        static_cast<double>( n ) * numberOfBins / numberOfObservations ) );
+      }
+    bins[indices[n]] = static_cast<unsigned short>( bin );
+    thresholds[bin] = values[indices[n]];
+    }
+
+  /** Empty bins share the boundary of the previous bin */
+  for( unsigned int b = 1; b < numberOfBins; b++ )
+    {
+    if( thresholds[b] < thresholds[b - 1] )
+      {
+      thresholds[b] = thresholds[b - 1];
+      }
+    }
+}
+
+template<class TStrongClassifier>
+void
+AdaBoost<TStrongClassifier>
+::FindOptimalThreshold( unsigned int feature, const WeightsType & weights,
+  RealType sumOfForegroundWeights, RealType & threshold,
+  MembershipSignType & membershipSign, RealType & weightedRate ) const
+{
+  /** WeakLearn on the presorted column, see WeakClassifier::DoWeakLearn() */
+
+  unsigned int numberOfObservations = this->m_TrainingObservations.size();
+  const SizeValueType offset =
+    static_cast<SizeValueType>( feature ) * numberOfObservations;
+  const unsigned int *indices = &this->m_SortedObservationIndices[offset];
+  const RealType *values = &this->m_SortedFeatureValues[offset];
+
+  RealType sumOfWeights = 0.0;
+  RealType sumOfBackgroundWeights = 1.0 - sumOfForegroundWeights;
+
+  threshold = values[0];
+  if( sumOfForegroundWeights >= sumOfBackgroundWeights )
+    {
+    membershipSign = FeatureNodeType::FOREGROUND;
+    sumOfWeights = sumOfForegroundWeights;
+    }
+  else
+    {
+    membershipSign = FeatureNodeType::BACKGROUND;
+    sumOfWeights = sumOfBackgroundWeights;
+    }
+
+  for( unsigned int n = 0; n < numberOfObservations; n++ )
+    {
+    unsigned int index = indices[n];
+    if( this->m_MembershipSigns[index] == FeatureNodeType::FOREGROUND )
+      {
+      sumOfForegroundWeights -= weights[index];
+      }
+    else
+      {
+      sumOfForegroundWeights += weights[index];
+      }
+
+    /** Only threshold between distinct values */
+    if( n < numberOfObservations - 1 && values[n + 1] == values[n] )
+      {
+      continue;
+      }
+
+    sumOfBackgroundWeights = 1.0 - sumOfForegroundWeights;
+
+    if( sumOfForegroundWeights > sumOfWeights )
+      {
+      sumOfWeights = sumOfForegroundWeights;
+      threshold = values[n];
+      membershipSign = FeatureNodeType::FOREGROUND;
+      }
+    if( sumOfBackgroundWeights > sumOfWeights )
+      {
+      sumOfWeights = sumOfBackgroundWeights;
+      threshold = values[n];
+      membershipSign = FeatureNodeType::BACKGROUND;
+      }
+    }
+
+  weightedRate = sumOfWeights;
+}
+
+template<class TStrongClassifier>
+void
+AdaBoost<TStrongClassifier>
+::FindOptimalHistogramThreshold( unsigned int feature, const WeightsType & weights,
+  RealType sumOfForegroundWeights, RealType & threshold,
+  MembershipSignType & membershipSign, RealType & weightedRate ) const
+{
+  unsigned int numberOfObservations = this->m_TrainingObservations.size();
+  unsigned int numberOfBins = this->m_NumberOfHistogramBins;
+  const unsigned short *bins = &this->m_HistogramBinIndices[
+    static_cast<SizeValueType>( feature ) * numberOfObservations];
+  const RealType *thresholds = &this->m_HistogramBinThresholds[
+    static_cast<SizeValueType>( feature ) * numberOfBins];
+
+  /** Signed weight of each bin, i.e. background minus foreground */
+  std::vector<RealType> binWeights( numberOfBins, 0.0 );
+  for( unsigned int n = 0; n < numberOfObservations; n++ )
+    {
+    if( this->m_MembershipSigns[n] == FeatureNodeType::FOREGROUND )
+      {
+      binWeights[bins[n]] -= weights[n];
+      }
+    else
+      {
+      binWeights[bins[n]] += weights[n];
+      }
+    }
+
+  RealType sumOfWeights = 0.0;
+  RealType sumOfBackgroundWeights = 1.0 - sumOfForegroundWeights;
+
+  threshold = thresholds[0];
+  if( sumOfForegroundWeights >= sumOfBackgroundWeights )
+    {
+    membershipSign = FeatureNodeType::FOREGROUND;
+    sumOfWeights = sumOfForegroundWeights;
+    }
+  else
+    {
+    membershipSign = FeatureNodeType::BACKGROUND;
+    sumOfWeights = sumOfBackgroundWeights;
+    }
+
+  for( unsigned int b = 0; b < numberOfBins; b++ )
+    {
+    sumOfForegroundWeights += binWeights[b];
+    sumOfBackgroundWeights = 1.0 - sumOfForegroundWeights;
+
+    if( sumOfForegroundWeights > sumOfWeights )
+      {
+      sumOfWeights = sumOfForegroundWeights;
+      threshold = thresholds[b];
+      membershipSign = FeatureNodeType::FOREGROUND;
+      }
+    if( sumOfBackgroundWeights > sumOfWeights )
+      {
+      sumOfWeights = sumOfBackgroundWeights;
+      threshold = thresholds[b];
+      membershipSign = FeatureNodeType::BACKGROUND;
+      }
+    }
+
+  weightedRate = sumOfWeights;
+}
+
+template<class TStrongClassifier>
+ITK_THREAD_RETURN_TYPE
+AdaBoost<TStrongClassifier>
+::PresortThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  TrainingThreadStruct *str =
+    static_cast<TrainingThreadStruct *>( info->UserData );
+
+  for( unsigned int j = info->ThreadID; j < str->NumberOfFeatures; j += info->NumberOfThreads )
+    {
+    str->AdaBoost->PresortFeature( j );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template<class TStrongClassifier>
+ITK_THREAD_RETURN_TYPE
+AdaBoost<TStrongClassifier>
+::FindOptimalThresholdsThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  TrainingThreadStruct *str =
+    static_cast<TrainingThreadStruct *>( info->UserData );
+
+  for( unsigned int j = info->ThreadID; j < str->NumberOfFeatures; j += info->NumberOfThreads )
+    {
+    if( str->AdaBoost->m_UseHistogramApproximation )
+      {
+      str->AdaBoost->FindOptimalHistogramThreshold( j, *str->Weights,
+        str->SumOfForegroundWeights, str->Thresholds[j],
+        str->MembershipSigns[j], str->WeightedRates[j] );
+      }
+    else
+      {
+      str->AdaBoost->FindOptimalThreshold( j, *str->Weights,
+        str->SumOfForegroundWeights, str->Thresholds[j],
+        str->MembershipSigns[j], str->WeightedRates[j] );
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template<class TStrongClassifier>
 void
 AdaBoost<TStrongClassifier>
@@ -516,6 +789,9 @@ AdaBoost<TStrongClassifier>
 {
   os << indent << "Number of iterations:               " << this->m_NumberOfIterations << std::endl;
   os << indent << "Number of observations:             " << this->m_TrainingObservations.size() << std::endl;
+  os << indent << "Number of threads:                  " << this->m_NumberOfThreads << std::endl;
+  os << indent << "Use histogram approximation:        " << this->m_UseHistogramApproximation << std::endl;
+  os << indent << "Number of histogram bins:           " << this->m_NumberOfHistogramBins << std::endl;
 
   if( this->m_TrainingObservations.size() > 0 )
     {
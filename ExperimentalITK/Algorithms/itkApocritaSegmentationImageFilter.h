@@ -50,6 +50,17 @@ namespace itk
  * indices 1, 2, 3, etc.  Label 0 is reserved for the background when a
  * mask is specified.
  *
+ * By default the MRF prior of every voxel is computed from the labeling of
+ * the previous iteration.  With the Checkerboard update strategy, the
+ * voxels are instead relabeled in place, one color class at a time, where
+ * the color of a voxel is made of its index modulo MRFRadius + 1 along
+ * each axis (2^D colors for a radius of 1, i.e. 8 colors for the 26
+ * neighborhood in 3-D).  No two voxels of the same color are MRF
+ * neighbors, so all the voxels of a color are updated in parallel and
+ * already see the new labels of the previous colors.  The result does not
+ * depend on the number of threads.  The posterior probability images of
+ * the iteration are kept even if MinimizeMemoryUsage is on.
+ *
  */
 
 template<class TInputImage, class TMaskImage
@@ -109,6 +120,8 @@ public:
   enum InitializationStrategyType
     { Random, KMeans, Otsu, PriorProbabilityImages, PriorLabelImage };
 
+  enum MRFUpdateStrategyType { Synchronous, Checkerboard };
+
   typedef std::pair<RealType, RealType>               LabelParametersType;
   typedef std::map<LabelType, LabelParametersType>    LabelParameterMapType;
 
@@ -140,6 +153,9 @@ public:
   itkSetMacro( MRFRadius, ArrayType );
   itkGetConstMacro( MRFRadius, ArrayType );
 
+  itkSetMacro( MRFUpdateStrategy, MRFUpdateStrategyType );
+  itkGetConstMacro( MRFUpdateStrategy, MRFUpdateStrategyType );
+
   itkSetMacro( InitializationStrategy, InitializationStrategyType );
   itkGetConstMacro( InitializationStrategy, InitializationStrategyType );
 
@@ -216,6 +232,24 @@ protected:
 
   void GenerateData();
 
+  /** Internal structure used for passing the color class to the threads. */
+  struct MRFThreadStruct
+  {
+    Self                                                 *Filter;
+    unsigned int                                          Color;
+    std::vector<typename RealImageType::Pointer>          SmoothImages;
+    std::vector<typename RealImageType::ConstPointer>     PriorImages;
+    std::vector<typename ClassifiedImageType::OffsetType> Offsets;
+    std::vector<RealType>                                 Weights;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE MRFThreaderCallback( void *arg );
+
+  /** Relabel the voxels of the color class str->Color in the region. */
+  void ThreadedUpdateMRFColor( const typename
+    ClassifiedImageType::RegionType & region, MRFThreadStruct *str );
+
 private:
   ApocritaSegmentationImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -229,6 +263,16 @@ private:
 
   RealType UpdateClassParametersAndLabeling();
 
+  /**
+   * Checkerboard MRF update of the labeling which also computes the
+   * posterior probability images of the iteration.
+   */
+  void UpdateLabelingWithCheckerboardMRF();
+
+  /** Unnormalized posterior probability of a voxel for a class */
+  RealType CalculatePosteriorProbability( RealType intensity, RealType mu,
+    RealType ratio, RealType prior, unsigned int whichClass ) const;
+
   unsigned int                                  m_NumberOfClasses;
   unsigned int                                  m_ElapsedIterations;
   unsigned int                                  m_MaximumNumberOfIterations;
@@ -244,6 +288,7 @@ private:
   RealType                                      m_MRFSmoothingFactor;
   RealType                                      m_MRFSigmoidAlpha;
   RealType                                      m_MRFSigmoidBeta;
+  MRFUpdateStrategyType                         m_MRFUpdateStrategy;
 
   RealType                                      m_PriorProbabilityWeighting;
   LabelParameterMapType                         m_PriorLabelParameterMap;
@@ -31,10 +31,11 @@
 #include "itkImageDuplicator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
-#include "itkImageToListGenerator.h"
+#include "itkImageRegionIteratorWithIndex.h"
 #include "itkIterationReporter.h"
 #include "itkKdTreeBasedKmeansEstimator.h"
 #include "itkLabelStatisticsImageFilter.h"
+#include "itkMaskedImageToListSampleAdaptor.h"
 #include "itkMaskImageFilter.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkMinimumDecisionRule.h"
@@ -75,6 +76,7 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
   this->m_MRFSigmoidAlpha = 0.0;
   this->m_MRFSigmoidBeta = 0.0;
   this->m_MRFRadius.Fill( 1 );
+  this->m_MRFUpdateStrategy = Synchronous;
 
   this->m_SplineOrder = 3;
   this->m_NumberOfLevels.Fill( 6 );
@@ -197,6 +199,10 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
 
     TimeProbe timer;
     timer.Start();
+    if( this->m_MRFUpdateStrategy == Checkerboard )
+      {
+      this->UpdateLabelingWithCheckerboardMRF();
+      }
     probabilityNew = this->UpdateClassParametersAndLabeling();
     timer.Stop();
 
@@ -518,21 +524,22 @@ void
 ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
 ::GenerateInitialClassLabelingWithKMeansClustering()
 {
-  typedef typename Statistics::ImageToListGenerator<ImageType, MaskImageType>
-    ListSampleGeneratorType;
-  typename ListSampleGeneratorType::Pointer sampler
-    = ListSampleGeneratorType::New();
-  sampler->SetInput( this->GetInput() );
+  /**
+   * The masked pixels are adapted in place rather than copied into a list
+   * sample.  The instances are visited in buffer order, which is the order
+   * used below to write the class labels back.
+   */
+  typedef typename Statistics::MaskedImageToListSampleAdaptor
+    <ImageType, MaskImageType> ListSampleType;
+  typename ListSampleType::Pointer sampler = ListSampleType::New();
+  sampler->SetImage( this->GetInput() );
   if( this->GetMaskImage() )
     {
-    sampler->SetMaskImage( this->GetMaskImage() );
     sampler->SetMaskValue( this->m_MaskLabel );
+    sampler->SetMaskImage( this->GetMaskImage() );
     }
-  sampler->Update();
 
-  typedef typename ListSampleGeneratorType::ListSampleType ListSampleType;
-  typedef typename ListSampleGeneratorType::MeasurementVectorType
-    MeasurementVectorType;
+  typedef typename ListSampleType::MeasurementVectorType MeasurementVectorType;
   typedef Statistics::WeightedCentroidKdTreeGenerator
     <ListSampleType> TreeGeneratorType;
   typedef typename TreeGeneratorType::KdTreeType TreeType;
@@ -540,8 +547,7 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
   typedef typename EstimatorType::ParametersType ParametersType;
 
   typename TreeGeneratorType::Pointer treeGenerator = TreeGeneratorType::New();
-  treeGenerator->SetSample( const_cast<ListSampleType*>(
-    sampler->GetListSample() ) );
+  treeGenerator->SetSample( sampler );
   treeGenerator->SetBucketSize( 16 );
   treeGenerator->Update();
 
@@ -594,8 +600,7 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
   typename ClassifierType::Pointer classifier = ClassifierType::New();
 
   classifier->SetDecisionRule( decisionRule.GetPointer() );
-  classifier->SetSample( const_cast<ListSampleType*>(
-    sampler->GetListSample() ) );
+  classifier->SetSample( sampler );
   classifier->SetNumberOfClasses( this->m_NumberOfClasses  );
 
   typedef itk::Statistics::EuclideanDistance<MeasurementVectorType>
@@ -1004,13 +1009,6 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
             RealType ratio = weightedNumberOfClassNeighbors
               / weightedTotalNumberOfNeighbors;
 
-            RealType mrfPrior = 1.0;
-            if( this->m_MRFSmoothingFactor > 0.0 )
-              {
-              mrfPrior = vcl_exp( -( 1.0 - ratio ) /
-                this->m_MRFSmoothingFactor );
-              }
-
             RealType prior = 1.0;
             if( priorProbabilityImage )
               {
@@ -1028,26 +1026,9 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
                 + this->m_PriorProbabilityWeighting
                 * smoothImage->GetPixel( ItO.GetIndex() );
               }
-            RealType likelihood = 1.0 / vcl_sqrt( 2.0 * vnl_math::pi
-              * this->m_CurrentClassParameters[c][1] ) *
-              vcl_exp( -0.5 * vnl_math_sqr( ItI.Get() - mu ) /
-              this->m_CurrentClassParameters[c][1] );
-
-            RealType posteriorProbability = likelihood * mrfPrior * prior *
-              this->m_CurrentClassParameters[c][2];
-
-            if( this->m_MRFSigmoidAlpha > 0.0 )
-              {
-              posteriorProbability = 1.0 / ( 1.0 + vcl_exp(
-                -( posteriorProbability - this->m_MRFSigmoidBeta ) /
-                this->m_MRFSigmoidAlpha ) );
-              }
-
-            if( vnl_math_isnan( posteriorProbability ) ||
-              vnl_math_isinf( posteriorProbability ) )
-              {
-              posteriorProbability = 0.0;
-              }
+            RealType posteriorProbability =
+              this->CalculatePosteriorProbability( ItI.Get(), mu, ratio,
+              prior, c + 1 );
 
             ItS.Set( ItS.Get() + posteriorProbability  );
             if( ( c == 0 ) || !this->m_MinimizeMemoryUsage )
@@ -1181,13 +1162,6 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
           RealType ratio = weightedNumberOfClassNeighbors
             / weightedTotalNumberOfNeighbors;
 
-          RealType mrfPrior = 1.0;
-          if( this->m_MRFSmoothingFactor > 0.0 )
-            {
-            mrfPrior = vcl_exp( -( 1.0 - ratio ) /
-              this->m_MRFSmoothingFactor );
-            }
-
           RealType prior = 1.0;
           if( priorProbabilityImage )
             {
@@ -1205,26 +1179,9 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
               + this->m_PriorProbabilityWeighting
               * smoothImage->GetPixel( ItO.GetIndex() );
             }
-          RealType likelihood = 1.0 / vcl_sqrt( 2.0 * vnl_math::pi
-            * this->m_CurrentClassParameters[whichClass-1][1] ) *
-            vcl_exp( -0.5 * vnl_math_sqr( ItI.Get() - mu ) /
-            this->m_CurrentClassParameters[whichClass-1][1] );
-
-          RealType posteriorProbability = likelihood * mrfPrior * prior *
-            this->m_CurrentClassParameters[whichClass-1][2];
-
-          if( this->m_MRFSigmoidAlpha > 0.0 )
-            {
-            posteriorProbability = 1.0 / ( 1.0 + vcl_exp(
-              -( posteriorProbability - this->m_MRFSigmoidBeta ) /
-              this->m_MRFSigmoidAlpha ) );
-            }
-
-          if( vnl_math_isnan( posteriorProbability ) ||
-            vnl_math_isinf( posteriorProbability ) )
-            {
-            posteriorProbability = 0.0;
-            }
+          RealType posteriorProbability =
+            this->CalculatePosteriorProbability( ItI.Get(), mu, ratio,
+            prior, whichClass );
           posteriorProbabilityImage->SetPixel( ItO.GetIndex(),
             posteriorProbability );
           }
@@ -1251,6 +1208,271 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
     }
 }
 
+template <class TInputImage, class TMaskImage, class TClassifiedImage>
+typename ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
+::RealType
+ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
+::CalculatePosteriorProbability( RealType intensity, RealType mu,
+  RealType ratio, RealType prior, unsigned int whichClass ) const
+{
+  const ParametersType & parameters =
+    this->m_CurrentClassParameters[whichClass-1];
+
+  RealType mrfPrior = 1.0;
+  if( this->m_MRFSmoothingFactor > 0.0 )
+    {
+    mrfPrior = vcl_exp( -( 1.0 - ratio ) / this->m_MRFSmoothingFactor );
+    }
+
+  RealType likelihood = 1.0 / vcl_sqrt( 2.0 * vnl_math::pi * parameters[1] ) *
+    vcl_exp( -0.5 * vnl_math_sqr( intensity - mu ) / parameters[1] );
+
+  RealType posteriorProbability = likelihood * mrfPrior * prior *
+    parameters[2];
+
+  if( this->m_MRFSigmoidAlpha > 0.0 )
+    {
+    posteriorProbability = 1.0 / ( 1.0 + vcl_exp(
+      -( posteriorProbability - this->m_MRFSigmoidBeta ) /
+      this->m_MRFSigmoidAlpha ) );
+    }
+
+  if( vnl_math_isnan( posteriorProbability ) ||
+    vnl_math_isinf( posteriorProbability ) )
+    {
+    posteriorProbability = 0.0;
+    }
+  return posteriorProbability;
+}
+
+template <class TInputImage, class TMaskImage, class TClassifiedImage>
+void
+ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
+::UpdateLabelingWithCheckerboardMRF()
+{
+  MRFThreadStruct str;
+  str.Filter = this;
+
+  /**
+   * The per class images are computed and cached on demand, in class order,
+   * so they are gathered before running the threads.
+   */
+  for( unsigned int c = 0; c < this->m_NumberOfClasses; c++ )
+    {
+    typename RealImageType::Pointer smoothImage = NULL;
+    if( this->m_PriorProbabilityWeighting > 0.0 )
+      {
+      smoothImage =
+        this->CalculateSmoothIntensityImageFromPriorProbabilityImage( c + 1 );
+      }
+    str.SmoothImages.push_back( smoothImage );
+
+    typename RealImageType::ConstPointer priorImage = NULL;
+    if( this->m_InitializationStrategy == PriorProbabilityImages )
+      {
+      priorImage = this->GetPriorProbabilityImage( c + 1 );
+      }
+    else if( this->m_InitializationStrategy == PriorLabelImage )
+      {
+      priorImage = this->GetDistancePriorProbabilityImageFromPriorLabelImage(
+        c + 1 ).GetPointer();
+      }
+    str.PriorImages.push_back( priorImage );
+    }
+
+  /**
+   * Offsets and inverse distance weights of the MRF neighbors, computed
+   * once instead of for every voxel and class.
+   */
+  unsigned int neighborhoodSize = 1;
+  unsigned int numberOfColors = 1;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    neighborhoodSize *= ( 2 * this->m_MRFRadius[d] + 1 );
+    numberOfColors *= ( this->m_MRFRadius[d] + 1 );
+    }
+  for( unsigned int n = 0; n < neighborhoodSize; n++ )
+    {
+    typename ClassifiedImageType::OffsetType offset;
+    unsigned int m = n;
+    RealType distance = 0.0;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      unsigned int width = 2 * this->m_MRFRadius[d] + 1;
+      offset[d] = static_cast<long>( m % width ) -
+        static_cast<long>( this->m_MRFRadius[d] );
+      m /= width;
+      distance += vnl_math_sqr( offset[d] *
+        this->GetOutput()->GetSpacing()[d] );
+      }
+    if( distance > 0.0 )
+      {
+      str.Offsets.push_back( offset );
+      str.Weights.push_back( 1.0 / vcl_sqrt( distance ) );
+      }
+    }
+
+  /**
+   * The posterior probability images are filled voxel by voxel during the
+   * update.
+   */
+  this->m_PosteriorProbabilityImages.clear();
+  for( unsigned int c = 0; c <= this->m_NumberOfClasses; c++ )
+    {
+    typename RealImageType::Pointer image = RealImageType::New();
+    image->SetRegions( this->GetOutput()->GetRequestedRegion() );
+    image->SetOrigin( this->GetOutput()->GetOrigin() );
+    image->SetSpacing( this->GetOutput()->GetSpacing() );
+    image->SetDirection( this->GetOutput()->GetDirection() );
+    image->Allocate();
+    image->FillBuffer( 0 );
+    if( c < this->m_NumberOfClasses )
+      {
+      this->m_PosteriorProbabilityImages.push_back( image );
+      }
+    else
+      {
+      this->m_SumPosteriorProbabilityImage = image;
+      }
+    }
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->MRFThreaderCallback, &str );
+  for( str.Color = 0; str.Color < numberOfColors; str.Color++ )
+    {
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+}
+
+template <class TInputImage, class TMaskImage, class TClassifiedImage>
+ITK_THREAD_RETURN_TYPE
+ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
+::MRFThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  MRFThreadStruct *str = static_cast<MRFThreadStruct *>( info->UserData );
+
+  typename ClassifiedImageType::RegionType splitRegion;
+  unsigned int total = str->Filter->SplitRequestedRegion( info->ThreadID,
+    info->NumberOfThreads, splitRegion );
+
+  if( info->ThreadID < total )
+    {
+    str->Filter->ThreadedUpdateMRFColor( splitRegion, str );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TMaskImage, class TClassifiedImage>
+void
+ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
+::ThreadedUpdateMRFColor( const typename
+  ClassifiedImageType::RegionType & region, MRFThreadStruct *str )
+{
+  ClassifiedImageType *output = this->GetOutput();
+  const MaskImageType *mask = this->GetMaskImage();
+  const typename ClassifiedImageType::RegionType & bufferedRegion =
+    output->GetBufferedRegion();
+
+  /**
+   * The weighted neighbor counts of all the classes are gathered in a
+   * single pass over the neighborhood.
+   */
+  std::vector<RealType> classWeights( this->m_NumberOfClasses );
+  std::vector<RealType> posteriors( this->m_NumberOfClasses );
+
+  ImageRegionIteratorWithIndex<ClassifiedImageType> ItO( output, region );
+  for( ItO.GoToBegin(); !ItO.IsAtEnd(); ++ItO )
+    {
+    typename ClassifiedImageType::IndexType index = ItO.GetIndex();
+
+    unsigned int color = 0;
+    unsigned int stride = 1;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      long period = static_cast<long>( this->m_MRFRadius[d] + 1 );
+      long residue = index[d] % period;
+      if( residue < 0 )
+        {
+        residue += period;
+        }
+      color += static_cast<unsigned int>( residue ) * stride;
+      stride *= static_cast<unsigned int>( period );
+      }
+    if( color != str->Color )
+      {
+      continue;
+      }
+    if( mask && mask->GetPixel( index ) != this->m_MaskLabel )
+      {
+      continue;
+      }
+
+    std::fill( classWeights.begin(), classWeights.end(), 0.0 );
+    RealType totalWeight = 0.0;
+    for( unsigned int n = 0; n < str->Offsets.size(); n++ )
+      {
+      typename ClassifiedImageType::IndexType neighborIndex =
+        index + str->Offsets[n];
+      if( !bufferedRegion.IsInside( neighborIndex ) )
+        {
+        continue;
+        }
+      unsigned int label =
+        static_cast<unsigned int>( output->GetPixel( neighborIndex ) );
+      if( label > 0 && label <= this->m_NumberOfClasses )
+        {
+        classWeights[label-1] += str->Weights[n];
+        }
+      totalWeight += str->Weights[n];
+      }
+
+    RealType intensity =
+      static_cast<RealType>( this->GetInput()->GetPixel( index ) );
+
+    RealType sumPosteriors = 0.0;
+    for( unsigned int c = 0; c < this->m_NumberOfClasses; c++ )
+      {
+      RealType prior = 1.0;
+      if( str->PriorImages[c] )
+        {
+        prior = str->PriorImages[c]->GetPixel( index );
+        }
+      RealType mu = this->m_CurrentClassParameters[c][0];
+      if( str->SmoothImages[c] )
+        {
+        mu = ( 1.0 - this->m_PriorProbabilityWeighting ) * mu
+          + this->m_PriorProbabilityWeighting
+          * str->SmoothImages[c]->GetPixel( index );
+        }
+      posteriors[c] = this->CalculatePosteriorProbability( intensity, mu,
+        classWeights[c] / totalWeight, prior, c + 1 );
+      sumPosteriors += posteriors[c];
+      }
+    this->m_SumPosteriorProbabilityImage->SetPixel( index, sumPosteriors );
+
+    RealType maxPosterior = 0.0;
+    LabelType maxLabel = NumericTraits<LabelType>::Zero;
+    for( unsigned int c = 0; c < this->m_NumberOfClasses; c++ )
+      {
+      if( sumPosteriors > 0 )
+        {
+        posteriors[c] /= sumPosteriors;
+        }
+      this->m_PosteriorProbabilityImages[c]->SetPixel( index, posteriors[c] );
+      if( posteriors[c] >= maxPosterior )
+        {
+        maxPosterior = posteriors[c];
+        maxLabel = static_cast<LabelType>( c + 1 );
+        }
+      }
+    ItO.Set( maxLabel );
+    }
+}
+
 template <class TInputImage, class TMaskImage, class TClassifiedImage>
 typename ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
 ::RealImageType::Pointer
@@ -1854,6 +2076,15 @@ ApocritaSegmentationImageFilter<TInputImage, TMaskImage, TClassifiedImage>
      << this->m_MRFSigmoidAlpha << std::endl;
   os << indent << "  MRF sigmoid beta: "
      << this->m_MRFSigmoidBeta << std::endl;
+  os << indent << "  MRF update strategy: ";
+  if( this->m_MRFUpdateStrategy == Checkerboard )
+    {
+    os << "Checkerboard" << std::endl;
+    }
+  else
+    {
+    os << "Synchronous" << std::endl;
+    }
 
   if( this->m_PriorProbabilityWeighting > 0.0 )
     {
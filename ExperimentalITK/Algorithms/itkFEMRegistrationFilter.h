@@ -19,6 +19,7 @@
 #define _itkFEMRegistrationFilter_h_
 
 #include "itkFEMLinearSystemWrapperItpack.h"
+#include "itkFEMLinearSystemWrapperCSR.h"
 #include "itkFEMLinearSystemWrapperDenseVNL.h"
 #include "itkFEMGenerateMesh.h"
 #include "itkFEMSolverCrankNicolson.h"
@@ -343,6 +344,11 @@ public:
   /** Sets the use of multi-resolution strategy.  The control file always uses multi-res. */ 
   void      EmployRegridding(unsigned int b) { m_EmployRegridding=b; } 
 
+  /** Use the CSR linear system wrapper (multithreaded assembly and
+      preconditioned conjugate gradients) instead of itpack. */
+  void      SetUseCSRLinearSystem(bool b) { m_UseCSRLinearSystem=b; }
+  bool      GetUseCSRLinearSystem() { return m_UseCSRLinearSystem; }
+
   /** This sets the line search's max iterations. */ 
   void      SetLineSearchMaximumIterations(unsigned int f) { m_LineSearchMaximumIterations=f; } 
   
@@ -515,6 +521,7 @@ private :
   bool  m_UseLandmarks;
   bool  m_ReadMeshFile;
   bool  m_UseMassMatrix;
+  bool  m_UseCSRLinearSystem;
   unsigned int m_EmployRegridding;
   Sign  m_DescentDirection;
 
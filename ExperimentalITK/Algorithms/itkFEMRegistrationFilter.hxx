@@ -43,6 +43,8 @@ PURPOSE.  See the above copyright notices for more information.
 
 #include "vnl/algo/vnl_determinant.h"
 
+#include <memory>
+
 namespace itk {
 namespace fem {
 
@@ -83,6 +85,7 @@ FEMRegistrationFilter<TMovingImage,TFixedImage>::FEMRegistrationFilter()
   m_DoLineSearchOnImageEnergy=1;
   m_LineSearchMaximumIterations=100;
   m_UseMassMatrix=true;
+  m_UseCSRLinearSystem=false;
 
   m_NumLevels=1;
   m_MaxLevel=1;
@@ -155,7 +158,20 @@ void FEMRegistrationFilter<TMovingImage,TFixedImage>::RunRegistration(void)
         itpackWrapper.SetTolerance(1.e-1);
         //    itpackWrapper.JacobianSemiIterative();
         itpackWrapper.JacobianConjugateGradient();
-        mySolver.SetLinearSystemWrapper(&itpackWrapper);
+        std::auto_ptr<LinearSystemWrapperCSR> csrWrapper;
+        if (m_UseCSRLinearSystem)
+            {
+            csrWrapper.reset(new LinearSystemWrapperCSR);
+            csrWrapper->SetMaximumNumberIterations(2*mySolver.GetNumberOfDegreesOfFreedom());
+            csrWrapper->SetTolerance(1.e-3);
+            csrWrapper->SetUseWarmStart(true);
+            csrWrapper->JacobiPreconditionedConjugateGradient();
+            mySolver.SetLinearSystemWrapper(csrWrapper.get());
+            }
+        else
+            {
+            mySolver.SetLinearSystemWrapper(&itpackWrapper);
+            }
 
         if( m_UseMassMatrix )
             {
@@ -1942,7 +1958,17 @@ void FEMRegistrationFilter<TMovingImage,TFixedImage>::MultiResSolve()
       itpackWrapper.SetTolerance(1.e-1);
       itpackWrapper.JacobianConjugateGradient(); 
       itpackWrapper.SetMaximumNonZeroValuesInMatrix(nzelts);
-      SSS.SetLinearSystemWrapper(&itpackWrapper); 
+      std::auto_ptr<LinearSystemWrapperCSR> csrWrapper;
+      if (m_UseCSRLinearSystem) 
+        {
+        csrWrapper.reset(new LinearSystemWrapperCSR);
+        csrWrapper->SetMaximumNumberIterations(maxits);
+        csrWrapper->SetTolerance(1.e-3);
+        csrWrapper->SetUseWarmStart(true);
+        csrWrapper->JacobiPreconditionedConjugateGradient();
+        SSS.SetLinearSystemWrapper(csrWrapper.get());
+        }
+      else SSS.SetLinearSystemWrapper(&itpackWrapper); 
 
 
 
@@ -27,7 +27,7 @@
 #include "vnl/vnl_math.h"
 #include <algorithm>
 
-#include "topological_numbers.h"
+#include "itkSimplePointLookupTable.h"
 
 namespace itk
 {
@@ -357,6 +357,14 @@ FastMarchingImageFilter<TLevelSet,TSpeedImage>
 
   this->UpdateProgress( 0.0 ); // Send first progress event
 
+  // Get the simple point table once instead of locking at each node.
+  const unsigned int *simplePointTable = NULL;
+  if( this->m_TopologyCheck != None && !this->m_UseWellComposedness )
+    {
+    simplePointTable = SimplePointLookupTable::GetTable(
+      this->m_SimplePointConnectivity );
+    }
+
   while ( !this->m_TrialHeap.empty() )
     {
     // get the node with the smallest value
@@ -384,7 +392,10 @@ FastMarchingImageFilter<TLevelSet,TSpeedImage>
     // does the node break topology
     if( this->m_TopologyCheck != None && !this->m_UseWellComposedness )
       {
-      NBH neighborhood;
+      // Pack the alive neighbors into a configuration for the simple point
+      // lookup table.  In 2-D the neighborhood is the middle slice of the
+      // 3x3x3 cube.
+      SimplePointLookupTable::ConfigurationType neighborhood = 0;
       typename NeighborhoodIteratorType::RadiusType radius;
       radius.Fill( 1 );
       NeighborhoodIteratorType ItL( radius, this->m_LabelImage,
@@ -396,28 +407,25 @@ FastMarchingImageFilter<TLevelSet,TSpeedImage>
           {
           for( unsigned int j = 0; j < 3; j++ )
             {
-            neighborhood[i][0][j] = neighborhood[i][2][j] = 0;
-            neighborhood[i][1][j] = static_cast<unsigned char>(
-              ItL.GetPixel( 3*i+j ) == AlivePoint );
+            if( 3*i+j != 4 && ItL.GetPixel( 3*i+j ) == AlivePoint )
+              {
+              neighborhood |= SimplePointLookupTable::GetMask( 9*i + 3 + j );
+              }
             }
           }
         }
       else if( SetDimension == 3 )
         {
-        for( unsigned int i = 0; i < 3; i++ )
+        for( unsigned int n = 0; n < 27; n++ )
           {
-          for( unsigned int j = 0; j < 3; j++ )
+          if( n != 13 && ItL.GetPixel( n ) == AlivePoint )
             {
-            for( unsigned int k = 0; k < 3; k++ )
-              {
-              neighborhood[i][j][k] = static_cast<unsigned char>(
-                ItL.GetPixel( 9*i + 3*j + k ) == AlivePoint );
-              }
+            neighborhood |= SimplePointLookupTable::GetMask( n );
             }
           }
         }
-      bool isSimplePoint = checkSimple( &neighborhood,
-        this->m_SimplePointConnectivity );
+      bool isSimplePoint = SimplePointLookupTable::IsSimple(
+        simplePointTable, neighborhood, this->m_SimplePointConnectivity );
       if( !isSimplePoint )
         {
         if( this->m_TopologyCheck == Strict )
@@ -428,13 +436,12 @@ FastMarchingImageFilter<TLevelSet,TSpeedImage>
           }
         else if( this->m_TopologyCheck == NoHandles )
           {
-          NBH dnbh;
-          NBH neighborhoodInv;
-          reverseNBH( &neighborhood, &neighborhoodInv );
-          unsigned int Tn = checkTn(
-            &neighborhood, &dnbh, this->m_SimplePointConnectivity );
-          unsigned int TnInv = checkTn( &neighborhoodInv, &dnbh,
-            associatedConnectivity( this->m_SimplePointConnectivity ) );
+          unsigned int Tn = SimplePointLookupTable::ComputeTopologicalNumber(
+            neighborhood, this->m_SimplePointConnectivity );
+          unsigned int TnInv = SimplePointLookupTable::ComputeTopologicalNumber(
+            ~neighborhood & SimplePointLookupTable::GetFullMask(),
+            SimplePointLookupTable::GetAssociatedConnectivity(
+              this->m_SimplePointConnectivity ) );
 
           // Get number of connected components
           NeighborhoodIterator<ConnectedComponentImageType> ItC(
@@ -1047,27 +1054,33 @@ bool
 FastMarchingImageFilter<TLevelSet,TSpeedImage>
 ::IsChangeWellComposed3D( IndexType idx )
 {
-  Array<short> neighborhoodPixels( 8 );
-
   typename NeighborhoodIteratorType::RadiusType radius;
   radius.Fill( 1 );
   NeighborhoodIteratorType It( radius, this->m_LabelImage,
     this->m_LabelImage->GetRequestedRegion() );
   It.SetLocation( idx );
 
+  // Pack the neighborhood once, with the center pixel flipped, and look up
+  // the C1 and C2 configurations in the tables built by InitializeIndices3D().
+  unsigned long pixels = 0;
+  for ( unsigned int n = 0; n < 27; n++ )
+    {
+    if( It.GetPixel( n ) == AlivePoint )
+      {
+      pixels |= 1ul << n;
+      }
+    }
+  pixels ^= 1ul << 13;
+
   // Check for C1 critical configurations
   for ( unsigned int i = 0; i < 12; i++ )
     {
+    unsigned int configuration = 0;
     for ( unsigned int j = 0; j < 4; j++ )
       {
-      neighborhoodPixels[j]
-        = ( It.GetPixel( this->m_C1Indices[i][j] ) == AlivePoint );
-      if( this->m_C1Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
+      configuration |= ( ( pixels >> this->m_C1Indices[i][j] ) & 1 ) << j;
       }
-    if( this->IsCriticalC1Configuration3D( neighborhoodPixels ) )
+    if( this->m_CriticalC1Configurations3D[configuration] )
       {
       return false;
       }
@@ -1076,16 +1089,12 @@ FastMarchingImageFilter<TLevelSet,TSpeedImage>
   // Check for C2 critical configurations
   for ( unsigned int i = 0; i < 8; i++ )
     {
+    unsigned int configuration = 0;
     for ( unsigned int j = 0; j < 8; j++ )
       {
-      neighborhoodPixels[j]
-        = ( It.GetPixel( this->m_C2Indices[i][j] ) == AlivePoint );
-      if( this->m_C2Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
+      configuration |= ( ( pixels >> this->m_C2Indices[i][j] ) & 1 ) << j;
       }
-    if( this->IsCriticalC2Configuration3D( neighborhoodPixels ) )
+    if( this->m_CriticalC2Configurations3D[configuration] )
       {
       return false;
       }
@@ -1251,6 +1260,24 @@ FastMarchingImageFilter<TLevelSet,TSpeedImage>
       this->m_C2Indices[i+4][j] = this->m_C2Indices[i+3][j] + addend;
       }
     }
+
+  // Tabulate the critical configurations, bit j of the table index holding
+  // pixel j of the C1 or C2 configuration.
+  Array<short> neighborhood( 8 );
+  for ( unsigned int n = 0; n < 256; n++ )
+    {
+    for ( unsigned int j = 0; j < 8; j++ )
+      {
+      neighborhood[j] = static_cast<short>( ( n >> j ) & 1 );
+      }
+    if( n < 16 )
+      {
+      this->m_CriticalC1Configurations3D[n] =
+        this->IsCriticalC1Configuration3D( neighborhood );
+      }
+    this->m_CriticalC2Configurations3D[n] =
+      ( this->IsCriticalC2Configuration3D( neighborhood ) != 0 );
+    }
 }
 
 } // namespace itk
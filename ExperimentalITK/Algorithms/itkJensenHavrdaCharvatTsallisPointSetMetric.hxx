@@ -224,22 +224,29 @@ JensenHavrdaCharvatTsallisPointSetMetric<TPointSet>
     {
     prefactor /= ( this->m_Alpha - 1.0 );
     }
+  typename DensityFunctionType::InputPointContainerType samplePoints;
+  typename DensityFunctionType::OutputContainerType probabilities;
+
   typename PointSetType::PointsContainerConstIterator It
     = samples[0]->GetPoints()->Begin();
   while( It != samples[0]->GetPoints()->End() )
     {
-    PointType samplePoint = It.Value();
+    samplePoints.push_back( It.Value() );
+    ++It;
+    }
+  densityFunctions[1]->EvaluatePoints( samplePoints, probabilities );
 
+  for( unsigned long n = 0; n < probabilities.size(); n++ )
+    {
     RealType probabilityStar =
-//         densityFunctions[0]->Evaluate( samplePoint ) *
+//         densityFunctions[0]->Evaluate( samplePoints[n] ) *
 //         static_cast<RealType>( points[0]->GetNumberOfPoints() ) +
-        densityFunctions[1]->Evaluate( samplePoint ) *
+        probabilities[n] *
         static_cast<RealType>( points[1]->GetNumberOfPoints() );
     probabilityStar /= totalNumberOfPoints;
 
     if( probabilityStar == 0 )
       {
-      ++It;
       continue;
       }
 
@@ -252,7 +259,6 @@ JensenHavrdaCharvatTsallisPointSetMetric<TPointSet>
       energyTerm1 += vcl_pow( probabilityStar,
         static_cast<RealType>( this->m_Alpha - 1.0 ) );
       }
-    ++It;
     }
   if( this->m_Alpha != 1.0 )
     {
@@ -272,17 +278,22 @@ JensenHavrdaCharvatTsallisPointSetMetric<TPointSet>
       {
       prefactor2 /= ( this->m_Alpha - 1.0 );
       }
+    samplePoints.clear();
     typename PointSetType::PointsContainerConstIterator It
       = samples[1]->GetPoints()->Begin();
     while( It != samples[1]->GetPoints()->End() )
       {
-      PointType samplePoint = It.Value();
+      samplePoints.push_back( It.Value() );
+      ++It;
+      }
+    densityFunctions[1]->EvaluatePoints( samplePoints, probabilities );
 
-      RealType probability = densityFunctions[1]->Evaluate( samplePoint );
+    for( unsigned long n = 0; n < probabilities.size(); n++ )
+      {
+      RealType probability = probabilities[n];
 
       if( probability == 0 )
         {
-        ++It;
         continue;
         }
 
@@ -295,7 +306,6 @@ JensenHavrdaCharvatTsallisPointSetMetric<TPointSet>
         energyTerm2 += ( prefactor2 * vcl_pow( probability,
           static_cast<RealType>( this->m_Alpha - 1.0 ) ) );
         }
-      ++It;
       }
     if( this->m_Alpha != 1.0 )
       {
@@ -27,6 +27,14 @@ namespace itk
  *
  * BinaryReinhardtMorphologicalImageFilter . 
  *
+ * If UseDistanceMapMorphology is on, the erosions, dilations, openings
+ * and closings by balls are computed by thresholding squared Euclidean
+ * distance maps (in voxels) instead of sweeping the structuring element.
+ * The cost does not depend on the radius, and the result is the same
+ * as with BinaryBallStructuringElement, whose offsets are those with a
+ * squared length <= radius * ( radius + 1 ).  The steps of an opening or
+ * closing are chained on a single mask.
+ *
  * \sa ImageToImageFilter BinaryDilateImageFilter BinaryMorphologyImageFilter
  */
 template <class TInputImage, class TOutputImage, class TKernel>
@@ -49,6 +57,8 @@ public:
   typedef TOutputImage                                OutputImageType;
   typedef typename TOutputImage::PixelType            OutputPixelType;
   typedef TKernel                                     KernelType;
+  typedef Image<float,
+    itkGetStaticConstMacro( OutputImageDimension )>   RealImageType;
 
   /** Standard class typedefs. */
   typedef BinaryReinhardtMorphologicalImageFilter     Self;
@@ -131,6 +141,13 @@ public:
   itkSetMacro( BoundarySmootherStructuringElementRadius, unsigned int );
   itkGetConstMacro( BoundarySmootherStructuringElementRadius, unsigned int );
 
+  /**
+   * distance map based morphology for the ball structuring elements
+   */
+  itkSetMacro( UseDistanceMapMorphology, bool );
+  itkGetConstMacro( UseDistanceMapMorphology, bool );
+  itkBooleanMacro( UseDistanceMapMorphology );
+
   /**
    * unclassified pixel processing
    */
@@ -161,6 +178,15 @@ private:
   void BoundarySmoother( typename OutputImageType::Pointer );
   void UnclassifiedPixelProcessing( typename OutputImageType::Pointer );
 
+  /** Erosion and dilation steps of the ball morphology. */
+  enum BallOperationType { BallDilate, BallErode, BallOpen, BallClose,
+    BallOpenClose };
+
+  /** Ball morphology of a binary (One/Zero) image with thresholded
+   * distance maps.  A new image is returned. */
+  typename OutputImageType::Pointer DistanceMapBallMorphology(
+    const OutputImageType *, unsigned int, BallOperationType );
+
   bool                                                  m_EmploySaltAndPepperRepair;
   unsigned int                                          m_SaltAndPepperMinimumSizeInPixels;
 
@@ -183,6 +209,8 @@ private:
   
   bool                                                  m_EmployUnclassifiedPixelProcessing;
 
+  bool                                                  m_UseDistanceMapMorphology;
+
 };
 
 } // end namespace itk
@@ -29,6 +29,7 @@
 #include "itkBinaryThresholdImageFilter.h"
 #include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
 #include "itkStatisticsImageFilter.h"
 
 namespace itk
@@ -59,6 +60,8 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutputImage, TKernel>
   this->m_BoundarySmootherStructuringElementRadius = 1;
 
    this->m_EmployUnclassifiedPixelProcessing = true;
+
+  this->m_UseDistanceMapMorphology = false;
 }
 
 template< class TInputImage, class TOutputImage, class TKernel>
@@ -198,18 +201,28 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
   ballStructuringElement.SetRadius( this->m_MinimumDiameterStructuringElementRadius );
   ballStructuringElement.CreateStructuringElement();
 
-  typedef BinaryErodeImageFilter<OutputImageType, OutputImageType,
-    BallStructuringElementType> EroderType;
-  typename EroderType::Pointer eroder = EroderType::New();
-  eroder->SetInput( thresholder->GetOutput() );
-  eroder->SetKernel( ballStructuringElement );
-  eroder->SetForegroundValue( NumericTraits<OutputPixelType>::One );
-  eroder->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
-  eroder->Update();
+  typename OutputImageType::Pointer eroded;
+  if ( this->m_UseDistanceMapMorphology )
+    {
+    eroded = this->DistanceMapBallMorphology( thresholder->GetOutput(),
+      this->m_MinimumDiameterStructuringElementRadius, BallErode );
+    }
+  else
+    {
+    typedef BinaryErodeImageFilter<OutputImageType, OutputImageType,
+      BallStructuringElementType> EroderType;
+    typename EroderType::Pointer eroder = EroderType::New();
+    eroder->SetInput( thresholder->GetOutput() );
+    eroder->SetKernel( ballStructuringElement );
+    eroder->SetForegroundValue( NumericTraits<OutputPixelType>::One );
+    eroder->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
+    eroder->Update();
+    eroded = eroder->GetOutput();
+    }
 
   typedef ConnectedComponentImageFilter<OutputImageType, OutputImageType> ConnectedComponentType;
   typename ConnectedComponentType::Pointer connecter = ConnectedComponentType::New();
-  connecter->SetInput( eroder->GetOutput() );
+  connecter->SetInput( eroded );
   connecter->FullyConnectedOff();
   connecter->Update();
 
@@ -233,14 +246,24 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
       }
     }
 
-  typedef BinaryDilateImageFilter<OutputImageType, OutputImageType,
-    BallStructuringElementType> DilaterType;
-  typename DilaterType::Pointer dilater = DilaterType::New();
-  dilater->SetInput( labeler->GetOutput() );
-  dilater->SetKernel( ballStructuringElement );
-  dilater->SetForegroundValue( NumericTraits<OutputPixelType>::One );
-  dilater->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
-  dilater->Update();
+  typename OutputImageType::Pointer dilated;
+  if ( this->m_UseDistanceMapMorphology )
+    {
+    dilated = this->DistanceMapBallMorphology( labeler->GetOutput(),
+      this->m_MinimumDiameterStructuringElementRadius, BallDilate );
+    }
+  else
+    {
+    typedef BinaryDilateImageFilter<OutputImageType, OutputImageType,
+      BallStructuringElementType> DilaterType;
+    typename DilaterType::Pointer dilater = DilaterType::New();
+    dilater->SetInput( labeler->GetOutput() );
+    dilater->SetKernel( ballStructuringElement );
+    dilater->SetForegroundValue( NumericTraits<OutputPixelType>::One );
+    dilater->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
+    dilater->Update();
+    dilated = dilater->GetOutput();
+    }
 
   typedef BinaryBoxStructuringElement<OutputPixelType,
     OutputImageDimension> BoxStructuringElementType;
@@ -251,7 +274,7 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
   typedef BinaryDilateImageFilter<OutputImageType, OutputImageType,
     BoxStructuringElementType> BoxDilaterType;
   typename BoxDilaterType::Pointer boxDilater = BoxDilaterType::New();
-  boxDilater->SetInput( dilater->GetOutput() );
+  boxDilater->SetInput( dilated );
   boxDilater->SetKernel( boxStructuringElement );
   boxDilater->SetForegroundValue( NumericTraits<OutputPixelType>::One );
   boxDilater->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
@@ -295,16 +318,26 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
     thresholder->SetUpperThreshold( static_cast<OutputPixelType>( i ) );
     thresholder->Update();
 
-    typedef BinaryMorphologicalClosingImageFilter<OutputImageType, OutputImageType,
-      BallStructuringElementType> CloserType;
-    typename CloserType::Pointer closer = CloserType::New();
-    closer->SetInput( thresholder->GetOutput() );
-    closer->SetKernel( ballStructuringElement );
-    closer->SetForegroundValue( NumericTraits<OutputPixelType>::One );
-    closer->Update();
+    typename OutputImageType::Pointer closed;
+    if ( this->m_UseDistanceMapMorphology )
+      {
+      closed = this->DistanceMapBallMorphology( thresholder->GetOutput(),
+        this->m_MinimumDiameterStructuringElementRadius, BallClose );
+      }
+    else
+      {
+      typedef BinaryMorphologicalClosingImageFilter<OutputImageType, OutputImageType,
+        BallStructuringElementType> CloserType;
+      typename CloserType::Pointer closer = CloserType::New();
+      closer->SetInput( thresholder->GetOutput() );
+      closer->SetKernel( ballStructuringElement );
+      closer->SetForegroundValue( NumericTraits<OutputPixelType>::One );
+      closer->Update();
+      closed = closer->GetOutput();
+      }
 
-    ImageRegionIterator<OutputImageType> ItC( closer->GetOutput(),
-      closer->GetOutput()->GetRequestedRegion() );
+    ImageRegionIterator<OutputImageType> ItC( closed,
+      closed->GetRequestedRegion() );
     ImageRegionIterator<OutputImageType> ItI( image,
       image->GetRequestedRegion() );
     ItC.GoToBegin();
@@ -388,14 +421,24 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
   ballStructuringElement.SetRadius( this->m_MinimumSizeStructuringElementRadius );
   ballStructuringElement.CreateStructuringElement();
 
-  typedef BinaryErodeImageFilter<OutputImageType, OutputImageType,
-    BallStructuringElementType> EroderType;
-  typename EroderType::Pointer eroder = EroderType::New();
-  eroder->SetInput( thresholder->GetOutput() );
-  eroder->SetKernel( ballStructuringElement );
-  eroder->SetForegroundValue( NumericTraits<OutputPixelType>::One );
-  eroder->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
-  eroder->Update();
+  typename OutputImageType::Pointer eroded;
+  if ( this->m_UseDistanceMapMorphology )
+    {
+    eroded = this->DistanceMapBallMorphology( thresholder->GetOutput(),
+      this->m_MinimumSizeStructuringElementRadius, BallErode );
+    }
+  else
+    {
+    typedef BinaryErodeImageFilter<OutputImageType, OutputImageType,
+      BallStructuringElementType> EroderType;
+    typename EroderType::Pointer eroder = EroderType::New();
+    eroder->SetInput( thresholder->GetOutput() );
+    eroder->SetKernel( ballStructuringElement );
+    eroder->SetForegroundValue( NumericTraits<OutputPixelType>::One );
+    eroder->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
+    eroder->Update();
+    eroded = eroder->GetOutput();
+    }
 
   typedef BinaryBoxStructuringElement<OutputPixelType,
     OutputImageDimension> BoxStructuringElementType;
@@ -407,7 +450,7 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
     OutputImageType, OutputImageType, BoxStructuringElementType> ConditionalDilaterType;
 
   typename ConditionalDilaterType::Pointer dilater = ConditionalDilaterType::New();
-  dilater->SetInput( eroder->GetOutput() );
+  dilater->SetInput( eroded );
   dilater->SetScaling( 50 );
   dilater->SetKernel( boxStructuringElement );
   dilater->SetBoundedSpaceImage( thresholder->GetOutput() );
@@ -450,14 +493,24 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
   ballStructuringElement.SetRadius( this->m_MaximumDiameterStructuringElementRadius );
   ballStructuringElement.CreateStructuringElement();
 
-  typedef BinaryMorphologicalOpeningImageFilter<OutputImageType, OutputImageType,
-    BallStructuringElementType> OpenerType;
-  typename OpenerType::Pointer opener = OpenerType::New();
-  opener->SetInput( thresholder->GetOutput() );
-  opener->SetKernel( ballStructuringElement );
-  opener->SetForegroundValue( NumericTraits<OutputPixelType>::One );
-  opener->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
-  opener->Update();
+  typename OutputImageType::Pointer opened;
+  if ( this->m_UseDistanceMapMorphology )
+    {
+    opened = this->DistanceMapBallMorphology( thresholder->GetOutput(),
+      this->m_MaximumDiameterStructuringElementRadius, BallOpen );
+    }
+  else
+    {
+    typedef BinaryMorphologicalOpeningImageFilter<OutputImageType, OutputImageType,
+      BallStructuringElementType> OpenerType;
+    typename OpenerType::Pointer opener = OpenerType::New();
+    opener->SetInput( thresholder->GetOutput() );
+    opener->SetKernel( ballStructuringElement );
+    opener->SetForegroundValue( NumericTraits<OutputPixelType>::One );
+    opener->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
+    opener->Update();
+    opened = opener->GetOutput();
+    }
 
   typedef BinaryBoxStructuringElement<OutputPixelType,
     OutputImageDimension> BoxStructuringElementType;
@@ -468,7 +521,7 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
   typedef BinaryDilateImageFilter<OutputImageType, OutputImageType,
     BoxStructuringElementType> DilaterType;
   typename DilaterType::Pointer dilater = DilaterType::New();
-  dilater->SetInput( opener->GetOutput() );
+  dilater->SetInput( opened );
   dilater->SetKernel( boxStructuringElement );
   dilater->SetForegroundValue( NumericTraits<OutputPixelType>::One );
   dilater->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
@@ -616,26 +669,35 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
   ballStructuringElement.SetRadius( this->m_BoundarySmootherStructuringElementRadius );
   ballStructuringElement.CreateStructuringElement();
 
-  typedef BinaryMorphologicalOpeningImageFilter<OutputImageType, OutputImageType,
-    BallStructuringElementType> OpenerType;
-  typename OpenerType::Pointer opener = OpenerType::New();
-  opener->SetInput( thresholder->GetOutput() );
-  opener->SetKernel( ballStructuringElement );
-  opener->SetForegroundValue( NumericTraits<OutputPixelType>::One );
-  opener->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
-  opener->Update();
-
-  typedef BinaryMorphologicalClosingImageFilter<OutputImageType, OutputImageType,
-    BallStructuringElementType> CloserType;
-  typename OpenerType::Pointer closer = OpenerType::New();
-  closer->SetInput( opener->GetOutput() );
-  closer->SetKernel( ballStructuringElement );
-  closer->SetForegroundValue( NumericTraits<OutputPixelType>::One );
-  closer->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
-  closer->Update();
-
-  ImageRegionIterator<OutputImageType> ItC( closer->GetOutput(),
-    closer->GetOutput()->GetRequestedRegion() );
+  typename OutputImageType::Pointer smoothed;
+  if ( this->m_UseDistanceMapMorphology )
+    {
+    smoothed = this->DistanceMapBallMorphology( thresholder->GetOutput(),
+      this->m_BoundarySmootherStructuringElementRadius, BallOpenClose );
+    }
+  else
+    {
+    typedef BinaryMorphologicalOpeningImageFilter<OutputImageType, OutputImageType,
+      BallStructuringElementType> OpenerType;
+    typename OpenerType::Pointer opener = OpenerType::New();
+    opener->SetInput( thresholder->GetOutput() );
+    opener->SetKernel( ballStructuringElement );
+    opener->SetForegroundValue( NumericTraits<OutputPixelType>::One );
+    opener->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
+    opener->Update();
+
+    typedef BinaryMorphologicalClosingImageFilter<OutputImageType, OutputImageType,
+      BallStructuringElementType> CloserType;
+    typename CloserType::Pointer closer = CloserType::New();
+    closer->SetInput( opener->GetOutput() );
+    closer->SetKernel( ballStructuringElement );
+    closer->SetForegroundValue( NumericTraits<OutputPixelType>::One );
+    closer->Update();
+    smoothed = closer->GetOutput();
+    }
+
+  ImageRegionIterator<OutputImageType> ItC( smoothed,
+    smoothed->GetRequestedRegion() );
   ItI.GoToBegin();
   ItC.GoToBegin();
   ItL.GoToBegin();
@@ -673,6 +735,101 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
     }
 }
 
+template <class TInputImage, class TOutput, class TKernel>
+typename BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
+  ::OutputImageType::Pointer
+BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
+::DistanceMapBallMorphology( const OutputImageType *image,
+  unsigned int radius, BallOperationType operation )
+{
+  /**
+   * Sequence of elementary steps (true for a dilation).
+   */
+  std::vector<bool> isDilation;
+  switch ( operation )
+    {
+    case BallDilate:
+      isDilation.push_back( true );
+      break;
+    case BallErode:
+      isDilation.push_back( false );
+      break;
+    case BallOpen:
+      isDilation.push_back( false );
+      isDilation.push_back( true );
+      break;
+    case BallClose:
+      isDilation.push_back( true );
+      isDilation.push_back( false );
+      break;
+    case BallOpenClose:
+      isDilation.push_back( false );
+      isDilation.push_back( true );
+      isDilation.push_back( true );
+      isDilation.push_back( false );
+      break;
+    }
+
+  // squared radius of BinaryBallStructuringElement, ( radius + 0.5 )^2 floored
+  const float threshold = static_cast<float>( radius * ( radius + 1 ) );
+
+  typename OutputImageType::Pointer mask = OutputImageType::New();
+  mask->CopyInformation( image );
+  mask->SetRegions( image->GetRequestedRegion() );
+  mask->Allocate();
+
+  ImageRegionConstIterator<OutputImageType> ItI( image,
+    image->GetRequestedRegion() );
+  ImageRegionIterator<OutputImageType> ItM( mask,
+    mask->GetRequestedRegion() );
+  for ( ItI.GoToBegin(), ItM.GoToBegin(); !ItI.IsAtEnd(); ++ItI, ++ItM )
+    {
+    ItM.Set( ItI.Get() );
+    }
+
+  for ( unsigned int n = 0; n < isDilation.size(); n++ )
+    {
+    /**
+     * A dilation keeps the voxels within the radius of the foreground and
+     * an erosion the voxels farther than the radius from the background,
+     * i.e. outside the dilation of the background.  The voxels outside the
+     * image are neither, as in BinaryErodeImageFilter.
+     */
+    typedef SignedMaurerDistanceMapImageFilter
+      <OutputImageType, RealImageType> DistancerType;
+    typename DistancerType::Pointer distancer = DistancerType::New();
+    distancer->SetInput( mask );
+    distancer->SetSquaredDistance( true );
+    distancer->SetUseImageSpacing( false );
+    distancer->SetInsideIsPositive( false );
+    if ( isDilation[n] )
+      {
+      distancer->SetBackgroundValue( NumericTraits<OutputPixelType>::Zero );
+      }
+    else
+      {
+      distancer->SetBackgroundValue( NumericTraits<OutputPixelType>::One );
+      }
+    distancer->Update();
+
+    ImageRegionConstIterator<RealImageType> ItD( distancer->GetOutput(),
+      distancer->GetOutput()->GetRequestedRegion() );
+    for ( ItD.GoToBegin(), ItM.GoToBegin(); !ItD.IsAtEnd(); ++ItD, ++ItM )
+      {
+      if ( ( ItD.Get() <= threshold ) == isDilation[n] )
+        {
+        ItM.Set( NumericTraits<OutputPixelType>::One );
+        }
+      else
+        {
+        ItM.Set( NumericTraits<OutputPixelType>::Zero );
+        }
+      }
+    }
+
+  return mask;
+}
+
 /**
  * Standard "PrintSelf" method
  */
@@ -747,6 +904,9 @@ BinaryReinhardtMorphologicalImageFilter<TInputImage, TOutput, TKernel>
        << ":  " << "EmployUnclassifiedPixelProcessing" << std::endl;
     }
 
+  os << indent << "UseDistanceMapMorphology: "
+     << this->m_UseDistanceMapMorphology << std::endl;
+
 }
 
 } // end namespace itk
@@ -5,6 +5,9 @@
 #include <itkImageToImageFilter.h>
 #include <itkImageRegionIteratorWithIndex.h>
 #include <itkConstantBoundaryCondition.h>
+#include "itkSimplePointLookupTable.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -32,7 +35,12 @@ namespace itk
 * Building skeleton models via 3-D medial surface/axis thinning algorithms.
 * Computer Vision, Graphics, and Image Processing, 56(6):462--478, 1994.
 * 
-* To do: Make use of multi-threading.
+* The border points of each type are collected in parallel.  They are then
+* re-checked and deleted one subfield after the other, where the eight
+* subfields group the points by the parity of their indices, so that the
+* points of a subfield can be processed in parallel.  Simple points are
+* classified with the SimplePointLookupTable, whose table is built the
+* first time the filter runs in a process.
 *
 * \author Hanno Homann, Oxford University, Wolfson Medical Vision Lab, UK.
 * 
@@ -133,19 +141,49 @@ protected:
   /**  Compute thinning Image. */
   void ComputeThinImage();
   
+  /** Packed 3x3x3 neighborhood, see SimplePointLookupTable. */
+  typedef SimplePointLookupTable::ConfigurationType ConfigurationType;
+
+  /** Pack the 26 neighbors of the current position of the iterator. */
+  ConfigurationType GetConfiguration( const NeighborhoodIteratorType & it ) const;
+
+  /** Collect the simple border points of type currentBorder in a region. */
+  void FindSimpleBorderPoints( const RegionType & region, int currentBorder,
+    const int *eulerLUT, std::vector< IndexType > & simpleBorderPoints );
+
+  /** Delete the points [begin, end) of a subfield that are still simple.
+   *  Returns the number of deleted points. */
+  unsigned long DeleteSimplePoints( const std::vector< IndexType > & points,
+    unsigned long begin, unsigned long end );
+
   /**  isEulerInvariant [Lee94] */
-  bool isEulerInvariant(NeighborhoodType neighbors, int *LUT);
+  bool isEulerInvariant(ConfigurationType neighbors, const int *LUT) const;
   void fillEulerLUT(int *LUT);  
   /**  isSimplePoint [Lee94] */
-  bool isSimplePoint(NeighborhoodType neighbors);
-  /**  Octree_labeling [Lee94] */
-  void Octree_labeling(int octant, int label, int *cube);
-
+  bool isSimplePoint(ConfigurationType neighbors) const;
+
+  /** Static functions used by the multi-threaded passes. */
+  static ITK_THREAD_RETURN_TYPE FindSimpleBorderPointsThreaderCallback( void *arg );
+  static ITK_THREAD_RETURN_TYPE DeleteSimplePointsThreaderCallback( void *arg );
+
+  /** Internal structure used for passing the state to the threads. */
+  struct ThinningThreadStruct
+  {
+    Self                                  *Filter;
+    const int                             *EulerLUT;
+    int                                    CurrentBorder;
+    std::vector< std::vector< IndexType > > SimpleBorderPoints;
+    const std::vector< IndexType >        *Subfield;
+    std::vector< unsigned long >           NumberOfDeletedPoints;
+  };
 
 private:   
   BinaryThinning3DImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
+  /** (26,6) simple point table, obtained once before the threads start. */
+  const unsigned int *m_SimplePointTable;
+
 }; // end of BinaryThinning3DImageFilter class
 
 } //end namespace itk
@@ -7,6 +7,7 @@
 #include "itkImageRegionConstIterator.h"
 #include "itkImageRegionIterator.h"
 #include "itkNeighborhoodIterator.h"
+#include "itkSimplePointLookupTable.h"
 #include <vector>
 
 namespace itk
@@ -25,6 +26,7 @@ BinaryThinning3DImageFilter<TInputImage,TOutputImage>
   OutputImagePointer thinImage = OutputImageType::New();
   this->SetNthOutput( 0, thinImage.GetPointer() );
 
+  this->m_SimplePointTable = NULL;
 }
 
 /**
@@ -99,33 +101,21 @@ BinaryThinning3DImageFilter<TInputImage,TOutputImage>
 ::ComputeThinImage() 
 {
   itkDebugMacro( << "ComputeThinImage Start");
-  OutputImagePointer thinImage = GetThinning();
 
-  typename OutputImageType::RegionType region = thinImage->GetRequestedRegion();
-  
-  ConstBoundaryConditionType boundaryCondition;
-  boundaryCondition.SetConstant( 0 );
+  // prepare Euler LUT [Lee94]
+  int eulerLUT[256]; 
+  fillEulerLUT( eulerLUT );
 
-  typename NeighborhoodIteratorType::RadiusType radius;
-  radius.Fill(1);
-  NeighborhoodIteratorType ot( radius, thinImage, region );
-  ot.SetBoundaryCondition( boundaryCondition );
+  ThinningThreadStruct str;
+  str.Filter = this;
+  str.EulerLUT = eulerLUT;
 
-  std::vector < IndexType > simpleBorderPoints;
-  typename std::vector < IndexType >::iterator simpleBorderPointsIt;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
 
-  // Define offsets
-  typedef typename NeighborhoodIteratorType::OffsetType OffsetType;
-  OffsetType N   = {{ 0,-1, 0}};  // north
-  OffsetType S   = {{ 0, 1, 0}};  // south
-  OffsetType E   = {{ 1, 0, 0}};  // east
-  OffsetType W   = {{-1, 0, 0}};  // west
-  OffsetType U   = {{ 0, 0, 1}};  // up
-  OffsetType B   = {{ 0, 0,-1}};  // bottom
+  // Build or load the simple point table before starting the threads,
+  // which then look it up without locking.
+  this->m_SimplePointTable = SimplePointLookupTable::GetTable( 4 );
 
-  // prepare Euler LUT [Lee94]
-  int eulerLUT[256]; 
-  fillEulerLUT( eulerLUT );
   // Loop through the image several times until there is no change.
   int unchangedBorders = 0;
   while( unchangedBorders < 6 )  // loop until no change for all the six border types
@@ -133,88 +123,218 @@ BinaryThinning3DImageFilter<TInputImage,TOutputImage>
     unchangedBorders = 0;
     for( int currentBorder = 1; currentBorder <= 6; currentBorder++)
     {
-      // Loop through the image.
-      for ( ot.GoToBegin(); !ot.IsAtEnd(); ++ot )
-      { 
-        // check if point is foreground
-        if ( ot.GetCenterPixel() != 1 )
-        {
-          continue;         // current point is already background 
-        }
-        // check 6-neighbors if point is a border point of type currentBorder
-        bool isBorderPoint = false;
-        if( currentBorder == 1 && ot.GetPixel(N)<=0 )
-          isBorderPoint = true;
-        if( currentBorder == 2 && ot.GetPixel(S)<=0 )
-          isBorderPoint = true;
-        if( currentBorder == 3 && ot.GetPixel(E)<=0 )
-          isBorderPoint = true;
-        if( currentBorder == 4 && ot.GetPixel(W)<=0 )
-          isBorderPoint = true;
-        if( currentBorder == 5 && ot.GetPixel(U)<=0 )
-          isBorderPoint = true;
-        if( currentBorder == 6 && ot.GetPixel(B)<=0 )
-          isBorderPoint = true;
-        if( !isBorderPoint )
-        {
-          continue;         // current point is not deletable
-        }        
-        // check if point is the end of an arc
-        int numberOfNeighbors = -1;   // -1 and not 0 because the center pixel will be counted as well  
-        for( int i = 0; i < 27; i++ ) // i =  0..26
-          if( ot.GetPixel(i)==1 )
-            numberOfNeighbors++;
-
-        if( numberOfNeighbors == 1 )
-        {
-          continue;         // current point is not deletable
-        }
-
-        // check if point is Euler invariant
-        if( !isEulerInvariant( ot.GetNeighborhood(), eulerLUT ) )
-        {
-          continue;         // current point is not deletable
-        }
-
-        // check if point is simple (deletion does not change connectivity in the 3x3x3 neighborhood)
-        if( !isSimplePoint( ot.GetNeighborhood() ) )
+      // Collect the simple border points of each piece of the image in
+      // parallel.
+      str.CurrentBorder = currentBorder;
+      str.SimpleBorderPoints.clear();
+      str.SimpleBorderPoints.resize( this->GetNumberOfThreads() );
+      this->GetMultiThreader()->SetSingleMethod(
+        this->FindSimpleBorderPointsThreaderCallback, &str );
+      this->GetMultiThreader()->SingleMethodExecute();
+
+      // Re-check the points before deleting them to preserve connectivity.
+      // Points whose indices have the same parity along every axis are not
+      // 26-adjacent, so deleting one does not change the neighborhood of
+      // the others.  Each of these eight subfields is re-checked in
+      // parallel and the subfields are processed one after the other.
+      std::vector < IndexType > subfields[8];
+      for( unsigned int t = 0; t < str.SimpleBorderPoints.size(); t++ )
+      {
+        for( unsigned int i = 0; i < str.SimpleBorderPoints[t].size(); i++ )
         {
-          continue;         // current point is not deletable
+          const IndexType & index = str.SimpleBorderPoints[t][i];
+          subfields[ ( index[0] & 1 ) | ( ( index[1] & 1 ) << 1 )
+            | ( ( index[2] & 1 ) << 2 ) ].push_back( index );
         }
+        str.SimpleBorderPoints[t].clear();
+      }
 
-        // add all simple border points to a list for sequential re-checking
-        simpleBorderPoints.push_back( ot.GetIndex() );
-      } // end image iteration loop
-
-      // sequential re-checking to preserve connectivity when
-      // deleting in a parallel way
       bool noChange = true;
-      for( simpleBorderPointsIt=simpleBorderPoints.begin(); simpleBorderPointsIt!=simpleBorderPoints.end(); simpleBorderPointsIt++)
+      for( unsigned int f = 0; f < 8; f++ )
       {
-       // 1. Set simple border point to 0
-        thinImage->SetPixel( *simpleBorderPointsIt, NumericTraits<OutputImagePixelType>::Zero);
-        // 2. Check if neighborhood is still connected
-        ot.SetLocation( *simpleBorderPointsIt );
-        if( !isSimplePoint( ot.GetNeighborhood() ) )
+        if( subfields[f].empty() )
         {
-          // we cannot delete current point, so reset
-          thinImage->SetPixel( *simpleBorderPointsIt, NumericTraits<OutputImagePixelType>::One );
+          continue;
         }
-        else
+        str.Subfield = &subfields[f];
+        str.NumberOfDeletedPoints.assign( this->GetNumberOfThreads(), 0 );
+        this->GetMultiThreader()->SetSingleMethod(
+          this->DeleteSimplePointsThreaderCallback, &str );
+        this->GetMultiThreader()->SingleMethodExecute();
+        for( unsigned int t = 0; t < str.NumberOfDeletedPoints.size(); t++ )
         {
-          noChange = false;
+          if( str.NumberOfDeletedPoints[t] > 0 )
+          {
+            noChange = false;
+          }
         }
       }
       if( noChange )
         unchangedBorders++;
-
-      simpleBorderPoints.clear();
     } // end currentBorder for loop
   } // end unchangedBorders while loop
 
   itkDebugMacro( << "ComputeThinImage End");
 }
 
+/**
+ *  Collect the simple border points of type currentBorder in a region.
+ */
+template <class TInputImage,class TOutputImage>
+void 
+BinaryThinning3DImageFilter<TInputImage,TOutputImage>
+::FindSimpleBorderPoints( const RegionType & region, int currentBorder,
+  const int *eulerLUT, std::vector< IndexType > & simpleBorderPoints )
+{
+  OutputImagePointer thinImage = GetThinning();
+
+  ConstBoundaryConditionType boundaryCondition;
+  boundaryCondition.SetConstant( 0 );
+
+  typename NeighborhoodIteratorType::RadiusType radius;
+  radius.Fill(1);
+  NeighborhoodIteratorType ot( radius, thinImage, region );
+  ot.SetBoundaryCondition( boundaryCondition );
+
+  // Neighborhood indices of the north, south, east, west, up and bottom
+  // neighbors, in the order of the border types.
+  static const unsigned int borderNeighbor[6] = { 10, 16, 14, 12, 22, 4 };
+  const ConfigurationType borderMask =
+    SimplePointLookupTable::GetMask( borderNeighbor[currentBorder - 1] );
+
+  // Loop through the image.
+  for ( ot.GoToBegin(); !ot.IsAtEnd(); ++ot )
+  { 
+    // check if point is foreground
+    if ( ot.GetCenterPixel() != 1 )
+    {
+      continue;         // current point is already background 
+    }
+    const ConfigurationType neighbors = this->GetConfiguration( ot );
+
+    // check 6-neighbors if point is a border point of type currentBorder
+    if( neighbors & borderMask )
+    {
+      continue;         // current point is not deletable
+    }        
+    // check if point is the end of an arc
+    if( ( neighbors & ( neighbors - 1 ) ) == 0 && neighbors != 0 )
+    {
+      continue;         // current point is not deletable
+    }
+
+    // check if point is Euler invariant
+    if( !isEulerInvariant( neighbors, eulerLUT ) )
+    {
+      continue;         // current point is not deletable
+    }
+
+    // check if point is simple (deletion does not change connectivity in the 3x3x3 neighborhood)
+    if( !isSimplePoint( neighbors ) )
+    {
+      continue;         // current point is not deletable
+    }
+
+    // add all simple border points to a list for sequential re-checking
+    simpleBorderPoints.push_back( ot.GetIndex() );
+  } // end image iteration loop
+}
+
+/**
+ *  Delete the points of a subfield that are still simple.
+ */
+template <class TInputImage,class TOutputImage>
+unsigned long 
+BinaryThinning3DImageFilter<TInputImage,TOutputImage>
+::DeleteSimplePoints( const std::vector< IndexType > & points,
+  unsigned long begin, unsigned long end )
+{
+  OutputImagePointer thinImage = GetThinning();
+
+  ConstBoundaryConditionType boundaryCondition;
+  boundaryCondition.SetConstant( 0 );
+
+  typename NeighborhoodIteratorType::RadiusType radius;
+  radius.Fill(1);
+  NeighborhoodIteratorType ot( radius, thinImage,
+    thinImage->GetRequestedRegion() );
+  ot.SetBoundaryCondition( boundaryCondition );
+
+  unsigned long numberOfDeletedPoints = 0;
+  for( unsigned long i = begin; i < end; i++ )
+  {
+    // The center point is not part of the configuration, so the check is
+    // the same before and after setting the point to 0.
+    ot.SetLocation( points[i] );
+    if( isSimplePoint( this->GetConfiguration( ot ) ) )
+    {
+      ot.SetCenterPixel( NumericTraits<OutputImagePixelType>::Zero );
+      numberOfDeletedPoints++;
+    }
+  }
+  return numberOfDeletedPoints;
+}
+
+template <class TInputImage,class TOutputImage>
+ITK_THREAD_RETURN_TYPE 
+BinaryThinning3DImageFilter<TInputImage,TOutputImage>
+::FindSimpleBorderPointsThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  ThinningThreadStruct *str =
+    static_cast<ThinningThreadStruct *>( info->UserData );
+
+  RegionType splitRegion;
+  int total = str->Filter->SplitRequestedRegion( info->ThreadID,
+    info->NumberOfThreads, splitRegion );
+  if( info->ThreadID < total )
+  {
+    str->Filter->FindSimpleBorderPoints( splitRegion, str->CurrentBorder,
+      str->EulerLUT, str->SimpleBorderPoints[info->ThreadID] );
+  }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage,class TOutputImage>
+ITK_THREAD_RETURN_TYPE 
+BinaryThinning3DImageFilter<TInputImage,TOutputImage>
+::DeleteSimplePointsThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  ThinningThreadStruct *str =
+    static_cast<ThinningThreadStruct *>( info->UserData );
+
+  const unsigned long size = str->Subfield->size();
+  const unsigned long begin = size * info->ThreadID / info->NumberOfThreads;
+  const unsigned long end = size * ( info->ThreadID + 1 )
+    / info->NumberOfThreads;
+  str->NumberOfDeletedPoints[info->ThreadID] =
+    str->Filter->DeleteSimplePoints( *str->Subfield, begin, end );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/**
+ *  Pack the 26 neighbors of the current position into a configuration.
+ */
+template <class TInputImage,class TOutputImage>
+typename BinaryThinning3DImageFilter<TInputImage,TOutputImage>
+::ConfigurationType 
+BinaryThinning3DImageFilter<TInputImage,TOutputImage>
+::GetConfiguration( const NeighborhoodIteratorType & it ) const
+{
+  ConfigurationType configuration = 0;
+  for( unsigned int i = 0; i < 27; i++ )
+  {
+    if( i != 13 && it.GetPixel( i ) == 1 )
+    {
+      configuration |= SimplePointLookupTable::GetMask( i );
+    }
+  }
+  return configuration;
+}
+
 /**
  *  Generate ThinImage
  */
@@ -378,147 +498,32 @@ BinaryThinning3DImageFilter<TInputImage,TOutputImage>
 template <class TInputImage,class TOutputImage>
 bool 
 BinaryThinning3DImageFilter<TInputImage,TOutputImage>
-::isEulerInvariant(NeighborhoodType neighbors, int *LUT)
+::isEulerInvariant(ConfigurationType neighbors, const int *LUT) const
 {
+  // Neighborhood indices of the octants SWU, SEU, NWU, NEU, SWB, SEB, NWB
+  // and NEB, for the bits 128 down to 2 of the octant configuration.
+  static const unsigned int octants[8][7] = {
+    { 24, 25, 15, 16, 21, 22, 12 },
+    { 26, 23, 17, 14, 25, 22, 16 },
+    { 18, 21,  9, 12, 19, 22, 10 },
+    { 20, 23, 19, 22, 11, 14, 10 },
+    {  6, 15,  7, 16,  3, 12,  4 },
+    {  8,  7, 17, 16,  5,  4, 14 },
+    {  0,  9,  3, 12,  1, 10,  4 },
+    {  2,  1, 11, 10,  5,  4, 14 } };
+
   // calculate Euler characteristic for each octant and sum up
   int EulerChar = 0;
-  unsigned char n;
-  // Octant SWU
-  n = 1;
-  if( neighbors[24]==1 )
-    n |= 128;
-  if( neighbors[25]==1 )
-    n |=  64;
-  if( neighbors[15]==1 )
-    n |=  32;
-  if( neighbors[16]==1 )
-    n |=  16;
-  if( neighbors[21]==1 )
-    n |=   8;
-  if( neighbors[22]==1 )
-    n |=   4;
-  if( neighbors[12]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
-  // Octant SEU
-  n = 1;
-  if( neighbors[26]==1 )
-    n |= 128;
-  if( neighbors[23]==1 )
-    n |=  64;
-  if( neighbors[17]==1 )
-    n |=  32;
-  if( neighbors[14]==1 )
-    n |=  16;
-  if( neighbors[25]==1 )
-    n |=   8;
-  if( neighbors[22]==1 )
-    n |=   4;
-  if( neighbors[16]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
-  // Octant NWU
-  n = 1;
-  if( neighbors[18]==1 )
-    n |= 128;
-  if( neighbors[21]==1 )
-    n |=  64;
-  if( neighbors[9]==1 )
-    n |=  32;
-  if( neighbors[12]==1 )
-    n |=  16;
-  if( neighbors[19]==1 )
-    n |=   8;
-  if( neighbors[22]==1 )
-    n |=   4;
-  if( neighbors[10]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
-  // Octant NEU
-  n = 1;
-  if( neighbors[20]==1 )
-    n |= 128;
-  if( neighbors[23]==1 )
-    n |=  64;
-  if( neighbors[19]==1 )
-    n |=  32;
-  if( neighbors[22]==1 )
-    n |=  16;
-  if( neighbors[11]==1 )
-    n |=   8;
-  if( neighbors[14]==1 )
-    n |=   4;
-  if( neighbors[10]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
-  // Octant SWB
-  n = 1;
-  if( neighbors[6]==1 )
-    n |= 128;
-  if( neighbors[15]==1 )
-    n |=  64;
-  if( neighbors[7]==1 )
-    n |=  32;
-  if( neighbors[16]==1 )
-    n |=  16;
-  if( neighbors[3]==1 )
-    n |=   8;
-  if( neighbors[12]==1 )
-    n |=   4;
-  if( neighbors[4]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
-  // Octant SEB
-  n = 1;
-  if( neighbors[8]==1 )
-    n |= 128;
-  if( neighbors[7]==1 )
-    n |=  64;
-  if( neighbors[17]==1 )
-    n |=  32;
-  if( neighbors[16]==1 )
-    n |=  16;
-  if( neighbors[5]==1 )
-    n |=   8;
-  if( neighbors[4]==1 )
-    n |=   4;
-  if( neighbors[14]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
-  // Octant NWB
-  n = 1;
-  if( neighbors[0]==1 )
-    n |= 128;
-  if( neighbors[9]==1 )
-    n |=  64;
-  if( neighbors[3]==1 )
-    n |=  32;
-  if( neighbors[12]==1 )
-    n |=  16;
-  if( neighbors[1]==1 )
-    n |=   8;
-  if( neighbors[10]==1 )
-    n |=   4;
-  if( neighbors[4]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
-  // Octant NEB
-  n = 1;
-  if( neighbors[2]==1 )
-    n |= 128;
-  if( neighbors[1]==1 )
-    n |=  64;
-  if( neighbors[11]==1 )
-    n |=  32;
-  if( neighbors[10]==1 )
-    n |=  16;
-  if( neighbors[5]==1 )
-    n |=   8;
-  if( neighbors[4]==1 )
-    n |=   4;
-  if( neighbors[14]==1 )
-    n |=   2;
-  EulerChar += LUT[n];
+  for( unsigned int o = 0; o < 8; o++ )
+  {
+    unsigned char n = 1;
+    for( unsigned int j = 0; j < 7; j++ )
+    {
+      if( neighbors & SimplePointLookupTable::GetMask( octants[o][j] ) )
+        n |= 128 >> j;
+    }
+    EulerChar += LUT[n];
+  }
   if( EulerChar == 0 )
     return true;
   else
@@ -526,430 +531,18 @@ BinaryThinning3DImageFilter<TInputImage,TOutputImage>
 }
 
 /** 
- * Check if current point is a Simple Point.
- * This method is named 'N(v)_labeling' in [Lee94].
- * Outputs the number of connected objects in a neighborhood of a point
- * after this point would have been removed.
+ * Check if current point is a Simple Point, i.e. if it can be deleted
+ * without changing the topology of its 3x3x3 neighborhood for the (26,6)
+ * connectivity.  This replaces the 'N(v)_labeling' octree labeling of
+ * [Lee94] with a lookup in the precomputed SimplePointLookupTable.
  */
 template <class TInputImage,class TOutputImage>
 bool 
 BinaryThinning3DImageFilter<TInputImage,TOutputImage>
-::isSimplePoint(NeighborhoodType neighbors)
-{
-  // copy neighbors for labeling
-  int cube[26];
-  int i;
-  for( i = 0; i < 13; i++ )  // i =  0..12 -> cube[0..12]
-    cube[i] = neighbors[i];
-  // i != 13 : ignore center pixel when counting (see [Lee94])
-  for( i = 14; i < 27; i++ ) // i = 14..26 -> cube[13..25]
-    cube[i-1] = neighbors[i];
-  // set initial label
-  int label = 2;
-  // for all points in the neighborhood
-  for( int i = 0; i < 26; i++ )
-  {
-    if( cube[i]==1 )     // voxel has not been labelled yet
-    {
-      // start recursion with any octant that contains the point i
-      switch( i )
-      {
-      case 0:
-      case 1:
-      case 3:
-      case 4:
-      case 9:
-      case 10:
-      case 12:
-        Octree_labeling(1, label, cube );
-        break;
-      case 2:
-      case 5:
-      case 11:
-      case 13:
-        Octree_labeling(2, label, cube );
-        break;
-      case 6:
-      case 7:
-      case 14:
-      case 15:
-        Octree_labeling(3, label, cube );
-        break;
-      case 8:
-      case 16:
-        Octree_labeling(4, label, cube );
-        break;
-      case 17:
-      case 18:
-      case 20:
-      case 21:
-        Octree_labeling(5, label, cube );
-        break;
-      case 19:
-      case 22:
-        Octree_labeling(6, label, cube );
-        break;
-      case 23:
-      case 24:
-        Octree_labeling(7, label, cube );
-        break;
-      case 25:
-        Octree_labeling(8, label, cube );
-        break;
-      }
-      label++;
-      if( label-2 >= 2 )
-      {
-        return false;
-      }
-    }
-  }
-  //return label-2; in [Lee94] if the number of connected compontents would be needed
-  return true;
-}
-
-/** 
- * Octree_labeling [Lee94]
- * This is a recursive method that calulates the number of connected
- * components in the 3D neighbourhood after the center pixel would
- * have been removed.
- */
-template <class TInputImage,class TOutputImage>
-void 
-BinaryThinning3DImageFilter<TInputImage,TOutputImage>
-::Octree_labeling(int octant, int label, int *cube)
+::isSimplePoint(ConfigurationType neighbors) const
 {
-  // check if there are points in the octant with value 1
-  if( octant==1 )
-  {
-   // set points in this octant to current label
-   // and recurseive labeling of adjacent octants
-    if( cube[0] == 1 )
-      cube[0] = label;
-    if( cube[1] == 1 )
-    {
-      cube[1] = label;        
-      Octree_labeling( 2, label, cube);
-    }
-    if( cube[3] == 1 )
-    {
-      cube[3] = label;        
-      Octree_labeling( 3, label, cube);
-    }
-    if( cube[4] == 1 )
-    {
-      cube[4] = label;        
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 4, label, cube);
-    }
-    if( cube[9] == 1 )
-    {
-      cube[9] = label;        
-      Octree_labeling( 5, label, cube);
-    }
-    if( cube[10] == 1 )
-    {
-      cube[10] = label;        
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 5, label, cube);
-      Octree_labeling( 6, label, cube);
-    }
-    if( cube[12] == 1 )
-    {
-      cube[12] = label;        
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 5, label, cube);
-      Octree_labeling( 7, label, cube);
-    }
-  }
-  if( octant==2 )
-  {
-    if( cube[1] == 1 )
-    {
-      cube[1] = label;
-      Octree_labeling( 1, label, cube);
-    }
-    if( cube[4] == 1 )
-    {
-      cube[4] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 4, label, cube);
-    }
-    if( cube[10] == 1 )
-    {
-      cube[10] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 5, label, cube);
-      Octree_labeling( 6, label, cube);
-    }
-    if( cube[2] == 1 )
-      cube[2] = label;        
-    if( cube[5] == 1 )
-    {
-      cube[5] = label;        
-      Octree_labeling( 4, label, cube);
-    }
-    if( cube[11] == 1 )
-    {
-      cube[11] = label;        
-      Octree_labeling( 6, label, cube);
-    }
-    if( cube[13] == 1 )
-    {
-      cube[13] = label;        
-      Octree_labeling( 4, label, cube);
-      Octree_labeling( 6, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-  }
-  if( octant==3 )
-  {
-    if( cube[3] == 1 )
-    {
-      cube[3] = label;        
-      Octree_labeling( 1, label, cube);
-    }
-    if( cube[4] == 1 )
-    {
-      cube[4] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 4, label, cube);
-    }
-    if( cube[12] == 1 )
-    {
-      cube[12] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 5, label, cube);
-      Octree_labeling( 7, label, cube);
-    }
-    if( cube[6] == 1 )
-      cube[6] = label;        
-    if( cube[7] == 1 )
-    {
-      cube[7] = label;        
-      Octree_labeling( 4, label, cube);
-    }
-    if( cube[14] == 1 )
-    {
-      cube[14] = label;        
-      Octree_labeling( 7, label, cube);
-    }
-    if( cube[15] == 1 )
-    {
-      cube[15] = label;        
-      Octree_labeling( 4, label, cube);
-      Octree_labeling( 7, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-  }
-  if( octant==4 )
-  {
-   if( cube[4] == 1 )
-    {
-      cube[4] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 3, label, cube);
-    }
-   if( cube[5] == 1 )
-    {
-      cube[5] = label;        
-      Octree_labeling( 2, label, cube);
-    }
-    if( cube[13] == 1 )
-    {
-      cube[13] = label;        
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 6, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-    if( cube[7] == 1 )
-    {
-      cube[7] = label;        
-      Octree_labeling( 3, label, cube);
-    }
-    if( cube[15] == 1 )
-    {
-      cube[15] = label;        
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 7, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-    if( cube[8] == 1 )
-      cube[8] = label;        
-    if( cube[16] == 1 )
-    {
-      cube[16] = label;        
-      Octree_labeling( 8, label, cube);
-    }
-  }
-  if( octant==5 )
-  {
-   if( cube[9] == 1 )
-    {
-      cube[9] = label;        
-      Octree_labeling( 1, label, cube);
-    }
-    if( cube[10] == 1 )
-    {
-      cube[10] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 6, label, cube);
-    }
-    if( cube[12] == 1 )
-    {
-      cube[12] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 7, label, cube);
-    }
-    if( cube[17] == 1 )
-      cube[17] = label;        
-    if( cube[18] == 1 )
-    {
-      cube[18] = label;        
-      Octree_labeling( 6, label, cube);
-    }
-    if( cube[20] == 1 )
-    {
-      cube[20] = label;        
-      Octree_labeling( 7, label, cube);
-    }
-    if( cube[21] == 1 )
-    {
-      cube[21] = label;        
-      Octree_labeling( 6, label, cube);
-      Octree_labeling( 7, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-  }
-  if( octant==6 )
-  {
-   if( cube[10] == 1 )
-    {
-      cube[10] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 5, label, cube);
-    }
-    if( cube[11] == 1 )
-    {
-      cube[11] = label;        
-      Octree_labeling( 2, label, cube);
-    }
-    if( cube[13] == 1 )
-    {
-      cube[13] = label;        
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 4, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-    if( cube[18] == 1 )
-    {
-      cube[18] = label;        
-      Octree_labeling( 5, label, cube);
-    }
-    if( cube[21] == 1 )
-    {
-      cube[21] = label;        
-      Octree_labeling( 5, label, cube);
-      Octree_labeling( 7, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-    if( cube[19] == 1 )
-      cube[19] = label;        
-    if( cube[22] == 1 )
-    {
-      cube[22] = label;        
-      Octree_labeling( 8, label, cube);
-    }
-  }
-  if( octant==7 )
-  {
-   if( cube[12] == 1 )
-    {
-      cube[12] = label;        
-      Octree_labeling( 1, label, cube);
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 5, label, cube);
-    }
-   if( cube[14] == 1 )
-    {
-      cube[14] = label;        
-      Octree_labeling( 3, label, cube);
-    }
-    if( cube[15] == 1 )
-    {
-      cube[15] = label;        
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 4, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-    if( cube[20] == 1 )
-    {
-      cube[20] = label;        
-      Octree_labeling( 5, label, cube);
-    }
-    if( cube[21] == 1 )
-    {
-      cube[21] = label;        
-      Octree_labeling( 5, label, cube);
-      Octree_labeling( 6, label, cube);
-      Octree_labeling( 8, label, cube);
-    }
-    if( cube[23] == 1 )
-      cube[23] = label;        
-    if( cube[24] == 1 )
-    {
-      cube[24] = label;        
-      Octree_labeling( 8, label, cube);
-    }
-  }
-  if( octant==8 )
-  {
-   if( cube[13] == 1 )
-    {
-      cube[13] = label;        
-      Octree_labeling( 2, label, cube);
-      Octree_labeling( 4, label, cube);
-      Octree_labeling( 6, label, cube);
-    }
-   if( cube[15] == 1 )
-    {
-      cube[15] = label;        
-      Octree_labeling( 3, label, cube);
-      Octree_labeling( 4, label, cube);
-      Octree_labeling( 7, label, cube);
-    }
-   if( cube[16] == 1 )
-    {
-      cube[16] = label;        
-      Octree_labeling( 4, label, cube);
-    }
-   if( cube[21] == 1 )
-    {
-      cube[21] = label;        
-      Octree_labeling( 5, label, cube);
-      Octree_labeling( 6, label, cube);
-      Octree_labeling( 7, label, cube);
-    }
-   if( cube[22] == 1 )
-    {
-      cube[22] = label;        
-      Octree_labeling( 6, label, cube);
-    }
-   if( cube[24] == 1 )
-    {
-      cube[24] = label;        
-      Octree_labeling( 7, label, cube);
-    }
-   if( cube[25] == 1 )
-      cube[25] = label;        
-  } 
+  return SimplePointLookupTable::IsSimple( this->m_SimplePointTable,
+    neighbors, 4 );
 }
 
 
@@ -21,6 +21,7 @@
 #include "itkNumericTraits.h"
 #include "itkArray.h"
 #include "itkImage.h"
+#include "itkPointKdTree.h"
 
 namespace itk {
 
@@ -42,6 +43,12 @@ namespace itk {
  * then computes the mean distance (in pixels) within the boundary pixels of
  * non-zero regions in the first image.
  *
+ * When the non-zero pixels of both images cover at most KdTreeVolumeFraction
+ * of the image, the distance map is replaced by a kd-tree over the boundary
+ * pixels (non-zero pixels with a zero neighbor of any kind) of the second
+ * image, which the threads query for the boundary pixels of the first
+ * image.
+ *
  * Use MeanDistanceImageFilter to compute the full Mean distance.
  *
  * This filter requires the largest possible region of the first image and the
@@ -120,6 +127,12 @@ public:
   /** Return the computed directed Mean distance. */
   itkGetConstMacro(ContourDirectedMeanDistance,RealType);
 
+  /** Set/Get the largest fraction of the image covered by the non-zero
+   * pixels of both inputs for which the kd-tree is used instead of the
+   * distance map.  0 always uses the distance map.  Default is 0.05. */
+  itkSetClampMacro(KdTreeVolumeFraction, double, 0.0, 1.0);
+  itkGetConstMacro(KdTreeVolumeFraction, double);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(InputHasNumericTraitsCheck,
@@ -158,7 +171,12 @@ private:
 
   typedef Image<RealType,itkGetStaticConstMacro(ImageDimension)> DistanceMapType;
 
+  typedef PointKdTree<RealType,itkGetStaticConstMacro(ImageDimension)> KdTreeType;
+
   typename DistanceMapType::Pointer   m_DistanceMap;
+  typename KdTreeType::Pointer        m_KdTree;
+  typename KdTreeType::PointType      m_KdTreeScales;
+  double                              m_KdTreeVolumeFraction;
   Array<RealType>                     m_MeanDistance;
   Array<int>                          m_Count;
   RealType                            m_ContourDirectedMeanDistance;
@@ -43,6 +43,8 @@ ContourDirectedMeanDistanceImageFilter<TInputImage1, TInputImage2>
   this->SetNumberOfRequiredInputs( 2 );
 
   m_DistanceMap = NULL;
+  m_KdTree = NULL;
+  m_KdTreeVolumeFraction = 0.05;
   m_ContourDirectedMeanDistance = NumericTraits<RealType>::Zero;
 }
 
@@ -137,6 +139,24 @@ ContourDirectedMeanDistanceImageFilter<TInputImage1, TInputImage2>
 
   typename FilterType::Pointer filter = FilterType::New();
 
+  // Small objects only need the distances to the boundary of the second
+  // object, in the units of the distance map
+  m_DistanceMap = NULL;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    m_KdTreeScales[d] = filter->GetUseImageSpacing()
+      ? static_cast<RealType>( this->GetInput2()->GetSpacing()[d] )
+      : NumericTraits<RealType>::One;
+    }
+  const RegionType region = this->GetInput1()->GetRequestedRegion();
+  m_KdTree = KdTreeType::NewBoundaryTree( this->GetInput1(), this->GetInput2(),
+    region, m_KdTreeScales, m_KdTreeVolumeFraction
+    * static_cast<double>( region.GetNumberOfPixels() ) );
+  if( m_KdTree )
+    {
+    return;
+    }
+
   filter->SetInput( this->GetInput2() );
   filter->Update();
 
@@ -170,6 +190,10 @@ ContourDirectedMeanDistanceImageFilter<TInputImage1, TInputImage2>
     {
     m_ContourDirectedMeanDistance = NumericTraits<RealType>::Zero;
     }
+
+  // clean up
+  m_DistanceMap = NULL;
+  m_KdTree = NULL;
 }
 
 template<class TInputImage1, class TInputImage2>
@@ -206,7 +230,11 @@ ContourDirectedMeanDistanceImageFilter<TInputImage1, TInputImage2>
   // the edge of the buffer.
   for (fit=faceList.begin(); fit != faceList.end(); ++fit)
     {
-    ImageRegionConstIterator<DistanceMapType> it2 (m_DistanceMap, *fit);
+    ImageRegionConstIterator<DistanceMapType> it2;
+    if( m_DistanceMap )
+      {
+      it2 = ImageRegionConstIterator<DistanceMapType>(m_DistanceMap, *fit);
+      }
     bit = ConstNeighborhoodIterator<InputImage1Type>(radius, input, *fit);
     unsigned int neighborhoodSize = bit.Size();
 
@@ -239,13 +267,29 @@ ContourDirectedMeanDistanceImageFilter<TInputImage1, TInputImage2>
         // set pixel center pixel value whether it is or not on contour
         if( bIsOnContour )
           {
-          const RealType value = it2.Get();
+          RealType value;
+          if( m_KdTree )
+            {
+            typename KdTreeType::PointType point;
+            for (i = 0; i < ImageDimension; ++i)
+              {
+              point[i] = static_cast<RealType>( bit.GetIndex()[i] ) * m_KdTreeScales[i];
+              }
+            value = vcl_sqrt( m_KdTree->GetNearestSquaredDistance( point ) );
+            }
+          else
+            {
+            value = it2.Get();
+            }
           m_MeanDistance[threadId] += vnl_math_abs( value );
           m_Count[threadId]++;
           }
         }
       ++bit;
-      ++it2;
+      if( m_DistanceMap )
+        {
+        ++it2;
+        }
       progress.CompletedPixel();
       }
     }
@@ -261,6 +305,8 @@ ContourDirectedMeanDistanceImageFilter<TInputImage1, TInputImage2>
 
   os << indent << "ContourDirectedMeanDistance: "
      << m_ContourDirectedMeanDistance << std::endl;
+  os << indent << "KdTreeVolumeFraction: "
+     << m_KdTreeVolumeFraction << std::endl;
 }
 
 
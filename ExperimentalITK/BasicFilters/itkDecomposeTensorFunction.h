@@ -39,6 +39,17 @@ namespace itk
  * This class also provides an interface to evaluating the determinant
  * from an NxN matrix using vnl routines.
  *
+ * The symmetric eigen-decomposition and the determinant of 2x2 and 3x3
+ * matrices are computed in closed form.  The eigenvalues of a symmetric
+ * 3x3 matrix come from the trigonometric solution of its characteristic
+ * polynomial and the eigenvectors from the cross products of the rows of
+ * A - lambda I, the nearly degenerate matrices being decomposed by Jacobi
+ * iterations.  EvaluateSymmetricTensorBatch() applies the same kernel to
+ * whole arrays of tensors stored component by component, in blocks
+ * traversed by simple loops over the tensors, with the tensors shared
+ * among the threads.  Each of its outputs (eigenvalues, eigenvectors,
+ * determinant, trace) is optional.
+ *
  * \author Nicholas J. Tustison
  *
  */
@@ -95,6 +106,43 @@ public:
 
   RealType EvaluateDeterminant( InputMatrixType& );
 
+  /**
+   * Batch of symmetric 2x2 or 3x3 tensors and of their decompositions,
+   * stored as structure of arrays: Components[k][n] is the component k of
+   * the upper triangle, row by row, of the tensor n, EigenValues[i][n] its
+   * eigenvalue i, in increasing order, and EigenVectors[i * Dimension + j][n]
+   * the component j of the corresponding eigenvector.  The outputs whose
+   * (first) pointer is NULL are not computed.
+   */
+  struct SymmetricTensorBatchType
+  {
+    unsigned int                                            Dimension;
+    SizeValueType                                           NumberOfTensors;
+    const RealType                                         *Components[6];
+    RealType                                               *EigenValues[3];
+    RealType                                               *EigenVectors[9];
+    RealType                                               *Determinant;
+    RealType                                               *Trace;
+  };
+
+  void EvaluateSymmetricTensorBatch( const SymmetricTensorBatchType & );
+
+  /** Eigenvalues, in increasing order, of a symmetric 2x2 or 3x3 tensor
+   * given by its upper triangle, row by row. */
+  static void ComputeSymmetricEigenValues( unsigned int dimension,
+    const double *tensor, double *eigenValues );
+
+  /** Unit eigenvectors of a symmetric 2x2 or 3x3 tensor, one after the
+   * other, from its eigenvalues.  Returns false, leaving the eigenvectors
+   * undefined, if a 3x3 tensor is nearly degenerate. */
+  static bool ComputeSymmetricEigenVectors( unsigned int dimension,
+    const double *tensor, const double *eigenValues, double *eigenVectors );
+
+  /** Eigenvalues and eigenvectors of a symmetric 2x2 or 3x3 tensor by
+   * cyclic Jacobi iterations. */
+  static void ComputeJacobiEigenSystem( unsigned int dimension,
+    const double *tensor, double *eigenValues, double *eigenVectors );
+
   DecomposeTensorFunction();
   virtual ~DecomposeTensorFunction() {}
 
@@ -102,6 +150,20 @@ protected:
 
   void PrintSelf ( std::ostream& os, Indent indent ) const;
 
+  /** Internal structure used for passing the batch to the threads. */
+  struct BatchThreadStruct
+  {
+    Self                                                   *Function;
+    const SymmetricTensorBatchType                         *Batch;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE BatchThreaderCallback( void *arg );
+
+  /** Decompose the tensors of a thread, block by block. */
+  void ThreadedEvaluateSymmetricTensorBatch( const SymmetricTensorBatchType *batch,
+    ThreadIdType threadId, ThreadIdType numberOfThreads );
+
 private:
 
   DecomposeTensorFunction(const Self&); //purposely not implemented
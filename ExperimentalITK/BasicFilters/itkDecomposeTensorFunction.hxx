@@ -28,6 +28,7 @@
 #include "vnl/vnl_matrix.h"
 #include "vnl/vnl_matrix_fixed.h"
 #include "vnl/vnl_det.h"
+#include "vnl/vnl_math.h"
 
 namespace itk {
 
@@ -89,6 +90,39 @@ DecomposeTensorFunction<TInput, TRealType, TOutput>
   V.SetSize( RowDimensions, RowDimensions );
 
   D.Fill( 0.0 );
+
+  if( RowDimensions == ColumnDimensions &&
+    ( RowDimensions == 2 || RowDimensions == 3 ) )
+    {
+    double tensor[6];
+    unsigned int k = 0;
+    for( unsigned int i = 0; i < RowDimensions; i++ )
+      {
+      for( unsigned int j = i; j < ColumnDimensions; j++ )
+        {
+        tensor[k++] = M[i][j];
+        }
+      }
+    double eigenValues[3];
+    double eigenVectors[9];
+    Self::ComputeSymmetricEigenValues( RowDimensions, tensor, eigenValues );
+    if( !Self::ComputeSymmetricEigenVectors( RowDimensions, tensor,
+      eigenValues, eigenVectors ) )
+      {
+      Self::ComputeJacobiEigenSystem( RowDimensions, tensor, eigenValues,
+        eigenVectors );
+      }
+    for( unsigned int j = 0; j < ColumnDimensions; j++ )
+      {
+      for( unsigned int i = 0; i < RowDimensions; i++ )
+        {
+        V[i][j] = static_cast<RealType>( eigenVectors[j * RowDimensions + i] );
+        }
+      D[j][j] = static_cast<RealType>( eigenValues[j] );
+      }
+    return;
+    }
+
   vnl_symmetric_eigensystem<RealType> eig( M.GetVnlMatrix() );
 
   for( unsigned int j = 0; j < ColumnDimensions; j++ )
@@ -323,6 +357,441 @@ DecomposeTensorFunction<TInput, TRealType, TOutput>
   return det;
 }
 
+template <typename TInput, typename TRealType, typename TOutput>
+void
+DecomposeTensorFunction<TInput, TRealType, TOutput>
+::ComputeSymmetricEigenValues( unsigned int dimension, const double *tensor,
+  double *eigenValues )
+{
+  if( dimension == 2 )
+    {
+    const double mean = 0.5 * ( tensor[0] + tensor[2] );
+    const double radius = vcl_sqrt( 0.25 * vnl_math_sqr( tensor[0] - tensor[2] )
+      + vnl_math_sqr( tensor[1] ) );
+    eigenValues[0] = mean - radius;
+    eigenValues[1] = mean + radius;
+    return;
+    }
+
+  // A = q I + p B with q = tr( A ) / 3 and p^2 = tr( ( A - q I )^2 ) / 6,
+  // det( B ) / 2 = cos( 3 phi ) and the eigenvalues are q + 2 p cos( phi ),
+  // q + 2 p cos( phi + 2 pi / 3 ) and q + 2 p cos( phi + 4 pi / 3 ).  The
+  // evaluation is free of branches but for the clamping of cos( 3 phi ).
+  const double q = ( tensor[0] + tensor[3] + tensor[5] ) / 3.0;
+  const double b00 = tensor[0] - q;
+  const double b11 = tensor[3] - q;
+  const double b22 = tensor[5] - q;
+  const double offDiagonal = vnl_math_sqr( tensor[1] )
+    + vnl_math_sqr( tensor[2] ) + vnl_math_sqr( tensor[4] );
+  const double p2 = ( vnl_math_sqr( b00 ) + vnl_math_sqr( b11 )
+    + vnl_math_sqr( b22 ) + 2.0 * offDiagonal ) / 6.0;
+  const double p = vcl_sqrt( p2 );
+  const double inverseP3 = ( p2 > 0.0 ) ? 1.0 / ( p2 * p ) : 0.0;
+
+  const double determinant = b00 * ( b11 * b22 - vnl_math_sqr( tensor[4] ) )
+    - tensor[1] * ( tensor[1] * b22 - tensor[4] * tensor[2] )
+    + tensor[2] * ( tensor[1] * tensor[4] - b11 * tensor[2] );
+  const double r = vnl_math_max( -1.0,
+    vnl_math_min( 1.0, 0.5 * determinant * inverseP3 ) );
+  const double phi = vcl_acos( r ) / 3.0;
+
+  eigenValues[2] = q + 2.0 * p * vcl_cos( phi );
+  eigenValues[0] = q + 2.0 * p * vcl_cos( phi + 2.0 * vnl_math::pi / 3.0 );
+  eigenValues[1] = 3.0 * q - eigenValues[0] - eigenValues[2];
+}
+
+template <typename TInput, typename TRealType, typename TOutput>
+bool
+DecomposeTensorFunction<TInput, TRealType, TOutput>
+::ComputeSymmetricEigenVectors( unsigned int dimension, const double *tensor,
+  const double *eigenValues, double *eigenVectors )
+{
+  // Relative gap between eigenvalues below which the cross products lose
+  // too much accuracy and the tensor is left to the Jacobi iterations.
+  const double tolerance = 1e-4;
+
+  const double scale = vnl_math_max( vnl_math_abs( eigenValues[0] ),
+    vnl_math_abs( eigenValues[dimension - 1] ) );
+
+  // The angle of the 2x2 eigenvectors is defined, if arbitrary, even for
+  // equal eigenvalues.
+  if( dimension == 2 )
+    {
+    const double theta = 0.5 * vcl_atan2( 2.0 * tensor[1],
+      tensor[0] - tensor[2] );
+    const double c = vcl_cos( theta );
+    const double s = vcl_sin( theta );
+    eigenVectors[0] = -s;
+    eigenVectors[1] = c;
+    eigenVectors[2] = c;
+    eigenVectors[3] = s;
+    return true;
+    }
+
+  if( eigenValues[1] - eigenValues[0] <= tolerance * scale ||
+    eigenValues[2] - eigenValues[1] <= tolerance * scale )
+    {
+    return false;
+    }
+
+  // The eigenvectors of the extreme eigenvalues are the largest cross
+  // product of two rows of A - lambda I, the middle one completes the basis.
+  for( unsigned int n = 0; n < 2; n++ )
+    {
+    const double lambda = eigenValues[2 * n];
+    const double row[3][3] = {
+      { tensor[0] - lambda, tensor[1], tensor[2] },
+      { tensor[1], tensor[3] - lambda, tensor[4] },
+      { tensor[2], tensor[4], tensor[5] - lambda } };
+
+    double *v = eigenVectors + 6 * n;
+    double largestNormSquared = 0.0;
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      const double *a = row[i];
+      const double *b = row[( i + 1 ) % 3];
+      const double cross[3] = { a[1] * b[2] - a[2] * b[1],
+        a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+      const double normSquared = vnl_math_sqr( cross[0] )
+        + vnl_math_sqr( cross[1] ) + vnl_math_sqr( cross[2] );
+      if( normSquared > largestNormSquared )
+        {
+        largestNormSquared = normSquared;
+        v[0] = cross[0];
+        v[1] = cross[1];
+        v[2] = cross[2];
+        }
+      }
+    if( !( largestNormSquared > vnl_math_sqr( tolerance * scale * scale ) ) )
+      {
+      return false;
+      }
+    const double inverseNorm = 1.0 / vcl_sqrt( largestNormSquared );
+    v[0] *= inverseNorm;
+    v[1] *= inverseNorm;
+    v[2] *= inverseNorm;
+    }
+
+  double *v0 = eigenVectors;
+  double *v1 = eigenVectors + 3;
+  double *v2 = eigenVectors + 6;
+
+  const double dot = v0[0] * v2[0] + v0[1] * v2[1] + v0[2] * v2[2];
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    v2[i] -= dot * v0[i];
+    }
+  const double inverseNorm = 1.0 / vcl_sqrt( vnl_math_sqr( v2[0] )
+    + vnl_math_sqr( v2[1] ) + vnl_math_sqr( v2[2] ) );
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    v2[i] *= inverseNorm;
+    }
+  v1[0] = v2[1] * v0[2] - v2[2] * v0[1];
+  v1[1] = v2[2] * v0[0] - v2[0] * v0[2];
+  v1[2] = v2[0] * v0[1] - v2[1] * v0[0];
+
+  return true;
+}
+
+template <typename TInput, typename TRealType, typename TOutput>
+void
+DecomposeTensorFunction<TInput, TRealType, TOutput>
+::ComputeJacobiEigenSystem( unsigned int dimension, const double *tensor,
+  double *eigenValues, double *eigenVectors )
+{
+  double a[3][3];
+  double v[3][3];
+  unsigned int k = 0;
+  for( unsigned int i = 0; i < dimension; i++ )
+    {
+    for( unsigned int j = i; j < dimension; j++ )
+      {
+      a[i][j] = a[j][i] = tensor[k++];
+      }
+    for( unsigned int j = 0; j < dimension; j++ )
+      {
+      v[i][j] = ( i == j ) ? 1.0 : 0.0;
+      }
+    }
+
+  for( unsigned int sweep = 0; sweep < 50; sweep++ )
+    {
+    double offDiagonal = 0.0;
+    double diagonal = 0.0;
+    for( unsigned int i = 0; i < dimension; i++ )
+      {
+      diagonal += vnl_math_sqr( a[i][i] );
+      for( unsigned int j = i + 1; j < dimension; j++ )
+        {
+        offDiagonal += vnl_math_sqr( a[i][j] );
+        }
+      }
+    if( offDiagonal <= 1e-30 * diagonal || offDiagonal == 0.0 )
+      {
+      break;
+      }
+
+    for( unsigned int p = 0; p + 1 < dimension; p++ )
+      {
+      for( unsigned int q = p + 1; q < dimension; q++ )
+        {
+        if( a[p][q] == 0.0 )
+          {
+          continue;
+          }
+        const double theta = 0.5 * ( a[q][q] - a[p][p] ) / a[p][q];
+        double t = 1.0 / ( vnl_math_abs( theta )
+          + vcl_sqrt( vnl_math_sqr( theta ) + 1.0 ) );
+        if( theta < 0.0 )
+          {
+          t = -t;
+          }
+        const double c = 1.0 / vcl_sqrt( vnl_math_sqr( t ) + 1.0 );
+        const double s = t * c;
+        for( unsigned int i = 0; i < dimension; i++ )
+          {
+          const double aip = a[i][p];
+          const double aiq = a[i][q];
+          a[i][p] = c * aip - s * aiq;
+          a[i][q] = s * aip + c * aiq;
+          }
+        for( unsigned int i = 0; i < dimension; i++ )
+          {
+          const double api = a[p][i];
+          const double aqi = a[q][i];
+          a[p][i] = c * api - s * aqi;
+          a[q][i] = s * api + c * aqi;
+          }
+        for( unsigned int i = 0; i < dimension; i++ )
+          {
+          const double vip = v[i][p];
+          const double viq = v[i][q];
+          v[i][p] = c * vip - s * viq;
+          v[i][q] = s * vip + c * viq;
+          }
+        }
+      }
+    }
+
+  // Sort in increasing order, the eigenvectors being the columns of v.
+  unsigned int order[3] = { 0, 1, 2 };
+  for( unsigned int i = 1; i < dimension; i++ )
+    {
+    for( unsigned int j = i; j > 0 && a[order[j]][order[j]] <
+      a[order[j - 1]][order[j - 1]]; j-- )
+      {
+      const unsigned int tmp = order[j];
+      order[j] = order[j - 1];
+      order[j - 1] = tmp;
+      }
+    }
+  for( unsigned int i = 0; i < dimension; i++ )
+    {
+    eigenValues[i] = a[order[i]][order[i]];
+    for( unsigned int j = 0; j < dimension; j++ )
+      {
+      eigenVectors[i * dimension + j] = v[j][order[i]];
+      }
+    }
+}
+
+template <typename TInput, typename TRealType, typename TOutput>
+void
+DecomposeTensorFunction<TInput, TRealType, TOutput>
+::EvaluateSymmetricTensorBatch( const SymmetricTensorBatchType & batch )
+{
+  if( batch.Dimension != 2 && batch.Dimension != 3 )
+    {
+    itkExceptionMacro( << "Only 2x2 and 3x3 tensors are supported." );
+    }
+  if( batch.NumberOfTensors == 0 )
+    {
+    return;
+    }
+
+  BatchThreadStruct str;
+  str.Function = this;
+  str.Batch = &batch;
+
+  // Small batches are not worth the threads.
+  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  if( batch.NumberOfTensors < 1024 )
+    {
+    numberOfThreads = 1;
+    }
+
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->BatchThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template <typename TInput, typename TRealType, typename TOutput>
+ITK_THREAD_RETURN_TYPE
+DecomposeTensorFunction<TInput, TRealType, TOutput>
+::BatchThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  BatchThreadStruct *str = static_cast<BatchThreadStruct *>( info->UserData );
+
+  str->Function->ThreadedEvaluateSymmetricTensorBatch( str->Batch,
+    info->ThreadID, info->NumberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <typename TInput, typename TRealType, typename TOutput>
+void
+DecomposeTensorFunction<TInput, TRealType, TOutput>
+::ThreadedEvaluateSymmetricTensorBatch( const SymmetricTensorBatchType *batch,
+  ThreadIdType threadId, ThreadIdType numberOfThreads )
+{
+  const unsigned int D = batch->Dimension;
+  const unsigned int numberOfComponents = D * ( D + 1 ) / 2;
+
+  const SizeValueType first = batch->NumberOfTensors * threadId
+    / numberOfThreads;
+  const SizeValueType last = batch->NumberOfTensors * ( threadId + 1 )
+    / numberOfThreads;
+
+  const bool computeEigenValues = ( batch->EigenValues[0] != NULL ||
+    batch->EigenVectors[0] != NULL );
+  const bool computeEigenVectors = ( batch->EigenVectors[0] != NULL );
+
+  // The components of a block are copied in double precision, one array per
+  // component, and each stage is a loop over the tensors of the block.
+  const SizeValueType blockSize = 256;
+  double components[6][blockSize];
+  double eigenValues[3][blockSize];
+
+  for( SizeValueType start = first; start < last; start += blockSize )
+    {
+    const SizeValueType m = vnl_math_min( blockSize, last - start );
+
+    for( unsigned int k = 0; k < numberOfComponents; k++ )
+      {
+      const RealType *component = batch->Components[k] + start;
+      double *block = components[k];
+      for( SizeValueType n = 0; n < m; n++ )
+        {
+        block[n] = static_cast<double>( component[n] );
+        }
+      }
+
+    if( batch->Determinant )
+      {
+      RealType *determinant = batch->Determinant + start;
+      if( D == 2 )
+        {
+        for( SizeValueType n = 0; n < m; n++ )
+          {
+          determinant[n] = static_cast<RealType>( components[0][n]
+            * components[2][n] - vnl_math_sqr( components[1][n] ) );
+          }
+        }
+      else
+        {
+        for( SizeValueType n = 0; n < m; n++ )
+          {
+          determinant[n] = static_cast<RealType>(
+            components[0][n] * ( components[3][n] * components[5][n]
+              - vnl_math_sqr( components[4][n] ) )
+            - components[1][n] * ( components[1][n] * components[5][n]
+              - components[4][n] * components[2][n] )
+            + components[2][n] * ( components[1][n] * components[4][n]
+              - components[3][n] * components[2][n] ) );
+          }
+        }
+      }
+
+    if( batch->Trace )
+      {
+      RealType *trace = batch->Trace + start;
+      if( D == 2 )
+        {
+        for( SizeValueType n = 0; n < m; n++ )
+          {
+          trace[n] = static_cast<RealType>( components[0][n]
+            + components[2][n] );
+          }
+        }
+      else
+        {
+        for( SizeValueType n = 0; n < m; n++ )
+          {
+          trace[n] = static_cast<RealType>( components[0][n]
+            + components[3][n] + components[5][n] );
+          }
+        }
+      }
+
+    if( !computeEigenValues )
+      {
+      continue;
+      }
+
+    for( SizeValueType n = 0; n < m; n++ )
+      {
+      double tensor[6];
+      double lambda[3];
+      for( unsigned int k = 0; k < numberOfComponents; k++ )
+        {
+        tensor[k] = components[k][n];
+        }
+      Self::ComputeSymmetricEigenValues( D, tensor, lambda );
+      for( unsigned int i = 0; i < D; i++ )
+        {
+        eigenValues[i][n] = lambda[i];
+        }
+      }
+
+    if( computeEigenVectors )
+      {
+      for( SizeValueType n = 0; n < m; n++ )
+        {
+        double tensor[6];
+        double lambda[3];
+        double vectors[9];
+        for( unsigned int k = 0; k < numberOfComponents; k++ )
+          {
+          tensor[k] = components[k][n];
+          }
+        for( unsigned int i = 0; i < D; i++ )
+          {
+          lambda[i] = eigenValues[i][n];
+          }
+        if( !Self::ComputeSymmetricEigenVectors( D, tensor, lambda, vectors ) )
+          {
+          Self::ComputeJacobiEigenSystem( D, tensor, lambda, vectors );
+          for( unsigned int i = 0; i < D; i++ )
+            {
+            eigenValues[i][n] = lambda[i];
+            }
+          }
+        for( unsigned int i = 0; i < D * D; i++ )
+          {
+          batch->EigenVectors[i][start + n] =
+            static_cast<RealType>( vectors[i] );
+          }
+        }
+      }
+
+    if( batch->EigenValues[0] )
+      {
+      for( unsigned int i = 0; i < D; i++ )
+        {
+        RealType *eigenValue = batch->EigenValues[i] + start;
+        for( SizeValueType n = 0; n < m; n++ )
+          {
+          eigenValue[n] = static_cast<RealType>( eigenValues[i][n] );
+          }
+        }
+      }
+    }
+}
+
 template <typename TInput, typename TRealType, typename TOutput>
 void
 DecomposeTensorFunction<TInput, TRealType, TOutput>
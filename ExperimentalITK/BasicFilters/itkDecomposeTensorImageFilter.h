@@ -18,6 +18,7 @@
 #define __itkDecomposeTensorImageFilter_h
 
 #include "itkConstNeighborhoodIterator.h"
+#include "itkDecomposeTensorFunction.h"
 #include "itkImageToImageFilter.h"
 #include "itkVariableSizeMatrix.h"
 #include "itkVector.h"
@@ -25,6 +26,12 @@
 namespace itk
 {
 /** \class DecomposeTensorImageFilter
+ *
+ * The eigen-decomposition of symmetric 2x2 and 3x3 tensors (only their
+ * upper triangle is read) is computed in closed form and multithreaded, the
+ * image being decomposed in large batches by
+ * DecomposeTensorFunction::EvaluateSymmetricTensorBatch().  With
+ * EigenValuesOnly, the eigenvectors are neither computed nor output.
  *
  */
 template <typename TInputImage,
@@ -80,6 +87,10 @@ public:
   itkSetMacro( SymmetricTensors, bool );
   itkGetConstReferenceMacro( SymmetricTensors, bool ); 
 
+  itkBooleanMacro( EigenValuesOnly );
+  itkSetMacro( EigenValuesOnly, bool );
+  itkGetConstReferenceMacro( EigenValuesOnly, bool );
+
   itkSetClampMacro( WhichDecomposition, unsigned int, 0, 4 );
   itkGetConstReferenceMacro( WhichDecomposition, unsigned int );
 
@@ -122,12 +133,14 @@ protected:
 
 private:
   bool m_SymmetricTensors;
+  bool m_EigenValuesOnly;
   unsigned int m_WhichDecomposition;
 
   DecomposeTensorImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
   void EigenDecomposition( InputMatrixType &, OutputMatrixType &, OutputMatrixType & );
+  void SymmetricEigenDecomposition();
   void RightPolarDecomposition( InputMatrixType &, OutputMatrixType &, OutputMatrixType & );
   void LeftPolarDecomposition( InputMatrixType &, OutputMatrixType &, OutputMatrixType & );
   void QRDecomposition( InputMatrixType &, OutputMatrixType &, OutputMatrixType & );
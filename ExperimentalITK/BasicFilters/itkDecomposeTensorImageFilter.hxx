@@ -19,6 +19,7 @@
 
 #include "itkDecomposeTensorImageFilter.h"
 
+#include "itkImageRegionConstIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
 
@@ -40,6 +41,7 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
 ::DecomposeTensorImageFilter()
 {
   this->m_SymmetricTensors = false;
+  this->m_EigenValuesOnly = false;
   this->SetNumberOfRequiredInputs( 1 );
 
   this->m_WhichDecomposition = 0;
@@ -55,7 +57,10 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
    */
   switch ( this->m_WhichDecomposition )
     {
-    case 0: case 1: case 2: case 3:
+    case 0:
+      this->SetNumberOfRequiredOutputs( this->m_EigenValuesOnly ? 1 : 2 );
+      break;
+    case 1: case 2: case 3:
       this->SetNumberOfRequiredOutputs( 2 );
       break;      
     case 4:
@@ -71,6 +76,14 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
     this->GetOutput( i )->Allocate();
     } 
 
+  if ( this->m_WhichDecomposition == 0 && this->m_SymmetricTensors &&
+    RowDimensions == ColumnDimensions && 
+    ( RowDimensions == 2 || RowDimensions == 3 ) )
+    {
+    this->SymmetricEigenDecomposition();
+    return;
+    }
+
   ImageRegionConstIteratorWithIndex<InputImageType> It
     ( this->GetInput(), this->GetInput()->GetRequestedRegion() );
 
@@ -90,7 +103,10 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
       case 0:  // EigenDecomposition
         this->EigenDecomposition( M, D, V );
         this->GetOutput( 0 )->SetPixel( It.GetIndex(), D );  // Eigenvalues
-        this->GetOutput( 1 )->SetPixel( It.GetIndex(), V );  // Eigenvectors (columnwise)
+        if ( !this->m_EigenValuesOnly )
+          {
+          this->GetOutput( 1 )->SetPixel( It.GetIndex(), V );  // Eigenvectors (columnwise)
+          }
         break;      
       case 1:  // Right Polar Decomposition
         this->RightPolarDecomposition( M, R, S );
@@ -167,6 +183,127 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
     }
 }
 
+template <typename TInputImage, typename TRealType, typename TOutputImage>
+void
+DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
+::SymmetricEigenDecomposition()
+{
+  typedef DecomposeTensorFunction<InputMatrixType, RealType> DecomposerType;
+  typedef typename DecomposerType::SymmetricTensorBatchType BatchType;
+
+  typename DecomposerType::Pointer decomposer = DecomposerType::New();
+  decomposer->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  /**
+   * The tensors are gathered, component by component, in chunks of the
+   * image which are decomposed at once.
+   */
+  const unsigned int numberOfComponents = 
+    RowDimensions * ( RowDimensions + 1 ) / 2;
+  const SizeValueType chunkSize = vnl_math_min( static_cast<SizeValueType>(
+    this->GetInput()->GetRequestedRegion().GetNumberOfPixels() ),
+    static_cast<SizeValueType>( 262144 ) );
+
+  std::vector<RealType> components[6];
+  std::vector<RealType> eigenValues[3];
+  std::vector<RealType> eigenVectors[9];
+
+  BatchType batch;
+  batch.Dimension = RowDimensions;
+  batch.Determinant = NULL;
+  batch.Trace = NULL;
+  for ( unsigned int k = 0; k < 6; k++ )
+    {
+    batch.Components[k] = NULL;
+    if ( k < numberOfComponents )
+      {
+      components[k].resize( chunkSize );
+      batch.Components[k] = &components[k][0];
+      }
+    }
+  for ( unsigned int i = 0; i < 3; i++ )
+    {
+    batch.EigenValues[i] = NULL;
+    if ( i < RowDimensions )
+      {
+      eigenValues[i].resize( chunkSize );
+      batch.EigenValues[i] = &eigenValues[i][0];
+      }
+    }
+  for ( unsigned int i = 0; i < 9; i++ )
+    {
+    batch.EigenVectors[i] = NULL;
+    if ( i < RowDimensions * RowDimensions && !this->m_EigenValuesOnly )
+      {
+      eigenVectors[i].resize( chunkSize );
+      batch.EigenVectors[i] = &eigenVectors[i][0];
+      }
+    }
+
+  ImageRegionConstIterator<InputImageType> It
+    ( this->GetInput(), this->GetInput()->GetRequestedRegion() );
+  ImageRegionIterator<OutputImageType> ItD( this->GetOutput( 0 ), 
+    this->GetOutput( 0 )->GetLargestPossibleRegion() );
+  ImageRegionIterator<OutputImageType> ItV;
+  if ( !this->m_EigenValuesOnly )
+    {
+    ItV = ImageRegionIterator<OutputImageType>( this->GetOutput( 1 ), 
+      this->GetOutput( 1 )->GetLargestPossibleRegion() );
+    ItV.GoToBegin();
+    }
+
+  OutputMatrixType D;
+  OutputMatrixType V;
+  D.SetSize( RowDimensions, RowDimensions );
+  V.SetSize( RowDimensions, RowDimensions );
+  D.Fill( 0.0 );
+
+  It.GoToBegin();
+  ItD.GoToBegin();
+  while ( !It.IsAtEnd() )
+    {
+    SizeValueType n = 0;
+    for ( ; n < chunkSize && !It.IsAtEnd(); ++It, n++ )
+      {
+      const InputMatrixType & M = It.Get();
+      unsigned int k = 0;
+      for ( unsigned int i = 0; i < RowDimensions; i++ )
+        {
+        for ( unsigned int j = i; j < ColumnDimensions; j++ )
+          {
+          components[k++][n] = M[i][j];
+          }
+        }
+      }
+
+    batch.NumberOfTensors = n;
+    decomposer->EvaluateSymmetricTensorBatch( batch );
+
+    for ( SizeValueType m = 0; m < n; m++ )
+      {
+      for ( unsigned int i = 0; i < RowDimensions; i++ )
+        {
+        D[i][i] = eigenValues[i][m];
+        }
+      ItD.Set( D );  // Eigenvalues
+      ++ItD;
+
+      if ( !this->m_EigenValuesOnly )
+        {
+        for ( unsigned int j = 0; j < ColumnDimensions; j++ )
+          {
+          for ( unsigned int i = 0; i < RowDimensions; i++ )
+            {
+            V[i][j] = eigenVectors[j * RowDimensions + i][m];
+            }
+          }
+        ItV.Set( V );  // Eigenvectors (columnwise)
+        ++ItV;
+        }
+      }
+    }
+}
+
 template <typename TInputImage, typename TRealType, typename TOutputImage>
 void
 DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
@@ -310,7 +447,8 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
    * holds for symmetric matrices.
    */
 
-  if ( this->m_WhichDecomposition != 0 || i >= ColumnDimensions )
+  if ( this->m_WhichDecomposition != 0 || i >= ColumnDimensions ||
+    this->m_EigenValuesOnly )
     {
     return NULL;
     }
@@ -321,7 +459,7 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
   this->m_EigenVectorImage->SetRegions( this->GetInput()->GetRequestedRegion() );  
   this->m_EigenVectorImage->Allocate();
 
-  ImageRegionIterator<RealImageType> ItE( this->m_EigenVectorImage, 
+  ImageRegionIterator<VectorImageType> ItE( this->m_EigenVectorImage, 
     this->m_EigenVectorImage->GetLargestPossibleRegion() );
   ImageRegionIterator<OutputImageType> ItV( this->GetOutput( 1 ), 
     this->GetOutput( 1 )->GetLargestPossibleRegion() );
@@ -351,6 +489,7 @@ DecomposeTensorImageFilter<TInputImage, TRealType, TOutputImage>
   Superclass::PrintSelf(os,indent);
 
   os << indent << "m_SymmetricTensors = " << this->m_SymmetricTensors << std::endl;
+  os << indent << "m_EigenValuesOnly = " << this->m_EigenValuesOnly << std::endl;
   os << indent << "m_WhichDecomposition = " << this->m_WhichDecomposition << std::endl;
 }
   
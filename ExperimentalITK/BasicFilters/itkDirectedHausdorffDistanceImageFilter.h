@@ -21,6 +21,7 @@
 #include "itkNumericTraits.h"
 #include "itkArray.h"
 #include "itkImage.h"
+#include "itkPointKdTree.h"
 
 namespace itk {
 
@@ -42,6 +43,13 @@ namespace itk {
  * find the largest distance (in pixels) within the set of all non-zero pixels in the first
  * image.
  *
+ * When the non-zero pixels of both images cover at most KdTreeVolumeFraction
+ * of the image, as for small lesions in a whole brain, the distance map is
+ * replaced by a kd-tree over the boundary pixels (non-zero pixels with a
+ * zero neighbor of any kind) of the second image, which the threads query
+ * for the non-zero pixels of the first image.  The distances are the same
+ * as those of the distance map, negative inside the second object.
+ *
  * Use HausdorffDistanceImageFilter to compute the full Hausdorff distance.
  *
  * This filter requires the largest possible region of the first image
@@ -115,6 +123,12 @@ public:
   itkGetConstMacro(DirectedHausdorffDistance,RealType);
   itkGetConstMacro(AverageHausdorffDistance,RealType);
 
+  /** Set/Get the largest fraction of the image covered by the non-zero
+   * pixels of both inputs for which the kd-tree is used instead of the
+   * distance map.  0 always uses the distance map.  Default is 0.05. */
+  itkSetClampMacro(KdTreeVolumeFraction, double, 0.0, 1.0);
+  itkGetConstMacro(KdTreeVolumeFraction, double);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(InputHasNumericTraitsCheck,
@@ -154,7 +168,11 @@ private:
 
   typedef Image<RealType,itkGetStaticConstMacro(ImageDimension)> DistanceMapType;
 
+  typedef PointKdTree<RealType,itkGetStaticConstMacro(ImageDimension)> KdTreeType;
+
   typename DistanceMapType::Pointer   m_DistanceMap;
+  typename KdTreeType::Pointer        m_KdTree;
+  double                              m_KdTreeVolumeFraction;
   Array<RealType>                     m_MaxDistance;
   Array<unsigned int>                 m_PixelCount;
   Array<RealType>                     m_Sum;
@@ -20,6 +20,7 @@
 
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNumericTraits.h"
 #include "itkSignedMaurerDistanceMapImageFilter.h"
 #include "itkProgressReporter.h"
@@ -36,6 +37,8 @@ DirectedHausdorffDistanceImageFilter<TInputImage1, TInputImage2>
   this->SetNumberOfRequiredInputs( 2 );
 
   m_DistanceMap = NULL;
+  m_KdTree = NULL;
+  m_KdTreeVolumeFraction = 0.05;
   m_DirectedHausdorffDistance = NumericTraits<RealType>::Zero;
   m_AverageHausdorffDistance = NumericTraits<RealType>::Zero;
 }
@@ -127,6 +130,19 @@ DirectedHausdorffDistanceImageFilter<TInputImage1, TInputImage2>
   m_PixelCount.Fill(0);
   m_Sum.Fill(NumericTraits<RealType>::Zero);
 
+  // Small objects only need the distances to the boundary of the second
+  // object
+  typename KdTreeType::PointType scales;
+  scales.Fill( NumericTraits<RealType>::One );
+  const RegionType region = this->GetInput1()->GetRequestedRegion();
+  m_KdTree = KdTreeType::NewBoundaryTree( this->GetInput1(), this->GetInput2(),
+    region, scales, m_KdTreeVolumeFraction
+    * static_cast<double>( region.GetNumberOfPixels() ) );
+  if( m_KdTree )
+    {
+    return;
+    }
+
   // Compute distance map from non-zero pixels in the second image
   typedef itk::SignedMaurerDistanceMapImageFilter
     <InputImage2Type, DistanceMapType> FilterType;
@@ -170,6 +186,7 @@ DirectedHausdorffDistanceImageFilter<TInputImage1, TInputImage2>
 
   // clean up
   m_DistanceMap = NULL;
+  m_KdTree = NULL;
 
 }
 
@@ -180,12 +197,47 @@ DirectedHausdorffDistanceImageFilter<TInputImage1, TInputImage2>
                        int threadId)
 {
 
-  ImageRegionConstIterator<TInputImage1> it1 (this->GetInput1(), regionForThread);
-  ImageRegionConstIterator<DistanceMapType> it2 (m_DistanceMap, regionForThread);
-
   // support progress methods/callbacks
   ProgressReporter progress(this, threadId, regionForThread.GetNumberOfPixels());
 
+  if( m_KdTree )
+    {
+    ImageRegionConstIteratorWithIndex<TInputImage1> it1 (this->GetInput1(), regionForThread);
+    ImageRegionConstIterator<TInputImage2> it2 (this->GetInput2(), regionForThread);
+
+    typename KdTreeType::PointType point;
+    while (!it1.IsAtEnd())
+      {
+      if( it1.Get() != NumericTraits<InputImage1PixelType>::Zero )
+        {
+        for( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          point[d] = static_cast<RealType>( it1.GetIndex()[d] );
+          }
+        RealType distance = vcl_sqrt( m_KdTree->GetNearestSquaredDistance( point ) );
+        if( it2.Get() != NumericTraits<InputImage2PixelType>::Zero )
+          {
+          distance = -distance;
+          }
+        if ( distance > m_MaxDistance[threadId] )
+          {
+          m_MaxDistance[threadId] = distance;
+          }
+        m_PixelCount[threadId]++;
+        m_Sum[threadId] += distance;
+        }
+
+      ++it1;
+      ++it2;
+
+      progress.CompletedPixel();
+      }
+    return;
+    }
+
+  ImageRegionConstIterator<TInputImage1> it1 (this->GetInput1(), regionForThread);
+  ImageRegionConstIterator<DistanceMapType> it2 (m_DistanceMap, regionForThread);
+
   // do the work
   while (!it1.IsAtEnd())
     {
@@ -220,6 +272,8 @@ DirectedHausdorffDistanceImageFilter<TInputImage1, TInputImage2>
      << m_DirectedHausdorffDistance << std::endl;
   os << indent << "AverageHausdorffDistance: "
      << m_AverageHausdorffDistance << std::endl;
+  os << indent << "KdTreeVolumeFraction: "
+     << m_KdTreeVolumeFraction << std::endl;
 }
 
 
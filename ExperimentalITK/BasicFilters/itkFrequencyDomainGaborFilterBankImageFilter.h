@@ -0,0 +1,197 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkFrequencyDomainGaborFilterBankImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkFrequencyDomainGaborFilterBankImageFilter_h
+#define __itkFrequencyDomainGaborFilterBankImageFilter_h
+
+#include "itkImageToImageFilter.h"
+
+#include "itkFixedArray.h"
+#include "itkMatrix.h"
+
+#include <complex>
+#include <vector>
+
+#ifdef ITK_USE_FFTWF
+#include "fftw3.h"
+#endif
+
+namespace itk
+{
+
+/** \class FrequencyDomainGaborFilterBankImageFilter
+ * \brief Maximum response of the input image over a bank of Gabor filters.
+ *
+ * The forward transform of the input is computed once and shared by all
+ * the kernels of the bank.  The transform of each kernel is evaluated
+ * analytically on the frequency grid as a pair of Gaussians centered at
+ * plus and minus the kernel frequency, so no kernel image is generated or
+ * resampled.  The kernels are distributed over the threads, each thread
+ * running its own inverse transforms and keeping its own maximum, and the
+ * per-thread maxima are combined at the end.  When ITK is built with single
+ * precision FFTW (ITK_USE_FFTWF) the inverse plan is created once per tile
+ * before the threads are started, since FFTW planning is not thread-safe,
+ * and the threads only execute it on their own buffers.
+ *
+ * Each kernel is described in its own frame by a frequency (cycles per
+ * physical unit) and the standard deviations of its spatial envelope
+ * (physical units).  The rotation maps the frequency coordinates of the
+ * image into the frame of the kernel.
+ *
+ * Volumes which do not fit in memory together with their spectra can be
+ * processed by setting a tile size.  The requested output region is then
+ * filtered tile by tile (overlap-save), each tile being padded with
+ * TileOverlapFactor times the largest kernel sigma on every side and only
+ * the unpadded part of the response being kept.  A zero tile size component
+ * means no tiling along that axis.  Only the requested output region,
+ * padded the same way, is requested from the input, so the filter can be
+ * streamed.  Beyond the image the tiles are padded with the nearest pixel
+ * of the image (zero flux Neumann condition, as ConvolutionImageFilter),
+ * so the circular convolution does not wrap the response around.  The
+ * padded tiles are further extended to lengths which are products of 2, 3
+ * and 5, which the vnl transforms require.
+ */
+
+template <class TInputImage, class TOutputImage>
+class FrequencyDomainGaborFilterBankImageFilter
+: public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  typedef FrequencyDomainGaborFilterBankImageFilter           Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>       Superclass;
+  typedef SmartPointer<Self>                                  Pointer;
+  typedef SmartPointer<const Self>                            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FrequencyDomainGaborFilterBankImageFilter, ImageToImageFilter );
+
+  /** Extract dimension from input image. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+                       TInputImage::ImageDimension );
+
+  /** Image typedef support. */
+  typedef TInputImage                                         InputImageType;
+  typedef TOutputImage                                        OutputImageType;
+  typedef typename OutputImageType::RegionType                RegionType;
+  typedef typename RegionType::SizeType                       SizeType;
+  typedef typename RegionType::IndexType                      IndexType;
+  typedef typename InputImageType::SpacingType                SpacingType;
+
+  /** Other typedef */
+  typedef float                                               RealType;
+  typedef Image<RealType,
+    itkGetStaticConstMacro( ImageDimension )>                 RealImageType;
+  typedef typename RealImageType::Pointer                     RealImagePointer;
+  typedef Image<std::complex<RealType>,
+    itkGetStaticConstMacro( ImageDimension )>                 ComplexImageType;
+  typedef FixedArray<RealType,
+    itkGetStaticConstMacro( ImageDimension )>                 ArrayType;
+  typedef Matrix<RealType, itkGetStaticConstMacro( ImageDimension ),
+    itkGetStaticConstMacro( ImageDimension )>                 MatrixType;
+
+  /** Parameters of a single kernel of the bank. */
+  struct GaborKernelParametersType
+  {
+    ArrayType                                                 Frequency;
+    ArrayType                                                 Sigma;
+    MatrixType                                                Rotation;
+    RealType                                                  Amplitude;
+  };
+
+  /** Even (cosine), odd (sine) or quadrature magnitude response. */
+  enum ResponseType { EvenResponse, OddResponse, MagnitudeResponse };
+
+  /** Helper functions */
+
+  void AddGaborKernel( const GaborKernelParametersType & );
+  void ClearGaborKernels();
+  unsigned int GetNumberOfGaborKernels() const
+    { return this->m_GaborKernels.size(); }
+  const GaborKernelParametersType & GetGaborKernel( unsigned int i ) const
+    { return this->m_GaborKernels[i]; }
+
+  itkSetMacro( ResponseType, ResponseType );
+  itkGetConstMacro( ResponseType, ResponseType );
+
+  itkSetMacro( TileSize, SizeType );
+  itkGetConstMacro( TileSize, SizeType );
+
+  itkSetMacro( TileOverlapFactor, RealType );
+  itkGetConstMacro( TileOverlapFactor, RealType );
+
+protected:
+  FrequencyDomainGaborFilterBankImageFilter();
+  virtual ~FrequencyDomainGaborFilterBankImageFilter();
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  void GenerateInputRequestedRegion();
+
+  void GenerateData();
+
+  /** Padding, in pixels, which covers the support of the widest kernel. */
+  SizeType ComputeOverlap() const;
+
+  /** Smallest length not less than the given one which is a product of 2,
+   * 3 and 5. */
+  static SizeValueType GetTransformLength( SizeValueType length );
+
+  /** Internal structure used for passing the tile to the threads. */
+  struct FilterBankThreadStruct
+  {
+    Self                                                     *Filter;
+    const ComplexImageType                                   *Spectrum;
+    SizeType                                                  Size;
+    std::vector<RealType>                                     Frequencies[ImageDimension];
+    std::vector<RealImagePointer>                             MaximumResponseImages;
+    RealType                                                  InverseScale;
+#ifdef ITK_USE_FFTWF
+    fftwf_plan                                                InversePlan;
+#endif
+  };
+
+  /** Maximum response over the bank of a tile starting at index zero. */
+  RealImagePointer FilterTile( const RealImageType * );
+
+  /** Filter the tile spectrum with the kernels threadId,
+   *  threadId + numberOfThreads, ... */
+  void ThreadedFilterTile( ThreadIdType threadId,
+    ThreadIdType numberOfThreads, FilterBankThreadStruct *str );
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE FilterTileThreaderCallback( void *arg );
+
+private:
+  FrequencyDomainGaborFilterBankImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::vector<GaborKernelParametersType>                      m_GaborKernels;
+
+  ResponseType                                                m_ResponseType;
+
+  SizeType                                                    m_TileSize;
+  RealType                                                    m_TileOverlapFactor;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFrequencyDomainGaborFilterBankImageFilter.hxx"
+#endif
+
+#endif
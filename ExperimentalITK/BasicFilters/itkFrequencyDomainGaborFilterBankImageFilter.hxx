@@ -0,0 +1,613 @@
+#ifndef __itkFrequencyDomainGaborFilterBankImageFilter_hxx
+#define __itkFrequencyDomainGaborFilterBankImageFilter_hxx
+
+#include "itkFrequencyDomainGaborFilterBankImageFilter.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#ifdef ITK_USE_FFTWF
+#include "itkFFTWRealToComplexConjugateImageFilter.h"
+#else
+#include "itkVnlFFTComplexConjugateToRealImageFilter.h"
+#include "itkVnlFFTRealToComplexConjugateImageFilter.h"
+#endif
+
+#include "vnl/vnl_math.h"
+
+namespace itk
+{
+
+template <class TInputImage, class TOutputImage>
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::FrequencyDomainGaborFilterBankImageFilter()
+{
+  this->m_ResponseType = EvenResponse;
+  this->m_TileSize.Fill( 0 );
+  this->m_TileOverlapFactor = 3.0;
+}
+
+template <class TInputImage, class TOutputImage>
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::~FrequencyDomainGaborFilterBankImageFilter()
+{
+}
+
+template <class TInputImage, class TOutputImage>
+void
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::AddGaborKernel( const GaborKernelParametersType & kernel )
+{
+  this->m_GaborKernels.push_back( kernel );
+  this->Modified();
+}
+
+template <class TInputImage, class TOutputImage>
+void
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::ClearGaborKernels()
+{
+  if ( !this->m_GaborKernels.empty() )
+    {
+    this->m_GaborKernels.clear();
+    this->Modified();
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+void
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  if ( !input )
+    {
+    return;
+    }
+
+  /**
+   * Request the output region padded with the tile overlap, so that the
+   * border of the request is filtered with the same neighborhood as its
+   * inside.
+   */
+  typename InputImageType::RegionType inputRegion;
+  inputRegion.SetIndex( this->GetOutput()->GetRequestedRegion().GetIndex() );
+  inputRegion.SetSize( this->GetOutput()->GetRequestedRegion().GetSize() );
+  inputRegion.PadByRadius( this->ComputeOverlap() );
+  inputRegion.Crop( input->GetLargestPossibleRegion() );
+
+  input->SetRequestedRegion( inputRegion );
+}
+
+template <class TInputImage, class TOutputImage>
+typename FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::SizeType
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::ComputeOverlap() const
+{
+  /**
+   * The overlap has to cover the support of the widest kernel, whatever
+   * its orientation.
+   */
+  RealType maximumSigma = 0.0;
+  for ( unsigned int k = 0; k < this->m_GaborKernels.size(); k++ )
+    {
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      maximumSigma = vnl_math_max( maximumSigma,
+        vnl_math_abs( this->m_GaborKernels[k].Sigma[i] ) );
+      }
+    }
+
+  SizeType overlap;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    overlap[i] = static_cast<unsigned long>( vcl_ceil( this->m_TileOverlapFactor
+      * maximumSigma / this->GetInput()->GetSpacing()[i] ) );
+    }
+  return overlap;
+}
+
+template <class TInputImage, class TOutputImage>
+SizeValueType
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::GetTransformLength( SizeValueType length )
+{
+  for ( SizeValueType n = vnl_math_max( length,
+    static_cast<SizeValueType>( 1 ) ); ; n++ )
+    {
+    SizeValueType m = n;
+    while ( m % 2 == 0 )
+      {
+      m /= 2;
+      }
+    while ( m % 3 == 0 )
+      {
+      m /= 3;
+      }
+    while ( m % 5 == 0 )
+      {
+      m /= 5;
+      }
+    if ( m == 1 )
+      {
+      return n;
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+void
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  if ( this->m_GaborKernels.empty() )
+    {
+    itkExceptionMacro( << "No Gabor kernels have been specified." );
+    }
+
+  this->AllocateOutputs();
+
+  const InputImageType *input = this->GetInput();
+  OutputImageType *output = this->GetOutput();
+
+  /**
+   * Only the requested output region is tiled.  The input requested region
+   * holds the overlap around it, except beyond the image.
+   */
+  RegionType region = output->GetRequestedRegion();
+  typename InputImageType::RegionType inputRegion = input->GetRequestedRegion();
+
+  SizeType tileSize;
+  SizeType overlap = this->ComputeOverlap();
+  SizeType numberOfTiles;
+  unsigned long totalNumberOfTiles = 1;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    tileSize[i] = region.GetSize()[i];
+    if ( this->m_TileSize[i] > 0 && this->m_TileSize[i] < tileSize[i] )
+      {
+      tileSize[i] = this->m_TileSize[i];
+      }
+    numberOfTiles[i] = ( region.GetSize()[i] + tileSize[i] - 1 ) / tileSize[i];
+    totalNumberOfTiles *= numberOfTiles[i];
+    }
+
+  for ( unsigned long n = 0; n < totalNumberOfTiles; n++ )
+    {
+    /**
+     * Find the core of the tile and pad it with the overlap, then up to a
+     * length the transforms support.
+     */
+    RegionType coreRegion;
+    RegionType paddedRegion;
+    unsigned long t = n;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      long start = region.GetIndex()[i]
+        + static_cast<long>( ( t % numberOfTiles[i] ) * tileSize[i] );
+      long end = vnl_math_min( start + static_cast<long>( tileSize[i] ),
+        region.GetIndex()[i] + static_cast<long>( region.GetSize()[i] ) );
+      t /= numberOfTiles[i];
+
+      coreRegion.SetIndex( i, start );
+      coreRegion.SetSize( i, end - start );
+
+      paddedRegion.SetIndex( i, start - static_cast<long>( overlap[i] ) );
+      paddedRegion.SetSize( i, this->GetTransformLength(
+        end - start + 2 * overlap[i] ) );
+      }
+
+    typename RealImageType::RegionType tileRegion;
+    tileRegion.SetSize( paddedRegion.GetSize() );
+
+    typename RealImageType::Pointer tile = RealImageType::New();
+    tile->SetRegions( tileRegion );
+    tile->SetSpacing( input->GetSpacing() );
+    tile->Allocate();
+
+    /**
+     * The pixels outside the input requested region take the value of the
+     * nearest pixel in it.  Within the overlap, these are only the pixels
+     * beyond the image.
+     */
+    ImageRegionIteratorWithIndex<RealImageType> ItT( tile, tileRegion );
+    for ( ItT.GoToBegin(); !ItT.IsAtEnd(); ++ItT )
+      {
+      typename InputImageType::IndexType index;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        index[i] = vnl_math_min( vnl_math_max( paddedRegion.GetIndex()[i]
+          + ItT.GetIndex()[i], inputRegion.GetIndex()[i] ),
+          inputRegion.GetIndex()[i]
+          + static_cast<long>( inputRegion.GetSize()[i] ) - 1 );
+        }
+      ItT.Set( static_cast<RealType>( input->GetPixel( index ) ) );
+      }
+
+    RealImagePointer response = this->FilterTile( tile );
+
+    /**
+     * Keep only the core of the tile.
+     */
+    typename RealImageType::RegionType responseRegion;
+    responseRegion.SetSize( coreRegion.GetSize() );
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      responseRegion.SetIndex( i,
+        coreRegion.GetIndex()[i] - paddedRegion.GetIndex()[i] );
+      }
+
+    ImageRegionConstIterator<RealImageType> ItR( response, responseRegion );
+    ImageRegionIterator<OutputImageType> ItO( output, coreRegion );
+    for ( ItR.GoToBegin(), ItO.GoToBegin(); !ItR.IsAtEnd(); ++ItR, ++ItO )
+      {
+      ItO.Set( static_cast<typename OutputImageType::PixelType>( ItR.Get() ) );
+      }
+
+    this->UpdateProgress( static_cast<float>( n + 1 )
+      / static_cast<float>( totalNumberOfTiles ) );
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+typename FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::RealImagePointer
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::FilterTile( const RealImageType *tile )
+{
+  /**
+   * Generate the fourier transform of the tile once for the whole bank.
+   */
+#ifdef ITK_USE_FFTWF
+  typedef FFTWRealToComplexConjugateImageFilter
+    <RealType, ImageDimension> FFTFilterType;
+#else
+  typedef VnlFFTRealToComplexConjugateImageFilter
+    <RealType, ImageDimension> FFTFilterType;
+#endif
+  typename FFTFilterType::Pointer fftFilter = FFTFilterType::New();
+  fftFilter->SetInput( tile );
+  fftFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+  fftFilter->Update();
+
+  /**
+   * Tabulate the signed frequency, in cycles per physical unit, of each
+   * index of the spectrum along each axis.  This is valid both for the
+   * half spectrum of the FFTW filters and the full spectrum of the vnl ones.
+   */
+  FilterBankThreadStruct str;
+  str.Filter = this;
+  str.Spectrum = fftFilter->GetOutput();
+  str.Size = tile->GetLargestPossibleRegion().GetSize();
+
+  typename ComplexImageType::RegionType spectrumRegion
+    = str.Spectrum->GetLargestPossibleRegion();
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    RealType N = static_cast<RealType>( str.Size[i] );
+    RealType delta = 1.0 / ( N * tile->GetSpacing()[i] );
+
+    str.Frequencies[i].resize( spectrumRegion.GetSize()[i] );
+    for ( unsigned int m = 0; m < spectrumRegion.GetSize()[i]; m++ )
+      {
+      RealType signedIndex = ( 2 * m <= str.Size[i] )
+        ? static_cast<RealType>( m ) : static_cast<RealType>( m ) - N;
+      str.Frequencies[i][m] = signedIndex * delta;
+      }
+    }
+
+  /**
+   * FFTW planning is not thread-safe, so the single threaded inverse plan
+   * is created here and the threads only execute it on their own buffers.
+   * FFTW does not normalize the inverse transform, which is folded into the
+   * kernel amplitudes.
+   */
+  str.InverseScale = 1.0;
+#ifdef ITK_USE_FFTWF
+  int n[ImageDimension];
+  unsigned long numberOfPixels = 1;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    n[ImageDimension - 1 - i] = static_cast<int>( str.Size[i] );
+    numberOfPixels *= str.Size[i];
+    }
+  str.InverseScale = 1.0 / static_cast<RealType>( numberOfPixels );
+
+  fftwf_complex *planInput = static_cast<fftwf_complex *>( fftwf_malloc(
+    sizeof( fftwf_complex ) * spectrumRegion.GetNumberOfPixels() ) );
+  RealType *planOutput = static_cast<RealType *>( fftwf_malloc(
+    sizeof( RealType ) * numberOfPixels ) );
+  fftwf_plan_with_nthreads( 1 );
+  str.InversePlan = fftwf_plan_dft_c2r( ImageDimension, n, planInput,
+    planOutput, FFTW_ESTIMATE | FFTW_UNALIGNED );
+#endif
+
+  ThreadIdType numberOfThreads = vnl_math_min(
+    static_cast<unsigned int>( this->GetNumberOfThreads() ),
+    static_cast<unsigned int>( this->m_GaborKernels.size() ) );
+  str.MaximumResponseImages.resize( numberOfThreads );
+
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->FilterTileThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+#ifdef ITK_USE_FFTWF
+  fftwf_destroy_plan( str.InversePlan );
+  fftwf_free( planInput );
+  fftwf_free( planOutput );
+#endif
+
+  /**
+   * Combine the maxima of the threads.
+   */
+  RealImagePointer response = str.MaximumResponseImages[0];
+  for ( unsigned int n = 1; n < str.MaximumResponseImages.size(); n++ )
+    {
+    if ( !str.MaximumResponseImages[n] )
+      {
+      continue;
+      }
+    ImageRegionConstIterator<RealImageType> ItN( str.MaximumResponseImages[n],
+      str.MaximumResponseImages[n]->GetLargestPossibleRegion() );
+    ImageRegionIterator<RealImageType> ItR( response,
+      response->GetLargestPossibleRegion() );
+    for ( ItN.GoToBegin(), ItR.GoToBegin(); !ItR.IsAtEnd(); ++ItN, ++ItR )
+      {
+      ItR.Set( vnl_math_max( ItN.Get(), ItR.Get() ) );
+      }
+    }
+
+  return response;
+}
+
+template <class TInputImage, class TOutputImage>
+ITK_THREAD_RETURN_TYPE
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::FilterTileThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  FilterBankThreadStruct *str =
+    static_cast<FilterBankThreadStruct *>( info->UserData );
+
+  str->Filter->ThreadedFilterTile( info->ThreadID, info->NumberOfThreads, str );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage>
+void
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::ThreadedFilterTile( ThreadIdType threadId, ThreadIdType numberOfThreads,
+  FilterBankThreadStruct *str )
+{
+#ifndef ITK_USE_FFTWF
+  typedef VnlFFTComplexConjugateToRealImageFilter
+    <RealType, ImageDimension> InverseFFTFilterType;
+#endif
+
+  const ComplexImageType *spectrum = str->Spectrum;
+  typename ComplexImageType::RegionType spectrumRegion
+    = spectrum->GetLargestPossibleRegion();
+
+  bool calculateEven = ( this->m_ResponseType != OddResponse );
+  bool calculateOdd = ( this->m_ResponseType != EvenResponse );
+
+  /**
+   * The products are reused for every kernel of the thread.
+   */
+  typename ComplexImageType::Pointer evenProduct = NULL;
+  typename ComplexImageType::Pointer oddProduct = NULL;
+  if ( calculateEven )
+    {
+    evenProduct = ComplexImageType::New();
+    evenProduct->SetRegions( spectrumRegion );
+    evenProduct->Allocate();
+    }
+  if ( calculateOdd )
+    {
+    oddProduct = ComplexImageType::New();
+    oddProduct->SetRegions( spectrumRegion );
+    oddProduct->Allocate();
+    }
+
+  RealImagePointer maximumResponse = RealImageType::New();
+  typename RealImageType::RegionType tileRegion;
+  tileRegion.SetSize( str->Size );
+  maximumResponse->SetRegions( tileRegion );
+  maximumResponse->Allocate();
+  maximumResponse->FillBuffer( NumericTraits<RealType>::NonpositiveMin() );
+  str->MaximumResponseImages[threadId] = maximumResponse;
+
+  RealImagePointer evenResponse = NULL;
+  RealImagePointer oddResponse = NULL;
+#ifdef ITK_USE_FFTWF
+  if ( calculateEven )
+    {
+    evenResponse = RealImageType::New();
+    evenResponse->SetRegions( tileRegion );
+    evenResponse->Allocate();
+    }
+  if ( calculateOdd )
+    {
+    oddResponse = RealImageType::New();
+    oddResponse->SetRegions( tileRegion );
+    oddResponse->Allocate();
+    }
+#endif
+
+  /**
+   * Gaussian terms below exp( -maximumExponent ) are dropped.
+   */
+  const RealType maximumExponent = 30.0;
+  const RealType twoPiSquared = 2.0 * vnl_math_sqr( vnl_math::pi );
+
+  for ( unsigned int k = threadId; k < this->m_GaborKernels.size();
+    k += numberOfThreads )
+    {
+    const GaborKernelParametersType & kernel = this->m_GaborKernels[k];
+    const RealType amplitude = kernel.Amplitude * str->InverseScale;
+
+    ArrayType weights;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      weights[i] = twoPiSquared * vnl_math_sqr( kernel.Sigma[i] );
+      }
+
+    /**
+     * Multiply in frequency space with the analytic transform of the
+     * kernel, i.e. the sum (even) or the difference times -i (odd) of the
+     * Gaussians centered at plus and minus the kernel frequency.
+     */
+    ImageRegionConstIteratorWithIndex<ComplexImageType> ItS( spectrum,
+      spectrumRegion );
+    ImageRegionIterator<ComplexImageType> ItE;
+    ImageRegionIterator<ComplexImageType> ItO;
+    if ( calculateEven )
+      {
+      ItE = ImageRegionIterator<ComplexImageType>( evenProduct, spectrumRegion );
+      ItE.GoToBegin();
+      }
+    if ( calculateOdd )
+      {
+      ItO = ImageRegionIterator<ComplexImageType>( oddProduct, spectrumRegion );
+      ItO.GoToBegin();
+      }
+
+    for ( ItS.GoToBegin(); !ItS.IsAtEnd(); ++ItS )
+      {
+      typename ComplexImageType::IndexType index = ItS.GetIndex();
+
+      RealType frequency[ImageDimension];
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        frequency[i] = str->Frequencies[i][index[i] - spectrumRegion.GetIndex()[i]];
+        }
+
+      RealType exponentMinus = 0.0;
+      RealType exponentPlus = 0.0;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        RealType u = 0.0;
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+          u += kernel.Rotation[i][j] * frequency[j];
+          }
+        exponentMinus += weights[i] * vnl_math_sqr( u - kernel.Frequency[i] );
+        exponentPlus += weights[i] * vnl_math_sqr( u + kernel.Frequency[i] );
+        }
+      RealType gaussianMinus = ( exponentMinus < maximumExponent )
+        ? vcl_exp( -exponentMinus ) : 0.0;
+      RealType gaussianPlus = ( exponentPlus < maximumExponent )
+        ? vcl_exp( -exponentPlus ) : 0.0;
+
+      if ( calculateEven )
+        {
+        ItE.Set( ItS.Get() * std::complex<RealType>(
+          amplitude * ( gaussianMinus + gaussianPlus ), 0.0 ) );
+        ++ItE;
+        }
+      if ( calculateOdd )
+        {
+        ItO.Set( ItS.Get() * std::complex<RealType>(
+          0.0, -amplitude * ( gaussianMinus - gaussianPlus ) ) );
+        ++ItO;
+        }
+      }
+
+    /**
+     * Transform back and keep the maximum response.
+     */
+#ifdef ITK_USE_FFTWF
+    if ( calculateEven )
+      {
+      fftwf_execute_dft_c2r( str->InversePlan,
+        reinterpret_cast<fftwf_complex *>( evenProduct->GetBufferPointer() ),
+        evenResponse->GetBufferPointer() );
+      }
+    if ( calculateOdd )
+      {
+      fftwf_execute_dft_c2r( str->InversePlan,
+        reinterpret_cast<fftwf_complex *>( oddProduct->GetBufferPointer() ),
+        oddResponse->GetBufferPointer() );
+      }
+#else
+    if ( calculateEven )
+      {
+      typename InverseFFTFilterType::Pointer evenFilter
+        = InverseFFTFilterType::New();
+      evenFilter->SetInput( evenProduct );
+      evenFilter->SetActualXDimensionIsOdd( str->Size[0] % 2 );
+      evenFilter->SetNumberOfThreads( 1 );
+      evenFilter->Update();
+      evenResponse = evenFilter->GetOutput();
+      }
+    if ( calculateOdd )
+      {
+      typename InverseFFTFilterType::Pointer oddFilter
+        = InverseFFTFilterType::New();
+      oddFilter->SetInput( oddProduct );
+      oddFilter->SetActualXDimensionIsOdd( str->Size[0] % 2 );
+      oddFilter->SetNumberOfThreads( 1 );
+      oddFilter->Update();
+      oddResponse = oddFilter->GetOutput();
+      }
+#endif
+
+    ImageRegionIterator<RealImageType> ItR( maximumResponse, tileRegion );
+    if ( this->m_ResponseType == MagnitudeResponse )
+      {
+      ImageRegionConstIterator<RealImageType> ItEven( evenResponse,
+        evenResponse->GetLargestPossibleRegion() );
+      ImageRegionConstIterator<RealImageType> ItOdd( oddResponse,
+        oddResponse->GetLargestPossibleRegion() );
+      for ( ItEven.GoToBegin(), ItOdd.GoToBegin(), ItR.GoToBegin();
+        !ItR.IsAtEnd(); ++ItEven, ++ItOdd, ++ItR )
+        {
+        RealType magnitude = vcl_sqrt( vnl_math_sqr( ItEven.Get() )
+          + vnl_math_sqr( ItOdd.Get() ) );
+        ItR.Set( vnl_math_max( magnitude, ItR.Get() ) );
+        }
+      }
+    else
+      {
+      RealImagePointer ifft = calculateEven ? evenResponse : oddResponse;
+      ImageRegionConstIterator<RealImageType> ItI( ifft,
+        ifft->GetLargestPossibleRegion() );
+      for ( ItI.GoToBegin(), ItR.GoToBegin(); !ItR.IsAtEnd(); ++ItI, ++ItR )
+        {
+        ItR.Set( vnl_math_max( ItI.Get(), ItR.Get() ) );
+        }
+      }
+    }
+}
+
+/**
+ * Standard "PrintSelf" method
+ */
+template <class TInputImage, class TOutputImage>
+void
+FrequencyDomainGaborFilterBankImageFilter<TInputImage, TOutputImage>
+::PrintSelf(
+  std::ostream& os,
+  Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Number of Gabor kernels: "
+     << this->m_GaborKernels.size() << std::endl;
+  os << indent << "Response type: " << this->m_ResponseType << std::endl;
+  os << indent << "Tile size: " << this->m_TileSize << std::endl;
+  os << indent << "Tile overlap factor: "
+     << this->m_TileOverlapFactor << std::endl;
+}
+
+}  //end namespace itk
+
+#endif
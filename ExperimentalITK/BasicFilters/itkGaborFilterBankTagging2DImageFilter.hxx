@@ -5,25 +5,12 @@
 
 #include "itkBinaryThresholdImageFilter.h"
 #include "itkEuler2DTransform.h"
-#include "itkExtractImageFilter.h"
-#include "itkFFTShiftImageFilter.h"
-#include "itkFFTWComplexConjugateToRealImageFilter.h"
-#include "itkFFTWRealToComplexConjugateImageFilter.h"
+#include "itkFrequencyDomainGaborFilterBankImageFilter.h"
 #include "itkLabelStatisticsImageFilter.h"
 #include "itkOtsuMultipleThresholdsImageFilter.h"
-#include "itkResampleImageFilter.h"
-#include "itkVnlFFTComplexConjugateToRealImageFilter.h"
-#include "itkVnlFFTRealToComplexConjugateImageFilter.h"
-
-#include "itkBinaryMagnitudeImageFilter.h"
-#include "itkComplexToImaginaryImageFilter.h"
-#include "itkComplexToRealImageFilter.h"
-#include "itkImageFileWriter.h"
 
 #include "vnl/vnl_math.h"
 
-#define USE_FFTW
-
 namespace itk
 {
 
@@ -52,13 +39,6 @@ GaborFilterBankTagging2DImageFilter<TInputImage, TOutputImage>
 ::GenerateData()
 {
 
-  this->m_MaximumResponseImage = RealImageType::New();
-  this->m_MaximumResponseImage->SetOrigin( this->GetInput()->GetOrigin() );
-  this->m_MaximumResponseImage->SetSpacing( this->GetInput()->GetSpacing() );
-  this->m_MaximumResponseImage->SetRegions( this->GetInput()->GetRequestedRegion() );
-  this->m_MaximumResponseImage->Allocate();
-  this->m_MaximumResponseImage->FillBuffer( NumericTraits<RealType>::NonpositiveMin() );
- 
   if ( !this->m_MaskImage )
     { 
     this->m_MaskImage = LabelImageType::New();
@@ -76,95 +56,15 @@ GaborFilterBankTagging2DImageFilter<TInputImage, TOutputImage>
    * the x, y, and z axes, respectively.
    */
 
-  typename InputImageType::SpacingType spacing;
-  for ( unsigned int i = 0; i < ImageDimension; i++ )
-    { 
-    spacing[i] = 1.0 / this->GetInput()->GetSpacing()[i];
-    }
-
-  /**
-   * Generate the fourier transform of the input image
-   */
-#ifdef USE_FFTW   
-  typedef FFTWRealToComplexConjugateImageFilter<RealType, ImageDimension> FFTFilterType;
-#else
-  typedef VnlFFTRealToComplexConjugateImageFilter<RealType, ImageDimension> FFTFilterType;
-#endif
-  typename FFTFilterType::Pointer fftFilter = FFTFilterType::New();
-  fftFilter->SetInput( this->GetInput() );
-  fftFilter->Update(); 
-  fftFilter->GetOutput()->SetSpacing( spacing );
-
-  typedef typename FFTFilterType::OutputImageType ComplexImageType;
-  typename ComplexImageType::Pointer fft = ComplexImageType::New();
-
-#ifdef USE_FFTW   
-  fft->SetSpacing( spacing );
-  fft->SetOrigin( fftFilter->GetOutput()->GetOrigin() );
-  fft->SetRegions( this->GetInput()->GetRequestedRegion() );  
-  fft->Allocate();
-
-  ImageRegionIteratorWithIndex<ComplexImageType> ItF( fft,
-    fft->GetLargestPossibleRegion() ); 
-
-  for ( ItF.GoToBegin(); !ItF.IsAtEnd(); ++ItF )
-    {
-    if ( ItF.GetIndex()[0] <= 0.5 * fft->GetLargestPossibleRegion().GetSize()[0] )
-      {
-      ItF.Set( fftFilter->GetOutput()->GetPixel( ItF.GetIndex() ) );  
-      } 
-    else
-      {
-      typename ComplexImageType::IndexType index;
-      for ( unsigned int i = 0; i < ImageDimension; i++ )
-        {
-        index[i] = fft->GetLargestPossibleRegion().GetSize()[i] - ItF.GetIndex()[i];
-        } 
-      typename ComplexImageType::PixelType pixel
-        = fftFilter->GetOutput()->GetPixel( index );
-      ItF.Set( std::complex<RealType>( pixel.real(), -pixel.imag() ) ); 
-      }
-    }
-
-#else
-  fft = fftFilter->GetOutput();
-#endif 
-
-  typedef FFTShiftImageFilter<ComplexImageType, ComplexImageType> ShifterType;
-  typename ShifterType::Pointer shifter = ShifterType::New();
-  shifter->SetInput( fft );
-  shifter->SetInverse( 1 );
-  shifter->Update();
-  
+  typedef FrequencyDomainGaborFilterBankImageFilter
+    <InputImageType, RealImageType> FilterBankType;
+  typename FilterBankType::Pointer filterBank = FilterBankType::New();
+  filterBank->SetInput( this->GetInput() );
+  filterBank->SetNumberOfThreads( this->GetNumberOfThreads() );
+  filterBank->SetResponseType( FilterBankType::EvenResponse );
 
-  /** 
-   * Debug: Write magnitude image of imaginary and real parts.
-   */ 
-  /*
-  typedef ComplexToImaginaryImageFilter<ComplexImageType, RealImageType> ImaginerType;
-  typename ImaginerType::Pointer imaginer = ImaginerType::New();
-  imaginer->SetInput( shifter->GetOutput() );
-  imaginer->Update();
-
-  typedef ComplexToRealImageFilter<ComplexImageType, RealImageType> RealerType;
-  typename RealerType::Pointer realer = RealerType::New();
-  realer->SetInput( shifter->GetOutput() );
-  realer->Update();
-
-  typedef BinaryMagnitudeImageFilter<RealImageType, RealImageType, RealImageType> BinarierType;
-  typename BinarierType::Pointer binarier = BinarierType::New();
-  binarier->SetInput1( imaginer->GetOutput() );
-  binarier->SetInput2( realer->GetOutput() );
-  binarier->Update();
-
-  typedef ImageFileWriter<RealImageType> WriterType;
-  typename WriterType::Pointer writer = WriterType::New();
-  writer->SetInput( binarier->GetOutput() );
-  writer->SetFileName( "FFTimage.nii" );
-  writer->Update();
-  */
-
-  unsigned int iteration = 0;
+  typename InputImageType::SizeType size 
+    = this->GetInput()->GetLargestPossibleRegion().GetSize();
 
   for ( RealType tagSpacing = this->m_TagSpacingMinimum; 
         tagSpacing <= this->m_TagSpacingMaximum; 
@@ -205,179 +105,37 @@ GaborFilterBankTagging2DImageFilter<TInputImage, TOutputImage>
         ArrayType sigma;
         sigma[0] = 0.4 / tagSpacing;
         sigma[1] = 7.5 * sigma[0]; 
-            
-        /**
-          * Generate the fourier transform of the gabor filter
-          */
-        typename RealImageType::Pointer fourierGaborImage 
-          = RealImageType::New();
-        fourierGaborImage->SetOrigin( this->GetInput()->GetOrigin() );
-        fourierGaborImage->SetSpacing( spacing );
-        fourierGaborImage->SetRegions( this->GetInput()->GetRequestedRegion().GetSize() );
-        fourierGaborImage->Allocate();
-        fourierGaborImage->FillBuffer( 0.0 );
-            
-        for ( RealType d = -1.0; d <= 1.01; d+=2.0 )
-          {  
-          typename FourierTransformGaborImageSourceType::Pointer 
-            fourierGabor = FourierTransformGaborImageSourceType::New();
-          fourierGabor->SetOrigin( this->GetInput()->GetOrigin() );
-          fourierGabor->SetSpacing( spacing );
-          fourierGabor->SetSize( this->GetInput()->GetRequestedRegion().GetSize() );
-        
-          typename FourierTransformGaborImageSourceType::ArrayType gaussianSigma;
-          typename FourierTransformGaborImageSourceType::ArrayType mean;
-        
-          for ( unsigned int i = 0; i < ImageDimension; i++ )
-            {
-            gaussianSigma[i] = 1.0 / ( 2.0 * sigma[i] * vnl_math::pi );
-            mean[i] = this->GetInput()->GetOrigin()[i] 
-              + 0.5 * ( this->GetInput()->GetLargestPossibleRegion().GetSize()[i] - 1 ) 
-                    * ( spacing[i] ) + d * fundamentalFrequency[i];
-            } 
-  
-          fourierGabor->SetSigma( gaussianSigma );
-          fourierGabor->SetMean( mean );
-          fourierGabor->SetScale( 1.0 );
-          fourierGabor->SetNormalized( false );
-          fourierGabor->Update();
-          
-          ImageRegionIterator<RealImageType> It( fourierGabor->GetOutput(),
-            fourierGabor->GetOutput()->GetRequestedRegion() );
-          ImageRegionIterator<RealImageType> ItF( fourierGaborImage,
-            fourierGaborImage->GetRequestedRegion() );
-          for ( It.GoToBegin(), ItF.GoToBegin(); !It.IsAtEnd(); ++It, ++ItF )  
-            {
-            ItF.Set( ItF.Get() + It.Get() );
-            }  
-          }       
-      
+
         /**
-          * Rotate the fourier transformed gabor filter
-          */
-        typedef Euler2DTransform<RealType> TransformType;
-        typename TransformType::Pointer transform = TransformType::New();
-      
-        transform->SetRotation( theta );
-        typename TransformType::OutputVectorType translation;
-        translation.Fill( 0 );
-        transform->SetTranslation( translation );
-        typename TransformType::InputPointType center;
+         * The tag spacing and the inverse sigmas are given in units of the physical
+         * frequency times the image size along each axis.  Convert them.
+         */
+        typename FilterBankType::GaborKernelParametersType kernel;
         for ( unsigned int i = 0; i < ImageDimension; i++ )
           {
-          center[i] = this->GetInput()->GetOrigin()[i] 
-            + 0.5 * ( this->GetInput()->GetLargestPossibleRegion().GetSize()[i] - 1 ) 
-                  * ( spacing[i] );
+          kernel.Frequency[i] = fundamentalFrequency[i] 
+            / static_cast<RealType>( size[i] );
+          kernel.Sigma[i] = sigma[i] * static_cast<RealType>( size[i] );
           }
-        transform->SetCenter( center );
-        
-        typedef LinearInterpolateImageFunction<RealImageType, RealType> LinearInterpolatorType;
-        typename LinearInterpolatorType::Pointer interpolator = LinearInterpolatorType::New();
-        interpolator->SetInputImage( fourierGaborImage );
-      
-        typedef ResampleImageFilter<RealImageType, RealImageType, RealType> ResamplerType;
-        typename ResamplerType::Pointer resampler = ResamplerType::New();
-        resampler->SetDefaultPixelValue( 0 );
-        resampler->SetTransform( transform );
-        resampler->SetInterpolator( interpolator );
-        resampler->SetInput( fourierGaborImage );
-        resampler->SetOutputSpacing( fourierGaborImage->GetSpacing() );
-        resampler->SetOutputOrigin( fourierGaborImage->GetOrigin() );
-        resampler->SetSize( fourierGaborImage->GetLargestPossibleRegion().GetSize() );
-        resampler->Update();
+        kernel.Amplitude = -1.0;
 
         /**
-         * Multiply in frequency space
+         * Rotate the fourier transformed gabor filter
          */
-        typename ComplexImageType::Pointer filteredImage = ComplexImageType::New();
-        filteredImage->SetRegions( resampler->GetOutput()->GetLargestPossibleRegion() );
-        filteredImage->SetOrigin( resampler->GetOutput()->GetOrigin() );
-        filteredImage->SetSpacing( resampler->GetOutput()->GetSpacing() );
-        filteredImage->Allocate();
-      
-        ImageRegionIterator<ComplexImageType> ItS( shifter->GetOutput(), 
-          shifter->GetOutput()->GetLargestPossibleRegion() );
-        ImageRegionIterator<RealImageType> ItG( resampler->GetOutput(), 
-          resampler->GetOutput()->GetLargestPossibleRegion() );
-        ImageRegionIterator<ComplexImageType> It( filteredImage, 
-          filteredImage->GetLargestPossibleRegion() );
-      
-        ItS.GoToBegin();
-        ItG.GoToBegin();
-        It.GoToBegin();
-        while ( !It.IsAtEnd()  )
-          {
-          It.Set( ItS.Get() * std::complex<RealType>( -ItG.Get(), 0 ) );     
-      
-          ++ItS;
-          ++ItG;  
-          ++It;
-          }  
-      
-        /**
-         * Generate the fourier transform of the filtered image
-         */
-      
-        typename ShifterType::Pointer inverseShifter = ShifterType::New();
-        inverseShifter->SetInput( filteredImage );
-        inverseShifter->SetInverse( 1 );
-        inverseShifter->Update();
-
-        typename ComplexImageType::Pointer ifft = ComplexImageType::New();
-
-#ifdef USE_FFTW   
-        typedef FFTWComplexConjugateToRealImageFilter<RealType, ImageDimension> InverseFFTFilterType;
-
-        typedef ExtractImageFilter<ComplexImageType, ComplexImageType> ExtracterType;
-        typename ExtracterType::Pointer extracter = ExtracterType::New();
-        typename ComplexImageType::RegionType region;
-        typename ComplexImageType::RegionType::SizeType size;
-        size = inverseShifter->GetOutput()->GetLargestPossibleRegion().GetSize();
-        size[0] = static_cast<unsigned int>( 0.5 * size[0] ) + 1;
-        region.SetIndex( inverseShifter->GetOutput()->GetLargestPossibleRegion().GetIndex() );
-        region.SetSize( size );
-        extracter->SetInput( inverseShifter->GetOutput() );
-        extracter->SetExtractionRegion( region );  
-        extracter->Update();
-
-        ifft = extracter->GetOutput();
-#else
-        typedef VnlFFTComplexConjugateToRealImageFilter<RealType, ImageDimension> InverseFFTFilterType;
-        ifft = inverseShifter->GetOutput();
-#endif
-        typename InverseFFTFilterType::Pointer ifftFilter = InverseFFTFilterType::New();
-        ifftFilter->SetInput( ifft );
-        ifftFilter->Update(); 
-        ifftFilter->GetOutput()->SetSpacing( this->GetInput()->GetSpacing() );
-   
-//        {
-//        itk::OStringStream buf;
-//        buf << iteration;
-//        std::string filename = std::string( "ifft" )
-//          + buf.str() + std::string( ".nii.gz" );       
-//
-//        typedef ImageFileWriter<RealImageType> WriterType;
-//        typename WriterType::Pointer writer = WriterType::New();
-//        writer->SetInput( ifftFilter->GetOutput() );
-//        writer->SetFileName( filename.c_str() );
-//        writer->Update();
-//        } 
-
-        ImageRegionIterator<RealImageType> ItI( ifftFilter->GetOutput(), 
-          ifftFilter->GetOutput()->GetLargestPossibleRegion() );
-        ImageRegionIterator<RealImageType> ItR( this->m_MaximumResponseImage, 
-          this->m_MaximumResponseImage->GetLargestPossibleRegion() );
-   
-        for ( ItI.GoToBegin(), ItR.GoToBegin(); !ItI.IsAtEnd(); ++ItI, ++ItR )
-          {
-          ItR.Set( vnl_math_max( ItI.Get(), ItR.Get() ) );
-          }  
+        typedef Euler2DTransform<RealType> TransformType;
+        typename TransformType::Pointer transform = TransformType::New();
+        transform->SetRotation( theta );
+        kernel.Rotation = transform->GetMatrix();
 
-        iteration++;
+        filterBank->AddGaborKernel( kernel );
         } 
       }
     }
 
+  filterBank->Update();
+  this->m_MaximumResponseImage = filterBank->GetOutput();
+  this->m_MaximumResponseImage->DisconnectPipeline();
+
   typename OutputImageType::Pointer output = OutputImageType::New();
   output->SetOrigin( this->GetInput()->GetOrigin() );
   output->SetSpacing( this->GetInput()->GetSpacing() );
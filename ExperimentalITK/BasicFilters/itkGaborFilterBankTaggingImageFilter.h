@@ -20,7 +20,6 @@
 #include "itkImageToImageFilter.h"
 
 #include "itkFixedArray.h"
-#include "itkGaussianImageSource.h"
 
 
 namespace itk
@@ -57,7 +56,6 @@ public:
     itkGetStaticConstMacro( ImageDimension )>                 RealImageType; 
   typedef Image<unsigned int, 
     itkGetStaticConstMacro( ImageDimension )>                 LabelImageType;   
-  typedef GaussianImageSource<RealImageType>                  FourierTransformGaborImageSourceType; 
   typedef FixedArray<RealType, 
     itkGetStaticConstMacro( ImageDimension )>                 ArrayType; 
   typedef FixedArray<unsigned int, 
@@ -0,0 +1,218 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkHessianMeasureFunctors.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkHessianMeasureFunctors_h
+#define __itkHessianMeasureFunctors_h
+
+#include "itkFixedArray.h"
+
+#include "vnl/vnl_math.h"
+
+namespace itk
+{
+
+// These functors compute a measure from the eigenvalues of the Hessian of
+// a pixel.  The eigenvalues are given in increasing order of magnitude,
+// |lambda_1| <= |lambda_2| <= ... , as produced by
+// MultiScaleRecursiveHessianMeasureImageFilter.
+namespace Functor {
+
+/** \class HessianObjectnessMeasure
+ * \brief Objectness of Antiga, generalizing the vesselness of Frangi to
+ * M-dimensional structures (0: blobs, 1: vessels, 2: plates).
+ *
+ * Same measure as HessianToObjectnessMeasureImageFilter.
+ */
+template <unsigned int VDimension>
+class HessianObjectnessMeasure
+{
+public:
+  typedef FixedArray<double, VDimension>                      EigenValuesType;
+
+  HessianObjectnessMeasure()
+    {
+    this->m_Alpha = 0.5;
+    this->m_Beta = 0.5;
+    this->m_Gamma = 5.0;
+    this->m_ObjectDimension = 1;
+    this->m_BrightObject = true;
+    this->m_ScaleObjectnessMeasure = true;
+    }
+  ~HessianObjectnessMeasure() {}
+
+  void SetAlpha( double alpha ) { this->m_Alpha = alpha; }
+  double GetAlpha() const { return this->m_Alpha; }
+  void SetBeta( double beta ) { this->m_Beta = beta; }
+  double GetBeta() const { return this->m_Beta; }
+  void SetGamma( double gamma ) { this->m_Gamma = gamma; }
+  double GetGamma() const { return this->m_Gamma; }
+  void SetObjectDimension( unsigned int dimension )
+    { this->m_ObjectDimension = dimension; }
+  unsigned int GetObjectDimension() const
+    { return this->m_ObjectDimension; }
+  void SetBrightObject( bool bright ) { this->m_BrightObject = bright; }
+  bool GetBrightObject() const { return this->m_BrightObject; }
+  void SetScaleObjectnessMeasure( bool scale )
+    { this->m_ScaleObjectnessMeasure = scale; }
+  bool GetScaleObjectnessMeasure() const
+    { return this->m_ScaleObjectnessMeasure; }
+
+  inline double operator()( const EigenValuesType & lambda ) const
+    {
+    const unsigned int M = this->m_ObjectDimension;
+
+    double absLambda[VDimension];
+    double frobeniusNormSquared = 0.0;
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      if( d >= M && ( ( this->m_BrightObject && lambda[d] > 0.0 ) ||
+        ( !this->m_BrightObject && lambda[d] < 0.0 ) ) )
+        {
+        return 0.0;
+        }
+      absLambda[d] = vnl_math_abs( lambda[d] );
+      frobeniusNormSquared += vnl_math_sqr( lambda[d] );
+      }
+
+    double measure = 1.0;
+    if( M + 1 < VDimension )
+      {
+      double rA = absLambda[M];
+      double rADenominator = 1.0;
+      for( unsigned int d = M + 1; d < VDimension; d++ )
+        {
+        rADenominator *= absLambda[d];
+        }
+      if( rADenominator > 0.0 )
+        {
+        rA /= vcl_pow( rADenominator,
+          1.0 / static_cast<double>( VDimension - M - 1 ) );
+        }
+      measure *= 1.0 - vcl_exp( -0.5 * vnl_math_sqr( rA / this->m_Alpha ) );
+      }
+    if( M > 0 )
+      {
+      double rB = absLambda[M - 1];
+      double rBDenominator = 1.0;
+      for( unsigned int d = M; d < VDimension; d++ )
+        {
+        rBDenominator *= absLambda[d];
+        }
+      if( rBDenominator > 0.0 )
+        {
+        rB /= vcl_pow( rBDenominator,
+          1.0 / static_cast<double>( VDimension - M ) );
+        }
+      measure *= vcl_exp( -0.5 * vnl_math_sqr( rB / this->m_Beta ) );
+      }
+    measure *= 1.0 - vcl_exp( -0.5 * frobeniusNormSquared
+      / vnl_math_sqr( this->m_Gamma ) );
+
+    if( this->m_ScaleObjectnessMeasure )
+      {
+      measure *= absLambda[VDimension - 1];
+      }
+    return measure;
+    }
+
+private:
+  double                                                      m_Alpha;
+  double                                                      m_Beta;
+  double                                                      m_Gamma;
+  unsigned int                                                m_ObjectDimension;
+  bool                                                        m_BrightObject;
+  bool                                                        m_ScaleObjectnessMeasure;
+};
+
+/** \class HessianSmoothedVesselnessMeasure
+ * \brief Smoothed vesselness of Manniesing et al. for 3-D images.
+ *
+ * Same measure as HessianSmoothed3DToVesselnessMeasureImageFilter.
+ */
+class HessianSmoothedVesselnessMeasure
+{
+public:
+  typedef FixedArray<double, 3>                               EigenValuesType;
+
+  HessianSmoothedVesselnessMeasure()
+    {
+    this->m_Alpha = 0.5;
+    this->m_Beta = 0.5;
+    this->m_Gamma = 5.0;
+    this->m_C = 10e-6;
+    this->m_ScaleVesselnessMeasure = true;
+    }
+  ~HessianSmoothedVesselnessMeasure() {}
+
+  void SetAlpha( double alpha ) { this->m_Alpha = alpha; }
+  double GetAlpha() const { return this->m_Alpha; }
+  void SetBeta( double beta ) { this->m_Beta = beta; }
+  double GetBeta() const { return this->m_Beta; }
+  void SetGamma( double gamma ) { this->m_Gamma = gamma; }
+  double GetGamma() const { return this->m_Gamma; }
+  void SetC( double c ) { this->m_C = c; }
+  double GetC() const { return this->m_C; }
+  void SetScaleVesselnessMeasure( bool scale )
+    { this->m_ScaleVesselnessMeasure = scale; }
+  bool GetScaleVesselnessMeasure() const
+    { return this->m_ScaleVesselnessMeasure; }
+
+  inline double operator()( const EigenValuesType & lambda ) const
+    {
+    const double epsilon = 1e-03;
+
+    if( lambda[1] >= 0.0 || lambda[2] >= 0.0 ||
+      vnl_math_abs( lambda[1] ) < epsilon || vnl_math_abs( lambda[2] ) < epsilon )
+      {
+      return 0.0;
+      }
+
+    const double lambda1Abs = vnl_math_abs( lambda[0] );
+    const double lambda2Abs = vnl_math_abs( lambda[1] );
+    const double lambda3Abs = vnl_math_abs( lambda[2] );
+
+    const double A = lambda2Abs / lambda3Abs;
+    const double B = lambda1Abs / vcl_sqrt( lambda2Abs * lambda3Abs );
+    const double S2 = vnl_math_sqr( lambda[0] ) + vnl_math_sqr( lambda[1] )
+      + vnl_math_sqr( lambda[2] );
+
+    double measure =
+      ( 1.0 - vcl_exp( -vnl_math_sqr( A ) / ( 2.0 * vnl_math_sqr( this->m_Alpha ) ) ) )
+      * vcl_exp( -vnl_math_sqr( B ) / ( 2.0 * vnl_math_sqr( this->m_Beta ) ) )
+      * ( 1.0 - vcl_exp( -S2 / ( 2.0 * vnl_math_sqr( this->m_Gamma ) ) ) )
+      * vcl_exp( -2.0 * vnl_math_sqr( this->m_C )
+      / ( lambda2Abs * vnl_math_sqr( lambda3Abs ) ) );
+
+    if( this->m_ScaleVesselnessMeasure )
+      {
+      measure *= lambda3Abs;
+      }
+    return measure;
+    }
+
+private:
+  double                                                      m_Alpha;
+  double                                                      m_Beta;
+  double                                                      m_Gamma;
+  double                                                      m_C;
+  bool                                                        m_ScaleVesselnessMeasure;
+};
+
+}  // end namespace Functor
+
+} // end namespace itk
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "itkSymmetricSecondRankTensor.h"
 #include "itkSymmetricEigenAnalysisImageFilter.h"
+#include "itkHessianMeasureFunctors.h"
 
 namespace itk
 {
@@ -83,6 +84,9 @@ public:
   typedef   SymmetricEigenAnalysisImageFilter< 
             InputImageType, EigenValueImageType >     EigenAnalysisFilterType;
 
+  /** Functor computing the vesselness from the eigenvalues */
+  typedef Functor::HessianSmoothedVesselnessMeasure       VesselnessFunctionType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
   
@@ -56,6 +56,8 @@
 #include "itkAddImageFilter.h"
 #include "itkImageRegionIterator.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -75,6 +77,15 @@ namespace itk
  * point and votes on a small region defined using the minimum and maximum
  * radius given by the user, and fill in the array of radii.
  *
+ *  Each thread votes into its own accumulators, covering its part of the
+ * image plus the voting distance, which are summed once all the threads
+ * are done.
+ *
+ *  GetSpheres() looks for the NumberOfSpheres highest peaks of the blurred
+ * accumulator coarse to fine: the maxima of blocks of SearchBlockSize
+ * pixels along each dimension are searched first, and only the winning
+ * block is scanned at full resolution.
+ *
  * \ingroup ImageFeatureExtraction
  * \todo Update the doxygen documentation!!!
  * */
@@ -231,6 +242,11 @@ public:
   itkSetMacro( SamplingRatio, double );
   itkGetConstMacro( SamplingRatio, double );
 
+  /** Set/Get the size of the blocks of the coarse level of the sphere
+   * search, in pixels along each dimension. Defaults to 8. */
+  itkSetMacro( SearchBlockSize, unsigned int );
+  itkGetConstMacro( SearchBlockSize, unsigned int );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(IntConvertibleToOutputCheck,
@@ -268,6 +284,15 @@ protected:
 
   unsigned int          m_NbOfThreads;
   bool                  m_AllSeedsProcessed;
+  unsigned int          m_SearchBlockSize;
+
+  /** Per-thread accumulators, summed in AfterThreadedGenerateData() */
+  std::vector< InternalImagePointer > m_ThreadAccumulatorImages;
+  std::vector< InternalImagePointer > m_ThreadRadiusImages;
+
+  /** Gaussian weights of a vote over the voting region */
+  std::vector< double > m_VotingWeights;
+  InternalSizeType      m_VotingRadius;
 
 
   /** Method for evaluating the implicit function over the image. */
@@ -291,6 +316,15 @@ protected:
 
   void ComputeMeanRadiusImage( );
 
+  /** Region of the fine image covered by a block of the coarse search */
+  InternalRegionType GetBlockRegion( const InternalIndexType & block,
+    const InternalSizeType & blockSize,
+    const InternalRegionType & fineRegion ) const;
+
+  /** Maximum of the image over a region and its first index */
+  InternalPixelType GetBlockMaximum( const InternalImageType * image,
+    const InternalRegionType & region, InternalIndexType & index ) const;
+
 
 
 private:
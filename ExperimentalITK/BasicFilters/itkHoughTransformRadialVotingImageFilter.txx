@@ -66,6 +66,7 @@ HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
 
   m_NbOfThreads        = 1;
   m_AllSeedsProcessed  = false;
+  m_SearchBlockSize    = 8;
 }
 
 template<class TInputImage, class TOutputImage>
@@ -130,6 +131,51 @@ HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
   m_RadiusImage->SetDirection( inputImage->GetDirection() );
   m_RadiusImage->Allocate();
   m_RadiusImage->FillBuffer( 0 );
+
+  // Each thread votes into its own accumulators, which are summed in
+  // AfterThreadedGenerateData().  With a single thread the votes go
+  // directly into the output accumulators.
+  const unsigned int numberOfThreads = this->GetNumberOfThreads();
+  m_ThreadAccumulatorImages.assign( numberOfThreads, InternalImagePointer() );
+  m_ThreadRadiusImages.assign( numberOfThreads, InternalImagePointer() );
+  if( numberOfThreads == 1 )
+    {
+    m_ThreadAccumulatorImages[0] = m_AccumulatorImage;
+    m_ThreadRadiusImages[0] = m_RadiusImage;
+    }
+
+  // The Gaussian weight of a vote only depends on the offset from the voted
+  // center, so it is tabulated once over the voting region.
+  InputCoordType averageRadius = 0.5 * ( m_MinimumRadius + m_MaximumRadius );
+  InputCoordType averageRadius2 = averageRadius * averageRadius;
+
+  GaussianFunctionPointer GaussianFunction = GaussianFunctionType::New();
+
+  unsigned long numberOfWeights = 1;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    m_VotingRadius[i] = static_cast<InternalSizeValueType>(
+      m_VotingRadiusRatio * m_MinimumRadius/spacing[i] );
+    numberOfWeights *= 1 + 2 * m_VotingRadius[i];
+    }
+
+  // Weights in the order of an image iterator over the voting region
+  m_VotingWeights.resize( numberOfWeights );
+  for ( unsigned long n = 0; n < numberOfWeights; n++ )
+    {
+    unsigned long rest = n;
+    double d = 0;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      const unsigned long width = 1 + 2 * m_VotingRadius[i];
+      const double offset = static_cast<double>( rest % width )
+        - static_cast<double>( m_VotingRadius[i] );
+      rest /= width;
+      d += vnl_math_sqr( offset * spacing[i] );
+      }
+    m_VotingWeights[n] =
+      GaussianFunction->EvaluatePDF( vcl_sqrt( d ), 0, averageRadius2 );
+    }
 }
 
 template<class TInputImage, class TOutputImage>
@@ -137,6 +183,31 @@ void
 HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
 ::AfterThreadedGenerateData()
 {
+  // Sum the thread accumulators
+  for ( unsigned int t = 0; t < m_ThreadAccumulatorImages.size(); t++ )
+    {
+    if( !m_ThreadAccumulatorImages[t]
+      || m_ThreadAccumulatorImages[t] == m_AccumulatorImage )
+      {
+      continue;
+      }
+    InternalRegionType region =
+      m_ThreadAccumulatorImages[t]->GetBufferedRegion();
+    ImageRegionConstIterator< InternalImageType >
+      tAccIt( m_ThreadAccumulatorImages[t], region );
+    ImageRegionConstIterator< InternalImageType >
+      tRadIt( m_ThreadRadiusImages[t], region );
+    InternalIteratorType accIt( m_AccumulatorImage, region );
+    InternalIteratorType radIt( m_RadiusImage, region );
+    for ( ; !accIt.IsAtEnd(); ++tAccIt, ++tRadIt, ++accIt, ++radIt )
+      {
+      accIt.Set( accIt.Get() + tAccIt.Get() );
+      radIt.Set( radIt.Get() + tRadIt.Get() );
+      }
+    }
+  m_ThreadAccumulatorImages.clear();
+  m_ThreadRadiusImages.clear();
+
   ComputeMeanRadiusImage();
 
   // Copy the typecast m_AccumulatorImage to Output image
@@ -168,8 +239,6 @@ ThreadedGenerateData(const OutputImageRegionType& windowRegion,
   DoGFunction->SetInputImage( inputImage );
   DoGFunction->SetSigma( m_SigmaGradient );
 
-  GaussianFunctionPointer GaussianFunction = GaussianFunctionType::New();
-
   unsigned int i;
 
   InternalRegionType region;
@@ -182,13 +251,42 @@ ThreadedGenerateData(const OutputImageRegionType& windowRegion,
   Index< ImageDimension > index, indexAtVote, center;
   InputCoordType distance;
 
-  double d;
   InputCoordType averageRadius = 0.5 * ( m_MinimumRadius + m_MaximumRadius );
-  InputCoordType averageRadius2 = averageRadius * averageRadius;
 
-  InputCoordType rad;
   double weight;
 
+  // The votes of the points of windowRegion fall within averageRadius plus
+  // the voting radius of it.
+  InternalImagePointer accumulatorImage = m_ThreadAccumulatorImages[threadId];
+  InternalImagePointer radiusImage = m_ThreadRadiusImages[threadId];
+  if( !accumulatorImage )
+    {
+    InternalRegionType accumulatorRegion = windowRegion;
+    InternalSizeType padding;
+    for ( i = 0; i < ImageDimension; i++ )
+      {
+      padding[i] = static_cast<InternalSizeValueType>(
+        averageRadius/spacing[i] ) + m_VotingRadius[i] + 1;
+      }
+    accumulatorRegion.PadByRadius( padding );
+    accumulatorRegion.Crop( inputImage->GetLargestPossibleRegion() );
+
+    accumulatorImage = InternalImageType::New();
+    accumulatorImage->CopyInformation( m_AccumulatorImage );
+    accumulatorImage->SetRegions( accumulatorRegion );
+    accumulatorImage->Allocate();
+    accumulatorImage->FillBuffer( 0 );
+
+    radiusImage = InternalImageType::New();
+    radiusImage->CopyInformation( m_RadiusImage );
+    radiusImage->SetRegions( accumulatorRegion );
+    radiusImage->Allocate();
+    radiusImage->FillBuffer( 0 );
+
+    m_ThreadAccumulatorImages[threadId] = accumulatorImage;
+    m_ThreadRadiusImages[threadId] = radiusImage;
+    }
+
   ImageRegionConstIteratorWithIndex< InputImageType >
     image_it( inputImage, windowRegion );
   image_it.GoToBegin();
@@ -225,9 +323,9 @@ ThreadedGenerateData(const OutputImageRegionType& windowRegion,
             center[i] = index[i] - static_cast< InternalIndexValueType >(
               averageRadius * grad[i]/spacing[i] );
 
-            rad = m_VotingRadiusRatio * m_MinimumRadius/spacing[i];
-            start[i] = center[i] - static_cast<InternalIndexValueType>( rad );
-            size[i] = 1 + 2 * static_cast<InternalSizeValueType>( rad );
+            start[i] = center[i]
+              - static_cast<InternalIndexValueType>( m_VotingRadius[i] );
+            size[i] = 1 + 2 * m_VotingRadius[i];
             }
 
           region.SetSize( size );
@@ -236,32 +334,30 @@ ThreadedGenerateData(const OutputImageRegionType& windowRegion,
           if ( inputImage->GetRequestedRegion().IsInside( region ) )
             {
             ImageRegionIteratorWithIndex< InternalImageType >
-              It1( m_AccumulatorImage, region );
-            ImageRegionIterator< InternalImageType > It2( m_RadiusImage, region );
+              It1( accumulatorImage, region );
+            ImageRegionIterator< InternalImageType > It2( radiusImage, region );
             It1.GoToBegin();
             It2.GoToBegin();
 
+            std::vector< double >::const_iterator wIt = m_VotingWeights.begin();
             while ( !It1.IsAtEnd() )
               {
               indexAtVote = It1.GetIndex();
               distance = 0;
-              d = 0;
               for ( i = 0; i < ImageDimension; i++ )
                 {
-                d += vnl_math_sqr(
-                  static_cast<double>( indexAtVote[i] - center[i] ) * spacing[i] );
                 distance += vnl_math_sqr(
                   static_cast<InputCoordType>( indexAtVote[i] - index[i] ) * spacing[i] );
                 }
-              d = vcl_sqrt( d );
               distance = vcl_sqrt( distance );
 
               // Apply a normal distribution weight;
-              weight = GaussianFunction->EvaluatePDF( d, 0, averageRadius2 );
+              weight = *wIt;
               It1.Set( It1.Get() + weight );
               It2.Set( It2.Get() + distance*weight );
               ++It1;
               ++It2;
+              ++wIt;
               }
             }
           } // end counter
@@ -322,13 +418,44 @@ HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
   InternalImagePointer postProcessImage = gaussianFilter->GetOutput();
   InternalSpacingType spacing = postProcessImage->GetSpacing();
   InternalSizeType size = postProcessImage->GetRequestedRegion().GetSize();
+  InternalRegionType fineRegion = postProcessImage->GetLargestPossibleRegion();
+
+  // Coarse level of the search: the maximum of each block of the blurred
+  // accumulator.  The maxima are found on the coarse level and only the
+  // winning block is scanned at full resolution.  After a sphere is
+  // removed, only the blocks it overlaps are updated.
+  InternalSizeType blockSize;
+  InternalRegionType coarseRegion;
+  InternalSizeType coarseSize;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    blockSize[i] = vnl_math_min( static_cast<InternalSizeValueType>(
+      m_SearchBlockSize ), fineRegion.GetSize()[i] );
+    blockSize[i] = vnl_math_max( blockSize[i],
+      static_cast<InternalSizeValueType>( 1 ) );
+    coarseSize[i] = ( fineRegion.GetSize()[i] + blockSize[i] - 1 ) / blockSize[i];
+    }
+  coarseRegion.SetSize( coarseSize );
+
+  InternalImagePointer coarseImage = InternalImageType::New();
+  coarseImage->SetRegions( coarseRegion );
+  coarseImage->Allocate();
+
+  InternalIndexType idx;
+  ImageRegionIteratorWithIndex< InternalImageType >
+    coarseIt( coarseImage, coarseRegion );
+  for ( coarseIt.GoToBegin(); !coarseIt.IsAtEnd(); ++coarseIt )
+    {
+    coarseIt.Set( this->GetBlockMaximum( postProcessImage,
+      this->GetBlockRegion( coarseIt.GetIndex(), blockSize, fineRegion ),
+      idx ) );
+    }
 
   MinMaxCalculatorPointer minMaxCalculator = MinMaxCalculatorType::New();
-  minMaxCalculator->SetImage( postProcessImage );
+  minMaxCalculator->SetImage( coarseImage );
   minMaxCalculator->ComputeMaximum();
 
   InternalPixelType  pmax = minMaxCalculator->GetMaximum();
-  InternalIndexType idx;
   InternalPixelType max;
   InternalRegionType region;
   InternalIndexType start, end;
@@ -343,13 +470,16 @@ HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
     {
     minMaxCalculator->ComputeMaximum();
     max = minMaxCalculator->GetMaximum();
-    idx = minMaxCalculator->GetIndexOfMaximum();
 
     if ( max < m_OutputThreshold * pmax )
       {
       break;
       }
 
+    // Refine the position within the block
+    this->GetBlockMaximum( postProcessImage, this->GetBlockRegion(
+      minMaxCalculator->GetIndexOfMaximum(), blockSize, fineRegion ), idx );
+
     SphereVectorType center;
     for ( i = 0; i < ImageDimension; i++ )
       {
@@ -403,6 +533,32 @@ HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
       ++It;
       }
 
+    // Update the blocks overlapped by the disc
+    InternalRegionType blocks;
+    InternalIndexType blocksStart;
+    InternalSizeType blocksSize;
+    for( i = 0; i < ImageDimension; i++ )
+      {
+      blocksStart[i] = ( start[i] - fineRegion.GetIndex()[i] )
+        / static_cast<InternalIndexValueType>( blockSize[i] );
+      blocksSize[i] = ( end[i] - fineRegion.GetIndex()[i] )
+        / static_cast<InternalIndexValueType>( blockSize[i] )
+        - blocksStart[i] + 1;
+      }
+    blocks.SetIndex( blocksStart );
+    blocks.SetSize( blocksSize );
+    blocks.Crop( coarseRegion );
+
+    ImageRegionIteratorWithIndex< InternalImageType >
+      blockIt( coarseImage, blocks );
+    for ( blockIt.GoToBegin(); !blockIt.IsAtEnd(); ++blockIt )
+      {
+      InternalIndexType blockIdx;
+      blockIt.Set( this->GetBlockMaximum( postProcessImage,
+        this->GetBlockRegion( blockIt.GetIndex(), blockSize, fineRegion ),
+        blockIdx ) );
+      }
+
     ++circles;
     } while(circles < m_NumberOfSpheres);
 
@@ -412,6 +568,47 @@ HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
 }
 
 
+template<class TInputImage, class TOutputImage>
+typename HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>::InternalRegionType
+HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
+::GetBlockRegion( const InternalIndexType & block,
+  const InternalSizeType & blockSize, const InternalRegionType & fineRegion ) const
+{
+  InternalRegionType region;
+  InternalIndexType start;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    start[i] = fineRegion.GetIndex()[i] + block[i] *
+      static_cast<InternalIndexValueType>( blockSize[i] );
+    }
+  region.SetIndex( start );
+  region.SetSize( blockSize );
+  region.Crop( fineRegion );
+  return region;
+}
+
+template<class TInputImage, class TOutputImage>
+typename HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>::InternalPixelType
+HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
+::GetBlockMaximum( const InternalImageType * image,
+  const InternalRegionType & region, InternalIndexType & index ) const
+{
+  ImageRegionConstIteratorWithIndex< InternalImageType > It( image, region );
+  It.GoToBegin();
+  InternalPixelType max = It.Get();
+  index = It.GetIndex();
+  for ( ++It; !It.IsAtEnd(); ++It )
+    {
+    if ( It.Get() > max )
+      {
+      max = It.Get();
+      index = It.GetIndex();
+      }
+    }
+  return max;
+}
+
+
 /** Print Self information */
 template<class TInputImage, class TOutputImage>
 void
@@ -431,6 +628,7 @@ HoughTransformRadialVotingImageFilter< TInputImage, TOutputImage>
   os << "Number Of Spheres: " << m_NumberOfSpheres << std::endl;
   os << "Output Threshold : " << m_OutputThreshold << std::endl;
   os << "Sampling Ratio: " << m_SamplingRatio <<std::endl;
+  os << "Search Block Size: " << m_SearchBlockSize <<std::endl;
   os << "NbOfThreads: " << m_NbOfThreads <<std::endl;
   os << "All Seeds Processed: " << m_AllSeedsProcessed <<std::endl;
 
@@ -0,0 +1,280 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMeasuresCalculator.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMeasuresCalculator_h
+#define __itkLabelMeasuresCalculator_h
+
+#include "itkObject.h"
+
+#include "itkImage.h"
+#include "itkMatrix.h"
+#include "itkMultiThreader.h"
+#include "itkVector.h"
+
+#include <iostream>
+#include <vector>
+
+namespace itk
+{
+
+/** \class LabelMeasuresCalculator
+ * \brief Shape and intensity measures of all the labels of an image.
+ *
+ * The measures replace those of LabelGeometryImageFilter,
+ * LabelStatisticsImageFilter and LabelPerimeterEstimationCalculator, all
+ * the labels being measured in a single traversal of the images.  The
+ * images are cut into slabs along their last dimension, each thread
+ * keeping its own accumulators for every label, and the accumulators of
+ * the threads are combined at the end.  A quick first pass collects the
+ * labels and the range of the intensities of the labeled pixels, which
+ * sets the range of the intensity histograms.
+ *
+ * For each label, the number of pixels, the volume, the centroid, the
+ * bounding box and the principal moments and axes (physical space) are
+ * computed, and the surface area (perimeter in 2-D) is estimated with the
+ * configuration lookup of LabelPerimeterEstimationCalculator over the
+ * 2 x ... x 2 blocks of pixels, the pixels outside the image being
+ * background.  If ComputeOrientedBoundingBoxes is on, the extents of the
+ * labels along their principal axes are computed by a second traversal.
+ *
+ * If an intensity image is set, the minimum, maximum, sum, mean, standard
+ * deviation, skewness, kurtosis (sample cumulants), weighted centroid and,
+ * from a histogram of NumberOfHistogramBins bins, the median, the 5th and
+ * 95th percentiles and the entropy are computed as well.
+ *
+ * WriteCSVTable() writes one line per label, BackgroundValue excepted.
+ *
+ * \sa LabelPerimeterEstimationCalculator
+ */
+template <class TLabelImage,
+  class TIntensityImage = Image<float, TLabelImage::ImageDimension> >
+class ITK_EXPORT LabelMeasuresCalculator : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelMeasuresCalculator                             Self;
+  typedef Object                                              Superclass;
+  typedef SmartPointer<Self>                                  Pointer;
+  typedef SmartPointer<const Self>                            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( LabelMeasuresCalculator, Object );
+
+  /** ImageDimension constants */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+                       TLabelImage::ImageDimension );
+
+  /** Image typedef support. */
+  typedef TLabelImage                                         LabelImageType;
+  typedef TIntensityImage                                     IntensityImageType;
+  typedef typename LabelImageType::PixelType                  LabelType;
+  typedef typename IntensityImageType::PixelType              IntensityPixelType;
+  typedef typename LabelImageType::RegionType                 RegionType;
+  typedef typename RegionType::SizeType                       SizeType;
+  typedef typename RegionType::IndexType                      IndexType;
+  typedef typename LabelImageType::PointType                  PointType;
+
+  /** Other typedef */
+  typedef double                                              RealType;
+  typedef Vector<RealType,
+    itkGetStaticConstMacro( ImageDimension )>                 VectorType;
+  typedef Matrix<RealType, itkGetStaticConstMacro( ImageDimension ),
+    itkGetStaticConstMacro( ImageDimension )>                 MatrixType;
+  typedef std::vector<LabelType>                              LabelsType;
+
+  /** Measures of a label.  The principal moments are the eigenvalues of
+   * the covariance of the physical coordinates of the pixels, in
+   * increasing order, the rows of PrincipalAxes the corresponding
+   * eigenvectors and AxesLength four times the square roots of the
+   * moments.  Eccentricity is sqrt( 1 - smallest / largest moment ) and
+   * Elongation sqrt( largest / smallest moment ), or 0 if the smallest
+   * moment is 0.  Orientation is the angle, in [0, pi), of the largest
+   * principal axis with the first axis in the plane of the first two. */
+  struct LabelMeasuresType
+  {
+    LabelType                                                 Label;
+    SizeValueType                                             NumberOfPixels;
+    RealType                                                  Volume;
+    RealType                                                  SurfaceArea;
+    PointType                                                 Centroid;
+    RegionType                                                BoundingBox;
+    VectorType                                                PrincipalMoments;
+    MatrixType                                                PrincipalAxes;
+    VectorType                                                AxesLength;
+    VectorType                                                OrientedBoundingBoxSize;
+    RealType                                                  Eccentricity;
+    RealType                                                  Elongation;
+    RealType                                                  Orientation;
+
+    RealType                                                  Minimum;
+    RealType                                                  Maximum;
+    RealType                                                  Sum;
+    RealType                                                  Mean;
+    RealType                                                  Sigma;
+    RealType                                                  Skewness;
+    RealType                                                  Kurtosis;
+    RealType                                                  Median;
+    RealType                                                  FifthPercentile;
+    RealType                                                  NinetyFifthPercentile;
+    RealType                                                  Entropy;
+    PointType                                                 WeightedCentroid;
+  };
+
+  /** Set/Get the label image. */
+  void SetLabelImage( const LabelImageType *image )
+    {
+    this->m_LabelImage = image;
+    this->Modified();
+    }
+  const LabelImageType * GetLabelImage() const
+    { return this->m_LabelImage.GetPointer(); }
+
+  /** Set/Get the optional intensity image. */
+  void SetIntensityImage( const IntensityImageType *image )
+    {
+    this->m_IntensityImage = image;
+    this->Modified();
+    }
+  const IntensityImageType * GetIntensityImage() const
+    { return this->m_IntensityImage.GetPointer(); }
+
+  /** Set/Get the label which is not measured. */
+  itkSetMacro( BackgroundValue, LabelType );
+  itkGetConstMacro( BackgroundValue, LabelType );
+
+  /** Set/Get the number of bins of the intensity histograms. */
+  itkSetMacro( NumberOfHistogramBins, unsigned int );
+  itkGetConstMacro( NumberOfHistogramBins, unsigned int );
+
+  /** Set/Get if the oriented bounding boxes are computed. */
+  itkSetMacro( ComputeOrientedBoundingBoxes, bool );
+  itkGetConstMacro( ComputeOrientedBoundingBoxes, bool );
+  itkBooleanMacro( ComputeOrientedBoundingBoxes );
+
+  /** Set/Get the number of threads. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
+  /** Measure all the labels. */
+  void Compute();
+
+  /** Labels found by Compute(), in increasing order. */
+  const LabelsType & GetLabels() const
+    { return this->m_Labels; }
+  bool HasLabel( LabelType label ) const;
+
+  /** Measures of a label found by Compute(). */
+  const LabelMeasuresType & GetMeasures( LabelType label ) const;
+
+  /** Write the measures of all the labels, one line per label preceded by
+   * a header line, the values being separated by the delimiter. */
+  void WriteCSVTable( std::ostream & os, char delimiter = ',' ) const;
+
+protected:
+  LabelMeasuresCalculator();
+  virtual ~LabelMeasuresCalculator() {}
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Sums of a label over the slab of a thread.  The index moments are
+   * relative to the index of the image and the intensity moments to the
+   * histogram minimum, to limit the cancellations. */
+  struct AccumulatorType
+  {
+    SizeValueType                                             NumberOfPixels;
+    IndexType                                                 MinimumIndex;
+    IndexType                                                 MaximumIndex;
+    VectorType                                                IndexSum;
+    MatrixType                                                IndexProductSum;
+    RealType                                                  SurfaceArea;
+    RealType                                                  Minimum;
+    RealType                                                  Maximum;
+    RealType                                                  PowerSums[4];
+    VectorType                                                WeightedIndexSum;
+    std::vector<SizeValueType>                                Histogram;
+    VectorType                                                MinimumProjection;
+    VectorType                                                MaximumProjection;
+  };
+
+  /** Internal structure used for passing the slabs to the threads. */
+  struct MeasuresThreadStruct
+  {
+    Self                                                     *Calculator;
+    std::vector<SizeValueType>                                SlabSlices;
+    std::vector<LabelsType>                                   Labels;
+    std::vector<RealType>                                     Minimum;
+    std::vector<RealType>                                     Maximum;
+    std::vector<std::vector<AccumulatorType> >                Accumulators;
+    std::vector<MatrixType>                                   Projections;
+  };
+
+  /** Static functions used as "callbacks" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ScanThreaderCallback( void *arg );
+  static ITK_THREAD_RETURN_TYPE AccumulateThreaderCallback( void *arg );
+  static ITK_THREAD_RETURN_TYPE ProjectThreaderCallback( void *arg );
+
+  /** Collect the labels and the intensity range of a slab. */
+  void ThreadedScan( MeasuresThreadStruct *str, ThreadIdType threadId );
+
+  /** Accumulate the pixels and the blocks of pixels of a slab. */
+  void ThreadedAccumulate( MeasuresThreadStruct *str, ThreadIdType threadId );
+
+  /** Project the pixels of a slab on the principal axes. */
+  void ThreadedProject( MeasuresThreadStruct *str, ThreadIdType threadId );
+
+  /** Index of a label in m_Labels, the previous one being tried first. */
+  SizeValueType GetLabelIndex( LabelType label, LabelType & lastLabel,
+    SizeValueType & lastIndex ) const;
+
+  /** Contribution to the surface area of each configuration of a block,
+   * the bit j being the pixel offset by ( j & 1, ( j >> 1 ) & 1, ... ). */
+  void ComputeSurfaceContributions();
+
+  /** Quantile of a histogram, interpolated in the bin. */
+  RealType GetHistogramQuantile( const std::vector<SizeValueType> & histogram,
+    SizeValueType total, RealType p ) const;
+
+private:
+  LabelMeasuresCalculator( const Self & ); //purposely not implemented
+  void operator=( const Self & ); //purposely not implemented
+
+  typename LabelImageType::ConstPointer                       m_LabelImage;
+  typename IntensityImageType::ConstPointer                   m_IntensityImage;
+
+  LabelType                                                   m_BackgroundValue;
+  unsigned int                                                m_NumberOfHistogramBins;
+  bool                                                        m_ComputeOrientedBoundingBoxes;
+
+  MultiThreader::Pointer                                      m_MultiThreader;
+  unsigned int                                                m_NumberOfThreads;
+
+  RealType                                                    m_HistogramMinimum;
+  RealType                                                    m_HistogramMaximum;
+  std::vector<RealType>                                       m_SurfaceContributions;
+
+  LabelsType                                                  m_Labels;
+  std::vector<LabelMeasuresType>                              m_Measures;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelMeasuresCalculator.hxx"
+#endif
+
+#endif
@@ -0,0 +1,992 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMeasuresCalculator.hxx,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMeasuresCalculator_hxx
+#define __itkLabelMeasuresCalculator_hxx
+
+#include "itkLabelMeasuresCalculator.h"
+
+#include "itkContinuousIndex.h"
+
+#include "vnl/vnl_math.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+
+#include <algorithm>
+#include <set>
+
+namespace itk
+{
+
+template <class TLabelImage, class TIntensityImage>
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::LabelMeasuresCalculator()
+{
+  this->m_LabelImage = NULL;
+  this->m_IntensityImage = NULL;
+
+  this->m_BackgroundValue = NumericTraits<LabelType>::Zero;
+  this->m_NumberOfHistogramBins = 200;
+  this->m_ComputeOrientedBoundingBoxes = false;
+
+  this->m_MultiThreader = MultiThreader::New();
+  this->m_NumberOfThreads = this->m_MultiThreader->GetNumberOfThreads();
+
+  this->m_HistogramMinimum = 0.0;
+  this->m_HistogramMaximum = 0.0;
+}
+
+template <class TLabelImage, class TIntensityImage>
+void
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::Compute()
+{
+  if ( !this->m_LabelImage )
+    {
+    itkExceptionMacro( << "The label image is not set." );
+    }
+  if ( this->m_IntensityImage && this->m_IntensityImage->GetBufferedRegion()
+    != this->m_LabelImage->GetBufferedRegion() )
+    {
+    itkExceptionMacro( << "The intensity image and the label image do not "
+      << "have the same buffered region." );
+    }
+  if ( this->m_NumberOfHistogramBins == 0 )
+    {
+    itkExceptionMacro( << "The number of histogram bins must be positive." );
+    }
+
+  this->m_Labels.clear();
+  this->m_Measures.clear();
+
+  const RegionType region = this->m_LabelImage->GetBufferedRegion();
+  const SizeValueType numberOfSlices = region.GetSize()[ImageDimension - 1];
+  if ( numberOfSlices == 0 )
+    {
+    return;
+    }
+
+  // The multithreader may clamp the number of threads, and every slab has
+  // to be scanned by a thread which actually runs.
+  this->m_MultiThreader->SetNumberOfThreads( static_cast<ThreadIdType>(
+    vnl_math_max( static_cast<SizeValueType>( 1 ), vnl_math_min(
+    numberOfSlices, static_cast<SizeValueType>( this->m_NumberOfThreads ) ) ) ) );
+  const ThreadIdType numberOfThreads =
+    this->m_MultiThreader->GetNumberOfThreads();
+
+  MeasuresThreadStruct str;
+  str.Calculator = this;
+  str.SlabSlices.resize( numberOfThreads + 1 );
+  for ( ThreadIdType t = 0; t <= numberOfThreads; t++ )
+    {
+    str.SlabSlices[t] = numberOfSlices * t / numberOfThreads;
+    }
+  str.Labels.resize( numberOfThreads );
+  str.Minimum.resize( numberOfThreads, NumericTraits<RealType>::max() );
+  str.Maximum.resize( numberOfThreads, NumericTraits<RealType>::NonpositiveMin() );
+  str.Accumulators.resize( numberOfThreads );
+
+  /**
+   * Collect the labels and the range of the labeled intensities.
+   */
+  this->m_MultiThreader->SetSingleMethod( this->ScanThreaderCallback, &str );
+  this->m_MultiThreader->SingleMethodExecute();
+
+  std::set<LabelType> labels;
+  this->m_HistogramMinimum = NumericTraits<RealType>::max();
+  this->m_HistogramMaximum = NumericTraits<RealType>::NonpositiveMin();
+  for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    labels.insert( str.Labels[t].begin(), str.Labels[t].end() );
+    this->m_HistogramMinimum =
+      vnl_math_min( this->m_HistogramMinimum, str.Minimum[t] );
+    this->m_HistogramMaximum =
+      vnl_math_max( this->m_HistogramMaximum, str.Maximum[t] );
+    }
+  this->m_Labels.assign( labels.begin(), labels.end() );
+  if ( this->m_Labels.empty() )
+    {
+    return;
+    }
+
+  /**
+   * Accumulate the pixels and the blocks of pixels.
+   */
+  this->ComputeSurfaceContributions();
+
+  this->m_MultiThreader->SetNumberOfThreads( numberOfThreads );
+  this->m_MultiThreader->SetSingleMethod(
+    this->AccumulateThreaderCallback, &str );
+  this->m_MultiThreader->SingleMethodExecute();
+
+  /**
+   * Combine the accumulators of the threads.
+   */
+  const SizeValueType numberOfLabels = this->m_Labels.size();
+  std::vector<AccumulatorType> & accumulators = str.Accumulators[0];
+  for ( ThreadIdType t = 1; t < numberOfThreads; t++ )
+    {
+    for ( SizeValueType k = 0; k < numberOfLabels; k++ )
+      {
+      AccumulatorType & a = accumulators[k];
+      const AccumulatorType & b = str.Accumulators[t][k];
+      if ( b.NumberOfPixels == 0 )
+        {
+        a.SurfaceArea += b.SurfaceArea;
+        continue;
+        }
+      a.NumberOfPixels += b.NumberOfPixels;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        a.MinimumIndex[i] = vnl_math_min( a.MinimumIndex[i], b.MinimumIndex[i] );
+        a.MaximumIndex[i] = vnl_math_max( a.MaximumIndex[i], b.MaximumIndex[i] );
+        }
+      a.IndexSum += b.IndexSum;
+      a.IndexProductSum += b.IndexProductSum;
+      a.SurfaceArea += b.SurfaceArea;
+      a.Minimum = vnl_math_min( a.Minimum, b.Minimum );
+      a.Maximum = vnl_math_max( a.Maximum, b.Maximum );
+      for ( unsigned int p = 0; p < 4; p++ )
+        {
+        a.PowerSums[p] += b.PowerSums[p];
+        }
+      a.WeightedIndexSum += b.WeightedIndexSum;
+      for ( unsigned int n = 0; n < a.Histogram.size(); n++ )
+        {
+        a.Histogram[n] += b.Histogram[n];
+        }
+      }
+    std::vector<AccumulatorType>().swap( str.Accumulators[t] );
+    }
+
+  /**
+   * Measures of the labels.
+   */
+  const LabelImageType *image = this->m_LabelImage;
+
+  RealType pixelVolume = 1.0;
+  vnl_matrix<RealType> indexToPhysical( ImageDimension, ImageDimension );
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    pixelVolume *= image->GetSpacing()[i];
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      indexToPhysical( i, j ) =
+        image->GetDirection()[i][j] * image->GetSpacing()[j];
+      }
+    }
+  const RealType binWidth = ( this->m_HistogramMaximum - this->m_HistogramMinimum )
+    / static_cast<RealType>( this->m_NumberOfHistogramBins );
+
+  this->m_Measures.resize( numberOfLabels );
+  str.Projections.resize( numberOfLabels );
+  for ( SizeValueType k = 0; k < numberOfLabels; k++ )
+    {
+    const AccumulatorType & a = accumulators[k];
+    LabelMeasuresType & measures = this->m_Measures[k];
+    const RealType N = static_cast<RealType>( a.NumberOfPixels );
+
+    measures.Label = this->m_Labels[k];
+    measures.NumberOfPixels = a.NumberOfPixels;
+    measures.Volume = N * pixelVolume;
+    measures.SurfaceArea = a.SurfaceArea;
+
+    IndexType index;
+    SizeType size;
+    ContinuousIndex<RealType, ImageDimension> centroid;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      index[i] = region.GetIndex()[i] + a.MinimumIndex[i];
+      size[i] = a.MaximumIndex[i] - a.MinimumIndex[i] + 1;
+      centroid[i] = static_cast<RealType>( region.GetIndex()[i] )
+        + a.IndexSum[i] / N;
+      }
+    measures.BoundingBox.SetIndex( index );
+    measures.BoundingBox.SetSize( size );
+    image->TransformContinuousIndexToPhysicalPoint( centroid,
+      measures.Centroid );
+
+    vnl_matrix<RealType> covariance( ImageDimension, ImageDimension );
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      for ( unsigned int j = 0; j <= i; j++ )
+        {
+        covariance( i, j ) = a.IndexProductSum[i][j] / N
+          - a.IndexSum[i] * a.IndexSum[j] / ( N * N );
+        covariance( j, i ) = covariance( i, j );
+        }
+      }
+    vnl_symmetric_eigensystem<RealType> eig( indexToPhysical * covariance
+      * indexToPhysical.transpose() );
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      measures.PrincipalMoments[i] = vnl_math_max( eig.get_eigenvalue( i ),
+        static_cast<RealType>( 0.0 ) );
+      measures.AxesLength[i] = 4.0 * vcl_sqrt( measures.PrincipalMoments[i] );
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        measures.PrincipalAxes[i][j] = eig.get_eigenvector( i )[j];
+        }
+      }
+    const RealType smallest = measures.PrincipalMoments[0];
+    const RealType largest = measures.PrincipalMoments[ImageDimension - 1];
+    measures.Eccentricity = ( largest > 0.0 )
+      ? vcl_sqrt( 1.0 - smallest / largest ) : 0.0;
+    measures.Elongation = ( smallest > 0.0 )
+      ? vcl_sqrt( largest / smallest ) : 0.0;
+    measures.Orientation = vcl_atan2(
+      measures.PrincipalAxes[ImageDimension - 1][1],
+      measures.PrincipalAxes[ImageDimension - 1][0] );
+    if ( measures.Orientation < 0.0 )
+      {
+      measures.Orientation += vnl_math::pi;
+      }
+    measures.OrientedBoundingBoxSize.Fill( 0.0 );
+
+    /**
+     * Projections of the index offsets on the principal axes.
+     */
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        str.Projections[k][i][j] = 0.0;
+        for ( unsigned int m = 0; m < ImageDimension; m++ )
+          {
+          str.Projections[k][i][j] +=
+            measures.PrincipalAxes[i][m] * indexToPhysical( m, j );
+          }
+        }
+      }
+
+    measures.Minimum = 0.0;
+    measures.Maximum = 0.0;
+    measures.Sum = 0.0;
+    measures.Mean = 0.0;
+    measures.Sigma = 0.0;
+    measures.Skewness = 0.0;
+    measures.Kurtosis = 0.0;
+    measures.Median = 0.0;
+    measures.FifthPercentile = 0.0;
+    measures.NinetyFifthPercentile = 0.0;
+    measures.Entropy = 0.0;
+    measures.WeightedCentroid = measures.Centroid;
+    if ( !this->m_IntensityImage )
+      {
+      continue;
+      }
+
+    /**
+     * Central moments from the power sums about the histogram minimum and
+     * the sample cumulants k2, k3 and k4.
+     */
+    const RealType shift = this->m_HistogramMinimum;
+    const RealType s1 = a.PowerSums[0] / N;
+    const RealType s2 = a.PowerSums[1] / N;
+    const RealType s3 = a.PowerSums[2] / N;
+    const RealType s4 = a.PowerSums[3] / N;
+    const RealType m2 = vnl_math_max( static_cast<RealType>( 0.0 ),
+      s2 - s1 * s1 );
+    const RealType m3 = s3 - 3.0 * s1 * s2 + 2.0 * s1 * s1 * s1;
+    const RealType m4 = s4 - 4.0 * s1 * s3 + 6.0 * s1 * s1 * s2
+      - 3.0 * s1 * s1 * s1 * s1;
+
+    measures.Minimum = a.Minimum;
+    measures.Maximum = a.Maximum;
+    measures.Mean = shift + s1;
+    measures.Sum = N * measures.Mean;
+    if ( N > 1.0 )
+      {
+      const RealType k2 = N / ( N - 1.0 ) * m2;
+      measures.Sigma = vcl_sqrt( k2 );
+      if ( N > 3.0 && k2 > 0.0 )
+        {
+        const RealType k3 = N * N / ( ( N - 1.0 ) * ( N - 2.0 ) ) * m3;
+        const RealType k4 = N * N / ( ( N - 1.0 ) * ( N - 2.0 ) * ( N - 3.0 ) )
+          * ( ( N + 1.0 ) * m4 - 3.0 * ( N - 1.0 ) * m2 * m2 );
+        measures.Skewness = k3 / vcl_sqrt( k2 * k2 * k2 );
+        measures.Kurtosis = k4 / ( k2 * k2 );
+        }
+      }
+
+    measures.Median = this->GetHistogramQuantile( a.Histogram,
+      a.NumberOfPixels, 0.5 );
+    measures.FifthPercentile = this->GetHistogramQuantile( a.Histogram,
+      a.NumberOfPixels, 0.05 );
+    measures.NinetyFifthPercentile = this->GetHistogramQuantile( a.Histogram,
+      a.NumberOfPixels, 0.95 );
+    for ( unsigned int n = 0; n < a.Histogram.size(); n++ )
+      {
+      const RealType p = static_cast<RealType>( a.Histogram[n] ) / N;
+      if ( p > 0.0 )
+        {
+        measures.Entropy -= p * vcl_log( p ) / vcl_log( 2.0 );
+        }
+      }
+    if ( binWidth == 0.0 )
+      {
+      measures.Median = measures.FifthPercentile =
+        measures.NinetyFifthPercentile = measures.Mean;
+      }
+
+    if ( measures.Sum != 0.0 )
+      {
+      ContinuousIndex<RealType, ImageDimension> weightedCentroid;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        weightedCentroid[i] = static_cast<RealType>( region.GetIndex()[i] )
+          + a.WeightedIndexSum[i] / measures.Sum;
+        }
+      image->TransformContinuousIndexToPhysicalPoint( weightedCentroid,
+        measures.WeightedCentroid );
+      }
+    }
+
+  /**
+   * The oriented bounding boxes need the principal axes.
+   */
+  if ( this->m_ComputeOrientedBoundingBoxes )
+    {
+    this->m_MultiThreader->SetNumberOfThreads( numberOfThreads );
+    this->m_MultiThreader->SetSingleMethod(
+      this->ProjectThreaderCallback, &str );
+    this->m_MultiThreader->SingleMethodExecute();
+
+    for ( SizeValueType k = 0; k < numberOfLabels; k++ )
+      {
+      VectorType minimum = str.Accumulators[0][k].MinimumProjection;
+      VectorType maximum = str.Accumulators[0][k].MaximumProjection;
+      for ( ThreadIdType t = 1; t < numberOfThreads; t++ )
+        {
+        for ( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+          minimum[i] = vnl_math_min( minimum[i],
+            str.Accumulators[t][k].MinimumProjection[i] );
+          maximum[i] = vnl_math_max( maximum[i],
+            str.Accumulators[t][k].MaximumProjection[i] );
+          }
+        }
+      this->m_Measures[k].OrientedBoundingBoxSize = maximum - minimum;
+      }
+    }
+}
+
+template <class TLabelImage, class TIntensityImage>
+ITK_THREAD_RETURN_TYPE
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::ScanThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  MeasuresThreadStruct *str =
+    static_cast<MeasuresThreadStruct *>( info->UserData );
+
+  if ( info->ThreadID + 1 < str->SlabSlices.size() )
+    {
+    str->Calculator->ThreadedScan( str, info->ThreadID );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TLabelImage, class TIntensityImage>
+ITK_THREAD_RETURN_TYPE
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::AccumulateThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  MeasuresThreadStruct *str =
+    static_cast<MeasuresThreadStruct *>( info->UserData );
+
+  if ( info->ThreadID + 1 < str->SlabSlices.size() )
+    {
+    str->Calculator->ThreadedAccumulate( str, info->ThreadID );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TLabelImage, class TIntensityImage>
+ITK_THREAD_RETURN_TYPE
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::ProjectThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  MeasuresThreadStruct *str =
+    static_cast<MeasuresThreadStruct *>( info->UserData );
+
+  if ( info->ThreadID + 1 < str->SlabSlices.size() )
+    {
+    str->Calculator->ThreadedProject( str, info->ThreadID );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TLabelImage, class TIntensityImage>
+void
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::ThreadedScan( MeasuresThreadStruct *str, ThreadIdType threadId )
+{
+  const SizeValueType sliceSize =
+    this->m_LabelImage->GetBufferedRegion().GetNumberOfPixels()
+    / this->m_LabelImage->GetBufferedRegion().GetSize()[ImageDimension - 1];
+  const SizeValueType first = str->SlabSlices[threadId] * sliceSize;
+  const SizeValueType last = str->SlabSlices[threadId + 1] * sliceSize;
+
+  const LabelType *labels = this->m_LabelImage->GetBufferPointer();
+  const IntensityPixelType *intensities = this->m_IntensityImage
+    ? this->m_IntensityImage->GetBufferPointer() : NULL;
+
+  /**
+   * The labels come in runs, so only the changes are looked up.
+   */
+  std::set<LabelType> found;
+  LabelType lastLabel = this->m_BackgroundValue;
+  RealType minimum = NumericTraits<RealType>::max();
+  RealType maximum = NumericTraits<RealType>::NonpositiveMin();
+  for ( SizeValueType n = first; n < last; n++ )
+    {
+    const LabelType label = labels[n];
+    if ( label == this->m_BackgroundValue )
+      {
+      continue;
+      }
+    if ( label != lastLabel )
+      {
+      found.insert( label );
+      lastLabel = label;
+      }
+    if ( intensities )
+      {
+      const RealType value = static_cast<RealType>( intensities[n] );
+      minimum = vnl_math_min( minimum, value );
+      maximum = vnl_math_max( maximum, value );
+      }
+    }
+  str->Labels[threadId].assign( found.begin(), found.end() );
+  str->Minimum[threadId] = minimum;
+  str->Maximum[threadId] = maximum;
+}
+
+template <class TLabelImage, class TIntensityImage>
+void
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::ThreadedAccumulate( MeasuresThreadStruct *str, ThreadIdType threadId )
+{
+  const SizeType size = this->m_LabelImage->GetBufferedRegion().GetSize();
+  const SizeValueType sliceSize =
+    this->m_LabelImage->GetBufferedRegion().GetNumberOfPixels()
+    / size[ImageDimension - 1];
+  const SizeValueType first = str->SlabSlices[threadId] * sliceSize;
+  const SizeValueType last = str->SlabSlices[threadId + 1] * sliceSize;
+
+  const LabelType *labels = this->m_LabelImage->GetBufferPointer();
+  const IntensityPixelType *intensities = this->m_IntensityImage
+    ? this->m_IntensityImage->GetBufferPointer() : NULL;
+
+  AccumulatorType initial;
+  initial.NumberOfPixels = 0;
+  initial.MinimumIndex.Fill( NumericTraits<IndexValueType>::max() );
+  initial.MaximumIndex.Fill( NumericTraits<IndexValueType>::NonpositiveMin() );
+  initial.IndexSum.Fill( 0.0 );
+  initial.IndexProductSum.Fill( 0.0 );
+  initial.SurfaceArea = 0.0;
+  initial.Minimum = NumericTraits<RealType>::max();
+  initial.Maximum = NumericTraits<RealType>::NonpositiveMin();
+  for ( unsigned int p = 0; p < 4; p++ )
+    {
+    initial.PowerSums[p] = 0.0;
+    }
+  initial.WeightedIndexSum.Fill( 0.0 );
+  if ( intensities )
+    {
+    initial.Histogram.resize( this->m_NumberOfHistogramBins, 0 );
+    }
+  initial.MinimumProjection.Fill( NumericTraits<RealType>::max() );
+  initial.MaximumProjection.Fill( NumericTraits<RealType>::NonpositiveMin() );
+
+  std::vector<AccumulatorType> & accumulators = str->Accumulators[threadId];
+  accumulators.assign( this->m_Labels.size(), initial );
+
+  const RealType shift = this->m_HistogramMinimum;
+  const RealType binScale =
+    ( this->m_HistogramMaximum > this->m_HistogramMinimum )
+    ? static_cast<RealType>( this->m_NumberOfHistogramBins )
+      / ( this->m_HistogramMaximum - this->m_HistogramMinimum ) : 0.0;
+  const SizeValueType lastBin = this->m_NumberOfHistogramBins - 1;
+
+  LabelType lastLabel = this->m_Labels[0];
+  SizeValueType lastIndex = 0;
+
+  /**
+   * Pixels of the slab.
+   */
+  IndexType index;
+  index.Fill( 0 );
+  index[ImageDimension - 1] = str->SlabSlices[threadId];
+  for ( SizeValueType n = first; n < last; n++ )
+    {
+    const LabelType label = labels[n];
+    if ( label != this->m_BackgroundValue )
+      {
+      AccumulatorType & a = accumulators[
+        this->GetLabelIndex( label, lastLabel, lastIndex )];
+
+      a.NumberOfPixels++;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        const RealType x = static_cast<RealType>( index[i] );
+        a.IndexSum[i] += x;
+        for ( unsigned int j = 0; j <= i; j++ )
+          {
+          a.IndexProductSum[i][j] += x * static_cast<RealType>( index[j] );
+          }
+        a.MinimumIndex[i] = vnl_math_min( a.MinimumIndex[i], index[i] );
+        a.MaximumIndex[i] = vnl_math_max( a.MaximumIndex[i], index[i] );
+        }
+
+      if ( intensities )
+        {
+        const RealType value = static_cast<RealType>( intensities[n] );
+        const RealType d = value - shift;
+        const RealType d2 = d * d;
+        a.PowerSums[0] += d;
+        a.PowerSums[1] += d2;
+        a.PowerSums[2] += d2 * d;
+        a.PowerSums[3] += d2 * d2;
+        a.Minimum = vnl_math_min( a.Minimum, value );
+        a.Maximum = vnl_math_max( a.Maximum, value );
+        a.Histogram[vnl_math_min( static_cast<SizeValueType>( d * binScale ),
+          lastBin )]++;
+        for ( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+          a.WeightedIndexSum[i] += value * static_cast<RealType>( index[i] );
+          }
+        }
+      }
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      if ( ++index[i] < static_cast<IndexValueType>( size[i] ) )
+        {
+        break;
+        }
+      index[i] = 0;
+      }
+    }
+
+  /**
+   * Blocks of 2 x ... x 2 pixels whose first corner is in the slab (or one
+   * slice before the image for the first slab).  The pixels outside the
+   * image are background.
+   */
+  const unsigned int numberOfCorners = 1 << ImageDimension;
+  OffsetValueType strides[ImageDimension];
+  strides[0] = 1;
+  for ( unsigned int i = 1; i < ImageDimension; i++ )
+    {
+    strides[i] = strides[i - 1] * static_cast<OffsetValueType>( size[i - 1] );
+    }
+  std::vector<OffsetValueType> cornerOffsets( numberOfCorners, 0 );
+  for ( unsigned int j = 0; j < numberOfCorners; j++ )
+    {
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      if ( j & ( 1 << i ) )
+        {
+        cornerOffsets[j] += strides[i];
+        }
+      }
+    }
+  std::vector<LabelType> values( numberOfCorners );
+  const unsigned int fullConfiguration = ( 1 << numberOfCorners ) - 1;
+
+  IndexType corner;
+  corner.Fill( -1 );
+  corner[ImageDimension - 1] = ( threadId == 0 ) ? -1
+    : static_cast<IndexValueType>( str->SlabSlices[threadId] );
+  const IndexValueType lastCorner =
+    static_cast<IndexValueType>( str->SlabSlices[threadId + 1] );
+
+  while ( corner[ImageDimension - 1] < lastCorner )
+    {
+    OffsetValueType offset = 0;
+    bool isInside = true;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      offset += corner[i] * strides[i];
+      if ( corner[i] < 0 ||
+        corner[i] + 1 >= static_cast<IndexValueType>( size[i] ) )
+        {
+        isInside = false;
+        }
+      }
+
+    bool isUniform = true;
+    for ( unsigned int j = 0; j < numberOfCorners; j++ )
+      {
+      bool isPixelInside = isInside;
+      if ( !isInside )
+        {
+        isPixelInside = true;
+        for ( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+          const IndexValueType x = corner[i] + ( ( j >> i ) & 1 );
+          if ( x < 0 || x >= static_cast<IndexValueType>( size[i] ) )
+            {
+            isPixelInside = false;
+            break;
+            }
+          }
+        }
+      values[j] = isPixelInside ? labels[offset + cornerOffsets[j]]
+        : this->m_BackgroundValue;
+      if ( values[j] != values[0] )
+        {
+        isUniform = false;
+        }
+      }
+
+    if ( !isUniform )
+      {
+      for ( unsigned int j = 0; j < numberOfCorners; j++ )
+        {
+        const LabelType label = values[j];
+        bool isDone = ( label == this->m_BackgroundValue );
+        for ( unsigned int m = 0; m < j && !isDone; m++ )
+          {
+          isDone = ( values[m] == label );
+          }
+        if ( isDone )
+          {
+          continue;
+          }
+        unsigned int configuration = 0;
+        for ( unsigned int m = j; m < numberOfCorners; m++ )
+          {
+          if ( values[m] == label )
+            {
+            configuration |= ( 1 << m );
+            }
+          }
+        if ( configuration != fullConfiguration )
+          {
+          accumulators[this->GetLabelIndex( label, lastLabel, lastIndex )]
+            .SurfaceArea += this->m_SurfaceContributions[configuration];
+          }
+        }
+      }
+
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      if ( ++corner[i] < static_cast<IndexValueType>( size[i] ) ||
+        i == ImageDimension - 1 )
+        {
+        break;
+        }
+      corner[i] = -1;
+      }
+    }
+}
+
+template <class TLabelImage, class TIntensityImage>
+void
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::ThreadedProject( MeasuresThreadStruct *str, ThreadIdType threadId )
+{
+  const SizeType size = this->m_LabelImage->GetBufferedRegion().GetSize();
+  const SizeValueType sliceSize =
+    this->m_LabelImage->GetBufferedRegion().GetNumberOfPixels()
+    / size[ImageDimension - 1];
+  const SizeValueType first = str->SlabSlices[threadId] * sliceSize;
+  const SizeValueType last = str->SlabSlices[threadId + 1] * sliceSize;
+
+  const LabelType *labels = this->m_LabelImage->GetBufferPointer();
+
+  std::vector<AccumulatorType> & accumulators = str->Accumulators[threadId];
+  if ( threadId > 0 )
+    {
+    accumulators.resize( this->m_Labels.size() );
+    }
+  for ( SizeValueType k = 0; k < accumulators.size(); k++ )
+    {
+    accumulators[k].MinimumProjection.Fill( NumericTraits<RealType>::max() );
+    accumulators[k].MaximumProjection.Fill(
+      NumericTraits<RealType>::NonpositiveMin() );
+    }
+
+  LabelType lastLabel = this->m_Labels[0];
+  SizeValueType lastIndex = 0;
+
+  IndexType index;
+  index.Fill( 0 );
+  index[ImageDimension - 1] = str->SlabSlices[threadId];
+  for ( SizeValueType n = first; n < last; n++ )
+    {
+    const LabelType label = labels[n];
+    if ( label != this->m_BackgroundValue )
+      {
+      const SizeValueType k = this->GetLabelIndex( label, lastLabel, lastIndex );
+      const MatrixType & projection = str->Projections[k];
+      AccumulatorType & a = accumulators[k];
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        RealType x = 0.0;
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+          x += projection[i][j] * static_cast<RealType>( index[j] );
+          }
+        a.MinimumProjection[i] = vnl_math_min( a.MinimumProjection[i], x );
+        a.MaximumProjection[i] = vnl_math_max( a.MaximumProjection[i], x );
+        }
+      }
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      if ( ++index[i] < static_cast<IndexValueType>( size[i] ) )
+        {
+        break;
+        }
+      index[i] = 0;
+      }
+    }
+}
+
+template <class TLabelImage, class TIntensityImage>
+SizeValueType
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::GetLabelIndex( LabelType label, LabelType & lastLabel,
+  SizeValueType & lastIndex ) const
+{
+  if ( label != lastLabel )
+    {
+    lastIndex = std::lower_bound( this->m_Labels.begin(),
+      this->m_Labels.end(), label ) - this->m_Labels.begin();
+    lastLabel = label;
+    }
+  return lastIndex;
+}
+
+template <class TLabelImage, class TIntensityImage>
+void
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::ComputeSurfaceContributions()
+{
+  const LabelImageType *image = this->m_LabelImage;
+
+  RealType pixelVolume = 1.0;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    pixelVolume *= image->GetSpacing()[i];
+    }
+
+  /**
+   * Each pixel of the configuration contributes half of its faces which
+   * are not shared with another pixel of the configuration, as in
+   * LabelPerimeterEstimationCalculator.
+   */
+  const unsigned int numberOfCorners = 1 << ImageDimension;
+  const unsigned int numberOfConfigurations = 1 << numberOfCorners;
+  this->m_SurfaceContributions.assign( numberOfConfigurations, 0.0 );
+  for ( unsigned int c = 0; c < numberOfConfigurations; c++ )
+    {
+    for ( unsigned int j = 0; j < numberOfCorners; j++ )
+      {
+      if ( !( c & ( 1 << j ) ) )
+        {
+        continue;
+        }
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        if ( !( c & ( 1 << ( j ^ ( 1 << i ) ) ) ) )
+          {
+          this->m_SurfaceContributions[c] +=
+            pixelVolume / image->GetSpacing()[i] / 2.0;
+          }
+        }
+      }
+    this->m_SurfaceContributions[c] /= static_cast<RealType>( ImageDimension );
+    }
+}
+
+template <class TLabelImage, class TIntensityImage>
+typename LabelMeasuresCalculator<TLabelImage, TIntensityImage>::RealType
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::GetHistogramQuantile( const std::vector<SizeValueType> & histogram,
+  SizeValueType total, RealType p ) const
+{
+  const RealType binWidth = ( this->m_HistogramMaximum - this->m_HistogramMinimum )
+    / static_cast<RealType>( histogram.size() );
+  const RealType target = p * static_cast<RealType>( total );
+
+  RealType cumulative = 0.0;
+  for ( unsigned int n = 0; n < histogram.size(); n++ )
+    {
+    const RealType frequency = static_cast<RealType>( histogram[n] );
+    if ( frequency > 0.0 && cumulative + frequency >= target )
+      {
+      return this->m_HistogramMinimum + binWidth * ( static_cast<RealType>( n )
+        + ( target - cumulative ) / frequency );
+      }
+    cumulative += frequency;
+    }
+  return this->m_HistogramMaximum;
+}
+
+template <class TLabelImage, class TIntensityImage>
+bool
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::HasLabel( LabelType label ) const
+{
+  return std::binary_search( this->m_Labels.begin(), this->m_Labels.end(),
+    label );
+}
+
+template <class TLabelImage, class TIntensityImage>
+const typename LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+  ::LabelMeasuresType &
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::GetMeasures( LabelType label ) const
+{
+  typename LabelsType::const_iterator it = std::lower_bound(
+    this->m_Labels.begin(), this->m_Labels.end(), label );
+  if ( it == this->m_Labels.end() || *it != label )
+    {
+    itkExceptionMacro( << "Unknown label: "
+      << static_cast<typename NumericTraits<LabelType>::PrintType>( label ) );
+    }
+  return this->m_Measures[it - this->m_Labels.begin()];
+}
+
+template <class TLabelImage, class TIntensityImage>
+void
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::WriteCSVTable( std::ostream & os, char delimiter ) const
+{
+  os << "Label" << delimiter << "NumberOfPixels" << delimiter << "Volume"
+     << delimiter << "SurfaceArea";
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    os << delimiter << "Centroid" << i;
+    }
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    os << delimiter << "BoundingBoxIndex" << i;
+    }
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    os << delimiter << "BoundingBoxSize" << i;
+    }
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    os << delimiter << "AxisLength" << i;
+    }
+  os << delimiter << "Eccentricity" << delimiter << "Elongation"
+     << delimiter << "Orientation";
+  if ( this->m_ComputeOrientedBoundingBoxes )
+    {
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      os << delimiter << "OrientedBoundingBoxSize" << i;
+      }
+    }
+  if ( this->m_IntensityImage )
+    {
+    os << delimiter << "Mean" << delimiter << "Sigma" << delimiter
+       << "Skewness" << delimiter << "Kurtosis" << delimiter << "Entropy"
+       << delimiter << "Sum" << delimiter << "Minimum" << delimiter
+       << "Maximum" << delimiter << "Median" << delimiter << "5th%"
+       << delimiter << "95th%";
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      os << delimiter << "WeightedCentroid" << i;
+      }
+    }
+  os << std::endl;
+
+  for ( SizeValueType k = 0; k < this->m_Measures.size(); k++ )
+    {
+    const LabelMeasuresType & measures = this->m_Measures[k];
+
+    os << static_cast<typename NumericTraits<LabelType>::PrintType>(
+      measures.Label ) << delimiter << measures.NumberOfPixels << delimiter
+       << measures.Volume << delimiter << measures.SurfaceArea;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      os << delimiter << measures.Centroid[i];
+      }
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      os << delimiter << measures.BoundingBox.GetIndex()[i];
+      }
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      os << delimiter << measures.BoundingBox.GetSize()[i];
+      }
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      os << delimiter << measures.AxesLength[i];
+      }
+    os << delimiter << measures.Eccentricity << delimiter
+       << measures.Elongation << delimiter << measures.Orientation;
+    if ( this->m_ComputeOrientedBoundingBoxes )
+      {
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        os << delimiter << measures.OrientedBoundingBoxSize[i];
+        }
+      }
+    if ( this->m_IntensityImage )
+      {
+      os << delimiter << measures.Mean << delimiter << measures.Sigma
+         << delimiter << measures.Skewness << delimiter << measures.Kurtosis
+         << delimiter << measures.Entropy << delimiter << measures.Sum
+         << delimiter << measures.Minimum << delimiter << measures.Maximum
+         << delimiter << measures.Median << delimiter
+         << measures.FifthPercentile << delimiter
+         << measures.NinetyFifthPercentile;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        os << delimiter << measures.WeightedCentroid[i];
+        }
+      }
+    os << std::endl;
+    }
+}
+
+template <class TLabelImage, class TIntensityImage>
+void
+LabelMeasuresCalculator<TLabelImage, TIntensityImage>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Background value: "
+     << static_cast<typename NumericTraits<LabelType>::PrintType>(
+       this->m_BackgroundValue ) << std::endl;
+  os << indent << "Number of histogram bins: "
+     << this->m_NumberOfHistogramBins << std::endl;
+  os << indent << "Compute oriented bounding boxes: "
+     << this->m_ComputeOrientedBoundingBoxes << std::endl;
+  os << indent << "Number of threads: " << this->m_NumberOfThreads
+     << std::endl;
+  os << indent << "Number of labels: " << this->m_Labels.size() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
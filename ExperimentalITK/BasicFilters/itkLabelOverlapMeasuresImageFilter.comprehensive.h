@@ -29,6 +29,16 @@ namespace itk {
  * \brief Computes overlap measures between the set same set of labels of
  * pixels of two images.  Background is assumed to be 0.
  *
+ * The surface voxels of all the labels of both images are extracted once.
+ * The surface distances of a label (Hausdorff, percentile Hausdorff and
+ * contour mean distances) are then computed from exact distance maps of
+ * its source and target surfaces restricted to the bounding box of the
+ * label in both images, which contains all the voxels the measures are
+ * evaluated at.  The labels are distributed over the threads.  As with
+ * DirectedHausdorffDistanceImageFilter and
+ * ContourDirectedMeanDistanceImageFilter, the distances are in pixel units
+ * unless UseImageSpacing is on.
+ *
  * \sa LabelOverlapMeasuresImageFilter
  *
  * \ingroup MultiThreaded
@@ -90,6 +100,8 @@ public:
       m_DirectedContourMeanDistance = 0.0;
       m_HausdorffDistance = 0.0;
       m_DirectedHausdorffDistance = 0.0;
+      m_PercentileHausdorffDistance = 0.0;
+      m_DirectedPercentileHausdorffDistance = 0.0;
       }
 
   // added for completeness
@@ -113,6 +125,10 @@ public:
       m_DirectedContourMeanDistance = l.m_DirectedContourMeanDistance;
       m_HausdorffDistance = l.m_HausdorffDistance;
       m_DirectedHausdorffDistance = l.m_DirectedHausdorffDistance;
+      m_PercentileHausdorffDistance = l.m_PercentileHausdorffDistance;
+      m_DirectedPercentileHausdorffDistance =
+        l.m_DirectedPercentileHausdorffDistance;
+      return *this;
       }
 
     unsigned long m_VolumeSource;
@@ -133,6 +149,8 @@ public:
     RealType m_DirectedContourMeanDistance;
     RealType m_HausdorffDistance;
     RealType m_DirectedHausdorffDistance;
+    RealType m_PercentileHausdorffDistance;
+    RealType m_DirectedPercentileHausdorffDistance;
     };
 
   /** Type of the map used to store data per label */
@@ -160,6 +178,17 @@ public:
   const LabelImageType * GetTargetImage( void )
     { return this->GetInput( 1 ); }
 
+  /** Set/Get the percentile of the surface distances used for the
+   * percentile Hausdorff distances (default 0.95). */
+  itkSetClampMacro( HausdorffPercentile, RealType, 0.0, 1.0 );
+  itkGetConstMacro( HausdorffPercentile, RealType );
+
+  /** Set/Get if the surface distances are in physical units rather than
+   * in pixel units (default false). */
+  itkSetMacro( UseImageSpacing, bool );
+  itkGetConstMacro( UseImageSpacing, bool );
+  itkBooleanMacro( UseImageSpacing );
+
   /** Get the label set measures */
   MapType GetLabelSetMeasures()
     { return this->m_LabelSetMeasures; }
@@ -221,6 +250,8 @@ public:
   RealType GetVolumeSimilarity( LabelType );
   RealType GetHausdorffDistance( LabelType );
   RealType GetDirectedHausdorffDistance( LabelType );
+  RealType GetPercentileHausdorffDistance( LabelType );
+  RealType GetDirectedPercentileHausdorffDistance( LabelType );
   RealType GetContourMeanDistance( LabelType );
   RealType GetDirectedContourMeanDistance( LabelType );
 
@@ -256,6 +287,30 @@ protected:
   // Override since the filter produces all of its output
   void EnlargeOutputRequestedRegion( DataObject *data );
 
+  /** Internal structure used for passing the labels to the threads. */
+  struct SurfaceDistanceThreadStruct
+  {
+    Self                                   *Filter;
+    std::vector<LabelType>                  Labels;
+    std::vector<RegionType>                 Regions;
+    std::vector<LabelSetMeasures *>         Measures;
+    unsigned long                           NextLabel;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader.  The
+   * threads take the labels one at a time until all are done. */
+  static ITK_THREAD_RETURN_TYPE SurfaceDistanceThreaderCallback( void *arg );
+
+  /** Surface distances of a label within the given region. */
+  void ComputeSurfaceDistances( LabelType, const RegionType &,
+    LabelSetMeasures & );
+
+  /** Squared Euclidean distances, in place, of the buffer of a region of
+   * the given size.  The sites have a zero distance and the other voxels
+   * NumericTraits<RealType>::max(). */
+  void ComputeSquaredDistances( std::vector<RealType> &,
+    const SizeType & ) const;
+
 private:
   LabelOverlapMeasuresImageFilter( const Self& ); //purposely not implemented
   void operator=( const Self& ); //purposely not implemented
@@ -266,6 +321,9 @@ private:
   std::vector<MapType>                            m_LabelSetMeasuresPerThread;
   MapType                                         m_LabelSetMeasures;
 
+  RealType                                        m_HausdorffPercentile;
+  bool                                            m_UseImageSpacing;
+
   SimpleFastMutexLock                             m_Mutex;
 
 }; // end of class
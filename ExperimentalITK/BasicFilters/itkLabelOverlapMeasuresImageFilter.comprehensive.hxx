@@ -19,14 +19,14 @@
 
 #include "itkLabelOverlapMeasuresImageFilter.h"
 
-#include "itkBinaryThresholdImageFilter.h"
-#include "itkContourDirectedMeanDistanceImageFilter.h"
-#include "itkContourMeanDistanceImageFilter.h"
-#include "itkDirectedHausdorffDistanceImageFilter.h"
-#include "itkHausdorffDistanceImageFilter.h"
 #include "itkLabelContourImageFilter.h"
 
 #include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
 
 namespace itk {
 
@@ -45,6 +45,9 @@ LabelOverlapMeasuresImageFilter<TLabelImage>
 {
   // this filter requires two input images
   this->SetNumberOfRequiredInputs( 2 );
+
+  this->m_HausdorffPercentile = 0.95;
+  this->m_UseImageSpacing = false;
 }
 
 template<class TLabelImage>
@@ -175,76 +178,309 @@ LabelOverlapMeasuresImageFilter<TLabelImage>
       } // end of thread map iterator loop
     } // end of thread loop
 
-  // compute the remainder of the overlap measures
-  for( MapIterator mapIt = m_LabelSetMeasures.begin();
-    mapIt != m_LabelSetMeasures.end(); ++mapIt )
-    {
-    LabelType label = (*mapIt).first;
-
-    typedef BinaryThresholdImageFilter<LabelImageType, LabelImageType>
-      ThresholderType;
-    typename ThresholderType::Pointer sourceThresholder =
-      ThresholderType::New();
-    sourceThresholder->SetInput( this->GetSourceImage() );
-    sourceThresholder->SetLowerThreshold( label );
-    sourceThresholder->SetUpperThreshold( label );
-    sourceThresholder->SetInsideValue( NumericTraits<LabelType>::One );
-    sourceThresholder->SetOutsideValue( NumericTraits<LabelType>::Zero );
-    sourceThresholder->Update();
-
-    typename ThresholderType::Pointer targetThresholder =
-      ThresholderType::New();
-    targetThresholder->SetInput( this->GetTargetImage() );
-    targetThresholder->SetLowerThreshold( label );
-    targetThresholder->SetUpperThreshold( label );
-    targetThresholder->SetInsideValue( NumericTraits<LabelType>::One );
-    targetThresholder->SetOutsideValue( NumericTraits<LabelType>::Zero );
-    targetThresholder->Update();
-
-    // Contour distances
-
-    typedef ContourDirectedMeanDistanceImageFilter
-      <LabelImageType, LabelImageType> DirectedContourFilterType;
-    typename DirectedContourFilterType::Pointer directedContourFilter =
-      DirectedContourFilterType::New();
-    directedContourFilter->SetInput1( sourceThresholder->GetOutput() );
-    directedContourFilter->SetInput2( targetThresholder->GetOutput() );
-    directedContourFilter->Update();
-
-    typedef ContourMeanDistanceImageFilter
-      <LabelImageType, LabelImageType> ContourFilterType;
-    typename ContourFilterType::Pointer contourFilter =
-      ContourFilterType::New();
-    contourFilter->SetInput1( sourceThresholder->GetOutput() );
-    contourFilter->SetInput2( targetThresholder->GetOutput() );
-    contourFilter->Update();
-
-    (*mapIt).second.m_DirectedContourMeanDistance =
-      directedContourFilter->GetContourDirectedMeanDistance();
-    (*mapIt).second.m_ContourMeanDistance = contourFilter->GetMeanDistance();
-
-    // Hausdorff distances
-
-    typedef DirectedHausdorffDistanceImageFilter
-      <LabelImageType, LabelImageType> DirectedHausdorffFilterType;
-    typename DirectedHausdorffFilterType::Pointer directedHausdorffFilter =
-      DirectedHausdorffFilterType::New();
-    directedHausdorffFilter->SetInput1( sourceThresholder->GetOutput() );
-    directedHausdorffFilter->SetInput2( targetThresholder->GetOutput() );
-    directedHausdorffFilter->Update();
-
-    typedef HausdorffDistanceImageFilter
-      <LabelImageType, LabelImageType> HausdorffFilterType;
-    typename HausdorffFilterType::Pointer hausdorffFilter =
-      HausdorffFilterType::New();
-    hausdorffFilter->SetInput1( sourceThresholder->GetOutput() );
-    hausdorffFilter->SetInput2( targetThresholder->GetOutput() );
-    hausdorffFilter->Update();
-
-    (*mapIt).second.m_DirectedHausdorffDistance =
-      directedHausdorffFilter->GetDirectedHausdorffDistance();
-    (*mapIt).second.m_HausdorffDistance =
-      hausdorffFilter->GetHausdorffDistance();
+  // find the bounding box of each label in both images
+  typedef hash_map<LabelType, unsigned long> LabelIndexMapType;
+  LabelIndexMapType labelIndices;
+
+  SurfaceDistanceThreadStruct str;
+  str.Filter = this;
+  str.NextLabel = 0;
+
+  for( MapIterator mapIt = this->m_LabelSetMeasures.begin();
+    mapIt != this->m_LabelSetMeasures.end(); ++mapIt )
+    {
+    // the surface distances of the background are not computed
+    if( (*mapIt).first == NumericTraits<LabelType>::Zero )
+      {
+      continue;
+      }
+    labelIndices[(*mapIt).first] = str.Labels.size();
+    str.Labels.push_back( (*mapIt).first );
+    str.Measures.push_back( &(*mapIt).second );
+    }
+
+  std::vector<IndexType> minimumIndex( str.Labels.size() );
+  std::vector<IndexType> maximumIndex( str.Labels.size() );
+  std::vector<bool> isFound( str.Labels.size(), false );
+
+  for( unsigned int i = 0; i < 2; i++ )
+    {
+    const LabelImageType *image = ( i == 0 ) ? this->GetSourceImage()
+      : this->GetTargetImage();
+
+    ImageRegionConstIteratorWithIndex<LabelImageType> It( image,
+      image->GetRequestedRegion() );
+    for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+      {
+      typename LabelIndexMapType::const_iterator labelIt =
+        labelIndices.find( It.Get() );
+      if( labelIt == labelIndices.end() )
+        {
+        continue;
+        }
+      const unsigned long n = (*labelIt).second;
+      const IndexType index = It.GetIndex();
+      if( !isFound[n] )
+        {
+        isFound[n] = true;
+        minimumIndex[n] = index;
+        maximumIndex[n] = index;
+        continue;
+        }
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        minimumIndex[n][d] = vnl_math_min( minimumIndex[n][d], index[d] );
+        maximumIndex[n][d] = vnl_math_max( maximumIndex[n][d], index[d] );
+        }
+      }
+    }
+
+  for( unsigned long n = 0; n < str.Labels.size(); n++ )
+    {
+    SizeType size;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      size[d] = maximumIndex[n][d] - minimumIndex[n][d] + 1;
+      }
+    RegionType region;
+    region.SetIndex( minimumIndex[n] );
+    region.SetSize( size );
+    str.Regions.push_back( region );
+    }
+
+  // compute the surface distances of the labels on all the threads
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->SurfaceDistanceThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template<class TLabelImage>
+ITK_THREAD_RETURN_TYPE
+LabelOverlapMeasuresImageFilter<TLabelImage>
+::SurfaceDistanceThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  SurfaceDistanceThreadStruct *str =
+    static_cast<SurfaceDistanceThreadStruct *>( info->UserData );
+
+  // the labels are taken one at a time since their sizes vary widely
+  while( true )
+    {
+    str->Filter->m_Mutex.Lock();
+    const unsigned long n = str->NextLabel++;
+    str->Filter->m_Mutex.Unlock();
+
+    if( n >= str->Labels.size() )
+      {
+      break;
+      }
+    str->Filter->ComputeSurfaceDistances( str->Labels[n], str->Regions[n],
+      *str->Measures[n] );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template<class TLabelImage>
+void
+LabelOverlapMeasuresImageFilter<TLabelImage>
+::ComputeSurfaceDistances( LabelType label, const RegionType & region,
+  LabelSetMeasures & measures )
+{
+  const RealType infinity = NumericTraits<RealType>::max();
+
+  std::vector<RealType> sourceDistances( region.GetNumberOfPixels(), infinity );
+  std::vector<RealType> targetDistances( region.GetNumberOfPixels(), infinity );
+
+  ImageRegionConstIterator<LabelImageType> ItS( this->GetSourceImage(), region );
+  ImageRegionConstIterator<LabelImageType> ItT( this->GetTargetImage(), region );
+  ImageRegionConstIterator<LabelImageType> Its( this->m_SourceSurfaceImage,
+    region );
+  ImageRegionConstIterator<LabelImageType> Itt( this->m_TargetSurfaceImage,
+    region );
+
+  unsigned long numberOfSourceSurfaceVoxels = 0;
+  unsigned long numberOfTargetSurfaceVoxels = 0;
+
+  unsigned long n = 0;
+  for( Its.GoToBegin(), Itt.GoToBegin(); !Its.IsAtEnd(); ++Its, ++Itt, ++n )
+    {
+    if( Its.Get() == label )
+      {
+      sourceDistances[n] = 0.0;
+      numberOfSourceSurfaceVoxels++;
+      }
+    if( Itt.Get() == label )
+      {
+      targetDistances[n] = 0.0;
+      numberOfTargetSurfaceVoxels++;
+      }
+    }
+
+  // the distances are not defined if the label is missing from an image
+  if( numberOfSourceSurfaceVoxels == 0 || numberOfTargetSurfaceVoxels == 0 )
+    {
+    return;
+    }
+
+  this->ComputeSquaredDistances( sourceDistances, region.GetSize() );
+  this->ComputeSquaredDistances( targetDistances, region.GetSize() );
+
+  /**
+   * The Hausdorff distances are taken over all the voxels of the label, the
+   * voxels inside the label of the other image being at distance zero.  The
+   * contour mean and percentile distances are taken over the surface voxels.
+   * Outside a label, the distance to its surface is the distance to the
+   * label.
+   */
+  RealType maximumSourceToTarget = 0.0;
+  RealType maximumTargetToSource = 0.0;
+  RealType sumSourceToTarget = 0.0;
+  RealType sumTargetToSource = 0.0;
+
+  std::vector<RealType> sourceToTarget;
+  sourceToTarget.reserve( numberOfSourceSurfaceVoxels );
+  std::vector<RealType> targetToSource;
+  targetToSource.reserve( numberOfTargetSurfaceVoxels );
+
+  n = 0;
+  for( ItS.GoToBegin(), ItT.GoToBegin(), Its.GoToBegin(), Itt.GoToBegin();
+    !ItS.IsAtEnd(); ++ItS, ++ItT, ++Its, ++Itt, ++n )
+    {
+    const bool isInSource = ( ItS.Get() == label );
+    const bool isInTarget = ( ItT.Get() == label );
+
+    if( isInSource && !isInTarget )
+      {
+      maximumSourceToTarget = vnl_math_max( maximumSourceToTarget,
+        targetDistances[n] );
+      }
+    if( isInTarget && !isInSource )
+      {
+      maximumTargetToSource = vnl_math_max( maximumTargetToSource,
+        sourceDistances[n] );
+      }
+    if( Its.Get() == label )
+      {
+      const RealType distance = vcl_sqrt( targetDistances[n] );
+      sumSourceToTarget += distance;
+      sourceToTarget.push_back( distance );
+      }
+    if( Itt.Get() == label )
+      {
+      const RealType distance = vcl_sqrt( sourceDistances[n] );
+      sumTargetToSource += distance;
+      targetToSource.push_back( distance );
+      }
+    }
+
+  measures.m_DirectedHausdorffDistance = vcl_sqrt( maximumSourceToTarget );
+  measures.m_HausdorffDistance = vcl_sqrt(
+    vnl_math_max( maximumSourceToTarget, maximumTargetToSource ) );
+
+  measures.m_DirectedContourMeanDistance =
+    sumSourceToTarget / static_cast<RealType>( sourceToTarget.size() );
+  measures.m_ContourMeanDistance = vnl_math_max(
+    measures.m_DirectedContourMeanDistance,
+    sumTargetToSource / static_cast<RealType>( targetToSource.size() ) );
+
+  // nearest rank percentiles
+  typename std::vector<RealType>::iterator percentileIt =
+    sourceToTarget.begin() + static_cast<unsigned long>( vcl_floor(
+    this->m_HausdorffPercentile * ( sourceToTarget.size() - 1 ) + 0.5 ) );
+  std::nth_element( sourceToTarget.begin(), percentileIt,
+    sourceToTarget.end() );
+  measures.m_DirectedPercentileHausdorffDistance = *percentileIt;
+
+  percentileIt = targetToSource.begin() + static_cast<unsigned long>(
+    vcl_floor( this->m_HausdorffPercentile *
+    ( targetToSource.size() - 1 ) + 0.5 ) );
+  std::nth_element( targetToSource.begin(), percentileIt,
+    targetToSource.end() );
+  measures.m_PercentileHausdorffDistance = vnl_math_max(
+    measures.m_DirectedPercentileHausdorffDistance, *percentileIt );
+}
+
+template<class TLabelImage>
+void
+LabelOverlapMeasuresImageFilter<TLabelImage>
+::ComputeSquaredDistances( std::vector<RealType> & distances,
+  const SizeType & size ) const
+{
+  const RealType infinity = NumericTraits<RealType>::max();
+  typename LabelImageType::SpacingType spacing;
+  spacing.Fill( 1.0 );
+  if( this->m_UseImageSpacing )
+    {
+    spacing = this->GetInput( 0 )->GetSpacing();
+    }
+
+  /**
+   * Separable exact transform: the distances along the rows of each
+   * dimension are replaced by the lower envelope of the parabolas rooted
+   * at the distances of the previous dimensions.
+   */
+  unsigned long stride = 1;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    const long length = static_cast<long>( size[d] );
+    const RealType spacing2 = vnl_math_sqr( spacing[d] );
+
+    std::vector<RealType> f( length );
+    std::vector<long> v( length );
+    std::vector<RealType> z( length + 1 );
+
+    const unsigned long numberOfRows = distances.size() / length;
+    for( unsigned long row = 0; length > 1 && row < numberOfRows; row++ )
+      {
+      RealType *rowDistances = &distances[0] +
+        ( row / stride ) * stride * length + row % stride;
+
+      long k = -1;
+      for( long q = 0; q < length; q++ )
+        {
+        f[q] = rowDistances[q * stride];
+        if( f[q] >= infinity )
+          {
+          continue;
+          }
+        RealType s = -infinity;
+        while( k >= 0 )
+          {
+          const long p = v[k];
+          s = ( ( f[q] + spacing2 * q * q ) - ( f[p] + spacing2 * p * p ) )
+            / ( 2.0 * spacing2 * ( q - p ) );
+          if( s > z[k] )
+            {
+            break;
+            }
+          k--;
+          }
+        k++;
+        v[k] = q;
+        z[k] = ( k == 0 ) ? -infinity : s;
+        z[k+1] = infinity;
+        }
+
+      if( k < 0 )
+        {
+        continue;
+        }
+
+      long j = 0;
+      for( long i = 0; i < length; i++ )
+        {
+        while( z[j+1] < i )
+          {
+          j++;
+          }
+        const long p = v[j];
+        rowDistances[i * stride] = f[p] + spacing2 * ( i - p ) * ( i - p );
+        }
+      }
+    stride *= length;
     }
 }
 
@@ -790,6 +1026,34 @@ LabelOverlapMeasuresImageFilter<TLabelImage>
   return (*mapIt).second.m_DirectedHausdorffDistance;
 }
 
+template<class TLabelImage>
+typename LabelOverlapMeasuresImageFilter<TLabelImage>::RealType
+LabelOverlapMeasuresImageFilter<TLabelImage>
+::GetPercentileHausdorffDistance( LabelType label )
+{
+  MapIterator mapIt = this->m_LabelSetMeasures.find( label );
+  if( mapIt == this->m_LabelSetMeasures.end() )
+    {
+    itkWarningMacro( "Label " << label << " not found." );
+    return 0.0;
+    }
+  return (*mapIt).second.m_PercentileHausdorffDistance;
+}
+
+template<class TLabelImage>
+typename LabelOverlapMeasuresImageFilter<TLabelImage>::RealType
+LabelOverlapMeasuresImageFilter<TLabelImage>
+::GetDirectedPercentileHausdorffDistance( LabelType label )
+{
+  MapIterator mapIt = this->m_LabelSetMeasures.find( label );
+  if( mapIt == this->m_LabelSetMeasures.end() )
+    {
+    itkWarningMacro( "Label " << label << " not found." );
+    return 0.0;
+    }
+  return (*mapIt).second.m_DirectedPercentileHausdorffDistance;
+}
+
 template<class TLabelImage>
 typename LabelOverlapMeasuresImageFilter<TLabelImage>::RealType
 LabelOverlapMeasuresImageFilter<TLabelImage>
@@ -825,6 +1089,10 @@ LabelOverlapMeasuresImageFilter<TLabelImage>
 {
   Superclass::PrintSelf( os, indent );
 
+  os << indent << "Hausdorff percentile: "
+     << this->m_HausdorffPercentile << std::endl;
+  os << indent << "Use image spacing: "
+     << this->m_UseImageSpacing << std::endl;
 }
 
 
@@ -20,8 +20,7 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkImage.h"
-#include "itkHessianSmoothed3DToVesselnessMeasureImageFilter.h" 
-#include "itkHessianRecursiveGaussianImageFilter.h"
+#include "itkMultiScaleRecursiveHessianMeasureImageFilter.h"
 
 namespace itk
 {
@@ -34,13 +33,18 @@ namespace itk
  * version of the Frang's vesselness function. The filter takes an 
  * image of any pixel type and generates a Hessian image pixels at different
  * scale levels. The vesselness measure is computed from the Hessian image 
- * at each scale level and the best response is selected.  The vesselness 
- * measure is computed using HessianSmoothed3DToVesselnessMeasureImageFilter.
+ * at each scale level and the best response is selected.  The Hessian and
+ * the vesselness measure of all the scales are computed by
+ * MultiScaleRecursiveHessianMeasureImageFilter, with the measure of
+ * HessianSmoothed3DToVesselnessMeasureImageFilter.
  *
  * Minimum and maximum sigma value can be set using SetMinSigma and SetMaxSigma
  * methods respectively. The number of scale levels is set using 
  * SetNumberOfSigmaSteps method. Exponentially distributed scale levels are 
  * computed within the bound set by the minimum and maximum sigma values 
+ * 
+ * The image can be processed by slabs of NumberOfSlicesPerSlab slices to
+ * limit the memory.
  *  
  *
  * \par References
@@ -78,9 +82,6 @@ public:
   typedef typename TInputImage::PixelType                InputPixelType;
   typedef typename TOutputImage::PixelType               OutputPixelType;
 
-  /** Update image buffer that holds the best vesselness response */ 
-  typedef Image< double, 3>                              UpdateBufferType;
-
   /** Image dimension = 3. */
   itkStaticConstMacro(ImageDimension, unsigned int,
                    ::itk::GetImageDimension<InputImageType>::ImageDimension);
@@ -100,28 +101,28 @@ public:
   itkSetMacro(NumberOfSigmaSteps, int);
   itkGetMacro(NumberOfSigmaSteps, int);
 
+  /** Set/Get macros for the number of slices of the slabs (0: no slabs) */
+  itkSetMacro(NumberOfSlicesPerSlab, SizeValueType);
+  itkGetMacro(NumberOfSlicesPerSlab, SizeValueType);
+
 
 protected:
   MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter();
   ~MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter() {};
   void PrintSelf(std::ostream& os, Indent indent) const;
   
-  typedef HessianRecursiveGaussianImageFilter< InputImageType >
-                                                        HessianFilterType;
-
-  typedef HessianSmoothed3DToVesselnessMeasureImageFilter< double >
+  typedef MultiScaleRecursiveHessianMeasureImageFilter< InputImageType,
+    OutputImageType, Functor::HessianSmoothedVesselnessMeasure >
                                                         VesselnessFilterType;
 
+  /** The whole image is processed */
+  void GenerateInputRequestedRegion();
+  void EnlargeOutputRequestedRegion( DataObject * );
+
   /** Generate Data */
   void GenerateData( void );
 
 private:
-  void UpdateMaximumResponse();
-
-  double ComputeSigmaValue( int scaleLevel );
-  
-  void   AllocateUpdateBuffer();
-
   //purposely not implemented
   MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter(const Self&); 
   void operator=(const Self&); //purposely not implemented
@@ -131,11 +132,9 @@ private:
 
   int                                               m_NumberOfSigmaSteps;
 
-  typename VesselnessFilterType::Pointer            m_VesselnessFilter;
-  typename HessianFilterType::Pointer               m_HessianFilter;
+  SizeValueType                                     m_NumberOfSlicesPerSlab;
 
-
-  UpdateBufferType::Pointer                         m_UpdateBuffer;
+  typename VesselnessFilterType::Pointer            m_VesselnessFilter;
 };
 
 } // end namespace itk
@@ -18,12 +18,8 @@
 #define __itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter_hxx
 
 #include "itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter.h"
-#include "itkImageRegionIterator.h"
-#include "itkImageRegionConstIterator.h"
 #include "vnl/vnl_math.h"
 
-#define EPSILON  1e-03
-
 namespace itk
 {
 
@@ -40,92 +36,25 @@ MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
 
   m_NumberOfSigmaSteps = 10;
 
-  m_HessianFilter                = HessianFilterType::New();
+  m_NumberOfSlicesPerSlab = 0;
+
   m_VesselnessFilter             = VesselnessFilterType::New();
 
   //Turn off vesselness measure scaling
-  m_VesselnessFilter->SetScaleVesselnessMeasure( false );
-
-  //Instantiate Update buffer
-  m_UpdateBuffer                 = UpdateBufferType::New();
+  m_VesselnessFilter->GetFunctor().SetScaleVesselnessMeasure( false );
 }
 
 template <typename TInputImage, typename TOutputImage >
 void
 MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
 <TInputImage,TOutputImage>
-::AllocateUpdateBuffer()
+::GenerateInputRequestedRegion()
 {
-  /* The update buffer looks just like the output and holds the best response
-     in the  vesselness measure */
-  
-  typename TOutputImage::Pointer output = this->GetOutput();
-
-  m_UpdateBuffer->SetSpacing(output->GetSpacing());
-  m_UpdateBuffer->SetOrigin(output->GetOrigin());
-  m_UpdateBuffer->SetLargestPossibleRegion(output->GetLargestPossibleRegion());
-  m_UpdateBuffer->SetRequestedRegion(output->GetRequestedRegion());
-  m_UpdateBuffer->SetBufferedRegion(output->GetBufferedRegion());
-  m_UpdateBuffer->Allocate();
-}
-
-
-template <typename TInputImage, typename TOutputImage >
-void
-MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
-<TInputImage,TOutputImage>
-::GenerateData()
-{
-  // Allocate the output
-  this->GetOutput()->SetBufferedRegion( 
-                 this->GetOutput()->GetRequestedRegion() );
-  this->GetOutput()->Allocate();
-
-  // Allocate the buffer
-  AllocateUpdateBuffer();
-
-  typename InputImageType::ConstPointer input = this->GetInput();
- 
-  this->m_HessianFilter->SetInput( input );
-
-  this->m_HessianFilter->SetNormalizeAcrossScale( true );
- 
-  double sigma = m_SigmaMin;
-
-  int scaleLevel = 1;
-
-  while ( sigma <= m_SigmaMax )
+  Superclass::GenerateInputRequestedRegion();
+  if( this->GetInput() )
     {
-    std::cout << "Computing vesselness for scale with sigma= " 
-              << sigma << std::endl;
-
-    m_HessianFilter->SetSigma( sigma );
-
-    m_VesselnessFilter->SetInput ( m_HessianFilter->GetOutput() ); 
-
-    m_VesselnessFilter->Update();
- 
-    this->UpdateMaximumResponse();
-
-    sigma  = this->ComputeSigmaValue( scaleLevel );
-
-    scaleLevel++;
-    } 
-
-  //Write out the best response to the output image
-  ImageRegionIterator<UpdateBufferType> 
-               it(m_UpdateBuffer,m_UpdateBuffer->GetLargestPossibleRegion());
-  it.GoToBegin();
-
-  ImageRegionIterator<TOutputImage> oit(this->GetOutput(),
-                          this->GetOutput()->GetLargestPossibleRegion());
-  oit.GoToBegin();
-
-  while(!oit.IsAtEnd())
-    {
-    oit.Value() = static_cast< OutputPixelType >( it.Get() );
-    ++oit;
-    ++it;
+    InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+    input->SetRequestedRegionToLargestPossibleRegion();
     }
 }
 
@@ -133,49 +62,36 @@ template <typename TInputImage, typename TOutputImage >
 void
 MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
 <TInputImage,TOutputImage>
-::UpdateMaximumResponse()
+::EnlargeOutputRequestedRegion( DataObject *output )
 {
-
-  ImageRegionIterator<UpdateBufferType> 
-            oit(m_UpdateBuffer,m_UpdateBuffer->GetLargestPossibleRegion());
-
-  oit.GoToBegin();
-
-  typedef typename VesselnessFilterType::OutputImageType   
-                                         VesselnessOutputImageType;
-
-  ImageRegionIterator<VesselnessOutputImageType> 
-            it(m_VesselnessFilter->GetOutput(),
-            this->m_VesselnessFilter->GetOutput()->GetLargestPossibleRegion());
-
-  it.GoToBegin();
-
-  while(!oit.IsAtEnd())
-    {
-    if( oit.Value() < it.Value() )
-      {
-      oit.Value() = it.Value();
-      }
-    ++oit;
-    ++it;
-    }
+  Superclass::EnlargeOutputRequestedRegion( output );
+  output->SetRequestedRegionToLargestPossibleRegion();
 }
 
 template <typename TInputImage, typename TOutputImage >
-double
+void
 MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
 <TInputImage,TOutputImage>
-::ComputeSigmaValue( int ScaleLevel )
+::GenerateData()
 {
-  double stepSize = 
-     ( vcl_log( m_SigmaMax )  - vcl_log( m_SigmaMin) ) / m_NumberOfSigmaSteps;
-
-  if( stepSize <= 1e-10 )
-    {
-    stepSize = 1e-10;
-    } 
+  typename InputImageType::ConstPointer input = this->GetInput();
 
-  return ( vcl_exp( vcl_log (m_SigmaMin) + stepSize * ScaleLevel) );
+  /* The scale levels are exp( log( SigmaMin ) + k * stepSize ) with
+     stepSize = ( log( SigmaMax ) - log( SigmaMin ) ) / NumberOfSigmaSteps,
+     k = 0, ..., NumberOfSigmaSteps, and the best response over all the
+     levels is kept */
+  this->m_VesselnessFilter->SetInput( input );
+  this->m_VesselnessFilter->SetNormalizeAcrossScale( true );
+  this->m_VesselnessFilter->SetSigmaMinimum( m_SigmaMin );
+  this->m_VesselnessFilter->SetSigmaMaximum( m_SigmaMax );
+  this->m_VesselnessFilter->SetNumberOfSigmaSteps(
+    static_cast<unsigned int>( vnl_math_max( m_NumberOfSigmaSteps, 0 ) + 1 ) );
+  this->m_VesselnessFilter->SetNumberOfSlicesPerSlab( m_NumberOfSlicesPerSlab );
+  this->m_VesselnessFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  this->m_VesselnessFilter->GraftOutput( this->GetOutput() );
+  this->m_VesselnessFilter->Update();
+  this->GraftOutput( this->m_VesselnessFilter->GetOutput() );
 }
 
 template <typename TInputImage, typename TOutputImage >
@@ -188,6 +104,9 @@ MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
   
   os << indent << "SigmaMin:  " << m_SigmaMin << std::endl;
   os << indent << "SigmaMax:  " << m_SigmaMax  << std::endl;
+  os << indent << "NumberOfSigmaSteps:  " << m_NumberOfSigmaSteps << std::endl;
+  os << indent << "NumberOfSlicesPerSlab:  " << m_NumberOfSlicesPerSlab
+     << std::endl;
 }
 
 
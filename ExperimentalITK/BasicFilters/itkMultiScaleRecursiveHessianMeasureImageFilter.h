@@ -0,0 +1,219 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMultiScaleRecursiveHessianMeasureImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMultiScaleRecursiveHessianMeasureImageFilter_h
+#define __itkMultiScaleRecursiveHessianMeasureImageFilter_h
+
+#include "itkImageToImageFilter.h"
+
+#include "itkFixedArray.h"
+#include "itkHessianMeasureFunctors.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class MultiScaleRecursiveHessianMeasureImageFilter
+ * \brief Maximum over the scales of a measure of the eigenvalues of the
+ * Hessian, such as the objectness or the vesselness.
+ *
+ * At each scale sigma, the second derivatives of the image are computed
+ * with the recursive Gaussian filters of Deriche, as in
+ * RecursiveGaussianImageFilter, one pass of order 0, 1 or 2 along each
+ * dimension.  The passes are ordered from the last dimension to the first
+ * and the components are visited so that the smoothed images shared by
+ * several components are computed once, e.g. the pass of order 0 along z
+ * serves the xx, xy and yy components.  A 3-D Hessian then costs 15 line
+ * passes instead of 18.  The eigenvalues of the Hessian of each pixel are
+ * computed in closed form (2-D and 3-D images), sorted by increasing
+ * magnitude and passed to the functor, e.g. Functor::HessianObjectnessMeasure
+ * or Functor::HessianSmoothedVesselnessMeasure, and the output is the
+ * largest response over the scales.
+ *
+ * The scales are NumberOfSigmaSteps values logarithmically spaced between
+ * SigmaMinimum and SigmaMaximum (physical units).  If NormalizeAcrossScale
+ * is on, the derivatives are multiplied by sigma^2.
+ *
+ * The image is processed by slabs of NumberOfSlicesPerSlab slices along the
+ * last dimension (0: the whole requested region at once), each slab being
+ * padded by SlabPaddingFactor * SigmaMaximum on both sides for the passes
+ * along that dimension, which bounds the memory to about ten slabs.  The
+ * same padding is requested from the input when the output is streamed.
+ *
+ * The passes and the eigenvalues are multithreaded.
+ *
+ * \sa MultiScaleHessianBasedMeasureImageFilter
+ * \sa RecursiveGaussianImageFilter
+ */
+template <class TInputImage, class TOutputImage, class TFunction>
+class ITK_EXPORT MultiScaleRecursiveHessianMeasureImageFilter
+: public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef MultiScaleRecursiveHessianMeasureImageFilter        Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>       Superclass;
+  typedef SmartPointer<Self>                                  Pointer;
+  typedef SmartPointer<const Self>                            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MultiScaleRecursiveHessianMeasureImageFilter,
+    ImageToImageFilter );
+
+  /** Extract dimension from input image. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+                       TInputImage::ImageDimension );
+
+  /** Image typedef support. */
+  typedef TInputImage                                         InputImageType;
+  typedef TOutputImage                                        OutputImageType;
+  typedef typename InputImageType::PixelType                  InputPixelType;
+  typedef typename OutputImageType::PixelType                 OutputPixelType;
+  typedef typename OutputImageType::RegionType                RegionType;
+  typedef typename RegionType::SizeType                       SizeType;
+  typedef typename RegionType::IndexType                      IndexType;
+
+  /** Other typedef */
+  typedef double                                              RealType;
+  typedef TFunction                                           FunctorType;
+  typedef FixedArray<RealType,
+    itkGetStaticConstMacro( ImageDimension )>                 EigenValuesType;
+
+  /** Number of components of the Hessian. */
+  itkStaticConstMacro( NumberOfHessianComponents, unsigned int,
+    ImageDimension * ( ImageDimension + 1 ) / 2 );
+
+  /** Set/Get the smallest and largest scales. */
+  itkSetMacro( SigmaMinimum, RealType );
+  itkGetConstMacro( SigmaMinimum, RealType );
+  itkSetMacro( SigmaMaximum, RealType );
+  itkGetConstMacro( SigmaMaximum, RealType );
+
+  /** Set/Get the number of scales. */
+  itkSetMacro( NumberOfSigmaSteps, unsigned int );
+  itkGetConstMacro( NumberOfSigmaSteps, unsigned int );
+
+  /** Set/Get if the derivatives are multiplied by sigma^2. */
+  itkSetMacro( NormalizeAcrossScale, bool );
+  itkGetConstMacro( NormalizeAcrossScale, bool );
+  itkBooleanMacro( NormalizeAcrossScale );
+
+  /** Set/Get the number of slices of the slabs (0: no slabs). */
+  itkSetMacro( NumberOfSlicesPerSlab, SizeValueType );
+  itkGetConstMacro( NumberOfSlicesPerSlab, SizeValueType );
+
+  /** Set/Get the padding of the slabs, in multiples of SigmaMaximum. */
+  itkSetMacro( SlabPaddingFactor, RealType );
+  itkGetConstMacro( SlabPaddingFactor, RealType );
+
+  /** Get/Set the functor computing the measure from the eigenvalues. */
+  FunctorType & GetFunctor()
+    { return this->m_Functor; }
+  const FunctorType & GetFunctor() const
+    { return this->m_Functor; }
+  void SetFunctor( const FunctorType & functor )
+    {
+    this->m_Functor = functor;
+    this->Modified();
+    }
+
+  /** Eigenvalues of a symmetric matrix given by its upper triangle, row
+   * by row, in increasing order of magnitude. */
+  static void ComputeEigenValues( const RealType *hessian,
+    EigenValuesType & eigenValues );
+
+protected:
+  MultiScaleRecursiveHessianMeasureImageFilter();
+  virtual ~MultiScaleRecursiveHessianMeasureImageFilter() {}
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  void GenerateInputRequestedRegion();
+  void EnlargeOutputRequestedRegion( DataObject * );
+
+  void GenerateData();
+
+  /** Coefficients of the causal (N) and anticausal (M) parts of a
+   * recursive filter, of their common denominator (D) and of the edge
+   * extension at the boundaries (BN, BM). */
+  struct RecursiveCoefficientsType
+  {
+    RealType                                                  N[4];
+    RealType                                                  M[4];
+    RealType                                                  D[4];
+    RealType                                                  BN[4];
+    RealType                                                  BM[4];
+  };
+
+  /** Internal structure used for passing the passes to the threads. */
+  struct HessianThreadStruct
+  {
+    Self                                                     *Filter;
+    bool                                                      IsEigenPass;
+    unsigned int                                              Dimension;
+    RecursiveCoefficientsType                                 Coefficients;
+    const RealType                                           *Source;
+    RealType                                                 *Destination;
+    SizeType                                                  Size;
+    std::vector<RealType>                                     Hessian[NumberOfHessianComponents];
+    OutputPixelType                                          *Output;
+    SizeValueType                                             NumberOfPixels;
+    bool                                                      IsFirstScale;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE HessianThreaderCallback( void *arg );
+
+  /** Recursive filtering of the lines of str->Dimension. */
+  void ThreadedFilterLines( HessianThreadStruct *str, ThreadIdType threadId,
+    ThreadIdType numberOfThreads );
+
+  /** Measure of the pixels, kept if larger than that of the previous scales. */
+  void ThreadedComputeMeasure( HessianThreadStruct *str, ThreadIdType threadId,
+    ThreadIdType numberOfThreads );
+
+  /** Coefficients of the derivative of order 0, 1 or 2 of the Gaussian of
+   * the given sigma along the dimension d. */
+  void ComputeRecursiveCoefficients( RealType sigma, unsigned int order,
+    unsigned int d, RecursiveCoefficientsType & coefficients ) const;
+
+  /** Number of slices padding a slab on each side. */
+  SizeValueType GetSlabPadding() const;
+
+private:
+  MultiScaleRecursiveHessianMeasureImageFilter( const Self & ); //purposely not implemented
+  void operator=( const Self & ); //purposely not implemented
+
+  RealType                                                    m_SigmaMinimum;
+  RealType                                                    m_SigmaMaximum;
+  unsigned int                                                m_NumberOfSigmaSteps;
+  bool                                                        m_NormalizeAcrossScale;
+  SizeValueType                                               m_NumberOfSlicesPerSlab;
+  RealType                                                    m_SlabPaddingFactor;
+
+  FunctorType                                                 m_Functor;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMultiScaleRecursiveHessianMeasureImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,695 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMultiScaleRecursiveHessianMeasureImageFilter.hxx,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMultiScaleRecursiveHessianMeasureImageFilter_hxx
+#define __itkMultiScaleRecursiveHessianMeasureImageFilter_hxx
+
+#include "itkMultiScaleRecursiveHessianMeasureImageFilter.h"
+
+#include "itkImageRegionConstIterator.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <class TInputImage, class TOutputImage, class TFunction>
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::MultiScaleRecursiveHessianMeasureImageFilter()
+{
+  this->m_SigmaMinimum = 1.0;
+  this->m_SigmaMaximum = 1.0;
+  this->m_NumberOfSigmaSteps = 1;
+  this->m_NormalizeAcrossScale = true;
+  this->m_NumberOfSlicesPerSlab = 0;
+  this->m_SlabPaddingFactor = 4.0;
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+SizeValueType
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::GetSlabPadding() const
+{
+  const RealType spacing = this->GetInput()->GetSpacing()[ImageDimension - 1];
+  return vnl_math_max( static_cast<SizeValueType>( vcl_ceil(
+    this->m_SlabPaddingFactor * this->m_SigmaMaximum / spacing ) ),
+    static_cast<SizeValueType>( 3 ) );
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  if( !input )
+    {
+    return;
+    }
+
+  /**
+   * The requested slices, padded for the passes along the last dimension.
+   */
+  RegionType region = this->GetOutput()->GetRequestedRegion();
+  const SizeValueType padding = this->GetSlabPadding();
+  region.SetIndex( ImageDimension - 1, region.GetIndex( ImageDimension - 1 )
+    - static_cast<OffsetValueType>( padding ) );
+  region.SetSize( ImageDimension - 1, region.GetSize( ImageDimension - 1 )
+    + 2 * padding );
+  region.Crop( input->GetLargestPossibleRegion() );
+  input->SetRequestedRegion( region );
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::EnlargeOutputRequestedRegion( DataObject *output )
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+
+  /**
+   * Whole lines along all the dimensions but the last one.
+   */
+  OutputImageType *outputImage = dynamic_cast<OutputImageType *>( output );
+  if( outputImage )
+    {
+    RegionType region = outputImage->GetRequestedRegion();
+    const RegionType & largestRegion = outputImage->GetLargestPossibleRegion();
+    for( unsigned int d = 0; d + 1 < ImageDimension; d++ )
+      {
+      region.SetIndex( d, largestRegion.GetIndex( d ) );
+      region.SetSize( d, largestRegion.GetSize( d ) );
+      }
+    outputImage->SetRequestedRegion( region );
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::GenerateData()
+{
+  if( ImageDimension != 2 && ImageDimension != 3 )
+    {
+    itkExceptionMacro( << "Only 2-D and 3-D images are supported." );
+    }
+  if( this->m_SigmaMinimum <= 0.0 ||
+    this->m_SigmaMaximum < this->m_SigmaMinimum )
+    {
+    itkExceptionMacro( << "Invalid sigma range [" << this->m_SigmaMinimum
+      << ", " << this->m_SigmaMaximum << "]." );
+    }
+
+  this->AllocateOutputs();
+
+  const InputImageType *input = this->GetInput();
+  OutputImageType *output = this->GetOutput();
+  const RegionType outputRegion = output->GetRequestedRegion();
+  const RegionType inputRegion = input->GetBufferedRegion();
+  const unsigned int last = ImageDimension - 1;
+
+  if( outputRegion.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+  for( unsigned int d = 0; d < last; d++ )
+    {
+    if( outputRegion.GetSize( d ) < 4 )
+      {
+      itkExceptionMacro( << "The image has less than 4 pixels along dimension "
+        << d << "." );
+      }
+    }
+
+  /**
+   * Logarithmically spaced scales.
+   */
+  const unsigned int numberOfScales =
+    vnl_math_max( this->m_NumberOfSigmaSteps, 1u );
+  std::vector<RealType> sigmas( numberOfScales, this->m_SigmaMinimum );
+  for( unsigned int s = 1; s < numberOfScales; s++ )
+    {
+    sigmas[s] = vcl_exp( vcl_log( this->m_SigmaMinimum ) + static_cast<RealType>( s )
+      * ( vcl_log( this->m_SigmaMaximum ) - vcl_log( this->m_SigmaMinimum ) )
+      / static_cast<RealType>( numberOfScales - 1 ) );
+    }
+
+  /**
+   * Derivative orders of the components, row by row of the upper triangle,
+   * and order of visit of the components, sorted on the orders from the
+   * last dimension to the first so that the components sharing the passes
+   * along the last dimensions follow each other.
+   */
+  unsigned int orders[NumberOfHessianComponents][ImageDimension];
+  unsigned int visit[NumberOfHessianComponents];
+  unsigned int c = 0;
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    for( unsigned int j = i; j < ImageDimension; j++ )
+      {
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        orders[c][d] = ( d == i ) + ( d == j );
+        }
+      visit[c] = c;
+      c++;
+      }
+    }
+  for( unsigned int k = 1; k < NumberOfHessianComponents; k++ )
+    {
+    for( unsigned int l = k; l > 0; l-- )
+      {
+      unsigned int d = last;
+      while( d > 0 && orders[visit[l]][d] == orders[visit[l - 1]][d] )
+        {
+        d--;
+        }
+      if( orders[visit[l]][d] >= orders[visit[l - 1]][d] )
+        {
+        break;
+        }
+      std::swap( visit[l], visit[l - 1] );
+      }
+    }
+
+  /**
+   * Slabs of the output, padded by the input available around them.
+   */
+  const SizeValueType sliceSize =
+    outputRegion.GetNumberOfPixels() / outputRegion.GetSize( last );
+  const OffsetValueType outputStart = outputRegion.GetIndex( last );
+  const OffsetValueType outputEnd = outputStart
+    + static_cast<OffsetValueType>( outputRegion.GetSize( last ) );
+  const OffsetValueType inputStart = inputRegion.GetIndex( last );
+  const OffsetValueType inputEnd = inputStart
+    + static_cast<OffsetValueType>( inputRegion.GetSize( last ) );
+  const OffsetValueType slabSlices = static_cast<OffsetValueType>(
+    ( this->m_NumberOfSlicesPerSlab > 0 )
+    ? this->m_NumberOfSlicesPerSlab : outputRegion.GetSize( last ) );
+  const OffsetValueType padding =
+    static_cast<OffsetValueType>( this->GetSlabPadding() );
+
+  HessianThreadStruct str;
+  str.Filter = this;
+
+  std::vector<RealType> paddedSlab;
+  std::vector<RealType> levels[ImageDimension];
+
+  for( OffsetValueType start = outputStart; start < outputEnd; start += slabSlices )
+    {
+    const OffsetValueType end = vnl_math_min( start + slabSlices, outputEnd );
+    const OffsetValueType paddedStart = vnl_math_max( start - padding, inputStart );
+    const OffsetValueType paddedEnd = vnl_math_min( end + padding, inputEnd );
+    if( paddedEnd - paddedStart < 4 )
+      {
+      itkExceptionMacro( << "The image has less than 4 pixels along dimension "
+        << last << "." );
+      }
+
+    RegionType paddedRegion = outputRegion;
+    paddedRegion.SetIndex( last, paddedStart );
+    paddedRegion.SetSize( last, static_cast<SizeValueType>( paddedEnd - paddedStart ) );
+    SizeType coreSize = outputRegion.GetSize();
+    coreSize[last] = static_cast<SizeValueType>( end - start );
+
+    const SizeValueType numberOfPixels = sliceSize * coreSize[last];
+    const SizeValueType coreOffset =
+      sliceSize * static_cast<SizeValueType>( start - paddedStart );
+
+    paddedSlab.resize( paddedRegion.GetNumberOfPixels() );
+    ImageRegionConstIterator<InputImageType> It( input, paddedRegion );
+    SizeValueType n = 0;
+    for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+      {
+      paddedSlab[n++] = static_cast<RealType>( It.Get() );
+      }
+
+    levels[last].resize( paddedSlab.size() );
+    for( unsigned int d = 1; d < last; d++ )
+      {
+      levels[d].resize( numberOfPixels );
+      }
+    for( c = 0; c < NumberOfHessianComponents; c++ )
+      {
+      str.Hessian[c].resize( numberOfPixels );
+      }
+
+    for( unsigned int s = 0; s < numberOfScales; s++ )
+      {
+      /**
+       * The pass along the dimension d > 0 is kept in levels[d] and reused
+       * as long as the orders from the last dimension down to d do not
+       * change.
+       */
+      int cachedOrders[ImageDimension];
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        cachedOrders[d] = -1;
+        }
+
+      str.IsEigenPass = false;
+      for( unsigned int k = 0; k < NumberOfHessianComponents; k++ )
+        {
+        c = visit[k];
+
+        unsigned int top = last;
+        while( top > 0 &&
+          cachedOrders[top] == static_cast<int>( orders[c][top] ) )
+          {
+          top--;
+          }
+        for( unsigned int d = top + 1; d-- > 0; )
+          {
+          str.Dimension = d;
+          this->ComputeRecursiveCoefficients( sigmas[s], orders[c][d], d,
+            str.Coefficients );
+          if( d == last )
+            {
+            str.Source = &paddedSlab[0];
+            str.Size = paddedRegion.GetSize();
+            }
+          else
+            {
+            str.Source = &levels[d + 1][0] + ( ( d + 1 == last ) ? coreOffset : 0 );
+            str.Size = coreSize;
+            }
+          str.Destination = ( d > 0 ) ? &levels[d][0] : &str.Hessian[c][0];
+          cachedOrders[d] = ( d > 0 ) ? static_cast<int>( orders[c][d] ) : -1;
+
+          this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+          this->GetMultiThreader()->SetSingleMethod(
+            this->HessianThreaderCallback, &str );
+          this->GetMultiThreader()->SingleMethodExecute();
+          }
+        }
+
+      str.IsEigenPass = true;
+      str.Output = output->GetBufferPointer()
+        + sliceSize * static_cast<SizeValueType>( start - outputStart );
+      str.NumberOfPixels = numberOfPixels;
+      str.IsFirstScale = ( s == 0 );
+
+      this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+      this->GetMultiThreader()->SetSingleMethod(
+        this->HessianThreaderCallback, &str );
+      this->GetMultiThreader()->SingleMethodExecute();
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+ITK_THREAD_RETURN_TYPE
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::HessianThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  HessianThreadStruct *str =
+    static_cast<HessianThreadStruct *>( info->UserData );
+
+  if( str->IsEigenPass )
+    {
+    str->Filter->ThreadedComputeMeasure( str, info->ThreadID,
+      info->NumberOfThreads );
+    }
+  else
+    {
+    str->Filter->ThreadedFilterLines( str, info->ThreadID,
+      info->NumberOfThreads );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::ThreadedFilterLines( HessianThreadStruct *str, ThreadIdType threadId,
+  ThreadIdType numberOfThreads )
+{
+  const unsigned int d = str->Dimension;
+  const SizeValueType length = str->Size[d];
+  SizeValueType numberOfLines = 1;
+  OffsetValueType stride = 1;
+  for( unsigned int k = 0; k < ImageDimension; k++ )
+    {
+    if( k != d )
+      {
+      numberOfLines *= str->Size[k];
+      }
+    if( k < d )
+      {
+      stride *= static_cast<OffsetValueType>( str->Size[k] );
+      }
+    }
+  const SizeValueType firstLine = numberOfLines * threadId / numberOfThreads;
+  const SizeValueType lastLine =
+    numberOfLines * ( threadId + 1 ) / numberOfThreads;
+
+  const RealType *N = str->Coefficients.N;
+  const RealType *M = str->Coefficients.M;
+  const RealType *D = str->Coefficients.D;
+  const RealType *BN = str->Coefficients.BN;
+  const RealType *BM = str->Coefficients.BM;
+
+  std::vector<RealType> data( length );
+  std::vector<RealType> causal( length );
+  std::vector<RealType> anticausal( length );
+
+  for( SizeValueType l = firstLine; l < lastLine; l++ )
+    {
+    const OffsetValueType lineStart = static_cast<OffsetValueType>( l % stride )
+      + static_cast<OffsetValueType>( l / stride ) * stride
+      * static_cast<OffsetValueType>( length );
+
+    OffsetValueType offset = lineStart;
+    for( SizeValueType i = 0; i < length; i++, offset += stride )
+      {
+      data[i] = str->Source[offset];
+      }
+
+    /**
+     * Causal and anticausal parts, the values beyond the ends of the line
+     * being those at the ends, as in RecursiveSeparableImageFilter.
+     */
+    const RealType first = data[0];
+    causal[0] = first * ( N[0] + N[1] + N[2] + N[3] )
+      - first * ( BN[0] + BN[1] + BN[2] + BN[3] );
+    causal[1] = data[1] * N[0] + first * ( N[1] + N[2] + N[3] )
+      - causal[0] * D[0] - first * ( BN[1] + BN[2] + BN[3] );
+    causal[2] = data[2] * N[0] + data[1] * N[1] + first * ( N[2] + N[3] )
+      - causal[1] * D[0] - causal[0] * D[1] - first * ( BN[2] + BN[3] );
+    causal[3] = data[3] * N[0] + data[2] * N[1] + data[1] * N[2] + first * N[3]
+      - causal[2] * D[0] - causal[1] * D[1] - causal[0] * D[2] - first * BN[3];
+    for( SizeValueType i = 4; i < length; i++ )
+      {
+      causal[i] = data[i] * N[0] + data[i - 1] * N[1] + data[i - 2] * N[2]
+        + data[i - 3] * N[3] - causal[i - 1] * D[0] - causal[i - 2] * D[1]
+        - causal[i - 3] * D[2] - causal[i - 4] * D[3];
+      }
+
+    const SizeValueType e = length - 1;
+    const RealType lastValue = data[e];
+    anticausal[e] = lastValue * ( M[0] + M[1] + M[2] + M[3] )
+      - lastValue * ( BM[0] + BM[1] + BM[2] + BM[3] );
+    anticausal[e - 1] = data[e] * M[0] + lastValue * ( M[1] + M[2] + M[3] )
+      - anticausal[e] * D[0] - lastValue * ( BM[1] + BM[2] + BM[3] );
+    anticausal[e - 2] = data[e - 1] * M[0] + data[e] * M[1]
+      + lastValue * ( M[2] + M[3] ) - anticausal[e - 1] * D[0]
+      - anticausal[e] * D[1] - lastValue * ( BM[2] + BM[3] );
+    anticausal[e - 3] = data[e - 2] * M[0] + data[e - 1] * M[1] + data[e] * M[2]
+      + lastValue * M[3] - anticausal[e - 2] * D[0] - anticausal[e - 1] * D[1]
+      - anticausal[e] * D[2] - lastValue * BM[3];
+    for( SizeValueType i = e - 3; i-- > 0; )
+      {
+      anticausal[i] = data[i + 1] * M[0] + data[i + 2] * M[1]
+        + data[i + 3] * M[2] + data[i + 4] * M[3] - anticausal[i + 1] * D[0]
+        - anticausal[i + 2] * D[1] - anticausal[i + 3] * D[2]
+        - anticausal[i + 4] * D[3];
+      }
+
+    offset = lineStart;
+    for( SizeValueType i = 0; i < length; i++, offset += stride )
+      {
+      str->Destination[offset] = causal[i] + anticausal[i];
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::ThreadedComputeMeasure( HessianThreadStruct *str, ThreadIdType threadId,
+  ThreadIdType numberOfThreads )
+{
+  const SizeValueType first = str->NumberOfPixels * threadId / numberOfThreads;
+  const SizeValueType last =
+    str->NumberOfPixels * ( threadId + 1 ) / numberOfThreads;
+
+  const RealType *components[NumberOfHessianComponents];
+  for( unsigned int c = 0; c < NumberOfHessianComponents; c++ )
+    {
+    components[c] = &str->Hessian[c][0];
+    }
+
+  RealType hessian[NumberOfHessianComponents];
+  EigenValuesType eigenValues;
+  for( SizeValueType n = first; n < last; n++ )
+    {
+    for( unsigned int c = 0; c < NumberOfHessianComponents; c++ )
+      {
+      hessian[c] = components[c][n];
+      }
+    ComputeEigenValues( hessian, eigenValues );
+
+    const RealType measure = this->m_Functor( eigenValues );
+    if( str->IsFirstScale ||
+      measure > static_cast<RealType>( str->Output[n] ) )
+      {
+      str->Output[n] = static_cast<OutputPixelType>( measure );
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::ComputeEigenValues( const RealType *hessian, EigenValuesType & eigenValues )
+{
+  RealType lambda[3];
+
+  if( ImageDimension == 2 )
+    {
+    const RealType mean = 0.5 * ( hessian[0] + hessian[2] );
+    const RealType radius = vcl_sqrt( vnl_math_sqr( 0.5 * ( hessian[0]
+      - hessian[2] ) ) + vnl_math_sqr( hessian[1] ) );
+    lambda[0] = mean - radius;
+    lambda[1] = mean + radius;
+    }
+  else
+    {
+    /**
+     * Trigonometric solution of the characteristic polynomial of the
+     * matrix A = q I + p B, the eigenvalues of B being
+     * 2 cos( acos( det( B ) / 2 ) / 3 + 2 k pi / 3 ).
+     */
+    const RealType q = ( hessian[0] + hessian[3] + hessian[5] ) / 3.0;
+    const RealType a00 = hessian[0] - q;
+    const RealType a11 = hessian[3] - q;
+    const RealType a22 = hessian[5] - q;
+    const RealType p2 = a00 * a00 + a11 * a11 + a22 * a22 + 2.0 *
+      ( hessian[1] * hessian[1] + hessian[2] * hessian[2]
+      + hessian[4] * hessian[4] );
+    if( p2 <= 0.0 )
+      {
+      lambda[0] = lambda[1] = lambda[2] = q;
+      }
+    else
+      {
+      const RealType p = vcl_sqrt( p2 / 6.0 );
+      const RealType b00 = a00 / p;
+      const RealType b01 = hessian[1] / p;
+      const RealType b02 = hessian[2] / p;
+      const RealType b11 = a11 / p;
+      const RealType b12 = hessian[4] / p;
+      const RealType b22 = a22 / p;
+      const RealType r = 0.5 * ( b00 * ( b11 * b22 - b12 * b12 )
+        - b01 * ( b01 * b22 - b12 * b02 ) + b02 * ( b01 * b12 - b11 * b02 ) );
+      const RealType phi = vcl_acos( vnl_math_max( static_cast<RealType>( -1.0 ),
+        vnl_math_min( static_cast<RealType>( 1.0 ), r ) ) ) / 3.0;
+      lambda[2] = q + 2.0 * p * vcl_cos( phi );
+      lambda[0] = q + 2.0 * p * vcl_cos( phi + 2.0 * vnl_math::pi / 3.0 );
+      lambda[1] = 3.0 * q - lambda[0] - lambda[2];
+      }
+    }
+
+  /**
+   * Increasing order of magnitude.
+   */
+  for( unsigned int i = 1; i < ImageDimension; i++ )
+    {
+    for( unsigned int j = i; j > 0 &&
+      vnl_math_abs( lambda[j] ) < vnl_math_abs( lambda[j - 1] ); j-- )
+      {
+      std::swap( lambda[j], lambda[j - 1] );
+      }
+    }
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    eigenValues[i] = lambda[i];
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::ComputeRecursiveCoefficients( RealType sigma, unsigned int order,
+  unsigned int d, RecursiveCoefficientsType & coefficients ) const
+{
+  /**
+   * Deriche's approximation of the Gaussian and of its derivatives by sums
+   * of exponentials, with the parameters of RecursiveGaussianImageFilter.
+   */
+  const RealType A1[3] = { 1.3530, -0.6724, -1.3563 };
+  const RealType B1[3] = { 1.8151, -3.4327, 5.2318 };
+  const RealType W1 = 0.6681;
+  const RealType L1 = -1.3932;
+  const RealType A2[3] = { -0.3531, 0.6724, 0.3446 };
+  const RealType B2[3] = { 0.0902, 0.6100, -2.2355 };
+  const RealType W2 = 2.0787;
+  const RealType L2 = -1.3732;
+
+  const RealType spacing = this->GetInput()->GetSpacing()[d];
+  const RealType sigmad = sigma / spacing;
+
+  const RealType sin1 = vcl_sin( W1 / sigmad );
+  const RealType sin2 = vcl_sin( W2 / sigmad );
+  const RealType cos1 = vcl_cos( W1 / sigmad );
+  const RealType cos2 = vcl_cos( W2 / sigmad );
+  const RealType exp1 = vcl_exp( L1 / sigmad );
+  const RealType exp2 = vcl_exp( L2 / sigmad );
+
+  RealType *D = coefficients.D;
+  D[3] = exp1 * exp1 * exp2 * exp2;
+  D[2] = -2.0 * cos1 * exp1 * exp2 * exp2 - 2.0 * cos2 * exp2 * exp1 * exp1;
+  D[1] = 4.0 * cos2 * cos1 * exp1 * exp2 + exp1 * exp1 + exp2 * exp2;
+  D[0] = -2.0 * ( exp2 * cos2 + exp1 * cos1 );
+
+  const RealType SD = 1.0 + D[0] + D[1] + D[2] + D[3];
+  const RealType DD = D[0] + 2.0 * D[1] + 3.0 * D[2] + 4.0 * D[3];
+  const RealType ED = D[0] + 4.0 * D[1] + 9.0 * D[2] + 16.0 * D[3];
+
+  /**
+   * Numerators of the orders 0, 1 and 2, and their sums weighted by 1,
+   * k and k^2.
+   */
+  RealType Ns[3][4];
+  RealType SN[3];
+  RealType DN[3];
+  RealType EN[3];
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    Ns[k][0] = A1[k] + A2[k];
+    Ns[k][1] = exp2 * ( B2[k] * sin2 - ( A2[k] + 2.0 * A1[k] ) * cos2 )
+      + exp1 * ( B1[k] * sin1 - ( A1[k] + 2.0 * A2[k] ) * cos1 );
+    Ns[k][2] = 2.0 * exp1 * exp2 * ( ( A1[k] + A2[k] ) * cos2 * cos1
+      - B1[k] * cos2 * sin1 - B2[k] * cos1 * sin2 )
+      + A2[k] * exp1 * exp1 + A1[k] * exp2 * exp2;
+    Ns[k][3] = exp2 * exp1 * exp1 * ( B2[k] * sin2 - A2[k] * cos2 )
+      + exp1 * exp2 * exp2 * ( B1[k] * sin1 - A1[k] * cos1 );
+
+    SN[k] = Ns[k][0] + Ns[k][1] + Ns[k][2] + Ns[k][3];
+    DN[k] = Ns[k][1] + 2.0 * Ns[k][2] + 3.0 * Ns[k][3];
+    EN[k] = Ns[k][1] + 4.0 * Ns[k][2] + 9.0 * Ns[k][3];
+    }
+
+  /**
+   * Normalization of the response to 1, x and x^2 / 2, the derivatives
+   * being then per pixel, and conversion to physical units or to the
+   * normalized derivatives sigma^order d^order / dx^order.
+   */
+  RealType *N = coefficients.N;
+  RealType normalization = 1.0;
+  if( order == 0 )
+    {
+    for( unsigned int i = 0; i < 4; i++ )
+      {
+      N[i] = Ns[0][i];
+      }
+    normalization = 1.0 / ( 2.0 * SN[0] / SD - N[0] );
+    }
+  else if( order == 1 )
+    {
+    for( unsigned int i = 0; i < 4; i++ )
+      {
+      N[i] = Ns[1][i];
+      }
+    normalization = ( SD * SD ) / ( 2.0 * ( SN[1] * DD - DN[1] * SD ) );
+    }
+  else
+    {
+    const RealType beta = -( 2.0 * SN[2] - SD * Ns[2][0] )
+      / ( 2.0 * SN[0] - SD * Ns[0][0] );
+    for( unsigned int i = 0; i < 4; i++ )
+      {
+      N[i] = Ns[2][i] + beta * Ns[0][i];
+      }
+    const RealType SN2 = SN[2] + beta * SN[0];
+    const RealType DN2 = DN[2] + beta * DN[0];
+    const RealType EN2 = EN[2] + beta * EN[0];
+    normalization = ( SD * SD * SD ) / ( EN2 * SD * SD - ED * SN2 * SD
+      - 2.0 * DN2 * DD * SD + 2.0 * DD * DD * SN2 );
+    }
+  if( this->m_NormalizeAcrossScale )
+    {
+    normalization *= vcl_pow( sigmad, static_cast<RealType>( order ) );
+    }
+  else
+    {
+    normalization /= vcl_pow( spacing, static_cast<RealType>( order ) );
+    }
+  for( unsigned int i = 0; i < 4; i++ )
+    {
+    N[i] *= normalization;
+    }
+
+  /**
+   * Anticausal numerators, the impulse response being symmetric for the
+   * even orders and antisymmetric for the first order, and coefficients of
+   * the edge extension.
+   */
+  const RealType sign = ( order == 1 ) ? -1.0 : 1.0;
+  RealType *M = coefficients.M;
+  M[0] = sign * ( N[1] - D[0] * N[0] );
+  M[1] = sign * ( N[2] - D[1] * N[0] );
+  M[2] = sign * ( N[3] - D[2] * N[0] );
+  M[3] = sign * ( -D[3] * N[0] );
+
+  const RealType sumN = N[0] + N[1] + N[2] + N[3];
+  const RealType sumM = M[0] + M[1] + M[2] + M[3];
+  for( unsigned int i = 0; i < 4; i++ )
+    {
+    coefficients.BN[i] = D[i] * sumN / SD;
+    coefficients.BM[i] = D[i] * sumM / SD;
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFunction>
+void
+MultiScaleRecursiveHessianMeasureImageFilter<TInputImage, TOutputImage, TFunction>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Sigma minimum: " << this->m_SigmaMinimum << std::endl;
+  os << indent << "Sigma maximum: " << this->m_SigmaMaximum << std::endl;
+  os << indent << "Number of sigma steps: "
+     << this->m_NumberOfSigmaSteps << std::endl;
+  os << indent << "Normalize across scale: "
+     << this->m_NormalizeAcrossScale << std::endl;
+  os << indent << "Number of slices per slab: "
+     << this->m_NumberOfSlicesPerSlab << std::endl;
+  os << indent << "Slab padding factor: "
+     << this->m_SlabPaddingFactor << std::endl;
+}
+
+} // end namespace itk
+
+#endif
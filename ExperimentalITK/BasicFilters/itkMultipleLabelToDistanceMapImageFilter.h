@@ -24,6 +24,22 @@ namespace itk
 
 /** \class MultipleLabelToDistanceMapImageFilter.h
  * \brief Image filter.
+ *
+ * The i-th component of the output is the signed distance (negative
+ * inside) to the contour of label i + 1, as computed by
+ * SignedMaurerDistanceMapImageFilter, or exp( -( d / sigma )^2 ) if the
+ * image is normalized.  The labels are found and their contour voxels
+ * marked in a single pass over the input, and the distances of each
+ * present label are computed by separable exact (lower envelope)
+ * transforms, the rows of each sweep being distributed over the threads.
+ * Absent labels are skipped and, if CropToLabelBoundingBoxes is on, the
+ * distances of a label are only computed in its bounding box padded by
+ * BoundingBoxPadding voxels.  The voxels outside are treated as infinitely
+ * far (0 if normalized).
+ *
+ * If GenerateNearestLabelImages is on, a single sweep over all the
+ * labeled voxels also gives, for every voxel, the nearest label (the
+ * voxel's own label inside a label) and the distance to it.
  */
 
 template <class TInputImage, class TOutputImage>
@@ -60,9 +76,12 @@ public:
   typedef typename InputImageType::SpacingType                InputSpacingType;
   typedef typename OutputImageType::SpacingType               OutputSpacingType;
 
+  typedef typename InputImageType::RegionType                 InputRegionType;
+
   typedef float                                               RealType;
   typedef Image<RealType, 
     itkGetStaticConstMacro( ImageDimension )>                 RealImageType;
+  typedef InputImageType                                      LabelImageType;
 
 
   /** Set/Get if the distance should be squared. */
@@ -84,6 +103,27 @@ public:
   itkSetMacro( Sigma, RealType );
   itkGetConstMacro( Sigma, RealType );
 
+  /** Set/Get if the distances of a label are only computed in its padded
+   * bounding box. */
+  itkSetMacro( CropToLabelBoundingBoxes, bool );
+  itkGetConstMacro( CropToLabelBoundingBoxes, bool );
+  itkBooleanMacro( CropToLabelBoundingBoxes );
+
+  /** Set/Get the padding of the bounding boxes, in voxels. */
+  itkSetMacro( BoundingBoxPadding, InputSizeType );
+  itkGetConstMacro( BoundingBoxPadding, InputSizeType );
+
+  /** Set/Get if the nearest label and nearest label distance images are
+   * generated. */
+  itkSetMacro( GenerateNearestLabelImages, bool );
+  itkGetConstMacro( GenerateNearestLabelImages, bool );
+  itkBooleanMacro( GenerateNearestLabelImages );
+
+  /** Nearest label of each voxel and the (squared, see SquaredDistance)
+   * distance to it.  Only available if GenerateNearestLabelImages is on. */
+  itkGetObjectMacro( NearestLabelImage, LabelImageType );
+  itkGetObjectMacro( NearestLabelDistanceImage, RealImageType );
+
 protected:
 
   MultipleLabelToDistanceMapImageFilter ();
@@ -93,7 +133,32 @@ protected:
   void PrintSelf( std::ostream& os, Indent indent ) const;
 
   void GenerateData();
-  
+
+  /** Internal structure used for passing the sweeps to the threads. */
+  struct DistanceThreadStruct
+  {
+    Self                                                     *Filter;
+    RealType                                                 *Distances;
+    InputPixelType                                           *Labels;
+    InputSizeType                                             Size;
+    unsigned int                                              Dimension;
+    double                                                    Spacing;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE DistanceThreaderCallback( void *arg );
+
+  /** Squared Euclidean distances, in place, of the buffer of an image of
+   * the given size.  The sites have a zero distance and the other voxels
+   * NumericTraits<RealType>::max().  If labels is not NULL, the label of
+   * the nearest site is propagated as well. */
+  void ComputeSquaredDistances( RealType *distances, InputPixelType *labels,
+    const InputSizeType & size );
+
+  /** Distances along one dimension of the rows first, ..., last - 1. */
+  void ThreadedSweep( DistanceThreadStruct *str, unsigned long first,
+    unsigned long last );
+
 private:
 
   MultipleLabelToDistanceMapImageFilter(const Self&); //purposely not implemented
@@ -105,6 +170,13 @@ private:
   bool                                                        m_NormalizeImage;
   RealType                                                    m_Sigma;
 
+  bool                                                        m_CropToLabelBoundingBoxes;
+  InputSizeType                                               m_BoundingBoxPadding;
+
+  bool                                                        m_GenerateNearestLabelImages;
+  typename LabelImageType::Pointer                            m_NearestLabelImage;
+  typename RealImageType::Pointer                             m_NearestLabelDistanceImage;
+
 };
 
 } // end namespace itk
@@ -3,13 +3,15 @@
 
 #include "itkMultipleLabelToDistanceMapImageFilter.h"
 
-#include "itkBinaryThresholdImageFilter.h"
+#include "itkConstNeighborhoodIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
-#include "itkSignedMaurerDistanceMapImageFilter.h"
-#include "itkStatisticsImageFilter.h"
 
 #include "vnl/vnl_math.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -18,8 +20,13 @@ MultipleLabelToDistanceMapImageFilter<TInputImage, TOutputImage>
 ::MultipleLabelToDistanceMapImageFilter() : m_UseImageSpacing( true ),
                                             m_SquaredDistance( false ),
                                             m_NormalizeImage( true ),
-                                            m_Sigma( 1.0 )
+                                            m_Sigma( 1.0 ),
+                                            m_CropToLabelBoundingBoxes( false ),
+                                            m_GenerateNearestLabelImages( false )
 {
+  this->m_BoundingBoxPadding.Fill( 0 );
+  this->m_NearestLabelImage = NULL;
+  this->m_NearestLabelDistanceImage = NULL;
 }
 
 template <class TInputImage, class TOutputImage>
@@ -33,72 +40,377 @@ void
 MultipleLabelToDistanceMapImageFilter<TInputImage, TOutputImage>
 ::GenerateData()
 {
+  const InputImageType *input = this->GetInput();
+  const InputRegionType region = input->GetRequestedRegion();
+
   typename OutputImageType::Pointer output = OutputImageType::New();
-  output->SetOrigin( this->GetInput()->GetOrigin() );
-  output->SetRegions( this->GetInput()->GetRequestedRegion() );
-  output->SetSpacing( this->GetInput()->GetSpacing() );
+  output->SetOrigin( input->GetOrigin() );
+  output->SetRegions( region );
+  output->SetSpacing( input->GetSpacing() );
+  output->SetDirection( input->GetDirection() );
   output->Allocate();
 
-  typedef StatisticsImageFilter<InputImageType> StatsFilterType;
-  typename StatsFilterType::Pointer stats = StatsFilterType::New();
-  stats->SetInput( this->GetInput() );
-  stats->Update();
+  const RealType infinity = NumericTraits<RealType>::max();
+
+  /**
+   * Find the present labels and their bounding boxes in a single pass.
+   */
+  std::vector<bool> isPresent;
+  std::vector<InputIndexType> minimumIndex;
+  std::vector<InputIndexType> maximumIndex;
 
-  OutputPixelType distances( stats->GetMaximum() );
-  distances.fill( 0 );
+  ImageRegionConstIteratorWithIndex<InputImageType> ItI( input, region );
+  for ( ItI.GoToBegin(); !ItI.IsAtEnd(); ++ItI )
+    {
+    if ( ItI.Get() <= NumericTraits<InputPixelType>::Zero )
+      {
+      continue;
+      }
+    const unsigned int label = static_cast<unsigned int>( ItI.Get() );
+    const InputIndexType index = ItI.GetIndex();
+    if ( label > isPresent.size() )
+      {
+      isPresent.resize( label, false );
+      minimumIndex.resize( label );
+      maximumIndex.resize( label );
+      }
+    if ( !isPresent[label-1] )
+      {
+      isPresent[label-1] = true;
+      minimumIndex[label-1] = index;
+      maximumIndex[label-1] = index;
+      continue;
+      }
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      minimumIndex[label-1][d] = vnl_math_min( minimumIndex[label-1][d], index[d] );
+      maximumIndex[label-1][d] = vnl_math_max( maximumIndex[label-1][d], index[d] );
+      }
+    }
+  const unsigned int maximumLabel = isPresent.size();
+
+  /**
+   * Voxels of an absent label, or outside the bounding box of a label, are
+   * infinitely far from it.
+   */
+  OutputPixelType distances( maximumLabel );
+  distances.fill( this->m_NormalizeImage ? 0 : infinity );
   output->FillBuffer( distances );
-  
-  for ( unsigned int label = 1; label <= stats->GetMaximum(); label++ )
+
+  /**
+   * Mark the contour voxels, i.e. the voxels with a fully connected
+   * neighbor of another label, as in SignedMaurerDistanceMapImageFilter.
+   * The contour of a label is made of the contour voxels of that label, so
+   * a single pass serves all the labels.
+   */
+  typedef Image<unsigned char,
+    itkGetStaticConstMacro( ImageDimension )> ContourImageType;
+  typename ContourImageType::Pointer contour = ContourImageType::New();
+  contour->SetRegions( region );
+  contour->Allocate();
+  contour->FillBuffer( 0 );
+
+  if ( maximumLabel > 0 )
     {
+    typename ConstNeighborhoodIterator<InputImageType>::RadiusType radius;
+    radius.Fill( 1 );
+    ConstNeighborhoodIterator<InputImageType> ItN( radius, input, region );
+    ImageRegionIterator<ContourImageType> ItC( contour, region );
+    for ( ItN.GoToBegin(), ItC.GoToBegin(); !ItN.IsAtEnd(); ++ItN, ++ItC )
+      {
+      const InputPixelType center = ItN.GetCenterPixel();
+      if ( center <= NumericTraits<InputPixelType>::Zero )
+        {
+        continue;
+        }
+      for ( unsigned int n = 0; n < ItN.Size(); n++ )
+        {
+        if ( ItN.GetPixel( n ) != center )
+          {
+          ItC.Set( 1 );
+          break;
+          }
+        }
+      }
+    }
+
+  for ( unsigned int label = 1; label <= maximumLabel; label++ )
+    {
+    if ( !isPresent[label-1] )
+      {
+      continue;
+      }
+
+    InputRegionType labelRegion = region;
+    if ( this->m_CropToLabelBoundingBoxes )
+      {
+      InputSizeType size;
+      for ( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        size[d] = maximumIndex[label-1][d] - minimumIndex[label-1][d] + 1;
+        }
+      labelRegion.SetIndex( minimumIndex[label-1] );
+      labelRegion.SetSize( size );
+      labelRegion.PadByRadius( this->m_BoundingBoxPadding );
+      labelRegion.Crop( region );
+      }
+
+    std::vector<RealType> squaredDistances(
+      labelRegion.GetNumberOfPixels(), infinity );
+
+    ImageRegionConstIterator<InputImageType> ItL( input, labelRegion );
+    ImageRegionConstIterator<ContourImageType> ItC( contour, labelRegion );
+    unsigned long n = 0;
+    for ( ItL.GoToBegin(), ItC.GoToBegin(); !ItL.IsAtEnd(); ++ItL, ++ItC, ++n )
+      {
+      if ( ItC.Get() && ItL.Get() == static_cast<InputPixelType>( label ) )
+        {
+        squaredDistances[n] = 0;
+        }
+      }
+
+    this->ComputeSquaredDistances( &squaredDistances[0], NULL,
+      labelRegion.GetSize() );
+
+    ImageRegionIterator<OutputImageType> ItO( output, labelRegion );
+    n = 0;
+    for ( ItL.GoToBegin(), ItO.GoToBegin(); !ItO.IsAtEnd(); ++ItL, ++ItO, ++n )
+      {
+      RealType distance = squaredDistances[n];
+      if ( distance < infinity && !this->m_SquaredDistance )
+        {
+        distance = vcl_sqrt( distance );
+        }
+      if ( ItL.Get() == static_cast<InputPixelType>( label ) )
+        {
+        distance = -distance;
+        }
 
-    typedef BinaryThresholdImageFilter
-      <InputImageType, InputImageType> ThresholderType;
-    typename ThresholderType::Pointer thresholder = ThresholderType::New();
-    thresholder->SetInput( this->GetInput() );
-    thresholder->SetInsideValue( 1 );
-    thresholder->SetOutsideValue( 0 );
-    thresholder->SetLowerThreshold( label );
-    thresholder->SetUpperThreshold( label );
-    thresholder->Update();
-
-    typedef SignedMaurerDistanceMapImageFilter
-      <InputImageType, RealImageType> DistanceFilterType;
-    typename DistanceFilterType::Pointer distancer = DistanceFilterType::New();
-    distancer->SetInput( thresholder->GetOutput() );
-    distancer->SetBackgroundValue( 0 );
-    distancer->SetInsideIsPositive( false );
-    distancer->SetUseImageSpacing( this->m_UseImageSpacing );
-    distancer->SetSquaredDistance( this->m_SquaredDistance );
-    distancer->Update();
-
-    ImageRegionIterator<OutputImageType> ItO( output, 
-      output->GetLargestPossibleRegion() );
-    ImageRegionIterator<RealImageType> ItD( distancer->GetOutput(), 
-      distancer->GetOutput()->GetLargestPossibleRegion() );
-
-    ItO.GoToBegin();
-    ItD.GoToBegin();
-    while ( !ItO.IsAtEnd() )
-      {    
       OutputPixelType distances = ItO.Get();
       if ( this->m_NormalizeImage )
         {
-        distances[label-1] = vcl_exp( -vnl_math_sqr( ItD.Get() / this->m_Sigma ) );
+        distances[label-1] = vcl_exp( -vnl_math_sqr( distance / this->m_Sigma ) );
         }   
       else
         {
-        distances[label-1] = ItD.Get();
+        distances[label-1] = distance;
         }            
       ItO.Set( distances );
-      ++ItO;
-      ++ItD;
       }
     } 
 
+  /**
+   * Nearest label of every voxel in a single sweep over all the labeled
+   * voxels, which are the sites of a multi-label Voronoi diagram.
+   */
+  this->m_NearestLabelImage = NULL;
+  this->m_NearestLabelDistanceImage = NULL;
+  if ( this->m_GenerateNearestLabelImages )
+    {
+    std::vector<RealType> squaredDistances(
+      region.GetNumberOfPixels(), infinity );
+    std::vector<InputPixelType> labels( region.GetNumberOfPixels(),
+      NumericTraits<InputPixelType>::Zero );
+
+    ImageRegionConstIterator<InputImageType> ItL( input, region );
+    unsigned long n = 0;
+    for ( ItL.GoToBegin(); !ItL.IsAtEnd(); ++ItL, ++n )
+      {
+      if ( ItL.Get() > NumericTraits<InputPixelType>::Zero )
+        {
+        squaredDistances[n] = 0;
+        labels[n] = ItL.Get();
+        }
+      }
+
+    this->ComputeSquaredDistances( &squaredDistances[0], &labels[0],
+      region.GetSize() );
+
+    this->m_NearestLabelImage = LabelImageType::New();
+    this->m_NearestLabelImage->CopyInformation( input );
+    this->m_NearestLabelImage->SetRegions( region );
+    this->m_NearestLabelImage->Allocate();
+
+    this->m_NearestLabelDistanceImage = RealImageType::New();
+    this->m_NearestLabelDistanceImage->CopyInformation( input );
+    this->m_NearestLabelDistanceImage->SetRegions( region );
+    this->m_NearestLabelDistanceImage->Allocate();
+
+    ImageRegionIterator<LabelImageType> ItN( this->m_NearestLabelImage, region );
+    ImageRegionIterator<RealImageType> ItD(
+      this->m_NearestLabelDistanceImage, region );
+    n = 0;
+    for ( ItN.GoToBegin(), ItD.GoToBegin(); !ItN.IsAtEnd(); ++ItN, ++ItD, ++n )
+      {
+      RealType distance = squaredDistances[n];
+      if ( distance < infinity && !this->m_SquaredDistance )
+        {
+        distance = vcl_sqrt( distance );
+        }
+      ItN.Set( labels[n] );
+      ItD.Set( distance );
+      }
+    }
 
   this->GraftOutput( output );
 }
 
+template <class TInputImage, class TOutputImage>
+void
+MultipleLabelToDistanceMapImageFilter<TInputImage, TOutputImage>
+::ComputeSquaredDistances( RealType *distances, InputPixelType *labels,
+  const InputSizeType & size )
+{
+  DistanceThreadStruct str;
+  str.Filter = this;
+  str.Distances = distances;
+  str.Labels = labels;
+  str.Size = size;
+
+  /**
+   * The transform is separable: each sweep replaces the distances along
+   * the rows of one dimension by the lower envelope of the parabolas
+   * rooted at the previous distances.  The rows are independent.
+   */
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    if ( size[d] < 2 )
+      {
+      continue;
+      }
+    str.Dimension = d;
+    str.Spacing = 1.0;
+    if ( this->m_UseImageSpacing )
+      {
+      str.Spacing = this->GetInput()->GetSpacing()[d];
+      }
+
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod(
+      this->DistanceThreaderCallback, &str );
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+ITK_THREAD_RETURN_TYPE
+MultipleLabelToDistanceMapImageFilter<TInputImage, TOutputImage>
+::DistanceThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  DistanceThreadStruct *str =
+    static_cast<DistanceThreadStruct *>( info->UserData );
+
+  unsigned long numberOfRows = 1;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    if ( d != str->Dimension )
+      {
+      numberOfRows *= str->Size[d];
+      }
+    }
+
+  const unsigned long first = numberOfRows * info->ThreadID
+    / info->NumberOfThreads;
+  const unsigned long last = numberOfRows * ( info->ThreadID + 1 )
+    / info->NumberOfThreads;
+  if ( first < last )
+    {
+    str->Filter->ThreadedSweep( str, first, last );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage>
+void
+MultipleLabelToDistanceMapImageFilter<TInputImage, TOutputImage>
+::ThreadedSweep( DistanceThreadStruct *str, unsigned long first,
+  unsigned long last )
+{
+  const unsigned int dimension = str->Dimension;
+  const long length = static_cast<long>( str->Size[dimension] );
+  const double spacing2 = vnl_math_sqr( str->Spacing );
+  const RealType infinity = NumericTraits<RealType>::max();
+
+  unsigned long stride = 1;
+  for ( unsigned int d = 0; d < dimension; d++ )
+    {
+    stride *= str->Size[d];
+    }
+
+  std::vector<double> f( length );
+  std::vector<InputPixelType> siteLabels( length );
+  std::vector<long> v( length );
+  std::vector<double> z( length + 1 );
+
+  for ( unsigned long row = first; row < last; row++ )
+    {
+    const unsigned long offset = ( row / stride ) * stride * length
+      + row % stride;
+    RealType *distances = str->Distances + offset;
+    InputPixelType *labels = str->Labels ? str->Labels + offset : NULL;
+
+    /**
+     * Lower envelope of the parabolas f[q] + ( ( i - q ) h )^2, the sites
+     * at infinity being left out.
+     */
+    long k = -1;
+    for ( long q = 0; q < length; q++ )
+      {
+      const RealType value = distances[q * stride];
+      if ( value >= infinity )
+        {
+        continue;
+        }
+      f[q] = value;
+      if ( labels )
+        {
+        siteLabels[q] = labels[q * stride];
+        }
+
+      double s = -NumericTraits<double>::max();
+      while ( k >= 0 )
+        {
+        const long p = v[k];
+        s = ( ( f[q] + spacing2 * q * q ) - ( f[p] + spacing2 * p * p ) )
+          / ( 2.0 * spacing2 * ( q - p ) );
+        if ( s > z[k] )
+          {
+          break;
+          }
+        k--;
+        }
+      k++;
+      v[k] = q;
+      z[k] = ( k == 0 ) ? -NumericTraits<double>::max() : s;
+      z[k+1] = NumericTraits<double>::max();
+      }
+
+    if ( k < 0 )
+      {
+      continue;
+      }
+
+    long j = 0;
+    for ( long i = 0; i < length; i++ )
+      {
+      while ( z[j+1] < i )
+        {
+        j++;
+        }
+      const long p = v[j];
+      distances[i * stride] = static_cast<RealType>(
+        f[p] + spacing2 * vnl_math_sqr( static_cast<double>( i - p ) ) );
+      if ( labels )
+        {
+        labels[i * stride] = siteLabels[p];
+        }
+      }
+    }
+}
+
 /**
  * Standard "PrintSelf" method
  */
@@ -118,6 +430,12 @@ MultipleLabelToDistanceMapImageFilter<TInputImage, TOutputImage>
      << this->m_NormalizeImage << std::endl;
   os << indent << "Sigma: "
      << this->m_Sigma << std::endl;
+  os << indent << "Crop to label bounding boxes: "
+     << this->m_CropToLabelBoundingBoxes << std::endl;
+  os << indent << "Bounding box padding: "
+     << this->m_BoundingBoxPadding << std::endl;
+  os << indent << "Generate nearest label images: "
+     << this->m_GenerateNearestLabelImages << std::endl;
 }
 
 
@@ -0,0 +1,127 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkPointKdTree.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkPointKdTree_h
+#define __itkPointKdTree_h
+
+#include "itkObject.h"
+
+#include "itkPoint.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class PointKdTree
+ * \brief Balanced kd-tree over a set of points for nearest neighbor
+ * distance queries from several threads.
+ *
+ * The points are reordered in place so that the median of each range,
+ * along the dimension of largest extent, is the node splitting the range,
+ * which needs no other storage than the split dimensions.  Unlike
+ * Statistics::KdTree, the queries keep no state in the tree so that
+ * GetNearestSquaredDistance() can be called concurrently.
+ *
+ * \sa DirectedHausdorffDistanceImageFilter
+ * \sa ContourDirectedMeanDistanceImageFilter
+ */
+template <class TRealType, unsigned int VDimension>
+class ITK_EXPORT PointKdTree : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef PointKdTree                                         Self;
+  typedef Object                                              Superclass;
+  typedef SmartPointer<Self>                                  Pointer;
+  typedef SmartPointer<const Self>                            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( PointKdTree, Object );
+
+  itkStaticConstMacro( Dimension, unsigned int, VDimension );
+
+  typedef TRealType                                           RealType;
+  typedef Point<RealType, VDimension>                         PointType;
+  typedef std::vector<PointType>                              PointsContainerType;
+
+  /** Set the points and build the tree. */
+  void SetPoints( const PointsContainerType & points );
+
+  /** Get the points, in the order of the tree. */
+  const PointsContainerType & GetPoints() const
+    { return this->m_Points; }
+
+  SizeValueType GetNumberOfPoints() const
+    { return this->m_Points.size(); }
+
+  /** Squared distance from a point to the nearest point of the tree, or
+   * NumericTraits<RealType>::max() if the tree is empty. */
+  RealType GetNearestSquaredDistance( const PointType & point ) const;
+
+  /** Tree over the boundary of the non-zero pixels of the second image in
+   * a region, i.e. those with a zero face, edge or vertex neighbor in the
+   * region as in the contour of SignedMaurerDistanceMapImageFilter, at
+   * their indices multiplied by the scales.  NULL is returned without
+   * building anything if the non-zero pixels of both images in the region
+   * are more than maximumNumberOfPixels, the count stopping as soon as they
+   * are, or if there is no boundary. */
+  template <class TImage1, class TImage2>
+  static Pointer NewBoundaryTree( const TImage1 *image1,
+    const TImage2 *image2, const typename TImage2::RegionType & region,
+    const PointType & scales, double maximumNumberOfPixels );
+
+protected:
+  PointKdTree() {}
+  virtual ~PointKdTree() {}
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Split the points first, ..., last - 1 around their median. */
+  void Build( SizeValueType first, SizeValueType last );
+
+  /** Search the points first, ..., last - 1. */
+  void Search( const PointType & point, SizeValueType first,
+    SizeValueType last, RealType & nearestSquaredDistance ) const;
+
+  /** Ranges of at most this size are searched exhaustively. */
+  static const SizeValueType BucketSize = 8;
+
+  /** Compare two points along a dimension. */
+  struct DimensionComparator
+  {
+    unsigned int                                              Dimension;
+    bool operator()( const PointType & a, const PointType & b ) const
+      { return ( a[this->Dimension] < b[this->Dimension] ); }
+  };
+
+private:
+  PointKdTree( const Self & ); //purposely not implemented
+  void operator=( const Self & ); //purposely not implemented
+
+  PointsContainerType                                         m_Points;
+  std::vector<unsigned char>                                  m_SplitDimensions;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkPointKdTree.hxx"
+#endif
+
+#endif
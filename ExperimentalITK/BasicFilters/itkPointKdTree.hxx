@@ -0,0 +1,240 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkPointKdTree.hxx,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkPointKdTree_hxx
+#define __itkPointKdTree_hxx
+
+#include "itkPointKdTree.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkNumericTraits.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <class TRealType, unsigned int VDimension>
+void
+PointKdTree<TRealType, VDimension>
+::SetPoints( const PointsContainerType & points )
+{
+  this->m_Points = points;
+  this->m_SplitDimensions.assign( points.size(), 0 );
+  this->Build( 0, this->m_Points.size() );
+  this->Modified();
+}
+
+template <class TRealType, unsigned int VDimension>
+void
+PointKdTree<TRealType, VDimension>
+::Build( SizeValueType first, SizeValueType last )
+{
+  if ( last - first <= BucketSize )
+    {
+    return;
+    }
+
+  PointType minimum = this->m_Points[first];
+  PointType maximum = this->m_Points[first];
+  for ( SizeValueType n = first + 1; n < last; n++ )
+    {
+    for ( unsigned int d = 0; d < VDimension; d++ )
+      {
+      minimum[d] = vnl_math_min( minimum[d], this->m_Points[n][d] );
+      maximum[d] = vnl_math_max( maximum[d], this->m_Points[n][d] );
+      }
+    }
+  DimensionComparator comparator;
+  comparator.Dimension = 0;
+  for ( unsigned int d = 1; d < VDimension; d++ )
+    {
+    if ( maximum[d] - minimum[d] > maximum[comparator.Dimension]
+      - minimum[comparator.Dimension] )
+      {
+      comparator.Dimension = d;
+      }
+    }
+
+  const SizeValueType median = first + ( last - first ) / 2;
+  std::nth_element( this->m_Points.begin() + first,
+    this->m_Points.begin() + median, this->m_Points.begin() + last,
+    comparator );
+  this->m_SplitDimensions[median] =
+    static_cast<unsigned char>( comparator.Dimension );
+
+  this->Build( first, median );
+  this->Build( median + 1, last );
+}
+
+template <class TRealType, unsigned int VDimension>
+typename PointKdTree<TRealType, VDimension>::RealType
+PointKdTree<TRealType, VDimension>
+::GetNearestSquaredDistance( const PointType & point ) const
+{
+  RealType nearestSquaredDistance = NumericTraits<RealType>::max();
+  this->Search( point, 0, this->m_Points.size(), nearestSquaredDistance );
+  return nearestSquaredDistance;
+}
+
+template <class TRealType, unsigned int VDimension>
+void
+PointKdTree<TRealType, VDimension>
+::Search( const PointType & point, SizeValueType first, SizeValueType last,
+  RealType & nearestSquaredDistance ) const
+{
+  if ( last - first <= BucketSize )
+    {
+    for ( SizeValueType n = first; n < last; n++ )
+      {
+      nearestSquaredDistance = vnl_math_min( nearestSquaredDistance,
+        static_cast<RealType>( point.SquaredEuclideanDistanceTo(
+        this->m_Points[n] ) ) );
+      }
+    return;
+    }
+
+  /**
+   * The side of the query point first, the other side only if the
+   * splitting plane is closer than the nearest point found.
+   */
+  const SizeValueType median = first + ( last - first ) / 2;
+  const unsigned int d = this->m_SplitDimensions[median];
+  const RealType difference = point[d] - this->m_Points[median][d];
+
+  nearestSquaredDistance = vnl_math_min( nearestSquaredDistance,
+    static_cast<RealType>( point.SquaredEuclideanDistanceTo(
+    this->m_Points[median] ) ) );
+  if ( difference < 0.0 )
+    {
+    this->Search( point, first, median, nearestSquaredDistance );
+    if ( difference * difference < nearestSquaredDistance )
+      {
+      this->Search( point, median + 1, last, nearestSquaredDistance );
+      }
+    }
+  else
+    {
+    this->Search( point, median + 1, last, nearestSquaredDistance );
+    if ( difference * difference < nearestSquaredDistance )
+      {
+      this->Search( point, first, median, nearestSquaredDistance );
+      }
+    }
+}
+
+template <class TRealType, unsigned int VDimension>
+template <class TImage1, class TImage2>
+typename PointKdTree<TRealType, VDimension>::Pointer
+PointKdTree<TRealType, VDimension>
+::NewBoundaryTree( const TImage1 *image1, const TImage2 *image2,
+  const typename TImage2::RegionType & region, const PointType & scales,
+  double maximumNumberOfPixels )
+{
+  typedef typename TImage1::PixelType Pixel1Type;
+  typedef typename TImage2::PixelType Pixel2Type;
+  typedef typename TImage2::IndexType IndexType;
+
+  if ( maximumNumberOfPixels < 1.0 )
+    {
+    return NULL;
+    }
+
+  SizeValueType numberOfPixels = 0;
+
+  ImageRegionConstIterator<TImage1> It1( image1, region );
+  for ( It1.GoToBegin(); !It1.IsAtEnd(); ++It1 )
+    {
+    if ( It1.Get() != NumericTraits<Pixel1Type>::Zero &&
+      ++numberOfPixels > maximumNumberOfPixels )
+      {
+      return NULL;
+      }
+    }
+
+  // All the 3^VDimension - 1 neighbors, as the fully connected contour of
+  // SignedMaurerDistanceMapImageFilter
+  unsigned int numberOfNeighbors = 1;
+  for ( unsigned int d = 0; d < VDimension; d++ )
+    {
+    numberOfNeighbors *= 3;
+    }
+  PointsContainerType boundary;
+
+  ImageRegionConstIteratorWithIndex<TImage2> It2( image2, region );
+  for ( It2.GoToBegin(); !It2.IsAtEnd(); ++It2 )
+    {
+    if ( It2.Get() == NumericTraits<Pixel2Type>::Zero )
+      {
+      continue;
+      }
+    if ( ++numberOfPixels > maximumNumberOfPixels )
+      {
+      return NULL;
+      }
+
+    const IndexType index = It2.GetIndex();
+    bool isOnBoundary = false;
+    for ( unsigned int k = 0; k < numberOfNeighbors && !isOnBoundary; k++ )
+      {
+      if ( k == numberOfNeighbors / 2 )
+        {
+        continue;
+        }
+      IndexType neighbor = index;
+      for ( unsigned int d = 0, code = k; d < VDimension; d++, code /= 3 )
+        {
+        neighbor[d] += static_cast<int>( code % 3 ) - 1;
+        }
+      isOnBoundary = ( region.IsInside( neighbor ) &&
+        image2->GetPixel( neighbor ) == NumericTraits<Pixel2Type>::Zero );
+      }
+    if ( isOnBoundary )
+      {
+      PointType point;
+      for ( unsigned int d = 0; d < VDimension; d++ )
+        {
+        point[d] = static_cast<RealType>( index[d] ) * scales[d];
+        }
+      boundary.push_back( point );
+      }
+    }
+
+  if ( boundary.empty() )
+    {
+    return NULL;
+    }
+  Pointer tree = Self::New();
+  tree->SetPoints( boundary );
+  return tree;
+}
+
+template <class TRealType, unsigned int VDimension>
+void
+PointKdTree<TRealType, VDimension>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Number of points: " << this->m_Points.size() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -171,6 +171,8 @@ private:
 
   Array<unsigned int>                        m_C1Indices[12];
   Array<unsigned int>                        m_C2Indices[8];
+  bool                                       m_CriticalC1Configurations3D[16];
+  bool                                       m_CriticalC2Configurations3D[256];
 
 
   /**
@@ -629,8 +629,6 @@ bool
 TopologyPreservingDigitalSurfaceEvolutionImageFilter<TImage>
 ::IsChangeWellComposed3D( IndexType idx )
 {
-  Array<short> neighborhoodPixels( 8 );
-
   typename NeighborhoodIteratorType::RadiusType radius;
   radius.Fill( 1 );
   NeighborhoodIteratorType It( radius, this->m_LabelSurfaceImage,
@@ -643,19 +641,27 @@ TopologyPreservingDigitalSurfaceEvolutionImageFilter<TImage>
     checkValue = this->m_BackgroundValue; 
     }
 
+  // Pack the neighborhood once, with the center pixel flipped, and look up
+  // the C1 and C2 configurations in the tables built by InitializeIndices3D().
+  unsigned long pixels = 0;
+  for ( unsigned int n = 0; n < 27; n++ )
+    {
+    if( It.GetPixel( n ) == checkValue )
+      {
+      pixels |= 1ul << n;
+      }
+    }
+  pixels ^= 1ul << 13;
+
   // Check for C1 critical configurations
   for ( unsigned int i = 0; i < 12; i++ )
     {
+    unsigned int configuration = 0;
     for ( unsigned int j = 0; j < 4; j++ )
       {
-      neighborhoodPixels[j]
-        = ( It.GetPixel( this->m_C1Indices[i][j] ) == checkValue );
-      if( this->m_C1Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
+      configuration |= ( ( pixels >> this->m_C1Indices[i][j] ) & 1 ) << j;
       }
-    if( this->IsCriticalC1Configuration3D( neighborhoodPixels ) )
+    if( this->m_CriticalC1Configurations3D[configuration] )
       {
       return false;
       }
@@ -664,16 +670,12 @@ TopologyPreservingDigitalSurfaceEvolutionImageFilter<TImage>
   // Check for C2 critical configurations
   for ( unsigned int i = 0; i < 8; i++ )
     {
+    unsigned int configuration = 0;
     for ( unsigned int j = 0; j < 8; j++ )
       {
-      neighborhoodPixels[j]
-        = ( It.GetPixel( this->m_C2Indices[i][j] ) == checkValue );
-      if( this->m_C2Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
+      configuration |= ( ( pixels >> this->m_C2Indices[i][j] ) & 1 ) << j;
       }
-    if( this->IsCriticalC2Configuration3D( neighborhoodPixels ) )
+    if( this->m_CriticalC2Configurations3D[configuration] )
       {
       return false;
       }
@@ -849,6 +851,24 @@ TopologyPreservingDigitalSurfaceEvolutionImageFilter<TImage>
       this->m_C2Indices[i+4][j] = this->m_C2Indices[i+3][j] + addend;
       }
     }
+
+  // Tabulate the critical configurations, bit j of the table index holding
+  // pixel j of the C1 or C2 configuration.
+  Array<short> neighborhood( 8 );
+  for ( unsigned int n = 0; n < 256; n++ )
+    {
+    for ( unsigned int j = 0; j < 8; j++ )
+      {
+      neighborhood[j] = static_cast<short>( ( n >> j ) & 1 );
+      }
+    if( n < 16 )
+      {
+      this->m_CriticalC1Configurations3D[n] =
+        this->IsCriticalC1Configuration3D( neighborhood );
+      }
+    this->m_CriticalC2Configurations3D[n] =
+      ( this->IsCriticalC2Configuration3D( neighborhood ) != 0 );
+    }
 }
 
 template <class TImage>
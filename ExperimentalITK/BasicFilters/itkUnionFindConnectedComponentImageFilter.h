@@ -0,0 +1,289 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkUnionFindConnectedComponentImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkUnionFindConnectedComponentImageFilter_h
+#define __itkUnionFindConnectedComponentImageFilter_h
+
+#include "itkImageToImageFilter.h"
+
+#include "itkMatrix.h"
+#include "itkVector.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class UnionFindConnectedComponentImageFilter
+ * \brief Labels the connected components of an image, relabels them by
+ * size and computes their statistics in the same pass.
+ *
+ * Every pixel different from BackgroundValue is an object pixel and two
+ * neighboring object pixels belong to the same component, whatever their
+ * values, as in ConnectedComponentImageFilter.  The image is cut into slabs
+ * along its last dimension.  Each thread encodes the object pixels of its
+ * slab as runs along the first dimension and merges the overlapping runs
+ * of neighboring rows with union-find.  The runs of the faces between the
+ * slabs are then merged serially and every component gets the size of its
+ * runs.
+ *
+ * The components smaller than MinimumObjectSize pixels are removed and, if
+ * RelabelByObjectSize is on, the remaining ones are labeled 1, 2, ... by
+ * decreasing size (the first in raster order for equal sizes), which gives
+ * the output of ConnectedComponentImageFilter followed by
+ * RelabelComponentImageFilter.  Otherwise they are labeled in raster order.
+ *
+ * For each output label, the size, bounding box, centroid, principal
+ * moments and axes (physical space) are computed from the runs and, if a
+ * feature image is set, the minimum, maximum, mean and standard deviation
+ * of its intensities, while the output is written by the threads.
+ *
+ * \sa ConnectedComponentImageFilter RelabelComponentImageFilter
+ * \sa LabelGeometryImageFilter LabelStatisticsImageFilter
+ */
+
+template <class TInputImage, class TOutputImage,
+  class TFeatureImage = TInputImage>
+class UnionFindConnectedComponentImageFilter
+: public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  typedef UnionFindConnectedComponentImageFilter              Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>       Superclass;
+  typedef SmartPointer<Self>                                  Pointer;
+  typedef SmartPointer<const Self>                            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( UnionFindConnectedComponentImageFilter, ImageToImageFilter );
+
+  /** Extract dimension from input image. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+                       TInputImage::ImageDimension );
+
+  /** Image typedef support. */
+  typedef TInputImage                                         InputImageType;
+  typedef TOutputImage                                        OutputImageType;
+  typedef TFeatureImage                                       FeatureImageType;
+  typedef typename InputImageType::PixelType                  InputPixelType;
+  typedef typename OutputImageType::PixelType                 OutputPixelType;
+  typedef typename FeatureImageType::PixelType                FeaturePixelType;
+  typedef typename InputImageType::RegionType                 RegionType;
+  typedef typename RegionType::SizeType                       SizeType;
+  typedef typename RegionType::IndexType                      IndexType;
+  typedef typename InputImageType::PointType                  PointType;
+
+  /** Other typedef */
+  typedef double                                              RealType;
+  typedef Vector<RealType,
+    itkGetStaticConstMacro( ImageDimension )>                 VectorType;
+  typedef Matrix<RealType, itkGetStaticConstMacro( ImageDimension ),
+    itkGetStaticConstMacro( ImageDimension )>                 MatrixType;
+
+  /** Statistics of an output label.  The principal moments are the
+   * eigenvalues of the covariance of the physical coordinates of the
+   * pixels, in increasing order, and the rows of PrincipalAxes the
+   * corresponding eigenvectors.  Eccentricity is
+   * sqrt( 1 - smallest / largest moment ) and Elongation
+   * sqrt( largest / smallest moment ), or 0 if the smallest moment is 0.
+   * The intensity statistics are only computed if a feature image is
+   * set. */
+  struct ObjectStatisticsType
+  {
+    SizeValueType                                             NumberOfPixels;
+    RealType                                                  PhysicalSize;
+    RegionType                                                BoundingBox;
+    PointType                                                 Centroid;
+    VectorType                                                PrincipalMoments;
+    MatrixType                                                PrincipalAxes;
+    RealType                                                  Eccentricity;
+    RealType                                                  Elongation;
+    RealType                                                  Minimum;
+    RealType                                                  Maximum;
+    RealType                                                  Mean;
+    RealType                                                  Sigma;
+    RealType                                                  Sum;
+  };
+
+  /** Set/Get the optional image whose intensities are summarized. */
+  void SetFeatureImage( const FeatureImageType *image )
+    { this->SetNthInput( 1, const_cast<FeatureImageType *>( image ) ); }
+  const FeatureImageType * GetFeatureImage() const
+    { return static_cast<const FeatureImageType *>(
+        this->ProcessObject::GetInput( 1 ) ); }
+
+  /** Set/Get the value of the input pixels which belong to no object. */
+  itkSetMacro( BackgroundValue, InputPixelType );
+  itkGetConstMacro( BackgroundValue, InputPixelType );
+
+  /** Set/Get if the diagonal neighbors are connected. */
+  itkSetMacro( FullyConnected, bool );
+  itkGetConstMacro( FullyConnected, bool );
+  itkBooleanMacro( FullyConnected );
+
+  /** Set/Get the size, in pixels, below which a component is removed. */
+  itkSetMacro( MinimumObjectSize, SizeValueType );
+  itkGetConstMacro( MinimumObjectSize, SizeValueType );
+
+  /** Set/Get if the output labels are sorted by decreasing size. */
+  itkSetMacro( RelabelByObjectSize, bool );
+  itkGetConstMacro( RelabelByObjectSize, bool );
+  itkBooleanMacro( RelabelByObjectSize );
+
+  /** Number of components before and after the size filtering.  Only valid
+   * after the filter has executed. */
+  itkGetConstMacro( OriginalNumberOfObjects, SizeValueType );
+  itkGetConstMacro( NumberOfObjects, SizeValueType );
+
+  /** Statistics of the output label 1, ..., NumberOfObjects. */
+  const ObjectStatisticsType & GetObjectStatistics( SizeValueType label ) const
+    { return this->m_ObjectStatistics[label - 1]; }
+  SizeValueType GetSizeOfObjectInPixels( SizeValueType label ) const
+    { return this->m_ObjectStatistics[label - 1].NumberOfPixels; }
+  RealType GetSizeOfObjectInPhysicalUnits( SizeValueType label ) const
+    { return this->m_ObjectStatistics[label - 1].PhysicalSize; }
+
+protected:
+  UnionFindConnectedComponentImageFilter();
+  virtual ~UnionFindConnectedComponentImageFilter();
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  void GenerateInputRequestedRegion();
+  void EnlargeOutputRequestedRegion( DataObject * );
+
+  void GenerateData();
+
+  /** Object pixels first, ..., last (inclusive) of a row, relative to the
+   * start of the row. */
+  struct RunType
+  {
+    OffsetValueType                                           First;
+    OffsetValueType                                           Last;
+  };
+
+  /** Intensity sums of an output label over the rows of a thread. */
+  struct IntensityAccumulatorType
+  {
+    RealType                                                  Minimum;
+    RealType                                                  Maximum;
+    RealType                                                  Sum;
+    RealType                                                  SumOfSquares;
+  };
+
+  /** Internal structure used for passing the slabs to the threads.  The
+   * runs of the row l are Runs[RowRuns[l]], ..., Runs[RowRuns[l + 1] - 1],
+   * the run indices being local to the slab until the slabs are joined. */
+  struct ComponentThreadStruct
+  {
+    Self                                                     *Filter;
+    std::vector<SizeValueType>                                SlabRows;
+    std::vector<std::vector<RunType> >                        SlabRuns;
+    std::vector<std::vector<SizeValueType> >                  SlabParents;
+    std::vector<SizeValueType>                                RowRuns;
+    std::vector<RunType>                                      Runs;
+    std::vector<SizeValueType>                                RunLabels;
+    std::vector<std::vector<IntensityAccumulatorType> >       Intensities;
+  };
+
+  /** Encode the rows first, ..., last - 1 as runs and merge them. */
+  void ThreadedLabelSlab( ComponentThreadStruct *str, ThreadIdType threadId,
+    SizeValueType first, SizeValueType last );
+
+  /** Write the output labels of the rows first, ..., last - 1 and sum the
+   * feature intensities. */
+  void ThreadedWriteSlab( ComponentThreadStruct *str, ThreadIdType threadId,
+    SizeValueType first, SizeValueType last );
+
+  /** Merge the runs rowRuns[row], ..., rowEnd - 1 of a row with the
+   * overlapping runs of the preceding neighbor rows whose index is in
+   * [minimumRow, maximumRow). */
+  void MergeRow( const std::vector<RunType> & runs,
+    const std::vector<SizeValueType> & rowRuns,
+    std::vector<SizeValueType> & parents, SizeValueType row,
+    SizeValueType rowEnd, SizeValueType minimumRow,
+    SizeValueType maximumRow ) const;
+
+  /** Static functions used as "callbacks" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE LabelSlabThreaderCallback( void *arg );
+  static ITK_THREAD_RETURN_TYPE WriteSlabThreaderCallback( void *arg );
+
+  /** Union-find with path halving, the root being the smallest run. */
+  static SizeValueType FindRoot( std::vector<SizeValueType> & parents,
+    SizeValueType run )
+    {
+    while( parents[run] != run )
+      {
+      parents[run] = parents[parents[run]];
+      run = parents[run];
+      }
+    return run;
+    }
+  static void Union( std::vector<SizeValueType> & parents,
+    SizeValueType run1, SizeValueType run2 )
+    {
+    run1 = FindRoot( parents, run1 );
+    run2 = FindRoot( parents, run2 );
+    if( run1 < run2 )
+      {
+      parents[run2] = run1;
+      }
+    else if( run2 < run1 )
+      {
+      parents[run1] = run2;
+      }
+    }
+
+  /** Decreasing size, then increasing component, order. */
+  struct SizeComparator
+  {
+    const std::vector<SizeValueType>                         *Sizes;
+    bool operator()( SizeValueType a, SizeValueType b ) const
+      {
+      if( ( *this->Sizes )[a] != ( *this->Sizes )[b] )
+        {
+        return ( ( *this->Sizes )[a] > ( *this->Sizes )[b] );
+        }
+      return ( a < b );
+      }
+  };
+
+private:
+  UnionFindConnectedComponentImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  InputPixelType                                              m_BackgroundValue;
+  bool                                                        m_FullyConnected;
+  SizeValueType                                               m_MinimumObjectSize;
+  bool                                                        m_RelabelByObjectSize;
+
+  /** Offsets, in rows, of the preceding neighbor rows. */
+  std::vector<std::vector<OffsetValueType> >                  m_RowOffsets;
+  SizeType                                                    m_Size;
+
+  SizeValueType                                               m_OriginalNumberOfObjects;
+  SizeValueType                                               m_NumberOfObjects;
+  std::vector<ObjectStatisticsType>                           m_ObjectStatistics;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkUnionFindConnectedComponentImageFilter.hxx"
+#endif
+
+#endif
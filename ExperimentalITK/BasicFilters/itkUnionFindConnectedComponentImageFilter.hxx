@@ -0,0 +1,690 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkUnionFindConnectedComponentImageFilter.hxx,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkUnionFindConnectedComponentImageFilter_hxx
+#define __itkUnionFindConnectedComponentImageFilter_hxx
+
+#include "itkUnionFindConnectedComponentImageFilter.h"
+
+#include "itkContinuousIndex.h"
+
+#include "vnl/vnl_math.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::UnionFindConnectedComponentImageFilter()
+{
+  this->SetNumberOfRequiredInputs( 1 );
+
+  this->m_BackgroundValue = NumericTraits<InputPixelType>::Zero;
+  this->m_FullyConnected = false;
+  this->m_MinimumObjectSize = 0;
+  this->m_RelabelByObjectSize = true;
+
+  this->m_OriginalNumberOfObjects = 0;
+  this->m_NumberOfObjects = 0;
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::~UnionFindConnectedComponentImageFilter()
+{
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+void
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  if ( input )
+    {
+    input->SetRequestedRegionToLargestPossibleRegion();
+    }
+  FeatureImageType *feature =
+    const_cast<FeatureImageType *>( this->GetFeatureImage() );
+  if ( feature )
+    {
+    feature->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+void
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::EnlargeOutputRequestedRegion( DataObject *output )
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+void
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::GenerateData()
+{
+  const InputImageType *input = this->GetInput();
+  const FeatureImageType *feature = this->GetFeatureImage();
+  if ( feature &&
+    feature->GetBufferedRegion() != input->GetBufferedRegion() )
+    {
+    itkExceptionMacro( << "The feature image and the input image do not "
+      << "have the same buffered region." );
+    }
+
+  this->AllocateOutputs();
+
+  const RegionType region = input->GetBufferedRegion();
+  this->m_Size = region.GetSize();
+
+  /**
+   * The rows are along the first dimension and the slabs are made of whole
+   * slices along the last one.
+   */
+  const SizeValueType numberOfRows =
+    region.GetNumberOfPixels() / this->m_Size[0];
+  const SizeValueType rowsPerSlice = ( ImageDimension > 1 )
+    ? numberOfRows / this->m_Size[ImageDimension - 1] : 1;
+  const SizeValueType numberOfSlices = ( rowsPerSlice > 0 )
+    ? numberOfRows / rowsPerSlice : 0;
+
+  /**
+   * Offsets, in row coordinates, of the neighbor rows which precede a row.
+   */
+  this->m_RowOffsets.clear();
+  if ( ImageDimension > 1 )
+    {
+    SizeValueType numberOfOffsets = 1;
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      numberOfOffsets *= 3;
+      }
+    for ( SizeValueType n = 0; n < numberOfOffsets; n++ )
+      {
+      std::vector<OffsetValueType> offset( ImageDimension - 1 );
+      SizeValueType m = n;
+      unsigned int numberOfNonZero = 0;
+      int last = 0;
+      for ( unsigned int d = 0; d < ImageDimension - 1; d++ )
+        {
+        offset[d] = static_cast<OffsetValueType>( m % 3 ) - 1;
+        m /= 3;
+        if ( offset[d] != 0 )
+          {
+          numberOfNonZero++;
+          last = offset[d];
+          }
+        }
+      if ( last < 0 && ( this->m_FullyConnected || numberOfNonZero == 1 ) )
+        {
+        this->m_RowOffsets.push_back( offset );
+        }
+      }
+    }
+
+  /**
+   * Label the slabs.
+   */
+  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  if ( numberOfSlices < numberOfThreads )
+    {
+    numberOfThreads = static_cast<ThreadIdType>( vnl_math_max( numberOfSlices,
+      static_cast<SizeValueType>( 1 ) ) );
+    }
+
+  // The multithreader may clamp the number of threads, and every slab has
+  // to be labeled by a thread which actually runs.
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  numberOfThreads = this->GetMultiThreader()->GetNumberOfThreads();
+
+  ComponentThreadStruct str;
+  str.Filter = this;
+  str.SlabRows.resize( numberOfThreads + 1 );
+  for ( ThreadIdType t = 0; t <= numberOfThreads; t++ )
+    {
+    str.SlabRows[t] = numberOfSlices * t / numberOfThreads * rowsPerSlice;
+    }
+  str.SlabRuns.resize( numberOfThreads );
+  str.SlabParents.resize( numberOfThreads );
+  str.RowRuns.resize( numberOfRows + 1 );
+
+  this->GetMultiThreader()->SetSingleMethod(
+    this->LabelSlabThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  /**
+   * Join the runs of the slabs and merge the runs of the first slice of
+   * each slab with the last slice of the previous one.
+   */
+  SizeValueType numberOfRuns = 0;
+  for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    numberOfRuns += str.SlabRuns[t].size();
+    }
+  std::vector<SizeValueType> parents;
+  parents.reserve( numberOfRuns );
+  str.Runs.reserve( numberOfRuns );
+  for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    const SizeValueType offset = str.Runs.size();
+    for ( SizeValueType n = 0; n < str.SlabRuns[t].size(); n++ )
+      {
+      str.Runs.push_back( str.SlabRuns[t][n] );
+      parents.push_back( str.SlabParents[t][n] + offset );
+      }
+    for ( SizeValueType row = str.SlabRows[t]; row < str.SlabRows[t + 1];
+      row++ )
+      {
+      str.RowRuns[row] += offset;
+      }
+    std::vector<RunType>().swap( str.SlabRuns[t] );
+    std::vector<SizeValueType>().swap( str.SlabParents[t] );
+    }
+  str.RowRuns[numberOfRows] = numberOfRuns;
+
+  for ( ThreadIdType t = 1; t < numberOfThreads; t++ )
+    {
+    for ( SizeValueType row = str.SlabRows[t];
+      row < str.SlabRows[t] + rowsPerSlice; row++ )
+      {
+      this->MergeRow( str.Runs, str.RowRuns, parents, row,
+        str.RowRuns[row + 1], 0, str.SlabRows[t] );
+      }
+    }
+
+  /**
+   * Number the components in raster order.  The parent of a run precedes
+   * it, so its entry already holds the component number.
+   */
+  std::vector<SizeValueType> sizes;
+  for ( SizeValueType n = 0; n < numberOfRuns; n++ )
+    {
+    if ( parents[n] == n )
+      {
+      parents[n] = sizes.size();
+      sizes.push_back( 0 );
+      }
+    else
+      {
+      parents[n] = parents[parents[n]];
+      }
+    sizes[parents[n]] += str.Runs[n].Last - str.Runs[n].First + 1;
+    }
+  this->m_OriginalNumberOfObjects = sizes.size();
+
+  /**
+   * Remove the small components and sort the others.
+   */
+  std::vector<SizeValueType> order;
+  for ( SizeValueType c = 0; c < sizes.size(); c++ )
+    {
+    if ( sizes[c] >= this->m_MinimumObjectSize )
+      {
+      order.push_back( c );
+      }
+    }
+  if ( this->m_RelabelByObjectSize )
+    {
+    SizeComparator comparator;
+    comparator.Sizes = &sizes;
+    std::sort( order.begin(), order.end(), comparator );
+    }
+  this->m_NumberOfObjects = order.size();
+  if ( this->m_NumberOfObjects > static_cast<SizeValueType>(
+    NumericTraits<OutputPixelType>::max() ) )
+    {
+    itkExceptionMacro( << "The number of objects, " << this->m_NumberOfObjects
+      << ", exceeds the maximum of the output pixel type." );
+    }
+
+  std::vector<SizeValueType> labels( sizes.size(), 0 );
+  for ( SizeValueType k = 0; k < order.size(); k++ )
+    {
+    labels[order[k]] = k + 1;
+    }
+  for ( SizeValueType n = 0; n < numberOfRuns; n++ )
+    {
+    parents[n] = labels[parents[n]];
+    }
+  str.RunLabels.swap( parents );
+
+  /**
+   * Write the output and sum the intensities.
+   */
+  str.Intensities.resize( numberOfThreads );
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->WriteSlabThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  /**
+   * Moments of the coordinates of the objects, from their runs.
+   */
+  const SizeValueType numberOfObjects = this->m_NumberOfObjects;
+
+  std::vector<SizeValueType> numberOfPixels( numberOfObjects, 0 );
+  std::vector<IndexType> minimumIndex( numberOfObjects );
+  std::vector<IndexType> maximumIndex( numberOfObjects );
+  std::vector<VectorType> firstMoments( numberOfObjects );
+  std::vector<MatrixType> secondMoments( numberOfObjects );
+  for ( SizeValueType k = 0; k < numberOfObjects; k++ )
+    {
+    minimumIndex[k].Fill( NumericTraits<IndexValueType>::max() );
+    maximumIndex[k].Fill( NumericTraits<IndexValueType>::NonpositiveMin() );
+    firstMoments[k].Fill( 0.0 );
+    secondMoments[k].Fill( 0.0 );
+    }
+
+  IndexType index = region.GetIndex();
+  for ( SizeValueType row = 0; row < numberOfRows; row++ )
+    {
+    for ( SizeValueType n = str.RowRuns[row]; n < str.RowRuns[row + 1]; n++ )
+      {
+      const SizeValueType label = str.RunLabels[n];
+      if ( label == 0 )
+        {
+        continue;
+        }
+      const SizeValueType k = label - 1;
+      const RunType & run = str.Runs[n];
+
+      const RealType length = static_cast<RealType>( run.Last - run.First + 1 );
+      const RealType first = static_cast<RealType>(
+        region.GetIndex()[0] + run.First );
+      const RealType sum = length * first + 0.5 * length * ( length - 1.0 );
+      const RealType sumOfSquares = length * first * first
+        + first * length * ( length - 1.0 )
+        + ( length - 1.0 ) * length * ( 2.0 * length - 1.0 ) / 6.0;
+
+      numberOfPixels[k] += run.Last - run.First + 1;
+      firstMoments[k][0] += sum;
+      secondMoments[k][0][0] += sumOfSquares;
+      minimumIndex[k][0] = vnl_math_min( minimumIndex[k][0],
+        region.GetIndex()[0] + run.First );
+      maximumIndex[k][0] = vnl_math_max( maximumIndex[k][0],
+        region.GetIndex()[0] + run.Last );
+      for ( unsigned int i = 1; i < ImageDimension; i++ )
+        {
+        const RealType x = static_cast<RealType>( index[i] );
+        firstMoments[k][i] += length * x;
+        secondMoments[k][0][i] += sum * x;
+        secondMoments[k][i][0] += sum * x;
+        for ( unsigned int j = 1; j < ImageDimension; j++ )
+          {
+          secondMoments[k][i][j] += length * x * static_cast<RealType>( index[j] );
+          }
+        minimumIndex[k][i] = vnl_math_min( minimumIndex[k][i], index[i] );
+        maximumIndex[k][i] = vnl_math_max( maximumIndex[k][i], index[i] );
+        }
+      }
+    for ( unsigned int i = 1; i < ImageDimension; i++ )
+      {
+      if ( ++index[i] < region.GetIndex()[i] +
+        static_cast<IndexValueType>( this->m_Size[i] ) )
+        {
+        break;
+        }
+      index[i] = region.GetIndex()[i];
+      }
+    }
+
+  /**
+   * Statistics of the objects.
+   */
+  RealType pixelVolume = 1.0;
+  vnl_matrix<RealType> indexToPhysical( ImageDimension, ImageDimension );
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    pixelVolume *= input->GetSpacing()[i];
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      indexToPhysical( i, j ) =
+        input->GetDirection()[i][j] * input->GetSpacing()[j];
+      }
+    }
+
+  this->m_ObjectStatistics.resize( numberOfObjects );
+  for ( SizeValueType k = 0; k < numberOfObjects; k++ )
+    {
+    ObjectStatisticsType & statistics = this->m_ObjectStatistics[k];
+    const RealType N = static_cast<RealType>( numberOfPixels[k] );
+
+    statistics.NumberOfPixels = numberOfPixels[k];
+    statistics.PhysicalSize = N * pixelVolume;
+
+    SizeType size;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      size[i] = maximumIndex[k][i] - minimumIndex[k][i] + 1;
+      }
+    statistics.BoundingBox.SetIndex( minimumIndex[k] );
+    statistics.BoundingBox.SetSize( size );
+
+    ContinuousIndex<RealType, ImageDimension> centroid;
+    vnl_matrix<RealType> covariance( ImageDimension, ImageDimension );
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      centroid[i] = firstMoments[k][i] / N;
+      }
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        covariance( i, j ) = secondMoments[k][i][j] / N
+          - centroid[i] * centroid[j];
+        }
+      }
+    input->TransformContinuousIndexToPhysicalPoint( centroid,
+      statistics.Centroid );
+
+    vnl_symmetric_eigensystem<RealType> eig( indexToPhysical * covariance
+      * indexToPhysical.transpose() );
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      statistics.PrincipalMoments[i] = vnl_math_max( eig.get_eigenvalue( i ),
+        static_cast<RealType>( 0.0 ) );
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        statistics.PrincipalAxes[i][j] = eig.get_eigenvector( i )[j];
+        }
+      }
+    const RealType smallest = statistics.PrincipalMoments[0];
+    const RealType largest = statistics.PrincipalMoments[ImageDimension - 1];
+    statistics.Eccentricity = ( largest > 0.0 )
+      ? vcl_sqrt( 1.0 - smallest / largest ) : 0.0;
+    statistics.Elongation = ( smallest > 0.0 )
+      ? vcl_sqrt( largest / smallest ) : 0.0;
+
+    statistics.Minimum = 0.0;
+    statistics.Maximum = 0.0;
+    statistics.Mean = 0.0;
+    statistics.Sigma = 0.0;
+    statistics.Sum = 0.0;
+    if ( feature )
+      {
+      RealType sumOfSquares = 0.0;
+      statistics.Minimum = NumericTraits<RealType>::max();
+      statistics.Maximum = NumericTraits<RealType>::NonpositiveMin();
+      for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+        {
+        const IntensityAccumulatorType & accumulator =
+          str.Intensities[t][k + 1];
+        statistics.Minimum =
+          vnl_math_min( statistics.Minimum, accumulator.Minimum );
+        statistics.Maximum =
+          vnl_math_max( statistics.Maximum, accumulator.Maximum );
+        statistics.Sum += accumulator.Sum;
+        sumOfSquares += accumulator.SumOfSquares;
+        }
+      statistics.Mean = statistics.Sum / N;
+      if ( numberOfPixels[k] > 1 )
+        {
+        statistics.Sigma = vcl_sqrt( vnl_math_max( static_cast<RealType>( 0.0 ),
+          ( sumOfSquares - N * vnl_math_sqr( statistics.Mean ) ) / ( N - 1.0 ) ) );
+        }
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+ITK_THREAD_RETURN_TYPE
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::LabelSlabThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  ComponentThreadStruct *str =
+    static_cast<ComponentThreadStruct *>( info->UserData );
+
+  const ThreadIdType threadId = info->ThreadID;
+  if ( threadId + 1 < str->SlabRows.size() )
+    {
+    str->Filter->ThreadedLabelSlab( str, threadId, str->SlabRows[threadId],
+      str->SlabRows[threadId + 1] );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+ITK_THREAD_RETURN_TYPE
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::WriteSlabThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  ComponentThreadStruct *str =
+    static_cast<ComponentThreadStruct *>( info->UserData );
+
+  const ThreadIdType threadId = info->ThreadID;
+  if ( threadId + 1 < str->SlabRows.size() )
+    {
+    str->Filter->ThreadedWriteSlab( str, threadId, str->SlabRows[threadId],
+      str->SlabRows[threadId + 1] );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+void
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::ThreadedLabelSlab( ComponentThreadStruct *str, ThreadIdType threadId,
+  SizeValueType first, SizeValueType last )
+{
+  const InputPixelType *buffer = this->GetInput()->GetBufferPointer();
+  const OffsetValueType length = static_cast<OffsetValueType>( this->m_Size[0] );
+
+  std::vector<RunType> & runs = str->SlabRuns[threadId];
+  std::vector<SizeValueType> & parents = str->SlabParents[threadId];
+
+  for ( SizeValueType row = first; row < last; row++ )
+    {
+    str->RowRuns[row] = runs.size();
+
+    const InputPixelType *pixels = buffer + row * length;
+    OffsetValueType x = 0;
+    while ( x < length )
+      {
+      if ( pixels[x] == this->m_BackgroundValue )
+        {
+        ++x;
+        continue;
+        }
+      RunType run;
+      run.First = x;
+      while ( x < length && pixels[x] != this->m_BackgroundValue )
+        {
+        ++x;
+        }
+      run.Last = x - 1;
+      parents.push_back( runs.size() );
+      runs.push_back( run );
+      }
+
+    this->MergeRow( runs, str->RowRuns, parents, row, runs.size(), first, row );
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+void
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::ThreadedWriteSlab( ComponentThreadStruct *str, ThreadIdType threadId,
+  SizeValueType first, SizeValueType last )
+{
+  OutputPixelType *buffer = this->GetOutput()->GetBufferPointer();
+  const FeatureImageType *feature = this->GetFeatureImage();
+  const SizeValueType length = this->m_Size[0];
+
+  std::vector<IntensityAccumulatorType> & intensities =
+    str->Intensities[threadId];
+  if ( feature )
+    {
+    IntensityAccumulatorType accumulator;
+    accumulator.Minimum = NumericTraits<RealType>::max();
+    accumulator.Maximum = NumericTraits<RealType>::NonpositiveMin();
+    accumulator.Sum = 0.0;
+    accumulator.SumOfSquares = 0.0;
+    intensities.assign( this->m_NumberOfObjects + 1, accumulator );
+    }
+
+  for ( SizeValueType row = first; row < last; row++ )
+    {
+    OutputPixelType *pixels = buffer + row * length;
+    std::fill( pixels, pixels + length, NumericTraits<OutputPixelType>::Zero );
+
+    for ( SizeValueType n = str->RowRuns[row]; n < str->RowRuns[row + 1]; n++ )
+      {
+      const SizeValueType label = str->RunLabels[n];
+      if ( label == 0 )
+        {
+        continue;
+        }
+      const RunType & run = str->Runs[n];
+      std::fill( pixels + run.First, pixels + run.Last + 1,
+        static_cast<OutputPixelType>( label ) );
+
+      if ( feature )
+        {
+        IntensityAccumulatorType & accumulator = intensities[label];
+        const FeaturePixelType *values =
+          feature->GetBufferPointer() + row * length;
+        for ( OffsetValueType x = run.First; x <= run.Last; x++ )
+          {
+          const RealType value = static_cast<RealType>( values[x] );
+          accumulator.Minimum = vnl_math_min( accumulator.Minimum, value );
+          accumulator.Maximum = vnl_math_max( accumulator.Maximum, value );
+          accumulator.Sum += value;
+          accumulator.SumOfSquares += value * value;
+          }
+        }
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+void
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::MergeRow( const std::vector<RunType> & runs,
+  const std::vector<SizeValueType> & rowRuns,
+  std::vector<SizeValueType> & parents, SizeValueType row, SizeValueType rowEnd,
+  SizeValueType minimumRow, SizeValueType maximumRow ) const
+{
+  if ( rowRuns[row] == rowEnd )
+    {
+    return;
+    }
+
+  /**
+   * Diagonal neighbors overlap if they are one pixel apart along the rows.
+   */
+  const OffsetValueType tolerance = this->m_FullyConnected ? 1 : 0;
+
+  OffsetValueType coordinates[ImageDimension];
+  SizeValueType m = row;
+  for ( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    coordinates[d] = static_cast<OffsetValueType>( m % this->m_Size[d] );
+    m /= this->m_Size[d];
+    }
+
+  for ( unsigned int o = 0; o < this->m_RowOffsets.size(); o++ )
+    {
+    const std::vector<OffsetValueType> & offset = this->m_RowOffsets[o];
+
+    bool isInside = true;
+    OffsetValueType neighbor = static_cast<OffsetValueType>( row );
+    OffsetValueType stride = 1;
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      const OffsetValueType coordinate = coordinates[d] + offset[d - 1];
+      if ( coordinate < 0 ||
+        coordinate >= static_cast<OffsetValueType>( this->m_Size[d] ) )
+        {
+        isInside = false;
+        break;
+        }
+      neighbor += offset[d - 1] * stride;
+      stride *= static_cast<OffsetValueType>( this->m_Size[d] );
+      }
+    if ( !isInside || neighbor < static_cast<OffsetValueType>( minimumRow ) ||
+      neighbor >= static_cast<OffsetValueType>( maximumRow ) )
+      {
+      continue;
+      }
+
+    SizeValueType a = rowRuns[row];
+    SizeValueType b = rowRuns[neighbor];
+    const SizeValueType bEnd = rowRuns[neighbor + 1];
+    while ( a < rowEnd && b < bEnd )
+      {
+      if ( runs[b].Last + tolerance < runs[a].First )
+        {
+        ++b;
+        }
+      else if ( runs[a].Last + tolerance < runs[b].First )
+        {
+        ++a;
+        }
+      else
+        {
+        Union( parents, a, b );
+        if ( runs[a].Last < runs[b].Last )
+          {
+          ++a;
+          }
+        else
+          {
+          ++b;
+          }
+        }
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TFeatureImage>
+void
+UnionFindConnectedComponentImageFilter<TInputImage, TOutputImage, TFeatureImage>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Background value: "
+     << static_cast<typename NumericTraits<InputPixelType>::PrintType>(
+       this->m_BackgroundValue ) << std::endl;
+  os << indent << "Fully connected: " << this->m_FullyConnected << std::endl;
+  os << indent << "Minimum object size: " << this->m_MinimumObjectSize
+     << std::endl;
+  os << indent << "Relabel by object size: " << this->m_RelabelByObjectSize
+     << std::endl;
+  os << indent << "Original number of objects: "
+     << this->m_OriginalNumberOfObjects << std::endl;
+  os << indent << "Number of objects: " << this->m_NumberOfObjects
+     << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -89,6 +89,17 @@ private:
   void operator=( const Self& ); //purposely not implemented
    
   void ConvertBoundaryPixels( PixelType );
+
+  /**
+   * Pack the 3^D neighborhood into a bitmask (bit n set where pixel n has
+   * the given label) and extract the configuration given by a set of
+   * neighborhood indices, bit j holding pixel indices[j].  The critical
+   * configuration tables below are indexed by these configurations.
+   */
+  unsigned long PackNeighborhood( NeighborhoodIteratorType &, PixelType );
+  unsigned int GetConfiguration( unsigned long,
+                                 const Array<unsigned int> & ) const;
+
   unsigned long                   m_TotalNumberOfLabels;
   MultipleIndexContainerType      m_CriticalConfigurationIndices;
 
@@ -108,6 +119,10 @@ private:
   bool                            m_FullInvariance;
   Array<unsigned int>             m_RotationIndices[4];
   Array<unsigned int>             m_ReflectionIndices[2];
+  bool                            m_CriticalC1Configurations2D[512];
+  bool                            m_CriticalC2Configurations2D[512];
+  bool                            m_CriticalC3Configurations2D[512];
+  bool                            m_CriticalC4Configurations2D[512];
 
   /**
    * Functions/data for the 3-D case
@@ -132,6 +147,8 @@ private:
 
   Array<unsigned int>             m_C1Indices[12];
   Array<unsigned int>             m_C2Indices[8];
+  bool                            m_CriticalC1Configurations3D[16];
+  bool                            m_CriticalC2Configurations3D[256];
 };
 
 } // end namespace itk
@@ -84,6 +84,36 @@ WellComposedImageFilter<TImage>
   this->GraftOutput( cropper->GetOutput() );
 }
 
+template<class TImage>
+unsigned long
+WellComposedImageFilter<TImage>
+::PackNeighborhood( NeighborhoodIteratorType &It, PixelType label )
+{
+  unsigned long pixels = 0;
+  for ( unsigned int n = 0; n < It.Size(); n++ )
+    {
+    if ( It.GetPixel( n ) == label )
+      {
+      pixels |= 1ul << n;
+      }
+    }
+  return pixels;
+}
+
+template<class TImage>
+unsigned int
+WellComposedImageFilter<TImage>
+::GetConfiguration( unsigned long pixels,
+                    const Array<unsigned int> &indices ) const
+{
+  unsigned int configuration = 0;
+  for ( unsigned int j = 0; j < indices.Size(); j++ )
+    {
+    configuration |= ( ( pixels >> indices[j] ) & 1 ) << j;
+    }
+  return configuration;
+}
+
 /*
  * 2-D
  */
@@ -102,8 +132,6 @@ WellComposedImageFilter<TImage>
   NeighborhoodIteratorType It( radius, this->GetOutput(),
         this->GetOutput()->GetRequestedRegion() );
 
-  Array<char> neighborhoodPixels( 9 );
-
   for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
     {
     if ( !It.InBounds() )
@@ -117,15 +145,13 @@ WellComposedImageFilter<TImage>
       static_cast<PixelType>( this->m_TotalNumberOfLabels ) )
       {
       // Check for critical configurations: 4 90-degree rotations
+      unsigned long pixels = this->PackNeighborhood( It, currentLabel );
       for ( unsigned int i = 0; i < 4; i++ )
         {
-        for ( unsigned int j = 0; j < 9; j++ )
-          {
-          neighborhoodPixels[j] =
-            ( It.GetPixel( this->m_RotationIndices[i][j] ) == currentLabel );
-          }
+        unsigned int configuration =
+          this->GetConfiguration( pixels, this->m_RotationIndices[i] );
 
-        if ( this->IsCriticalC1Configuration2D( neighborhoodPixels ) )
+        if ( this->m_CriticalC1Configurations2D[configuration] )
           {
           NumberOfC1Configurations2D++;
           for ( int k = currentLabel; k >= 0; k-- )
@@ -141,7 +167,7 @@ WellComposedImageFilter<TImage>
             }
           break;
           }
-        else if ( this->IsCriticalC2Configuration2D( neighborhoodPixels ) )
+        else if ( this->m_CriticalC2Configurations2D[configuration] )
           {
           NumberOfC2Configurations2D++;
           for ( int k = currentLabel; k >= 0; k-- )
@@ -157,7 +183,7 @@ WellComposedImageFilter<TImage>
             }
           break;
           }
-        else if ( this->IsCriticalC3Configuration2D( neighborhoodPixels ) )
+        else if ( this->m_CriticalC3Configurations2D[configuration] )
           {
           NumberOfC3Configurations2D++;
           int k4;
@@ -187,7 +213,7 @@ WellComposedImageFilter<TImage>
           break;
           }
 
-        else if ( this->IsCriticalC4Configuration2D( neighborhoodPixels ) )
+        else if ( this->m_CriticalC4Configurations2D[configuration] )
           {
           NumberOfC4Configurations2D++;
 
@@ -247,16 +273,15 @@ WellComposedImageFilter<TImage>
       //  are covered by the rotation cases above (except
       //  in the case of FullInvariance == false.
 
+      pixels = this->PackNeighborhood( It, currentLabel );
+
       for ( unsigned int i = 0; i < 2; i++ )
         {
-        for ( unsigned int j = 0; j < 9; j++ )
-          {
-          neighborhoodPixels[j] =
-            ( It.GetPixel( this->m_ReflectionIndices[i][j] ) == currentLabel );
-          }
+        unsigned int configuration =
+          this->GetConfiguration( pixels, this->m_ReflectionIndices[i] );
 
         if ( !this->m_FullInvariance
-             && this->IsCriticalC1Configuration2D( neighborhoodPixels ) )
+             && this->m_CriticalC1Configurations2D[configuration] )
           {
           NumberOfC1Configurations2D++;
           for ( int k = currentLabel; k >= 0; k-- )
@@ -273,7 +298,7 @@ WellComposedImageFilter<TImage>
           break;
           }
         else if ( !this->m_FullInvariance
-                  && this->IsCriticalC2Configuration2D( neighborhoodPixels ) )
+                  && this->m_CriticalC2Configurations2D[configuration] )
           {
           NumberOfC2Configurations2D++;
           for ( int k = currentLabel; k >= 0; k-- )
@@ -289,7 +314,7 @@ WellComposedImageFilter<TImage>
             }
           break;
           }
-        else if ( this->IsCriticalC3Configuration2D( neighborhoodPixels ) )
+        else if ( this->m_CriticalC3Configurations2D[configuration] )
           {
           NumberOfC3Configurations2D++;
           int k4;
@@ -318,7 +343,7 @@ WellComposedImageFilter<TImage>
                                        static_cast<PixelType>( k7 ) );
           break;
           }
-        else if ( this->IsCriticalC4Configuration2D( neighborhoodPixels ) )
+        else if ( this->m_CriticalC4Configurations2D[configuration] )
           {
           NumberOfC4Configurations2D++;
 
@@ -394,29 +419,23 @@ bool
 WellComposedImageFilter<TImage>
 ::IsChangeSafe2D( PixelType label, IndexType idx )
 {
-  Array<char> neighborhoodPixels( 9 );
-
   typename NeighborhoodIteratorType::RadiusType radius;
   radius.Fill( 1 );
   NeighborhoodIteratorType It( radius, this->GetOutput(),
         this->GetOutput()->GetLargestPossibleRegion() );
   It.SetLocation( idx );
 
+  // The configurations are checked as if the center pixel had changed.
+  unsigned long pixels = this->PackNeighborhood( It, label ) ^ ( 1ul << 4 );
+
   for ( unsigned int i = 0; i < 4; i++ )
     {
-    for ( unsigned int j = 0; j < 9; j++ )
-      {
-      neighborhoodPixels[j] =
-        ( It.GetPixel( this->m_RotationIndices[i][j] ) == label );
-      if ( this->m_RotationIndices[i][j] == 4 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
-      }
-    if ( this->IsCriticalC1Configuration2D( neighborhoodPixels ) ||
-         this->IsCriticalC2Configuration2D( neighborhoodPixels ) ||
-         this->IsCriticalC3Configuration2D( neighborhoodPixels ) ||
-         this->IsCriticalC4Configuration2D( neighborhoodPixels ) )
+    unsigned int configuration =
+      this->GetConfiguration( pixels, this->m_RotationIndices[i] );
+    if ( this->m_CriticalC1Configurations2D[configuration] ||
+         this->m_CriticalC2Configurations2D[configuration] ||
+         this->m_CriticalC3Configurations2D[configuration] ||
+         this->m_CriticalC4Configurations2D[configuration] )
       {
       return false;
       }
@@ -424,17 +443,10 @@ WellComposedImageFilter<TImage>
 
   for ( unsigned int i = 0; i < 2; i++ )
     {
-    for ( unsigned int j = 0; j < 9; j++ )
-      {
-      neighborhoodPixels[j] =
-        ( It.GetPixel( this->m_ReflectionIndices[i][j] ) == label );
-      if ( this->m_ReflectionIndices[i][j] == 4 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
-      }
-    if ( this->IsCriticalC3Configuration2D( neighborhoodPixels ) ||
-         this->IsCriticalC4Configuration2D( neighborhoodPixels ) )
+    unsigned int configuration =
+      this->GetConfiguration( pixels, this->m_ReflectionIndices[i] );
+    if ( this->m_CriticalC3Configurations2D[configuration] ||
+         this->m_CriticalC4Configurations2D[configuration] )
       {
       return false;
       }
@@ -596,6 +608,25 @@ WellComposedImageFilter<TImage>
   this->m_ReflectionIndices[1][6] = 8;
   this->m_ReflectionIndices[1][7] = 7;
   this->m_ReflectionIndices[1][8] = 6;
+
+  // Tabulate the critical configurations, bit j of the table index holding
+  // pixel j of the rotated or reflected neighborhood.
+  Array<char> neighborhood( 9 );
+  for ( unsigned int n = 0; n < 512; n++ )
+    {
+    for ( unsigned int j = 0; j < 9; j++ )
+      {
+      neighborhood[j] = static_cast<char>( ( n >> j ) & 1 );
+      }
+    this->m_CriticalC1Configurations2D[n] =
+      this->IsCriticalC1Configuration2D( neighborhood );
+    this->m_CriticalC2Configurations2D[n] =
+      this->IsCriticalC2Configuration2D( neighborhood );
+    this->m_CriticalC3Configurations2D[n] =
+      this->IsCriticalC3Configuration2D( neighborhood );
+    this->m_CriticalC4Configurations2D[n] =
+      this->IsCriticalC4Configuration2D( neighborhood );
+    }
 }
 
 /*
@@ -653,21 +684,20 @@ WellComposedImageFilter<TImage>
       It.SetLocation( this->m_CriticalConfigurationIndices[label].front() );
       this->m_CriticalConfigurationIndices[label].pop_front();
 
-      Array<char> neighborhoodPixels( 8 );
+      unsigned long pixels = this->PackNeighborhood( It, label );
       bool removedCriticalConfiguration = false;
       /**
        * Deal with the C1 configurations
        */
       for ( unsigned int i = 0; i < 3; i++ )
         {
-        for ( unsigned int j = 0; j < 4; j++ )
-          {
-          neighborhoodPixels[j] = ( It.GetPixel( this->m_C1Indices[i][j] ) == label );
-          }
-        if ( this->IsCriticalC1Configuration3D( neighborhoodPixels ) )
+        unsigned int configuration =
+          this->GetConfiguration( pixels, this->m_C1Indices[i] );
+        if ( this->m_CriticalC1Configurations3D[configuration] )
           {
           this->RemoveCriticalC1Configuration3D( i, label, It.GetIndex() );
           removedCriticalConfiguration = true;
+          pixels = this->PackNeighborhood( It, label );
           }
         }
 
@@ -676,12 +706,9 @@ WellComposedImageFilter<TImage>
        */
       if ( !removedCriticalConfiguration )
         {
-        for ( unsigned int j = 0; j < 8; j++ )
-          {
-          neighborhoodPixels[j]
-            = ( It.GetPixel( this->m_C2Indices[0][j] ) == label );
-          }
-        if ( this->IsCriticalC2Configuration3D( neighborhoodPixels ) )
+        unsigned int configuration =
+          this->GetConfiguration( pixels, this->m_C2Indices[0] );
+        if ( this->m_CriticalC2Configurations3D[configuration] )
           {
           this->RemoveCriticalC2Configuration3D( 0, label, It.GetIndex() );
           }
@@ -709,8 +736,6 @@ WellComposedImageFilter<TImage>
   NeighborhoodIteratorType It( radius, this->GetOutput(),
     this->GetOutput()->GetLargestPossibleRegion() );
 
-  Array<char> neighborhoodPixels( 8 );
-
   int countC1 = 0;
   int countC2 = 0;
 
@@ -721,17 +746,17 @@ WellComposedImageFilter<TImage>
       continue;
       }
 
+    unsigned long pixels = this->PackNeighborhood( It, label );
+
     /**
      * Check for C1 critical configurations
      */
     bool foundC1 = false;
     for ( unsigned int i = 0; i < 3; i++ )
       {
-      for ( unsigned int j = 0; j < 4; j++ )
-        {
-        neighborhoodPixels[j] = ( It.GetPixel( this->m_C1Indices[i][j] ) == label );
-        }
-      if ( this->IsCriticalC1Configuration3D( neighborhoodPixels ) )
+      unsigned int configuration =
+        this->GetConfiguration( pixels, this->m_C1Indices[i] );
+      if ( this->m_CriticalC1Configurations3D[configuration] )
         {
         foundC1 = true;
         countC1++;
@@ -747,11 +772,9 @@ WellComposedImageFilter<TImage>
      */
     else
       {
-      for ( unsigned int j = 0; j < 8; j++ )
-        {
-        neighborhoodPixels[j] = ( It.GetPixel( this->m_C2Indices[0][j] ) == label );
-        }
-      if ( this->IsCriticalC2Configuration3D( neighborhoodPixels ) )
+      unsigned int configuration =
+        this->GetConfiguration( pixels, this->m_C2Indices[0] );
+      if ( this->m_CriticalC2Configurations3D[configuration] )
         {
         this->m_CriticalConfigurationIndices[label].push_back( It.GetIndex() );
         countC2++;
@@ -954,26 +977,21 @@ bool
 WellComposedImageFilter<TImage>
 ::IsChangeSafe3D( PixelType label, IndexType idx )
 {
-  Array<char> neighborhoodPixels( 8 );
-
   typename NeighborhoodIteratorType::RadiusType radius;
   radius.Fill( 1 );
   NeighborhoodIteratorType It( radius, this->GetOutput(),
         this->GetOutput()->GetLargestPossibleRegion() );
   It.SetLocation( idx );
 
+  // The configurations are checked as if the center pixel had changed.
+  unsigned long pixels = this->PackNeighborhood( It, label ) ^ ( 1ul << 13 );
+
   // Check for C1 critical configurations
   for ( unsigned int i = 0; i < 12; i++ )
     {
-    for ( unsigned int j = 0; j < 4; j++ )
-      {
-      neighborhoodPixels[j] = ( It.GetPixel( this->m_C1Indices[i][j] ) == label );
-      if ( this->m_C1Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
-      }
-    if ( this->IsCriticalC1Configuration3D( neighborhoodPixels ) )
+    unsigned int configuration =
+      this->GetConfiguration( pixels, this->m_C1Indices[i] );
+    if ( this->m_CriticalC1Configurations3D[configuration] )
       {
       return false;
       }
@@ -982,15 +1000,9 @@ WellComposedImageFilter<TImage>
   // Check for C2 critical configurations
   for ( unsigned int i = 0; i < 8; i++ )
     {
-    for ( unsigned int j = 0; j < 8; j++ )
-      {
-      neighborhoodPixels[j] = ( It.GetPixel( this->m_C2Indices[i][j] ) == label );
-      if ( this->m_C2Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
-      }
-    if ( this->IsCriticalC2Configuration3D( neighborhoodPixels ) )
+    unsigned int configuration =
+      this->GetConfiguration( pixels, this->m_C2Indices[i] );
+    if ( this->m_CriticalC2Configurations3D[configuration] )
       {
       return false;
       }
@@ -1007,26 +1019,21 @@ WellComposedImageFilter<TImage>
 ::InsertCriticalConfiguration3D( PixelType label,
                                  IndexType idx )
 {
-  Array<char> neighborhoodPixels( 8 );
-
   typename NeighborhoodIteratorType::RadiusType radius;
   radius.Fill( 1 );
   NeighborhoodIteratorType It( radius, this->GetOutput(),
         this->GetOutput()->GetLargestPossibleRegion() );
   It.SetLocation( idx );
 
+  // The configurations are checked as if the center pixel had changed.
+  unsigned long pixels = this->PackNeighborhood( It, label ) ^ ( 1ul << 13 );
+
   // C1 configurations
   for ( unsigned int i = 0; i < 12; i++ )
     {
-    for ( unsigned int j = 0; j < 4; j++ )
-      {
-      neighborhoodPixels[j] = ( It.GetPixel( this->m_C1Indices[i][j] ) == label );
-      if ( this->m_C1Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
-      }
-    if ( this->IsCriticalC1Configuration3D( neighborhoodPixels ) )
+    unsigned int configuration =
+      this->GetConfiguration( pixels, this->m_C1Indices[i] );
+    if ( this->m_CriticalC1Configurations3D[configuration] )
       {
       this->m_CriticalConfigurationIndices[label].push_back(
         It.GetIndex( this->m_C1Indices[i][0] ) );
@@ -1036,15 +1043,9 @@ WellComposedImageFilter<TImage>
   // C2 configurations
   for ( unsigned int i = 0; i < 8; i++ )
     {
-    for ( unsigned int j = 0; j < 8; j++ )
-      {
-      neighborhoodPixels[j] = ( It.GetPixel( this->m_C2Indices[i][j] ) == label );
-      if ( this->m_C2Indices[i][j] == 13 )
-        {
-        neighborhoodPixels[j] = !neighborhoodPixels[j];
-        }
-      }
-    if ( this->IsCriticalC2Configuration3D( neighborhoodPixels ) )
+    unsigned int configuration =
+      this->GetConfiguration( pixels, this->m_C2Indices[i] );
+    if ( this->m_CriticalC2Configurations3D[configuration] )
       {
       this->m_CriticalConfigurationIndices[label].push_back(
         It.GetIndex( this->m_C2Indices[i][0] ) );
@@ -1219,6 +1220,24 @@ WellComposedImageFilter<TImage>
       this->m_C2Indices[i+4][j] = this->m_C2Indices[i+3][j] - subtrahend;
       }
     }
+
+  // Tabulate the critical configurations, bit j of the table index holding
+  // pixel j of the C1 or C2 configuration.
+  Array<char> neighborhood( 8 );
+  for ( unsigned int n = 0; n < 256; n++ )
+    {
+    for ( unsigned int j = 0; j < 8; j++ )
+      {
+      neighborhood[j] = static_cast<char>( ( n >> j ) & 1 );
+      }
+    if ( n < 16 )
+      {
+      this->m_CriticalC1Configurations3D[n] =
+        this->IsCriticalC1Configuration3D( neighborhood );
+      }
+    this->m_CriticalC2Configurations3D[n] =
+      ( this->IsCriticalC2Configuration3D( neighborhood ) != 0 );
+    }
 }
 
 /*
@@ -0,0 +1,164 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkBitPackedBinaryImage.h,v $
+  Language:  C++
+  Date:      $Date: $
+  Version:   $Revision: $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkBitPackedBinaryImage_h
+#define __itkBitPackedBinaryImage_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageRegion.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class BitPackedBinaryImage
+ * \brief Binary image stored with one bit per pixel, with the morphology
+ * operations working directly on the packed words.
+ *
+ * Each row along the first dimension is stored in its own sequence of
+ * words, the bit j of the word i holding the pixel i * WordBits + j, so a
+ * shift along the first dimension is a shift of the words and a shift
+ * along the other dimensions is a shift of whole rows.  Dilations are
+ * computed with these shifts:
+ *
+ * - box: separable, each dimension by log( radius ) shift-or steps,
+ * - diamond: radius successive dilations by the elementary cross,
+ * - ball: decomposed into chords along the first dimension.  The rows
+ *   are dilated once per distinct chord half-width and or-ed with the
+ *   offsets of the chords of that width.
+ *
+ * The elements are those of BinaryBoxStructuringElement,
+ * BinaryDiamondStructuringElement (minimum radius) and
+ * BinaryBallStructuringElement.  Erosions are computed by duality, the
+ * pixels outside the image being foreground as in BinaryErodeImageFilter.
+ *
+ * SetFromImage() and FillImage() convert from and to a regular image.
+ */
+template <unsigned int VImageDimension>
+class ITK_EXPORT BitPackedBinaryImage : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef BitPackedBinaryImage                          Self;
+  typedef Object                                        Superclass;
+  typedef SmartPointer<Self>                            Pointer;
+  typedef SmartPointer<const Self>                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BitPackedBinaryImage, Object );
+
+  itkStaticConstMacro( ImageDimension, unsigned int, VImageDimension );
+
+  typedef unsigned long                                 WordType;
+  typedef std::vector<WordType>                         BufferType;
+
+  typedef ImageRegion<VImageDimension>                  RegionType;
+  typedef typename RegionType::SizeType                 SizeType;
+  typedef typename RegionType::IndexType                IndexType;
+
+  enum StructuringElementType { BoxElement, BallElement, DiamondElement };
+
+  /** Set/Get the region.  Allocate() must be called afterwards. */
+  void SetRegion( const RegionType & region )
+    { this->m_Region = region; }
+  const RegionType & GetRegion() const
+    { return this->m_Region; }
+
+  /** Allocate the buffer, all the pixels being off. */
+  void Allocate();
+
+  void FillBuffer( bool );
+
+  bool GetPixel( const IndexType & ) const;
+  void SetPixel( const IndexType &, bool );
+
+  /** Number of pixels which are on. */
+  unsigned long GetNumberOfOnPixels() const;
+
+  /** Direct access to the words of a row. */
+  unsigned long GetNumberOfRows() const
+    { return this->m_NumberOfRows; }
+  unsigned long GetNumberOfWordsPerRow() const
+    { return this->m_NumberOfWordsPerRow; }
+  WordType * GetRow( unsigned long row )
+    { return &this->m_Buffer[row * this->m_NumberOfWordsPerRow]; }
+  const WordType * GetRow( unsigned long row ) const
+    { return &this->m_Buffer[row * this->m_NumberOfWordsPerRow]; }
+
+  /** Set the region to the buffered region of the image, allocate, and
+   * turn on the pixels equal to the foreground value. */
+  template <class TImage>
+  void SetFromImage( const TImage *, const typename TImage::PixelType & );
+
+  /** Write the foreground value at the pixels which are on and the
+   * background value elsewhere.  The buffered region of the image must be
+   * the region of this image. */
+  template <class TImage>
+  void FillImage( TImage *, const typename TImage::PixelType &,
+    const typename TImage::PixelType & ) const;
+
+  /** Morphology */
+  void Invert();
+  void Dilate( StructuringElementType, const SizeType & );
+  void Erode( StructuringElementType, const SizeType & );
+  void Close( StructuringElementType, const SizeType & );
+  void Open( StructuringElementType, const SizeType & );
+
+protected:
+  BitPackedBinaryImage();
+  virtual ~BitPackedBinaryImage() {}
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** target |= source shifted by the given number of pixels along the
+   * given dimension.  The pixels shifted in from outside are off. */
+  void OrShifted( BufferType & target, const BufferType & source,
+    unsigned int dimension, long shift ) const;
+
+  /** Dilation of the buffer by a line of the given radius along one
+   * dimension. */
+  void DilateAlongDimension( BufferType &, unsigned int dimension,
+    unsigned long radius ) const;
+
+  void DilateBox( const SizeType & );
+  void DilateDiamond( const SizeType & );
+  void DilateBall( const SizeType & );
+
+  /** Turn off the bits beyond the end of the rows. */
+  void ClearPadding( BufferType & ) const;
+
+private:
+  BitPackedBinaryImage( const Self& ); //purposely not implemented
+  void operator=( const Self& ); //purposely not implemented
+
+  RegionType                                            m_Region;
+  BufferType                                            m_Buffer;
+  unsigned long                                         m_NumberOfRows;
+  unsigned long                                         m_NumberOfWordsPerRow;
+  unsigned long                                         m_RowStride[VImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBitPackedBinaryImage.hxx"
+#endif
+
+#endif
@@ -0,0 +1,536 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkBitPackedBinaryImage.hxx,v $
+  Language:  C++
+  Date:      $Date: $
+  Version:   $Revision: $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkBitPackedBinaryImage_hxx
+#define __itkBitPackedBinaryImage_hxx
+
+#include "itkBitPackedBinaryImage.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkOffset.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <unsigned int VImageDimension>
+BitPackedBinaryImage<VImageDimension>
+::BitPackedBinaryImage()
+{
+  this->m_NumberOfRows = 0;
+  this->m_NumberOfWordsPerRow = 0;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    this->m_RowStride[d] = 0;
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::Allocate()
+{
+  const SizeType size = this->m_Region.GetSize();
+  const unsigned long wordBits = 8 * sizeof( WordType );
+
+  this->m_NumberOfWordsPerRow = ( size[0] + wordBits - 1 ) / wordBits;
+  this->m_NumberOfRows = 1;
+  this->m_RowStride[0] = 1;
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    this->m_RowStride[d] = this->m_NumberOfRows;
+    this->m_NumberOfRows *= size[d];
+    }
+  this->m_Buffer.assign(
+    this->m_NumberOfRows * this->m_NumberOfWordsPerRow, 0 );
+  this->Modified();
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::FillBuffer( bool value )
+{
+  std::fill( this->m_Buffer.begin(), this->m_Buffer.end(),
+    value ? ~static_cast<WordType>( 0 ) : static_cast<WordType>( 0 ) );
+  this->ClearPadding( this->m_Buffer );
+  this->Modified();
+}
+
+template <unsigned int VImageDimension>
+bool
+BitPackedBinaryImage<VImageDimension>
+::GetPixel( const IndexType & index ) const
+{
+  const unsigned long wordBits = 8 * sizeof( WordType );
+  const IndexType start = this->m_Region.GetIndex();
+
+  unsigned long row = 0;
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    row += ( index[d] - start[d] ) * this->m_RowStride[d];
+    }
+  const unsigned long x = index[0] - start[0];
+
+  return ( this->GetRow( row )[x / wordBits] >> ( x % wordBits ) ) & 1;
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::SetPixel( const IndexType & index, bool value )
+{
+  const unsigned long wordBits = 8 * sizeof( WordType );
+  const IndexType start = this->m_Region.GetIndex();
+
+  unsigned long row = 0;
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    row += ( index[d] - start[d] ) * this->m_RowStride[d];
+    }
+  const unsigned long x = index[0] - start[0];
+
+  const WordType bit = static_cast<WordType>( 1 ) << ( x % wordBits );
+  if( value )
+    {
+    this->GetRow( row )[x / wordBits] |= bit;
+    }
+  else
+    {
+    this->GetRow( row )[x / wordBits] &= ~bit;
+    }
+}
+
+template <unsigned int VImageDimension>
+unsigned long
+BitPackedBinaryImage<VImageDimension>
+::GetNumberOfOnPixels() const
+{
+  unsigned long count = 0;
+  for( unsigned long i = 0; i < this->m_Buffer.size(); i++ )
+    {
+    for( WordType word = this->m_Buffer[i]; word; word &= word - 1 )
+      {
+      count++;
+      }
+    }
+  return count;
+}
+
+template <unsigned int VImageDimension>
+template <class TImage>
+void
+BitPackedBinaryImage<VImageDimension>
+::SetFromImage( const TImage *image,
+  const typename TImage::PixelType & foreground )
+{
+  const unsigned long wordBits = 8 * sizeof( WordType );
+
+  this->SetRegion( image->GetBufferedRegion() );
+  this->Allocate();
+
+  const unsigned long length = this->m_Region.GetSize()[0];
+
+  ImageRegionConstIterator<TImage> It( image, this->m_Region );
+
+  unsigned long x = 0;
+  WordType *words = &this->m_Buffer[0];
+  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    if( It.Get() == foreground )
+      {
+      words[x / wordBits] |= static_cast<WordType>( 1 ) << ( x % wordBits );
+      }
+    if( ++x == length )
+      {
+      x = 0;
+      words += this->m_NumberOfWordsPerRow;
+      }
+    }
+}
+
+template <unsigned int VImageDimension>
+template <class TImage>
+void
+BitPackedBinaryImage<VImageDimension>
+::FillImage( TImage *image, const typename TImage::PixelType & foreground,
+  const typename TImage::PixelType & background ) const
+{
+  const unsigned long wordBits = 8 * sizeof( WordType );
+
+  if( image->GetBufferedRegion() != this->m_Region )
+    {
+    itkExceptionMacro( "The buffered region of the image does not match "
+      << "the region of the bit packed image." );
+    }
+
+  const unsigned long length = this->m_Region.GetSize()[0];
+
+  ImageRegionIterator<TImage> It( image, this->m_Region );
+
+  unsigned long x = 0;
+  const WordType *words = &this->m_Buffer[0];
+  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    if( ( words[x / wordBits] >> ( x % wordBits ) ) & 1 )
+      {
+      It.Set( foreground );
+      }
+    else
+      {
+      It.Set( background );
+      }
+    if( ++x == length )
+      {
+      x = 0;
+      words += this->m_NumberOfWordsPerRow;
+      }
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::ClearPadding( BufferType & buffer ) const
+{
+  const unsigned long wordBits = 8 * sizeof( WordType );
+  const unsigned long remainder = this->m_Region.GetSize()[0] % wordBits;
+  if( remainder == 0 )
+    {
+    return;
+    }
+  const WordType mask = ( static_cast<WordType>( 1 ) << remainder ) - 1;
+  for( unsigned long row = 0; row < this->m_NumberOfRows; row++ )
+    {
+    buffer[( row + 1 ) * this->m_NumberOfWordsPerRow - 1] &= mask;
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::OrShifted( BufferType & target, const BufferType & source,
+  unsigned int dimension, long shift ) const
+{
+  const long words = static_cast<long>( this->m_NumberOfWordsPerRow );
+  const SizeType size = this->m_Region.GetSize();
+
+  if( shift == 0 )
+    {
+    for( unsigned long i = 0; i < target.size(); i++ )
+      {
+      target[i] |= source[i];
+      }
+    return;
+    }
+
+  if( dimension == 0 )
+    {
+    /**
+     * Shift of the words of each row, the bits of the neighboring word
+     * being carried over.
+     */
+    const long wordBits = 8 * sizeof( WordType );
+    const long q = vnl_math_abs( shift ) / wordBits;
+    const long b = vnl_math_abs( shift ) % wordBits;
+
+    for( unsigned long row = 0; row < this->m_NumberOfRows; row++ )
+      {
+      const WordType *in = &source[row * words];
+      WordType *out = &target[row * words];
+      if( shift > 0 )
+        {
+        for( long i = q; i < words; i++ )
+          {
+          WordType value = in[i - q] << b;
+          if( b > 0 && i - q - 1 >= 0 )
+            {
+            value |= in[i - q - 1] >> ( wordBits - b );
+            }
+          out[i] |= value;
+          }
+        }
+      else
+        {
+        for( long i = 0; i + q < words; i++ )
+          {
+          WordType value = in[i + q] >> b;
+          if( b > 0 && i + q + 1 < words )
+            {
+            value |= in[i + q + 1] << ( wordBits - b );
+            }
+          out[i] |= value;
+          }
+        }
+      }
+    this->ClearPadding( target );
+    return;
+    }
+
+  /**
+   * Shift of whole rows: the rows come in blocks of m_RowStride[dimension]
+   * rows sharing the same coordinate along the dimension.
+   */
+  const unsigned long stride = this->m_RowStride[dimension];
+  const long length = static_cast<long>( size[dimension] );
+  const unsigned long numberOfBlocks = this->m_NumberOfRows
+    / ( stride * length );
+
+  for( unsigned long block = 0; block < numberOfBlocks; block++ )
+    {
+    for( long c = vnl_math_max( 0L, shift );
+      c < vnl_math_min( length, length + shift ); c++ )
+      {
+      const WordType *in = &source[( ( block * length + c - shift )
+        * stride ) * words];
+      WordType *out = &target[( ( block * length + c ) * stride ) * words];
+      for( unsigned long i = 0; i < stride * words; i++ )
+        {
+        out[i] |= in[i];
+        }
+      }
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::DilateAlongDimension( BufferType & buffer, unsigned int dimension,
+  unsigned long radius ) const
+{
+  /**
+   * Each step or-s the buffer with its copies shifted by +/- step, which
+   * extends the covered interval [-covered, covered] without gaps as long
+   * as step <= covered + 1.
+   */
+  unsigned long covered = 0;
+  while( covered < radius )
+    {
+    const unsigned long step = vnl_math_min( covered + 1, radius - covered );
+    const BufferType source = buffer;
+    this->OrShifted( buffer, source, dimension, static_cast<long>( step ) );
+    this->OrShifted( buffer, source, dimension, -static_cast<long>( step ) );
+    covered += step;
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::DilateBox( const SizeType & radius )
+{
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    this->DilateAlongDimension( this->m_Buffer, d, radius[d] );
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::DilateDiamond( const SizeType & radius )
+{
+  unsigned long minimumRadius = radius[0];
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    minimumRadius = vnl_math_min( minimumRadius,
+      static_cast<unsigned long>( radius[d] ) );
+    }
+
+  for( unsigned long n = 0; n < minimumRadius; n++ )
+    {
+    const BufferType source = this->m_Buffer;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      this->OrShifted( this->m_Buffer, source, d, 1 );
+      this->OrShifted( this->m_Buffer, source, d, -1 );
+      }
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::DilateBall( const SizeType & radius )
+{
+  typedef Offset<VImageDimension> OffsetType;
+
+  /**
+   * The ball of BinaryBallStructuringElement holds the offsets with
+   * sum_d ( o[d] / ( radius[d] + 0.5 ) )^2 <= 1.  Group its chords along
+   * the first dimension, centered at the offsets o[1], ..., o[D-1], by
+   * half-width.
+   */
+  std::vector<std::vector<OffsetType> > chords( radius[0] + 1 );
+
+  OffsetType offset;
+  offset.Fill( 0 );
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    offset[d] = -static_cast<long>( radius[d] );
+    }
+  bool isDone = false;
+  while( !isDone )
+    {
+    double distance = 0.0;
+    for( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      distance += vnl_math_sqr( offset[d] / ( radius[d] + 0.5 ) );
+      }
+    if( distance <= 1.0 )
+      {
+      const unsigned long halfWidth = vnl_math_min(
+        static_cast<unsigned long>( radius[0] ),
+        static_cast<unsigned long>( vcl_floor(
+        ( radius[0] + 0.5 ) * vcl_sqrt( 1.0 - distance ) ) ) );
+      chords[halfWidth].push_back( offset );
+      }
+
+    isDone = true;
+    for( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      if( offset[d] < static_cast<long>( radius[d] ) )
+        {
+        offset[d]++;
+        isDone = false;
+        break;
+        }
+      offset[d] = -static_cast<long>( radius[d] );
+      }
+    }
+
+  const BufferType source = this->m_Buffer;
+  std::fill( this->m_Buffer.begin(), this->m_Buffer.end(), 0 );
+
+  for( unsigned long w = 0; w < chords.size(); w++ )
+    {
+    if( chords[w].empty() )
+      {
+      continue;
+      }
+    BufferType dilated = source;
+    this->DilateAlongDimension( dilated, 0, w );
+
+    /**
+     * The offsets along the dimensions > 0 are applied one dimension at a
+     * time on a scratch buffer, except in 2-D where a single shift suffices.
+     */
+    for( unsigned long n = 0; n < chords[w].size(); n++ )
+      {
+      if( ImageDimension == 1 )
+        {
+        this->OrShifted( this->m_Buffer, dilated, 0, 0 );
+        continue;
+        }
+      if( ImageDimension == 2 )
+        {
+        this->OrShifted( this->m_Buffer, dilated, 1, chords[w][n][1] );
+        continue;
+        }
+      BufferType shifted = dilated;
+      for( unsigned int d = 1; d < ImageDimension - 1; d++ )
+        {
+        BufferType scratch( shifted.size(), 0 );
+        this->OrShifted( scratch, shifted, d, chords[w][n][d] );
+        shifted.swap( scratch );
+        }
+      this->OrShifted( this->m_Buffer, shifted, ImageDimension - 1,
+        chords[w][n][ImageDimension - 1] );
+      }
+    }
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::Invert()
+{
+  for( unsigned long i = 0; i < this->m_Buffer.size(); i++ )
+    {
+    this->m_Buffer[i] = ~this->m_Buffer[i];
+    }
+  this->ClearPadding( this->m_Buffer );
+  this->Modified();
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::Dilate( StructuringElementType element, const SizeType & radius )
+{
+  switch( element )
+    {
+    case BoxElement:
+      this->DilateBox( radius );
+      break;
+    case BallElement:
+      this->DilateBall( radius );
+      break;
+    case DiamondElement:
+      this->DilateDiamond( radius );
+      break;
+    }
+  this->Modified();
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::Erode( StructuringElementType element, const SizeType & radius )
+{
+  // the elements are symmetric
+  this->Invert();
+  this->Dilate( element, radius );
+  this->Invert();
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::Close( StructuringElementType element, const SizeType & radius )
+{
+  this->Dilate( element, radius );
+  this->Erode( element, radius );
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::Open( StructuringElementType element, const SizeType & radius )
+{
+  this->Erode( element, radius );
+  this->Dilate( element, radius );
+}
+
+template <unsigned int VImageDimension>
+void
+BitPackedBinaryImage<VImageDimension>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Region: " << this->m_Region << std::endl;
+  os << indent << "Words per row: "
+     << this->m_NumberOfWordsPerRow << std::endl;
+}
+
+} // end namespace itk
+
+#endif
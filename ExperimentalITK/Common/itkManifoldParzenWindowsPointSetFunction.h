@@ -25,7 +25,10 @@
 #include "itkMatrix.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkMeshSource.h"
+#include "itkMultiThreader.h"
 #include "itkPointSet.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkTimeStamp.h"
 #include "itkVector.h"
 #include "itkWeightedCentroidKdTreeGenerator.h"
 
@@ -36,6 +39,17 @@ namespace itk
 
 /** \class ManifoldParzenWindowsPointSetFunction.h
  * \brief point set filter.
+ *
+ * Many query points can be evaluated at once with EvaluatePoints().  The
+ * queries are sorted along a Morton curve and split among the threads, and
+ * the neighbor list of a query is reused for the following ones as long as
+ * it provably contains their EvaluationKNeighborhood nearest kernels, so
+ * that the kd-tree is only searched when the queries move away.  Both
+ * Evaluate() and EvaluatePoints() use the inverse Cholesky factors of the
+ * kernel covariances, packed with the kernel means, which are computed when
+ * the input point set is set or the kd-tree is regenerated, and by
+ * EvaluatePoints() after SetGaussian().  Changes made to a kernel through
+ * GetGaussian() are not detected.
  */
 
 template <class TPointSet, class TOutput = double, class TCoordRep = double>
@@ -74,6 +88,7 @@ public:
   typedef typename TreeGeneratorType::KdTreeType   KdTreeType;
   typedef typename KdTreeType
     ::InstanceIdentifierVectorType                 NeighborhoodIdentifierType;
+  typedef typename KdTreeType::InstanceIdentifier  InstanceIdentifierType;
 
 
   typedef typename Statistics
@@ -90,6 +105,9 @@ public:
   typedef std::vector<typename GaussianType::Pointer>    GaussianContainerType;
   typedef typename GaussianType::MatrixType              CovarianceMatrixType;
 
+  typedef std::vector<InputPointType>                    InputPointContainerType;
+  typedef std::vector<OutputType>                        OutputContainerType;
+
   /** Helper functions */
 
   itkSetMacro( CovarianceKNeighborhood, unsigned int );
@@ -119,6 +137,14 @@ public:
 
   virtual TOutput Evaluate( const InputPointType& point ) const;
 
+  /** Evaluate the function at all the points.  The result is the same as
+   * calling Evaluate() for each point, up to rounding. */
+  virtual void EvaluatePoints( const InputPointContainerType & points,
+    OutputContainerType & values ) const;
+
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
   PointType GenerateRandomSample();
 
   typename GaussianType::Pointer GetGaussian( unsigned int i )
@@ -141,6 +167,7 @@ public:
       this->m_Gaussians.resize( i+1 );
       }
     this->m_Gaussians[i] = gaussian;
+    this->m_GaussiansTime.Modified();
     this->Modified();
     }
 
@@ -158,6 +185,34 @@ protected:
 
   void GenerateData();
 
+  /** Internal structure used for passing the queries to the threads. */
+  struct EvaluationThreadStruct
+  {
+    const Self                                 *Function;
+    const InputPointContainerType              *Points;
+    const std::vector<unsigned long>           *Order;
+    OutputContainerType                        *Values;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE EvaluationThreaderCallback( void *arg );
+
+  /** Pack the kernel means with the inverse Cholesky factors of the kernel
+   * covariances. */
+  void GenerateKernelParameters() const;
+
+  /** Whether the packed kernel parameters are up to date. */
+  bool KernelParametersAreValid() const;
+
+  /** Sum at the query of the kernels listed in ids, or of the first
+   * numberOfKernels kernels if ids is NULL. */
+  RealType EvaluateKernels( const RealType *query,
+    const InstanceIdentifierType *ids, unsigned long numberOfKernels ) const;
+
+  /** Kd-tree search, serialized since the tree keeps its search state. */
+  void SearchNeighbors( const MeasurementVectorType & query,
+    unsigned int numberOfNeighbors, NeighborhoodIdentifierType & ) const;
+
 private:
   //purposely not implemented
   ManifoldParzenWindowsPointSetFunction( const Self& );
@@ -177,6 +232,17 @@ private:
   bool                                          m_Normalize;
   bool                                          m_UseAnisotropicCovariances;
   typename RandomizerType::Pointer              m_Randomizer;
+
+  /** Per kernel: the mean followed by the rows of the lower triangular
+   * inverse of the Cholesky factor of the covariance. */
+  mutable std::vector<RealType>                 m_KernelParameters;
+  mutable std::vector<bool>                     m_KernelIsFactored;
+  mutable TimeStamp                             m_KernelParametersTime;
+  TimeStamp                                     m_GaussiansTime;
+  mutable SimpleFastMutexLock                   m_SearchLock;
+
+  MultiThreader::Pointer                        m_MultiThreader;
+  unsigned int                                  m_NumberOfThreads;
 };
 
 } // end namespace itk
@@ -19,9 +19,13 @@
 
 #include "itkManifoldParzenWindowsPointSetFunction.h"
 
+#include "vnl/vnl_matrix.h"
 #include "vnl/vnl_vector.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace itk
 {
 
@@ -45,6 +49,9 @@ ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
 
   this->m_Randomizer = RandomizerType::New();
   this->m_Randomizer->SetSeed();
+
+  this->m_MultiThreader = MultiThreader::New();
+  this->m_NumberOfThreads = this->m_MultiThreader->GetNumberOfThreads();
 }
 
 template <class TPointSet, class TOutput, class TCoordRep>
@@ -188,6 +195,8 @@ ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
       }
     ++It;
     }
+
+  this->GenerateKernelParameters();
 }
 
 template <class TPointSet, class TOutput, class TCoordRep>
@@ -218,38 +227,236 @@ ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
   this->m_KdTreeGenerator->SetSample( this->m_SamplePoints );
   this->m_KdTreeGenerator->SetBucketSize( this->m_BucketSize );
   this->m_KdTreeGenerator->Update();
+
+  this->GenerateKernelParameters();
 }
 
 template <class TPointSet, class TOutput, class TCoordRep>
-TOutput
+void
 ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
-::Evaluate( const InputPointType &point ) const
+::GenerateKernelParameters() const
 {
-  if( !this->m_KdTreeGenerator )
+  const unsigned int numberOfParameters =
+    Dimension + Dimension * ( Dimension + 1 ) / 2;
+  const unsigned long numberOfKernels = this->m_Gaussians.size();
+
+  this->m_KernelParameters.assign( numberOfKernels * numberOfParameters, 0.0 );
+  this->m_KernelIsFactored.assign( numberOfKernels, false );
+
+  for( unsigned long n = 0; n < numberOfKernels; n++ )
     {
-    MeasurementVectorType measurement;
+    if( this->m_Gaussians[n].IsNull() )
+      {
+      continue;
+      }
+
+    RealType *parameters = &this->m_KernelParameters[n * numberOfParameters];
+
+    typename GaussianType::MeanType mean = this->m_Gaussians[n]->GetMean();
     for( unsigned int d = 0; d < Dimension; d++ )
       {
-      measurement[d] = point[d];
+      parameters[d] = static_cast<RealType>( mean[d] );
+      }
+
+    /**
+     * Cholesky factor L of the covariance, C = L L^T.  Kernels whose
+     * covariance is not positive definite are evaluated by the gaussian.
+     */
+    CovarianceMatrixType covariance = this->m_Gaussians[n]->GetCovariance();
+
+    vnl_matrix<RealType> L( Dimension, Dimension, 0.0 );
+    bool isPositiveDefinite = true;
+    for( unsigned int i = 0; i < Dimension && isPositiveDefinite; i++ )
+      {
+      for( unsigned int j = 0; j <= i; j++ )
+        {
+        RealType sum = static_cast<RealType>( covariance( i, j ) );
+        for( unsigned int k = 0; k < j; k++ )
+          {
+          sum -= L( i, k ) * L( j, k );
+          }
+        if( j < i )
+          {
+          L( i, j ) = sum / L( j, j );
+          }
+        else if( sum > 0.0 )
+          {
+          L( i, i ) = vcl_sqrt( sum );
+          }
+        else
+          {
+          isPositiveDefinite = false;
+          }
+        }
+      }
+    if( !isPositiveDefinite )
+      {
+      continue;
+      }
+
+    /**
+     * The quadratic form of the kernel is | L^-1 ( x - mean ) |^2.  The
+     * inverse of L is obtained by forward substitution and stored row by
+     * row after the mean.
+     */
+    vnl_matrix<RealType> inverseL( Dimension, Dimension, 0.0 );
+    for( unsigned int i = 0; i < Dimension; i++ )
+      {
+      inverseL( i, i ) = 1.0 / L( i, i );
+      for( unsigned int j = 0; j < i; j++ )
+        {
+        RealType sum = 0.0;
+        for( unsigned int k = j; k < i; k++ )
+          {
+          sum += L( i, k ) * inverseL( k, j );
+          }
+        inverseL( i, j ) = -sum / L( i, i );
+        }
+      }
+
+    RealType *factor = parameters + Dimension;
+    for( unsigned int i = 0; i < Dimension; i++ )
+      {
+      for( unsigned int j = 0; j <= i; j++ )
+        {
+        *factor++ = inverseL( i, j );
+        }
+      }
+    this->m_KernelIsFactored[n] = true;
+    }
+
+  this->m_KernelParametersTime.Modified();
+}
+
+template <class TPointSet, class TOutput, class TCoordRep>
+bool
+ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
+::KernelParametersAreValid() const
+{
+  return ( this->m_KernelIsFactored.size() == this->m_Gaussians.size()
+    && this->m_KernelParametersTime.GetMTime()
+    > this->m_GaussiansTime.GetMTime() );
+}
+
+template <class TPointSet, class TOutput, class TCoordRep>
+typename ManifoldParzenWindowsPointSetFunction
+  <TPointSet, TOutput, TCoordRep>::RealType
+ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
+::EvaluateKernels( const RealType *query, const InstanceIdentifierType *ids,
+  unsigned long numberOfKernels ) const
+{
+  const unsigned int numberOfParameters =
+    Dimension + Dimension * ( Dimension + 1 ) / 2;
+  const unsigned long blockSize = 64;
+
+  /**
+   * The exponents of a block of kernels are computed first and then
+   * exponentiated in a separate loop over contiguous memory, which the
+   * compiler can vectorize.
+   */
+  RealType exponents[blockSize];
+  RealType sum = 0.0;
+
+  for( unsigned long begin = 0; begin < numberOfKernels; begin += blockSize )
+    {
+    const unsigned long count =
+      vnl_math_min( blockSize, numberOfKernels - begin );
+    for( unsigned long j = 0; j < count; j++ )
+      {
+      const unsigned long n = ( ids ) ? ids[begin + j] : begin + j;
+      if( !this->m_KernelIsFactored[n] )
+        {
+        exponents[j] = NumericTraits<RealType>::NonpositiveMin();
+        if( this->m_Gaussians[n].IsNotNull() )
+          {
+          VectorType measurement;
+          for( unsigned int d = 0; d < Dimension; d++ )
+            {
+            measurement[d] = query[d];
+            }
+          sum += static_cast<RealType>(
+            this->m_Gaussians[n]->Evaluate( measurement ) );
+          }
+        continue;
+        }
+
+      const RealType *parameters =
+        &this->m_KernelParameters[n * numberOfParameters];
+      RealType difference[Dimension];
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        difference[d] = query[d] - parameters[d];
+        }
+      const RealType *factor = parameters + Dimension;
+      RealType distance = 0.0;
+      for( unsigned int i = 0; i < Dimension; i++ )
+        {
+        RealType y = 0.0;
+        for( unsigned int k = 0; k <= i; k++ )
+          {
+          y += factor[k] * difference[k];
+          }
+        factor += i + 1;
+        distance += y * y;
+        }
+      exponents[j] = -0.5 * distance;
+      }
+    for( unsigned long j = 0; j < count; j++ )
+      {
+      sum += vcl_exp( exponents[j] );
       }
+    }
+  return sum;
+}
 
+template <class TPointSet, class TOutput, class TCoordRep>
+void
+ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
+::SearchNeighbors( const MeasurementVectorType & query,
+  unsigned int numberOfNeighbors, NeighborhoodIdentifierType & neighbors ) const
+{
+  this->m_SearchLock.Lock();
+  this->m_KdTreeGenerator->GetOutput()->Search( query, numberOfNeighbors,
+    neighbors );
+  this->m_SearchLock.Unlock();
+}
+
+template <class TPointSet, class TOutput, class TCoordRep>
+TOutput
+ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
+::Evaluate( const InputPointType &point ) const
+{
+  MeasurementVectorType queryPoint;
+  RealType query[Dimension];
+  for( unsigned int d = 0; d < Dimension; d++ )
+    {
+    queryPoint[d] = point[d];
+    query[d] = point[d];
+    }
+
+  const bool useKernelParameters = this->KernelParametersAreValid();
+
+  if( !this->m_KdTreeGenerator )
+    {
     OutputType sum = 0.0;
-    typename GaussianContainerType::const_iterator it;
-    for( it = this->m_Gaussians.begin(); it != this->m_Gaussians.end(); ++it )
+    if( useKernelParameters )
       {
-      sum += static_cast<OutputType>( (*it)->Evaluate( measurement ) );
+      sum = static_cast<OutputType>( this->EvaluateKernels( query, NULL,
+        this->m_Gaussians.size() ) );
+      }
+    else
+      {
+      typename GaussianContainerType::const_iterator it;
+      for( it = this->m_Gaussians.begin(); it != this->m_Gaussians.end(); ++it )
+        {
+        sum += static_cast<OutputType>( (*it)->Evaluate( queryPoint ) );
+        }
       }
     return static_cast<OutputType>(
       sum / static_cast<OutputType>( this->m_Gaussians.size() ) );
     }
   else
     {
-    MeasurementVectorType queryPoint;
-    for( unsigned int d = 0; d < Dimension; d++ )
-      {
-      queryPoint[d] = point[d];
-      }
-
     unsigned int numberOfNeighbors = vnl_math_min(
       this->m_EvaluationKNeighborhood,
       static_cast<unsigned int>( this->m_Gaussians.size() ) );
@@ -258,23 +465,37 @@ ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
 
     if( numberOfNeighbors == this->m_Gaussians.size() )
       {
-      for( unsigned int j = 0; j < this->m_Gaussians.size(); j++ )
+      if( useKernelParameters )
         {
-        sum += static_cast<OutputType>(
-          this->m_Gaussians[j]->Evaluate( queryPoint ) );
+        sum = static_cast<OutputType>( this->EvaluateKernels( query, NULL,
+          numberOfNeighbors ) );
+        }
+      else
+        {
+        for( unsigned int j = 0; j < this->m_Gaussians.size(); j++ )
+          {
+          sum += static_cast<OutputType>(
+            this->m_Gaussians[j]->Evaluate( queryPoint ) );
+          }
         }
       }
     else
       {
-      typename TreeGeneratorType::KdTreeType
-        ::InstanceIdentifierVectorType neighbors;
-      this->m_KdTreeGenerator->GetOutput()->Search( queryPoint,
-        numberOfNeighbors, neighbors );
+      NeighborhoodIdentifierType neighbors;
+      this->SearchNeighbors( queryPoint, numberOfNeighbors, neighbors );
 
-      for( unsigned int j = 0; j < numberOfNeighbors; j++ )
+      if( useKernelParameters )
         {
-        sum += static_cast<OutputType>(
-          this->m_Gaussians[neighbors[j]]->Evaluate( queryPoint ) );
+        sum = static_cast<OutputType>( this->EvaluateKernels( query,
+          &neighbors[0], numberOfNeighbors ) );
+        }
+      else
+        {
+        for( unsigned int j = 0; j < numberOfNeighbors; j++ )
+          {
+          sum += static_cast<OutputType>(
+            this->m_Gaussians[neighbors[j]]->Evaluate( queryPoint ) );
+          }
         }
       }
     return static_cast<OutputType>(
@@ -282,6 +503,239 @@ ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
     }
 }
 
+template <class TPointSet, class TOutput, class TCoordRep>
+void
+ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
+::EvaluatePoints( const InputPointContainerType & points,
+  OutputContainerType & values ) const
+{
+  values.resize( points.size() );
+  if( points.empty() )
+    {
+    return;
+    }
+
+  if( !this->KernelParametersAreValid() )
+    {
+    this->GenerateKernelParameters();
+    }
+
+  /**
+   * Sort the queries along a Morton curve over their bounding box so that
+   * consecutive queries, and therefore the queries of a thread, are close
+   * to each other.
+   */
+  RealType minimum[Dimension];
+  RealType maximum[Dimension];
+  for( unsigned int d = 0; d < Dimension; d++ )
+    {
+    minimum[d] = maximum[d] = points[0][d];
+    }
+  for( unsigned long i = 1; i < points.size(); i++ )
+    {
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      minimum[d] = vnl_math_min( minimum[d],
+        static_cast<RealType>( points[i][d] ) );
+      maximum[d] = vnl_math_max( maximum[d],
+        static_cast<RealType>( points[i][d] ) );
+      }
+    }
+
+  const unsigned int numberOfCodeBits = 32;
+  const unsigned int bitsPerAxis = vnl_math_max( 1u,
+    vnl_math_min( 16u, numberOfCodeBits / Dimension ) );
+  const RealType maximumCell = static_cast<RealType>(
+    ( 1ul << bitsPerAxis ) - 1 );
+
+  std::vector<std::pair<unsigned long, unsigned long> > codes( points.size() );
+  for( unsigned long i = 0; i < points.size(); i++ )
+    {
+    unsigned long code = 0;
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      unsigned long cell = 0;
+      if( maximum[d] > minimum[d] )
+        {
+        cell = static_cast<unsigned long>( maximumCell *
+          ( points[i][d] - minimum[d] ) / ( maximum[d] - minimum[d] ) + 0.5 );
+        }
+      for( unsigned int b = 0; b < bitsPerAxis; b++ )
+        {
+        const unsigned int position = b * Dimension + d;
+        if( position < numberOfCodeBits && ( ( cell >> b ) & 1ul ) )
+          {
+          code |= ( 1ul << position );
+          }
+        }
+      }
+    codes[i] = std::make_pair( code, i );
+    }
+  std::sort( codes.begin(), codes.end() );
+
+  std::vector<unsigned long> order( points.size() );
+  for( unsigned long i = 0; i < points.size(); i++ )
+    {
+    order[i] = codes[i].second;
+    }
+
+  EvaluationThreadStruct str;
+  str.Function = this;
+  str.Points = &points;
+  str.Order = &order;
+  str.Values = &values;
+
+  this->m_MultiThreader->SetNumberOfThreads( this->m_NumberOfThreads );
+  this->m_MultiThreader->SetSingleMethod(
+    this->EvaluationThreaderCallback, &str );
+  this->m_MultiThreader->SingleMethodExecute();
+}
+
+template <class TPointSet, class TOutput, class TCoordRep>
+ITK_THREAD_RETURN_TYPE
+ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
+::EvaluationThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  EvaluationThreadStruct *str =
+    static_cast<EvaluationThreadStruct *>( info->UserData );
+  const Self *function = str->Function;
+
+  const std::vector<unsigned long> & order = *str->Order;
+  const InputPointContainerType & points = *str->Points;
+  OutputContainerType & values = *str->Values;
+
+  const unsigned long numberOfPoints = order.size();
+  unsigned long begin = static_cast<unsigned long>( static_cast<double>(
+    numberOfPoints ) * info->ThreadID / info->NumberOfThreads );
+  unsigned long end = static_cast<unsigned long>( static_cast<double>(
+    numberOfPoints ) * ( info->ThreadID + 1 ) / info->NumberOfThreads );
+
+  const unsigned long numberOfKernels = function->m_Gaussians.size();
+  const unsigned int numberOfParameters =
+    Dimension + Dimension * ( Dimension + 1 ) / 2;
+
+  unsigned long numberOfNeighbors = numberOfKernels;
+  if( function->m_KdTreeGenerator )
+    {
+    numberOfNeighbors = vnl_math_min( static_cast<unsigned long>(
+      function->m_EvaluationKNeighborhood ), numberOfKernels );
+    }
+
+  MeasurementVectorType queryPoint;
+  RealType query[Dimension];
+
+  if( numberOfNeighbors == numberOfKernels )
+    {
+    for( unsigned long i = begin; i < end; i++ )
+      {
+      const InputPointType & point = points[order[i]];
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        query[d] = point[d];
+        }
+      values[order[i]] = static_cast<OutputType>(
+        function->EvaluateKernels( query, NULL, numberOfKernels ) /
+        static_cast<RealType>( numberOfKernels ) );
+      }
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  /**
+   * The kd-tree is searched for the 2k nearest kernels of an anchor query.
+   * Let r be the distance from the anchor to its k-th nearest kernel and R
+   * the distance to the farthest of these candidates.  For a query at a
+   * distance delta from the anchor, its k nearest kernels are closer than
+   * r + delta whereas the kernels which are not candidates are farther than
+   * R - delta.  The candidates thus contain the k nearest kernels of every
+   * query with r + 2 delta < R, and only the distances to the candidates
+   * need to be computed.  Otherwise the query becomes the new anchor.
+   */
+  const unsigned long numberOfCandidates =
+    vnl_math_min( 2 * numberOfNeighbors, numberOfKernels );
+
+  NeighborhoodIdentifierType candidates;
+  std::vector<std::pair<RealType, InstanceIdentifierType> > distances;
+  std::vector<InstanceIdentifierType> neighbors( numberOfNeighbors );
+
+  RealType anchor[Dimension];
+  RealType anchorRadius = 0.0;
+  RealType candidateRadius = 0.0;
+  bool hasAnchor = false;
+
+  for( unsigned long i = begin; i < end; i++ )
+    {
+    const InputPointType & point = points[order[i]];
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      queryPoint[d] = point[d];
+      query[d] = point[d];
+      }
+
+    bool reuseCandidates = false;
+    if( hasAnchor )
+      {
+      RealType delta = 0.0;
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        delta += vnl_math_sqr( query[d] - anchor[d] );
+        }
+      reuseCandidates =
+        ( anchorRadius + 2.0 * vcl_sqrt( delta ) < candidateRadius );
+      }
+    if( !reuseCandidates )
+      {
+      function->SearchNeighbors( queryPoint, numberOfCandidates, candidates );
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        anchor[d] = query[d];
+        }
+      hasAnchor = true;
+      }
+
+    distances.resize( candidates.size() );
+    for( unsigned long j = 0; j < candidates.size(); j++ )
+      {
+      const RealType *mean =
+        &function->m_KernelParameters[candidates[j] * numberOfParameters];
+      RealType distance = 0.0;
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        distance += vnl_math_sqr( query[d] - mean[d] );
+        }
+      distances[j] = std::make_pair( distance, candidates[j] );
+      }
+    std::nth_element( distances.begin(),
+      distances.begin() + ( numberOfNeighbors - 1 ), distances.end() );
+
+    if( !reuseCandidates )
+      {
+      anchorRadius = vcl_sqrt( distances[numberOfNeighbors - 1].first );
+      if( numberOfCandidates == numberOfKernels )
+        {
+        candidateRadius = NumericTraits<RealType>::max();
+        }
+      else
+        {
+        candidateRadius = vcl_sqrt( std::max_element(
+          distances.begin() + ( numberOfNeighbors - 1 ),
+          distances.end() )->first );
+        }
+      }
+
+    for( unsigned long j = 0; j < numberOfNeighbors; j++ )
+      {
+      neighbors[j] = distances[j].second;
+      }
+    values[order[i]] = static_cast<OutputType>(
+      function->EvaluateKernels( query, &neighbors[0], numberOfNeighbors ) /
+      static_cast<RealType>( numberOfNeighbors ) );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template <class TPointSet, class TOutput, class TCoordRep>
 typename ManifoldParzenWindowsPointSetFunction
   <TPointSet, TOutput, TCoordRep>::NeighborhoodIdentifierType
@@ -361,6 +815,8 @@ ManifoldParzenWindowsPointSetFunction<TPointSet, TOutput, TCoordRep>
                << this->m_Normalize << std::endl;
   os << indent << "Use anisotropic covariances: "
                << this->m_UseAnisotropicCovariances << std::endl;
+  os << indent << "Number of threads: "
+               << this->m_NumberOfThreads << std::endl;
 }
 
 }  //end namespace itk
@@ -0,0 +1,447 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkSimplePointLookupTable.h,v $
+  Language:  C++
+  Date:      $Date: $
+  Version:   $Revision: $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkSimplePointLookupTable_h
+#define __itkSimplePointLookupTable_h
+
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itksys/SystemTools.hxx"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class SimplePointLookupTable
+ * \brief Classifies 3x3x3 binary configurations as simple or not simple
+ * with a single table lookup.
+ *
+ * A configuration is the set of the 26 neighbors of a point, packed into
+ * the lower 26 bits of an unsigned integer.  Neighbor n of a radius 1
+ * neighborhood iterator (n = 0..26, n != 13, ordered with the first index
+ * varying fastest) is stored in bit GetBit( n ).  The center point is not
+ * part of the configuration.
+ *
+ * The connectivities follow the convention of topological_numbers.h,
+ * i.e. 1 = (6+,18), 2 = (18,6+), 3 = (6,26) and 4 = (26,6), where the first
+ * connectivity refers to the foreground.  A (6,26) configuration is simple
+ * if and only if its complement is (26,6) simple, and likewise for (6+,18)
+ * and (18,6+), so only two tables of 2^26 bits (8 MB each) are needed.
+ *
+ * The tables are computed lazily, once per process, the first time
+ * GetTable() is called for a connectivity pair.  The computation is
+ * multi-threaded and takes a few seconds.  GetTable() takes a lock on every
+ * call, so callers get the table once, before their loops or threads, and
+ * then look configurations up with the lock-free IsSimple( table, ... ).  If a cache directory is given, either through
+ * SetCacheDirectory() or the ITK_SIMPLE_POINT_LOOKUP_TABLE_DIRECTORY
+ * environment variable, the tables are read from that directory and
+ * written to it after they are computed, so that later processes only pay
+ * for reading the file.
+ *
+ * The topological numbers themselves can be computed without the tables
+ * with ComputeTopologicalNumber().  This uses bit-parallel flood filling
+ * over the packed configuration and gives the same results as checkTn().
+ *
+ * Reference:
+ * G. Bertrand and G. Malandain.  A new characterization of
+ * three-dimensional simple points.  Pattern Recognition Letters,
+ * 15(2):169--175, 1994.
+ */
+class SimplePointLookupTable
+{
+public:
+  /** Packed 3x3x3 neighborhood without the center point. */
+  typedef unsigned int ConfigurationType;
+
+  /** Number of bits of a configuration and number of configurations. */
+  enum { NumberOfBits = 26 };
+  enum { NumberOfConfigurations = 1 << NumberOfBits };
+
+  /** Return the bit of the neighborhood index n = 0..26, n != 13. */
+  static unsigned int GetBit( unsigned int n )
+    {
+    return ( n < 13 ) ? n : n - 1;
+    }
+
+  /** Return the configuration with only neighborhood index n set. */
+  static ConfigurationType GetMask( unsigned int n )
+    {
+    return static_cast<ConfigurationType>( 1 ) << GetBit( n );
+    }
+
+  /** All the 26 neighbors. */
+  static ConfigurationType GetFullMask()
+    {
+    return ( static_cast<ConfigurationType>( 1 ) << NumberOfBits ) - 1;
+    }
+
+  /** Return the table of the given connectivity pair, building or loading
+   * it on the first call.  The table is never freed or modified afterwards.
+   * Every call takes the lock which guards the construction. */
+  static const unsigned int * GetTable( unsigned int connectivity )
+    {
+    const unsigned int which = ( connectivity <= 2 ) ? 1 : 0;
+
+    GetMutex().Lock();
+    TableType & table = GetTables()[which];
+    if( table.empty() )
+      {
+      try
+        {
+        BuildTable( which, table );
+        }
+      catch( ... )
+        {
+        table.clear();
+        GetMutex().Unlock();
+        throw;
+        }
+      }
+    const unsigned int *pointer = &table[0];
+    GetMutex().Unlock();
+    return pointer;
+    }
+
+  /** Returns true if the center of the configuration is simple for the
+   * given connectivity pair, using a table returned by GetTable() for the
+   * same connectivity.  Does not lock. */
+  static bool IsSimple( const unsigned int *table,
+    ConfigurationType configuration, unsigned int connectivity )
+    {
+    configuration &= GetFullMask();
+    if( connectivity == 3 || connectivity == 1 )
+      {
+      configuration = ~configuration & GetFullMask();
+      }
+    return ( table[configuration >> 5] >> ( configuration & 31 ) ) & 1;
+    }
+
+  /** Same as above with the table obtained through GetTable(), i.e. with a
+   * lock taken on every call.  Meant for occasional queries. */
+  static bool IsSimple( ConfigurationType configuration,
+    unsigned int connectivity )
+    {
+    return IsSimple( GetTable( connectivity ), configuration, connectivity );
+    }
+
+  /** Computes the topological number of the foreground of the configuration
+   * for the first connectivity of the pair, without the tables.  The
+   * topological number of the background is obtained by passing the
+   * complement of the configuration and the associated connectivity. */
+  static unsigned int ComputeTopologicalNumber(
+    ConfigurationType configuration, unsigned int connectivity )
+    {
+    return ComputeTopologicalNumber( configuration, connectivity, 27 );
+    }
+
+  /** Same as IsSimple() without the tables. */
+  static bool ComputeIsSimple( ConfigurationType configuration,
+    unsigned int connectivity )
+    {
+    configuration &= GetFullMask();
+    return ComputeTopologicalNumber( configuration, connectivity, 2 ) == 1
+      && ComputeTopologicalNumber( ~configuration & GetFullMask(),
+        GetAssociatedConnectivity( connectivity ), 2 ) == 1;
+    }
+
+  /** Return the connectivity pair with foreground and background swapped. */
+  static unsigned int GetAssociatedConnectivity( unsigned int connectivity )
+    {
+    switch( connectivity )
+      {
+      case 1:
+        return 2;
+      case 2:
+        return 1;
+      case 3:
+        return 4;
+      case 4:
+        return 3;
+      default:
+        return 0;
+      }
+    }
+
+  /** Directory where the tables are cached between processes.  Empty
+   * disables the cache.  The default is the value of the
+   * ITK_SIMPLE_POINT_LOOKUP_TABLE_DIRECTORY environment variable. */
+  static void SetCacheDirectory( const std::string & directory )
+    {
+    GetMutex().Lock();
+    GetCacheDirectoryReference() = directory;
+    GetMutex().Unlock();
+    }
+  static std::string GetCacheDirectory()
+    {
+    GetMutex().Lock();
+    std::string directory = GetCacheDirectoryReference();
+    GetMutex().Unlock();
+    return directory;
+    }
+
+private:
+  /** Table 0 holds the (26,6) simple configurations, table 1 the (18,6+)
+   * ones. */
+  typedef std::vector<unsigned int> TableType;
+
+  struct ThreadStruct
+    {
+    unsigned int *Table;
+    unsigned int  Connectivity;
+    };
+
+  static SimpleFastMutexLock & GetMutex()
+    {
+    static SimpleFastMutexLock mutex;
+    return mutex;
+    }
+
+  static std::string & GetCacheDirectoryReference()
+    {
+    static bool initialized = false;
+    static std::string directory;
+    if( !initialized )
+      {
+      const char *env = itksys::SystemTools::GetEnv(
+        "ITK_SIMPLE_POINT_LOOKUP_TABLE_DIRECTORY" );
+      if( env )
+        {
+        directory = env;
+        }
+      initialized = true;
+      }
+    return directory;
+    }
+
+  /** The two tables, empty until they are built.  Only accessed with the
+   * mutex held. */
+  static TableType * GetTables()
+    {
+    static TableType tables[2];
+    return tables;
+    }
+
+  /** Reads or computes a table.  Called with the mutex held. */
+  static void BuildTable( unsigned int which, TableType & table )
+    {
+    table.resize( NumberOfConfigurations / 32 );
+
+    std::string fileName = GetCacheDirectoryReference();
+    if( !fileName.empty() )
+      {
+      fileName += ( which == 0 ) ? "/itkSimplePointLookupTable_26_6.bin"
+        : "/itkSimplePointLookupTable_18_6p.bin";
+      }
+    if( fileName.empty() || !ReadTable( fileName, table ) )
+      {
+      ThreadStruct str;
+      str.Table = &table[0];
+      str.Connectivity = ( which == 0 ) ? 4 : 2;
+
+      MultiThreader::Pointer threader = MultiThreader::New();
+      threader->SetSingleMethod( BuildTableThreaderCallback, &str );
+      threader->SingleMethodExecute();
+
+      if( !fileName.empty() )
+        {
+        WriteTable( fileName, table );
+        }
+      }
+    }
+
+  static ITK_THREAD_RETURN_TYPE BuildTableThreaderCallback( void *arg )
+    {
+    MultiThreader::ThreadInfoStruct *info =
+      static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+    ThreadStruct *str = static_cast<ThreadStruct *>( info->UserData );
+
+    const unsigned int numberOfWords = NumberOfConfigurations / 32;
+    const unsigned int begin = static_cast<unsigned int>(
+      static_cast<double>( numberOfWords ) * info->ThreadID
+      / info->NumberOfThreads );
+    const unsigned int end = static_cast<unsigned int>(
+      static_cast<double>( numberOfWords ) * ( info->ThreadID + 1 )
+      / info->NumberOfThreads );
+
+    for( unsigned int w = begin; w < end; w++ )
+      {
+      unsigned int word = 0;
+      for( unsigned int b = 0; b < 32; b++ )
+        {
+        if( ComputeIsSimple( ( w << 5 ) | b, str->Connectivity ) )
+          {
+          word |= 1u << b;
+          }
+        }
+      str->Table[w] = word;
+      }
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  /** The cache file holds a byte order mark followed by the table. */
+  static bool ReadTable( const std::string & fileName, TableType & table )
+    {
+    std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+    if( !file )
+      {
+      return false;
+      }
+    unsigned int mark = 0;
+    file.read( reinterpret_cast<char *>( &mark ), sizeof( mark ) );
+    file.read( reinterpret_cast<char *>( &table[0] ),
+      table.size() * sizeof( unsigned int ) );
+    return file && mark == 0x01020304;
+    }
+
+  static void WriteTable( const std::string & fileName,
+    const TableType & table )
+    {
+    // Write to a temporary file first so that concurrent processes never
+    // see a partial table.
+    std::string temporaryFileName = fileName + ".tmp";
+    std::ofstream file( temporaryFileName.c_str(),
+      std::ios::out | std::ios::binary );
+    if( !file )
+      {
+      return;
+      }
+    const unsigned int mark = 0x01020304;
+    file.write( reinterpret_cast<const char *>( &mark ), sizeof( mark ) );
+    file.write( reinterpret_cast<const char *>( &table[0] ),
+      table.size() * sizeof( unsigned int ) );
+    file.close();
+    if( !file || std::rename( temporaryFileName.c_str(), fileName.c_str() ) )
+      {
+      std::remove( temporaryFileName.c_str() );
+      }
+    }
+
+  /** Index of the lowest set bit of a non-zero word. */
+  static unsigned int GetLowestBit( unsigned int x )
+    {
+    static const unsigned int deBruijn[32] = {
+      0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+      31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9 };
+    return deBruijn[( ( x & ( 0u - x ) ) * 0x077CB531u ) >> 27];
+    }
+
+  /** Returns the points of 'candidates' adjacent to a point of 'set'. */
+  static unsigned int GetAdjacentPoints( unsigned int candidates,
+    unsigned int set, const unsigned int *adjacency )
+    {
+    unsigned int points = 0;
+    while( candidates )
+      {
+      const unsigned int bit = GetLowestBit( candidates );
+      if( adjacency[bit] & set )
+        {
+        points |= 1u << bit;
+        }
+      candidates &= candidates - 1;
+      }
+    return points;
+    }
+
+  /** Counts the components of 'set' that contain a point of 'seeds',
+   * stopping at 'maximum'. */
+  static unsigned int CountComponents( unsigned int set, unsigned int seeds,
+    const unsigned int *adjacency, unsigned int maximum )
+    {
+    unsigned int count = 0;
+    while( ( set & seeds ) && count < maximum )
+      {
+      unsigned int component = ( set & seeds ) & ( 0u - ( set & seeds ) );
+      unsigned int front = component;
+      while( front )
+        {
+        const unsigned int grown = adjacency[GetLowestBit( front )]
+          & set & ~component;
+        front &= front - 1;
+        component |= grown;
+        front |= grown;
+        }
+      set &= ~component;
+      ++count;
+      }
+    return count;
+    }
+
+  static unsigned int ComputeTopologicalNumber(
+    ConfigurationType configuration, unsigned int connectivity,
+    unsigned int maximum )
+    {
+    // Neighbors of each bit for the 6, 18 and 26 adjacencies.
+    static const unsigned int adjacency6[26] = {
+      0x000020a, 0x0000415, 0x0000822, 0x0001051, 0x00000aa, 0x0002114,
+      0x0004088, 0x0008150, 0x00100a0, 0x0021401, 0x0040a02, 0x0082404,
+      0x0104208, 0x0410820, 0x0809040, 0x1014080, 0x200a100, 0x0140200,
+      0x02a0400, 0x0440800, 0x0a21000, 0x1540000, 0x2282000, 0x1104000,
+      0x2a08000, 0x1410000 };
+    static const unsigned int adjacency18[26] = {
+      0x000161a, 0x0000e3d, 0x0002c32, 0x00052d3, 0x000b5ef, 0x0012996,
+      0x000d098, 0x001c178, 0x001a0b0, 0x016140b, 0x02e3a17, 0x04c2426,
+      0x0b2c659, 0x2698d34, 0x19090c8, 0x3a171d0, 0x340a1a0, 0x0341600,
+      0x07a0e00, 0x0642c00, 0x1a65200, 0x3deb400, 0x32d2800, 0x130d000,
+      0x2f1c000, 0x161a000 };
+    static const unsigned int adjacency26[26] = {
+      0x000161a, 0x0003e3d, 0x0002c32, 0x000d6d3, 0x001ffef, 0x001ad96,
+      0x000d098, 0x001f178, 0x001a0b0, 0x036141b, 0x07e3a3f, 0x06c2436,
+      0x1b6c6db, 0x36d8db6, 0x1b090d8, 0x3f171f8, 0x360a1b0, 0x0341600,
+      0x07a3e00, 0x0642c00, 0x1a6d600, 0x3dffe00, 0x32dac00, 0x130d000,
+      0x2f1f000, 0x161a000 };
+    // The 6 face neighbors and the 18 face and edge neighbors.
+    const unsigned int faces = 0x020b410;
+    const unsigned int neighbors18 = 0x175feba;
+
+    configuration &= GetFullMask();
+    switch( connectivity )
+      {
+      case 1:
+        {
+        // 6-components of the geodesic neighborhood of order 3: the face
+        // neighbors, the edge neighbors 6-adjacent to those and the corner
+        // neighbors 6-adjacent to those edges.
+        unsigned int geodesic = configuration & faces;
+        geodesic |= GetAdjacentPoints( configuration & neighbors18 & ~faces,
+          geodesic, adjacency6 );
+        geodesic |= GetAdjacentPoints( configuration & ~neighbors18,
+          geodesic, adjacency6 );
+        return CountComponents( geodesic, faces, adjacency6, maximum );
+        }
+      case 2:
+        // 18-components 18-adjacent to the center.
+        return CountComponents( configuration, neighbors18, adjacency18,
+          maximum );
+      case 3:
+        // 6-components of the 18-neighborhood 6-adjacent to the center.
+        return CountComponents( configuration & neighbors18, faces,
+          adjacency6, maximum );
+      case 4:
+        return CountComponents( configuration, GetFullMask(), adjacency26,
+          maximum );
+      default:
+        return 0;
+      }
+    }
+};
+
+} // end namespace itk
+
+#endif
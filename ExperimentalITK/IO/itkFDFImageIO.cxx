@@ -20,12 +20,120 @@
 #include "itkByteSwapper.h"
 #include "itkRGBPixel.h"
 #include "itkRGBAPixel.h"
+#include "vnl/vnl_math.h"
 #include <stdio.h>
+#include <string.h>
 #include <fstream>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace itk
 {
 
+/**
+ * Read only view of a whole file, memory mapped where possible and read
+ * otherwise.  Errors are not thrown, so that it can be used by the
+ * threads, but reported by IsValid().
+ */
+class FDFMappedFile
+{
+public:
+  FDFMappedFile( const char *fileName )
+    {
+    this->m_Data = NULL;
+    this->m_Size = 0;
+#if defined(_WIN32)
+    std::ifstream inFile( fileName, std::ios::in | std::ios::binary );
+    if( inFile )
+      {
+      inFile.seekg( 0, std::ios::end );
+      this->m_Buffer.resize( static_cast<size_t>( inFile.tellg() ) );
+      inFile.seekg( 0, std::ios::beg );
+      if( !this->m_Buffer.empty() &&
+        inFile.read( &this->m_Buffer[0], this->m_Buffer.size() ) )
+        {
+        this->m_Data = &this->m_Buffer[0];
+        this->m_Size = this->m_Buffer.size();
+        }
+      }
+#else
+    int fileDescriptor = open( fileName, O_RDONLY );
+    if( fileDescriptor >= 0 )
+      {
+      struct stat fileStatus;
+      if( fstat( fileDescriptor, &fileStatus ) == 0 && fileStatus.st_size > 0 )
+        {
+        void *data = mmap( NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE,
+          fileDescriptor, 0 );
+        if( data != MAP_FAILED )
+          {
+          this->m_Data = static_cast<const char *>( data );
+          this->m_Size = fileStatus.st_size;
+          }
+        }
+      close( fileDescriptor );
+      }
+#endif
+    }
+
+  ~FDFMappedFile()
+    {
+#if !defined(_WIN32)
+    if( this->m_Data )
+      {
+      munmap( const_cast<char *>( this->m_Data ), this->m_Size );
+      }
+#endif
+    }
+
+  bool IsValid() const { return ( this->m_Data != NULL ); }
+  const char * GetData() const { return this->m_Data; }
+  size_t GetSize() const { return this->m_Size; }
+
+private:
+  FDFMappedFile( const FDFMappedFile & ); //purposely not implemented
+  void operator=( const FDFMappedFile & ); //purposely not implemented
+
+  const char         *m_Data;
+  size_t              m_Size;
+#if defined(_WIN32)
+  std::vector<char>   m_Buffer;
+#endif
+};
+
+/**
+ * Location of a slice, read from the header of its file
+ */
+static std::vector<float> ReadFDFLocation( const std::string & fileName )
+{
+  std::vector<float> location;
+
+  std::ifstream inFile( fileName.c_str(), std::ios::in | std::ios::binary );
+  std::string line;
+  std::vector<std::string> tokens;
+  while( getline( inFile, line, '\n' ) )
+    {
+    if ( line == "\0" )
+      {
+      break;
+      }
+    line = ParseLine( line );
+    Tokenize( line, tokens, " ;" );
+    if( tokens.size() == 4 && tokens[1] == "location" )
+      {
+      StringToVector( tokens[3], location );
+      break;
+      }
+    tokens.clear();
+    }
+  return location;
+}
+
 bool FDFImageIO::CanReadFile(const char* file)
 {
   this->SetFileName(file);
@@ -77,6 +185,14 @@ bool FDFImageIO::CanReadFile(const char* file)
 
 void FDFImageIO::ReadImageInformation()
 {
+  // The header of the first file of a series describes the slices
+  if( !this->m_SeriesFileNames.empty() )
+    {
+    this->m_FileName = this->m_SeriesFileNames[0];
+    this->SetNumberOfDimensions( 3 );
+    this->SetDimensions( 2, 1 );
+    }
+
   if(!this->CanReadFile(m_FileName.c_str()))
     RAISE_EXCEPTION();
 
@@ -275,16 +391,159 @@ void FDFImageIO::ReadImageInformation()
   long int fileSize = inFile.tellg();
   this->m_InputPosition = fileSize - this->GetImageSizeInBytes();
 
-  for( unsigned int i = 0; i < this->GetNumberOfDimensions(); i++ )
+  for( unsigned int i = 0; i < this->GetNumberOfDimensions() &&
+    i < this->m_Roi.size(); i++ )
     {
     this->SetSpacing( i, ( this->m_Roi[i] * 10 ) / this->GetDimensions( i ) );
     }
+
+  if( this->m_SeriesFileNames.size() > 1 )
+    {
+    this->SetDimensions( 2, this->m_SeriesFileNames.size() );
+
+    // The slice spacing is the distance between the first two slices
+    std::vector<float> firstLocation =
+      ReadFDFLocation( this->m_SeriesFileNames[0] );
+    std::vector<float> secondLocation =
+      ReadFDFLocation( this->m_SeriesFileNames[1] );
+    if( firstLocation.size() == secondLocation.size() )
+      {
+      double distance = 0.0;
+      for( unsigned int i = 0; i < firstLocation.size(); i++ )
+        {
+        distance += vnl_math_sqr( secondLocation[i] - firstLocation[i] );
+        }
+      if( distance > 0.0 )
+        {
+        this->SetSpacing( 2, vcl_sqrt( distance ) * 10 );
+        }
+      }
+
+    ImageIORegion::SizeType   size( 3 );
+    ImageIORegion::IndexType  index( 3 );
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      size[i] = this->GetDimensions( i );
+      index[i] = 0;
+      }
+    region.SetSize( size );
+    region.SetIndex( index );
+    this->SetIORegion( region );
+    }
+}
+
+
+void FDFImageIO::ReadVolume(void* buffer)
+{
+  SeriesThreadStruct str;
+  str.IO = this;
+  str.Buffer = static_cast<char *>( buffer );
+  this->GetRegionBounds( str.Dimensions, str.Index, str.Size );
+
+  if( str.Index[2] + str.Size[2] > this->m_SeriesFileNames.size() )
+    {
+    itkExceptionMacro( "The region has " << str.Index[2] + str.Size[2]
+      << " slices but the series only " << this->m_SeriesFileNames.size() );
+    }
+  str.Succeeded.assign( str.Size[2], 0 );
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( vnl_math_min(
+    static_cast<unsigned long>( threader->GetNumberOfThreads() ), str.Size[2] ) );
+  threader->SetSingleMethod( this->ReadSeriesThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  for( unsigned long k = 0; k < str.Size[2]; k++ )
+    {
+    if( !str.Succeeded[k] )
+      {
+      itkExceptionMacro( "Error reading image data from "
+        << this->m_SeriesFileNames[str.Index[2] + k] );
+      }
+    }
+}
+
+ITK_THREAD_RETURN_TYPE
+FDFImageIO::ReadSeriesThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  SeriesThreadStruct *str = static_cast<SeriesThreadStruct *>( info->UserData );
+
+  const unsigned long pixelSize =
+    str->IO->GetComponentSize() * str->IO->GetNumberOfComponents();
+  const unsigned long sliceSize =
+    str->Dimensions[0] * str->Dimensions[1] * pixelSize;
+  const unsigned long regionSliceSize =
+    str->Size[0] * str->Size[1] * pixelSize;
+
+  // Each file holds a single slice, at its end
+  unsigned long index[3] = { str->Index[0], str->Index[1], 0 };
+  unsigned long size[3] = { str->Size[0], str->Size[1], 1 };
+  unsigned long dimensions[3] = { str->Dimensions[0], str->Dimensions[1], 1 };
+
+  const unsigned long first = str->Size[2] * info->ThreadID / info->NumberOfThreads;
+  const unsigned long last = str->Size[2] * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+  for( unsigned long k = first; k < last; k++ )
+    {
+    FDFMappedFile file(
+      str->IO->m_SeriesFileNames[str->Index[2] + k].c_str() );
+    if( !file.IsValid() || file.GetSize() < sliceSize )
+      {
+      continue;
+      }
+    try
+      {
+      str->IO->CopyRegion( file.GetData() + file.GetSize() - sliceSize,
+        dimensions, index, size, str->Buffer + k * regionSliceSize );
+      str->Succeeded[k] = 1;
+      }
+    catch( ... )
+      {
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
 }
 
+void FDFImageIO::GetRegionBounds( unsigned long dimensions[3],
+  unsigned long index[3], unsigned long size[3] ) const
+{
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    if( i < this->GetNumberOfDimensions() )
+      {
+      dimensions[i] = this->GetDimensions( i );
+      index[i] = this->m_IORegion.GetIndex( i );
+      size[i] = this->m_IORegion.GetSize( i );
+      }
+    else
+      {
+      dimensions[i] = 1;
+      index[i] = 0;
+      size[i] = 1;
+      }
+    }
+}
 
-void FDFImageIO::ReadVolume(void*)
+void FDFImageIO::CopyRegion( const char *data, const unsigned long dimensions[3],
+  const unsigned long index[3], const unsigned long size[3], char *buffer )
 {
+  const unsigned long pixelSize =
+    this->GetComponentSize() * this->GetNumberOfComponents();
+  const unsigned long rowSize = size[0] * pixelSize;
 
+  for( unsigned long z = index[2]; z < index[2] + size[2]; z++ )
+    {
+    for( unsigned long y = index[1]; y < index[1] + size[1]; y++ )
+      {
+      const unsigned long offset =
+        ( ( z * dimensions[1] + y ) * dimensions[0] + index[0] ) * pixelSize;
+      memcpy( buffer, data + offset, rowSize );
+      this->SwapBytesIfNecessary( buffer, size[0] );
+      buffer += rowSize;
+      }
+    }
 }
 
 // const std::type_info& FDFImageIO::GetPixelType() const
@@ -368,33 +627,28 @@ void FDFImageIO::ReadVolume(void*)
 
 void FDFImageIO::Read(void* buffer)
 {
-  std::ifstream inFile(m_FileName.c_str(), std::ios::in | std::ios::binary);
-
-  // Check if there was an error opening the file
-  if (!inFile)
-  {
-    RAISE_EXCEPTION();
-  }
+  if( this->m_SeriesFileNames.size() > 1 )
+    {
+    this->ReadVolume( buffer );
+    return;
+    }
 
-  inFile.seekg( this->m_InputPosition );
+  FDFMappedFile file( m_FileName.c_str() );
 
-  if (!inFile)
+  // Check if there was an error opening the file
+  if( !file.IsValid() )
     {
     RAISE_EXCEPTION();
     }
-
-  char * p = static_cast<char *>(buffer);
-
-  inFile.read( p, this->GetImageSizeInBytes() );
-
-  bool success = !inFile.bad();
-  inFile.close();
-  if( !success )
+  if( file.GetSize() < this->m_InputPosition + this->GetImageSizeInBytes() )
     {
     itkExceptionMacro("Error reading image data.");
     }
 
-  this->SwapBytesIfNecessary( buffer, this->GetImageSizeInPixels() );
+  unsigned long dimensions[3], index[3], size[3];
+  this->GetRegionBounds( dimensions, index, size );
+  this->CopyRegion( file.GetData() + this->m_InputPosition,
+    dimensions, index, size, static_cast<char *>( buffer ) );
 }
 
 
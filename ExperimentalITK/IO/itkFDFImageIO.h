@@ -19,11 +19,20 @@
 #define __itkFDFImageIO_h
 
 #include "itkImageIOBase.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
 
 /* \brief ImageIO object for reading and writing FDF images
+ *
+ * The payload is memory mapped, where possible, and only the requested
+ * region is copied, the bytes being swapped row by row during the copy.
+ *
+ * A series of 2-D FDF files, one slice per file, is read as a volume when
+ * the file names are given with SetSeriesFileNames().  The files are then
+ * read by all the threads, each slice being copied directly at its place
+ * in the volume.
  *
  * \ingroup IOFilters
  *
@@ -73,6 +82,19 @@ public:
   /** Reads 3D data from multiple files assuming one slice per file. */
   virtual void ReadVolume(void* buffer);
 
+  /** Any region of the image can be read. */
+  virtual bool CanStreamRead() { return true; }
+
+  /** Set/Get the files of a series of slices, in slice order.  The header
+   * of the first file describes the slices. */
+  void SetSeriesFileNames( const std::vector<std::string> & fileNames )
+    {
+    this->m_SeriesFileNames = fileNames;
+    this->Modified();
+    }
+  const std::vector<std::string> & GetSeriesFileNames() const
+    { return this->m_SeriesFileNames; }
+
   /** Compute the size (in bytes) of the components of a pixel. For
    * example, and RGB pixel of unsigned char would have a
    * component size of 1 byte. */
@@ -101,6 +123,30 @@ protected:
 
   int ReadHeader(const char *FileNameToRead);
 
+  /** Internal structure used for passing the series to the threads. */
+  struct SeriesThreadStruct
+  {
+    FDFImageIO                     *IO;
+    char                           *Buffer;
+    unsigned long                   Dimensions[3];
+    unsigned long                   Index[3];
+    unsigned long                   Size[3];
+    std::vector<char>               Succeeded;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ReadSeriesThreaderCallback( void *arg );
+
+  /** Dimensions of the image and index and size of the IORegion, padded
+   * to three dimensions. */
+  void GetRegionBounds( unsigned long dimensions[3], unsigned long index[3],
+    unsigned long size[3] ) const;
+
+  /** Copy the region of the pixels, stored contiguously from data, to the
+   * buffer and swap their bytes. */
+  void CopyRegion( const char *data, const unsigned long dimensions[3],
+    const unsigned long index[3], const unsigned long size[3], char *buffer );
+
 private:
   FDFImageIO(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -117,6 +163,8 @@ private:
   std::vector<float>   m_Location;
   std::vector<float>   m_Span;
   std::vector<float>   m_Roi;
+
+  std::vector<std::string> m_SeriesFileNames;
 };
 
 } // end namespace itk
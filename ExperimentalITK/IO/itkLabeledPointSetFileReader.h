@@ -22,6 +22,7 @@
 
 #include "itkArray.h"
 #include "itkImage.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkVectorContainer.h"
 
 #include <vector>
@@ -33,6 +34,15 @@ namespace itk
  * \brief
  * Reads a file and creates an itkMesh.
  *
+ * The format is given by the extension: Avants landmark files (.txt), VTK
+ * polydata (.vtk), binary labeled point sets (.lps, see
+ * LabeledPointSetFileWriter) or any image readable by ImageFileReader, in
+ * which case the non-zero voxels are the points.  The numbers of the ASCII
+ * formats are parsed by all the threads, each one taking a chunk of the
+ * text, and binary labeled point sets are memory mapped where possible.
+ * Points are randomly discarded while they are read when RandomPercentage
+ * is less than one.
+ *
  */
 template <class TOutputMesh>
 class LabeledPointSetFileReader 
@@ -104,6 +114,37 @@ protected:
   /** Reads the file */
   void GenerateData();
 
+  /** Internal structure used for passing the text to the threads. */
+  struct ParserThreadStruct
+  {
+    const char                                   *Begin;
+    const char                                   *End;
+    std::vector<std::vector<double> >             Values;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ParserThreaderCallback( void *arg );
+
+  /** Start of the chunk of [begin, end) parsed by a thread, moved forward
+   * to a whitespace so that no number is split. */
+  static const char * FindChunkBoundary( const char *begin, const char *end,
+    unsigned int chunk, unsigned int numberOfChunks );
+
+  /** Parse the numbers of [begin, end) with the threads.  values[i] holds,
+   * in order, the numbers of the i-th chunk. */
+  void ParseNumbers( const char *begin, const char *end,
+    std::vector<std::vector<double> > & values );
+
+  /** Start of the first line of [begin, end) which begins with a keyword,
+   * i.e. the end of a block of numbers of a vtk file. */
+  static const char * FindEndOfNumbers( const char *begin, const char *end );
+
+  /** Append what is left of the stream to the buffer. */
+  static void ReadRemainingFile( std::istream & stream, std::string & buffer );
+
+  /** Decide whether the next point is kept, see RandomPercentage. */
+  bool SelectPoint();
+
   bool                                            m_ExtractBoundaryPoints;
 
   std::string                                     m_FileName;  
@@ -119,12 +160,20 @@ private:
   
   void ReadPointsFromImageFile();
   void ReadPointsFromAvantsFile();
+  void ReadPointsFromBinaryFile();
+  void ReadPointsFromBinaryBuffer( const char *buffer, std::size_t size );
 
   void ReadVTKFile();
   void ReadPointsFromVTKFile();
   void ReadScalarsFromVTKFile();
   void ReadLinesFromVTKFile();
 
+  typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer                          m_RandomGenerator;
+
+  /** Which of the points of the vtk file are kept */
+  std::vector<bool>                               m_PointIsSelected;
+
 };
 
 } // end namespace itk
@@ -26,11 +26,22 @@
 #include "itkLabelContourImageFilter.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkByteSwapper.h"
+#include "itkIntTypes.h"
 
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <stdio.h>
 #include <string>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace itk
 {
 
@@ -88,6 +99,17 @@ LabeledPointSetFileReader<TOutputMesh>
   std::string::size_type pos = this->m_FileName.rfind( "." );
   std::string extension( this->m_FileName, pos+1, this->m_FileName.length()-1 );
 
+  /**
+   * The random subsampling is done while the points are read so that the
+   * discarded points are never stored.
+   */
+  this->m_RandomGenerator = NULL;
+  if( this->m_RandomPercentage < 1.0 )
+    {
+    this->m_RandomGenerator = GeneratorType::New();
+    this->m_RandomGenerator->SetSeed();
+    }
+
   if( extension == "txt" )
     {
     this->ReadPointsFromAvantsFile();
@@ -96,45 +118,18 @@ LabeledPointSetFileReader<TOutputMesh>
     {
     this->ReadVTKFile();
     }
+  else if( extension == "lps" )
+    {
+    this->ReadPointsFromBinaryFile();
+    }
   else // try reading the file as an image
     {
     this->ReadPointsFromImageFile();
     }
 
-  if( this->m_RandomPercentage < 1.0 )
-    {
-    typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
-    typename GeneratorType::Pointer generator = GeneratorType::New();
-    generator->SetSeed();
-
-    typename OutputMeshType::Pointer output = OutputMeshType::New();
-    output->Initialize();
-
-    if( this->GetOutput()->GetNumberOfPoints() > 0 )
-      {
-      typename OutputMeshType::PointsContainerIterator It =
-        this->GetOutput()->GetPoints()->Begin();
+  this->m_RandomGenerator = NULL;
+  this->m_PointIsSelected.clear();
 
-      unsigned long count = 0;
-      while( It != this->GetOutput()->GetPoints()->End() )
-        {
-        if( generator->GetVariateWithClosedRange() <= this->m_RandomPercentage )
-          {
-          output->SetPoint( count, It.Value() );
-          PixelType label;
-          bool elementExists = this->GetOutput()->GetPointData()
-            ->GetElementIfIndexExists( It.Index(), &label );
-          if( elementExists )
-            {
-            output->SetPointData( count, label );
-            }
-          count++;
-          }
-        ++It;
-        }
-      }
-    this->GraftOutput( output );
-    }
   this->m_LabelSet.clear();
 
   /**
@@ -174,6 +169,150 @@ LabeledPointSetFileReader<TOutputMesh>
     }
 }
 
+template<class TOutputMesh>
+bool
+LabeledPointSetFileReader<TOutputMesh>
+::SelectPoint()
+{
+  if( this->m_RandomGenerator.IsNull() )
+    {
+    return true;
+    }
+  return ( this->m_RandomGenerator->GetVariateWithClosedRange()
+    <= this->m_RandomPercentage );
+}
+
+template<class TOutputMesh>
+void
+LabeledPointSetFileReader<TOutputMesh>
+::ReadRemainingFile( std::istream & stream, std::string & buffer )
+{
+  std::vector<char> block( 1 << 20 );
+  do
+    {
+    stream.read( &block[0], block.size() );
+    buffer.append( &block[0], stream.gcount() );
+    }
+  while( stream );
+}
+
+template<class TOutputMesh>
+const char *
+LabeledPointSetFileReader<TOutputMesh>
+::FindChunkBoundary( const char *begin, const char *end,
+  unsigned int chunk, unsigned int numberOfChunks )
+{
+  if( chunk == 0 )
+    {
+    return begin;
+    }
+  if( chunk >= numberOfChunks )
+    {
+    return end;
+    }
+  const char *boundary = begin + static_cast<std::size_t>(
+    static_cast<double>( end - begin ) * chunk / numberOfChunks );
+  while( boundary < end && !isspace( static_cast<unsigned char>( *boundary ) ) )
+    {
+    ++boundary;
+    }
+  return boundary;
+}
+
+template<class TOutputMesh>
+const char *
+LabeledPointSetFileReader<TOutputMesh>
+::FindEndOfNumbers( const char *begin, const char *end )
+{
+  const char *lineBegin = begin;
+  while( lineBegin < end )
+    {
+    const char *it = lineBegin;
+    while( it < end && ( *it == ' ' || *it == '\t' ) )
+      {
+      ++it;
+      }
+    if( it < end && isalpha( static_cast<unsigned char>( *it ) ) )
+      {
+      return lineBegin;
+      }
+    const char *lineEnd = static_cast<const char *>(
+      memchr( it, '\n', end - it ) );
+    if( lineEnd == NULL )
+      {
+      break;
+      }
+    lineBegin = lineEnd + 1;
+    }
+  return end;
+}
+
+template<class TOutputMesh>
+void
+LabeledPointSetFileReader<TOutputMesh>
+::ParseNumbers( const char *begin, const char *end,
+  std::vector<std::vector<double> > & values )
+{
+  ParserThreadStruct str;
+  str.Begin = begin;
+  str.End = end;
+  str.Values.resize( this->GetNumberOfThreads() );
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->ParserThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  values.swap( str.Values );
+}
+
+template<class TOutputMesh>
+ITK_THREAD_RETURN_TYPE
+LabeledPointSetFileReader<TOutputMesh>
+::ParserThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  ParserThreadStruct *str = static_cast<ParserThreadStruct *>( info->UserData );
+
+  const char *it = FindChunkBoundary( str->Begin, str->End,
+    info->ThreadID, info->NumberOfThreads );
+  const char *chunkEnd = FindChunkBoundary( str->Begin, str->End,
+    info->ThreadID + 1, info->NumberOfThreads );
+
+  /**
+   * A chunk ends on a whitespace or at the end of the text, which is
+   * followed by a keyword line or the terminating null character, so
+   * strtod never reads past it.
+   */
+  std::vector<double> & values = str->Values[info->ThreadID];
+  values.clear();
+  values.reserve( ( chunkEnd - it ) / 4 );
+  while( it < chunkEnd )
+    {
+    if( isspace( static_cast<unsigned char>( *it ) ) )
+      {
+      ++it;
+      continue;
+      }
+    char *next = NULL;
+    const double value = strtod( it, &next );
+    if( next == it )
+      {
+      // skip anything which is not a number
+      while( it < chunkEnd && !isspace( static_cast<unsigned char>( *it ) ) )
+        {
+        ++it;
+        }
+      continue;
+      }
+    values.push_back( value );
+    it = next;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template<class TOutputMesh>
 void
 LabeledPointSetFileReader<TOutputMesh>
@@ -182,31 +321,187 @@ LabeledPointSetFileReader<TOutputMesh>
   typename OutputMeshType::Pointer outputMesh = this->GetOutput();
 
   std::ifstream inputFile( m_FileName.c_str() );
+  std::string buffer;
+  this->ReadRemainingFile( inputFile, buffer );
+  inputFile.close();
+
+  std::vector<std::vector<double> > values;
+  this->ParseNumbers( buffer.c_str(), buffer.c_str() + buffer.size(), values );
+  std::string().swap( buffer );
+
+  /**
+   * Each line holds the point followed by its label.  2-D points are
+   * written with a third, unused, coordinate.
+   */
+  const unsigned int numberOfCoordinates = ( Dimension == 2 ) ? 3 : Dimension;
+  const unsigned int recordSize = numberOfCoordinates + 1;
 
+  std::vector<double> record( recordSize );
+  unsigned int component = 0;
   unsigned long count = 0;
-  while( !inputFile.eof() )
+  for( unsigned int n = 0; n < values.size(); n++ )
     {
-    PointType point;
-    PixelType label;
+    for( unsigned long i = 0; i < values[n].size(); i++ )
+      {
+      record[component++] = values[n][i];
+      if( component < recordSize )
+        {
+        continue;
+        }
+      component = 0;
+
+      PointType point;
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        point[d] = record[d];
+        }
+      PixelType label = static_cast<PixelType>( record[numberOfCoordinates] );
+
+      if( ( ( point.GetVectorFromOrigin() ).GetSquaredNorm() > 0.0
+           || label != 0 ) && this->SelectPoint() )
+        {
+        outputMesh->SetPointData( count, label );
+        outputMesh->SetPoint( count, point );
+        count++;
+        }
+      }
+    std::vector<double>().swap( values[n] );
+    }
+}
 
-    if( Dimension == 2 )
+template<class TOutputMesh>
+void
+LabeledPointSetFileReader<TOutputMesh>
+::ReadPointsFromBinaryFile()
+{
+#if defined(_WIN32)
+  std::ifstream inputFile( this->m_FileName.c_str(), std::ios::binary );
+  std::string buffer;
+  this->ReadRemainingFile( inputFile, buffer );
+  inputFile.close();
+
+  this->ReadPointsFromBinaryBuffer( buffer.data(), buffer.size() );
+#else
+  int fileDescriptor = open( this->m_FileName.c_str(), O_RDONLY );
+  if( fileDescriptor < 0 )
+    {
+    itkExceptionMacro( "Unable to open file\n"
+        "inputFilename= " << this->m_FileName );
+    }
+  struct stat fileStatus;
+  if( fstat( fileDescriptor, &fileStatus ) != 0 || fileStatus.st_size <= 0 )
+    {
+    close( fileDescriptor );
+    itkExceptionMacro( "Unable to read file\n"
+        "inputFilename= " << this->m_FileName );
+    }
+  const std::size_t size = static_cast<std::size_t>( fileStatus.st_size );
+
+  void *buffer = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0 );
+  close( fileDescriptor );
+  if( buffer == MAP_FAILED )
+    {
+    itkExceptionMacro( "Unable to map file\n"
+        "inputFilename= " << this->m_FileName );
+    }
+  madvise( buffer, size, MADV_SEQUENTIAL );
+
+  try
+    {
+    this->ReadPointsFromBinaryBuffer( static_cast<const char *>( buffer ), size );
+    }
+  catch( ... )
+    {
+    munmap( buffer, size );
+    throw;
+    }
+  munmap( buffer, size );
+#endif
+}
+
+template<class TOutputMesh>
+void
+LabeledPointSetFileReader<TOutputMesh>
+::ReadPointsFromBinaryBuffer( const char *buffer, std::size_t size )
+{
+  typename OutputMeshType::Pointer outputMesh = this->GetOutput();
+
+  /**
+   * See LabeledPointSetFileWriter for the layout of the file.
+   */
+  const std::size_t headerSize = 24;
+  if( size < headerSize || strncmp( buffer, "LABELPS1", 8 ) != 0 )
+    {
+    itkExceptionMacro( "Not a labeled point set file\n"
+        "inputFilename= " << this->m_FileName );
+    }
+
+  uint32_t header[4];
+  memcpy( header, buffer + 8, sizeof( header ) );
+  ByteSwapper<uint32_t>::SwapRangeFromSystemToLittleEndian( header, 4 );
+
+  const unsigned int dimension = header[0];
+  const unsigned long numberOfPoints = header[1];
+  const unsigned int labelType = header[2];
+
+  if( dimension != Dimension )
+    {
+    itkExceptionMacro( "The points are of dimension " << dimension
+      << " instead of " << Dimension );
+    }
+  if( labelType > 1 )
+    {
+    itkExceptionMacro( "Unknown label type " << labelType );
+    }
+  if( size < headerSize + numberOfPoints * ( Dimension + 1 ) * 4 )
+    {
+    itkExceptionMacro( "The file is truncated\n"
+        "inputFilename= " << this->m_FileName );
+    }
+
+  const char *points = buffer + headerSize;
+  const char *labels = points + numberOfPoints * Dimension * sizeof( float );
+
+  unsigned long count = 0;
+  for( unsigned long i = 0; i < numberOfPoints; i++ )
+    {
+    if( !this->SelectPoint() )
       {
-      float trash;
-      inputFile >> point >> trash >> label;
+      continue;
       }
-    else // Dimension == 3
+
+    float coordinates[Dimension];
+    memcpy( coordinates, points + i * sizeof( coordinates ),
+      sizeof( coordinates ) );
+    ByteSwapper<float>::SwapRangeFromSystemToLittleEndian(
+      coordinates, Dimension );
+
+    PointType point;
+    for( unsigned int d = 0; d < Dimension; d++ )
       {
-      inputFile >> point >> label;
+      point[d] = coordinates[d];
       }
-    if( ( point.GetVectorFromOrigin() ).GetSquaredNorm() > 0.0
-         || label != 0 )
+
+    PixelType label;
+    if( labelType == 0 )
       {
-      outputMesh->SetPointData( count, label );
-      outputMesh->SetPoint( count, point );
-      count++;
+      int32_t value;
+      memcpy( &value, labels + i * sizeof( value ), sizeof( value ) );
+      ByteSwapper<int32_t>::SwapFromSystemToLittleEndian( &value );
+      label = static_cast<PixelType>( value );
       }
+    else
+      {
+      float value;
+      memcpy( &value, labels + i * sizeof( value ), sizeof( value ) );
+      ByteSwapper<float>::SwapFromSystemToLittleEndian( &value );
+      label = static_cast<PixelType>( value );
+      }
+
+    outputMesh->SetPoint( count, point );
+    outputMesh->SetPointData( count, label );
+    count++;
     }
-  inputFile.close();
 }
 
 template<class TOutputMesh>
@@ -270,12 +565,28 @@ LabeledPointSetFileReader<TOutputMesh>
     return;
     }
 
-  outputMesh->GetPoints()->Reserve( numberOfPoints );
+  /**
+   * The points are selected before they are read so that the scalars of
+   * the discarded points can be skipped as well.
+   */
+  this->m_PointIsSelected.resize( numberOfPoints );
+  unsigned long numberOfSelectedPoints = 0;
+  for( long i = 0; i < numberOfPoints; i++ )
+    {
+    this->m_PointIsSelected[i] = this->SelectPoint();
+    if( this->m_PointIsSelected[i] )
+      {
+      numberOfSelectedPoints++;
+      }
+    }
+
+  outputMesh->GetPoints()->Reserve( numberOfSelectedPoints );
 
   //
   // Load the point coordinates into the itk::Mesh
   //
   PointType point;
+  unsigned long count = 0;
 
   if (isBinary)
     {
@@ -288,29 +599,55 @@ LabeledPointSetFileReader<TOutputMesh>
     
     for (long i = 0; i < numberOfPoints; i++ )
       {
+      if( !this->m_PointIsSelected[i] )
+        {
+        continue;
+        }
       for (long j = 0; j < Dimension; j++ )
         {
         point[j] = ptData[i*3+j];
         }
-      outputMesh->SetPoint( i, point );
+      outputMesh->SetPoint( count++, point );
       }
       
     delete [] ptData;
     }
   else 
     {
-    for( long i = 0; i < numberOfPoints; i++ )
+    std::string buffer;
+    this->ReadRemainingFile( inputFile, buffer );
+
+    const char *begin = buffer.c_str();
+    std::vector<std::vector<double> > values;
+    this->ParseNumbers( begin,
+      this->FindEndOfNumbers( begin, begin + buffer.size() ), values );
+
+    // vtk points always have three coordinates
+    unsigned long index = 0;
+    for( unsigned int n = 0; n < values.size(); n++ )
       {
-      if( Dimension == 2 )
+      for( unsigned long i = 0; i < values[n].size(); i++, index++ )
         {
-        float trash;
-        inputFile >> point >> trash;
-        }
-      else  // Dimension = 3
-        {
-        inputFile >> point;
+        const unsigned long pointId = index / 3;
+        const unsigned int component = index % 3;
+        if( pointId >= static_cast<unsigned long>( numberOfPoints ) )
+          {
+          break;
+          }
+        if( component < Dimension )
+          {
+          point[component] = values[n][i];
+          }
+        if( component == 2 && this->m_PointIsSelected[pointId] )
+          {
+          outputMesh->SetPoint( count++, point );
+          }
         }
-      outputMesh->SetPoint( i, point );
+      }
+    if( index < static_cast<unsigned long>( 3 * numberOfPoints ) )
+      {
+      itkExceptionMacro( "Only " << index / 3 << " of the "
+        << numberOfPoints << " points could be read" );
       }
     }
 
@@ -362,75 +699,76 @@ LabeledPointSetFileReader<TOutputMesh>
 
   std::getline( inputFile, line );
 
+  // the scalars are given for all the points of the file
+  const unsigned long numberOfPoints = this->m_PointIsSelected.size();
+  const unsigned long numberOfValues = numberOfPoints * numberOfComponents;
+
+  std::vector<double> scalarData;
+
   if (isBinary)
     {
- 
-  
-    int numberOfValues = outputMesh->GetNumberOfPoints()*numberOfComponents;
-    float p;
-    int * scalarData = new int [ numberOfValues ];
-    inputFile.read( reinterpret_cast< char * >( scalarData ), numberOfComponents * sizeof(p) );
-    ByteSwapper<int>::SwapRangeFromSystemToBigEndian(scalarData,numberOfValues); 
-  
-    if( numberOfComponents == 1 )
+    int * binaryData = new int [ numberOfValues ];
+    inputFile.read( reinterpret_cast< char * >( binaryData ), numberOfValues * sizeof( int ) );
+    ByteSwapper<int>::SwapRangeFromSystemToBigEndian(binaryData,numberOfValues); 
+    scalarData.assign( binaryData, binaryData + numberOfValues );
+    delete [] binaryData;
+    }
+  else
+    {
+    std::string buffer;
+    this->ReadRemainingFile( inputFile, buffer );
+
+    const char *begin = buffer.c_str();
+    std::vector<std::vector<double> > values;
+    this->ParseNumbers( begin,
+      this->FindEndOfNumbers( begin, begin + buffer.size() ), values );
+
+    scalarData.reserve( numberOfValues );
+    for( unsigned int n = 0; n < values.size(); n++ )
       {
-      //PixelType label;
-      for( unsigned long i = 0; i < outputMesh->GetNumberOfPoints(); i++ )
-        {
-        outputMesh->SetPointData( i, scalarData[i] );
-        }
-  //    itkExceptionMacro( "Only single label components are readable" );
+      scalarData.insert( scalarData.end(), values[n].begin(), values[n].end() );
+      std::vector<double>().swap( values[n] );
       }
-    else
+    if( scalarData.size() < numberOfValues )
       {
-      this->m_MultiComponentScalars = MultiComponentScalarSetType::New(); 
-      this->m_MultiComponentScalars->Initialize();
-      
-      for( unsigned long i = 0; i < outputMesh->GetNumberOfPoints(); i++ )
+      itkExceptionMacro( "Only " << scalarData.size() << " of the "
+        << numberOfValues << " scalar values could be read" );
+      }
+    }
+
+  if( numberOfComponents == 1 )
+    {
+    unsigned long count = 0;
+    for( unsigned long i = 0; i < numberOfPoints; i++ )
+      {
+      if( this->m_PointIsSelected[i] )
         {
-        MultiComponentScalarType scalar;
-        scalar.SetSize( numberOfComponents );
-        for( unsigned int d = 0; d < numberOfComponents; d++ )
-          {
-          scalar[d] = scalarData[i*numberOfComponents + d];
-          }
-        this->m_MultiComponentScalars->InsertElement( i, scalar );
+        outputMesh->SetPointData( count++,
+          static_cast<PixelType>( scalarData[i] ) );
         }
-      } 
-    
-      delete [] scalarData;
-   
+      }
     }
   else
     {
-
-    if( numberOfComponents == 1 )
+    this->m_MultiComponentScalars = MultiComponentScalarSetType::New(); 
+    this->m_MultiComponentScalars->Initialize();
+    
+    unsigned long count = 0;
+    for( unsigned long i = 0; i < numberOfPoints; i++ )
       {
-      PixelType label;
-      for( unsigned long i = 0; i < outputMesh->GetNumberOfPoints(); i++ )
+      if( !this->m_PointIsSelected[i] )
         {
-        inputFile >> label;
-        outputMesh->SetPointData( i, label );
+        continue;
         }
-  //    itkExceptionMacro( "Only single label components are readable" );
-      }
-    else
-      {
-      this->m_MultiComponentScalars = MultiComponentScalarSetType::New(); 
-      this->m_MultiComponentScalars->Initialize();
-      
-      for( unsigned long i = 0; i < outputMesh->GetNumberOfPoints(); i++ )
+      MultiComponentScalarType scalar;
+      scalar.SetSize( numberOfComponents );
+      for( unsigned int d = 0; d < numberOfComponents; d++ )
         {
-        MultiComponentScalarType scalar;
-        scalar.SetSize( numberOfComponents );
-        for( unsigned int d = 0; d < numberOfComponents; d++ )
-          {
-          inputFile >> scalar[d];
-          }
-        this->m_MultiComponentScalars->InsertElement( i, scalar );
+        scalar[d] = static_cast<PixelType>(
+          scalarData[i*numberOfComponents + d] );
         }
+      this->m_MultiComponentScalars->InsertElement( count++, scalar );
       }
-    
     }
 
   inputFile.close();
@@ -554,7 +892,7 @@ LabeledPointSetFileReader<TOutputMesh>
     for( It.GoToBegin(); !It.IsAtEnd(); ++It )
       {
       PixelType label = It.Get();
-      if( label != NumericTraits<PixelType>::Zero )
+      if( label != NumericTraits<PixelType>::Zero && this->SelectPoint() )
         {
         typename LabeledPointSetImageType::PointType imagePoint;
         imageReader->GetOutput()->TransformIndexToPhysicalPoint(
@@ -588,7 +926,7 @@ LabeledPointSetFileReader<TOutputMesh>
     for( It.GoToBegin(); !It.IsAtEnd(); ++It )
       {
       PixelType label = It.Get();
-      if( It.Get() > 0 )
+      if( It.Get() > 0 && this->SelectPoint() )
         {
         typename LabeledPointSetImageType::PointType imagePoint;
         contourFilter->GetOutput()->TransformIndexToPhysicalPoint(
@@ -29,6 +29,17 @@ namespace itk
  * \brief
  * Writes an itkMesh to a file in various txt file formats.
  *
+ * The format is given by the extension: Avants landmark files (.txt), VTK
+ * polydata (.vtk), binary labeled point sets (.lps) or an image.
+ *
+ * A binary labeled point set is a 24 byte header followed by the point
+ * coordinates, as float32, and then the labels.  The header holds the
+ * characters "LABELPS1" and four 32 bit unsigned integers: the point
+ * dimension, the number of points, the label type (0 for int32 labels,
+ * written for integer pixel types, 1 for float32 labels) and a reserved
+ * zero.  All the values are little endian.  The lines and multi-component
+ * scalars are not stored.
+ *
  */
 template <class TInputMesh>
 class LabeledPointSetFileWriter : public Object
@@ -133,6 +144,7 @@ private:
   void operator=(const Self&); //purposely not implemented
 
   void WritePointsToAvantsFile();
+  void WritePointsToBinaryFile();
   void WritePointsToImageFile();
 
 
@@ -20,9 +20,12 @@
 #include "itkLabeledPointSetFileWriter.h"
 
 #include "itkBoundingBox.h"
+#include "itkByteSwapper.h"
 #include "itkImageFileWriter.h"
+#include "itkIntTypes.h"
 
 #include <fstream>
+#include <vector>
 
 namespace itk
 {
@@ -143,6 +146,10 @@ LabeledPointSetFileWriter<TInputMesh>
     {
     this->WriteVTKFile();
     }
+  else if( extension == "lps" )
+    {
+    this->WritePointsToBinaryFile();
+    }
   else
     {
     try
@@ -361,6 +368,115 @@ LabeledPointSetFileWriter<TInputMesh>
   outputFile.close();
 }
 
+template<class TInputMesh>
+void
+LabeledPointSetFileWriter<TInputMesh>
+::WritePointsToBinaryFile()
+{
+  //
+  // Write to output file
+  //
+  std::ofstream outputFile( this->m_FileName.c_str(), std::ios::binary );
+
+  const unsigned long numberOfPoints = this->m_Input->GetNumberOfPoints();
+  const bool hasPointData = ( this->m_Input->GetPointData() &&
+    this->m_Input->GetPointData()->Size() == numberOfPoints );
+  const bool integerLabels = NumericTraits<PixelType>::is_integer;
+
+  uint32_t header[4];
+  header[0] = Dimension;
+  header[1] = static_cast<uint32_t>( numberOfPoints );
+  header[2] = integerLabels ? 0 : 1;
+  header[3] = 0;
+  ByteSwapper<uint32_t>::SwapRangeFromSystemToLittleEndian( header, 4 );
+
+  outputFile.write( "LABELPS1", 8 );
+  outputFile.write( reinterpret_cast<const char *>( header ), sizeof( header ) );
+
+  /**
+   * The points and the labels are converted and written in blocks.
+   */
+  const unsigned long blockSize = 65536;
+  std::vector<float> coordinates;
+  coordinates.reserve( blockSize * Dimension );
+
+  if( numberOfPoints > 0 )
+    {
+    typename InputMeshType::PointsContainerIterator pointIterator
+      = this->m_Input->GetPoints()->Begin();
+    typename InputMeshType::PointsContainerIterator pointEnd
+      = this->m_Input->GetPoints()->End();
+    while( pointIterator != pointEnd )
+      {
+      coordinates.clear();
+      for( unsigned long n = 0; n < blockSize && pointIterator != pointEnd;
+        n++, ++pointIterator )
+        {
+        PointType point = pointIterator.Value();
+        for( unsigned int d = 0; d < Dimension; d++ )
+          {
+          coordinates.push_back( static_cast<float>( point[d] ) );
+          }
+        }
+      ByteSwapper<float>::SwapRangeFromSystemToLittleEndian(
+        &coordinates[0], coordinates.size() );
+      outputFile.write( reinterpret_cast<const char *>( &coordinates[0] ),
+        coordinates.size() * sizeof( float ) );
+      }
+    }
+
+  std::vector<int32_t> integerValues;
+  std::vector<float> realValues;
+  typename InputMeshType::PointDataContainerIterator pointDataIterator;
+  if( hasPointData )
+    {
+    pointDataIterator = this->m_Input->GetPointData()->Begin();
+    }
+  for( unsigned long i = 0; i < numberOfPoints; )
+    {
+    integerValues.clear();
+    realValues.clear();
+    for( unsigned long n = 0; n < blockSize && i < numberOfPoints; n++, i++ )
+      {
+      PixelType label = NumericTraits<PixelType>::Zero;
+      if( hasPointData )
+        {
+        label = pointDataIterator.Value();
+        ++pointDataIterator;
+        }
+      if( integerLabels )
+        {
+        integerValues.push_back( static_cast<int32_t>( label ) );
+        }
+      else
+        {
+        realValues.push_back( static_cast<float>( label ) );
+        }
+      }
+    if( integerLabels )
+      {
+      ByteSwapper<int32_t>::SwapRangeFromSystemToLittleEndian(
+        &integerValues[0], integerValues.size() );
+      outputFile.write( reinterpret_cast<const char *>( &integerValues[0] ),
+        integerValues.size() * sizeof( int32_t ) );
+      }
+    else
+      {
+      ByteSwapper<float>::SwapRangeFromSystemToLittleEndian(
+        &realValues[0], realValues.size() );
+      outputFile.write( reinterpret_cast<const char *>( &realValues[0] ),
+        realValues.size() * sizeof( float ) );
+      }
+    }
+
+  if( !outputFile.good() )
+    {
+    itkExceptionMacro( "Unable to write file\n"
+        "outputFilename= " << this->m_FileName );
+    }
+  outputFile.close();
+}
+
 template<class TInputMesh>
 void
 LabeledPointSetFileWriter<TInputMesh>
@@ -19,10 +19,14 @@
 #include "itkExceptionObject.h"
 #include "itkMetaDataObject.h"
 #include "itkByteSwapper.h"
+#include "itkMultiThreader.h"
+#include "vnl/vnl_math.h"
 #include <iostream>
 #include <list>
 #include <string>
+#include <vector>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 
 
@@ -38,10 +42,19 @@ namespace itk {
 class GenericCUBFileAdaptor
 {
 public:
+  virtual ~GenericCUBFileAdaptor() {}
+
   virtual unsigned char ReadByte() = 0;
   virtual void ReadData(void *data, unsigned long bytes) = 0;
   virtual void WriteData(const void *data, unsigned long bytes) = 0;
 
+  // Position in the uncompressed data
+  virtual void Seek(unsigned long position) = 0;
+  virtual unsigned long Tell() = 0;
+
+  // Write what is still buffered and close the file, throwing on failure
+  virtual void Close() = 0;
+
   std::string ReadHeader()
     {
     // Read everything up to the \f symbol
@@ -80,6 +93,8 @@ class CompressedCUBFileAdaptor : public GenericCUBFileAdaptor
 public:
   CompressedCUBFileAdaptor(const char *file, const char *mode)
     {
+    m_BufferBegin = 0;
+    m_BufferEnd = 0;
     m_GzFile = ::gzopen(file, mode);
     if(m_GzFile == NULL)
       {
@@ -98,18 +113,25 @@ public:
  }
     }
 
+  // The bytes are read through a buffer, which ReadData empties first
   unsigned char ReadByte()
     {
-    int byte = ::gzgetc(m_GzFile);
-    if(byte < 0)
+    if(m_BufferBegin == m_BufferEnd)
       {
-      std::ostringstream oss;
-      oss << "Error reading byte from file at position: " << ::gztell(m_GzFile);
-      ExceptionObject exception;
-      exception.SetDescription(oss.str().c_str());
-      throw exception;
+      m_Buffer.resize(BufferSize);
+      int bread = ::gzread(m_GzFile, &m_Buffer[0], BufferSize);
+      if(bread <= 0)
+        {
+        std::ostringstream oss;
+        oss << "Error reading byte from file at position: " << ::gztell(m_GzFile);
+        ExceptionObject exception;
+        exception.SetDescription(oss.str().c_str());
+        throw exception;
+        }
+      m_BufferBegin = 0;
+      m_BufferEnd = bread;
       }
-    return static_cast<unsigned char>(byte);
+    return static_cast<unsigned char>(m_Buffer[m_BufferBegin++]);
     }
   
   void ReadData(void *data, unsigned long bytes)
@@ -121,7 +143,23 @@ public:
       throw exception;
       }
 
-    int bread = ::gzread(m_GzFile, data, bytes);
+    unsigned long buffered = m_BufferEnd - m_BufferBegin;
+    if(buffered > bytes)
+      {
+      buffered = bytes;
+      }
+    if(buffered > 0)
+      {
+      memcpy(data, &m_Buffer[m_BufferBegin], buffered);
+      m_BufferBegin += buffered;
+      }
+
+    int bread = buffered;
+    if(bytes > buffered)
+      {
+      bread += ::gzread(m_GzFile,
+        static_cast<char *>(data) + buffered, bytes - buffered);
+      }
     if(bread != bytes)
       {
       std::ostringstream oss;
@@ -155,8 +193,52 @@ public:
      ::gzflush(m_GzFile,Z_SYNC_FLUSH);
     }
 
+  void Seek(unsigned long position)
+    {
+    // Stay in the buffer if possible, gzseek backwards restarts the stream
+    unsigned long bufferPosition = ::gztell(m_GzFile) - m_BufferEnd;
+    if(position >= bufferPosition && position <= bufferPosition + m_BufferEnd)
+      {
+      m_BufferBegin = position - bufferPosition;
+      return;
+      }
+    m_BufferBegin = 0;
+    m_BufferEnd = 0;
+    if(::gzseek(m_GzFile, position, SEEK_SET) < 0)
+      {
+      ExceptionObject exception;
+      exception.SetDescription("File cannot be read");
+      throw exception;
+      }
+    }
+
+  unsigned long Tell()
+    {
+    return ::gztell(m_GzFile) - (m_BufferEnd - m_BufferBegin);
+    }
+
+  void Close()
+    {
+    if(m_GzFile)
+      {
+      int status = ::gzclose(m_GzFile);
+      m_GzFile = NULL;
+      if(status != Z_OK)
+        {
+        ExceptionObject exception;
+        exception.SetDescription("Could not close the file");
+        throw exception;
+        }
+      }
+    }
+
 private:
+  enum { BufferSize = 4096 };
+
   gzFile m_GzFile;
+  std::vector<char> m_Buffer;
+  unsigned long m_BufferBegin;
+  unsigned long m_BufferEnd;
 };
 
 //#endif // SNAP_GZIP_SUPPORT
@@ -239,8 +321,650 @@ public:
       }
     }
 
+  void Seek(unsigned long position)
+    {
+    if(fseek(m_File, position, SEEK_SET) != 0)
+      {
+      ExceptionObject exception;
+      exception.SetDescription("File cannot be read");
+      throw exception;
+      }
+    }
+
+  unsigned long Tell()
+    {
+    return ftell(m_File);
+    }
+
+  void Close()
+    {
+    if(m_File)
+      {
+      int status = fclose(m_File);
+      m_File = NULL;
+      if(status != 0)
+        {
+        ExceptionObject exception;
+        exception.SetDescription("Could not close the file");
+        throw exception;
+        }
+      }
+    }
+
+private:
+  FILE *m_File;
+};
+
+/**
+ * A reader and writer for blocked gzip files. The data are cut in blocks
+ * of at most BlockDataSize bytes, each one compressed as a separate gzip
+ * member whose extra field ("BC") holds the compressed size of the block,
+ * as in the BGZF format. The file is therefore still a valid gzip file,
+ * while the blocks are compressed and decompressed independently on all
+ * the threads. The blocks are indexed as they are needed, from their
+ * headers only, so that a part of the data can be read without inflating
+ * the blocks before it.
+ */
+class BlockedCompressedCUBFileAdaptor : public GenericCUBFileAdaptor
+{
+public:
+  BlockedCompressedCUBFileAdaptor(const char *file, const char *mode)
+    {
+    m_File = fopen(file, mode);
+    if(!m_File)
+      {
+      ExceptionObject exception;
+      exception.SetDescription("File cannot be accessed");
+      throw exception;
+      }
+    m_Writing = (mode[0] == 'w');
+    m_Position = 0;
+    m_NumberOfWrittenBlocks = 0;
+    m_NextBlockOffset = 0;
+    m_IndexIsComplete = false;
+    m_CachedBlock = -1;
+    }
+
+  // Only a fallback, the writers call Close() to see the errors
+  ~BlockedCompressedCUBFileAdaptor()
+    {
+    try
+      {
+      this->Close();
+      }
+    catch(...)
+      {
+      }
+    }
+
+  // Write what is left and the empty end of file block
+  void Close()
+    {
+    if(!m_File)
+      {
+      return;
+      }
+    if(m_Writing)
+      {
+      try
+        {
+        if(!m_Pending.empty())
+          {
+          this->WriteBlocks(&m_Pending[0], m_Pending.size());
+          m_Pending.clear();
+          }
+        std::vector<unsigned char> block;
+        if(!CompressBlock(NULL, 0, block) ||
+          fwrite(&block[0], 1, block.size(), m_File) != block.size())
+          {
+          ExceptionObject exception;
+          exception.SetDescription("Could not write all bytes to file");
+          throw exception;
+          }
+        }
+      catch(...)
+        {
+        fclose(m_File);
+        m_File = NULL;
+        throw;
+        }
+      }
+    int status = fclose(m_File);
+    m_File = NULL;
+    if(status != 0 && m_Writing)
+      {
+      ExceptionObject exception;
+      exception.SetDescription("Could not close the file");
+      throw exception;
+      }
+    }
+
+  // Check whether the first member of a gzip file has a block size field
+  static bool IsBlockedFile(const char *file)
+    {
+    FILE *f = fopen(file, "rb");
+    if(!f)
+      {
+      return false;
+      }
+    unsigned char header[MaximumHeaderSize];
+    unsigned long length = fread(header, 1, MaximumHeaderSize, f);
+    fclose(f);
+
+    unsigned long headerSize;
+    return (GetBlockSize(header, length, headerSize) > 0);
+    }
+
+  unsigned char ReadByte()
+    {
+    if(m_CachedBlock < 0 || !this->IsInBlock(m_Position, m_CachedBlock))
+      {
+      long block = this->FindBlock(m_Position);
+      if(block < 0 || !this->InflateCachedBlock(block))
+        {
+        std::ostringstream oss;
+        oss << "Error reading byte from file at position: " << m_Position;
+        ExceptionObject exception;
+        exception.SetDescription(oss.str().c_str());
+        throw exception;
+        }
+      }
+    const BlockInfo &info = m_Blocks[m_CachedBlock];
+    return m_Cache[m_Position++ - info.UncompressedOffset];
+    }
+
+  void ReadData(void *data, unsigned long bytes)
+    {
+    if(bytes == 0)
+      {
+      return;
+      }
+    const unsigned long begin = m_Position;
+    const unsigned long end = m_Position + bytes;
+
+    this->IndexBlocks(end - 1);
+    long firstBlock = this->FindBlock(begin);
+    if(firstBlock < 0 || this->GetIndexedSize() < end)
+      {
+      unsigned long available = this->GetIndexedSize() > begin
+        ? this->GetIndexedSize() - begin : 0;
+      std::ostringstream oss;
+      oss << "File size does not match header: " 
+        << bytes << " bytes requested but only "
+        << available << " bytes available!" << std::endl
+        << "At file position " << begin;
+      ExceptionObject exception;
+      exception.SetDescription(oss.str().c_str());
+      throw exception;
+      }
+
+    unsigned char *output = static_cast<unsigned char *>(data);
+    unsigned long first = firstBlock;
+    while(m_Position < end)
+      {
+      // Inflate the blocks by batches to bound the compressed data in memory
+      unsigned long last = first;
+      while(last + 1 < m_Blocks.size() && last + 1 - first < BatchSize
+        && m_Blocks[last + 1].UncompressedOffset < end)
+        {
+        last++;
+        }
+      this->ReadCompressedBlocks(first, last);
+
+      BlockThreadStruct str;
+      str.Compress = false;
+      std::vector<std::vector<unsigned char> > partial(last - first + 1);
+      for(unsigned long b = first; b <= last; b++)
+        {
+        const BlockInfo &info = m_Blocks[b];
+        str.Inputs.push_back(
+          &m_Compressed[info.CompressedOffset - m_Blocks[first].CompressedOffset]);
+        str.InputSizes.push_back(info.CompressedSize);
+        if(info.UncompressedOffset >= begin
+          && info.UncompressedOffset + info.UncompressedSize <= end)
+          {
+          str.Outputs.push_back(output + (info.UncompressedOffset - begin));
+          }
+        else
+          {
+          partial[b - first].resize(info.UncompressedSize);
+          str.Outputs.push_back(&partial[b - first][0]);
+          }
+        str.OutputSizes.push_back(info.UncompressedSize);
+        }
+      ProcessBlocks(str);
+
+      // Copy the requested part of the first and last blocks
+      for(unsigned long b = first; b <= last; b++)
+        {
+        if(partial[b - first].empty())
+          {
+          continue;
+          }
+        const BlockInfo &info = m_Blocks[b];
+        unsigned long from = vnl_math_max(begin, info.UncompressedOffset);
+        unsigned long to = vnl_math_min(end,
+          info.UncompressedOffset + info.UncompressedSize);
+        memcpy(output + (from - begin),
+          &partial[b - first][from - info.UncompressedOffset], to - from);
+        }
+
+      m_Position = vnl_math_min(end,
+        m_Blocks[last].UncompressedOffset + m_Blocks[last].UncompressedSize);
+      first = last + 1;
+      }
+    }
+
+  void WriteData(const void *data, unsigned long bytes)
+    {
+    if(!m_Writing)
+      {
+      ExceptionObject exception;
+      exception.SetDescription("File cannot be written");
+      throw exception;
+      }
+
+    const unsigned char *input = static_cast<const unsigned char *>(data);
+
+    // Complete the pending block first
+    if(!m_Pending.empty())
+      {
+      unsigned long n = vnl_math_min(bytes,
+        static_cast<unsigned long>(BlockDataSize - m_Pending.size()));
+      m_Pending.insert(m_Pending.end(), input, input + n);
+      input += n;
+      bytes -= n;
+      if(m_Pending.size() < BlockDataSize)
+        {
+        this->UpdateWritePosition();
+        return;
+        }
+      this->WriteBlocks(&m_Pending[0], m_Pending.size());
+      m_Pending.clear();
+      }
+
+    unsigned long full = bytes - bytes % BlockDataSize;
+    this->WriteBlocks(input, full);
+    m_Pending.assign(input + full, input + bytes);
+    this->UpdateWritePosition();
+    }
+
+  void Seek(unsigned long position)
+    {
+    // The blocks are written sequentially, so a writer cannot move
+    if(m_Writing && position != m_Position)
+      {
+      ExceptionObject exception;
+      exception.SetDescription("Blocked compressed file cannot be seeked while writing");
+      throw exception;
+      }
+    m_Position = position;
+    }
+
+  unsigned long Tell()
+    {
+    return m_Position;
+    }
+
 private:
+  enum { BlockDataSize = 0xff00,
+         MaximumBlockSize = 0x10000,
+         MaximumHeaderSize = 0x10000 + 12,
+         BatchSize = 1024 };
+
+  struct BlockInfo
+    {
+    unsigned long CompressedOffset;
+    unsigned long CompressedSize;
+    unsigned long UncompressedOffset;
+    unsigned long UncompressedSize;
+    };
+
+  // Blocks compressed or inflated by the threads
+  struct BlockThreadStruct
+    {
+    bool Compress;
+    std::vector<const unsigned char *> Inputs;
+    std::vector<unsigned long> InputSizes;
+    std::vector<unsigned char *> Outputs;
+    std::vector<unsigned long> OutputSizes;
+    std::vector<std::vector<unsigned char> > Blocks;
+    std::vector<char> Succeeded;
+    };
+
+  static unsigned long GetLittleEndian(const unsigned char *bytes, unsigned int n)
+    {
+    unsigned long value = 0;
+    for(unsigned int i = n; i > 0; i--)
+      {
+      value = (value << 8) | bytes[i - 1];
+      }
+    return value;
+    }
+
+  static void SetLittleEndian(unsigned char *bytes, unsigned long value, unsigned int n)
+    {
+    for(unsigned int i = 0; i < n; i++, value >>= 8)
+      {
+      bytes[i] = static_cast<unsigned char>(value & 0xff);
+      }
+    }
+
+  // Total size of the block starting with the given bytes, 0 if it is not
+  // a blocked gzip member
+  static unsigned long GetBlockSize(const unsigned char *header,
+    unsigned long length, unsigned long &headerSize)
+    {
+    if(length < 12 || header[0] != 31 || header[1] != 139
+      || header[2] != 8 || !(header[3] & 4))
+      {
+      return 0;
+      }
+    unsigned long xlen = GetLittleEndian(header + 10, 2);
+    headerSize = 12 + xlen;
+    if(length < headerSize)
+      {
+      return 0;
+      }
+    for(unsigned long i = 12; i + 4 <= headerSize; )
+      {
+      unsigned long slen = GetLittleEndian(header + i + 2, 2);
+      if(header[i] == 'B' && header[i + 1] == 'C' && slen == 2
+        && i + 6 <= headerSize)
+        {
+        return GetLittleEndian(header + i + 4, 2) + 1;
+        }
+      i += 4 + slen;
+      }
+    return 0;
+    }
+
+  static bool CompressBlock(const unsigned char *data, unsigned long size,
+    std::vector<unsigned char> &block)
+    {
+    const unsigned long headerSize = 18;
+    block.resize(MaximumBlockSize);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+      Z_DEFAULT_STRATEGY) != Z_OK)
+      {
+      return false;
+      }
+    stream.next_in = const_cast<Bytef *>(data);
+    stream.avail_in = size;
+    stream.next_out = &block[headerSize];
+    stream.avail_out = MaximumBlockSize - headerSize - 8;
+    int status = deflate(&stream, Z_FINISH);
+    unsigned long compressedSize = stream.total_out;
+    deflateEnd(&stream);
+    if(status != Z_STREAM_END)
+      {
+      return false;
+      }
+
+    const unsigned char header[16] =
+      { 31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0 };
+    unsigned long blockSize = headerSize + compressedSize + 8;
+    memcpy(&block[0], header, 16);
+    SetLittleEndian(&block[16], blockSize - 1, 2);
+    SetLittleEndian(&block[headerSize + compressedSize],
+      crc32(crc32(0L, Z_NULL, 0), data, size), 4);
+    SetLittleEndian(&block[headerSize + compressedSize + 4], size, 4);
+    block.resize(blockSize);
+    return true;
+    }
+
+  static bool InflateBlock(const unsigned char *block, unsigned long blockSize,
+    unsigned char *output, unsigned long outputSize)
+    {
+    unsigned long headerSize;
+    if(GetBlockSize(block, blockSize, headerSize) != blockSize
+      || blockSize < headerSize + 8)
+      {
+      return false;
+      }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if(inflateInit2(&stream, -15) != Z_OK)
+      {
+      return false;
+      }
+    stream.next_in = const_cast<Bytef *>(block + headerSize);
+    stream.avail_in = blockSize - headerSize - 8;
+    stream.next_out = output;
+    stream.avail_out = outputSize;
+    int status = inflate(&stream, Z_FINISH);
+    unsigned long inflatedSize = stream.total_out;
+    inflateEnd(&stream);
+
+    return (status == Z_STREAM_END && inflatedSize == outputSize
+      && crc32(crc32(0L, Z_NULL, 0), output, outputSize)
+        == GetLittleEndian(block + blockSize - 8, 4));
+    }
+
+  static ITK_THREAD_RETURN_TYPE BlockThreaderCallback(void *arg)
+    {
+    MultiThreader::ThreadInfoStruct *info =
+      static_cast<MultiThreader::ThreadInfoStruct *>(arg);
+    BlockThreadStruct *str = static_cast<BlockThreadStruct *>(info->UserData);
+
+    unsigned long n = str->Inputs.size();
+    unsigned long first = n * info->ThreadID / info->NumberOfThreads;
+    unsigned long last = n * (info->ThreadID + 1) / info->NumberOfThreads;
+    for(unsigned long i = first; i < last; i++)
+      {
+      if(str->Compress)
+        {
+        str->Succeeded[i] = CompressBlock(str->Inputs[i], str->InputSizes[i],
+          str->Blocks[i]);
+        }
+      else
+        {
+        str->Succeeded[i] = InflateBlock(str->Inputs[i], str->InputSizes[i],
+          str->Outputs[i], str->OutputSizes[i]);
+        }
+      }
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  static void ProcessBlocks(BlockThreadStruct &str)
+    {
+    str.Blocks.resize(str.Compress ? str.Inputs.size() : 0);
+    str.Succeeded.assign(str.Inputs.size(), 0);
+
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetNumberOfThreads(vnl_math_min(
+      static_cast<unsigned long>(threader->GetNumberOfThreads()),
+      static_cast<unsigned long>(str.Inputs.size())));
+    threader->SetSingleMethod(BlockThreaderCallback, &str);
+    threader->SingleMethodExecute();
+
+    for(unsigned long i = 0; i < str.Succeeded.size(); i++)
+      {
+      if(!str.Succeeded[i])
+        {
+        ExceptionObject exception;
+        exception.SetDescription(str.Compress
+          ? "Could not compress the data" : "Corrupted compressed block");
+        throw exception;
+        }
+      }
+    }
+
+  // All the blocks written before the pending bytes are full
+  void UpdateWritePosition()
+    {
+    m_Position = m_NumberOfWrittenBlocks * BlockDataSize + m_Pending.size();
+    }
+
+  // Compress and write the data, all the blocks but the last one being full
+  void WriteBlocks(const unsigned char *data, unsigned long bytes)
+    {
+    for(unsigned long offset = 0; offset < bytes;
+      offset += BatchSize * BlockDataSize)
+      {
+      BlockThreadStruct str;
+      str.Compress = true;
+      unsigned long end = vnl_math_min(bytes,
+        offset + BatchSize * BlockDataSize);
+      for(unsigned long b = offset; b < end; b += BlockDataSize)
+        {
+        str.Inputs.push_back(data + b);
+        str.InputSizes.push_back(vnl_math_min(
+          static_cast<unsigned long>(BlockDataSize), end - b));
+        }
+      ProcessBlocks(str);
+
+      for(unsigned long i = 0; i < str.Blocks.size(); i++)
+        {
+        if(fwrite(&str.Blocks[i][0], 1, str.Blocks[i].size(), m_File)
+          != str.Blocks[i].size())
+          {
+          ExceptionObject exception;
+          exception.SetDescription("Could not write all bytes to file");
+          throw exception;
+          }
+        }
+      m_NumberOfWrittenBlocks += str.Blocks.size();
+      }
+    }
+
+  unsigned long GetIndexedSize() const
+    {
+    if(m_Blocks.empty())
+      {
+      return 0;
+      }
+    return m_Blocks.back().UncompressedOffset + m_Blocks.back().UncompressedSize;
+    }
+
+  // Index the blocks until the one holding the position
+  void IndexBlocks(unsigned long position)
+    {
+    std::vector<unsigned char> header(MaximumHeaderSize);
+    while(!m_IndexIsComplete && this->GetIndexedSize() <= position)
+      {
+      unsigned long length = 0;
+      if(fseek(m_File, m_NextBlockOffset, SEEK_SET) == 0)
+        {
+        length = fread(&header[0], 1, 12, m_File);
+        }
+      if(length == 0)
+        {
+        m_IndexIsComplete = true;
+        break;
+        }
+      if(length == 12 && (header[3] & 4))
+        {
+        length += fread(&header[12], 1, GetLittleEndian(&header[10], 2), m_File);
+        }
+
+      unsigned long headerSize;
+      unsigned long blockSize = GetBlockSize(&header[0], length, headerSize);
+      unsigned char trailer[4];
+      if(blockSize < headerSize + 8
+        || fseek(m_File, m_NextBlockOffset + blockSize - 4, SEEK_SET) != 0
+        || fread(trailer, 1, 4, m_File) != 4)
+        {
+        ExceptionObject exception;
+        exception.SetDescription("Corrupted compressed block");
+        throw exception;
+        }
+
+      BlockInfo info;
+      info.CompressedOffset = m_NextBlockOffset;
+      info.CompressedSize = blockSize;
+      info.UncompressedOffset = this->GetIndexedSize();
+      info.UncompressedSize = GetLittleEndian(trailer, 4);
+      m_NextBlockOffset += blockSize;
+
+      // Skip the empty blocks, such as the end of file marker
+      if(info.UncompressedSize > 0)
+        {
+        m_Blocks.push_back(info);
+        }
+      }
+    }
+
+  bool IsInBlock(unsigned long position, long block) const
+    {
+    const BlockInfo &info = m_Blocks[block];
+    return (position >= info.UncompressedOffset
+      && position < info.UncompressedOffset + info.UncompressedSize);
+    }
+
+  // Block holding the position, -1 past the end of the data
+  long FindBlock(unsigned long position)
+    {
+    this->IndexBlocks(position);
+    if(position >= this->GetIndexedSize())
+      {
+      return -1;
+      }
+    unsigned long low = 0, high = m_Blocks.size() - 1;
+    while(low < high)
+      {
+      unsigned long middle = (low + high + 1) / 2;
+      if(m_Blocks[middle].UncompressedOffset <= position)
+        {
+        low = middle;
+        }
+      else
+        {
+        high = middle - 1;
+        }
+      }
+    return low;
+    }
+
+  void ReadCompressedBlocks(unsigned long first, unsigned long last)
+    {
+    unsigned long offset = m_Blocks[first].CompressedOffset;
+    unsigned long size = m_Blocks[last].CompressedOffset
+      + m_Blocks[last].CompressedSize - offset;
+    m_Compressed.resize(size);
+    if(fseek(m_File, offset, SEEK_SET) != 0
+      || fread(&m_Compressed[0], 1, size, m_File) != size)
+      {
+      ExceptionObject exception;
+      exception.SetDescription("File cannot be read");
+      throw exception;
+      }
+    }
+
+  bool InflateCachedBlock(long block)
+    {
+    this->ReadCompressedBlocks(block, block);
+    m_Cache.resize(m_Blocks[block].UncompressedSize);
+    m_CachedBlock = -1;
+    if(!InflateBlock(&m_Compressed[0], m_Compressed.size(),
+      &m_Cache[0], m_Cache.size()))
+      {
+      return false;
+      }
+    m_CachedBlock = block;
+    return true;
+    }
+
   FILE *m_File;
+  bool m_Writing;
+  unsigned long m_Position;
+  unsigned long m_NumberOfWrittenBlocks;
+
+  // Block index, built as the blocks are needed
+  std::vector<BlockInfo> m_Blocks;
+  unsigned long m_NextBlockOffset;
+  bool m_IndexIsComplete;
+
+  // Last single block inflated, used when reading the header byte per byte
+  std::vector<unsigned char> m_Cache;
+  long m_CachedBlock;
+
+  std::vector<unsigned char> m_Compressed;
+  std::vector<unsigned char> m_Pending;
 };
 
 
@@ -292,6 +1016,7 @@ VoxBoCUBImageIO::VoxBoCUBImageIO()
   m_ByteOrder = BigEndian;
   m_Reader = NULL;
   m_Writer = NULL;
+  m_DataOffset = 0;
 }
 
 
@@ -312,7 +1037,13 @@ VoxBoCUBImageIO::CreateReader(const char *filename)
     bool compressed;
     if(CheckExtension(filename, compressed))
       if(compressed)
+        {
+        // Files written by older versions are single gzip streams
+        if(BlockedCompressedCUBFileAdaptor::IsBlockedFile(filename))
+          return new BlockedCompressedCUBFileAdaptor(filename, "rb");
+        else
           return new CompressedCUBFileAdaptor(filename, "rb");
+        }
       else
         return new DirectCUBFileAdaptor(filename, "rb");
     else
@@ -332,7 +1063,7 @@ VoxBoCUBImageIO::CreateWriter(const char *filename)
     bool compressed;
     if(CheckExtension(filename, compressed))
       if(compressed)
-          return new CompressedCUBFileAdaptor(filename, "wb");
+          return new BlockedCompressedCUBFileAdaptor(filename, "wb");
       else
         return new DirectCUBFileAdaptor(filename, "wb");
     else
@@ -398,8 +1129,41 @@ void VoxBoCUBImageIO::Read(void* buffer)
     throw exception;
     }
 
-  m_Reader->ReadData(buffer, GetImageSizeInBytes());
-  this->SwapBytesIfNecessary(buffer, GetImageSizeInBytes());
+  const unsigned long pixelSize =
+    this->GetComponentSize() * this->GetNumberOfComponents();
+  if(m_IORegion.GetNumberOfPixels() == this->GetImageSizeInPixels())
+    {
+    m_Reader->Seek(m_DataOffset);
+    m_Reader->ReadData(buffer, GetImageSizeInBytes());
+    this->SwapBytesIfNecessary(buffer, GetImageSizeInBytes());
+    return;
+    }
+
+  // Streaming: read the rows of the region slice by slice
+  unsigned long index[3], size[3];
+  for(unsigned int d = 0; d < 3; d++)
+    {
+    index[d] = (d < m_IORegion.GetImageDimension()) ? m_IORegion.GetIndex(d) : 0;
+    size[d] = (d < m_IORegion.GetImageDimension()) ? m_IORegion.GetSize(d) : 1;
+    }
+  const unsigned long rowSize = m_Dimensions[0] * pixelSize;
+  const unsigned long sliceSize = m_Dimensions[1] * rowSize;
+  const unsigned long regionRowSize = size[0] * pixelSize;
+
+  std::vector<char> rows(size[1] * rowSize);
+  char *output = static_cast<char *>(buffer);
+  for(unsigned long z = index[2]; z < index[2] + size[2]; z++)
+    {
+    m_Reader->Seek(m_DataOffset + z * sliceSize + index[1] * rowSize);
+    m_Reader->ReadData(&rows[0], rows.size());
+    for(unsigned long y = 0; y < size[1]; y++)
+      {
+      memcpy(output, &rows[y * rowSize + index[0] * pixelSize], regionRowSize);
+      output += regionRowSize;
+      }
+    }
+  this->SwapBytesIfNecessary(buffer,
+    m_IORegion.GetNumberOfPixels() * pixelSize);
 }
 
 /** 
@@ -426,6 +1190,7 @@ void VoxBoCUBImageIO::ReadImageInformation()
 
   // Read the file header
   std::istringstream issHeader(m_Reader->ReadHeader());
+  m_DataOffset = m_Reader->Tell();
 
   // Read every string in the header. Parse the strings that are special
   while(issHeader.good())
@@ -657,8 +1422,9 @@ VoxBoCUBImageIO
   m_Writer = CreateWriter(m_FileName.c_str());
   WriteImageInformation();
   m_Writer->WriteData(buffer, GetImageSizeInBytes());
-delete m_Writer;
-m_Writer=NULL;
+  m_Writer->Close();
+  delete m_Writer;
+  m_Writer = NULL;
 }
 
 /** Print Self Method */
@@ -36,6 +36,11 @@ namespace itk
  *
  *  \brief Read VoxBoCUBImage file format. 
  *
+ *  Compressed (.cub.gz) files are written as blocked gzip files, which
+ *  plain gzip still reads but whose blocks are compressed and inflated on
+ *  all the threads. A region can be read without inflating the blocks
+ *  before it. Single stream gzip files are still read.
+ *
  *  \ingroup IOFilters
  *
  */
@@ -65,6 +70,9 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void* buffer);
 
+  /** Any region of the image can be read. */
+  virtual bool CanStreamRead() { return true; }
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can write the
@@ -92,6 +100,9 @@ private:
   GenericCUBFileAdaptor *CreateWriter(const char *filename);
   GenericCUBFileAdaptor *m_Reader, *m_Writer;
 
+  // Position of the first pixel in the (uncompressed) file
+  unsigned long m_DataOffset;
+
   // Initialize the orientation map (from strings to ITK)
   void InitializeOrientationMap();
 
@@ -0,0 +1,1804 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkFEMLinearSystemWrapperCSR.cxx,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:22:50 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+// disable debug warnings in MS compiler
+#ifdef _MSC_VER
+#pragma warning(disable: 4786)
+#endif
+
+#include "itkFEMLinearSystemWrapperCSR.h"
+#include "itkFEMException.h"
+
+#include "vnl/algo/vnl_sparse_lu.h"
+#include "vnl/vnl_sparse_matrix.h"
+#include "vnl/vnl_vector.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace itk {
+namespace fem {
+
+/**
+ * Rows below this number are processed by the calling thread only,
+ * the cost of spawning the threads would dominate.
+ */
+static const unsigned int CSRMinimumRowsPerThreadedCall = 4096;
+
+
+
+LinearSystemWrapperCSR::LinearSystemWrapperCSR()
+  : m_Matrices(0), m_Vectors(0), m_Solutions(0)
+{
+  m_Preconditioner = JacobiPreconditioner;
+  m_MaximumNumberIterations = 0;
+  m_Tolerance = 1.e-6;
+  m_UseWarmStart = false;
+  m_MultigridCoarsestSize = 500;
+  m_NumberOfIterationsPerformed = 0;
+  m_FinalRelativeResidual = 0.0;
+  m_CoarsestOrder = 0;
+  m_PreconditionerIsDirty = true;
+  m_UseDirectSolver = false;
+  m_DirectSolver = 0;
+
+  m_Threader = MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+
+  m_ThreadMatrix = 0;
+  m_ThreadInput1 = 0;
+  m_ThreadInput2 = 0;
+  m_ThreadOutput1 = 0;
+  m_ThreadOutput2 = 0;
+  m_ThreadScalar = 0.0;
+  m_ThreadOperation = DotProductOperation;
+  m_ThreadRows = 0;
+}
+
+
+
+LinearSystemWrapperCSR::~LinearSystemWrapperCSR()
+{
+  unsigned int i;
+  delete m_DirectSolver;
+  if ( m_Matrices != 0 )
+  {
+    for (i=0; i<m_Matrices->size(); i++)
+    {
+      delete (*m_Matrices)[i];
+    }
+    delete m_Matrices;
+  }
+  if ( m_Vectors != 0 )
+  {
+    for (i=0; i<m_Vectors->size(); i++)
+    {
+      delete (*m_Vectors)[i];
+    }
+    delete m_Vectors;
+  }
+  if ( m_Solutions != 0 )
+  {
+    for (i=0; i<m_Solutions->size(); i++)
+    {
+      delete (*m_Solutions)[i];
+    }
+    delete m_Solutions;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::SetNumberOfThreads(unsigned int n)
+{
+  m_Threader->SetNumberOfThreads(n);
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+
+/* -----------------------------------------------------------------
+ *
+ * Symbolic assembly
+ *
+ * -----------------------------------------------------------------
+ */
+
+void LinearSystemWrapperCSR::BuildSparsityPattern(const std::vector<ColumnArray>& dofsPerElement)
+{
+  if (m_Order == 0)
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, "LinearSystemWrapperCSR::BuildSparsityPattern", "System order not set");
+  }
+
+  const unsigned int N = m_Order;
+  const unsigned int numberOfElements = static_cast<unsigned int>( dofsPerElement.size() );
+  unsigned int e, i, j;
+
+  /*
+   * Incidence of the degrees of freedom in the elements (CSR layout).
+   */
+  ColumnArray incidenceStart(N+1, 0);
+  for (e=0; e<numberOfElements; e++)
+  {
+    for (i=0; i<dofsPerElement[e].size(); i++)
+    {
+      const unsigned int dof = dofsPerElement[e][i];
+      if (dof >= N)
+      {
+        throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::BuildSparsityPattern", "dofsPerElement", e, i);
+      }
+      incidenceStart[dof+1]++;
+    }
+  }
+  for (i=0; i<N; i++)
+  {
+    incidenceStart[i+1] += incidenceStart[i];
+  }
+  ColumnArray incidence(incidenceStart[N]);
+  ColumnArray fill(incidenceStart.begin(), incidenceStart.end()-1);
+  for (e=0; e<numberOfElements; e++)
+  {
+    for (i=0; i<dofsPerElement[e].size(); i++)
+    {
+      incidence[fill[dofsPerElement[e][i]]++] = e;
+    }
+  }
+
+  /*
+   * Each row gets the union of the degrees of freedom of the elements
+   * that contain it.  A marker array avoids storing duplicates.
+   */
+  std::vector<unsigned int> marker(N, N);
+  ColumnArray row;
+  m_PatternRowStart.assign(N+1, 0);
+  m_PatternColumns.clear();
+  m_PatternColumns.reserve(incidenceStart[N]*8);
+  for (i=0; i<N; i++)
+  {
+    row.clear();
+    row.push_back(i);
+    marker[i] = i;
+    for (j=incidenceStart[i]; j<incidenceStart[i+1]; j++)
+    {
+      const ColumnArray& dofs = dofsPerElement[incidence[j]];
+      for (unsigned int k=0; k<dofs.size(); k++)
+      {
+        if (marker[dofs[k]] != i)
+        {
+          marker[dofs[k]] = i;
+          row.push_back(dofs[k]);
+        }
+      }
+    }
+    std::sort(row.begin(), row.end());
+    m_PatternColumns.insert(m_PatternColumns.end(), row.begin(), row.end());
+    m_PatternRowStart[i+1] = static_cast<unsigned int>( m_PatternColumns.size() );
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::ClearSparsityPattern()
+{
+  m_PatternRowStart.clear();
+  m_PatternColumns.clear();
+}
+
+
+
+/* -----------------------------------------------------------------
+ *
+ * Memory management
+ *
+ * -----------------------------------------------------------------
+ */
+
+void LinearSystemWrapperCSR::InitializeMatrix(unsigned int matrixIndex)
+{
+  if (m_Order == 0)
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, "LinearSystemWrapperCSR::InitializeMatrix", "System order not set");
+  }
+  if (matrixIndex >= m_NumberOfMatrices)
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::InitializeMatrix", "m_Matrices", matrixIndex);
+  }
+
+  if (m_Matrices == 0)
+  {
+    m_Matrices = new MatrixHolder(m_NumberOfMatrices, static_cast<MatrixRepresentation*>(0));
+  }
+  else if (m_Matrices->size() < m_NumberOfMatrices)
+  {
+    m_Matrices->resize(m_NumberOfMatrices, static_cast<MatrixRepresentation*>(0));
+  }
+
+  if ( (*m_Matrices)[matrixIndex] == 0 )
+  {
+    (*m_Matrices)[matrixIndex] = new MatrixRepresentation;
+  }
+  MatrixRepresentation *A = (*m_Matrices)[matrixIndex];
+
+  if ( this->HasSparsityPattern() )
+  {
+    A->m_RowStart = m_PatternRowStart;
+    A->m_Columns = m_PatternColumns;
+  }
+  else
+  {
+    A->m_RowStart.assign(m_Order+1, 0);
+    A->m_Columns.clear();
+  }
+  A->m_Values.assign(A->m_Columns.size(), 0.0);
+  A->m_Overflow.clear();
+  A->m_Overflow.resize(m_Order);
+
+  if (matrixIndex == 0)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+}
+
+
+
+bool LinearSystemWrapperCSR::IsMatrixInitialized(unsigned int matrixIndex)
+{
+  if (m_Matrices == 0) return false;
+  if (matrixIndex >= m_Matrices->size()) return false;
+  if ( (*m_Matrices)[matrixIndex] == 0 ) return false;
+
+  return true;
+}
+
+
+
+void LinearSystemWrapperCSR::DestroyMatrix(unsigned int matrixIndex)
+{
+  if (m_Matrices == 0) return;
+  if (matrixIndex >= m_Matrices->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::DestroyMatrix", "m_Matrices", matrixIndex);
+  }
+  delete (*m_Matrices)[matrixIndex];
+  (*m_Matrices)[matrixIndex] = 0;
+
+  if (matrixIndex == 0)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::InitializeVector(unsigned int vectorIndex)
+{
+  if (m_Order == 0)
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, "LinearSystemWrapperCSR::InitializeVector", "System order not set");
+  }
+  if (vectorIndex >= m_NumberOfVectors)
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::InitializeVector", "m_Vectors", vectorIndex);
+  }
+
+  if (m_Vectors == 0)
+  {
+    m_Vectors = new VectorHolder(m_NumberOfVectors, static_cast<VectorRepresentation*>(0));
+  }
+  else if (m_Vectors->size() < m_NumberOfVectors)
+  {
+    m_Vectors->resize(m_NumberOfVectors, static_cast<VectorRepresentation*>(0));
+  }
+
+  if ( (*m_Vectors)[vectorIndex] == 0 )
+  {
+    (*m_Vectors)[vectorIndex] = new VectorRepresentation;
+  }
+  (*m_Vectors)[vectorIndex]->assign(m_Order, 0.0);
+}
+
+
+
+bool LinearSystemWrapperCSR::IsVectorInitialized(unsigned int vectorIndex)
+{
+  if (m_Vectors == 0) return false;
+  if (vectorIndex >= m_Vectors->size()) return false;
+  if ( (*m_Vectors)[vectorIndex] == 0 ) return false;
+
+  return true;
+}
+
+
+
+void LinearSystemWrapperCSR::DestroyVector(unsigned int vectorIndex)
+{
+  if (m_Vectors == 0) return;
+  if (vectorIndex >= m_Vectors->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::DestroyVector", "m_Vectors", vectorIndex);
+  }
+  delete (*m_Vectors)[vectorIndex];
+  (*m_Vectors)[vectorIndex] = 0;
+}
+
+
+
+void LinearSystemWrapperCSR::InitializeSolution(unsigned int solutionIndex)
+{
+  if (m_Order == 0)
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, "LinearSystemWrapperCSR::InitializeSolution", "System order not set");
+  }
+  if (solutionIndex >= m_NumberOfSolutions)
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::InitializeSolution", "m_Solutions", solutionIndex);
+  }
+
+  if (m_Solutions == 0)
+  {
+    m_Solutions = new VectorHolder(m_NumberOfSolutions, static_cast<VectorRepresentation*>(0));
+  }
+  else if (m_Solutions->size() < m_NumberOfSolutions)
+  {
+    m_Solutions->resize(m_NumberOfSolutions, static_cast<VectorRepresentation*>(0));
+  }
+
+  if ( (*m_Solutions)[solutionIndex] == 0 )
+  {
+    (*m_Solutions)[solutionIndex] = new VectorRepresentation;
+  }
+  (*m_Solutions)[solutionIndex]->assign(m_Order, 0.0);
+}
+
+
+
+bool LinearSystemWrapperCSR::IsSolutionInitialized(unsigned int solutionIndex)
+{
+  if (m_Solutions == 0) return false;
+  if (solutionIndex >= m_Solutions->size()) return false;
+  if ( (*m_Solutions)[solutionIndex] == 0 ) return false;
+
+  return true;
+}
+
+
+
+void LinearSystemWrapperCSR::DestroySolution(unsigned int solutionIndex)
+{
+  if (m_Solutions == 0) return;
+  if (solutionIndex >= m_Solutions->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::DestroySolution", "m_Solutions", solutionIndex);
+  }
+  delete (*m_Solutions)[solutionIndex];
+  (*m_Solutions)[solutionIndex] = 0;
+}
+
+
+
+LinearSystemWrapperCSR::MatrixRepresentation*
+LinearSystemWrapperCSR::GetMatrix(unsigned int matrixIndex, const char *location) const
+{
+  if (m_Matrices == 0)
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, location, "No matrices have been allocated");
+  }
+  if (matrixIndex >= m_Matrices->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, location, "m_Matrices", matrixIndex);
+  }
+  if ( (*m_Matrices)[matrixIndex] == 0 )
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, location, "Indexed matrix not yet allocated");
+  }
+  return (*m_Matrices)[matrixIndex];
+}
+
+
+
+LinearSystemWrapperCSR::VectorRepresentation*
+LinearSystemWrapperCSR::GetVector(const VectorHolder* holder, unsigned int index,
+  unsigned int numberOfVectors, const char *location, const char *name) const
+{
+  if (holder == 0)
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, location, "No vectors have been allocated");
+  }
+  if (index >= numberOfVectors || index >= holder->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, location, name, index);
+  }
+  if ( (*holder)[index] == 0 )
+  {
+    throw FEMExceptionLinearSystem(__FILE__, __LINE__, location, "Indexed vector not yet allocated");
+  }
+  return (*holder)[index];
+}
+
+
+
+/* -----------------------------------------------------------------
+ *
+ * Element access
+ *
+ * -----------------------------------------------------------------
+ */
+
+long LinearSystemWrapperCSR::FindEntry(const MatrixRepresentation& A, unsigned int i, unsigned int j)
+{
+  ColumnArray::const_iterator first = A.m_Columns.begin() + A.m_RowStart[i];
+  ColumnArray::const_iterator last = A.m_Columns.begin() + A.m_RowStart[i+1];
+  ColumnArray::const_iterator it = std::lower_bound(first, last, j);
+  if (it == last || *it != j)
+  {
+    return -1;
+  }
+  return static_cast<long>( it - A.m_Columns.begin() );
+}
+
+
+
+LinearSystemWrapperCSR::Float
+LinearSystemWrapperCSR::GetMatrixValue(unsigned int i, unsigned int j, unsigned int matrixIndex) const
+{
+  const MatrixRepresentation *A = this->GetMatrix(matrixIndex, "LinearSystemWrapperCSR::GetMatrixValue");
+  if (i >= m_Order || j >= m_Order)
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::GetMatrixValue", "m_Matrices[]", i, j);
+  }
+
+  long k = FindEntry(*A, i, j);
+  if (k >= 0)
+  {
+    return A->m_Values[k];
+  }
+  std::map<unsigned int, Float>::const_iterator it = A->m_Overflow[i].find(j);
+  if (it != A->m_Overflow[i].end())
+  {
+    return it->second;
+  }
+  return 0.0;
+}
+
+
+
+void LinearSystemWrapperCSR::SetMatrixValue(unsigned int i, unsigned int j, Float value, unsigned int matrixIndex)
+{
+  MatrixRepresentation *A = this->GetMatrix(matrixIndex, "LinearSystemWrapperCSR::SetMatrixValue");
+  if (i >= m_Order || j >= m_Order)
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::SetMatrixValue", "m_Matrices[]", i, j);
+  }
+
+  // the flag is only written once, so that concurrent assembly does not race on it
+  if (matrixIndex == 0 && !m_PreconditionerIsDirty)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+
+  long k = FindEntry(*A, i, j);
+  if (k >= 0)
+  {
+    A->m_Values[k] = value;
+  }
+  else if (value != 0.0 || A->m_Overflow[i].find(j) != A->m_Overflow[i].end())
+  {
+    A->m_Overflow[i][j] = value;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::AddMatrixValue(unsigned int i, unsigned int j, Float value, unsigned int matrixIndex)
+{
+  MatrixRepresentation *A = this->GetMatrix(matrixIndex, "LinearSystemWrapperCSR::AddMatrixValue");
+  if (i >= m_Order || j >= m_Order)
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::AddMatrixValue", "m_Matrices[]", i, j);
+  }
+
+  // the flag is only written once, so that concurrent assembly does not race on it
+  if (matrixIndex == 0 && !m_PreconditionerIsDirty)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+
+  long k = FindEntry(*A, i, j);
+  if (k >= 0)
+  {
+    A->m_Values[k] += value;
+  }
+  else if (value != 0.0)
+  {
+    A->m_Overflow[i][j] += value;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::GetColumnsOfNonZeroMatrixElementsInRow( unsigned int row, ColumnArray& cols, unsigned int matrixIndex )
+{
+  const MatrixRepresentation *A = this->GetMatrix(matrixIndex, "LinearSystemWrapperCSR::GetColumnsOfNonZeroMatrixElementsInRow");
+  if (row >= m_Order)
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::GetColumnsOfNonZeroMatrixElementsInRow", "m_Matrices[]", row);
+  }
+
+  cols.assign(A->m_Columns.begin() + A->m_RowStart[row], A->m_Columns.begin() + A->m_RowStart[row+1]);
+  if ( !A->m_Overflow[row].empty() )
+  {
+    for (std::map<unsigned int, Float>::const_iterator it = A->m_Overflow[row].begin(); it != A->m_Overflow[row].end(); ++it)
+    {
+      cols.push_back(it->first);
+    }
+    std::sort(cols.begin(), cols.end());
+  }
+}
+
+
+
+LinearSystemWrapperCSR::Float
+LinearSystemWrapperCSR::GetVectorValue(unsigned int i, unsigned int vectorIndex) const
+{
+  const VectorRepresentation *v = this->GetVector(m_Vectors, vectorIndex, m_NumberOfVectors, "LinearSystemWrapperCSR::GetVectorValue", "m_Vectors");
+  if (i >= v->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::GetVectorValue", "m_Vectors[]", i);
+  }
+  return (*v)[i];
+}
+
+
+
+void LinearSystemWrapperCSR::SetVectorValue(unsigned int i, Float value, unsigned int vectorIndex)
+{
+  VectorRepresentation *v = this->GetVector(m_Vectors, vectorIndex, m_NumberOfVectors, "LinearSystemWrapperCSR::SetVectorValue", "m_Vectors");
+  if (i >= v->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::SetVectorValue", "m_Vectors[]", i);
+  }
+  (*v)[i] = value;
+}
+
+
+
+void LinearSystemWrapperCSR::AddVectorValue(unsigned int i, Float value, unsigned int vectorIndex)
+{
+  VectorRepresentation *v = this->GetVector(m_Vectors, vectorIndex, m_NumberOfVectors, "LinearSystemWrapperCSR::AddVectorValue", "m_Vectors");
+  if (i >= v->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::AddVectorValue", "m_Vectors[]", i);
+  }
+  (*v)[i] += value;
+}
+
+
+
+LinearSystemWrapperCSR::Float
+LinearSystemWrapperCSR::GetSolutionValue(unsigned int i, unsigned int solutionIndex) const
+{
+  if (m_Solutions == 0) return 0.0;
+  if (solutionIndex >= m_Solutions->size()) return 0.0;
+  if ( (*m_Solutions)[solutionIndex] == 0 ) return 0.0;
+  if (i >= (*m_Solutions)[solutionIndex]->size()) return 0.0;
+
+  return (*((*m_Solutions)[solutionIndex]))[i];
+}
+
+
+
+void LinearSystemWrapperCSR::SetSolutionValue(unsigned int i, Float value, unsigned int solutionIndex)
+{
+  VectorRepresentation *v = this->GetVector(m_Solutions, solutionIndex, m_NumberOfSolutions, "LinearSystemWrapperCSR::SetSolutionValue", "m_Solutions");
+  if (i >= v->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::SetSolutionValue", "m_Solutions[]", i);
+  }
+  (*v)[i] = value;
+}
+
+
+
+void LinearSystemWrapperCSR::AddSolutionValue(unsigned int i, Float value, unsigned int solutionIndex)
+{
+  VectorRepresentation *v = this->GetVector(m_Solutions, solutionIndex, m_NumberOfSolutions, "LinearSystemWrapperCSR::AddSolutionValue", "m_Solutions");
+  if (i >= v->size())
+  {
+    throw FEMExceptionLinearSystemBounds(__FILE__, __LINE__, "LinearSystemWrapperCSR::AddSolutionValue", "m_Solutions[]", i);
+  }
+  (*v)[i] += value;
+}
+
+
+
+/* -----------------------------------------------------------------
+ *
+ * Matrix & vector manipulation
+ *
+ * -----------------------------------------------------------------
+ */
+
+void LinearSystemWrapperCSR::CompressMatrix(unsigned int matrixIndex)
+{
+  MatrixRepresentation *A = this->GetMatrix(matrixIndex, "LinearSystemWrapperCSR::CompressMatrix");
+
+  const unsigned int N = static_cast<unsigned int>( A->m_RowStart.size() ) - 1;
+  unsigned long numberOfOverflowEntries = 0;
+  unsigned int i;
+  for (i=0; i<N; i++)
+  {
+    numberOfOverflowEntries += A->m_Overflow[i].size();
+  }
+  if (numberOfOverflowEntries == 0)
+  {
+    return;
+  }
+
+  ColumnArray rowStart(N+1, 0);
+  ColumnArray columns;
+  VectorRepresentation values;
+  columns.reserve(A->m_Columns.size() + numberOfOverflowEntries);
+  values.reserve(A->m_Columns.size() + numberOfOverflowEntries);
+
+  for (i=0; i<N; i++)
+  {
+    // merge the two sorted lists; overflow entries are never in the pattern
+    unsigned int k = A->m_RowStart[i];
+    const unsigned int kend = A->m_RowStart[i+1];
+    std::map<unsigned int, Float>::const_iterator it = A->m_Overflow[i].begin();
+    while (k < kend || it != A->m_Overflow[i].end())
+    {
+      if ( it == A->m_Overflow[i].end() || (k < kend && A->m_Columns[k] < it->first) )
+      {
+        columns.push_back(A->m_Columns[k]);
+        values.push_back(A->m_Values[k]);
+        k++;
+      }
+      else
+      {
+        columns.push_back(it->first);
+        values.push_back(it->second);
+        ++it;
+      }
+    }
+    A->m_Overflow[i].clear();
+    rowStart[i+1] = static_cast<unsigned int>( columns.size() );
+  }
+
+  A->m_RowStart.swap(rowStart);
+  A->m_Columns.swap(columns);
+  A->m_Values.swap(values);
+}
+
+
+
+void LinearSystemWrapperCSR::ScaleMatrix(Float scale, unsigned int matrixIndex)
+{
+  this->CompressMatrix(matrixIndex);
+  MatrixRepresentation *A = this->GetMatrix(matrixIndex, "LinearSystemWrapperCSR::ScaleMatrix");
+  if (matrixIndex == 0)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+  for (VectorRepresentation::iterator it = A->m_Values.begin(); it != A->m_Values.end(); ++it)
+  {
+    *it *= scale;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::SwapMatrices(unsigned int matrixIndex1, unsigned int matrixIndex2)
+{
+  this->GetMatrix(matrixIndex1, "LinearSystemWrapperCSR::SwapMatrices");
+  this->GetMatrix(matrixIndex2, "LinearSystemWrapperCSR::SwapMatrices");
+  std::swap( (*m_Matrices)[matrixIndex1], (*m_Matrices)[matrixIndex2] );
+  if (matrixIndex1 == 0 || matrixIndex2 == 0)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::CopyMatrix(unsigned int matrixIndex1, unsigned int matrixIndex2)
+{
+  this->CompressMatrix(matrixIndex1);
+  const MatrixRepresentation *A = this->GetMatrix(matrixIndex1, "LinearSystemWrapperCSR::CopyMatrix");
+  if ( !this->IsMatrixInitialized(matrixIndex2) )
+  {
+    this->InitializeMatrix(matrixIndex2);
+  }
+  *((*m_Matrices)[matrixIndex2]) = *A;
+  if (matrixIndex2 == 0)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::AddMatrixMatrix(unsigned int matrixIndex1, unsigned int matrixIndex2)
+{
+  this->CompressMatrix(matrixIndex1);
+  this->CompressMatrix(matrixIndex2);
+  MatrixRepresentation *A = this->GetMatrix(matrixIndex1, "LinearSystemWrapperCSR::AddMatrixMatrix");
+  const MatrixRepresentation *B = this->GetMatrix(matrixIndex2, "LinearSystemWrapperCSR::AddMatrixMatrix");
+  if (matrixIndex1 == 0)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+
+  if (A->m_RowStart == B->m_RowStart && A->m_Columns == B->m_Columns)
+  {
+    for (unsigned int k=0; k<A->m_Values.size(); k++)
+    {
+      A->m_Values[k] += B->m_Values[k];
+    }
+    return;
+  }
+
+  for (unsigned int i=0; i<m_Order; i++)
+  {
+    for (unsigned int k=B->m_RowStart[i]; k<B->m_RowStart[i+1]; k++)
+    {
+      this->AddMatrixValue(i, B->m_Columns[k], B->m_Values[k], matrixIndex1);
+    }
+  }
+  this->CompressMatrix(matrixIndex1);
+}
+
+
+
+void LinearSystemWrapperCSR::SwapVectors(unsigned int vectorIndex1, unsigned int vectorIndex2)
+{
+  this->GetVector(m_Vectors, vectorIndex1, m_NumberOfVectors, "LinearSystemWrapperCSR::SwapVectors", "m_Vectors");
+  this->GetVector(m_Vectors, vectorIndex2, m_NumberOfVectors, "LinearSystemWrapperCSR::SwapVectors", "m_Vectors");
+  std::swap( (*m_Vectors)[vectorIndex1], (*m_Vectors)[vectorIndex2] );
+}
+
+
+
+void LinearSystemWrapperCSR::SwapSolutions(unsigned int solutionIndex1, unsigned int solutionIndex2)
+{
+  this->GetVector(m_Solutions, solutionIndex1, m_NumberOfSolutions, "LinearSystemWrapperCSR::SwapSolutions", "m_Solutions");
+  this->GetVector(m_Solutions, solutionIndex2, m_NumberOfSolutions, "LinearSystemWrapperCSR::SwapSolutions", "m_Solutions");
+  std::swap( (*m_Solutions)[solutionIndex1], (*m_Solutions)[solutionIndex2] );
+}
+
+
+
+void LinearSystemWrapperCSR::CopySolution2Vector(unsigned int solutionIndex, unsigned int vectorIndex)
+{
+  const VectorRepresentation *s = this->GetVector(m_Solutions, solutionIndex, m_NumberOfSolutions, "LinearSystemWrapperCSR::CopySolution2Vector", "m_Solutions");
+  if ( !this->IsVectorInitialized(vectorIndex) )
+  {
+    this->InitializeVector(vectorIndex);
+  }
+  *((*m_Vectors)[vectorIndex]) = *s;
+}
+
+
+
+void LinearSystemWrapperCSR::CopyVector2Solution(unsigned int vectorIndex, unsigned int solutionIndex)
+{
+  const VectorRepresentation *v = this->GetVector(m_Vectors, vectorIndex, m_NumberOfVectors, "LinearSystemWrapperCSR::CopyVector2Solution", "m_Vectors");
+  if ( !this->IsSolutionInitialized(solutionIndex) )
+  {
+    this->InitializeSolution(solutionIndex);
+  }
+  *((*m_Solutions)[solutionIndex]) = *v;
+}
+
+
+
+void LinearSystemWrapperCSR::MultiplyMatrixMatrix(unsigned int resultMatrixIndex, unsigned int leftMatrixIndex, unsigned int rightMatrixIndex)
+{
+  this->CompressMatrix(leftMatrixIndex);
+  this->CompressMatrix(rightMatrixIndex);
+  const MatrixRepresentation *L = this->GetMatrix(leftMatrixIndex, "LinearSystemWrapperCSR::MultiplyMatrixMatrix");
+  const MatrixRepresentation *R = this->GetMatrix(rightMatrixIndex, "LinearSystemWrapperCSR::MultiplyMatrixMatrix");
+
+  const unsigned int N = m_Order;
+  MatrixRepresentation C;
+  C.m_RowStart.assign(N+1, 0);
+  C.m_Overflow.resize(N);
+
+  // row by row product with a dense accumulator
+  VectorRepresentation accumulator(N, 0.0);
+  std::vector<unsigned int> marker(N, N);
+  ColumnArray row;
+  for (unsigned int i=0; i<N; i++)
+  {
+    row.clear();
+    for (unsigned int k=L->m_RowStart[i]; k<L->m_RowStart[i+1]; k++)
+    {
+      const unsigned int m = L->m_Columns[k];
+      const Float lv = L->m_Values[k];
+      for (unsigned int q=R->m_RowStart[m]; q<R->m_RowStart[m+1]; q++)
+      {
+        const unsigned int j = R->m_Columns[q];
+        if (marker[j] != i)
+        {
+          marker[j] = i;
+          accumulator[j] = 0.0;
+          row.push_back(j);
+        }
+        accumulator[j] += lv * R->m_Values[q];
+      }
+    }
+    std::sort(row.begin(), row.end());
+    for (unsigned int r=0; r<row.size(); r++)
+    {
+      C.m_Columns.push_back(row[r]);
+      C.m_Values.push_back(accumulator[row[r]]);
+    }
+    C.m_RowStart[i+1] = static_cast<unsigned int>( C.m_Columns.size() );
+  }
+
+  if ( !this->IsMatrixInitialized(resultMatrixIndex) )
+  {
+    this->InitializeMatrix(resultMatrixIndex);
+  }
+  *((*m_Matrices)[resultMatrixIndex]) = C;
+  if (resultMatrixIndex == 0)
+  {
+    m_PreconditionerIsDirty = true;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::MultiplyMatrixVector(unsigned int resultVectorIndex, unsigned int matrixIndex, unsigned int vectorIndex)
+{
+  this->CompressMatrix(matrixIndex);
+  const MatrixRepresentation *A = this->GetMatrix(matrixIndex, "LinearSystemWrapperCSR::MultiplyMatrixVector");
+  const VectorRepresentation *x = this->GetVector(m_Vectors, vectorIndex, m_NumberOfVectors, "LinearSystemWrapperCSR::MultiplyMatrixVector", "m_Vectors");
+
+  if (resultVectorIndex == vectorIndex)
+  {
+    VectorRepresentation input(*x);
+    this->ThreadedMatrixVectorProduct(*A, input, *((*m_Vectors)[resultVectorIndex]));
+    return;
+  }
+  if ( !this->IsVectorInitialized(resultVectorIndex) )
+  {
+    this->InitializeVector(resultVectorIndex);
+  }
+  this->ThreadedMatrixVectorProduct(*A, *x, *((*m_Vectors)[resultVectorIndex]));
+}
+
+
+
+/* -----------------------------------------------------------------
+ *
+ * Threaded kernels
+ *
+ * -----------------------------------------------------------------
+ */
+
+void LinearSystemWrapperCSR::GetThreadRowRange(unsigned int threadId, unsigned int n,
+  unsigned int& start, unsigned int& end) const
+{
+  const unsigned int chunk = n / m_NumberOfThreads;
+  const unsigned int remainder = n % m_NumberOfThreads;
+  start = threadId * chunk + ( threadId < remainder ? threadId : remainder );
+  end = start + chunk + ( threadId < remainder ? 1 : 0 );
+}
+
+
+
+ITK_THREAD_RETURN_TYPE LinearSystemWrapperCSR::ThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast<MultiThreader::ThreadInfoStruct *>(arg);
+  const unsigned int threadId = info->ThreadID;
+  Self *self = static_cast<Self *>(info->UserData);
+
+  unsigned int start, end;
+  self->GetThreadRowRange(threadId, self->m_ThreadRows, start, end);
+  self->ExecuteOperation(threadId, start, end);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+
+LinearSystemWrapperCSR::Float
+LinearSystemWrapperCSR::ThreadedExecute(ThreadOperationType operation, unsigned int rows)
+{
+  m_ThreadOperation = operation;
+  m_ThreadRows = rows;
+  m_ThreadPartialSums.assign(m_NumberOfThreads, 0.0);
+
+  if (m_NumberOfThreads <= 1 || rows < CSRMinimumRowsPerThreadedCall)
+  {
+    this->ExecuteOperation(0, 0, rows);
+  }
+  else
+  {
+    m_Threader->SetNumberOfThreads(m_NumberOfThreads);
+    m_Threader->SetSingleMethod(ThreaderCallback, this);
+    m_Threader->SingleMethodExecute();
+  }
+
+  Float sum = 0.0;
+  for (unsigned int t=0; t<m_ThreadPartialSums.size(); t++)
+  {
+    sum += m_ThreadPartialSums[t];
+  }
+  return sum;
+}
+
+
+
+void LinearSystemWrapperCSR::ExecuteOperation(unsigned int threadId, unsigned int start, unsigned int end)
+{
+  Float partial = 0.0;
+  unsigned int i, k;
+
+  switch (m_ThreadOperation)
+  {
+    case MatrixVectorProductOperation:
+    {
+      // y = A x, partial = x.y
+      const MatrixRepresentation& A = *m_ThreadMatrix;
+      const VectorRepresentation& x = *m_ThreadInput1;
+      VectorRepresentation& y = *m_ThreadOutput1;
+      for (i=start; i<end; i++)
+      {
+        Float sum = 0.0;
+        for (k=A.m_RowStart[i]; k<A.m_RowStart[i+1]; k++)
+        {
+          sum += A.m_Values[k] * x[A.m_Columns[k]];
+        }
+        y[i] = sum;
+        partial += x[i] * sum;
+      }
+      break;
+    }
+    case ResidualOperation:
+    {
+      // r = b - A x, partial = r.r
+      const MatrixRepresentation& A = *m_ThreadMatrix;
+      const VectorRepresentation& x = *m_ThreadInput1;
+      const VectorRepresentation& b = *m_ThreadInput2;
+      VectorRepresentation& r = *m_ThreadOutput1;
+      for (i=start; i<end; i++)
+      {
+        Float sum = b[i];
+        for (k=A.m_RowStart[i]; k<A.m_RowStart[i+1]; k++)
+        {
+          sum -= A.m_Values[k] * x[A.m_Columns[k]];
+        }
+        r[i] = sum;
+        partial += sum * sum;
+      }
+      break;
+    }
+    case UpdateSolutionOperation:
+    {
+      // x += alpha p, r -= alpha q, partial = r.r
+      const VectorRepresentation& p = *m_ThreadInput1;
+      const VectorRepresentation& q = *m_ThreadInput2;
+      VectorRepresentation& x = *m_ThreadOutput1;
+      VectorRepresentation& r = *m_ThreadOutput2;
+      const Float alpha = m_ThreadScalar;
+      for (i=start; i<end; i++)
+      {
+        x[i] += alpha * p[i];
+        r[i] -= alpha * q[i];
+        partial += r[i] * r[i];
+      }
+      break;
+    }
+    case JacobiOperation:
+    {
+      // z = D^-1 r, partial = r.z
+      const VectorRepresentation& r = *m_ThreadInput1;
+      const VectorRepresentation& d = *m_ThreadInput2;
+      VectorRepresentation& z = *m_ThreadOutput1;
+      for (i=start; i<end; i++)
+      {
+        z[i] = d[i] * r[i];
+        partial += r[i] * z[i];
+      }
+      break;
+    }
+    case UpdateDirectionOperation:
+    {
+      // p = z + beta p
+      const VectorRepresentation& z = *m_ThreadInput1;
+      VectorRepresentation& p = *m_ThreadOutput1;
+      const Float beta = m_ThreadScalar;
+      for (i=start; i<end; i++)
+      {
+        p[i] = z[i] + beta * p[i];
+      }
+      break;
+    }
+    case DotProductOperation:
+    {
+      const VectorRepresentation& a = *m_ThreadInput1;
+      const VectorRepresentation& b = *m_ThreadInput2;
+      for (i=start; i<end; i++)
+      {
+        partial += a[i] * b[i];
+      }
+      break;
+    }
+  }
+
+  m_ThreadPartialSums[threadId] = partial;
+}
+
+
+
+void LinearSystemWrapperCSR::ThreadedMatrixVectorProduct(const MatrixRepresentation& A,
+  const VectorRepresentation& x, VectorRepresentation& y)
+{
+  const unsigned int n = static_cast<unsigned int>( A.m_RowStart.size() ) - 1;
+  y.resize(n);
+  m_ThreadMatrix = &A;
+  m_ThreadInput1 = &x;
+  m_ThreadOutput1 = &y;
+  this->ThreadedExecute(MatrixVectorProductOperation, n);
+}
+
+
+
+/* -----------------------------------------------------------------
+ *
+ * Preconditioners
+ *
+ * -----------------------------------------------------------------
+ */
+
+void LinearSystemWrapperCSR::InitializePreconditioner()
+{
+  const MatrixRepresentation& A = *((*m_Matrices)[0]);
+  const unsigned int N = m_Order;
+
+  m_InverseDiagonal.assign(N, 1.0);
+  for (unsigned int i=0; i<N; i++)
+  {
+    long k = FindEntry(A, i, i);
+    if (k >= 0 && A.m_Values[k] != 0.0)
+    {
+      m_InverseDiagonal[i] = 1.0 / A.m_Values[k];
+    }
+  }
+
+  m_CholeskyFactor = MatrixRepresentation();
+  m_MultigridLevels.clear();
+  m_CoarsestFactor.clear();
+  m_CoarsestOrder = 0;
+
+  delete m_DirectSolver;
+  m_DirectSolver = 0;
+
+  // the Lagrange multiplier rows of the MFCs have a zero diagonal, such
+  // systems are indefinite and go to the direct solver
+  m_UseDirectSolver = !this->HasPositiveDiagonal(A);
+  if (m_UseDirectSolver)
+  {
+    this->FactorDirectSolver(A);
+    return;
+  }
+
+  switch (m_Preconditioner)
+  {
+    case IncompleteCholeskyPreconditioner:
+      this->FactorIncompleteCholesky(A);
+      break;
+    case AlgebraicMultigridPreconditioner:
+      this->BuildMultigridHierarchy(A);
+      break;
+    case JacobiPreconditioner:
+    default:
+      break;
+  }
+}
+
+
+
+bool LinearSystemWrapperCSR::HasPositiveDiagonal(const MatrixRepresentation& A) const
+{
+  for (unsigned int i=0; i<m_Order; i++)
+  {
+    long k = FindEntry(A, i, i);
+    if (k < 0 || !(A.m_Values[k] > 0.0))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+
+void LinearSystemWrapperCSR::FactorDirectSolver(const MatrixRepresentation& A)
+{
+  const unsigned int N = m_Order;
+
+  vnl_sparse_matrix<double> M(N, N);
+  for (unsigned int i=0; i<N; i++)
+  {
+    const unsigned int start = A.m_RowStart[i];
+    const unsigned int end = A.m_RowStart[i+1];
+    std::vector<int> cols;
+    std::vector<double> vals;
+    cols.reserve(end-start);
+    vals.reserve(end-start);
+    for (unsigned int k=start; k<end; k++)
+    {
+      if (A.m_Values[k] != 0.0)
+      {
+        cols.push_back( static_cast<int>( A.m_Columns[k] ) );
+        vals.push_back( A.m_Values[k] );
+      }
+    }
+    M.set_row(i, cols, vals);
+  }
+
+  delete m_DirectSolver;
+  m_DirectSolver = new vnl_sparse_lu(M);
+}
+
+
+
+void LinearSystemWrapperCSR::DirectSolve(const VectorRepresentation& b, VectorRepresentation& x)
+{
+  const unsigned int N = m_Order;
+
+  vnl_vector<double> rhs(N);
+  for (unsigned int i=0; i<N; i++)
+  {
+    rhs[i] = b[i];
+  }
+  vnl_vector<double> solution(N);
+  m_DirectSolver->solve(rhs, &solution);
+  for (unsigned int i=0; i<N; i++)
+  {
+    x[i] = solution[i];
+  }
+
+  m_NumberOfIterationsPerformed = 0;
+  m_FinalRelativeResidual = 0.0;
+}
+
+
+
+void LinearSystemWrapperCSR::FactorIncompleteCholesky(const MatrixRepresentation& A)
+{
+  const unsigned int N = m_Order;
+  unsigned int i, k;
+
+  /*
+   * The factor keeps the lower triangle of A including the diagonal, which
+   * is the last entry of each row since the columns are sorted.
+   */
+  MatrixRepresentation& L = m_CholeskyFactor;
+  L.m_RowStart.assign(N+1, 0);
+  L.m_Columns.clear();
+  L.m_Values.clear();
+  VectorRepresentation diagonal(N, 0.0);
+  for (i=0; i<N; i++)
+  {
+    for (k=A.m_RowStart[i]; k<A.m_RowStart[i+1]; k++)
+    {
+      const unsigned int j = A.m_Columns[k];
+      if (j < i)
+      {
+        L.m_Columns.push_back(j);
+        L.m_Values.push_back(A.m_Values[k]);
+      }
+      else if (j == i)
+      {
+        diagonal[i] = A.m_Values[k];
+      }
+    }
+    L.m_Columns.push_back(i);
+    L.m_Values.push_back(diagonal[i]);
+    L.m_RowStart[i+1] = static_cast<unsigned int>( L.m_Columns.size() );
+  }
+  const VectorRepresentation original(L.m_Values);
+
+  /*
+   * IC(0) may break down for matrices that are not M-matrices. In that case
+   * the factorization is restarted with a growing diagonal shift.
+   */
+  Float shift = 0.0;
+  for (unsigned int attempt=0; attempt<10; attempt++)
+  {
+    L.m_Values = original;
+    if (shift > 0.0)
+    {
+      for (i=0; i<N; i++)
+      {
+        L.m_Values[L.m_RowStart[i+1]-1] *= (1.0 + shift);
+      }
+    }
+
+    bool breakdown = false;
+    for (i=0; i<N && !breakdown; i++)
+    {
+      const unsigned int rowBegin = L.m_RowStart[i];
+      const unsigned int rowDiagonal = L.m_RowStart[i+1]-1;
+      for (k=rowBegin; k<rowDiagonal; k++)
+      {
+        const unsigned int j = L.m_Columns[k];
+        // sum over the common columns c < j of L(i,c) L(j,c)
+        Float sum = L.m_Values[k];
+        unsigned int a = rowBegin;
+        unsigned int b = L.m_RowStart[j];
+        const unsigned int bend = L.m_RowStart[j+1]-1;
+        while (a < k && b < bend)
+        {
+          if (L.m_Columns[a] == L.m_Columns[b])
+          {
+            sum -= L.m_Values[a] * L.m_Values[b];
+            a++;
+            b++;
+          }
+          else if (L.m_Columns[a] < L.m_Columns[b])
+          {
+            a++;
+          }
+          else
+          {
+            b++;
+          }
+        }
+        L.m_Values[k] = sum / L.m_Values[L.m_RowStart[j+1]-1];
+      }
+      Float d = L.m_Values[rowDiagonal];
+      for (k=rowBegin; k<rowDiagonal; k++)
+      {
+        d -= L.m_Values[k] * L.m_Values[k];
+      }
+      if (d <= 0.0)
+      {
+        breakdown = true;
+      }
+      else
+      {
+        L.m_Values[rowDiagonal] = sqrt(d);
+      }
+    }
+    if (!breakdown)
+    {
+      return;
+    }
+    shift = (shift == 0.0) ? 1.e-3 : 2.0 * shift;
+  }
+
+  throw FEMExceptionLinearSystem(__FILE__, __LINE__, "LinearSystemWrapperCSR::FactorIncompleteCholesky", "Incomplete Cholesky factorization failed, matrix is not positive definite");
+}
+
+
+
+void LinearSystemWrapperCSR::BuildMultigridHierarchy(const MatrixRepresentation& A)
+{
+  const Float strengthThreshold = 0.08;
+  const unsigned int maximumNumberOfLevels = 10;
+
+  m_MultigridLevels.clear();
+  m_MultigridLevels.push_back(MultigridLevel());
+
+  unsigned int level = 0;
+  while (true)
+  {
+    const MatrixRepresentation& Al = (level == 0) ? A : m_MultigridLevels[level].m_Matrix;
+    const unsigned int n = static_cast<unsigned int>( Al.m_RowStart.size() ) - 1;
+    unsigned int i, k;
+
+    VectorRepresentation diagonal(n, 0.0);
+    m_MultigridLevels[level].m_InverseDiagonal.assign(n, 1.0);
+    for (i=0; i<n; i++)
+    {
+      long d = FindEntry(Al, i, i);
+      if (d >= 0 && Al.m_Values[d] != 0.0)
+      {
+        diagonal[i] = Al.m_Values[d];
+        m_MultigridLevels[level].m_InverseDiagonal[i] = 1.0 / Al.m_Values[d];
+      }
+    }
+    m_MultigridLevels[level].m_X.assign(n, 0.0);
+    m_MultigridLevels[level].m_B.assign(n, 0.0);
+    m_MultigridLevels[level].m_R.assign(n, 0.0);
+
+    if (n <= m_MultigridCoarsestSize || level+1 >= maximumNumberOfLevels)
+    {
+      this->FactorCoarsestLevel(Al);
+      return;
+    }
+
+    /*
+     * Greedy aggregation on the strength of connection graph:
+     * |a_ij| >= theta sqrt(|a_ii a_jj|).
+     */
+    const unsigned int unassigned = n;
+    ColumnArray& aggregate = m_MultigridLevels[level].m_Aggregate;
+    aggregate.assign(n, unassigned);
+    unsigned int numberOfAggregates = 0;
+
+    // pass 1: seed aggregates from rows whose strong neighbors are all free
+    for (i=0; i<n; i++)
+    {
+      if (aggregate[i] != unassigned) continue;
+      bool free = true;
+      for (k=Al.m_RowStart[i]; k<Al.m_RowStart[i+1] && free; k++)
+      {
+        const unsigned int j = Al.m_Columns[k];
+        if (j != i && aggregate[j] != unassigned &&
+            fabs(Al.m_Values[k]) >= strengthThreshold * sqrt(fabs(diagonal[i]*diagonal[j])))
+        {
+          free = false;
+        }
+      }
+      if (!free) continue;
+      aggregate[i] = numberOfAggregates;
+      for (k=Al.m_RowStart[i]; k<Al.m_RowStart[i+1]; k++)
+      {
+        const unsigned int j = Al.m_Columns[k];
+        if (j != i && fabs(Al.m_Values[k]) >= strengthThreshold * sqrt(fabs(diagonal[i]*diagonal[j])))
+        {
+          aggregate[j] = numberOfAggregates;
+        }
+      }
+      numberOfAggregates++;
+    }
+
+    // pass 2: attach remaining rows to a strongly connected aggregate
+    for (i=0; i<n; i++)
+    {
+      if (aggregate[i] != unassigned) continue;
+      Float strongest = 0.0;
+      for (k=Al.m_RowStart[i]; k<Al.m_RowStart[i+1]; k++)
+      {
+        const unsigned int j = Al.m_Columns[k];
+        if (j != i && aggregate[j] != unassigned && aggregate[j] < numberOfAggregates &&
+            fabs(Al.m_Values[k]) > strongest)
+        {
+          strongest = fabs(Al.m_Values[k]);
+          aggregate[i] = aggregate[j];
+        }
+      }
+      // pass 3: isolated rows become their own aggregate
+      if (aggregate[i] == unassigned)
+      {
+        aggregate[i] = numberOfAggregates++;
+      }
+    }
+
+    // stop if coarsening stagnates
+    if (numberOfAggregates == 0 || numberOfAggregates > 0.8 * n)
+    {
+      aggregate.clear();
+      this->FactorCoarsestLevel(Al);
+      return;
+    }
+
+    /*
+     * Galerkin coarse operator with piecewise constant prolongation:
+     * Ac(I,J) = sum_{agg(i)=I, agg(j)=J} a_ij.
+     */
+    MultigridLevel coarse;
+    MatrixRepresentation& Ac = coarse.m_Matrix;
+    Ac.m_RowStart.assign(numberOfAggregates+1, 0);
+    Ac.m_Overflow.resize(numberOfAggregates);
+
+    ColumnArray memberStart(numberOfAggregates+1, 0);
+    for (i=0; i<n; i++)
+    {
+      memberStart[aggregate[i]+1]++;
+    }
+    for (i=0; i<numberOfAggregates; i++)
+    {
+      memberStart[i+1] += memberStart[i];
+    }
+    ColumnArray members(n);
+    ColumnArray fill(memberStart.begin(), memberStart.end()-1);
+    for (i=0; i<n; i++)
+    {
+      members[fill[aggregate[i]]++] = i;
+    }
+
+    VectorRepresentation accumulator(numberOfAggregates, 0.0);
+    std::vector<unsigned int> marker(numberOfAggregates, numberOfAggregates);
+    ColumnArray row;
+    for (unsigned int I=0; I<numberOfAggregates; I++)
+    {
+      row.clear();
+      for (unsigned int m=memberStart[I]; m<memberStart[I+1]; m++)
+      {
+        const unsigned int r = members[m];
+        for (k=Al.m_RowStart[r]; k<Al.m_RowStart[r+1]; k++)
+        {
+          const unsigned int J = aggregate[Al.m_Columns[k]];
+          if (marker[J] != I)
+          {
+            marker[J] = I;
+            accumulator[J] = 0.0;
+            row.push_back(J);
+          }
+          accumulator[J] += Al.m_Values[k];
+        }
+      }
+      std::sort(row.begin(), row.end());
+      for (unsigned int r=0; r<row.size(); r++)
+      {
+        Ac.m_Columns.push_back(row[r]);
+        Ac.m_Values.push_back(accumulator[row[r]]);
+      }
+      Ac.m_RowStart[I+1] = static_cast<unsigned int>( Ac.m_Columns.size() );
+    }
+
+    m_MultigridLevels.push_back(coarse);
+    level++;
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::FactorCoarsestLevel(const MatrixRepresentation& A)
+{
+  const unsigned int n = static_cast<unsigned int>( A.m_RowStart.size() ) - 1;
+  unsigned int i, j, k;
+
+  m_CoarsestOrder = n;
+  m_CoarsestFactor.assign(n*n, 0.0);
+  for (i=0; i<n; i++)
+  {
+    for (k=A.m_RowStart[i]; k<A.m_RowStart[i+1]; k++)
+    {
+      m_CoarsestFactor[i*n + A.m_Columns[k]] = A.m_Values[k];
+    }
+  }
+
+  // dense Cholesky, the lower triangle holds the factor
+  for (j=0; j<n; j++)
+  {
+    Float d = m_CoarsestFactor[j*n+j];
+    for (k=0; k<j; k++)
+    {
+      d -= m_CoarsestFactor[j*n+k] * m_CoarsestFactor[j*n+k];
+    }
+    if (d <= 1.e-12 * fabs(m_CoarsestFactor[j*n+j]) || d <= 0.0)
+    {
+      // singular coarse direction, regularize
+      d = (m_CoarsestFactor[j*n+j] > 0.0) ? 1.e-12 * m_CoarsestFactor[j*n+j] : 1.e-12;
+    }
+    const Float ljj = sqrt(d);
+    m_CoarsestFactor[j*n+j] = ljj;
+    for (i=j+1; i<n; i++)
+    {
+      Float s = m_CoarsestFactor[i*n+j];
+      for (k=0; k<j; k++)
+      {
+        s -= m_CoarsestFactor[i*n+k] * m_CoarsestFactor[j*n+k];
+      }
+      m_CoarsestFactor[i*n+j] = s / ljj;
+    }
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::MultigridVCycle(unsigned int level)
+{
+  MultigridLevel& L = m_MultigridLevels[level];
+  const unsigned int n = static_cast<unsigned int>( L.m_B.size() );
+  unsigned int i;
+
+  if (level+1 == m_MultigridLevels.size())
+  {
+    // coarsest level: forward and backward substitution
+    const unsigned int nc = m_CoarsestOrder;
+    const VectorRepresentation& F = m_CoarsestFactor;
+    VectorRepresentation& x = L.m_X;
+    for (i=0; i<nc; i++)
+    {
+      Float s = L.m_B[i];
+      for (unsigned int k=0; k<i; k++)
+      {
+        s -= F[i*nc+k] * x[k];
+      }
+      x[i] = s / F[i*nc+i];
+    }
+    for (i=nc; i-- > 0; )
+    {
+      Float s = x[i];
+      for (unsigned int k=i+1; k<nc; k++)
+      {
+        s -= F[k*nc+i] * x[k];
+      }
+      x[i] = s / F[i*nc+i];
+    }
+    return;
+  }
+
+  const MatrixRepresentation& A = (level == 0) ? *((*m_Matrices)[0]) : L.m_Matrix;
+  const Float omega = 2.0/3.0;
+  const unsigned int numberOfSweeps = 2;
+  unsigned int sweep;
+
+  // pre-smoothing with damped Jacobi, starting from zero
+  for (i=0; i<n; i++)
+  {
+    L.m_X[i] = omega * L.m_InverseDiagonal[i] * L.m_B[i];
+  }
+  for (sweep=1; sweep<numberOfSweeps; sweep++)
+  {
+    m_ThreadMatrix = &A;
+    m_ThreadInput1 = &L.m_X;
+    m_ThreadInput2 = &L.m_B;
+    m_ThreadOutput1 = &L.m_R;
+    this->ThreadedExecute(ResidualOperation, n);
+    for (i=0; i<n; i++)
+    {
+      L.m_X[i] += omega * L.m_InverseDiagonal[i] * L.m_R[i];
+    }
+  }
+
+  // restrict the residual
+  m_ThreadMatrix = &A;
+  m_ThreadInput1 = &L.m_X;
+  m_ThreadInput2 = &L.m_B;
+  m_ThreadOutput1 = &L.m_R;
+  this->ThreadedExecute(ResidualOperation, n);
+  MultigridLevel& C = m_MultigridLevels[level+1];
+  std::fill(C.m_B.begin(), C.m_B.end(), 0.0);
+  for (i=0; i<n; i++)
+  {
+    C.m_B[L.m_Aggregate[i]] += L.m_R[i];
+  }
+
+  this->MultigridVCycle(level+1);
+
+  // prolongate the correction
+  MultigridLevel& Lp = m_MultigridLevels[level];
+  const MultigridLevel& Cp = m_MultigridLevels[level+1];
+  for (i=0; i<n; i++)
+  {
+    Lp.m_X[i] += Cp.m_X[Lp.m_Aggregate[i]];
+  }
+
+  // post-smoothing
+  for (sweep=0; sweep<numberOfSweeps; sweep++)
+  {
+    m_ThreadMatrix = &A;
+    m_ThreadInput1 = &Lp.m_X;
+    m_ThreadInput2 = &Lp.m_B;
+    m_ThreadOutput1 = &Lp.m_R;
+    this->ThreadedExecute(ResidualOperation, n);
+    for (i=0; i<n; i++)
+    {
+      Lp.m_X[i] += omega * Lp.m_InverseDiagonal[i] * Lp.m_R[i];
+    }
+  }
+}
+
+
+
+void LinearSystemWrapperCSR::ApplyPreconditioner(const VectorRepresentation& r, VectorRepresentation& z)
+{
+  const unsigned int N = m_Order;
+  unsigned int i, k;
+
+  switch (m_Preconditioner)
+  {
+    case IncompleteCholeskyPreconditioner:
+    {
+      const MatrixRepresentation& L = m_CholeskyFactor;
+      // forward substitution L y = r
+      for (i=0; i<N; i++)
+      {
+        Float s = r[i];
+        const unsigned int diag = L.m_RowStart[i+1]-1;
+        for (k=L.m_RowStart[i]; k<diag; k++)
+        {
+          s -= L.m_Values[k] * z[L.m_Columns[k]];
+        }
+        z[i] = s / L.m_Values[diag];
+      }
+      // backward substitution L^T z = y, column oriented
+      for (i=N; i-- > 0; )
+      {
+        const unsigned int diag = L.m_RowStart[i+1]-1;
+        z[i] /= L.m_Values[diag];
+        const Float zi = z[i];
+        for (k=L.m_RowStart[i]; k<diag; k++)
+        {
+          z[L.m_Columns[k]] -= L.m_Values[k] * zi;
+        }
+      }
+      break;
+    }
+    case AlgebraicMultigridPreconditioner:
+    {
+      MultigridLevel& L = m_MultigridLevels[0];
+      L.m_B = r;
+      this->MultigridVCycle(0);
+      z = m_MultigridLevels[0].m_X;
+      break;
+    }
+    case JacobiPreconditioner:
+    default:
+    {
+      for (i=0; i<N; i++)
+      {
+        z[i] = m_InverseDiagonal[i] * r[i];
+      }
+      break;
+    }
+  }
+}
+
+
+
+/* -----------------------------------------------------------------
+ *
+ * Solver
+ *
+ * -----------------------------------------------------------------
+ */
+
+void LinearSystemWrapperCSR::Solve(void)
+{
+  this->GetMatrix(0, "LinearSystemWrapperCSR::Solve");
+  const VectorRepresentation& b = *( this->GetVector(m_Vectors, 0, m_NumberOfVectors, "LinearSystemWrapperCSR::Solve", "m_Vectors") );
+  if ( !this->IsSolutionInitialized(0) )
+  {
+    this->InitializeSolution(0);
+  }
+  VectorRepresentation& x = *((*m_Solutions)[0]);
+
+  this->CompressMatrix(0);
+  const MatrixRepresentation& A = *((*m_Matrices)[0]);
+  const unsigned int N = m_Order;
+
+  m_NumberOfIterationsPerformed = 0;
+  m_FinalRelativeResidual = 0.0;
+
+  if (m_UseWarmStart && m_LastSolution.size() == N)
+  {
+    x = m_LastSolution;
+  }
+
+  m_ThreadInput1 = &b;
+  m_ThreadInput2 = &b;
+  const Float bnorm = sqrt( this->ThreadedExecute(DotProductOperation, N) );
+  if (bnorm == 0.0)
+  {
+    std::fill(x.begin(), x.end(), 0.0);
+    m_LastSolution = x;
+    return;
+  }
+
+  // the preconditioner is reused until matrix 0 changes
+  if (m_PreconditionerIsDirty)
+  {
+    this->InitializePreconditioner();
+    m_PreconditionerIsDirty = false;
+  }
+
+  if (m_UseDirectSolver)
+  {
+    this->DirectSolve(b, x);
+    m_LastSolution = x;
+    return;
+  }
+
+  VectorRepresentation r(N), z(N), p(N), q(N);
+
+  // r = b - A x
+  m_ThreadMatrix = &A;
+  m_ThreadInput1 = &x;
+  m_ThreadInput2 = &b;
+  m_ThreadOutput1 = &r;
+  Float rr = this->ThreadedExecute(ResidualOperation, N);
+  m_FinalRelativeResidual = sqrt(rr) / bnorm;
+  if (m_FinalRelativeResidual <= m_Tolerance)
+  {
+    m_LastSolution = x;
+    return;
+  }
+
+  // z = M^-1 r
+  Float rz;
+  if (m_Preconditioner == JacobiPreconditioner)
+  {
+    m_ThreadInput1 = &r;
+    m_ThreadInput2 = &m_InverseDiagonal;
+    m_ThreadOutput1 = &z;
+    rz = this->ThreadedExecute(JacobiOperation, N);
+  }
+  else
+  {
+    this->ApplyPreconditioner(r, z);
+    m_ThreadInput1 = &r;
+    m_ThreadInput2 = &z;
+    rz = this->ThreadedExecute(DotProductOperation, N);
+  }
+  p = z;
+
+  const unsigned int maximumIterations = (m_MaximumNumberIterations > 0) ? m_MaximumNumberIterations : 2*N;
+  for (unsigned int iteration=0; iteration<maximumIterations; iteration++)
+  {
+    // q = A p
+    m_ThreadMatrix = &A;
+    m_ThreadInput1 = &p;
+    m_ThreadOutput1 = &q;
+    const Float pq = this->ThreadedExecute(MatrixVectorProductOperation, N);
+    if (pq <= 0.0)
+    {
+      // the matrix is not positive definite, switch to the direct solver
+      // for this and the following solves with the same matrix
+      m_UseDirectSolver = true;
+      this->FactorDirectSolver(A);
+      this->DirectSolve(b, x);
+      m_LastSolution = x;
+      return;
+    }
+    const Float alpha = rz / pq;
+
+    // x += alpha p, r -= alpha q
+    m_ThreadInput1 = &p;
+    m_ThreadInput2 = &q;
+    m_ThreadOutput1 = &x;
+    m_ThreadOutput2 = &r;
+    m_ThreadScalar = alpha;
+    rr = this->ThreadedExecute(UpdateSolutionOperation, N);
+
+    m_NumberOfIterationsPerformed = iteration+1;
+    m_FinalRelativeResidual = sqrt(rr) / bnorm;
+    if (m_FinalRelativeResidual <= m_Tolerance)
+    {
+      break;
+    }
+
+    // z = M^-1 r
+    Float rzNew;
+    if (m_Preconditioner == JacobiPreconditioner)
+    {
+      m_ThreadInput1 = &r;
+      m_ThreadInput2 = &m_InverseDiagonal;
+      m_ThreadOutput1 = &z;
+      rzNew = this->ThreadedExecute(JacobiOperation, N);
+    }
+    else
+    {
+      this->ApplyPreconditioner(r, z);
+      m_ThreadInput1 = &r;
+      m_ThreadInput2 = &z;
+      rzNew = this->ThreadedExecute(DotProductOperation, N);
+    }
+
+    // p = z + beta p
+    m_ThreadInput1 = &z;
+    m_ThreadOutput1 = &p;
+    m_ThreadScalar = rzNew / rz;
+    this->ThreadedExecute(UpdateDirectionOperation, N);
+    rz = rzNew;
+  }
+
+  m_LastSolution = x;
+}
+
+}} // end namespace itk::fem
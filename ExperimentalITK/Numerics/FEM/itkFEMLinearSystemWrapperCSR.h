@@ -0,0 +1,415 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkFEMLinearSystemWrapperCSR.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:22:50 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __itkFEMLinearSystemWrapperCSR_h
+#define __itkFEMLinearSystemWrapperCSR_h
+
+#include "itkFEMLinearSystemWrapper.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+#include <map>
+
+class vnl_sparse_lu;
+
+namespace itk {
+namespace fem {
+
+/**
+ * \class LinearSystemWrapperCSR
+ * \brief LinearSystemWrapper class that stores the matrices in compressed
+ *        sparse row (CSR) format and solves the system with a multithreaded
+ *        preconditioned conjugate gradient method.
+ *
+ * The sparsity pattern of the matrices can be built symbolically from the
+ * element connectivity (see BuildSparsityPattern()) before any value is
+ * assembled.  Once the pattern exists, AddMatrixValue() and SetMatrixValue()
+ * only locate the entry in its row and never allocate, so distinct rows
+ * may be assembled concurrently.  This is what Solver::AssembleK() relies
+ * on to assemble colored element sets in parallel.  Entries which fall
+ * outside of the pattern (e.g. the Lagrange multiplier rows of the MFCs)
+ * are kept in a per-row overflow map and merged into the CSR arrays before
+ * the matrix is used for solving.
+ *
+ * The system is solved with the conjugate gradient method, which requires
+ * the matrix to be symmetric positive definite.  Three preconditioners are
+ * available: Jacobi (diagonal scaling), zero fill-in incomplete Cholesky and
+ * a simple aggregation based algebraic multigrid V-cycle.  If warm starts
+ * are enabled, the previous solution is used as the initial guess.
+ *
+ * Systems with a non-positive diagonal entry, such as the saddle point
+ * systems produced by the Lagrange multipliers of the MFC boundary
+ * conditions, are not positive definite.  They are solved with a sparse LU
+ * factorization (vnl_sparse_lu) instead, as are the systems on which the
+ * conjugate gradients break down.
+ *
+ * The preconditioner is built on the first call to Solve() and kept for
+ * later calls as long as matrix 0 is not modified, so a sequence of solves
+ * with the same operator and changing right hand sides (e.g. the time steps
+ * of SolverCrankNicolson) pays for the factorization only once.
+ *
+ * \sa LinearSystemWrapper
+ */
+class LinearSystemWrapperCSR : public LinearSystemWrapper
+{
+public:
+
+  /** Standard "Self" typedef. */
+  typedef LinearSystemWrapperCSR Self;
+
+  /** Standard "Superclass" typedef. */
+  typedef LinearSystemWrapper Superclass;
+
+  /**  Pointer to an object. */
+  typedef Self* Pointer;
+
+  /**  Const pointer to an object. */
+  typedef const Self* ConstPointer;
+
+  /** values stored in matrices & vectors */
+  typedef LinearSystemWrapper::Float Float;
+
+  /** column index array typedef */
+  typedef LinearSystemWrapper::ColumnArray ColumnArray;
+
+  /** dense vector representation */
+  typedef std::vector<Float> VectorRepresentation;
+
+  /** vector of vectors typedef */
+  typedef std::vector<VectorRepresentation*> VectorHolder;
+
+  /**
+   * \class MatrixRepresentation
+   * \brief Compressed sparse row matrix.  The column indices of each row
+   *        are kept sorted.
+   */
+  class MatrixRepresentation
+  {
+  public:
+    /** index of the first entry of each row (size N+1) */
+    ColumnArray m_RowStart;
+
+    /** column index of each stored entry */
+    ColumnArray m_Columns;
+
+    /** value of each stored entry */
+    VectorRepresentation m_Values;
+
+    /** entries that are not part of the sparsity pattern (one map per row) */
+    std::vector< std::map<unsigned int, Float> > m_Overflow;
+  };
+
+  /** vector of matrices typedef */
+  typedef std::vector<MatrixRepresentation*> MatrixHolder;
+
+  /** preconditioners available to the conjugate gradient solver */
+  typedef enum { JacobiPreconditioner=0,
+                 IncompleteCholeskyPreconditioner=1,
+                 AlgebraicMultigridPreconditioner=2 } PreconditionerType;
+
+  /** constructor & destructor */
+  LinearSystemWrapperCSR();
+  virtual ~LinearSystemWrapperCSR();
+
+  /* -----------------------------------------------------------------
+   *
+   * Symbolic assembly
+   *
+   * -----------------------------------------------------------------
+   */
+
+  /**
+   * Build the sparsity pattern of the system from the list of global
+   * degrees of freedom of each element.  Every pair of degrees of freedom
+   * that share an element gets a slot in the pattern.  The diagonal is
+   * always part of the pattern.  The system order must be set first.
+   * Matrices initialized afterwards use this pattern.
+   *
+   * \param dofsPerElement global degree of freedom numbers of each element
+   */
+  void BuildSparsityPattern(const std::vector<ColumnArray>& dofsPerElement);
+
+  /** Returns true if a sparsity pattern matching the system order exists. */
+  bool HasSparsityPattern() const
+  {
+    return ( m_Order > 0 && m_PatternRowStart.size() == m_Order+1 );
+  }
+
+  /** Discard the symbolic sparsity pattern. */
+  void ClearSparsityPattern();
+
+  /** Number of entries in the symbolic sparsity pattern. */
+  unsigned long GetNumberOfNonZerosInPattern() const
+  {
+    return static_cast<unsigned long>( m_PatternColumns.size() );
+  }
+
+  /* -----------------------------------------------------------------
+   *
+   * Solver parameters
+   *
+   * -----------------------------------------------------------------
+   */
+
+  /** Set/Get the preconditioner (default: Jacobi) */
+  void SetPreconditioner(PreconditionerType p) { m_Preconditioner = p; m_PreconditionerIsDirty = true; }
+  PreconditionerType GetPreconditioner() const { return m_Preconditioner; }
+
+  /** Use Jacobi (diagonal) preconditioning */
+  void JacobiPreconditionedConjugateGradient() { this->SetPreconditioner(JacobiPreconditioner); }
+
+  /** Use zero fill-in incomplete Cholesky preconditioning */
+  void IncompleteCholeskyConjugateGradient() { this->SetPreconditioner(IncompleteCholeskyPreconditioner); }
+
+  /** Use an aggregation based algebraic multigrid V-cycle as preconditioner */
+  void AlgebraicMultigridConjugateGradient() { this->SetPreconditioner(AlgebraicMultigridPreconditioner); }
+
+  /** Set/Get the maximum number of conjugate gradient iterations.  Zero
+   *  means twice the system order. */
+  void SetMaximumNumberIterations(unsigned int i) { m_MaximumNumberIterations = i; }
+  unsigned int GetMaximumNumberIterations() const { return m_MaximumNumberIterations; }
+
+  /** Set/Get the convergence tolerance relative to the norm of the
+   *  right hand side. */
+  void SetTolerance(Float t) { m_Tolerance = t; }
+  Float GetTolerance() const { return m_Tolerance; }
+
+  /** Set/Get whether the last solution is used as the initial guess */
+  void SetUseWarmStart(bool b) { m_UseWarmStart = b; }
+  bool GetUseWarmStart() const { return m_UseWarmStart; }
+
+  /** Set/Get the number of threads used for assembly and solving */
+  void SetNumberOfThreads(unsigned int n);
+  unsigned int GetNumberOfThreads() const { return m_NumberOfThreads; }
+
+  /** Set/Get the size below which the multigrid hierarchy stops coarsening
+   *  and the coarsest system is factored directly. */
+  void SetMultigridCoarsestSize(unsigned int n) { m_MultigridCoarsestSize = n; m_PreconditionerIsDirty = true; }
+  unsigned int GetMultigridCoarsestSize() const { return m_MultigridCoarsestSize; }
+
+  /** Number of iterations performed by the last call to Solve() */
+  unsigned int GetNumberOfIterationsPerformed() const { return m_NumberOfIterationsPerformed; }
+
+  /** Relative residual reached by the last call to Solve() */
+  Float GetFinalRelativeResidual() const { return m_FinalRelativeResidual; }
+
+  /** True if the current matrix 0 is solved with the direct (sparse LU)
+   *  solver instead of the conjugate gradients */
+  bool GetUseDirectSolver() const { return m_UseDirectSolver; }
+
+  /** Force the preconditioner to be rebuilt on the next call to Solve() */
+  void InvalidatePreconditioner() { m_PreconditionerIsDirty = true; }
+
+  /* -----------------------------------------------------------------
+   *
+   * LinearSystemWrapper interface
+   *
+   * -----------------------------------------------------------------
+   */
+
+  /* memory management routines */
+  virtual void  InitializeMatrix(unsigned int matrixIndex=0);
+  virtual bool  IsMatrixInitialized(unsigned int matrixIndex=0);
+  virtual void  DestroyMatrix(unsigned int matrixIndex=0);
+  virtual void  InitializeVector(unsigned int vectorIndex=0);
+  virtual bool  IsVectorInitialized(unsigned int vectorIndex=0);
+  virtual void  DestroyVector(unsigned int vectorIndex=0);
+  virtual void  InitializeSolution(unsigned int solutionIndex=0);
+  virtual bool  IsSolutionInitialized(unsigned int solutionIndex=0);
+  virtual void  DestroySolution(unsigned int solutionIndex=0);
+
+  /* assembly & solving routines */
+  virtual Float GetMatrixValue(unsigned int i, unsigned int j, unsigned int matrixIndex=0) const;
+  virtual void  SetMatrixValue(unsigned int i, unsigned int j, Float value, unsigned int matrixIndex=0);
+  virtual void  AddMatrixValue(unsigned int i, unsigned int j, Float value, unsigned int matrixIndex=0);
+  virtual void  GetColumnsOfNonZeroMatrixElementsInRow( unsigned int row, ColumnArray& cols, unsigned int matrixIndex=0 );
+  virtual Float GetVectorValue(unsigned int i, unsigned int vectorIndex=0) const;
+  virtual void  SetVectorValue(unsigned int i, Float value, unsigned int vectorIndex=0);
+  virtual void  AddVectorValue(unsigned int i, Float value, unsigned int vectorIndex=0);
+  virtual Float GetSolutionValue(unsigned int i, unsigned int solutionIndex=0) const;
+  virtual void  SetSolutionValue(unsigned int i, Float value, unsigned int solutionIndex=0);
+  virtual void  AddSolutionValue(unsigned int i, Float value, unsigned int solutionIndex=0);
+  virtual void  Solve(void);
+
+  /* matrix & vector manipulation routines */
+  virtual void  ScaleMatrix(Float scale, unsigned int matrixIndex=0);
+  virtual void  SwapMatrices(unsigned int matrixIndex1, unsigned int matrixIndex2);
+  virtual void  CopyMatrix(unsigned int matrixIndex1, unsigned int matrixIndex2);
+  virtual void  AddMatrixMatrix(unsigned int matrixIndex1, unsigned int matrixIndex2);
+  virtual void  SwapVectors(unsigned int vectorIndex1, unsigned int vectorIndex2);
+  virtual void  SwapSolutions(unsigned int solutionIndex1, unsigned int solutionIndex2);
+  virtual void  CopySolution2Vector(unsigned int solutionIndex, unsigned int vectorIndex);
+  virtual void  CopyVector2Solution(unsigned int vectorIndex, unsigned int solutionIndex);
+  virtual void  MultiplyMatrixMatrix(unsigned int resultMatrixIndex, unsigned int leftMatrixIndex, unsigned int rightMatrixIndex);
+  virtual void  MultiplyMatrixVector(unsigned int resultVectorIndex, unsigned int matrixIndex, unsigned int vectorIndex);
+
+  /**
+   * Merge the entries stored outside of the sparsity pattern into the
+   * CSR arrays of a matrix.  Called automatically before solving and
+   * before matrix-vector products.
+   * \param matrixIndex index of matrix to compress
+   */
+  void CompressMatrix(unsigned int matrixIndex=0);
+
+protected:
+
+  /** one level of the algebraic multigrid hierarchy */
+  class MultigridLevel
+  {
+  public:
+    /** system matrix of this level */
+    MatrixRepresentation m_Matrix;
+
+    /** inverse of the diagonal of m_Matrix */
+    VectorRepresentation m_InverseDiagonal;
+
+    /** aggregate (coarse row) of each row of this level */
+    ColumnArray m_Aggregate;
+
+    /** work vectors */
+    VectorRepresentation m_X;
+    VectorRepresentation m_B;
+    VectorRepresentation m_R;
+  };
+
+  /** operations executed by the threads */
+  typedef enum { MatrixVectorProductOperation=0,
+                 UpdateSolutionOperation,
+                 JacobiOperation,
+                 UpdateDirectionOperation,
+                 DotProductOperation,
+                 ResidualOperation } ThreadOperationType;
+
+  /** Execute one of the threaded vector kernels on the first rows of the
+   *  current operands.  Returns the sum of the partial dot products. */
+  Float ThreadedExecute(ThreadOperationType operation, unsigned int rows);
+
+  /** Execute the current operation on the rows [start,end) */
+  void ExecuteOperation(unsigned int threadId, unsigned int start, unsigned int end);
+
+  /** Multiply a CSR matrix with a vector using all threads */
+  void ThreadedMatrixVectorProduct(const MatrixRepresentation& A,
+    const VectorRepresentation& x, VectorRepresentation& y);
+
+  /** Threader callback */
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback( void *arg );
+
+  /** Split the rows [0,n) evenly between the threads */
+  void GetThreadRowRange(unsigned int threadId, unsigned int n,
+    unsigned int& start, unsigned int& end) const;
+
+  /** Build the preconditioner for matrix 0 */
+  void InitializePreconditioner();
+
+  /** Apply the preconditioner: z = M^-1 r */
+  void ApplyPreconditioner(const VectorRepresentation& r, VectorRepresentation& z);
+
+  /** Incomplete Cholesky factorization of the lower triangle of A */
+  void FactorIncompleteCholesky(const MatrixRepresentation& A);
+
+  /** Build the multigrid hierarchy from matrix 0 */
+  void BuildMultigridHierarchy(const MatrixRepresentation& A);
+
+  /** Multigrid V-cycle starting at a given level */
+  void MultigridVCycle(unsigned int level);
+
+  /** Dense Cholesky factorization of the coarsest multigrid level */
+  void FactorCoarsestLevel(const MatrixRepresentation& A);
+
+  /** Returns true if every diagonal entry of A is positive, which the
+   *  conjugate gradients require. */
+  bool HasPositiveDiagonal(const MatrixRepresentation& A) const;
+
+  /** Sparse LU factorization of matrix 0 for the direct solver */
+  void FactorDirectSolver(const MatrixRepresentation& A);
+
+  /** Solve with the sparse LU factorization of matrix 0 */
+  void DirectSolve(const VectorRepresentation& b, VectorRepresentation& x);
+
+  /** Locate entry (i,j) in the CSR arrays, returns -1 if not present */
+  static long FindEntry(const MatrixRepresentation& A, unsigned int i, unsigned int j);
+
+  /** Check that a matrix index is valid and allocated */
+  MatrixRepresentation* GetMatrix(unsigned int matrixIndex, const char *location) const;
+
+  /** Check that a vector index is valid and allocated */
+  VectorRepresentation* GetVector(const VectorHolder* holder, unsigned int index,
+    unsigned int numberOfVectors, const char *location, const char *name) const;
+
+private:
+
+  /** symbolic sparsity pattern */
+  ColumnArray m_PatternRowStart;
+  ColumnArray m_PatternColumns;
+
+  /** matrices, vectors and solutions of the system */
+  MatrixHolder *m_Matrices;
+  VectorHolder *m_Vectors;
+  VectorHolder *m_Solutions;
+
+  /** solver parameters */
+  PreconditionerType  m_Preconditioner;
+  unsigned int        m_MaximumNumberIterations;
+  Float               m_Tolerance;
+  bool                m_UseWarmStart;
+  unsigned int        m_MultigridCoarsestSize;
+  unsigned int        m_NumberOfIterationsPerformed;
+  Float               m_FinalRelativeResidual;
+
+  /** solution of the previous solve, used for warm starts */
+  VectorRepresentation m_LastSolution;
+
+  /** preconditioner data */
+  VectorRepresentation        m_InverseDiagonal;
+  MatrixRepresentation        m_CholeskyFactor;
+  std::vector<MultigridLevel> m_MultigridLevels;
+  VectorRepresentation        m_CoarsestFactor;
+  unsigned int                m_CoarsestOrder;
+
+  /** true if matrix 0 changed since the preconditioner was built */
+  bool                        m_PreconditionerIsDirty;
+
+  /** direct solver used for systems that are not positive definite */
+  bool                        m_UseDirectSolver;
+  vnl_sparse_lu              *m_DirectSolver;
+
+  /** threading */
+  MultiThreader::Pointer      m_Threader;
+  unsigned int                m_NumberOfThreads;
+  VectorRepresentation        m_ThreadPartialSums;
+
+  /** operands of the threaded kernels */
+  const MatrixRepresentation *m_ThreadMatrix;
+  const VectorRepresentation *m_ThreadInput1;
+  const VectorRepresentation *m_ThreadInput2;
+  VectorRepresentation       *m_ThreadOutput1;
+  VectorRepresentation       *m_ThreadOutput2;
+  Float                       m_ThreadScalar;
+  ThreadOperationType         m_ThreadOperation;
+  unsigned int                m_ThreadRows;
+
+  /** Copy constructor is not allowed. */
+  LinearSystemWrapperCSR(const LinearSystemWrapperCSR&);
+
+  /** Asignment operator is not allowed. */
+  const LinearSystemWrapperCSR& operator= (const LinearSystemWrapperCSR&);
+
+};
+
+}} // end namespace itk::fem
+
+#endif // #ifndef __itkFEMLinearSystemWrapperCSR_h
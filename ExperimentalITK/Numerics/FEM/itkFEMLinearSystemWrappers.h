@@ -25,3 +25,4 @@
 #include "itkFEMLinearSystemWrapperItpack.h"
 #include "itkFEMLinearSystemWrapperVNL.h"
 #include "itkFEMLinearSystemWrapperDenseVNL.h"
+#include "itkFEMLinearSystemWrapperCSR.h"
@@ -61,6 +61,7 @@ void Solver::Clear( void )
   this->NMFC=0;
   this->m_NZE=0;
   this->SetLinearSystemWrapper(&m_lsVNL);
+  this->Modified();
 }
 
 
@@ -75,6 +76,7 @@ void Solver::SetLinearSystemWrapper(LinearSystemWrapper::Pointer ls)
   m_ls=ls; // update the pointer to LinearSystemWrapper object
 
   this->InitializeLinearSystemWrapper();
+  this->Modified();
 }
 
 
@@ -160,6 +162,8 @@ void Solver::Read(std::istream& f) {
 
   } while ( o );
 
+  this->Modified();
+
 }
 
 
@@ -246,6 +250,8 @@ void Solver::GenerateGFN() {
     }
   } // end for e
 
+  this->Modified();
+
 //  NGFN=Element::GetGlobalDOFCounter()+1;
   if (NGFN>0) return;  // if we got 0 DOF, somebody forgot to define the system...
 
@@ -288,17 +294,13 @@ void Solver::AssembleK()
    * Since we're using the Lagrange multiplier method to apply the MFC,
    * each constraint adds a new global DOF.
    */
+  this->BuildSparsityPattern(NGFN+NMFC);
   this->InitializeMatrixForAssembly(NGFN+NMFC);
 
   /*
    * Step over all elements
    */
-  for(ElementArray::iterator e=el.begin(); e!=el.end(); e++)
-  {
-    // Call the function that actually moves the element matrix
-    // to the master matrix.
-    this->AssembleElementMatrix(&**e);
-  }
+  this->AssembleElementMatrices();
 
   /*
    * Step over all the loads again to add the landmark contributions
@@ -327,6 +329,163 @@ void Solver::InitializeMatrixForAssembly(unsigned int N)
 }
 
 
+
+void Solver::BuildSparsityPattern(unsigned int N)
+{
+  LinearSystemWrapperCSR *csr = dynamic_cast<LinearSystemWrapperCSR*>( this->m_ls );
+  if ( !csr ) return;
+
+  this->m_ls->SetSystemOrder(N);
+
+  /*
+   * Collect the global DOFs of every element. Illegal GFNs are skipped
+   * here, AssembleElementMatrix() reports them.
+   */
+  std::vector<LinearSystemWrapper::ColumnArray> dofs(el.size());
+  unsigned int i=0;
+  for(ElementArray::iterator e=el.begin(); e!=el.end(); e++, i++)
+  {
+    unsigned int Ne=(*e)->GetNumberOfDegreesOfFreedom();
+    dofs[i].reserve(Ne);
+    for(unsigned int j=0; j<Ne; j++)
+    {
+      if ( (*e)->GetDegreeOfFreedom(j) < NGFN )
+      {
+        dofs[i].push_back( (*e)->GetDegreeOfFreedom(j) );
+      }
+    }
+  }
+  csr->BuildSparsityPattern(dofs);
+}
+
+
+
+/**
+ * Data shared by the threads that assemble the elements of one color.
+ */
+struct SolverAssemblyThreadStruct
+{
+  Solver *solver;
+  Solver::ElementAssemblyMethodType method;
+  const std::vector<Element::Pointer> *elements;
+  std::vector<std::string> *errors;
+};
+
+
+
+ITK_THREAD_RETURN_TYPE Solver::AssembleElementMatricesThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast<MultiThreader::ThreadInfoStruct *>(arg);
+  const unsigned int threadId = info->ThreadID;
+  const unsigned int numberOfThreads = info->NumberOfThreads;
+  SolverAssemblyThreadStruct *str = static_cast<SolverAssemblyThreadStruct *>(info->UserData);
+
+  const unsigned int n = static_cast<unsigned int>( str->elements->size() );
+  const unsigned int start = ( n * threadId ) / numberOfThreads;
+  const unsigned int end = ( n * (threadId+1) ) / numberOfThreads;
+
+  // exceptions must not leave the thread
+  try
+  {
+    for(unsigned int i=start; i<end; i++)
+    {
+      (str->solver->*(str->method))( (*str->elements)[i] );
+    }
+  }
+  catch( ExceptionObject &e )
+  {
+    (*str->errors)[threadId] = e.GetDescription();
+  }
+  catch( ... )
+  {
+    (*str->errors)[threadId] = "Unknown exception during element assembly";
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+
+void Solver::AssembleElementMatrices( ElementAssemblyMethodType method )
+{
+  LinearSystemWrapperCSR *csr = dynamic_cast<LinearSystemWrapperCSR*>( this->m_ls );
+  if ( !csr || !csr->HasSparsityPattern() || csr->GetNumberOfThreads()<=1 )
+  {
+    for(ElementArray::iterator e=el.begin(); e!=el.end(); e++)
+    {
+      // Call the function that actually moves the element matrix
+      // to the master matrix.
+      (this->*method)(&**e);
+    }
+    return;
+  }
+
+  /*
+   * Greedy coloring of the elements: an element gets the smallest color
+   * that is not used yet by any element sharing one of its DOFs. All
+   * elements of one color write to disjoint rows of the master matrix.
+   */
+  std::vector<LinearSystemWrapper::ColumnArray> colorsAtDOF(NGFN);
+  std::vector<std::vector<Element::Pointer> > colors;
+  std::vector<unsigned int> forbidden;
+  unsigned int i=0;
+  for(ElementArray::iterator e=el.begin(); e!=el.end(); e++, i++)
+  {
+    unsigned int Ne=(*e)->GetNumberOfDegreesOfFreedom();
+    for(unsigned int j=0; j<Ne; j++)
+    {
+      unsigned int dof=(*e)->GetDegreeOfFreedom(j);
+      if ( dof>=NGFN ) continue;
+      for(unsigned int k=0; k<colorsAtDOF[dof].size(); k++)
+      {
+        forbidden[colorsAtDOF[dof][k]]=i+1;
+      }
+    }
+    unsigned int c=0;
+    while ( c<forbidden.size() && forbidden[c]==i+1 ) c++;
+    if ( c==colors.size() )
+    {
+      colors.push_back( std::vector<Element::Pointer>() );
+      forbidden.push_back(0);
+    }
+    colors[c].push_back(&**e);
+    for(unsigned int j=0; j<Ne; j++)
+    {
+      unsigned int dof=(*e)->GetDegreeOfFreedom(j);
+      if ( dof>=NGFN ) continue;
+      if ( colorsAtDOF[dof].empty() || colorsAtDOF[dof].back()!=c )
+      {
+        colorsAtDOF[dof].push_back(c);
+      }
+    }
+  }
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( csr->GetNumberOfThreads() );
+
+  std::vector<std::string> errors;
+  SolverAssemblyThreadStruct str;
+  str.solver = this;
+  str.method = method;
+  str.errors = &errors;
+
+  for(unsigned int c=0; c<colors.size(); c++)
+  {
+    str.elements = &colors[c];
+    errors.assign( threader->GetNumberOfThreads(), std::string() );
+    threader->SetSingleMethod( AssembleElementMatricesThreaderCallback, &str );
+    threader->SingleMethodExecute();
+    for(unsigned int t=0; t<errors.size(); t++)
+    {
+      if ( !errors[t].empty() )
+      {
+        throw FEMExceptionSolution(__FILE__,__LINE__,"Solver::AssembleElementMatrices()",errors[t]);
+      }
+    }
+  }
+}
+
+
 void Solver::AssembleLandmarkContribution(Element::Pointer e, float eta)
 {
   // Copy the element "landmark" matrix for faster access.
@@ -24,6 +24,7 @@
 
 #include "itkFEMLinearSystemWrapper.h"
 #include "itkFEMLinearSystemWrapperVNL.h"
+#include "itkFEMLinearSystemWrapperCSR.h"
 
 #include "itkImage.h"
 
@@ -156,6 +157,14 @@ public:
    */
   virtual void Clear( void );
 
+  /**
+   * Tell the solver that the problem (nodes, elements, materials or loads)
+   * has changed. Read(), Clear(), GenerateGFN() and SetLinearSystemWrapper()
+   * call it; call it after modifying the arrays or their objects directly.
+   * Subclasses that keep data derived from the problem override it.
+   */
+  virtual void Modified( void ) {}
+
 
   /**
    * System solver functions. Call all six functions below (in listed order) to solve system.
@@ -199,6 +208,30 @@ public:
    */
   virtual void AssembleElementMatrix(Element::Pointer e);
 
+  /**
+   * Build the sparsity pattern of the master matrix from the element
+   * connectivity. This only does something if the linear system wrapper
+   * can make use of it (see LinearSystemWrapperCSR).
+   *
+   * \param N Size of the matrix.
+   */
+  virtual void BuildSparsityPattern(unsigned int N);
+
+  /**
+   * Member function that adds the contribution of one element to the
+   * master matrices.
+   */
+  typedef void (Solver::*ElementAssemblyMethodType)(Element::Pointer e);
+
+  /**
+   * Call an element assembly method, AssembleElementMatrix() by default,
+   * for every element. If the linear system wrapper holds a sparsity
+   * pattern, the elements are split in colors such that no two elements
+   * of one color share a degree of freedom, and the elements of each color
+   * are assembled concurrently.
+   */
+  void AssembleElementMatrices( ElementAssemblyMethodType method=&Solver::AssembleElementMatrix );
+
   /**
    * Add the contribution of the landmark-containing elements to the
    * correct position in the master stiffess matrix. Since more
@@ -351,6 +384,12 @@ protected:
 
 private:
 
+  /**
+   * Assembles a range of the elements of one color, called by the
+   * MultiThreader from AssembleElementMatrices().
+   */
+  static ITK_THREAD_RETURN_TYPE AssembleElementMatricesThreaderCallback( void *arg );
+
   /**
    * LinearSystemWrapperVNL object that is used by default in Solver class.
    */
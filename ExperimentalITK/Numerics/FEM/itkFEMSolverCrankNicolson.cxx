@@ -51,6 +51,56 @@ void SolverCrankNicolson::InitializeForSolution()
   m_ls->InitializeSolution(SolutionTMinus1Index);
 }
 
+void SolverCrankNicolson::AssembleElementKandM(Element::Pointer e)
+{
+  vnl_matrix<Float> Ke;
+  e->GetStiffnessMatrix(Ke);  /*Copy the element stiffness matrix for faster access. */
+
+  vnl_matrix<Float> Me;
+  e->GetMassMatrix(Me);  /*Copy the element mass matrix for faster access. */
+  int Ne=e->GetNumberOfDegreesOfFreedom();          /*... same for element DOF */
+
+  Me=Me*m_rho;
+
+  Float lhsval=0.0;
+  Float rhsval=0.0;
+
+  /* step over all rows in in element matrix */
+  for(int j=0; j<Ne; j++)
+  {
+    /* step over all columns in in element matrix */
+    for(int k=0; k<Ne; k++) 
+    {
+      /* error checking. all GFN should be =>0 and <NGFN */
+      if ( e->GetDegreeOfFreedom(j) >= NGFN ||
+           e->GetDegreeOfFreedom(k) >= NGFN  )
+      {
+        throw FEMExceptionSolution(__FILE__,__LINE__,"SolverCrankNicolson::AssembleElementKandM()","Illegal GFN!");
+      }
+      
+      /* Here we finaly update the corresponding element
+       * in the master stiffness matrix. We first check if 
+       * element in Ke is zero, to prevent zeros from being 
+       * allocated in sparse matrix.
+       */
+      if ( Ke(j,k)!=Float(0.0) || Me(j,k) != Float(0.0) )
+      {
+        // left hand side matrix
+        lhsval=(Me(j,k) + m_alpha*m_deltaT*Ke(j,k));
+        m_ls->AddMatrixValue( e->GetDegreeOfFreedom(j) , 
+                  e->GetDegreeOfFreedom(k), 
+                  lhsval, SumMatrixIndex );
+        // right hand side matrix
+        rhsval=(Me(j,k) - (1.-m_alpha)*m_deltaT*Ke(j,k));
+        m_ls->AddMatrixValue( e->GetDegreeOfFreedom(j) , 
+                  e->GetDegreeOfFreedom(k), 
+                  rhsval, DifferenceMatrixIndex );
+      }
+    }
+  }
+}
+
+
 /*
  * Assemble the master stiffness matrix (also apply the MFCs to K)
  */  
@@ -61,8 +111,6 @@ void SolverCrankNicolson::AssembleKandM()
   
   if (NGFN<=0) return;
 
-  Float lhsval=0.0;
-  Float rhsval=0.0;
   NMFC=0;  // number of MFC in a system
 
   // temporary storage for pointers to LoadBCMFC objects
@@ -91,57 +139,30 @@ void SolverCrankNicolson::AssembleKandM()
    * from element stiffness matrices
    */
 
+  this->BuildSparsityPattern(NGFN+NMFC);
   InitializeForSolution(); 
-  
+
+  this->AssembleOperator();
+}
+
+
+/*
+ * Assemble the left and right hand side matrices. The vectors and
+ * solutions of the linear system are left untouched.
+ */
+void SolverCrankNicolson::AssembleOperator()
+{
+  Float lhsval=0.0;
+  Float rhsval=0.0;
+
+  m_ls->InitializeMatrix(SumMatrixIndex);
+  m_ls->InitializeMatrix(DifferenceMatrixIndex);
+
   /*
    * Step over all elements
    */
-   
-  for(ElementArray::iterator e=el.begin(); e!=el.end(); e++)
-  {
-    vnl_matrix<Float> Ke;
-    (*e)->GetStiffnessMatrix(Ke);  /*Copy the element stiffness matrix for faster access. */
-
-    vnl_matrix<Float> Me;
-    (*e)->GetMassMatrix(Me);  /*Copy the element mass matrix for faster access. */
-    int Ne=(*e)->GetNumberOfDegreesOfFreedom();          /*... same for element DOF */
+  this->AssembleElementMatrices( static_cast<ElementAssemblyMethodType>( &SolverCrankNicolson::AssembleElementKandM ) );
 
-    Me=Me*m_rho;
-
-    /* step over all rows in in element matrix */
-    for(int j=0; j<Ne; j++)
-    {
-      /* step over all columns in in element matrix */
-      for(int k=0; k<Ne; k++) 
-      {
-        /* error checking. all GFN should be =>0 and <NGFN */
-        if ( (*e)->GetDegreeOfFreedom(j) >= NGFN ||
-             (*e)->GetDegreeOfFreedom(k) >= NGFN  )
-        {
-          throw FEMExceptionSolution(__FILE__,__LINE__,"SolverCrankNicolson::AssembleKandM()","Illegal GFN!");
-        }
-        
-        /* Here we finaly update the corresponding element
-         * in the master stiffness matrix. We first check if 
-         * element in Ke is zero, to prevent zeros from being 
-         * allocated in sparse matrix.
-         */
-        if ( Ke(j,k)!=Float(0.0) || Me(j,k) != Float(0.0) )
-        {
-          // left hand side matrix
-          lhsval=(Me(j,k) + m_alpha*m_deltaT*Ke(j,k));
-          m_ls->AddMatrixValue( (*e)->GetDegreeOfFreedom(j) , 
-                    (*e)->GetDegreeOfFreedom(k), 
-                    lhsval, SumMatrixIndex );
-          // right hand side matrix
-          rhsval=(Me(j,k) - (1.-m_alpha)*m_deltaT*Ke(j,k));
-          m_ls->AddMatrixValue( (*e)->GetDegreeOfFreedom(j) , 
-                    (*e)->GetDegreeOfFreedom(k), 
-                    rhsval, DifferenceMatrixIndex );
-        }
-      }
-    }
-  }
   /*
    * Step over all the loads to add the landmark contributions to the
    * appropriate place in the stiffness matrix
@@ -161,7 +182,7 @@ void SolverCrankNicolson::AssembleKandM()
             // error checking, all GFN should be >=0 and < NGFN
             if ( ep->GetDegreeOfFreedom(j) >= NGFN ||
                  ep->GetDegreeOfFreedom(k) >= NGFN ) {
-                throw FEMExceptionSolution(__FILE__,__LINE__,"SolverCrankNicolson::AssembleKandM()","Illegal GFN!");
+                throw FEMExceptionSolution(__FILE__,__LINE__,"SolverCrankNicolson::AssembleOperator()","Illegal GFN!");
             }
     
           // Now update the corresponding element in the master
@@ -185,6 +206,40 @@ void SolverCrankNicolson::AssembleKandM()
 
   /* step over all types of BCs */
   this->ApplyBC();  // BUG  -- are BCs applied appropriately to the problem?
+
+  m_OperatorIsDirty=false;
+  m_AssembledAlpha=m_alpha;
+  m_AssembledDeltaT=m_deltaT;
+  m_AssembledRho=m_rho;
+  m_AssembledNGFN=NGFN;
+  m_AssembledNumberOfElements=static_cast<unsigned int>(el.size());
+  m_AssembledNumberOfLoads=static_cast<unsigned int>(load.size());
+  m_AssembledLinearSystem=m_ls;
+  m_LineSearchCoefficientsAreValid=false;
+}
+
+
+
+bool SolverCrankNicolson::OperatorIsOutOfDate() const
+{
+  return m_OperatorIsDirty ||
+         m_AssembledAlpha!=m_alpha ||
+         m_AssembledDeltaT!=m_deltaT ||
+         m_AssembledRho!=m_rho ||
+         m_AssembledNGFN!=NGFN ||
+         m_AssembledNumberOfElements!=el.size() ||
+         m_AssembledNumberOfLoads!=load.size() ||
+         m_AssembledLinearSystem!=m_ls;
+}
+
+
+
+void SolverCrankNicolson::UpdateOperator()
+{
+  if ( !this->OperatorIsOutOfDate() || NGFN<=0 ) return;
+  if ( !m_ls->IsMatrixInitialized(SumMatrixIndex) ) return;
+
+  this->AssembleOperator();
 }
 
 
@@ -194,6 +249,11 @@ void SolverCrankNicolson::AssembleKandM()
 void SolverCrankNicolson::AssembleFforTimeStep(int dim) {
 /* if no DOFs exist in a system, we have nothing to do */
   if (NGFN<=0) return;
+
+  /* reassemble the matrices only if the problem has changed */
+  this->UpdateOperator();
+  m_LineSearchCoefficientsAreValid=false;
+
   AssembleF(dim); // assuming assemblef uses index 0 in vector!
   
   typedef std::map<Element::DegreeOfFreedomIDType,Float> BCTermType;
@@ -231,7 +291,8 @@ void SolverCrankNicolson::AssembleFforTimeStep(int dim) {
 
 
 void  SolverCrankNicolson::RecomputeForceVector(unsigned int index)
-{ 
+{
+  m_LineSearchCoefficientsAreValid=false; 
   Float ft   = m_ls->GetVectorValue(index,ForceTIndex);
   Float ftm1 = m_ls->GetVectorValue(index,ForceTMinus1Index);
   Float utm1 = m_ls->GetVectorValue(index,DiffMatrixBySolutionTMinus1Index);
@@ -250,6 +311,7 @@ void SolverCrankNicolson::Solve()
   /* FIXME Initialize the solution vector */
   m_ls->InitializeSolution(SolutionTIndex);
   m_ls->Solve();  
+  m_LineSearchCoefficientsAreValid=false;
 // call this externally    AddToDisplacements(); 
 }
 
@@ -343,6 +405,9 @@ void SolverCrankNicolson::FindBracketingTriplet(Float* a, Float* b, Float* c)
 
 Element::Float SolverCrankNicolson::BrentsMethod(Float tol,unsigned int MaxIters)
 {
+  // the energy along the search line is a quadratic in t
+  this->ComputeLineSearchCoefficients();
+
   // We should now have a, b and c, as well as f(a), f(b), f(c), 
   // where b gives the minimum energy position;
 
@@ -427,6 +492,9 @@ Element::Float SolverCrankNicolson::BrentsMethod(Float tol,unsigned int MaxIters
 
 Element::Float SolverCrankNicolson::GoldenSection(Float tol,unsigned int MaxIters)
 {
+  // the energy along the search line is a quadratic in t
+  this->ComputeLineSearchCoefficients();
+
   // We should now have a, b and c, as well as f(a), f(b), f(c), 
   // where b gives the minimum energy position;
 
@@ -480,6 +548,7 @@ Element::Float SolverCrankNicolson::GoldenSection(Float tol,unsigned int MaxIter
 
 void SolverCrankNicolson::SetEnergyToMin(Float xmin)
 {
+  m_LineSearchCoefficientsAreValid=false;
   for (unsigned int j=0; j<NGFN; j++)
     {
     Float SolVal;
@@ -501,83 +570,81 @@ void SolverCrankNicolson::SetEnergyToMin(Float xmin)
 
 }
 
-Element::Float SolverCrankNicolson::GetDeformationEnergy(Float t)
+void SolverCrankNicolson::ComputeLineSearchCoefficients()
 {
-  Float DeformationEnergy=0.0;
-  Float iSolVal,jSolVal;
-
-  for (unsigned int i=0; i<NGFN; i++)
-    {
-// forming  U^T F
-#ifdef LOCE
-    iSolVal=t*(m_ls->GetSolutionValue(i,SolutionTIndex))
-      +(1.-t)*m_ls->GetSolutionValue(i,SolutionTMinus1Index);
-#endif
-#ifdef TOTE
-    iSolVal=t*(m_ls->GetSolutionValue(i,SolutionTIndex))
-      +m_ls->GetSolutionValue(i,TotalSolutionIndex);// FOR TOT E
-#endif
-// forming U^T K U
-    Float TempRowVal=0.0;
-    for (unsigned int j=0; j<NGFN; j++)
-      {
+  /*
+   * Along the search line the solution and the force are linear in t,
+   * u(t)=u0+t*u1 and f(t)=f0+t*f1, so that
+   *   u^T A u = u0^T A u0 + t*(u0^T A u1 + u1^T A u0) + t^2*u1^T A u1
+   *   u^T f   = u0^T f0   + t*(u0^T f1 + u1^T f0)     + t^2*u1^T f1
+   */
+  std::vector<Float> u0(NGFN), u1(NGFN), f0(NGFN), f1(NGFN);
+  unsigned int i;
+  for (i=0; i<NGFN; i++)
+  {
 #ifdef LOCE
-      jSolVal=t*(m_ls->GetSolutionValue(j,SolutionTIndex))
-        +(1.-t)*m_ls->GetSolutionValue(j,SolutionTMinus1Index);
+    u0[i]=m_ls->GetSolutionValue(i,SolutionTMinus1Index);
+    u1[i]=m_ls->GetSolutionValue(i,SolutionTIndex)-u0[i];
+    f0[i]=m_ls->GetVectorValue(i,ForceTMinus1Index);
+    f1[i]=m_ls->GetVectorValue(i,ForceTIndex)-f0[i];
 #endif
 #ifdef TOTE
-      jSolVal=t*(m_ls->GetSolutionValue(j,SolutionTIndex))
-        +m_ls->GetSolutionValue(j,TotalSolutionIndex);// FOR TOT E
+    u0[i]=m_ls->GetSolutionValue(i,TotalSolutionIndex);// FOR TOT E
+    u1[i]=m_ls->GetSolutionValue(i,SolutionTIndex);
+    f0[i]=m_ls->GetVectorValue(i,ForceTotalIndex);
+    f1[i]=m_ls->GetVectorValue(i,ForceTIndex);
 #endif
-      TempRowVal+=m_ls->GetMatrixValue(i,j,SumMatrixIndex)*jSolVal;
-      }
-    DeformationEnergy+=iSolVal*TempRowVal;
   }
+
+  for (i=0; i<3; i++)
+  {
+    m_DeformationEnergyCoefficients[i]=0.0;
+    m_ForceEnergyCoefficients[i]=0.0;
+  }
+
+  LinearSystemWrapper::ColumnArray cols;
+  for (i=0; i<NGFN; i++)
+  {
+    // only the non zero entries of the row are visited
+    m_ls->GetColumnsOfNonZeroMatrixElementsInRow(i,cols,SumMatrixIndex);
+    Float Au0=0.0, Au1=0.0;
+    for (LinearSystemWrapper::ColumnArray::const_iterator c=cols.begin(); c!=cols.end(); c++)
+    {
+      if ( *c>=NGFN ) continue;
+      Float a=m_ls->GetMatrixValue(i,*c,SumMatrixIndex);
+      Au0+=a*u0[*c];
+      Au1+=a*u1[*c];
+    }
+    m_DeformationEnergyCoefficients[0]+=u0[i]*Au0;
+    m_DeformationEnergyCoefficients[1]+=u0[i]*Au1+u1[i]*Au0;
+    m_DeformationEnergyCoefficients[2]+=u1[i]*Au1;
+    m_ForceEnergyCoefficients[0]+=u0[i]*f0[i];
+    m_ForceEnergyCoefficients[1]+=u0[i]*f1[i]+u1[i]*f0[i];
+    m_ForceEnergyCoefficients[2]+=u1[i]*f1[i];
+  }
+
+  m_LineSearchCoefficientsAreValid=true;
+}
+
+
+Element::Float SolverCrankNicolson::GetDeformationEnergy(Float t)
+{
+  if ( !m_LineSearchCoefficientsAreValid ) this->ComputeLineSearchCoefficients();
+
+  Float DeformationEnergy=m_DeformationEnergyCoefficients[0]
+    +t*(m_DeformationEnergyCoefficients[1]+t*m_DeformationEnergyCoefficients[2]);
   return DeformationEnergy;
 }
 
 
 Element::Float SolverCrankNicolson::EvaluateResidual(Float t)
 {
- 
-  Float ForceEnergy=0.0,FVal=0.0;
-  Float DeformationEnergy=0.0;
-  Float iSolVal,jSolVal;
+  if ( !m_LineSearchCoefficientsAreValid ) this->ComputeLineSearchCoefficients();
 
-  for (unsigned int i=0; i<NGFN; i++)
-  {
-// forming  U^T F
-#ifdef LOCE
-    iSolVal=t*(m_ls->GetSolutionValue(i,SolutionTIndex))
-       +(1.-t)*m_ls->GetSolutionValue(i,SolutionTMinus1Index);
-    FVal=m_ls->GetVectorValue(i,ForceTIndex);
-  FVal=t*FVal+(1.-t)*m_ls->GetVectorValue(i,ForceTMinus1Index);
-
-    ForceEnergy+=iSolVal*FVal;
-#endif
-#ifdef TOTE
-    FVal=FVal+0.0;
-    iSolVal=t*(m_ls->GetSolutionValue(i,SolutionTIndex))
-        +m_ls->GetSolutionValue(i,TotalSolutionIndex);// FOR TOT E
-    ForceEnergy+=iSolVal*(m_ls->GetVectorValue(i,ForceTotalIndex)+
-    t*m_ls->GetVectorValue(i,ForceTIndex));// FOR TOT E
-#endif
-// forming U^T K U
-    Float TempRowVal=0.0;
-    for (unsigned int j=0; j<NGFN; j++)
-    {
-#ifdef LOCE
-      jSolVal=t*(m_ls->GetSolutionValue(j,SolutionTIndex))
-         +(1.-t)*m_ls->GetSolutionValue(j,SolutionTMinus1Index);
-#endif
-#ifdef TOTE
-      jSolVal=t*(m_ls->GetSolutionValue(j,SolutionTIndex))
-       +m_ls->GetSolutionValue(j,TotalSolutionIndex);// FOR TOT E
-#endif
-      TempRowVal+=m_ls->GetMatrixValue(i,j,SumMatrixIndex)*jSolVal;
-    }
-    DeformationEnergy+=iSolVal*TempRowVal;
-  }
+  Float ForceEnergy=m_ForceEnergyCoefficients[0]
+    +t*(m_ForceEnergyCoefficients[1]+t*m_ForceEnergyCoefficients[2]);
+  Float DeformationEnergy=m_DeformationEnergyCoefficients[0]
+    +t*(m_DeformationEnergyCoefficients[1]+t*m_DeformationEnergyCoefficients[2]);
   Float Energy=(Float) fabs(DeformationEnergy-ForceEnergy);
   return Energy;
 }
@@ -588,6 +655,7 @@ Element::Float SolverCrankNicolson::EvaluateResidual(Float t)
  */  
 void SolverCrankNicolson::AddToDisplacements(Float optimum) 
 {
+  m_LineSearchCoefficientsAreValid=false;
   /*
    * Copy the resulting displacements from 
    * solution vector back to node objects.
@@ -669,6 +737,7 @@ void SolverCrankNicolson::PrintMinMaxOfSolution()
  */  
 void SolverCrankNicolson::AverageLastTwoDisplacements(Float t) 
 {
+  m_LineSearchCoefficientsAreValid=false;
  
   Float maxs=0.0;
   for(unsigned int i=0;i<NGFN;i++)
@@ -685,6 +754,7 @@ void SolverCrankNicolson::AverageLastTwoDisplacements(Float t)
 
 void SolverCrankNicolson::ZeroVector(int which) 
 {
+  m_LineSearchCoefficientsAreValid=false;
   for(unsigned int i=0;i<NGFN;i++)
   {  
     m_ls->SetVectorValue(i,0.0,which);
@@ -74,6 +74,14 @@ public:
    */  
   void AssembleKandM();            
 
+  /**
+   * Add the element contributions to the left hand side (M + alpha*dt*K)
+   * and right hand side (M - (1-alpha)*dt*K) matrices. Called for every
+   * element from AssembleKandM(); AssembleK() still assembles the plain
+   * stiffness matrix through AssembleElementMatrix().
+   */
+  void AssembleElementKandM(Element::Pointer e);
+
   /**
    * Assemble the master force vector at a given time.
    *
@@ -99,13 +107,43 @@ public:
   void PrintForce();
   
   /** Set stability step for the solution.  */
-  inline void SetAlpha(Float a = 0.5) { m_alpha=a; }
+  inline void SetAlpha(Float a = 0.5) 
+  { 
+    if ( a!=m_alpha ) { m_alpha=a; this->Modified(); }
+  }
 
   /** Set time step for the solution. Should be 1/2. */
-  inline void SetDeltatT(Float T) { m_deltaT=T; }
+  inline void SetDeltatT(Float T) 
+  { 
+    if ( T!=m_deltaT ) { m_deltaT=T; this->Modified(); }
+  }
 
   /** Set density constant.  */
-  inline void SetRho(Float rho) { m_rho=rho;  }
+  inline void SetRho(Float rho) 
+  { 
+    if ( rho!=m_rho ) { m_rho=rho; this->Modified(); }
+  }
+
+  /**
+   * The left and right hand side matrices only depend on the mesh, the
+   * materials, the loads, alpha, rho and the time step. They are assembled
+   * once and reused for all the time steps until the problem changes: the
+   * setters above and the Solver functions that change the problem call
+   * Modified(), and UpdateOperator() also compares the parameters and the
+   * sizes of the arrays with those of the last assembly.
+   */
+  virtual void Modified( void )
+  {
+    m_OperatorIsDirty=true;
+    m_LineSearchCoefficientsAreValid=false;
+  }
+
+  /**
+   * Reassemble the left and right hand side matrices if the operator is
+   * dirty. Unlike AssembleKandM() the force and solution vectors are kept.
+   * This is called by AssembleFforTimeStep().
+   */
+  void UpdateOperator();
 
   /** compute the current state of the right hand side and store the current force 
    *  for the next iteration.
@@ -122,6 +160,16 @@ public:
   Float BrentsMethod(Float tol=0.01,unsigned int MaxIters=25);
   Float EvaluateResidual(Float t=1.0);
   Float GetDeformationEnergy(Float t=1.0);
+
+  /**
+   * Both energies are quadratic polynomials in t along the search line.
+   * The coefficients are computed once with a sparse pass over the left
+   * hand side matrix, so EvaluateResidual() and GetDeformationEnergy()
+   * cost O(1) per evaluation.  Every member function that changes the
+   * current solution or force invalidates the coefficients; call this
+   * after changing them directly through GetLS().
+   */
+  void InvalidateLineSearchCoefficients() { m_LineSearchCoefficientsAreValid=false; }
   inline Float GSSign(Float a,Float b) { return (b > 0.0 ? fabs(a) : -1.*fabs(a)); }
   inline Float GSMax(Float a,Float b) { return (a > b ? a : b); }
 
@@ -153,6 +201,20 @@ public:
     SumMatrixIndex=0;                   // matrix
     DifferenceMatrixIndex=1;            // matrix    
     m_CurrentMaxSolution=1.0;
+    m_OperatorIsDirty=true;
+    m_AssembledAlpha=0.0;
+    m_AssembledDeltaT=0.0;
+    m_AssembledRho=0.0;
+    m_AssembledNGFN=0;
+    m_AssembledNumberOfElements=0;
+    m_AssembledNumberOfLoads=0;
+    m_AssembledLinearSystem=0;
+    m_LineSearchCoefficientsAreValid=false;
+    for (unsigned int i=0; i<3; i++)
+    {
+      m_DeformationEnergyCoefficients[i]=0.0;
+      m_ForceEnergyCoefficients[i]=0.0;
+    }
     this->SetMaximumNumberOfNonZeroElements(0);
   }
 
@@ -174,6 +236,39 @@ public:
   unsigned int DifferenceMatrixIndex;
   unsigned int SumMatrixIndex;
   unsigned int DiffMatrixBySolutionTMinus1Index;
+
+protected:
+
+  /**
+   * Assemble the left and right hand side matrices and apply the BCs.
+   */
+  void AssembleOperator();
+
+  /**
+   * Compute the coefficients of the deformation and force energies as
+   * quadratic polynomials in the line search parameter t.
+   */
+  void ComputeLineSearchCoefficients();
+
+  /**
+   * True if the operator must be reassembled, i.e. Modified() was called
+   * or the parameters or the problem size changed since the last assembly.
+   */
+  bool OperatorIsOutOfDate() const;
+
+  bool  m_OperatorIsDirty;
+  /** state of the problem at the last assembly of the operator */
+  Float m_AssembledAlpha;
+  Float m_AssembledDeltaT;
+  Float m_AssembledRho;
+  unsigned int m_AssembledNGFN;
+  unsigned int m_AssembledNumberOfElements;
+  unsigned int m_AssembledNumberOfLoads;
+  LinearSystemWrapper::Pointer m_AssembledLinearSystem;
+  bool  m_LineSearchCoefficientsAreValid;
+  /** c[0] + c[1]*t + c[2]*t^2 */
+  Float m_DeformationEnergyCoefficients[3];
+  Float m_ForceEnergyCoefficients[3];
   
 };
 
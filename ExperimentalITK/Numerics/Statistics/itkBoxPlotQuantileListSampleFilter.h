@@ -80,6 +80,14 @@ public:
   itkSetClampMacro( LowerPercentile, RealType, 0, 1 );
   itkGetConstMacro( LowerPercentile, RealType );
 
+  /**
+   * Number of bins of the histograms from which the quantiles are
+   * interpolated.
+   */
+  itkSetClampMacro( NumberOfHistogramBins, unsigned int, 2,
+    NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfHistogramBins, unsigned int );
+
   InstanceIdentifierContainerType GetOutlierInstanceIdentifiers()
     {
     return this->m_OutlierInstanceIdentifiers;
@@ -95,6 +103,31 @@ protected:
 
   virtual void GenerateData();
 
+  /** Internal structure used for passing the measurements to the threads. */
+  struct QuantileThreadStruct
+  {
+    Self                                             *Filter;
+    const std::vector<RealType>                      *Measurements;
+    RealType                                          LowerBound;
+    RealType                                          UpperBound;
+    RealType                                          Minimum;
+    RealType                                          Maximum;
+    bool                                              ComputeRange;
+    std::vector<RealType>                             ThreadMinima;
+    std::vector<RealType>                             ThreadMaxima;
+    std::vector<std::vector<SizeValueType> >          ThreadHistograms;
+  };
+
+  /**
+   * Lower and upper percentile quantiles of the measurements lying between
+   * the bounds.
+   */
+  void ComputeQuantiles( const std::vector<RealType> &, RealType, RealType,
+    RealType &, RealType & );
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ComputeQuantilesThreaderCallback( void *arg );
+
 private:
   BoxPlotQuantileListSampleFilter( const Self& ); //purposely not implemented
   void operator=( const Self& ); //purposely not implemented
@@ -107,6 +140,7 @@ private:
   RealType                                            m_WhiskerScalingFactor;
   RealType                                            m_LowerPercentile;
   RealType                                            m_UpperPercentile;
+  unsigned int                                        m_NumberOfHistogramBins;
 
 
 }; // end of class
@@ -19,8 +19,10 @@
 
 #include "itkBoxPlotQuantileListSampleFilter.h"
 
-#include "itkHistogram.h"
-#include "itkListSampleToHistogramFilter.h"
+#include "itkMultiThreader.h"
+#include "itkNumericTraits.h"
+
+#include "vnl/vnl_math.h"
 
 namespace itk {
 namespace Statistics {
@@ -36,6 +38,7 @@ BoxPlotQuantileListSampleFilter<TScalarListSample>
   this->m_WhiskerScalingFactor = 1.5;
   this->m_LowerPercentile = 0.25;
   this->m_UpperPercentile = 0.75;
+  this->m_NumberOfHistogramBins = 200;
 }
 
 template<class TScalarListSample>
@@ -60,134 +63,243 @@ BoxPlotQuantileListSampleFilter<TScalarListSample>
 
   const unsigned int scalarMeasurementVectorSize =
     this->GetOutput()->GetMeasurementVectorSize();
+  this->GetOutput()->Clear();
   this->GetOutput()->SetMeasurementVectorSize( scalarMeasurementVectorSize );
 
   /**
-   * Initialize the histogram in preparation for the
+   * Gather the measurements in a contiguous array which is then shared by
+   * the threads.  The quantiles are found from per-thread partial
+   * histograms which are merged by adding the bin counts.
    */
-
-  typedef Histogram<RealType, 1> HistogramType;
-  typename HistogramType::Pointer histogram = HistogramType::New();
-
-  typename HistogramType::MeasurementVectorType minimumValue;
-  minimumValue[0] = NumericTraits<RealType>::max();
-  typename HistogramType::MeasurementVectorType maximumValue;
-  maximumValue[0] = NumericTraits<RealType>::NonpositiveMin();
-  typename HistogramType::SizeType histogramSize;
-  histogramSize.Fill( 200 );
+  std::vector<RealType> measurements;
+  measurements.reserve( this->GetInput()->Size() );
 
   typename ScalarListSampleType::ConstIterator It = this->GetInput()->Begin();
   while( It != this->GetInput()->End() )
     {
     MeasurementVectorType inputMeasurement = It.GetMeasurementVector();
-    if( inputMeasurement[0] < minimumValue[0] )
-      {
-      minimumValue[0] = inputMeasurement[0];
-      }
-    if( inputMeasurement[0] > maximumValue[0] )
-      {
-      maximumValue[0] = inputMeasurement[0];
-      }
+    measurements.push_back( inputMeasurement[0] );
     ++It;
     }
-  histogram->Initialize( histogramSize, minimumValue, maximumValue );
 
-  typedef ListSampleToHistogramFilter<ScalarListSampleType, HistogramType>
-    SampleFilterType;
-  typename SampleFilterType::Pointer sampleFilter = SampleFilterType::New();
-  sampleFilter->SetHistogram( histogram );
-  sampleFilter->SetListSample( this->GetInput() );
-  sampleFilter->Update();
-
-  RealType lowerQuantile = histogram->Quantile( 0, this->m_LowerPercentile );
-  RealType upperQuantile = histogram->Quantile( 0, this->m_UpperPercentile );
+  RealType lowerQuantile = 0.0;
+  RealType upperQuantile = 0.0;
+  this->ComputeQuantiles( measurements, NumericTraits<RealType>::NonpositiveMin(),
+    NumericTraits<RealType>::max(), lowerQuantile, upperQuantile );
 
   RealType upperBound = upperQuantile +
     this->m_WhiskerScalingFactor * ( upperQuantile - lowerQuantile );
   RealType lowerBound = lowerQuantile -
     this->m_WhiskerScalingFactor * ( upperQuantile - lowerQuantile );
 
+  /**
+   * With winsorizing, the quantiles of the sample with the outliers removed
+   * are those of the measurements between the bounds, so they are computed
+   * from the same array instead of from a first version of the output.
+   */
+  RealType lowerBound2 = lowerBound;
+  RealType upperBound2 = upperBound;
+  if( this->m_OutlierHandling == Winsorize )
+    {
+    RealType lowerQuantile2 = 0.0;
+    RealType upperQuantile2 = 0.0;
+    this->ComputeQuantiles( measurements, lowerBound, upperBound,
+      lowerQuantile2, upperQuantile2 );
+
+    upperBound2 = upperQuantile2 +
+      this->m_WhiskerScalingFactor * ( upperQuantile2 - lowerQuantile2 );
+    lowerBound2 = lowerQuantile2 -
+      this->m_WhiskerScalingFactor * ( upperQuantile2 - lowerQuantile2 );
+    }
+
+  this->m_OutlierInstanceIdentifiers.clear();
+
   It = this->GetInput()->Begin();
-  while( It != this->GetInput()->End() )
+  for( unsigned long i = 0; i < measurements.size(); i++ )
     {
-    MeasurementVectorType inputMeasurement = It.GetMeasurementVector();
     typename ScalarListSampleType::MeasurementVectorType outputMeasurement;
     outputMeasurement.SetSize( scalarMeasurementVectorSize );
-    if( inputMeasurement[0] < lowerBound || inputMeasurement[0] > upperBound )
+    outputMeasurement[0] = measurements[i];
+    if( measurements[i] < lowerBound || measurements[i] > upperBound )
       {
       this->m_OutlierInstanceIdentifiers.push_back( It.GetInstanceIdentifier() );
       if( this->m_OutlierHandling == None )
         {
-        outputMeasurement[0] = inputMeasurement[0];
+        this->GetOutput()->PushBack( outputMeasurement );
+        }
+      else if( this->m_OutlierHandling == Winsorize )
+        {
+        if( measurements[i] < lowerBound )
+          {
+          outputMeasurement[0] = lowerBound2;
+          }
+        else
+          {
+          outputMeasurement[0] = upperBound2;
+          }
         this->GetOutput()->PushBack( outputMeasurement );
         }
       // else trim from the output
       }
     else
       {
-      outputMeasurement[0] = inputMeasurement[0];
       this->GetOutput()->PushBack( outputMeasurement );
       }
     ++It;
     }
+}
 
-  if( this->m_OutlierHandling == Winsorize )
+template<class TScalarListSample>
+void
+BoxPlotQuantileListSampleFilter<TScalarListSample>
+::ComputeQuantiles( const std::vector<RealType> & measurements,
+  RealType lowerBound, RealType upperBound,
+  RealType & lowerQuantile, RealType & upperQuantile )
+{
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+
+  QuantileThreadStruct str;
+  str.Filter = this;
+  str.Measurements = &measurements;
+  str.LowerBound = lowerBound;
+  str.UpperBound = upperBound;
+  str.ThreadMinima.assign( numberOfThreads, NumericTraits<RealType>::max() );
+  str.ThreadMaxima.assign( numberOfThreads,
+    NumericTraits<RealType>::NonpositiveMin() );
+  str.ThreadHistograms.resize( numberOfThreads );
+
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+
+  /**
+   * First find the range of the measurements between the bounds.
+   */
+  str.ComputeRange = true;
+  this->GetMultiThreader()->SetSingleMethod(
+    this->ComputeQuantilesThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  RealType minimumValue = NumericTraits<RealType>::max();
+  RealType maximumValue = NumericTraits<RealType>::NonpositiveMin();
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
     {
-    /** Retabulate the histogram with the outliers removed */
-    minimumValue[0] = NumericTraits<RealType>::max();
-    maximumValue[0] = NumericTraits<RealType>::NonpositiveMin();
+    minimumValue = vnl_math_min( minimumValue, str.ThreadMinima[t] );
+    maximumValue = vnl_math_max( maximumValue, str.ThreadMaxima[t] );
+    }
+  if( minimumValue >= maximumValue )
+    {
+    lowerQuantile = upperQuantile = ( minimumValue <= maximumValue )
+      ? minimumValue : 0.0;
+    return;
+    }
+  str.Minimum = minimumValue;
+  str.Maximum = maximumValue;
 
-    typename ScalarListSampleType::Iterator ItO = this->GetOutput()->Begin();
-    while( ItO != this->GetOutput()->End() )
+  /**
+   * Then bin them in a histogram per thread and merge the histograms.
+   */
+  str.ComputeRange = false;
+  this->GetMultiThreader()->SetSingleMethod(
+    this->ComputeQuantilesThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  std::vector<SizeValueType> histogram( this->m_NumberOfHistogramBins, 0 );
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    for( unsigned int b = 0; b < str.ThreadHistograms[t].size(); b++ )
       {
-      MeasurementVectorType outputMeasurement = ItO.GetMeasurementVector();
-      if( outputMeasurement[0] < minimumValue[0] )
-        {
-        minimumValue[0] = outputMeasurement[0];
-        }
-      if( outputMeasurement[0] > maximumValue[0] )
+      histogram[b] += str.ThreadHistograms[t][b];
+      }
+    }
+
+  /**
+   * The quantiles are interpolated linearly within their bin.
+   */
+  RealType totalFrequency = 0.0;
+  for( unsigned int b = 0; b < histogram.size(); b++ )
+    {
+    totalFrequency += static_cast<RealType>( histogram[b] );
+    }
+  RealType binWidth = ( maximumValue - minimumValue ) /
+    static_cast<RealType>( this->m_NumberOfHistogramBins );
+
+  RealType percentiles[2] = { this->m_LowerPercentile, this->m_UpperPercentile };
+  RealType quantiles[2] = { maximumValue, maximumValue };
+  for( unsigned int q = 0; q < 2; q++ )
+    {
+    RealType target = percentiles[q] * totalFrequency;
+    RealType cumulativeFrequency = 0.0;
+    for( unsigned int b = 0; b < histogram.size(); b++ )
+      {
+      RealType frequency = static_cast<RealType>( histogram[b] );
+      if( frequency > 0.0 && cumulativeFrequency + frequency >= target )
         {
-        maximumValue[0] = outputMeasurement[0];
+        quantiles[q] = minimumValue + binWidth * ( static_cast<RealType>( b )
+          + ( target - cumulativeFrequency ) / frequency );
+        break;
         }
-      ++ItO;
+      cumulativeFrequency += frequency;
       }
-    typename HistogramType::Pointer histogram2 = HistogramType::New();
-    histogram2->Initialize( histogramSize, minimumValue, maximumValue );
+    }
+  lowerQuantile = quantiles[0];
+  upperQuantile = quantiles[1];
+}
 
-    typename SampleFilterType::Pointer sampleFilter2 = SampleFilterType::New();
-    sampleFilter2->SetHistogram( histogram2 );
-    sampleFilter2->SetListSample( this->GetOutput() );
-    sampleFilter2->Update();
+template<class TScalarListSample>
+ITK_THREAD_RETURN_TYPE
+BoxPlotQuantileListSampleFilter<TScalarListSample>
+::ComputeQuantilesThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  QuantileThreadStruct *str =
+    static_cast<QuantileThreadStruct *>( info->UserData );
 
-    RealType lowerQuantile2 = histogram2->Quantile( 0, this->m_LowerPercentile );
-    RealType upperQuantile2 = histogram2->Quantile( 0, this->m_UpperPercentile );
+  const std::vector<RealType> & measurements = *str->Measurements;
+  const unsigned long numberOfMeasurements = measurements.size();
 
-    RealType upperBound2 = upperQuantile2 +
-      this->m_WhiskerScalingFactor * ( upperQuantile2 - lowerQuantile2 );
-    RealType lowerBound2 = lowerQuantile2 -
-      this->m_WhiskerScalingFactor * ( upperQuantile2 - lowerQuantile2 );
+  unsigned long begin = static_cast<unsigned long>( static_cast<double>(
+    numberOfMeasurements ) * info->ThreadID / info->NumberOfThreads );
+  unsigned long end = static_cast<unsigned long>( static_cast<double>(
+    numberOfMeasurements ) * ( info->ThreadID + 1 ) / info->NumberOfThreads );
 
-    this->GetOutput()->Clear();
-
-    It = this->GetInput()->Begin();
-    while( It != this->GetInput()->End() )
+  if( str->ComputeRange )
+    {
+    RealType minimumValue = NumericTraits<RealType>::max();
+    RealType maximumValue = NumericTraits<RealType>::NonpositiveMin();
+    for( unsigned long i = begin; i < end; i++ )
       {
-      MeasurementVectorType inputMeasurement = It.GetMeasurementVector();
-      typename ScalarListSampleType::MeasurementVectorType outputMeasurement;
-      outputMeasurement.SetSize( scalarMeasurementVectorSize );
-      outputMeasurement[0] = inputMeasurement[0];
-      if( inputMeasurement[0] < lowerBound )
+      RealType x = measurements[i];
+      if( x >= str->LowerBound && x <= str->UpperBound )
         {
-        outputMeasurement[0] = lowerBound2;
+        minimumValue = vnl_math_min( minimumValue, x );
+        maximumValue = vnl_math_max( maximumValue, x );
         }
-      else if( inputMeasurement[0] > upperBound )
+      }
+    str->ThreadMinima[info->ThreadID] = minimumValue;
+    str->ThreadMaxima[info->ThreadID] = maximumValue;
+    }
+  else
+    {
+    const unsigned int numberOfBins = str->Filter->m_NumberOfHistogramBins;
+    const RealType scale = static_cast<RealType>( numberOfBins ) /
+      ( str->Maximum - str->Minimum );
+
+    std::vector<SizeValueType> & histogram =
+      str->ThreadHistograms[info->ThreadID];
+    histogram.assign( numberOfBins, 0 );
+    for( unsigned long i = begin; i < end; i++ )
+      {
+      RealType x = measurements[i];
+      if( x >= str->LowerBound && x <= str->UpperBound )
         {
-        outputMeasurement[0] = upperBound2;
+        unsigned int bin = static_cast<unsigned int>(
+          ( x - str->Minimum ) * scale );
+        histogram[vnl_math_min( bin, numberOfBins - 1 )]++;
         }
-      this->GetOutput()->PushBack( outputMeasurement );
-      ++It;
       }
     }
+
+  return ITK_THREAD_RETURN_VALUE;
 }
 
 template<class TScalarListSample>
@@ -200,6 +312,8 @@ BoxPlotQuantileListSampleFilter<TScalarListSample>
     << std::endl;
   os << indent << "Whisker scaling factor: "
     << this->m_WhiskerScalingFactor << std::endl;
+  os << indent << "Number of histogram bins: "
+    << this->m_NumberOfHistogramBins << std::endl;
   os << indent << "Outlier handling: ";
   if( this->m_OutlierHandling == None )
     {
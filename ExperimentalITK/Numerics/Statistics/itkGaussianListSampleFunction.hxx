@@ -18,10 +18,7 @@
 #define __itkGaussianListSampleFunction_hxx
 
 #include "itkGaussianListSampleFunction.h"
-#include "itkCovarianceCalculator.h"
-#include "itkMeanCalculator.h"
-#include "itkWeightedCovarianceCalculator.h"
-#include "itkWeightedMeanCalculator.h"
+#include "itkListSampleMomentCalculator.h"
 
 namespace itk {
 namespace Statistics {
@@ -53,55 +50,23 @@ GaussianListSampleFunction<TListSample, TOutput, TCoordRep>
 
   if( this->m_ListSample->Size() > 1 )
     {
+    /**
+     * The mean and the covariance are accumulated together in one threaded
+     * pass over the sample.
+     */
+    typedef ListSampleMomentCalculator<InputListSampleType>
+      MomentCalculatorType;
+    typename MomentCalculatorType::Pointer momentCalculator =
+      MomentCalculatorType::New();
+    momentCalculator->SetInput( this->m_ListSample );
     if( this->m_Weights.Size() == this->m_ListSample->Size() )
       {
-      typedef typename Statistics::
-        WeightedMeanCalculator<InputListSampleType> MeanCalculatorType;
-      typename MeanCalculatorType::Pointer meanCalculator =
-        MeanCalculatorType::New();
-      meanCalculator->SetMeasurementVectorSize(
-        this->m_ListSample->GetMeasurementVectorSize() );
-      meanCalculator->SetWeights( &this->m_Weights );
-      meanCalculator->SetInputSample( this->m_ListSample );
-      meanCalculator->Update();
-
-      typedef typename Statistics::
-        WeightedCovarianceCalculator<InputListSampleType> CovarianceCalculatorType;
-      typename CovarianceCalculatorType::Pointer covarianceCalculator =
-        CovarianceCalculatorType::New();
-      covarianceCalculator->SetMeasurementVectorSize(
-        this->m_ListSample->GetMeasurementVectorSize() );
-      covarianceCalculator->SetWeights( &this->m_Weights );
-      covarianceCalculator->SetMean( meanCalculator->GetOutput() );
-      covarianceCalculator->SetInputSample( this->m_ListSample );
-      covarianceCalculator->Update();
-
-      this->m_Gaussian->SetMean( *meanCalculator->GetOutput() );
-      this->m_Gaussian->SetCovariance( *covarianceCalculator->GetOutput() );
-      }
-    else
-      {
-      typedef Statistics::MeanCalculator<InputListSampleType> MeanCalculatorType;
-      typename MeanCalculatorType::Pointer meanCalculator =
-        MeanCalculatorType::New();
-      meanCalculator->SetMeasurementVectorSize(
-        this->m_ListSample->GetMeasurementVectorSize() );
-      meanCalculator->SetInputSample( this->m_ListSample );
-      meanCalculator->Update();
-
-      typedef Statistics::CovarianceCalculator<InputListSampleType>
-        CovarianceCalculatorType;
-      typename CovarianceCalculatorType::Pointer covarianceCalculator =
-        CovarianceCalculatorType::New();
-      covarianceCalculator->SetMeasurementVectorSize(
-        this->m_ListSample->GetMeasurementVectorSize() );
-      covarianceCalculator->SetMean( meanCalculator->GetOutput() );
-      covarianceCalculator->SetInputSample( this->m_ListSample );
-      covarianceCalculator->Update();
-
-      this->m_Gaussian->SetMean( *meanCalculator->GetOutput() );
-      this->m_Gaussian->SetCovariance( *covarianceCalculator->GetOutput() );
+      momentCalculator->SetWeights( &this->m_Weights );
       }
+    momentCalculator->Compute();
+
+    this->m_Gaussian->SetMean( momentCalculator->GetMeanAsArray() );
+    this->m_Gaussian->SetCovariance( momentCalculator->GetCovariance() );
     }
   else
     {
@@ -20,6 +20,7 @@
 
 #include "itkMixtureModelComponentBase.h"
 #include "itkGaussianMembershipFunction.h"
+#include "itkListSampleMomentCalculator.h"
 #include "itkWeightedMeanSampleFilter.h"
 #include "itkWeightedCovarianceSampleFilter.h"
 
@@ -82,6 +83,10 @@ public:
   /** Type of the covariance matrix */
   typedef typename CovarianceEstimatorType::OutputType CovarianceType;
 
+  /** Type of the calculator which estimates the mean and the covariance
+   *  together in one pass over the weighted sample */
+  typedef ListSampleMomentCalculator< TSample >    MomentCalculatorType;
+
   /** Sets the input sample */
   void SetSample(const TSample* sample);
 
@@ -105,8 +110,7 @@ private:
 
   typename MeanEstimatorType::MeasurementVectorType    m_Mean;
   typename CovarianceEstimatorType::MatrixType         m_Covariance;
-  typename MeanEstimatorType::Pointer                  m_MeanEstimator;
-  typename CovarianceEstimatorType::Pointer            m_CovarianceEstimator;
+  typename MomentCalculatorType::Pointer               m_MomentCalculator;
 }; // end of class
 
 } // end of namespace Statistics
@@ -29,8 +29,7 @@ template< class TSample >
 GaussianMixtureModelComponent< TSample >
 ::GaussianMixtureModelComponent()
 {
-  m_MeanEstimator = MeanEstimatorType::New();
-  m_CovarianceEstimator = CovarianceEstimatorType::New();
+  m_MomentCalculator = MomentCalculatorType::New();
   m_GaussianMembershipFunction = NativeMembershipFunctionType::New();
   this->SetMembershipFunction((MembershipFunctionType*)
                               m_GaussianMembershipFunction.GetPointer());
@@ -47,8 +46,7 @@ GaussianMixtureModelComponent< TSample >
 
   os << indent << "Mean: " << m_Mean << std::endl;
   os << indent << "Covariance: " << m_Covariance << std::endl;
-  os << indent << "Mean Estimator: " << m_MeanEstimator << std::endl;
-  os << indent << "Covariance Estimator: " << m_CovarianceEstimator << std::endl;
+  os << indent << "Moment Calculator: " << m_MomentCalculator << std::endl;
   os << indent << "GaussianMembershipFunction: " << m_GaussianMembershipFunction << std::endl;
 }
 
@@ -59,8 +57,7 @@ GaussianMixtureModelComponent< TSample >
 {
   Superclass::SetSample(sample);
 
-  m_MeanEstimator->SetInput(sample);
-  m_CovarianceEstimator->SetInput(sample);
+  m_MomentCalculator->SetInput(sample);
 
   const MeasurementVectorSizeType measurementVectorLength = 
             sample->GetMeasurementVectorSize();
@@ -148,11 +145,10 @@ GaussianMixtureModelComponent< TSample >
 {
   unsigned int i, j;
 
-  typename MeanType::MeasurementVectorType meanEstimate =
-                                          m_MeanEstimator->GetMean();
-
-  CovarianceType covEstimateDecoratedObject = m_CovarianceEstimator->GetOutput();
-  typename CovarianceType::MeasurementVectorType covEstimate =  covEstimateDecoratedObject->et();
+  const typename MomentCalculatorType::MeanType & meanEstimate =
+                                          m_MomentCalculator->GetMeanAsArray();
+  const typename MomentCalculatorType::CovarianceType & covEstimate =
+                                          m_MomentCalculator->GetCovariance();
 
   double temp;
   double changes = 0.0;
@@ -191,19 +187,10 @@ GaussianMixtureModelComponent< TSample >
 
   const WeightArrayType & weights = this->GetWeights();
 
-  typename TSample::ConstIterator iter = this->GetSample()->Begin();
-  typename TSample::ConstIterator end =  this->GetSample()->End();
-
-  typename TSample::MeasurementVectorType measurements;
-
-  while (iter != end)
-    {
-    measurements = iter.GetMeasurementVector(); 
-    ++iter;
-    }
-
-  m_MeanEstimator->SetWeights( weights );
-  m_MeanEstimator->Update();
+  // The mean and the covariance are estimated together in a single
+  // threaded pass over the weighted sample.
+  m_MomentCalculator->SetWeights( &weights );
+  m_MomentCalculator->Compute();
 
 
   unsigned int i, j;
@@ -213,7 +200,8 @@ GaussianMixtureModelComponent< TSample >
   ParametersType parameters = this->GetFullParameters();
   int paramIndex  = 0;
 
-  typename MeanEstimatorType::MeasurementVectorType meanEstimate = m_MeanEstimator->GetMean(); 
+  const typename MomentCalculatorType::MeanType & meanEstimate =
+                      m_MomentCalculator->GetMeanAsArray();
   for ( i = 0; i < measurementVectorSize; i++)
     {
     temp = m_Mean[i] - meanEstimate[i];
@@ -228,7 +216,10 @@ GaussianMixtureModelComponent< TSample >
 
   if ( changed )
     {
-    m_Mean = meanEstimate; 
+    for ( i = 0; i < measurementVectorSize; i++)
+      {
+      m_Mean[i] = meanEstimate[i];
+      }
     for ( i = 0; i < measurementVectorSize; i++)
       {
       parameters[paramIndex] = meanEstimate[i];
@@ -241,10 +232,8 @@ GaussianMixtureModelComponent< TSample >
     paramIndex = measurementVectorSize;
     }
 
-  m_CovarianceEstimator->SetWeights( weights );
-  m_CovarianceEstimator->Update();
-  typename CovarianceEstimatorType::MatrixType covEstimate =
-                      m_CovarianceEstimator->GetCovarianceMatrix(); 
+  const typename MomentCalculatorType::CovarianceType & covEstimate =
+                      m_MomentCalculator->GetCovariance();
 
   changed = false;
   for ( i = 0; i < measurementVectorSize; i++ )
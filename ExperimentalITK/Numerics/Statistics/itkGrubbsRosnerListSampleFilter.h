@@ -19,6 +19,7 @@
 
 #include "itkListSampleToListSampleFilter.h"
 
+#include <utility>
 #include <vector>
 
 namespace itk {
@@ -65,6 +66,7 @@ public:
   typedef typename ScalarListSampleType
     ::InstanceIdentifier                              InstanceIdentifierType;
   typedef std::vector<InstanceIdentifierType>         InstanceIdentifierContainerType;
+  typedef std::pair<RealType, InstanceIdentifierType> MeasurementAndIdentifierType;
 
   enum OutlierHandlingType { None, Trim, Winsorize };
 
@@ -96,7 +98,6 @@ private:
   GrubbsRosnerListSampleFilter( const Self& ); //purposely not implemented
   void operator=( const Self& ); //purposely not implemented
 
-  InstanceIdentifierType FindMaximumNonOutlierDeviationValue( RealType, RealType );
   bool IsMeasurementAnOutlier( RealType, RealType, RealType, unsigned long );
 
   OutlierHandlingType                                 m_OutlierHandling;
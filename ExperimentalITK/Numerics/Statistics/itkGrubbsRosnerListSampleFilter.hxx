@@ -21,6 +21,8 @@
 
 #include "itkTDistribution.h"
 
+#include <algorithm>
+
 namespace itk {
 namespace Statistics {
 
@@ -82,51 +84,85 @@ GrubbsRosnerListSampleFilter<TScalarListSample>
     }
 
   /**
-   * Otherwise, iterate through the input list, removing t
+   * Otherwise, sort the measurements once.  The remaining measurement which
+   * deviates most from the mean is always one of the two extremes of the
+   * remaining sorted range, so each test only compares both ends of the
+   * range.  The mean and variance of the range are obtained in constant time
+   * from prefix sums of the measurements centered at the sample mean, which
+   * avoids both rescanning the sample and accumulating the round-off of
+   * downdating the moments at every removal.
    */
+  std::vector<MeasurementAndIdentifierType> sortedMeasurements;
+  sortedMeasurements.reserve( this->GetInput()->Size() );
 
-  RealType mean = 0.0;
-  RealType variance = 0.0;
-  RealType count = 0.0;
-
+  RealType sampleMean = 0.0;
   typename ScalarListSampleType::ConstIterator It = this->GetInput()->Begin();
   while( It != this->GetInput()->End() )
     {
     MeasurementVectorType inputMeasurement = It.GetMeasurementVector();
-
-    count += 1.0;
-    variance += ( count - 1.0 ) *
-      vnl_math_sqr( inputMeasurement[0] - mean ) / count;
-    mean = mean + ( inputMeasurement[0] - mean ) / count;
+    sortedMeasurements.push_back( MeasurementAndIdentifierType(
+      inputMeasurement[0], It.GetInstanceIdentifier() ) );
+    sampleMean += inputMeasurement[0];
     ++It;
     }
-  variance /= ( count - 1.0 );
+  sampleMean /= static_cast<RealType>( sortedMeasurements.size() );
+
+  std::sort( sortedMeasurements.begin(), sortedMeasurements.end() );
+
+  std::vector<RealType> prefixSum( sortedMeasurements.size() + 1, 0.0 );
+  std::vector<RealType> prefixSumOfSquares( sortedMeasurements.size() + 1, 0.0 );
+  for( unsigned long i = 0; i < sortedMeasurements.size(); i++ )
+    {
+    RealType centered = sortedMeasurements[i].first - sampleMean;
+    prefixSum[i+1] = prefixSum[i] + centered;
+    prefixSumOfSquares[i+1] = prefixSumOfSquares[i] + centered * centered;
+    }
+
+  RealType mean = 0.0;
+  RealType variance = 0.0;
+
+  unsigned long lower = 0;
+  unsigned long upper = sortedMeasurements.size();
 
-  bool outlierFound = true;
   this->m_OutlierInstanceIdentifiers.clear();
-  while( outlierFound == true &&
-    ( this->GetInput()->Size() - this->m_OutlierInstanceIdentifiers.size() > 6 ) )
+  while( true )
     {
-    outlierFound = false;
-    InstanceIdentifierType id =
-      this->FindMaximumNonOutlierDeviationValue( mean, variance );
-    if( this->GetInput()->GetFrequency( id ) > 0 )
+    RealType count = static_cast<RealType>( upper - lower );
+    RealType sum = prefixSum[upper] - prefixSum[lower];
+    RealType sumOfSquares =
+      prefixSumOfSquares[upper] - prefixSumOfSquares[lower];
+
+    mean = sampleMean + sum / count;
+    variance = vnl_math_max( 0.0,
+      ( sumOfSquares - sum * sum / count ) / ( count - 1.0 ) );
+
+    if( upper - lower <= 6 )
       {
-      MeasurementVectorType measurement =
-        this->GetInput()->GetMeasurementVector( id );
-      outlierFound = this->IsMeasurementAnOutlier( measurement[0], mean, variance,
-        this->GetInput()->Size() - this->m_OutlierInstanceIdentifiers.size() );
-      if( outlierFound )
-        {
-        /** Retabulate the variance and mean by removing the previous estimate */
-        RealType count = this->GetInput()->Size() -
-          this->m_OutlierInstanceIdentifiers.size();
-        mean = ( mean * count - measurement[0] ) / ( count - 1.0 );
-        variance = ( count - 1.0 ) * variance - ( count - 1.0 ) *
-          vnl_math_sqr( measurement[0] - mean ) / count;
-        variance /= ( count - 2.0 );
-        this->m_OutlierInstanceIdentifiers.push_back( id );
-        }
+      break;
+      }
+
+    const MeasurementAndIdentifierType & smallest = sortedMeasurements[lower];
+    const MeasurementAndIdentifierType & largest = sortedMeasurements[upper-1];
+
+    bool isLargestCandidate = ( largest.first - mean > mean - smallest.first ||
+      ( largest.first - mean == mean - smallest.first &&
+      largest.second < smallest.second ) );
+    const MeasurementAndIdentifierType & candidate =
+      isLargestCandidate ? largest : smallest;
+
+    if( !this->IsMeasurementAnOutlier( candidate.first, mean, variance,
+      upper - lower ) )
+      {
+      break;
+      }
+    this->m_OutlierInstanceIdentifiers.push_back( candidate.second );
+    if( isLargestCandidate )
+      {
+      upper--;
+      }
+    else
+      {
+      lower++;
       }
     }
 
@@ -144,6 +180,11 @@ GrubbsRosnerListSampleFilter<TScalarListSample>
     upperWinsorBound = mean + t * vcl_sqrt( variance );
     }
 
+  InstanceIdentifierContainerType sortedOutlierInstanceIdentifiers =
+    this->m_OutlierInstanceIdentifiers;
+  std::sort( sortedOutlierInstanceIdentifiers.begin(),
+    sortedOutlierInstanceIdentifiers.end() );
+
   It = this->GetInput()->Begin();
   while( It != this->GetInput()->End() )
     {
@@ -151,10 +192,9 @@ GrubbsRosnerListSampleFilter<TScalarListSample>
     MeasurementVectorType outputMeasurement;
     outputMeasurement.SetSize( scalarMeasurementVectorSize );
 
-    if( this->m_OutlierHandling == None || std::find(
-      this->m_OutlierInstanceIdentifiers.begin(),
-      this->m_OutlierInstanceIdentifiers.end(), It.GetInstanceIdentifier() ) ==
-      this->m_OutlierInstanceIdentifiers.end() )
+    if( this->m_OutlierHandling == None || !std::binary_search(
+      sortedOutlierInstanceIdentifiers.begin(),
+      sortedOutlierInstanceIdentifiers.end(), It.GetInstanceIdentifier() ) )
       {
       outputMeasurement[0] = inputMeasurement[0];
       this->GetOutput()->PushBack( outputMeasurement );
@@ -175,37 +215,6 @@ GrubbsRosnerListSampleFilter<TScalarListSample>
     }
 }
 
-template<class TScalarListSample>
-typename GrubbsRosnerListSampleFilter<TScalarListSample>
-::InstanceIdentifierType
-GrubbsRosnerListSampleFilter<TScalarListSample>
-::FindMaximumNonOutlierDeviationValue( RealType mean, RealType variance )
-{
-  RealType maximumDeviation = 0.0;
-  InstanceIdentifierType maximumID =
-    NumericTraits<InstanceIdentifierType>::max();
-
-  typename ScalarListSampleType::ConstIterator It = this->GetInput()->Begin();
-  while( It != this->GetInput()->End() )
-    {
-    MeasurementVectorType inputMeasurement = It.GetMeasurementVector();
-    InstanceIdentifierType inputID = It.GetInstanceIdentifier();
-
-    if( std::find( this->m_OutlierInstanceIdentifiers.begin(),
-      this->m_OutlierInstanceIdentifiers.end(), inputID ) ==
-      this->m_OutlierInstanceIdentifiers.end() )
-      {
-      if( vnl_math_abs( inputMeasurement[0] - mean ) > maximumDeviation )
-        {
-        maximumDeviation = vnl_math_abs( inputMeasurement[0] - mean );
-        maximumID = inputID;
-        }
-      }
-    ++It;
-    }
-  return maximumID;
-}
-
 template<class TScalarListSample>
 bool
 GrubbsRosnerListSampleFilter<TScalarListSample>
@@ -19,13 +19,34 @@
 
 #include "itkListSampleFunction.h"
 
+#include "itkArray.h"
 #include "itkImage.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
 
 namespace itk {
 namespace Statistics {
 
 /** \class HistogramParzenWindowsListSampleFunction.h
  * \brief point set filter.
+ *
+ * The density is estimated by binned kernel density estimation.  The
+ * samples are linearly binned in one threaded pass, each thread filling
+ * its own histogram, and the merged histogram is smoothed with a Gaussian
+ * of Sigma bins by multiplication with its analytic transform in the
+ * frequency domain.  By default, the density is the product of the
+ * marginal densities of the components.  For bivariate samples, the joint
+ * density can be estimated instead from a single 2-D histogram.
+ *
+ * Sigma can also be chosen from the sample with the normal reference
+ * rules, 1.06 s n^(-1/5) for the marginals (Silverman) and s n^(-1/6) for
+ * the joint histogram (Scott), s being the standard deviation of the
+ * component.
+ *
+ * The cubic B-spline interpolant of each smoothed histogram is tabulated
+ * once at a few points per bin, so that Evaluate() only reads the table and
+ * interpolates linearly.
  */
 
 template <class TListSample, class TOutput = double, class TCoordRep = double>
@@ -57,6 +78,7 @@ public:
   typedef TOutput                                           OutputType;
 
   typedef Image<RealType, 1>                                HistogramImageType;
+  typedef Image<RealType, 2>                                JointHistogramImageType;
 
 
   /** Helper functions */
@@ -67,6 +89,19 @@ public:
   itkSetMacro( NumberOfHistogramBins, unsigned int );
   itkGetConstMacro( NumberOfHistogramBins, unsigned int );
 
+  /** Estimate the joint density of bivariate samples. */
+  itkSetMacro( UseJointHistogram, bool );
+  itkGetConstMacro( UseJointHistogram, bool );
+  itkBooleanMacro( UseJointHistogram );
+
+  /** Select Sigma from the sample instead of using the set value. */
+  itkSetMacro( UseAutomaticBandwidthSelection, bool );
+  itkGetConstMacro( UseAutomaticBandwidthSelection, bool );
+  itkBooleanMacro( UseAutomaticBandwidthSelection );
+
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
   virtual void SetInputListSample( const InputListSampleType * ptr );
 
   virtual TOutput Evaluate( const InputMeasurementVectorType& measurement ) const;
@@ -78,6 +113,25 @@ protected:
 
   void GenerateData();
 
+  /** Internal structure used for passing the sample to the threads. */
+  struct BinningThreadStruct
+  {
+    Self                                               *Function;
+    bool                                                ComputeRange;
+    bool                                                UseJointHistogram;
+    std::vector<std::vector<RealType> >                 ThreadMinima;
+    std::vector<std::vector<RealType> >                 ThreadMaxima;
+    std::vector<std::vector<RealType> >                 ThreadHistograms;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE BinningThreaderCallback( void *arg );
+
+  /** Smooth a histogram of size0 x size1 bins, stored with the first axis
+   *  varying fastest, with a Gaussian of sigma0 x sigma1 bins. */
+  void SmoothHistogram( std::vector<RealType> &histogram,
+    unsigned int size0, unsigned int size1, RealType sigma0, RealType sigma1 );
+
 private:
   //purposely not implemented
   HistogramParzenWindowsListSampleFunction( const Self& );
@@ -86,7 +140,24 @@ private:
   unsigned int                                         m_NumberOfHistogramBins;
   RealType                                             m_Sigma;
 
+  bool                                                 m_UseJointHistogram;
+  bool                                                 m_UseAutomaticBandwidthSelection;
+
   std::vector<typename HistogramImageType::Pointer>    m_HistogramImages;
+  typename JointHistogramImageType::Pointer            m_JointHistogramImage;
+
+  /** Geometry of the histograms */
+  Array<RealType>                                      m_HistogramOrigin;
+  Array<RealType>                                      m_HistogramSpacing;
+  std::vector<unsigned int>                            m_HistogramSize;
+
+  /** Tabulated densities and their geometry */
+  std::vector<std::vector<RealType> >                  m_EvaluationTables;
+  Array<RealType>                                      m_EvaluationTableInverseSpacing;
+  std::vector<unsigned int>                            m_EvaluationTableSize;
+
+  MultiThreader::Pointer                               m_MultiThreader;
+  unsigned int                                         m_NumberOfThreads;
 };
 
 } // end of namespace Statistics
@@ -19,12 +19,17 @@
 
 #include "itkHistogramParzenWindowsListSampleFunction.h"
 
-#include "itkArray.h"
 #include "itkBSplineInterpolateImageFunction.h"
-#include "itkContinuousIndex.h"
-#include "itkDiscreteGaussianImageFilter.h"
-#include "itkDivideByConstantImageFilter.h"
-#include "itkStatisticsImageFilter.h"
+#include "itkListSampleMomentCalculator.h"
+
+#include "vnl/vnl_math.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_vector.h"
+#include "vnl/algo/vnl_fft_1d.h"
+#include "vnl/algo/vnl_fft_2d.h"
+
+#include <algorithm>
+#include <complex>
 
 namespace itk {
 namespace Statistics {
@@ -35,6 +40,13 @@ HistogramParzenWindowsListSampleFunction<TListSample, TOutput, TCoordRep>
 {
   this->m_NumberOfHistogramBins = 32;
   this->m_Sigma = 1.0;
+  this->m_UseJointHistogram = false;
+  this->m_UseAutomaticBandwidthSelection = false;
+
+  this->m_JointHistogramImage = NULL;
+
+  this->m_MultiThreader = MultiThreader::New();
+  this->m_NumberOfThreads = this->m_MultiThreader->GetNumberOfThreads();
 }
 
 template <class TListSample, class TOutput, class TCoordRep>
@@ -65,126 +77,485 @@ HistogramParzenWindowsListSampleFunction<TListSample, TOutput, TCoordRep>
   const unsigned int Dimension =
     this->m_ListSample->GetMeasurementVectorSize();
 
+  if( this->m_UseJointHistogram && Dimension != 2 )
+    {
+    itkExceptionMacro( "The joint histogram requires a bivariate sample." );
+    }
+
+  BinningThreadStruct str;
+  str.Function = this;
+  str.UseJointHistogram = this->m_UseJointHistogram;
+  str.ThreadMinima.resize( this->m_NumberOfThreads );
+  str.ThreadMaxima.resize( this->m_NumberOfThreads );
+  str.ThreadHistograms.resize( this->m_NumberOfThreads );
+
+  this->m_MultiThreader->SetNumberOfThreads( this->m_NumberOfThreads );
+
   /**
    * Find the min/max values to define the histogram domain
    */
+  str.ComputeRange = true;
+  this->m_MultiThreader->SetSingleMethod(
+    this->BinningThreaderCallback, &str );
+  this->m_MultiThreader->SingleMethodExecute();
 
   Array<RealType> minValues( Dimension );
   minValues.Fill( NumericTraits<RealType>::max() );
   Array<RealType> maxValues( Dimension );
   maxValues.Fill( NumericTraits<RealType>::NonpositiveMin() );
+  for( unsigned int t = 0; t < str.ThreadMinima.size(); t++ )
+    {
+    for( unsigned int d = 0; d < str.ThreadMinima[t].size(); d++ )
+      {
+      minValues[d] = vnl_math_min( minValues[d], str.ThreadMinima[t][d] );
+      maxValues[d] = vnl_math_max( maxValues[d], str.ThreadMaxima[t][d] );
+      }
+    }
 
-  typename InputListSampleType::ConstIterator It
-    = this->m_ListSample->Begin();
-  while( It != this->m_ListSample->End() )
+  Array<RealType> spacing( Dimension );
+  for( unsigned int d = 0; d < Dimension; d++ )
     {
-    InputMeasurementVectorType inputMeasurement = It.GetMeasurementVector();
+    spacing[d] = ( maxValues[d] - minValues[d] ) /
+      static_cast<RealType>( this->m_NumberOfHistogramBins - 1 );
+    if( spacing[d] <= 0.0 )
+      {
+      spacing[d] = 1.0;
+      }
+    }
 
+  /**
+   * Sigma, in bins, along each axis.
+   */
+  Array<RealType> sigma( Dimension );
+  sigma.Fill( this->m_Sigma );
+  if( this->m_UseAutomaticBandwidthSelection )
+    {
+    typedef ListSampleMomentCalculator<InputListSampleType> CalculatorType;
+    typename CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->SetInput( this->m_ListSample );
+    if( this->m_Weights.Size() == this->m_ListSample->Size() )
+      {
+      calculator->SetWeights( &this->m_Weights );
+      }
+    calculator->Compute();
+
+    RealType n = static_cast<RealType>( this->m_ListSample->Size() );
+    RealType factor = ( this->m_UseJointHistogram )
+      ? vcl_pow( n, static_cast<RealType>( -1.0 / 6.0 ) )
+      : static_cast<RealType>( 1.06 ) * vcl_pow( n,
+        static_cast<RealType>( -0.2 ) );
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      sigma[d] = factor * vcl_sqrt( calculator->GetCovariance()( d, d ) ) /
+        spacing[d];
+      }
+    }
+
+  this->m_HistogramOrigin.SetSize( Dimension );
+  this->m_HistogramSpacing = spacing;
+  this->m_HistogramSize.resize( Dimension );
+  for( unsigned int d = 0; d < Dimension; d++ )
+    {
+    RealType margin = 3.0 * ( sigma[d] * spacing[d] );
+    this->m_HistogramOrigin[d] = minValues[d] - margin;
+    this->m_HistogramSize[d] = static_cast<unsigned int>(
+      vcl_ceil( ( maxValues[d] - minValues[d] + 2.0 * margin ) /
+      spacing[d] ) ) + 1;
+    }
+
+  /**
+   * Bin the samples, each thread in its own histogram, and merge the
+   * histograms.
+   */
+  str.ComputeRange = false;
+  this->m_MultiThreader->SetSingleMethod(
+    this->BinningThreaderCallback, &str );
+  this->m_MultiThreader->SingleMethodExecute();
+
+  unsigned int numberOfBins = 0;
+  if( this->m_UseJointHistogram )
+    {
+    numberOfBins = this->m_HistogramSize[0] * this->m_HistogramSize[1];
+    }
+  else
+    {
     for( unsigned int d = 0; d < Dimension; d++ )
       {
-      if( inputMeasurement[d] < minValues[d] )
+      numberOfBins += this->m_HistogramSize[d];
+      }
+    }
+  std::vector<RealType> histogram( numberOfBins, 0.0 );
+  for( unsigned int t = 0; t < str.ThreadHistograms.size(); t++ )
+    {
+    for( unsigned int n = 0; n < str.ThreadHistograms[t].size(); n++ )
+      {
+      histogram[n] += str.ThreadHistograms[t][n];
+      }
+    str.ThreadHistograms[t].clear();
+    }
+
+  /**
+   * Smooth and normalize the histograms, then tabulate their cubic B-spline
+   * interpolants at evaluationTableRefinement points per bin.
+   */
+  const unsigned int evaluationTableRefinement = 4;
+
+  this->m_HistogramImages.clear();
+  this->m_JointHistogramImage = NULL;
+  this->m_EvaluationTables.clear();
+  this->m_EvaluationTableInverseSpacing.SetSize( Dimension );
+  this->m_EvaluationTableSize.resize( Dimension );
+  for( unsigned int d = 0; d < Dimension; d++ )
+    {
+    this->m_EvaluationTableInverseSpacing[d] =
+      static_cast<RealType>( evaluationTableRefinement ) / spacing[d];
+    this->m_EvaluationTableSize[d] = ( this->m_HistogramSize[d] - 1 ) *
+      evaluationTableRefinement + 1;
+    }
+
+  if( this->m_UseJointHistogram )
+    {
+    this->SmoothHistogram( histogram, this->m_HistogramSize[0],
+      this->m_HistogramSize[1], sigma[0], sigma[1] );
+
+    typename JointHistogramImageType::PointType origin;
+    typename JointHistogramImageType::SpacingType imageSpacing;
+    typename JointHistogramImageType::SizeType size;
+    for( unsigned int d = 0; d < 2; d++ )
+      {
+      origin[d] = this->m_HistogramOrigin[d];
+      imageSpacing[d] = spacing[d];
+      size[d] = this->m_HistogramSize[d];
+      }
+    this->m_JointHistogramImage = JointHistogramImageType::New();
+    this->m_JointHistogramImage->SetOrigin( origin );
+    this->m_JointHistogramImage->SetSpacing( imageSpacing );
+    this->m_JointHistogramImage->SetRegions( size );
+    this->m_JointHistogramImage->Allocate();
+    std::copy( histogram.begin(), histogram.end(),
+      this->m_JointHistogramImage->GetBufferPointer() );
+
+    typedef BSplineInterpolateImageFunction<JointHistogramImageType>
+      InterpolatorType;
+    typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+    interpolator->SetSplineOrder( 3 );
+    interpolator->SetInputImage( this->m_JointHistogramImage );
+
+    std::vector<RealType> table( this->m_EvaluationTableSize[0] *
+      this->m_EvaluationTableSize[1] );
+    typename InterpolatorType::ContinuousIndexType cidx;
+    for( unsigned int j = 0; j < this->m_EvaluationTableSize[1]; j++ )
+      {
+      cidx[1] = static_cast<double>( j ) / evaluationTableRefinement;
+      for( unsigned int i = 0; i < this->m_EvaluationTableSize[0]; i++ )
         {
-        minValues[d] = inputMeasurement[d];
+        cidx[0] = static_cast<double>( i ) / evaluationTableRefinement;
+        table[i + j * this->m_EvaluationTableSize[0]] = vnl_math_max(
+          static_cast<RealType>( 0.0 ), static_cast<RealType>(
+          interpolator->EvaluateAtContinuousIndex( cidx ) ) );
         }
-      if( inputMeasurement[d] > maxValues[d] )
+      }
+    this->m_EvaluationTables.push_back( table );
+    }
+  else
+    {
+    unsigned int offset = 0;
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      std::vector<RealType> marginal( histogram.begin() + offset,
+        histogram.begin() + offset + this->m_HistogramSize[d] );
+      offset += this->m_HistogramSize[d];
+
+      this->SmoothHistogram( marginal, this->m_HistogramSize[d], 1,
+        sigma[d], 0.0 );
+
+      typename HistogramImageType::PointType origin;
+      origin[0] = this->m_HistogramOrigin[d];
+      typename HistogramImageType::SpacingType imageSpacing;
+      imageSpacing[0] = spacing[d];
+      typename HistogramImageType::SizeType size;
+      size[0] = this->m_HistogramSize[d];
+
+      this->m_HistogramImages.push_back( HistogramImageType::New() );
+      this->m_HistogramImages[d]->SetOrigin( origin );
+      this->m_HistogramImages[d]->SetSpacing( imageSpacing );
+      this->m_HistogramImages[d]->SetRegions( size );
+      this->m_HistogramImages[d]->Allocate();
+      std::copy( marginal.begin(), marginal.end(),
+        this->m_HistogramImages[d]->GetBufferPointer() );
+
+      typedef BSplineInterpolateImageFunction<HistogramImageType>
+        InterpolatorType;
+      typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+      interpolator->SetSplineOrder( 3 );
+      interpolator->SetInputImage( this->m_HistogramImages[d] );
+
+      std::vector<RealType> table( this->m_EvaluationTableSize[d] );
+      typename InterpolatorType::ContinuousIndexType cidx;
+      for( unsigned int i = 0; i < this->m_EvaluationTableSize[d]; i++ )
         {
-        maxValues[d] = inputMeasurement[d];
+        cidx[0] = static_cast<double>( i ) / evaluationTableRefinement;
+        table[i] = vnl_math_max( static_cast<RealType>( 0.0 ),
+          static_cast<RealType>( interpolator->EvaluateAtContinuousIndex( cidx ) ) );
         }
+      this->m_EvaluationTables.push_back( table );
       }
-    ++It;
     }
+}
 
-  this->m_HistogramImages.clear();
-  for( unsigned int d = 0; d < Dimension; d++ )
+template <class TListSample, class TOutput, class TCoordRep>
+ITK_THREAD_RETURN_TYPE
+HistogramParzenWindowsListSampleFunction<TListSample, TOutput, TCoordRep>
+::BinningThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  BinningThreadStruct *str =
+    static_cast<BinningThreadStruct *>( info->UserData );
+  Self *function = str->Function;
+
+  const InputListSampleType *sample = function->m_ListSample;
+  const unsigned int Dimension = sample->GetMeasurementVectorSize();
+  const unsigned long numberOfMeasurements = sample->Size();
+  const bool useWeights =
+    ( function->m_Weights.Size() == numberOfMeasurements );
+
+  unsigned long begin = static_cast<unsigned long>( static_cast<double>(
+    numberOfMeasurements ) * info->ThreadID / info->NumberOfThreads );
+  unsigned long end = static_cast<unsigned long>( static_cast<double>(
+    numberOfMeasurements ) * ( info->ThreadID + 1 ) / info->NumberOfThreads );
+
+  typename InputListSampleType::ConstIterator It = sample->Begin();
+  for( unsigned long n = 0; n < begin; n++ )
     {
-    this->m_HistogramImages.push_back( HistogramImageType::New() );
+    ++It;
+    }
 
-    typename HistogramImageType::SpacingType spacing;
-    spacing[0] = ( maxValues[d] - minValues[d] ) /
-      static_cast<RealType>( this->m_NumberOfHistogramBins - 1 );
+  if( str->ComputeRange )
+    {
+    std::vector<RealType> & minValues = str->ThreadMinima[info->ThreadID];
+    std::vector<RealType> & maxValues = str->ThreadMaxima[info->ThreadID];
+    minValues.assign( Dimension, NumericTraits<RealType>::max() );
+    maxValues.assign( Dimension, NumericTraits<RealType>::NonpositiveMin() );
 
-    typename HistogramImageType::PointType origin;
-    origin[0] = minValues[d] - 3.0 * ( this->m_Sigma * spacing[0] );
+    for( unsigned long n = begin; n < end; n++ )
+      {
+      const InputMeasurementVectorType & inputMeasurement =
+        It.GetMeasurementVector();
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        if( inputMeasurement[d] < minValues[d] )
+          {
+          minValues[d] = inputMeasurement[d];
+          }
+        if( inputMeasurement[d] > maxValues[d] )
+          {
+          maxValues[d] = inputMeasurement[d];
+          }
+        }
+      ++It;
+      }
+    return ITK_THREAD_RETURN_VALUE;
+    }
 
-    typename HistogramImageType::SizeType size;
-    size[0] = static_cast<unsigned int>(
-      vcl_ceil( ( maxValues[d] + 3.0 * ( this->m_Sigma * spacing[0] ) -
-      ( minValues[d] - 3.0 * ( this->m_Sigma * spacing[0] ) ) ) / spacing[0] ) );
+  const std::vector<unsigned int> & size = function->m_HistogramSize;
+  const Array<RealType> & origin = function->m_HistogramOrigin;
+  const Array<RealType> & spacing = function->m_HistogramSpacing;
 
-    this->m_HistogramImages[d]->SetOrigin( origin );
-    this->m_HistogramImages[d]->SetSpacing( spacing );
-    this->m_HistogramImages[d]->SetRegions( size );
-    this->m_HistogramImages[d]->Allocate();
-    this->m_HistogramImages[d]->FillBuffer( 0 );
+  std::vector<RealType> & histogram = str->ThreadHistograms[info->ThreadID];
+  if( str->UseJointHistogram )
+    {
+    histogram.assign( size[0] * size[1], 0.0 );
+    }
+  else
+    {
+    unsigned int numberOfBins = 0;
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      numberOfBins += size[d];
+      }
+    histogram.assign( numberOfBins, 0.0 );
     }
 
-  unsigned long count = 0;
-  It = this->m_ListSample->Begin();
-  while( It != this->m_ListSample->End() )
+  /**
+   * Linear binning: the weight of each sample is shared between the two
+   * nearest bins along each axis.
+   */
+  long index[2];
+  RealType fraction[2];
+  for( unsigned long n = begin; n < end; n++ )
     {
-    InputMeasurementVectorType inputMeasurement = It.GetMeasurementVector();
+    const InputMeasurementVectorType & inputMeasurement =
+      It.GetMeasurementVector();
 
     RealType newWeight = 1.0;
-    if( this->m_Weights.Size() == this->m_ListSample->Size() )
+    if( useWeights )
       {
-      newWeight = this->m_Weights[count];
+      newWeight = function->m_Weights[n];
       }
 
-    for( unsigned int d = 0; d < Dimension; d++ )
+    if( str->UseJointHistogram )
+      {
+      for( unsigned int d = 0; d < 2; d++ )
+        {
+        RealType cidx = ( inputMeasurement[d] - origin[d] ) / spacing[d];
+        index[d] = static_cast<long>( vcl_floor( cidx ) );
+        fraction[d] = cidx - static_cast<RealType>( index[d] );
+        }
+      for( unsigned int j = 0; j < 2; j++ )
+        {
+        long idx1 = index[1] + j;
+        if( idx1 < 0 || idx1 >= static_cast<long>( size[1] ) )
+          {
+          continue;
+          }
+        RealType weight1 = ( j == 0 ) ? 1.0 - fraction[1] : fraction[1];
+        for( unsigned int i = 0; i < 2; i++ )
+          {
+          long idx0 = index[0] + i;
+          if( idx0 < 0 || idx0 >= static_cast<long>( size[0] ) )
+            {
+            continue;
+            }
+          RealType weight0 = ( i == 0 ) ? 1.0 - fraction[0] : fraction[0];
+          histogram[idx0 + idx1 * size[0]] += weight0 * weight1 * newWeight;
+          }
+        }
+      }
+    else
+      {
+      unsigned int offset = 0;
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        RealType cidx = ( inputMeasurement[d] - origin[d] ) / spacing[d];
+        long idx = static_cast<long>( vcl_floor( cidx ) );
+        RealType f = cidx - static_cast<RealType>( idx );
+        if( idx >= 0 && idx < static_cast<long>( size[d] ) )
+          {
+          histogram[offset + idx] += ( 1.0 - f ) * newWeight;
+          }
+        idx++;
+        if( idx >= 0 && idx < static_cast<long>( size[d] ) )
+          {
+          histogram[offset + idx] += f * newWeight;
+          }
+        offset += size[d];
+        }
+      }
+    ++It;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TListSample, class TOutput, class TCoordRep>
+void
+HistogramParzenWindowsListSampleFunction<TListSample, TOutput, TCoordRep>
+::SmoothHistogram( std::vector<RealType> &histogram, unsigned int size0,
+  unsigned int size1, RealType sigma0, RealType sigma1 )
+{
+  /**
+   * Zero-pad the histogram to a power of 2 along each axis, with at least
+   * 3 sigma on one side so that the convolution does not wrap around, and
+   * multiply its transform by the transform of the Gaussian,
+   * exp( -2 pi^2 sigma^2 ( k / N )^2 ).
+   */
+  unsigned int size[2] = { size0, size1 };
+  RealType sigma[2] = { sigma0, sigma1 };
+  unsigned int paddedSize[2] = { 1, 1 };
+  std::vector<double> gaussian[2];
+  for( unsigned int d = 0; d < 2; d++ )
+    {
+    if( size[d] == 1 )
       {
-      typename HistogramImageType::PointType point;
-      point[0] = inputMeasurement[d];
+      gaussian[d].assign( 1, 1.0 );
+      continue;
+      }
+    unsigned int minimumSize = size[d] + static_cast<unsigned int>(
+      vcl_ceil( 3.0 * sigma[d] ) ) + 1;
+    while( paddedSize[d] < minimumSize )
+      {
+      paddedSize[d] *= 2;
+      }
+    gaussian[d].resize( paddedSize[d] );
+    for( unsigned int k = 0; k < paddedSize[d]; k++ )
+      {
+      double frequency = static_cast<double>( ( k <= paddedSize[d] / 2 )
+        ? k : paddedSize[d] - k ) / static_cast<double>( paddedSize[d] );
+      gaussian[d][k] = vcl_exp( -2.0 * vnl_math_sqr( vnl_math::pi *
+        sigma[d] * frequency ) );
+      }
+    }
 
-      ContinuousIndex<double, 1> cidx;
-      this->m_HistogramImages[d]->TransformPhysicalPointToContinuousIndex(
-        point, cidx );
+  if( size1 == 1 )
+    {
+    vnl_vector< vcl_complex<double> > V( paddedSize[0],
+      vcl_complex<double>( 0.0, 0.0 ) );
+    for( unsigned int i = 0; i < size0; i++ )
+      {
+      V[i] = histogram[i];
+      }
 
-      typename HistogramImageType::IndexType idx;
+    vnl_fft_1d<double> fft( paddedSize[0] );
+    fft.fwd_transform( V );
+    for( unsigned int k = 0; k < paddedSize[0]; k++ )
+      {
+      V[k] *= gaussian[0][k];
+      }
+    fft.bwd_transform( V );
 
-      idx[0] = static_cast<typename
-        HistogramImageType::IndexType::IndexValueType>( vcl_floor( cidx[0] ) );
-      if( this->m_HistogramImages[d]->GetLargestPossibleRegion().IsInside( idx ) )
+    for( unsigned int i = 0; i < size0; i++ )
+      {
+      histogram[i] = vnl_math_max( 0.0, V[i].real() );
+      }
+    }
+  else
+    {
+    vnl_matrix< vcl_complex<double> > V( paddedSize[1], paddedSize[0],
+      vcl_complex<double>( 0.0, 0.0 ) );
+    for( unsigned int j = 0; j < size1; j++ )
+      {
+      for( unsigned int i = 0; i < size0; i++ )
         {
-        RealType oldWeight = this->m_HistogramImages[d]->GetPixel( idx );
-        this->m_HistogramImages[d]->SetPixel( idx,
-          ( 1.0 - ( cidx[0] - idx[0] ) ) * newWeight + oldWeight );
+        V( j, i ) = histogram[i + j * size0];
         }
+      }
 
-      idx[0]++;
-      if( this->m_HistogramImages[d]->GetLargestPossibleRegion().IsInside( idx ) )
+    vnl_fft_2d<double> fft( paddedSize[1], paddedSize[0] );
+    fft.fwd_transform( V );
+    for( unsigned int j = 0; j < paddedSize[1]; j++ )
+      {
+      for( unsigned int i = 0; i < paddedSize[0]; i++ )
         {
-        RealType oldWeight = this->m_HistogramImages[d]->GetPixel( idx );
-        this->m_HistogramImages[d]->SetPixel( idx,
-          ( 1.0 - ( idx[0] - cidx[0] ) ) * newWeight + oldWeight );
+        V( j, i ) *= gaussian[0][i] * gaussian[1][j];
+        }
+      }
+    fft.bwd_transform( V );
+
+    for( unsigned int j = 0; j < size1; j++ )
+      {
+      for( unsigned int i = 0; i < size0; i++ )
+        {
+        histogram[i + j * size0] = vnl_math_max( 0.0, V( j, i ).real() );
         }
       }
-    ++count;
-    ++It;
     }
 
-  for( unsigned int d = 0; d < Dimension; d++ )
+  /**
+   * The backward transform is not scaled, so the histogram is normalized
+   * here.
+   */
+  RealType sum = 0.0;
+  for( unsigned int n = 0; n < histogram.size(); n++ )
     {
-    typedef DiscreteGaussianImageFilter<HistogramImageType, HistogramImageType>
-      GaussianFilterType;
-    typename GaussianFilterType::Pointer gaussian = GaussianFilterType::New();
-    gaussian->SetInput( this->m_HistogramImages[d] );
-    gaussian->SetVariance( this->m_Sigma * this->m_Sigma );
-    gaussian->SetMaximumError( 0.01 );
-    gaussian->SetUseImageSpacing( false );
-    gaussian->Update();
-
-    typedef StatisticsImageFilter<HistogramImageType> StatsFilterType;
-    typename StatsFilterType::Pointer stats = StatsFilterType::New();
-    stats->SetInput( gaussian->GetOutput() );
-    stats->Update();
-
-    typedef DivideByConstantImageFilter<HistogramImageType, RealType,
-      HistogramImageType> DividerType;
-    typename DividerType::Pointer divider = DividerType::New();
-    divider->SetInput( gaussian->GetOutput() );
-    divider->SetConstant( stats->GetSum() );
-    divider->Update();
-    this->m_HistogramImages[d] = divider->GetOutput();
+    sum += histogram[n];
+    }
+  if( sum > 0.0 )
+    {
+    for( unsigned int n = 0; n < histogram.size(); n++ )
+      {
+      histogram[n] /= sum;
+      }
     }
 }
 
@@ -198,24 +569,48 @@ HistogramParzenWindowsListSampleFunction<TListSample, TOutput, TCoordRep>
     return 0;
     }
 
-  typedef BSplineInterpolateImageFunction<HistogramImageType> InterpolatorType;
+  /**
+   * Read the tabulated densities, interpolating linearly.
+   */
+  long index[2];
+  RealType fraction[2];
+  const unsigned int numberOfAxes = ( this->m_UseJointHistogram ) ? 2 : 1;
 
   RealType probability = 1.0;
-  for( unsigned int d = 0; d < this->m_HistogramImages.size(); d++ )
+  for( unsigned int t = 0; t < this->m_EvaluationTables.size(); t++ )
     {
-    typename HistogramImageType::PointType point;
-    point[0] = measurement[d];
+    for( unsigned int a = 0; a < numberOfAxes; a++ )
+      {
+      unsigned int d = t + a;
+      RealType cidx = ( measurement[d] - this->m_HistogramOrigin[d] ) *
+        this->m_EvaluationTableInverseSpacing[d];
+      RealType maximumIndex = static_cast<RealType>(
+        this->m_EvaluationTableSize[d] - 1 );
+      if( !( cidx >= 0.0 && cidx <= maximumIndex ) )
+        {
+        return 0;
+        }
+      index[a] = vnl_math_min( static_cast<long>( cidx ),
+        static_cast<long>( maximumIndex ) - 1 );
+      fraction[a] = cidx - static_cast<RealType>( index[a] );
+      }
 
-    typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
-    interpolator->SetSplineOrder( 3 );
-    interpolator->SetInputImage( this->m_HistogramImages[d] );
-    if( interpolator->IsInsideBuffer( point ) )
+    const std::vector<RealType> & table = this->m_EvaluationTables[t];
+    if( numberOfAxes == 1 )
       {
-      probability *= interpolator->Evaluate( point );
+      probability *= ( 1.0 - fraction[0] ) * table[index[0]] +
+        fraction[0] * table[index[0] + 1];
       }
     else
       {
-      return 0;
+      const unsigned int size0 = this->m_EvaluationTableSize[0];
+      const RealType *row0 = &table[index[0] + index[1] * size0];
+      const RealType *row1 = row0 + size0;
+      probability *=
+        ( 1.0 - fraction[1] ) * ( ( 1.0 - fraction[0] ) * row0[0] +
+        fraction[0] * row0[1] ) +
+        fraction[1] * ( ( 1.0 - fraction[0] ) * row1[0] +
+        fraction[0] * row1[1] );
       }
     }
   return probability;
@@ -235,6 +630,12 @@ HistogramParzenWindowsListSampleFunction<TListSample, TOutput, TCoordRep>
                << this->m_Sigma << std::endl;
   os << indent << "Number of histogram bins: "
                << this->m_NumberOfHistogramBins << std::endl;
+  os << indent << "Use joint histogram: "
+               << this->m_UseJointHistogram << std::endl;
+  os << indent << "Use automatic bandwidth selection: "
+               << this->m_UseAutomaticBandwidthSelection << std::endl;
+  os << indent << "Number of threads: "
+               << this->m_NumberOfThreads << std::endl;
 }
 
 } // end of namespace Statistics
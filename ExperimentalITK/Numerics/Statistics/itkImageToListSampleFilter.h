@@ -48,7 +48,7 @@ namespace Statistics {
  * think the ImageMaskSpatialObject is slow in terms of inefficient iteration 
  * through the image.
  * 
- * \sa ImageToListSampleAdaptor
+ * \sa ImageToListSampleAdaptor, MaskedImageToListSampleAdaptor
  */
 template < class TImage, class TMaskImage = TImage > 
 class ITK_EXPORT ImageToListSampleFilter :
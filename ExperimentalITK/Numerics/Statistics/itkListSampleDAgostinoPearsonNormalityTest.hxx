@@ -91,13 +91,20 @@ ListSampleDAgostinoPearsonNormalityTest<TListSample>
   typename CalculatorType::Pointer calculator = CalculatorType::New();
   calculator->SetInput( this->GetInput() );
 
+  /**
+   * Both moments come from the same single pass over the sample.
+   */
+  calculator->Compute();
+  MeasurementVectorType skewness = calculator->GetStandardizedMoment( 3 );
+  MeasurementVectorType kurtosis = calculator->GetStandardizedMoment( 4 );
+
   typename ListSampleType::MeasurementVectorType p;
   p.SetSize( this->GetInput()->GetMeasurementVectorSize() );
 
   for( unsigned int n = 0; n < p.Size(); n++ )
     {
-    RealType g1 = calculator->GetStandardizedMoment( 3 )[n];
-    RealType g2 = calculator->GetStandardizedMoment( 4 )[n] - 3.0 ;
+    RealType g1 = skewness[n];
+    RealType g2 = kurtosis[n] - 3.0 ;
 
 
     RealType Z1_g1 = d * vcl_log( g1 / ( a * vcl_sqrt( u2_g1 ) ) +
@@ -22,16 +22,34 @@
 
 #include "itkProcessObject.h"
 
+#include "itkArray.h"
+#include "itkMultiThreader.h"
+#include "itkVariableSizeMatrix.h"
+
+#include <vector>
+
 namespace itk {
 namespace Statistics {
 
 /** \class ListSampleMomentCalculator
- * \brief Base class for filters that take a list sample as an input and output
- * another list sample.
+ * \brief Computes the mean, the covariance and the standardized moments up
+ * to the fourth order of an optionally weighted list sample.
+ *
+ * All the moments are accumulated in a single pass over the sample.  The
+ * sample is split in contiguous pieces, one per thread, and each thread
+ * keeps the sum of the weights, the mean and the centered sums of the
+ * powers and cross products of its piece, updated one measurement at a
+ * time (Welford).  The partial results are then merged pairwise (Chan,
+ * Pebay), which gives the moments of the whole sample without ever
+ * summing raw powers of the measurements.
  *
- * ListSampleMomentCalculator is the base class for all process objects that output
- * list sample data, and require list sample data as input. Specifically, this class
- * defines the SetInput() method for defining the input to a filter.
+ * The weights, if set, are indexed by the position of the measurements in
+ * the iteration order of the sample.  The covariance is normalized by
+ * W - W2 / W, where W and W2 are the sums of the weights and of the squared
+ * weights, which reduces to N - 1 without weights.
+ *
+ * The moments are computed on the first request after the input or the
+ * weights changed, so successive requests cost a single pass.
  *
  * \ingroup ListSampleFilters
  *
@@ -56,25 +74,91 @@ public:
   typedef TListSample                                    ListSampleType;
   typedef typename ListSampleType::MeasurementVectorType MeasurementVectorType;
 
+  typedef double                                         RealType;
+  typedef Array<RealType>                                WeightArrayType;
+  typedef Array<RealType>                                MeanType;
+  typedef VariableSizeMatrix<RealType>                   CovarianceType;
+
   /** Set the list sample input of this object.  */
   void SetInput( const ListSampleType *input );
 
   /** Get the list sample input of this object.  */
   ListSampleType * GetInput();
 
+  /** Set/Get the weights of the measurements.  NULL means no weights. */
+  void SetWeights( const WeightArrayType *weights );
+  const WeightArrayType * GetWeights() const
+    { return this->m_Weights; }
+
+  /** Compute all the moments.  Called as needed by the Get methods. */
+  void Compute();
+
   MeasurementVectorType GetMean();
 
+  /** Mean in double precision. */
+  const MeanType & GetMeanAsArray();
+
+  const CovarianceType & GetCovariance();
+
+  RealType GetSumOfWeights();
+
   MeasurementVectorType GetStandardizedMoment( unsigned int k );
 
 protected:
   ListSampleMomentCalculator();
   ~ListSampleMomentCalculator() {};
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Centered moments of a part of the sample. */
+  struct MomentAccumulatorType
+  {
+    RealType                                             SumOfWeights;
+    RealType                                             SumOfSquaredWeights;
+    std::vector<RealType>                                Mean;
+    std::vector<RealType>                                M2;
+    std::vector<RealType>                                M3;
+    std::vector<RealType>                                M4;
+    std::vector<RealType>                                CrossProducts;
+  };
+
+  static void InitializeAccumulator( MomentAccumulatorType &, unsigned int );
+
+  /** Add a single measurement of the given weight. */
+  static void AccumulateMeasurement( MomentAccumulatorType &,
+    const MeasurementVectorType &, RealType );
+
+  /** Merge the second accumulator into the first. */
+  static void MergeAccumulators( MomentAccumulatorType &,
+    const MomentAccumulatorType & );
+
+  /** Internal structure used for passing the accumulators to the threads.
+   * Thread t accumulates the instances [Offsets[t], Offsets[t + 1]), starting
+   * from the iterator Begins[t]. */
+  struct MomentThreadStruct
+  {
+    Self                                                *Filter;
+    std::vector<MomentAccumulatorType>                   Accumulators;
+    std::vector<unsigned long>                           Offsets;
+    std::vector<typename ListSampleType::ConstIterator>  Begins;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ComputeThreaderCallback( void *arg );
 
 private:
   ListSampleMomentCalculator( const Self& ); //purposely not implemented
   void operator=( const Self& ); //purposely not implemented
 
+  /** Compute the moments if the input or the weights changed. */
+  void ComputeIfNeeded();
+
   typename ListSampleType::ConstPointer              m_ListSample;
+  const WeightArrayType                             *m_Weights;
+
+  MomentAccumulatorType                              m_Moments;
+  MeanType                                           m_Mean;
+  CovarianceType                                     m_Covariance;
+  TimeStamp                                          m_ComputeTime;
 
 };
 
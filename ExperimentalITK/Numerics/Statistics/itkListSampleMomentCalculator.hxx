@@ -34,6 +34,8 @@ ListSampleMomentCalculator<TListSample>
 {
   // Modify superclass default values, can be overridden by subclasses
   this->SetNumberOfRequiredInputs( 1 );
+
+  this->m_Weights = NULL;
 }
 
 template <class TListSample>
@@ -42,6 +44,7 @@ ListSampleMomentCalculator<TListSample>
 ::SetInput( const TListSample *input )
 {
   this->m_ListSample = const_cast<ListSampleType *>( input );
+  this->Modified();
 }
 
 template <class TListSample>
@@ -53,33 +56,319 @@ ListSampleMomentCalculator<TListSample>
 }
 
 template <class TListSample>
-typename ListSampleMomentCalculator<TListSample>
-::MeasurementVectorType
+void
 ListSampleMomentCalculator<TListSample>
-::GetMean()
+::SetWeights( const WeightArrayType *weights )
 {
-  MeasurementVectorType mean;
-  mean.SetSize( this->GetInput()->GetMeasurementVectorSize() );
-  mean.Fill( 0.0 );
+  this->m_Weights = weights;
+  this->Modified();
+}
 
-  typename ListSampleType::ConstIterator It = this->GetInput()->Begin();
-  while( It != this->GetInput()->End() )
+template <class TListSample>
+void
+ListSampleMomentCalculator<TListSample>
+::InitializeAccumulator( MomentAccumulatorType & accumulator,
+  unsigned int measurementVectorSize )
+{
+  accumulator.SumOfWeights = 0.0;
+  accumulator.SumOfSquaredWeights = 0.0;
+  accumulator.Mean.assign( measurementVectorSize, 0.0 );
+  accumulator.M2.assign( measurementVectorSize, 0.0 );
+  accumulator.M3.assign( measurementVectorSize, 0.0 );
+  accumulator.M4.assign( measurementVectorSize, 0.0 );
+  accumulator.CrossProducts.assign(
+    measurementVectorSize * measurementVectorSize, 0.0 );
+}
+
+template <class TListSample>
+void
+ListSampleMomentCalculator<TListSample>
+::AccumulateMeasurement( MomentAccumulatorType & accumulator,
+  const MeasurementVectorType & measurement, RealType weight )
+{
+  if( weight == 0.0 )
     {
-    MeasurementVectorType measurement = It.GetMeasurementVector();
-    for( unsigned int d = 0; d < mean.Size(); d++ )
+    return;
+    }
+
+  const unsigned int measurementVectorSize = accumulator.Mean.size();
+
+  const RealType nA = accumulator.SumOfWeights;
+  const RealType n = nA + weight;
+  const RealType r = weight / n;
+
+  /**
+   * The cross products use the deviations from the previous mean, so they
+   * are updated first.  Only the upper triangle is accumulated.
+   */
+  for( unsigned int i = 0; i < measurementVectorSize; i++ )
+    {
+    RealType deltaI = r * nA * ( static_cast<RealType>( measurement[i] ) -
+      accumulator.Mean[i] );
+    for( unsigned int j = i; j < measurementVectorSize; j++ )
+      {
+      accumulator.CrossProducts[i * measurementVectorSize + j] += deltaI *
+        ( static_cast<RealType>( measurement[j] ) - accumulator.Mean[j] );
+      }
+    }
+
+  for( unsigned int i = 0; i < measurementVectorSize; i++ )
+    {
+    const RealType delta = static_cast<RealType>( measurement[i] ) -
+      accumulator.Mean[i];
+    const RealType delta2 = delta * delta;
+    const RealType M2 = accumulator.M2[i];
+    const RealType M3 = accumulator.M3[i];
+
+    accumulator.M4[i] += delta2 * delta2 * r * nA *
+      ( nA * nA - nA * weight + weight * weight ) / ( n * n ) +
+      6.0 * delta2 * r * r * M2 - 4.0 * delta * r * M3;
+    accumulator.M3[i] += delta2 * delta * r * nA * ( nA - weight ) / n -
+      3.0 * delta * r * M2;
+    accumulator.M2[i] += delta2 * r * nA;
+    accumulator.Mean[i] += delta * r;
+    }
+
+  accumulator.SumOfWeights = n;
+  accumulator.SumOfSquaredWeights += weight * weight;
+}
+
+template <class TListSample>
+void
+ListSampleMomentCalculator<TListSample>
+::MergeAccumulators( MomentAccumulatorType & accumulator,
+  const MomentAccumulatorType & other )
+{
+  if( other.SumOfWeights == 0.0 )
+    {
+    return;
+    }
+  if( accumulator.SumOfWeights == 0.0 )
+    {
+    accumulator = other;
+    return;
+    }
+
+  const unsigned int measurementVectorSize = accumulator.Mean.size();
+
+  const RealType nA = accumulator.SumOfWeights;
+  const RealType nB = other.SumOfWeights;
+  const RealType n = nA + nB;
+
+  for( unsigned int i = 0; i < measurementVectorSize; i++ )
+    {
+    RealType deltaI = nA * nB / n * ( other.Mean[i] - accumulator.Mean[i] );
+    for( unsigned int j = i; j < measurementVectorSize; j++ )
+      {
+      accumulator.CrossProducts[i * measurementVectorSize + j] +=
+        other.CrossProducts[i * measurementVectorSize + j] +
+        deltaI * ( other.Mean[j] - accumulator.Mean[j] );
+      }
+    }
+
+  for( unsigned int i = 0; i < measurementVectorSize; i++ )
+    {
+    const RealType delta = other.Mean[i] - accumulator.Mean[i];
+    const RealType delta2 = delta * delta;
+    const RealType M2A = accumulator.M2[i];
+    const RealType M3A = accumulator.M3[i];
+
+    accumulator.M4[i] += other.M4[i] + delta2 * delta2 * nA * nB *
+      ( nA * nA - nA * nB + nB * nB ) / ( n * n * n ) +
+      6.0 * delta2 * ( nA * nA * other.M2[i] + nB * nB * M2A ) / ( n * n ) +
+      4.0 * delta * ( nA * other.M3[i] - nB * M3A ) / n;
+    accumulator.M3[i] += other.M3[i] + delta2 * delta * nA * nB *
+      ( nA - nB ) / ( n * n ) +
+      3.0 * delta * ( nA * other.M2[i] - nB * M2A ) / n;
+    accumulator.M2[i] += other.M2[i] + delta2 * nA * nB / n;
+    accumulator.Mean[i] += delta * nB / n;
+    }
+
+  accumulator.SumOfWeights = n;
+  accumulator.SumOfSquaredWeights += other.SumOfSquaredWeights;
+}
+
+template <class TListSample>
+void
+ListSampleMomentCalculator<TListSample>
+::Compute()
+{
+  if( !this->m_ListSample )
+    {
+    itkExceptionMacro( "The input list sample has not been set." );
+    }
+  if( this->m_Weights &&
+    this->m_Weights->Size() != this->m_ListSample->Size() )
+    {
+    itkExceptionMacro( "The number of weights (" << this->m_Weights->Size()
+      << ") does not match the size of the list sample ("
+      << this->m_ListSample->Size() << ")." );
+    }
+
+  const unsigned int measurementVectorSize =
+    this->m_ListSample->GetMeasurementVectorSize();
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  const unsigned int numberOfThreads =
+    this->GetMultiThreader()->GetNumberOfThreads();
+
+  MomentThreadStruct str;
+  str.Filter = this;
+  str.Accumulators.resize( numberOfThreads );
+  for( unsigned int t = 0; t < str.Accumulators.size(); t++ )
+    {
+    InitializeAccumulator( str.Accumulators[t], measurementVectorSize );
+    }
+
+  /**
+   * Split the sample into one contiguous piece per thread.  The instance
+   * identifiers of a sample need not be contiguous, so the start of each
+   * piece is found with a single walk of the iterator, which is cheap next
+   * to the accumulation, rather than by instance identifier.
+   */
+  const unsigned long numberOfMeasurements = this->m_ListSample->Size();
+  str.Offsets.resize( numberOfThreads + 1 );
+  for( unsigned int t = 0; t <= numberOfThreads; t++ )
+    {
+    str.Offsets[t] = static_cast<unsigned long>( static_cast<double>(
+      numberOfMeasurements ) * t / numberOfThreads );
+    }
+  typename ListSampleType::ConstIterator It = this->m_ListSample->Begin();
+  unsigned long position = 0;
+  for( unsigned int t = 0; t < numberOfThreads; t++ )
+    {
+    for( ; position < str.Offsets[t]; position++ )
       {
-      mean[d] += measurement[d];
+      ++It;
       }
+    str.Begins.push_back( It );
+    }
+
+  this->GetMultiThreader()->SetSingleMethod(
+    this->ComputeThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  InitializeAccumulator( this->m_Moments, measurementVectorSize );
+  for( unsigned int t = 0; t < str.Accumulators.size(); t++ )
+    {
+    MergeAccumulators( this->m_Moments, str.Accumulators[t] );
+    }
+
+  this->m_Mean.SetSize( measurementVectorSize );
+  for( unsigned int i = 0; i < measurementVectorSize; i++ )
+    {
+    this->m_Mean[i] = this->m_Moments.Mean[i];
+    }
+
+  this->m_Covariance.SetSize( measurementVectorSize, measurementVectorSize );
+  this->m_Covariance.Fill( 0.0 );
+  RealType normalization = this->m_Moments.SumOfWeights;
+  if( normalization > 0.0 )
+    {
+    normalization -= this->m_Moments.SumOfSquaredWeights /
+      this->m_Moments.SumOfWeights;
+    }
+  if( normalization > 0.0 )
+    {
+    for( unsigned int i = 0; i < measurementVectorSize; i++ )
+      {
+      for( unsigned int j = i; j < measurementVectorSize; j++ )
+        {
+        RealType covariance = this->m_Moments.CrossProducts[
+          i * measurementVectorSize + j] / normalization;
+        this->m_Covariance( i, j ) = covariance;
+        this->m_Covariance( j, i ) = covariance;
+        }
+      }
+    }
+
+  this->m_ComputeTime.Modified();
+}
+
+template <class TListSample>
+ITK_THREAD_RETURN_TYPE
+ListSampleMomentCalculator<TListSample>
+::ComputeThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  MomentThreadStruct *str = static_cast<MomentThreadStruct *>( info->UserData );
+
+  const WeightArrayType *weights = str->Filter->m_Weights;
+
+  const unsigned long begin = str->Offsets[info->ThreadID];
+  const unsigned long end = str->Offsets[info->ThreadID + 1];
+
+  MomentAccumulatorType & accumulator = str->Accumulators[info->ThreadID];
+
+  typename ListSampleType::ConstIterator It = str->Begins[info->ThreadID];
+  for( unsigned long i = begin; i < end; i++ )
+    {
+    AccumulateMeasurement( accumulator, It.GetMeasurementVector(),
+      weights ? ( *weights )[i] : 1.0 );
     ++It;
     }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TListSample>
+void
+ListSampleMomentCalculator<TListSample>
+::ComputeIfNeeded()
+{
+  if( this->m_ComputeTime < this->GetMTime() ||
+    this->m_ComputeTime < this->m_ListSample->GetMTime() )
+    {
+    this->Compute();
+    }
+}
+
+template <class TListSample>
+typename ListSampleMomentCalculator<TListSample>
+::MeasurementVectorType
+ListSampleMomentCalculator<TListSample>
+::GetMean()
+{
+  this->ComputeIfNeeded();
+
+  MeasurementVectorType mean;
+  mean.SetSize( this->GetInput()->GetMeasurementVectorSize() );
   for( unsigned int d = 0; d < mean.Size(); d++ )
     {
-    mean[d] /= static_cast<double>( this->GetInput()->Size() );
+    mean[d] = this->m_Mean[d];
     }
 
   return mean;
 }
 
+template <class TListSample>
+const typename ListSampleMomentCalculator<TListSample>::MeanType &
+ListSampleMomentCalculator<TListSample>
+::GetMeanAsArray()
+{
+  this->ComputeIfNeeded();
+  return this->m_Mean;
+}
+
+template <class TListSample>
+const typename ListSampleMomentCalculator<TListSample>::CovarianceType &
+ListSampleMomentCalculator<TListSample>
+::GetCovariance()
+{
+  this->ComputeIfNeeded();
+  return this->m_Covariance;
+}
+
+template <class TListSample>
+typename ListSampleMomentCalculator<TListSample>::RealType
+ListSampleMomentCalculator<TListSample>
+::GetSumOfWeights()
+{
+  this->ComputeIfNeeded();
+  return this->m_Moments.SumOfWeights;
+}
+
 template <class TListSample>
 typename ListSampleMomentCalculator<TListSample>
 ::MeasurementVectorType
@@ -101,37 +390,65 @@ ListSampleMomentCalculator<TListSample>
     return moment;
     }
 
-  MeasurementVectorType mean = this->GetMean();
+  this->ComputeIfNeeded();
+
+  const RealType sumOfWeights = this->m_Moments.SumOfWeights;
+
+  if( k <= 4 )
+    {
+    const std::vector<RealType> & Mk = ( k == 2 ) ? this->m_Moments.M2 :
+      ( ( k == 3 ) ? this->m_Moments.M3 : this->m_Moments.M4 );
+    for( unsigned int d = 0; d < moment.Size(); d++ )
+      {
+      moment[d] = ( Mk[d] / sumOfWeights ) / vcl_pow( this->m_Moments.M2[d] /
+        sumOfWeights, 0.5 * static_cast<double>( k ) );
+      }
+    return moment;
+    }
 
+  /**
+   * Higher orders need a second pass around the mean.
+   */
   MeasurementVectorType numerator;
   numerator.SetSize( this->GetInput()->GetMeasurementVectorSize() );
   numerator.Fill( 0.0 );
-  MeasurementVectorType denominator;
-  denominator.SetSize( this->GetInput()->GetMeasurementVectorSize() );
-  denominator.Fill( 0.0 );
 
+  unsigned long i = 0;
   typename ListSampleType::ConstIterator It = this->GetInput()->Begin();
   while( It != this->GetInput()->End() )
     {
     MeasurementVectorType measurement = It.GetMeasurementVector();
-    for( unsigned int d = 0; d < mean.Size(); d++ )
+    RealType weight = this->m_Weights ? ( *this->m_Weights )[i] : 1.0;
+    for( unsigned int d = 0; d < moment.Size(); d++ )
       {
-      numerator[d] += vcl_pow( static_cast<double>( measurement[d] - mean[d] ),
-        static_cast<double>( k ) );
-      denominator[d] += vcl_pow( static_cast<double>( measurement[d] - mean[d] ),
-        static_cast<double>( 2.0 ) );
+      numerator[d] += weight * vcl_pow( static_cast<double>( measurement[d] -
+        this->m_Mean[d] ), static_cast<double>( k ) );
       }
     ++It;
+    ++i;
     }
   for( unsigned int d = 0; d < moment.Size(); d++ )
     {
-    moment[d] = ( numerator[d] / static_cast<double>( this->GetInput()->Size() ) ) /
-      vcl_pow( ( denominator[d] / static_cast<double>( this->GetInput()->Size() ) ),
-      0.5 * static_cast<double>( k ) );
+    moment[d] = ( numerator[d] / sumOfWeights ) / vcl_pow( this->m_Moments.M2[d]
+      / sumOfWeights, 0.5 * static_cast<double>( k ) );
     }
   return moment;
 }
 
+template <class TListSample>
+void
+ListSampleMomentCalculator<TListSample>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Weights: " << ( this->m_Weights ? "set" : "not set" )
+    << std::endl;
+  os << indent << "Mean: " << this->m_Mean << std::endl;
+  os << indent << "Covariance: " << std::endl << this->m_Covariance
+    << std::endl;
+}
+
 } // end of namespace Statistics
 } // end of namespace itk
 
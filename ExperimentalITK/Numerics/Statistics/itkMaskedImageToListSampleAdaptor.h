@@ -0,0 +1,282 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMaskedImageToListSampleAdaptor.h,v $
+  Language:  C++
+  Date:      $Date: 2009-05-02 05:43:56 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMaskedImageToListSampleAdaptor_h
+#define __itkMaskedImageToListSampleAdaptor_h
+
+#include "itkSample.h"
+#include "itkPixelTraits.h"
+#include "itkMeasurementVectorTraits.h"
+
+#include <vector>
+
+namespace itk {
+namespace Statistics {
+
+/** \class MaskedImageToListSampleAdaptor
+ *  \brief Presents the pixels of an image, optionally restricted to a mask,
+ *  as a list sample without copying them.
+ *
+ *  Contrary to ImageToListSampleFilter, no measurement vector is stored.
+ *  Only the buffer offsets of the selected pixels are kept, in a contiguous
+ *  list, and the measurement vectors are read from the image on access.
+ *  The instance identifiers are 0, ..., Size() - 1 in the order of the
+ *  offsets, i.e. the same order as the output of ImageToListSampleFilter
+ *  for the same image and mask.
+ *
+ *  The selected pixels are given either by a mask image and a mask value,
+ *  or directly by a precomputed list of buffer offsets.  Without either,
+ *  all the pixels of the buffered region are used and no list is stored.
+ *
+ *  The class provides the interface of ListSample used by the list sample
+ *  functions and filters (Size(), GetMeasurementVector(), GetFrequency(),
+ *  Begin(), End() and a ConstIterator), so it can be used as their list
+ *  sample template argument.  The image must not be reallocated while it
+ *  is adapted.  GaussianListSampleFunction,
+ *  HistogramParzenWindowsListSampleFunction and
+ *  ManifoldParzenWindowsListSampleFunction only walk their input through
+ *  this interface and take the adaptor directly, e.g.
+ *  GaussianListSampleFunction<MaskedImageToListSampleAdaptor<ImageType,
+ *  MaskImageType>, float, float>.  GrubbsRosnerListSampleFilter and
+ *  BoxPlotQuantileListSampleFilter produce an owning ListSample of their
+ *  input type and therefore still need a ListSample input.
+ *
+ *  GetMeasurementVector( id ) returns a reference to an internal cache and
+ *  is therefore not thread safe.  Multithreaded callers should use the
+ *  overload which fills a caller provided measurement vector, or one
+ *  ConstIterator per thread.
+ *
+ * \sa ImageToListSampleFilter
+ */
+template < class TImage, class TMaskImage = TImage >
+class ITK_EXPORT MaskedImageToListSampleAdaptor :
+  public Sample< typename MeasurementVectorPixelTraits<
+    typename TImage::PixelType >::MeasurementVectorType >
+{
+public:
+  /** Standard class typedefs */
+  typedef MaskedImageToListSampleAdaptor    Self;
+  typedef Sample< typename MeasurementVectorPixelTraits<
+    typename TImage::PixelType >::MeasurementVectorType > Superclass;
+  typedef SmartPointer< Self >              Pointer;
+  typedef SmartPointer<const Self>          ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MaskedImageToListSampleAdaptor, Sample);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Image typedefs */
+  typedef TImage                                      ImageType;
+  typedef typename ImageType::ConstPointer            ImageConstPointer;
+  typedef typename ImageType::PixelType               PixelType;
+  typedef typename ImageType::InternalPixelType       InternalPixelType;
+  typedef typename ImageType::OffsetValueType         OffsetValueType;
+  typedef typename ImageType::NeighborhoodAccessorFunctorType
+                                                      AccessorType;
+
+  /** Mask Image typedefs */
+  typedef TMaskImage                                  MaskImageType;
+  typedef typename MaskImageType::ConstPointer        MaskImageConstPointer;
+  typedef typename MaskImageType::PixelType           MaskPixelType;
+
+  /** Superclass typedefs */
+  typedef typename Superclass::MeasurementVectorType  MeasurementVectorType;
+  typedef typename Superclass::MeasurementType        MeasurementType;
+  typedef typename Superclass::InstanceIdentifier     InstanceIdentifier;
+  typedef typename Superclass::AbsoluteFrequencyType  AbsoluteFrequencyType;
+  typedef typename Superclass::TotalAbsoluteFrequencyType
+                                                      TotalAbsoluteFrequencyType;
+  typedef typename Superclass::MeasurementVectorSizeType
+                                                      MeasurementVectorSizeType;
+
+  /** Buffer offsets of the adapted pixels */
+  typedef std::vector<OffsetValueType>                InstanceOffsetContainerType;
+
+  /** Method to set/get the image */
+  void SetImage( const ImageType* image );
+  const ImageType* GetImage() const;
+
+  /** Method to set/get the mask.  The offsets of the pixels equal to the
+   * mask value are collected when the mask or the mask value is set. */
+  void SetMaskImage( const MaskImageType* image );
+  const MaskImageType* GetMaskImage() const;
+
+  /** Set/Get the pixel value treated as on in the mask. */
+  void SetMaskValue( const MaskPixelType value );
+  itkGetConstMacro( MaskValue, MaskPixelType );
+
+  /** Set/Get the buffer offsets of the pixels directly.  This removes the
+   * mask. */
+  void SetInstanceOffsets( const InstanceOffsetContainerType & );
+  const InstanceOffsetContainerType & GetInstanceOffsets() const
+    { return this->m_InstanceOffsets; }
+
+  /** Buffer offset of an instance */
+  OffsetValueType GetOffset( InstanceIdentifier id ) const
+    {
+    return ( this->m_UseInstanceOffsets ? this->m_InstanceOffsets[id]
+      : static_cast<OffsetValueType>( id ) );
+    }
+
+  /** Number of measurement vectors */
+  InstanceIdentifier Size() const;
+
+  /** Method to get the measurement vector of an instance. Not thread safe,
+   * see the class documentation. */
+  const MeasurementVectorType & GetMeasurementVector( InstanceIdentifier id ) const;
+
+  /** Thread safe variant of the above. */
+  void GetMeasurementVector( InstanceIdentifier id,
+    MeasurementVectorType & measurement ) const;
+
+  /** Every instance has a frequency of one. */
+  AbsoluteFrequencyType GetFrequency( InstanceIdentifier id ) const;
+  TotalAbsoluteFrequencyType GetTotalFrequency() const;
+
+  /** \class ConstIterator
+   * \brief Iterates over the adapted pixels in identifier order.
+   */
+  class ConstIterator
+  {
+    friend class MaskedImageToListSampleAdaptor;
+  public:
+
+    ConstIterator( const MaskedImageToListSampleAdaptor *adaptor )
+      {
+      *this = adaptor->Begin();
+      }
+
+    ConstIterator( const ConstIterator & iter )
+      {
+      this->m_Adaptor = iter.m_Adaptor;
+      this->m_InstanceIdentifier = iter.m_InstanceIdentifier;
+      this->m_MeasurementVectorCache = iter.m_MeasurementVectorCache;
+      }
+
+    ConstIterator & operator=( const ConstIterator & iter )
+      {
+      this->m_Adaptor = iter.m_Adaptor;
+      this->m_InstanceIdentifier = iter.m_InstanceIdentifier;
+      this->m_MeasurementVectorCache = iter.m_MeasurementVectorCache;
+      return *this;
+      }
+
+    AbsoluteFrequencyType GetFrequency() const
+      {
+      return 1;
+      }
+
+    const MeasurementVectorType & GetMeasurementVector() const
+      {
+      this->m_Adaptor->GetMeasurementVector( this->m_InstanceIdentifier,
+        this->m_MeasurementVectorCache );
+      return this->m_MeasurementVectorCache;
+      }
+
+    InstanceIdentifier GetInstanceIdentifier() const
+      {
+      return this->m_InstanceIdentifier;
+      }
+
+    ConstIterator & operator++()
+      {
+      ++this->m_InstanceIdentifier;
+      return *this;
+      }
+
+    bool operator!=( const ConstIterator & it )
+      {
+      return ( this->m_InstanceIdentifier != it.m_InstanceIdentifier );
+      }
+
+    bool operator==( const ConstIterator & it )
+      {
+      return ( this->m_InstanceIdentifier == it.m_InstanceIdentifier );
+      }
+
+  protected:
+    // This method should only be available to the adaptor
+    ConstIterator( const MaskedImageToListSampleAdaptor *adaptor,
+      InstanceIdentifier id )
+      {
+      this->m_Adaptor = adaptor;
+      this->m_InstanceIdentifier = id;
+      MeasurementVectorTraits::SetLength( this->m_MeasurementVectorCache,
+        adaptor->GetMeasurementVectorSize() );
+      }
+
+    // This method is purposely not implemented
+    ConstIterator();
+
+  private:
+    const MaskedImageToListSampleAdaptor         *m_Adaptor;
+    InstanceIdentifier                            m_InstanceIdentifier;
+    mutable MeasurementVectorType                 m_MeasurementVectorCache;
+  };
+
+  /** Returns an iterator that points to the first instance */
+  ConstIterator Begin() const
+    {
+    ConstIterator iter( this, 0 );
+    return iter;
+    }
+
+  /** Returns an iterator that points past the last instance */
+  ConstIterator End() const
+    {
+    ConstIterator iter( this, this->Size() );
+    return iter;
+    }
+
+protected:
+  MaskedImageToListSampleAdaptor();
+  virtual ~MaskedImageToListSampleAdaptor() {}
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** Collect the offsets of the pixels of the mask equal to the mask value. */
+  void ComputeInstanceOffsets();
+
+  /** Set the measurement vector size from the image. */
+  void UpdateMeasurementVectorSize();
+
+private:
+  MaskedImageToListSampleAdaptor(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  ImageConstPointer                         m_Image;
+  MaskImageConstPointer                     m_MaskImage;
+  MaskPixelType                             m_MaskValue;
+
+  InstanceOffsetContainerType               m_InstanceOffsets;
+  bool                                      m_UseInstanceOffsets;
+
+  AccessorType                              m_Accessor;
+  const InternalPixelType                  *m_Buffer;
+
+  mutable MeasurementVectorType             m_MeasurementVectorInternal;
+
+}; // end of class MaskedImageToListSampleAdaptor
+
+} // end of namespace Statistics
+} // end of namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMaskedImageToListSampleAdaptor.hxx"
+#endif
+
+#endif
@@ -0,0 +1,267 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMaskedImageToListSampleAdaptor.hxx,v $
+  Language:  C++
+  Date:      $Date: 2009-05-02 05:43:56 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMaskedImageToListSampleAdaptor_hxx
+#define __itkMaskedImageToListSampleAdaptor_hxx
+
+#include "itkMaskedImageToListSampleAdaptor.h"
+#include "itkImageRegionConstIterator.h"
+
+namespace itk {
+namespace Statistics {
+
+template < class TImage, class TMaskImage >
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::MaskedImageToListSampleAdaptor()
+{
+  this->m_Image = NULL;
+  this->m_MaskImage = NULL;
+  this->m_MaskValue = NumericTraits< MaskPixelType >::max();
+  this->m_UseInstanceOffsets = false;
+  this->m_Buffer = NULL;
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::PrintSelf(std::ostream& os, Indent indent) const
+{
+  Superclass::PrintSelf(os,indent);
+
+  os << indent << "Image: ";
+  if( this->m_Image.IsNotNull() )
+    {
+    os << this->m_Image << std::endl;
+    }
+  else
+    {
+    os << "not set." << std::endl;
+    }
+  os << indent << "MaskImage: ";
+  if( this->m_MaskImage.IsNotNull() )
+    {
+    os << this->m_MaskImage << std::endl;
+    }
+  else
+    {
+    os << "not set." << std::endl;
+    }
+  os << indent << "MaskValue: "
+     << static_cast<typename NumericTraits<MaskPixelType>::PrintType>(
+       this->m_MaskValue)
+     << std::endl;
+  os << indent << "Number of instances: " << this->Size() << std::endl;
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::SetImage( const ImageType* image )
+{
+  this->m_Image = image;
+  this->m_Buffer = NULL;
+  if( image )
+    {
+    this->m_Buffer = image->GetBufferPointer();
+    this->m_Accessor = image->GetNeighborhoodAccessor();
+    this->m_Accessor.SetBegin( this->m_Buffer );
+    this->UpdateMeasurementVectorSize();
+    }
+  if( this->m_MaskImage.IsNotNull() )
+    {
+    this->ComputeInstanceOffsets();
+    }
+  this->Modified();
+}
+
+template < class TImage, class TMaskImage >
+const TImage*
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::GetImage() const
+{
+  return this->m_Image.GetPointer();
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::SetMaskImage( const MaskImageType* image )
+{
+  this->m_MaskImage = image;
+  this->ComputeInstanceOffsets();
+  this->Modified();
+}
+
+template < class TImage, class TMaskImage >
+const TMaskImage*
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::GetMaskImage() const
+{
+  return this->m_MaskImage.GetPointer();
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::SetMaskValue( const MaskPixelType value )
+{
+  if( this->m_MaskValue == value )
+    {
+    return;
+    }
+  this->m_MaskValue = value;
+  if( this->m_MaskImage.IsNotNull() )
+    {
+    this->ComputeInstanceOffsets();
+    }
+  this->Modified();
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::SetInstanceOffsets( const InstanceOffsetContainerType & offsets )
+{
+  this->m_MaskImage = NULL;
+  this->m_InstanceOffsets = offsets;
+  this->m_UseInstanceOffsets = true;
+  this->Modified();
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::ComputeInstanceOffsets()
+{
+  this->m_InstanceOffsets.clear();
+  this->m_UseInstanceOffsets = false;
+
+  if( this->m_MaskImage.IsNull() )
+    {
+    return;
+    }
+
+  if( this->m_Image.IsNotNull() && this->m_Image->GetBufferedRegion()
+    != this->m_MaskImage->GetBufferedRegion() )
+    {
+    itkExceptionMacro( "BufferedRegion of the mask does not match the one "
+      << "for the image" );
+    }
+
+  /**
+   * The offsets are collected in buffer order so that the instances are
+   * visited in the same order as the output of ImageToListSampleFilter and
+   * the image is read sequentially.
+   */
+  typedef ImageRegionConstIterator< MaskImageType > MaskIteratorType;
+  MaskIteratorType mit( this->m_MaskImage,
+    this->m_MaskImage->GetBufferedRegion() );
+
+  OffsetValueType offset = 0;
+  for( mit.GoToBegin(); !mit.IsAtEnd(); ++mit, ++offset )
+    {
+    if( mit.Get() == this->m_MaskValue )
+      {
+      this->m_InstanceOffsets.push_back( offset );
+      }
+    }
+  this->m_UseInstanceOffsets = true;
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::UpdateMeasurementVectorSize()
+{
+  MeasurementVectorType m;
+  MeasurementVectorSizeType measurementVectorSize;
+
+  if( !MeasurementVectorTraits::IsResizable( m ) )
+    {
+    measurementVectorSize = MeasurementVectorTraits::GetLength( m );
+    }
+  else
+    {
+    measurementVectorSize = this->m_Image->GetNumberOfComponentsPerPixel();
+    }
+  this->SetMeasurementVectorSize( measurementVectorSize );
+  MeasurementVectorTraits::SetLength( this->m_MeasurementVectorInternal,
+    measurementVectorSize );
+}
+
+template < class TImage, class TMaskImage >
+typename MaskedImageToListSampleAdaptor< TImage, TMaskImage >::InstanceIdentifier
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::Size() const
+{
+  if( this->m_UseInstanceOffsets )
+    {
+    return static_cast<InstanceIdentifier>( this->m_InstanceOffsets.size() );
+    }
+  if( this->m_Image.IsNull() )
+    {
+    return 0;
+    }
+  return static_cast<InstanceIdentifier>(
+    this->m_Image->GetBufferedRegion().GetNumberOfPixels() );
+}
+
+template < class TImage, class TMaskImage >
+const typename MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+  ::MeasurementVectorType &
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::GetMeasurementVector( InstanceIdentifier id ) const
+{
+  this->GetMeasurementVector( id, this->m_MeasurementVectorInternal );
+  return this->m_MeasurementVectorInternal;
+}
+
+template < class TImage, class TMaskImage >
+void
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::GetMeasurementVector( InstanceIdentifier id,
+  MeasurementVectorType & measurement ) const
+{
+  if( this->m_Buffer == NULL )
+    {
+    itkExceptionMacro( "Image has not been set yet" );
+    }
+  MeasurementVectorTraits::Assign( measurement,
+    this->m_Accessor.Get( this->m_Buffer + this->GetOffset( id ) ) );
+}
+
+template < class TImage, class TMaskImage >
+typename MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+  ::AbsoluteFrequencyType
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::GetFrequency( InstanceIdentifier itkNotUsed( id ) ) const
+{
+  return 1;
+}
+
+template < class TImage, class TMaskImage >
+typename MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+  ::TotalAbsoluteFrequencyType
+MaskedImageToListSampleAdaptor< TImage, TMaskImage >
+::GetTotalFrequency() const
+{
+  return static_cast<TotalAbsoluteFrequencyType>( this->Size() );
+}
+
+} // end of namespace Statistics
+} // end of namespace itk
+
+#endif
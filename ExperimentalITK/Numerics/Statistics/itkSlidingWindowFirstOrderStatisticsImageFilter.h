@@ -0,0 +1,185 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkSlidingWindowFirstOrderStatisticsImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkSlidingWindowFirstOrderStatisticsImageFilter_h
+#define __itkSlidingWindowFirstOrderStatisticsImageFilter_h
+
+#include "itkImageToImageFilter.h"
+
+#include "vnl/vnl_math.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class SlidingWindowFirstOrderStatisticsImageFilter
+ * \brief First order statistics in a box neighborhood of each pixel,
+ * updated incrementally as the box slides over the image.
+ *
+ * The output is a VectorImage whose components are, in this order, the
+ * mean, minimum, maximum, variance, standard deviation, skewness, kurtosis,
+ * entropy, median, 5th percentile and 95th percentile of the pixels of the
+ * box of size 2 * Radius + 1, the pixels outside the image being ignored.
+ * The first eight components are those of
+ * NeighborhoodFirstOrderStatisticsImageFilter with a box kernel.
+ *
+ * The box is separable, so the power sums of the pixels, from which the
+ * moments are computed, are running sums along the lines of one dimension
+ * after another, and the minimum and maximum are running extrema along the
+ * lines with monotone queues.  Each pixel then costs a few operations per
+ * dimension instead of a visit of all the pixels of the box.  A box whose
+ * minimum and maximum agree, or whose variance is within the rounding noise
+ * of the running sums, has a variance, skewness and kurtosis of 0.
+ *
+ * The entropy, median and percentiles come from a histogram of
+ * NumberOfHistogramBins bins which slides along the rows, a face of the
+ * box being added and another removed at each step.  For integer images
+ * whose range fits in the bins, and for images with at most
+ * NumberOfHistogramBins distinct values, each bin is a single value and
+ * the entropy is that of the values, as for
+ * NeighborhoodFirstOrderStatisticsImageFilter.  Otherwise the bins have
+ * equal widths and the entropy is that of the binned values.
+ * The histogram can be skipped with ComputeHistogramStatisticsOff(), the
+ * corresponding components being 0.
+ *
+ * The lines of each pass are shared among the threads.
+ *
+ * \sa NeighborhoodFirstOrderStatisticsImageFilter
+ */
+template <class TInputImage, class TOutputImage>
+class ITK_EXPORT SlidingWindowFirstOrderStatisticsImageFilter
+: public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef SlidingWindowFirstOrderStatisticsImageFilter        Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>       Superclass;
+  typedef SmartPointer<Self>                                  Pointer;
+  typedef SmartPointer<const Self>                            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SlidingWindowFirstOrderStatisticsImageFilter,
+    ImageToImageFilter );
+
+  /** Extract dimension from input image. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+                       TInputImage::ImageDimension );
+
+  /** Image typedef support. */
+  typedef TInputImage                                         InputImageType;
+  typedef TOutputImage                                        OutputImageType;
+  typedef typename InputImageType::PixelType                  InputPixelType;
+  typedef typename OutputImageType::InternalPixelType         OutputValueType;
+  typedef typename InputImageType::RegionType                 RegionType;
+  typedef typename RegionType::SizeType                       SizeType;
+
+  /** Other typedef */
+  typedef double                                              RealType;
+
+  /** Number of components of the output. */
+  itkStaticConstMacro( NumberOfOutputComponents, unsigned int, 11 );
+
+  /** Set/Get the radius of the box. */
+  itkSetMacro( Radius, SizeType );
+  itkGetConstMacro( Radius, SizeType );
+
+  /** Set/Get if the entropy, median and percentiles are computed. */
+  itkSetMacro( ComputeHistogramStatistics, bool );
+  itkGetConstMacro( ComputeHistogramStatistics, bool );
+  itkBooleanMacro( ComputeHistogramStatistics );
+
+  /** Set/Get the largest number of bins of the histogram. */
+  itkSetMacro( NumberOfHistogramBins, unsigned int );
+  itkGetConstMacro( NumberOfHistogramBins, unsigned int );
+
+protected:
+  SlidingWindowFirstOrderStatisticsImageFilter();
+  virtual ~SlidingWindowFirstOrderStatisticsImageFilter() {}
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  void GenerateOutputInformation();
+  void GenerateInputRequestedRegion();
+  void EnlargeOutputRequestedRegion( DataObject * );
+
+  void GenerateData();
+
+  /** Internal structure used for passing the passes to the threads.  The
+   * pass along the dimension d reads the buffers ( d + 1 ) % 2, or the
+   * input for the first one, and writes the buffers d % 2.  The pass
+   * ImageDimension writes the output. */
+  struct StatisticsThreadStruct
+  {
+    Self                                                     *Filter;
+    unsigned int                                              Dimension;
+    RealType                                                  Shift;
+    std::vector<RealType>                                     PowerSums[2];
+    std::vector<RealType>                                     Minima[2];
+    std::vector<RealType>                                     Maxima[2];
+    std::vector<unsigned int>                                 Bins;
+    unsigned int                                              NumberOfBins;
+    RealType                                                  HistogramMinimum;
+    RealType                                                  BinWidth;
+    std::vector<RealType>                                     BinValues;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE SlideThreaderCallback( void *arg );
+
+  /** Running sums and extrema along the lines of str->Dimension. */
+  void ThreadedSlideLines( StatisticsThreadStruct *str, ThreadIdType threadId,
+    ThreadIdType numberOfThreads );
+
+  /** Statistics of the rows, with the sliding histogram. */
+  void ThreadedWriteRows( StatisticsThreadStruct *str, ThreadIdType threadId,
+    ThreadIdType numberOfThreads );
+
+  /** First and last (inclusive) positions of the box around position i of
+   * a line of the dimension d. */
+  void GetWindow( unsigned int d, SizeValueType i, SizeValueType & first,
+    SizeValueType & last ) const
+    {
+    first = ( i > this->m_Radius[d] ) ? i - this->m_Radius[d] : 0;
+    last = vnl_math_min( i + this->m_Radius[d], this->m_Size[d] - 1 );
+    }
+
+  /** Value of the quantile p of a histogram. */
+  RealType GetHistogramQuantile( const StatisticsThreadStruct *str,
+    const std::vector<SizeValueType> & histogram, SizeValueType total,
+    RealType p ) const;
+
+private:
+  SlidingWindowFirstOrderStatisticsImageFilter( const Self & ); //purposely not implemented
+  void operator=( const Self & ); //purposely not implemented
+
+  SizeType                                                    m_Radius;
+  bool                                                        m_ComputeHistogramStatistics;
+  unsigned int                                                m_NumberOfHistogramBins;
+
+  SizeType                                                    m_Size;
+  OffsetValueType                                             m_Strides[ImageDimension];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSlidingWindowFirstOrderStatisticsImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,552 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkSlidingWindowFirstOrderStatisticsImageFilter.hxx,v $
+  Language:  C++
+  Date:      $Date: 2008/10/18 00:16:52 $
+  Version:   $Revision: 1.1.1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkSlidingWindowFirstOrderStatisticsImageFilter_hxx
+#define __itkSlidingWindowFirstOrderStatisticsImageFilter_hxx
+
+#include "itkSlidingWindowFirstOrderStatisticsImageFilter.h"
+
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <set>
+
+namespace itk
+{
+
+template <class TInputImage, class TOutputImage>
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::SlidingWindowFirstOrderStatisticsImageFilter()
+{
+  this->m_Radius.Fill( 1 );
+  this->m_ComputeHistogramStatistics = true;
+  this->m_NumberOfHistogramBins = 256;
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  OutputImageType *output = this->GetOutput();
+  if( output && output->GetNumberOfComponentsPerPixel()
+    != NumberOfOutputComponents )
+    {
+    output->SetNumberOfComponentsPerPixel( NumberOfOutputComponents );
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+  if( this->GetInput() )
+    {
+    InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+    input->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::EnlargeOutputRequestedRegion( DataObject *output )
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType *input = this->GetInput();
+  const InputPixelType *buffer = input->GetBufferPointer();
+
+  this->m_Size = input->GetBufferedRegion().GetSize();
+  const SizeValueType numberOfPixels =
+    input->GetBufferedRegion().GetNumberOfPixels();
+  if( numberOfPixels == 0 )
+    {
+    return;
+    }
+  this->m_Strides[0] = 1;
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    this->m_Strides[d] = this->m_Strides[d - 1]
+      * static_cast<OffsetValueType>( this->m_Size[d - 1] );
+    }
+
+  /**
+   * The power sums are taken about the mean of the image to limit the
+   * cancellations in the central moments.
+   */
+  StatisticsThreadStruct str;
+  str.Filter = this;
+
+  RealType minimum = NumericTraits<RealType>::max();
+  RealType maximum = NumericTraits<RealType>::NonpositiveMin();
+  RealType sum = 0.0;
+  for( SizeValueType n = 0; n < numberOfPixels; n++ )
+    {
+    const RealType value = static_cast<RealType>( buffer[n] );
+    minimum = vnl_math_min( minimum, value );
+    maximum = vnl_math_max( maximum, value );
+    sum += value;
+    }
+  str.Shift = sum / static_cast<RealType>( numberOfPixels );
+
+  /**
+   * Bins of the pixels.  For integer images whose range fits in the
+   * histogram, and for images with at most as many distinct values as
+   * bins, each bin is a single value.
+   */
+  str.NumberOfBins = vnl_math_max( this->m_NumberOfHistogramBins, 1u );
+  str.HistogramMinimum = minimum;
+  str.BinWidth = 1.0;
+  str.BinValues.clear();
+  if( NumericTraits<InputPixelType>::is_integer &&
+    maximum - minimum < static_cast<RealType>( str.NumberOfBins ) )
+    {
+    str.NumberOfBins = static_cast<unsigned int>( maximum - minimum ) + 1;
+    for( unsigned int n = 0; n < str.NumberOfBins; n++ )
+      {
+      str.BinValues.push_back( minimum + static_cast<RealType>( n ) );
+      }
+    }
+  else if( this->m_ComputeHistogramStatistics )
+    {
+    std::set<RealType> values;
+    for( SizeValueType n = 0; n < numberOfPixels &&
+      values.size() <= str.NumberOfBins; n++ )
+      {
+      values.insert( static_cast<RealType>( buffer[n] ) );
+      }
+    if( values.size() <= str.NumberOfBins )
+      {
+      str.BinValues.assign( values.begin(), values.end() );
+      str.NumberOfBins = static_cast<unsigned int>( str.BinValues.size() );
+      }
+    else
+      {
+      str.BinWidth = ( maximum - minimum )
+        / static_cast<RealType>( str.NumberOfBins );
+      }
+    }
+  if( this->m_ComputeHistogramStatistics )
+    {
+    str.Bins.resize( numberOfPixels );
+    if( !str.BinValues.empty() )
+      {
+      for( SizeValueType n = 0; n < numberOfPixels; n++ )
+        {
+        str.Bins[n] = static_cast<unsigned int>( std::lower_bound(
+          str.BinValues.begin(), str.BinValues.end(),
+          static_cast<RealType>( buffer[n] ) ) - str.BinValues.begin() );
+        }
+      }
+    else
+      {
+      const RealType scale = ( str.BinWidth > 0.0 ) ? 1.0 / str.BinWidth : 0.0;
+      const unsigned int lastBin = str.NumberOfBins - 1;
+      for( SizeValueType n = 0; n < numberOfPixels; n++ )
+        {
+        str.Bins[n] = vnl_math_min( static_cast<unsigned int>( scale *
+          ( static_cast<RealType>( buffer[n] ) - minimum ) ), lastBin );
+        }
+      }
+    }
+
+  const unsigned int numberOfBuffers = ( ImageDimension > 1 ) ? 2 : 1;
+  for( unsigned int b = 0; b < numberOfBuffers; b++ )
+    {
+    str.PowerSums[b].resize( 4 * numberOfPixels );
+    str.Minima[b].resize( numberOfPixels );
+    str.Maxima[b].resize( numberOfPixels );
+    }
+
+  /**
+   * One pass along each dimension, then the output.
+   */
+  for( unsigned int d = 0; d <= ImageDimension; d++ )
+    {
+    str.Dimension = d;
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod(
+      this->SlideThreaderCallback, &str );
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+ITK_THREAD_RETURN_TYPE
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::SlideThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  StatisticsThreadStruct *str =
+    static_cast<StatisticsThreadStruct *>( info->UserData );
+
+  if( str->Dimension < ImageDimension )
+    {
+    str->Filter->ThreadedSlideLines( str, info->ThreadID,
+      info->NumberOfThreads );
+    }
+  else
+    {
+    str->Filter->ThreadedWriteRows( str, info->ThreadID,
+      info->NumberOfThreads );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::ThreadedSlideLines( StatisticsThreadStruct *str, ThreadIdType threadId,
+  ThreadIdType numberOfThreads )
+{
+  const unsigned int d = str->Dimension;
+  const SizeValueType length = this->m_Size[d];
+  const SizeValueType radius = this->m_Radius[d];
+  const OffsetValueType stride = this->m_Strides[d];
+  const SizeValueType numberOfLines =
+    this->GetInput()->GetBufferedRegion().GetNumberOfPixels() / length;
+  const SizeValueType firstLine = numberOfLines * threadId / numberOfThreads;
+  const SizeValueType lastLine =
+    numberOfLines * ( threadId + 1 ) / numberOfThreads;
+
+  const InputPixelType *buffer = this->GetInput()->GetBufferPointer();
+  const RealType *inputSums = ( d > 0 ) ? &str->PowerSums[( d + 1 ) % 2][0] : NULL;
+  const RealType *inputMinima = ( d > 0 ) ? &str->Minima[( d + 1 ) % 2][0] : NULL;
+  const RealType *inputMaxima = ( d > 0 ) ? &str->Maxima[( d + 1 ) % 2][0] : NULL;
+  RealType *outputSums = &str->PowerSums[d % 2][0];
+  RealType *outputMinima = &str->Minima[d % 2][0];
+  RealType *outputMaxima = &str->Maxima[d % 2][0];
+
+  std::vector<RealType> sums( 4 * length );
+  std::vector<RealType> minima( length );
+  std::vector<RealType> maxima( length );
+  std::vector<SizeValueType> minimumQueue( length );
+  std::vector<SizeValueType> maximumQueue( length );
+
+  for( SizeValueType l = firstLine; l < lastLine; l++ )
+    {
+    const OffsetValueType lineStart = static_cast<OffsetValueType>( l % stride )
+      + static_cast<OffsetValueType>( l / stride ) * stride
+      * static_cast<OffsetValueType>( length );
+
+    /**
+     * Load the line.
+     */
+    OffsetValueType offset = lineStart;
+    for( SizeValueType i = 0; i < length; i++, offset += stride )
+      {
+      if( d == 0 )
+        {
+        const RealType value = static_cast<RealType>( buffer[offset] );
+        const RealType y = value - str->Shift;
+        sums[4 * i] = y;
+        sums[4 * i + 1] = y * y;
+        sums[4 * i + 2] = y * y * y;
+        sums[4 * i + 3] = y * y * y * y;
+        minima[i] = maxima[i] = value;
+        }
+      else
+        {
+        for( unsigned int p = 0; p < 4; p++ )
+          {
+          sums[4 * i + p] = inputSums[4 * offset + p];
+          }
+        minima[i] = inputMinima[offset];
+        maxima[i] = inputMaxima[offset];
+        }
+      }
+
+    /**
+     * Running sums, and monotone queues of the positions whose value can
+     * still be the extremum of a later window.
+     */
+    RealType s[4] = { 0.0, 0.0, 0.0, 0.0 };
+    SizeValueType next = 0;
+    SizeValueType minimumHead = 0;
+    SizeValueType minimumTail = 0;
+    SizeValueType maximumHead = 0;
+    SizeValueType maximumTail = 0;
+
+    offset = lineStart;
+    for( SizeValueType i = 0; i < length; i++, offset += stride )
+      {
+      SizeValueType first;
+      SizeValueType last;
+      this->GetWindow( d, i, first, last );
+
+      for( ; next <= last; next++ )
+        {
+        for( unsigned int p = 0; p < 4; p++ )
+          {
+          s[p] += sums[4 * next + p];
+          }
+        while( minimumTail > minimumHead &&
+          minima[minimumQueue[minimumTail - 1]] >= minima[next] )
+          {
+          minimumTail--;
+          }
+        minimumQueue[minimumTail++] = next;
+        while( maximumTail > maximumHead &&
+          maxima[maximumQueue[maximumTail - 1]] <= maxima[next] )
+          {
+          maximumTail--;
+          }
+        maximumQueue[maximumTail++] = next;
+        }
+      if( i > radius )
+        {
+        for( unsigned int p = 0; p < 4; p++ )
+          {
+          s[p] -= sums[4 * ( first - 1 ) + p];
+          }
+        }
+      while( minimumQueue[minimumHead] < first )
+        {
+        minimumHead++;
+        }
+      while( maximumQueue[maximumHead] < first )
+        {
+        maximumHead++;
+        }
+
+      for( unsigned int p = 0; p < 4; p++ )
+        {
+        outputSums[4 * offset + p] = s[p];
+        }
+      outputMinima[offset] = minima[minimumQueue[minimumHead]];
+      outputMaxima[offset] = maxima[maximumQueue[maximumHead]];
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::ThreadedWriteRows( StatisticsThreadStruct *str, ThreadIdType threadId,
+  ThreadIdType numberOfThreads )
+{
+  const SizeValueType length = this->m_Size[0];
+  const SizeValueType radius = this->m_Radius[0];
+  const SizeValueType numberOfRows =
+    this->GetInput()->GetBufferedRegion().GetNumberOfPixels() / length;
+  const SizeValueType firstRow = numberOfRows * threadId / numberOfThreads;
+  const SizeValueType lastRow = numberOfRows * ( threadId + 1 ) / numberOfThreads;
+
+  const unsigned int b = ( ImageDimension - 1 ) % 2;
+  const RealType *sums = &str->PowerSums[b][0];
+  const RealType *minima = &str->Minima[b][0];
+  const RealType *maxima = &str->Maxima[b][0];
+  OutputValueType *output = this->GetOutput()->GetBufferPointer();
+
+  const RealType tolerance = 4.0 * static_cast<RealType>( ImageDimension )
+    * NumericTraits<RealType>::epsilon();
+
+  std::vector<SizeValueType> histogram( str->NumberOfBins, 0 );
+  std::vector<OffsetValueType> rowStarts;
+
+  for( SizeValueType row = firstRow; row < lastRow; row++ )
+    {
+    /**
+     * Starts of the rows of the box, the position of the row being
+     * decomposed along the other dimensions.
+     */
+    rowStarts.assign( 1, 0 );
+    SizeValueType position = row;
+    for( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      const SizeValueType i = position % this->m_Size[d];
+      position /= this->m_Size[d];
+
+      SizeValueType first;
+      SizeValueType last;
+      this->GetWindow( d, i, first, last );
+
+      const SizeValueType numberOfStarts = rowStarts.size();
+      rowStarts.resize( numberOfStarts * ( last - first + 1 ) );
+      for( SizeValueType j = last - first + 1; j-- > 0; )
+        {
+        for( SizeValueType k = 0; k < numberOfStarts; k++ )
+          {
+          rowStarts[j * numberOfStarts + k] = rowStarts[k]
+            + static_cast<OffsetValueType>( first + j ) * this->m_Strides[d];
+          }
+        }
+      }
+    const SizeValueType numberOfRowsInBox = rowStarts.size();
+
+    SizeValueType next = 0;
+    if( this->m_ComputeHistogramStatistics )
+      {
+      std::fill( histogram.begin(), histogram.end(), 0 );
+      }
+
+    const OffsetValueType rowStart =
+      static_cast<OffsetValueType>( row * length );
+    for( SizeValueType i = 0; i < length; i++ )
+      {
+      SizeValueType first;
+      SizeValueType last;
+      this->GetWindow( 0, i, first, last );
+
+      const SizeValueType count = numberOfRowsInBox * ( last - first + 1 );
+      const OffsetValueType offset = rowStart + static_cast<OffsetValueType>( i );
+      const RealType N = static_cast<RealType>( count );
+
+      /**
+       * Moments, as in TextureHistogram.  The running sums leave rounding
+       * noise of a few ulps of m2 per summed pixel and pass in the central
+       * moments, so a box whose extrema agree, or whose variance is within
+       * that noise, is flat.
+       */
+      const RealType mean = sums[4 * offset] / N;
+      const RealType m2 = sums[4 * offset + 1] / N;
+      const RealType m3 = sums[4 * offset + 2] / N;
+      const RealType m4 = sums[4 * offset + 3] / N;
+
+      RealType variance = 0.0;
+      RealType skewness = 0.0;
+      RealType kurtosis = 0.0;
+      const RealType centralM2 = m2 - mean * mean;
+      if( count > 1 && maxima[offset] > minima[offset] &&
+        centralM2 > tolerance * N * m2 )
+        {
+        variance = centralM2 * N / ( N - 1.0 );
+        skewness = ( m3 - 3.0 * mean * m2 + 2.0 * mean * mean * mean )
+          / ( variance * vcl_sqrt( variance ) );
+        kurtosis = ( m4 + mean * ( -4.0 * m3 + mean * ( 6.0 * m2
+          - 3.0 * mean * mean ) ) ) / ( variance * variance ) - 3.0;
+        }
+      const RealType sigma = vcl_sqrt( variance );
+
+      OutputValueType *out = output + NumberOfOutputComponents * offset;
+      out[0] = static_cast<OutputValueType>( str->Shift + mean );
+      out[1] = static_cast<OutputValueType>( minima[offset] );
+      out[2] = static_cast<OutputValueType>( maxima[offset] );
+      out[3] = static_cast<OutputValueType>( variance );
+      out[4] = static_cast<OutputValueType>( sigma );
+      out[5] = static_cast<OutputValueType>( skewness );
+      out[6] = static_cast<OutputValueType>( kurtosis );
+
+      if( !this->m_ComputeHistogramStatistics )
+        {
+        for( unsigned int c = 7; c < NumberOfOutputComponents; c++ )
+          {
+          out[c] = NumericTraits<OutputValueType>::Zero;
+          }
+        continue;
+        }
+
+      /**
+       * Slide the histogram: add the columns entering the box and remove
+       * the one leaving it.
+       */
+      for( ; next <= last; next++ )
+        {
+        for( SizeValueType k = 0; k < numberOfRowsInBox; k++ )
+          {
+          histogram[str->Bins[rowStarts[k] + next]]++;
+          }
+        }
+      if( i > radius )
+        {
+        for( SizeValueType k = 0; k < numberOfRowsInBox; k++ )
+          {
+          histogram[str->Bins[rowStarts[k] + first - 1]]--;
+          }
+        }
+
+      RealType entropy = 0.0;
+      for( unsigned int n = 0; n < str->NumberOfBins; n++ )
+        {
+        if( histogram[n] > 0 )
+          {
+          const RealType p = static_cast<RealType>( histogram[n] ) / N;
+          entropy -= p * vcl_log( p );
+          }
+        }
+      out[7] = static_cast<OutputValueType>( entropy );
+      out[8] = static_cast<OutputValueType>(
+        this->GetHistogramQuantile( str, histogram, count, 0.5 ) );
+      out[9] = static_cast<OutputValueType>(
+        this->GetHistogramQuantile( str, histogram, count, 0.05 ) );
+      out[10] = static_cast<OutputValueType>(
+        this->GetHistogramQuantile( str, histogram, count, 0.95 ) );
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+typename SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+  ::RealType
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::GetHistogramQuantile( const StatisticsThreadStruct *str,
+  const std::vector<SizeValueType> & histogram, SizeValueType total,
+  RealType p ) const
+{
+  const RealType target = p * static_cast<RealType>( total );
+
+  RealType cumulative = 0.0;
+  for( unsigned int n = 0; n < str->NumberOfBins; n++ )
+    {
+    const RealType frequency = static_cast<RealType>( histogram[n] );
+    if( frequency > 0.0 && cumulative + frequency >= target )
+      {
+      if( !str->BinValues.empty() )
+        {
+        return str->BinValues[n];
+        }
+      return str->HistogramMinimum + str->BinWidth * ( static_cast<RealType>( n )
+        + ( target - cumulative ) / frequency );
+      }
+    cumulative += frequency;
+    }
+  return str->HistogramMinimum
+    + str->BinWidth * static_cast<RealType>( str->NumberOfBins );
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SlidingWindowFirstOrderStatisticsImageFilter<TInputImage, TOutputImage>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Radius: " << this->m_Radius << std::endl;
+  os << indent << "Compute histogram statistics: "
+     << this->m_ComputeHistogramStatistics << std::endl;
+  os << indent << "Number of histogram bins: "
+     << this->m_NumberOfHistogramBins << std::endl;
+}
+
+} // end namespace itk
+
+#endif
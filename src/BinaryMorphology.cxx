@@ -13,6 +13,7 @@
 #include "itkBinaryDiamondStructuringElement.h"
 #include "itkBinaryThinning3DImageFilter.h"
 #include "itkBinaryThinningImageFilter.h"
+#include "itkBitPackedBinaryImage.h"
 
 #include "itkCastImageFilter.h"
 #include "itkImageRegionIteratorWithIndex.h"
@@ -516,6 +517,92 @@ int myDilate( int argc, char * argv[] )
 
 
 
+int BinaryMorphologyBitPacked( int argc, char * argv[] )
+{
+  const unsigned int ImageDimension = 3;
+
+  typedef short PixelType;
+  typedef itk::Image<PixelType, ImageDimension> ImageType;
+
+  typedef itk::ImageFileReader<ImageType>  ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+  reader->Update();
+
+  unsigned int radius = 1;
+  if ( argc > 5 )
+    {
+    radius = atoi( argv[5] );
+    }
+
+  PixelType foreground = itk::NumericTraits<PixelType>::One;
+  PixelType background = itk::NumericTraits<PixelType>::Zero;
+  if ( argc > 7 )
+    {
+    foreground = static_cast<PixelType>( atof( argv[7] ) );
+    }
+  if ( argc > 8 )
+    {
+    background = static_cast<PixelType>( atof( argv[8] ) );
+    }
+
+  typedef itk::BitPackedBinaryImage<ImageDimension> BinaryImageType;
+
+  BinaryImageType::StructuringElementType element =
+    BinaryImageType::BallElement;
+  if ( argc > 6 && atoi( argv[6] ) == 0 )
+    {
+    element = BinaryImageType::BoxElement;
+    }
+  else if ( argc > 6 && atoi( argv[6] ) == 2 )
+    {
+    element = BinaryImageType::DiamondElement;
+    }
+
+  BinaryImageType::SizeType elementRadius;
+  elementRadius.Fill( radius );
+
+  /**
+   * The mask is packed to one bit per voxel and the morphology is applied
+   * to the packed words.
+   */
+  BinaryImageType::Pointer binaryImage = BinaryImageType::New();
+  binaryImage->SetFromImage( reader->GetOutput(), foreground );
+
+  switch ( atoi( argv[4] ) )
+    {
+    case 0:
+      binaryImage->Dilate( element, elementRadius );
+      break;
+    case 1:
+      binaryImage->Erode( element, elementRadius );
+      break;
+    case 2:
+      binaryImage->Close( element, elementRadius );
+      break;
+    case 3:
+      binaryImage->Open( element, elementRadius );
+      break;
+    default:
+      {
+      std::cerr << "Invalid operation choice." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  ImageType::Pointer output = reader->GetOutput();
+  output->DisconnectPipeline();
+  binaryImage->FillImage( output.GetPointer(), foreground, background );
+
+  typedef itk::ImageFileWriter<ImageType>  WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( output );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  return EXIT_SUCCESS;
+}
+
 int BinaryMorphologySliceBySlice( int argc, char * argv[] )
 {
   const unsigned int ImageDimension = 3;
@@ -921,6 +1008,8 @@ int main( int argc, char *argv[] )
     std::cerr << "Usage: " << std::endl;
     std::cerr << argv[0] << " imageDimension inputImage outputImage operation "
       << "[radius] [type: box == 0, ball = 1, diamond = 2] [label]" << std::endl;
+    std::cerr << "  imageDimension 'P' runs operations 0-3 on a bit packed 3-D "
+      << "mask (binary output)." << std::endl;
     std::cerr << "  operation: " << std::endl;
     std::cerr << "    0. dilate" << std::endl;
     std::cerr << "    1. erode " << std::endl;
@@ -941,6 +1030,10 @@ int main( int argc, char *argv[] )
     {
     myDilate( argc, argv );
     }
+  else if( *argv[1] == 'P' )
+    {
+    BinaryMorphologyBitPacked( argc, argv );
+    }
   else
     {
 				if( atoi( argv[4] ) == 4 )
@@ -1,9 +1,8 @@
 #include <stdio.h>
 
-#include "itkFlatStructuringElement.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
-#include "itkNeighborhoodFirstOrderStatisticsImageFilter.h"
+#include "itkSlidingWindowFirstOrderStatisticsImageFilter.h"
 #include "itkVectorIndexSelectionCastImageFilter.h"
 
 #include <fstream>
@@ -20,15 +19,14 @@ int CalculateStatisticsImage( int argc, char *argv[] )
   typedef itk::Image<PixelType, ImageDimension> ImageType;
 
   typedef itk::VectorImage<PixelType, ImageDimension> VectorImageType;
-  typedef itk::FlatStructuringElement<ImageDimension> KernelType;
-  typedef itk::NeighborhoodFirstOrderStatisticsImageFilter<ImageType, VectorImageType, KernelType> TextureFilterType;
+  typedef itk::SlidingWindowFirstOrderStatisticsImageFilter<ImageType, VectorImageType> TextureFilterType;
 
   typedef itk::ImageFileReader<ImageType> ReaderType;
   typename ReaderType::Pointer reader = ReaderType::New();
   reader->SetFileName( argv[2] );
   reader->Update();
 
-  typename KernelType::SizeType radius;
+  typename TextureFilterType::SizeType radius;
   std::vector<PixelType> rad = ConvertVector<PixelType>( std::string( argv[5] ) );
   if( rad.size() != ImageDimension )
     {
@@ -42,19 +40,26 @@ int CalculateStatisticsImage( int argc, char *argv[] )
       }
     }
   radius.Fill( atoi( argv[5] ) );
-  KernelType kernel = KernelType::Box( radius );
+
+  int operation = atoi( argv[4] );
 
   typename TextureFilterType::Pointer filter = TextureFilterType::New();
-  filter->SetKernel( kernel );
+  filter->SetRadius( radius );
   filter->SetInput( reader->GetOutput() );
+  if( operation < 7 )
+    {
+    filter->ComputeHistogramStatisticsOff();
+    }
+  if( argc > 6 )
+    {
+    filter->SetNumberOfHistogramBins( atoi( argv[6] ) );
+    }
   filter->Update();
 
   typedef itk::VectorIndexSelectionCastImageFilter<VectorImageType, ImageType> IndexSelectionType;
   typename IndexSelectionType::Pointer indexSelectionFilter = IndexSelectionType::New();
   indexSelectionFilter->SetInput( filter->GetOutput() );
 
-  int operation = atoi( argv[4] );
-
   switch( operation )
     {
     case 0:
@@ -97,6 +102,21 @@ int CalculateStatisticsImage( int argc, char *argv[] )
       indexSelectionFilter->SetIndex( 7 );
       break;
       }
+    case 8:
+      {
+      indexSelectionFilter->SetIndex( 8 );
+      break;
+      }
+    case 9:
+      {
+      indexSelectionFilter->SetIndex( 9 );
+      break;
+      }
+    case 10:
+      {
+      indexSelectionFilter->SetIndex( 10 );
+      break;
+      }
     default:
       {
       std::cerr << "Unrecognized option: " << operation << std::endl;
@@ -120,7 +140,7 @@ int main( int argc, char *argv[] )
   if ( argc < 6 )
     {
     std::cerr << "Usage: " << argv[0] << " imageDimension inputImage "
-              << "outputImage operation radius" << std::endl;
+              << "outputImage operation radius [numberOfBins=256]" << std::endl;
     std::cerr << "  operation: " << std::endl;
     std::cerr << "    0. mean " << std::endl;
     std::cerr << "    1. min " << std::endl;
@@ -130,6 +150,14 @@ int main( int argc, char *argv[] )
     std::cerr << "    5. skewness " << std::endl;
     std::cerr << "    6. kurtosis " << std::endl;
     std::cerr << "    7. entropy " << std::endl;
+    std::cerr << "    8. median " << std::endl;
+    std::cerr << "    9. 5th percentile " << std::endl;
+    std::cerr << "    10. 95th percentile " << std::endl;
+    std::cerr << "  Operations 7 to 10 use one bin per value if the image has at most "
+              << "numberOfBins distinct values, and numberOfBins equal bins "
+              << "otherwise.  In the latter "
+              << "case the entropy is that of the binned values, not the per-value "
+              << "entropy of earlier versions." << std::endl;
     exit( 1 );
     }
 
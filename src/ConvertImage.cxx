@@ -12,7 +12,12 @@
 #include "itkFDFImageIOFactory.h"
 #include "itkFDFImageIO.h"
 
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
 #include <string>
+#include <vector>
 
 template <class TPixel, unsigned int ImageDimension>
 int ConvertImage( int argc, char *argv[] )
@@ -194,6 +199,37 @@ int ConvertImage( int argc, char *argv[] )
 
     typename ReaderType::Pointer reader = ReaderType::New();
     reader->SetFileName( argv[2] );
+
+    // A directory of FDF files, one slice per file, is read as a volume
+    if( ImageDimension == 3 &&
+      itksys::SystemTools::FileIsDirectory( argv[2] ) )
+      {
+      itksys::Directory directory;
+      directory.Load( argv[2] );
+
+      std::vector<std::string> fileNames;
+      for( unsigned long i = 0; i < directory.GetNumberOfFiles(); i++ )
+        {
+        std::string fileName = directory.GetFile( i );
+        std::string extension =
+          itksys::SystemTools::GetFilenameLastExtension( fileName );
+        if( extension == ".fdf" || extension == ".FDF" )
+          {
+          fileNames.push_back( std::string( argv[2] ) + "/" + fileName );
+          }
+        }
+      std::sort( fileNames.begin(), fileNames.end() );
+      if( fileNames.empty() )
+        {
+        std::cerr << "No FDF files found in " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      itk::FDFImageIO::Pointer fdfIO = itk::FDFImageIO::New();
+      fdfIO->SetSeriesFileNames( fileNames );
+      reader->SetImageIO( fdfIO );
+      reader->SetFileName( fileNames[0].c_str() );
+      }
     reader->Update();
 
     // If the requested output image is a .png or .jpg, optimize for visualization
@@ -240,6 +276,7 @@ int main( int argc, char *argv[] )
     {
     std::cout << "Usage: " << argv[0] << " imageDimension "
       << "inputImage outputImage pixelType" << std::endl;
+    std::cout << "inputImage can be a directory of 2-D FDF slices (imageDimension 3)." << std::endl;
     std::cout << "pixelType:  0 -> float (default)" << std::endl
               << "            1 -> unsigned short" << std::endl
               << "            2 -> unsigned int" << std::endl
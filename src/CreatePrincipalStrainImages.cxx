@@ -5,7 +5,9 @@
 #include "itkImageFileWriter.h"
 #include "itkVector.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 template <unsigned int ImageDimension>
 int CreatePrincipalStrainImages( int argc, char *argv[] )
@@ -70,8 +72,56 @@ int CreatePrincipalStrainImages( int argc, char *argv[] )
   typedef itk::DecomposeTensorFunction<typename FunctionType::MatrixType> DecomposerType;
   typename DecomposerType::Pointer decomposer = DecomposerType::New();
 
+  /**
+   * The strain tensors of the mask are gathered, component by component,
+   * in chunks which are decomposed at once.  A second mask iterator walks
+   * the strain images in step to scatter the principal strains.
+   */
+  const unsigned int numberOfComponents
+    = ImageDimension * ( ImageDimension + 1 ) / 2;
+  const unsigned long chunkSize = std::min( static_cast<unsigned long>(
+    mask->GetLargestPossibleRegion().GetNumberOfPixels() ), 262144ul );
+
+  std::vector<RealType> components[6];
+  std::vector<RealType> eigenValues[3];
+  std::vector<RealType> eigenVectors[9];
+
+  typename DecomposerType::SymmetricTensorBatchType batch;
+  batch.Dimension = ImageDimension;
+  batch.Determinant = NULL;
+  batch.Trace = NULL;
+  for ( unsigned int k = 0; k < 6; k++ )
+    {
+    batch.Components[k] = NULL;
+    if ( k < numberOfComponents )
+      {
+      components[k].resize( chunkSize );
+      batch.Components[k] = &components[k][0];
+      }
+    }
+  for ( unsigned int i = 0; i < 3; i++ )
+    {
+    batch.EigenValues[i] = NULL;
+    if ( i < ImageDimension )
+      {
+      eigenValues[i].resize( chunkSize );
+      batch.EigenValues[i] = &eigenValues[i][0];
+      }
+    }
+  for ( unsigned int i = 0; i < 9; i++ )
+    {
+    batch.EigenVectors[i] = NULL;
+    if ( i < ImageDimension * ImageDimension )
+      {
+      eigenVectors[i].resize( chunkSize );
+      batch.EigenVectors[i] = &eigenVectors[i][0];
+      }
+    }
+
   itk::ImageRegionIteratorWithIndex<MaskImageType> ItM
     ( mask, mask->GetLargestPossibleRegion() );
+  itk::ImageRegionIteratorWithIndex<MaskImageType> ItW
+    ( mask, mask->GetLargestPossibleRegion() );
   itk::ImageRegionIteratorWithIndex<VectorImageType> ItS1
     ( strain1, strain1->GetLargestPossibleRegion() );
   itk::ImageRegionIteratorWithIndex<VectorImageType> ItS2
@@ -88,61 +138,84 @@ int CreatePrincipalStrainImages( int argc, char *argv[] )
   RealType var3 = 0.0;
 
   ItM.GoToBegin();
+  ItW.GoToBegin();
   ItS1.GoToBegin();
   ItS2.GoToBegin();
   ItS3.GoToBegin();
-
   while ( !ItM.IsAtEnd() )
     {
-    if ( ItM.Get() == 0 )
+    unsigned long n = 0;
+    for ( ; n < chunkSize && !ItM.IsAtEnd(); ++ItM )
       {
-      ++ItM;
-      ++ItS1;
-      ++ItS2;
-      ++ItS3;
-      continue;
-      }
-    typename FunctionType::MatrixType E
-      = function->EvaluateLagrangianStrainTensorAtIndex( ItM.GetIndex() );
-    typename FunctionType::MatrixType D;
-    typename FunctionType::MatrixType V;
-    decomposer->EvaluateSymmetricEigenDecomposition( E, D, V );
-    VectorType P1;  P1.Fill( 0 );
-    VectorType P2;
-    VectorType P3;
-    for ( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      if ( ImageDimension == 3 )
+      if ( ItM.Get() == 0 )
+        {
+        continue;
+        }
+      typename FunctionType::MatrixType E
+        = function->EvaluateLagrangianStrainTensorAtIndex( ItM.GetIndex() );
+      unsigned int k = 0;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
         {
-        P1[i] = D[2][2]*V[i][2];
+        for ( unsigned int j = i; j < ImageDimension; j++ )
+          {
+          components[k++][n] = E[i][j];
+          }
         }
-      P2[i] = D[1][1]*V[i][1];
-      P3[i] = D[0][0]*V[i][0];
+      n++;
       }
-    ItS1.Set( P1 );
-    ItS2.Set( P2 );
-    ItS3.Set( P3 );
-
-    N += 1.0;
-    if ( ImageDimension == 3 )
+    if ( n == 0 )
       {
-      mean1 = mean1*( N - 1.0 )/N + D[2][2]/N;
+      break;
       }
-    mean2 = mean2*( N - 1.0 )/N + D[1][1]/N;
-    mean3 = mean3*( N - 1.0 )/N + D[0][0]/N;
-    if ( N > 1.0 )
+
+    batch.NumberOfTensors = n;
+    decomposer->EvaluateSymmetricTensorBatch( batch );
+
+    for ( unsigned long m = 0; m < n; ++ItW, ++ItS1, ++ItS2, ++ItS3 )
       {
+      if ( ItW.Get() == 0 )
+        {
+        continue;
+        }
+      RealType D[3];
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        D[i] = eigenValues[i][m];
+        }
+      VectorType P1;  P1.Fill( 0 );
+      VectorType P2;
+      VectorType P3;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        if ( ImageDimension == 3 )
+          {
+          P1[i] = D[2]*eigenVectors[2*ImageDimension+i][m];
+          }
+        P2[i] = D[1]*eigenVectors[ImageDimension+i][m];
+        P3[i] = D[0]*eigenVectors[i][m];
+        }
+      ItS1.Set( P1 );
+      ItS2.Set( P2 );
+      ItS3.Set( P3 );
+
+      N += 1.0;
       if ( ImageDimension == 3 )
         {
-        var1 = var1*( N - 1.0 )/N + ( D[2][2] - mean1 )*( D[2][2] - mean1 )/( N - 1.0 );
+        mean1 = mean1*( N - 1.0 )/N + D[2]/N;
+        }
+      mean2 = mean2*( N - 1.0 )/N + D[1]/N;
+      mean3 = mean3*( N - 1.0 )/N + D[0]/N;
+      if ( N > 1.0 )
+        {
+        if ( ImageDimension == 3 )
+          {
+          var1 = var1*( N - 1.0 )/N + ( D[2] - mean1 )*( D[2] - mean1 )/( N - 1.0 );
+          }
+        var2 = var2*( N - 1.0 )/N + ( D[1] - mean2 )*( D[1] - mean2 )/( N - 1.0 );
+        var3 = var3*( N - 1.0 )/N + ( D[0] - mean3 )*( D[0] - mean3 )/( N - 1.0 );
         }
-      var2 = var2*( N - 1.0 )/N + ( D[1][1] - mean2 )*( D[1][1] - mean2 )/( N - 1.0 );
-      var3 = var3*( N - 1.0 )/N + ( D[0][0] - mean3 )*( D[0][0] - mean3 )/( N - 1.0 );
+      m++;
       }
-    ++ItM;
-    ++ItS1;
-    ++ItS2;
-    ++ItS3;
     }
 
   bool magnitudeOnly = true;
@@ -0,0 +1,106 @@
+#include "itkContourDirectedMeanDistanceImageFilter.h"
+#include "itkDirectedHausdorffDistanceImageFilter.h"
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <cmath>
+
+/**
+ * Compares the distances of DirectedHausdorffDistanceImageFilter and
+ * ContourDirectedMeanDistanceImageFilter computed from the distance map
+ * (KdTreeVolumeFraction 0) and from the boundary kd-tree
+ * (KdTreeVolumeFraction 1), for two overlapping objects with rough
+ * boundaries.
+ */
+
+template <class ImageType>
+typename ImageType::Pointer CreateObject( const typename ImageType::RegionType
+  & region, double center[], double radius,
+  itk::Statistics::MersenneTwisterRandomVariateGenerator *generator )
+{
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> It( image, region );
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    double distance = 0.0;
+    for ( unsigned int d = 0; d < ImageType::ImageDimension; d++ )
+      {
+      distance += vnl_math_sqr( It.GetIndex()[d] - center[d] );
+      }
+    It.Set( std::sqrt( distance ) < radius
+      + generator->GetUniformVariate( -1.5, 1.5 ) ? 1 : 0 );
+    }
+  return image;
+}
+
+bool IsClose( double a, double b )
+{
+  return ( std::fabs( a - b ) <= 1e-6 * vnl_math_max( 1.0, std::fabs( b ) ) );
+}
+
+int main( int argc, char *argv[] )
+{
+  const unsigned int ImageDimension = 3;
+
+  typedef itk::Image<unsigned char, ImageDimension> ImageType;
+
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 40 );
+  region.SetSize( size );
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  double center1[] = { 18.0, 20.0, 20.0 };
+  double center2[] = { 22.0, 19.0, 21.0 };
+  ImageType::Pointer image1 = CreateObject<ImageType>( region, center1, 9.0,
+    generator );
+  ImageType::Pointer image2 = CreateObject<ImageType>( region, center2, 8.0,
+    generator );
+
+  typedef itk::DirectedHausdorffDistanceImageFilter<ImageType, ImageType>
+    HausdorffType;
+  typedef itk::ContourDirectedMeanDistanceImageFilter<ImageType, ImageType>
+    ContourMeanType;
+
+  double hausdorff[2];
+  double averageHausdorff[2];
+  double contourMean[2];
+  for ( unsigned int k = 0; k < 2; k++ )
+    {
+    HausdorffType::Pointer filter = HausdorffType::New();
+    filter->SetInput1( image1 );
+    filter->SetInput2( image2 );
+    filter->SetKdTreeVolumeFraction( static_cast<double>( k ) );
+    filter->Update();
+    hausdorff[k] = filter->GetDirectedHausdorffDistance();
+    averageHausdorff[k] = filter->GetAverageHausdorffDistance();
+
+    ContourMeanType::Pointer contour = ContourMeanType::New();
+    contour->SetInput1( image1 );
+    contour->SetInput2( image2 );
+    contour->SetKdTreeVolumeFraction( static_cast<double>( k ) );
+    contour->Update();
+    contourMean[k] = contour->GetContourDirectedMeanDistance();
+    }
+
+  if ( !IsClose( hausdorff[1], hausdorff[0] ) ||
+    !IsClose( averageHausdorff[1], averageHausdorff[0] ) ||
+    !IsClose( contourMean[1], contourMean[0] ) )
+    {
+    std::cerr << "Kd-tree distances " << hausdorff[1] << ", "
+      << averageHausdorff[1] << ", " << contourMean[1]
+      << " instead of the distance map ones " << hausdorff[0] << ", "
+      << averageHausdorff[0] << ", " << contourMean[0] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -1,7 +1,6 @@
 #include "itkBinaryReinhardtMorphologicalImageFilter.h"
 #include "itkBinaryBallStructuringElement.h"
 #include "itkBinaryThresholdImageFilter.h"
-#include "itkConnectedComponentImageFilter.h"
 #include "itkConstantPadImageFilter.h"
 #include "itkExtractImageFilter.h"
 #include "itkImageFileReader.h"
@@ -11,8 +10,8 @@
 #include "itkPadImageFilter.h"
 #include "itkOtsuThresholdImageFilter.h"
 #include "itkOtsuMultipleThresholdsCalculator.h"
-#include "itkRelabelComponentImageFilter.h"
 #include "itkStatisticsImageFilter.h"
+#include "itkUnionFindConnectedComponentImageFilter.h"
 
 int main( int argc, char *argv[] )
 {
@@ -184,16 +183,13 @@ int main( int argc, char *argv[] )
 
 
 
-  typedef itk::ConnectedComponentImageFilter<LabelImageType, LabelImageType> ConnectedComponentType;
-  ConnectedComponentType::Pointer connecter = ConnectedComponentType::New();
-  connecter->SetInput( padder->GetOutput() );
-  connecter->FullyConnectedOff();
-  connecter->Update();
-
-  typedef itk::RelabelComponentImageFilter<LabelImageType, LabelImageType> RelabelerType;
-  RelabelerType::Pointer relabeler = RelabelerType::New();
-  relabeler->SetInput( connecter->GetOutput() );
-  relabeler->InPlaceOff();
+  /**
+   * The components are labeled by decreasing size in a single pass.
+   */
+  typedef itk::UnionFindConnectedComponentImageFilter<LabelImageType, LabelImageType> ConnectedComponentType;
+  ConnectedComponentType::Pointer relabeler = ConnectedComponentType::New();
+  relabeler->SetInput( padder->GetOutput() );
+  relabeler->FullyConnectedOff();
   relabeler->Update();
 
   typedef itk::BinaryThresholdImageFilter<LabelImageType, LabelImageType> ThresholderType;
@@ -205,14 +201,9 @@ int main( int argc, char *argv[] )
   thresholder->SetUpperThreshold( 1 );
   thresholder->Update();
 
-  ConnectedComponentType::Pointer connecter3 = ConnectedComponentType::New();
-  connecter3->SetInput( thresholder->GetOutput() );
-  connecter3->FullyConnectedOff();
-  connecter3->Update();
-
-  RelabelerType::Pointer relabeler3 = RelabelerType::New();
-  relabeler3->SetInput( connecter3->GetOutput() );
-  relabeler3->InPlaceOff();
+  ConnectedComponentType::Pointer relabeler3 = ConnectedComponentType::New();
+  relabeler3->SetInput( thresholder->GetOutput() );
+  relabeler3->FullyConnectedOff();
   relabeler3->Update();
 
   /**
@@ -263,14 +254,9 @@ int main( int argc, char *argv[] )
    * spurious labels
    */
 
-  ConnectedComponentType::Pointer connecter2 = ConnectedComponentType::New();
-  connecter2->SetInput( relabeler3->GetOutput() );
-  connecter2->FullyConnectedOff();
-  connecter2->Update();
-
-  RelabelerType::Pointer relabeler2 = RelabelerType::New();
-  relabeler2->SetInput( connecter2->GetOutput() );
-  relabeler2->InPlaceOff();
+  ConnectedComponentType::Pointer relabeler2 = ConnectedComponentType::New();
+  relabeler2->SetInput( relabeler3->GetOutput() );
+  relabeler2->FullyConnectedOff();
   relabeler2->Update();
 
   itk::ImageRegionIterator<LabelImageType> It2( relabeler2->GetOutput(),
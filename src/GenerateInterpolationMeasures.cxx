@@ -3,14 +3,9 @@
 #include "itkImage.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
-#include "itkImageRegionIterator.h"
-#include "itkLabelGeometryImageFilter.h"
-#include "itkLabelPerimeterEstimationCalculator.h"
+#include "itkLabelMeasuresCalculator.h"
 
-#include <iomanip>
 #include <iostream>
-#include <ostream>
-#include <sstream>
 
 
 template <unsigned int ImageDimension>
@@ -31,72 +26,50 @@ int GenerateInterpolationMeasures( int argc, char *argv[] )
   reader2->SetFileName( argv[3] );
   reader2->Update();
 
-  typedef itk::LabelGeometryImageFilter<LabelImageType, RealImageType> FilterType;
+  typedef itk::LabelMeasuresCalculator<LabelImageType, RealImageType> CalculatorType;
 
-  typename FilterType::Pointer filter1 = FilterType::New();
-  filter1->SetInput( reader1->GetOutput() );
-  filter1->CalculatePixelIndicesOff();
-  filter1->CalculateOrientedBoundingBoxOff();
-  filter1->CalculateOrientedLabelRegionsOff();
-  filter1->Update();
+  typename CalculatorType::Pointer calculator1 = CalculatorType::New();
+  calculator1->SetLabelImage( reader1->GetOutput() );
+  calculator1->SetBackgroundValue( 0 );
+  calculator1->Compute();
 
-  typename FilterType::Pointer filter2 = FilterType::New();
-  filter2->SetInput( reader2->GetOutput() );
-  filter2->CalculatePixelIndicesOff();
-  filter2->CalculateOrientedBoundingBoxOff();
-  filter2->CalculateOrientedLabelRegionsOff();
-  filter2->Update();
+  typename CalculatorType::Pointer calculator2 = CalculatorType::New();
+  calculator2->SetLabelImage( reader2->GetOutput() );
+  calculator2->SetBackgroundValue( 0 );
+  calculator2->Compute();
 
-  typedef itk::LabelPerimeterEstimationCalculator<LabelImageType> AreaFilterType;
+  std::cout << "Label,PercentVolumeDiff,PercentSurfAreaDiff,Distance" << std::endl;
 
-  typename AreaFilterType::Pointer areaFilter1 = AreaFilterType::New();
-  areaFilter1->SetImage( reader1->GetOutput() );
-  areaFilter1->Compute();
-
-  typename AreaFilterType::Pointer areaFilter2 = AreaFilterType::New();
-  areaFilter2->SetImage( reader2->GetOutput() );
-  areaFilter2->Compute();
-
-
-  std::cout << std::left << std::setw( 7 )  << "Label"
-            << std::left << std::setw( 20 ) << "PercentVolumeDiff"
-            << std::left << std::setw( 25 ) << "PercentSurfAreaDiff"
-            << std::left << std::setw( 25 ) << "Distance";
-  std::cout << std::endl;
-
-
-  typename FilterType::LabelsType allLabels1 = filter1->GetLabels();
-  std::sort( allLabels1.begin(), allLabels1.end() );
-
-  typename FilterType::LabelsType allLabels2 = filter2->GetLabels();
-
-  typename FilterType::LabelsType::iterator allLabelsIt;
-  for( allLabelsIt = allLabels1.begin(); allLabelsIt != allLabels1.end(); allLabelsIt++ )
+  typename CalculatorType::LabelsType::const_iterator allLabelsIt;
+  for( allLabelsIt = calculator1->GetLabels().begin();
+    allLabelsIt != calculator1->GetLabels().end(); allLabelsIt++ )
     {
-    if( *allLabelsIt == 0 || std::find( allLabels2.begin(), allLabels2.end(), *allLabelsIt ) == allLabels2.end() )
+    if( !calculator2->HasLabel( *allLabelsIt ) )
       {
       continue;
       }
-    RealType volume = filter1->GetVolume( *allLabelsIt );
-    RealType volumeRotated = filter2->GetVolume( *allLabelsIt );
+    const typename CalculatorType::LabelMeasuresType & measures =
+      calculator1->GetMeasures( *allLabelsIt );
+    const typename CalculatorType::LabelMeasuresType & measuresRotated =
+      calculator2->GetMeasures( *allLabelsIt );
+
+    RealType volume = measures.NumberOfPixels;
+    RealType volumeRotated = measuresRotated.NumberOfPixels;
 
     RealType percentVolumeDifference = ( volume - volumeRotated ) / volume;
 
-    RealType surfaceArea = areaFilter1->GetPerimeter( *allLabelsIt );
-    RealType surfaceAreaRotated = areaFilter2->GetPerimeter( *allLabelsIt );
+    RealType surfaceArea = measures.SurfaceArea;
+    RealType surfaceAreaRotated = measuresRotated.SurfaceArea;
 
     RealType percentSurfaceAreaDifference = ( surfaceArea - surfaceAreaRotated ) / surfaceArea;
 
-    typename LabelImageType::PointType centroidPoint = filter1->GetCentroid( *allLabelsIt );
-    typename LabelImageType::PointType centroidPointRotated = filter2->GetCentroid( *allLabelsIt );
-
-    RealType distance = centroidPoint.EuclideanDistanceTo( centroidPointRotated );
+    RealType distance = measures.Centroid.EuclideanDistanceTo(
+      measuresRotated.Centroid );
 
-    std::cout << std::left << std::setw( 7 )  << *allLabelsIt
-              << std::left << std::setw( 20 ) << percentVolumeDifference
-              << std::left << std::setw( 25 ) << percentSurfaceAreaDifference
-              << std::left << std::setw( 25 ) << distance;
-    std::cout << std::endl;
+    std::cout << *allLabelsIt << ","
+              << percentVolumeDifference << ","
+              << percentSurfaceAreaDifference << ","
+              << distance << std::endl;
     }
   return EXIT_SUCCESS;
 }
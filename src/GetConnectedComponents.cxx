@@ -23,8 +23,8 @@
 #include "itkImageRegionIterator.h"
 
 #include "itkBinaryThresholdImageFilter.h"
-#include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
+#include "itkUnionFindConnectedComponentImageFilter.h"
 
 #include <vector>
 #include <algorithm>
@@ -40,37 +40,35 @@ int GetConnectedComponents(int argc, char* argv[] )
   reader->SetFileName( argv[2] );
   reader->Update();
 
-  typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelerType;
-  typename RelabelerType::Pointer relabeler = RelabelerType::New();
+  /**
+   * The components are labeled by decreasing size, and their sizes computed,
+   * in the same pass.
+   */
+  typedef itk::UnionFindConnectedComponentImageFilter<ImageType, ImageType>
+    ConnectedComponentType;
 
   if( argc > 5 )
     {
-    typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentType;
     typename ConnectedComponentType::Pointer filter = ConnectedComponentType::New();
     filter->SetInput( reader->GetOutput() );
     filter->Update();
 
-    typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelerType;
-    typename RelabelerType::Pointer relabeler = RelabelerType::New();
-    relabeler->SetInput( filter->GetOutput() );
-    relabeler->Update();
-
     float thresholdSize = atof( argv[5] );
-    if( thresholdSize <= 1.0 )
+    if( thresholdSize <= 1.0 && filter->GetNumberOfObjects() > 0 )
       {
-      thresholdSize *= relabeler->GetSizeOfObjectsInPixels()[0];
+      thresholdSize *= filter->GetSizeOfObjectInPixels( 1 );
 
-      std::cout << "  Thresholding at size " << static_cast<typename RelabelerType::ObjectSizeType>( thresholdSize ) << std::endl;
+      std::cout << "  Thresholding at size " << static_cast<itk::SizeValueType>( thresholdSize ) << std::endl;
       }
 
-    for ( unsigned int i = 0; i < relabeler->GetNumberOfObjects(); i++ )
+    for ( unsigned int i = 1; i <= filter->GetNumberOfObjects(); i++ )
       {
-      if( relabeler->GetSizeOfObjectsInPixels()[i] < static_cast<typename RelabelerType::ObjectSizeType>( thresholdSize ) )
+      if( filter->GetSizeOfObjectInPixels( i ) < static_cast<itk::SizeValueType>( thresholdSize ) )
         {
-        itk::ImageRegionIterator<ImageType> It( relabeler->GetOutput(), relabeler->GetOutput()->GetRequestedRegion() );
+        itk::ImageRegionIterator<ImageType> It( filter->GetOutput(), filter->GetOutput()->GetRequestedRegion() );
         for( It.GoToBegin(); !It.IsAtEnd(); ++It )
           {
-          if( It.Get() >= static_cast<PixelType>( i+1 ) )
+          if( It.Get() >= static_cast<PixelType>( i ) )
             {
             It.Set( 0 );
             }
@@ -82,7 +80,7 @@ int GetConnectedComponents(int argc, char* argv[] )
     typedef itk::ImageFileWriter<ImageType> WriterType;
     typename WriterType::Pointer writer = WriterType::New();
     writer->SetFileName( argv[3] );
-    writer->SetInput( relabeler->GetOutput() );
+    writer->SetInput( filter->GetOutput() );
     writer->Update();
     }
   else if( argc > 4 && atoi( argv[4] ) != 0 )
@@ -143,17 +141,12 @@ int GetConnectedComponents(int argc, char* argv[] )
       thresholder->SetInsideValue( 1 );
       thresholder->Update();
 
-      typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentType;
       typename ConnectedComponentType::Pointer filter = ConnectedComponentType::New();
       filter->SetInput( thresholder->GetOutput() );
       filter->Update();
 
-      typename RelabelerType::Pointer relabeler2 = RelabelerType::New();
-      relabeler2->SetInput( filter->GetOutput() );
-      relabeler2->Update();
-
-      itk::ImageRegionIterator<ImageType> It2( relabeler2->GetOutput(),
-        relabeler2->GetOutput()->GetRequestedRegion() );
+      itk::ImageRegionIterator<ImageType> It2( filter->GetOutput(),
+        filter->GetOutput()->GetRequestedRegion() );
 
       itk::ImageRegionIterator<ImageType> ItO( output, output->GetRequestedRegion() );
 
@@ -165,7 +158,7 @@ int GetConnectedComponents(int argc, char* argv[] )
           ItO.Set( label + count );
           }
         }
-      count += relabeler2->GetNumberOfObjects();
+      count += filter->GetNumberOfObjects();
       }
 
     typedef itk::ImageFileWriter<ImageType> WriterType;
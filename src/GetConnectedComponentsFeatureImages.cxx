@@ -4,13 +4,12 @@
 #include "itkImageRegionIteratorWithIndex.h"
 
 #include "itkBinaryThresholdImageFilter.h"
-#include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
-#include "itkLabelGeometryImageFilter.h"
 #include "itkLabelPerimeterEstimationCalculator.h"
 #include "itkLabelStatisticsImageFilter.h"
 #include "itkMultiplyImageFilter.h"
 #include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkUnionFindConnectedComponentImageFilter.h"
 
 #include <string>
 #include <vector>
@@ -47,13 +46,6 @@ int GetConnectedComponents(int argc, char* argv[] )
     outputImages.push_back( output );
     }
 
-  typename ImageType::SpacingType spacing = reader->GetOutput()->GetSpacing();
-  float prefactor = 1.0;
-  for( unsigned int d = 0; d < ImageDimension; d++ )
-    {
-    prefactor *= spacing[d];
-    }
-
   typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelerType;
   typename RelabelerType::Pointer relabeler = RelabelerType::New();
   relabeler->SetInput( reader->GetOutput() );
@@ -72,32 +64,24 @@ int GetConnectedComponents(int argc, char* argv[] )
     thresholder->SetOutsideValue( 0 );
     thresholder->Update();
 
-    typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentType;
+    /**
+     * The components are labeled and their geometry computed in one pass.
+     */
+    typedef itk::UnionFindConnectedComponentImageFilter<ImageType, ImageType>
+      ConnectedComponentType;
     typename ConnectedComponentType::Pointer filter = ConnectedComponentType::New();
     filter->SetInput( thresholder->GetOutput() );
     filter->Update();
 
-    typename RelabelerType::Pointer relabeler2 = RelabelerType::New();
-    relabeler2->SetInput( filter->GetOutput() );
-    relabeler2->Update();
-
-    typedef itk::LabelGeometryImageFilter<ImageType, RealImageType> GeometryFilterType;
-    typename GeometryFilterType::Pointer geometry = GeometryFilterType::New();
-    geometry->SetInput( relabeler2->GetOutput() );
-    geometry->CalculatePixelIndicesOff();
-    geometry->CalculateOrientedBoundingBoxOff();
-    geometry->CalculateOrientedLabelRegionsOff();
-    geometry->Update();
-
     typedef itk::LabelPerimeterEstimationCalculator<ImageType> AreaFilterType;
     typename AreaFilterType::Pointer area = AreaFilterType::New();
-    area->SetImage( relabeler2->GetOutput() );
+    area->SetImage( filter->GetOutput() );
     area->Compute();
 
     itk::ImageRegionIteratorWithIndex<ImageType> It( relabeler->GetOutput(),
       relabeler->GetOutput()->GetRequestedRegion() );
-    itk::ImageRegionIterator<ImageType> It2( relabeler2->GetOutput(),
-      relabeler2->GetOutput()->GetRequestedRegion() );
+    itk::ImageRegionIterator<ImageType> It2( filter->GetOutput(),
+      filter->GetOutput()->GetRequestedRegion() );
 
     for( It.GoToBegin(), It2.GoToBegin(); !It.IsAtEnd(); ++It, ++It2 )
       {
@@ -112,12 +96,15 @@ int GetConnectedComponents(int argc, char* argv[] )
         // [2] = eccentricity
         // [3] = elongation
 
-        float volume = prefactor * static_cast<float>( geometry->GetVolume( label ) );
+        const typename ConnectedComponentType::ObjectStatisticsType & statistics
+          = filter->GetObjectStatistics( label );
+
+        float volume = static_cast<float>( statistics.PhysicalSize );
 
         outputImages[0]->SetPixel( index, volume );
         outputImages[1]->SetPixel( index, area->GetPerimeter( label ) / volume );
-        outputImages[2]->SetPixel( index, geometry->GetEccentricity( label ) );
-        outputImages[3]->SetPixel( index, geometry->GetElongation( label ) );
+        outputImages[2]->SetPixel( index, statistics.Eccentricity );
+        outputImages[3]->SetPixel( index, statistics.Elongation );
         }
       }
     }
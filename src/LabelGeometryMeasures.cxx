@@ -1,7 +1,6 @@
 #include "itkImage.h"
 #include "itkImageFileReader.h"
-#include "itkLabelGeometryImageFilter.h"
-#include "itkLabelPerimeterEstimationCalculator.h"
+#include "itkLabelMeasuresCalculator.h"
 
 #include <iomanip>
 #include <iostream>
@@ -30,32 +29,22 @@ int LabelGeometryMeasures( int argc, char * argv[] )
     reader->Update();
     }
 
-  typedef itk::LabelGeometryImageFilter<LabelImageType, RealImageType> FilterType;
-  typename FilterType::Pointer filter = FilterType::New();
-  filter->SetInput( labelReader->GetOutput() );
+  /**
+   * The geometry, the surface areas and, with an intensity image, the
+   * intensity measures of all the labels are computed in one pass.  The
+   * oriented bounding boxes are not printed and therefore not computed.
+   */
+  typedef itk::LabelMeasuresCalculator<LabelImageType, RealImageType> CalculatorType;
+  typename CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetLabelImage( labelReader->GetOutput() );
   if( argc > 3 )
     {
-    filter->SetIntensityInput( reader->GetOutput() );
+    calculator->SetIntensityImage( reader->GetOutput() );
     }
-  filter->CalculatePixelIndicesOff();
-  filter->CalculateOrientedBoundingBoxOff();
-  filter->CalculateOrientedLabelRegionsOff();
-  // These generate optional outputs.
-//   filter->CalculatePixelIndicesOn();
-//   filter->CalculateOrientedBoundingBoxOn();;
-//   filter->CalculateOrientedLabelRegionsOn();
-  filter->Update();
-
-  typedef itk::LabelPerimeterEstimationCalculator<LabelImageType> AreaFilterType;
-  typename AreaFilterType::Pointer areafilter = AreaFilterType::New();
-  areafilter->SetImage( labelReader->GetOutput() );
-  areafilter->Compute();
-
-
-  typename FilterType::LabelsType allLabels = filter->GetLabels();
-  typename FilterType::LabelsType::iterator allLabelsIt;
-//   std::cout << "Number of labels: " << labelGeometryFilter->GetNumberOfLabels() << std::endl;
-//   std::cout << "Label geometry measures." << std::endl;
+  calculator->SetBackgroundValue( 0 );
+  calculator->Compute();
+
+  const typename CalculatorType::LabelsType & allLabels = calculator->GetLabels();
   std::cout << std::left << std::setw( 7 )  << "Label"
             << std::left << std::setw( 10 ) << "Volume(vox)"
             << std::left << std::setw( 15 ) << "SurfArea(mm^2)"
@@ -65,47 +54,51 @@ int LabelGeometryMeasures( int argc, char * argv[] )
             << std::left << std::setw( 30 ) << "Centroid"
             << std::left << std::setw( 30 ) << "Axes Length"
             << std::left << std::setw( 30 ) << "Bounding Box";
-  if( filter->GetIntensityInput() )
+  if( calculator->GetIntensityImage() )
     {
     std::cout << std::left << std::setw( 20 )  << "Integrated Int."
               << std::left << std::setw( 30 ) << "Weighted Centroid";
     }
   std::cout << std::endl;
-  for( allLabelsIt = allLabels.begin(); allLabelsIt != allLabels.end(); allLabelsIt++ )
+  for( unsigned int n = 0; n < allLabels.size(); n++ )
     {
-    if( *allLabelsIt == 0 )
-      {
-      continue;
-      }
-    std::cout << std::setw( 7 ) << *allLabelsIt;
-    std::cout << std::setw( 10 ) << filter->GetVolume( *allLabelsIt );
-    std::cout << std::setw( 15 ) << areafilter->GetPerimeter( *allLabelsIt );
-    std::cout << std::setw( 15 ) << filter->GetEccentricity( *allLabelsIt );
-    std::cout << std::setw( 15 ) << filter->GetElongation( *allLabelsIt );
-    std::cout << std::setw( 15 ) << filter->GetOrientation( *allLabelsIt );
+    const typename CalculatorType::LabelMeasuresType & measures =
+      calculator->GetMeasures( allLabels[n] );
+
+    std::cout << std::setw( 7 ) << measures.Label;
+    std::cout << std::setw( 10 ) << measures.NumberOfPixels;
+    std::cout << std::setw( 15 ) << measures.SurfaceArea;
+    std::cout << std::setw( 15 ) << measures.Eccentricity;
+    std::cout << std::setw( 15 ) << measures.Elongation;
+    std::cout << std::setw( 15 ) << measures.Orientation;
 
     std::stringstream oss;
-    oss << filter->GetCentroid( *allLabelsIt );
+    oss << measures.Centroid;
     std::cout << std::setw( 30 ) << ( oss.str() ).c_str();
     oss.str( "" );
 
-    oss << filter->GetAxesLength( *allLabelsIt );
+    oss << measures.AxesLength;
     std::cout << std::setw( 30 ) << ( oss.str() ).c_str();
     oss.str( "" );
 
-    oss << filter->GetBoundingBox( *allLabelsIt );
+    // Minimum and maximum index of each dimension
+    oss << "[";
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      oss << ( d > 0 ? ", " : "" ) << measures.BoundingBox.GetIndex()[d]
+        << ", " << measures.BoundingBox.GetUpperIndex()[d];
+      }
+    oss << "]";
     std::cout << std::setw( 30 ) << ( oss.str() ).c_str();
     oss.str( "" );
 
-//     std::cout << filter->GetMajorAxisLength( *allLabelsIt ) << "\t";
-//     std::cout << filter->GetMinorAxisLength( *allLabelsIt ) << "\t";
-    if( filter->GetIntensityInput() )
+    if( calculator->GetIntensityImage() )
       {
-      oss << filter->GetIntegratedIntensity( *allLabelsIt );
+      oss << measures.Sum;
       std::cout << std::setw( 20 ) << ( oss.str() ).c_str();
       oss.str( "" );
 
-      oss << filter->GetWeightedCentroid( *allLabelsIt );
+      oss << measures.WeightedCentroid;
       std::cout << std::setw( 30 ) << ( oss.str() ).c_str();
       oss.str( "" );
       }
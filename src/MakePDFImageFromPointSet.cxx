@@ -41,6 +41,14 @@ int MakePDFImageFromPointSet( int argc, char *argv[] )
   reader->SetFileName( argv[8] );
   reader->Update();
 
+  /**
+   * Evaluate all the voxels at once so that the queries can be sorted and
+   * threaded by the density function.
+   */
+  typename ParzenFilterType::InputPointContainerType points;
+  points.reserve(
+    reader->GetOutput()->GetLargestPossibleRegion().GetNumberOfPixels() );
+
   itk::ImageRegionIteratorWithIndex<RealImageType> It( reader->GetOutput(),
     reader->GetOutput()->GetLargestPossibleRegion() );
   for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
@@ -52,7 +60,16 @@ int MakePDFImageFromPointSet( int argc, char *argv[] )
       {
       pt[d] = point[d];
       }
-    It.Set( parzen->Evaluate( pt ) );
+    points.push_back( pt );
+    }
+
+  typename ParzenFilterType::OutputContainerType values;
+  parzen->EvaluatePoints( points, values );
+
+  unsigned long count = 0;
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    It.Set( values[count++] );
     }
 
   typedef itk::ImageFileWriter<RealImageType> WriterType;
@@ -0,0 +1,142 @@
+#include "itkGaussianListSampleFunction.h"
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageToListSampleFilter.h"
+#include "itkMaskedImageToListSampleAdaptor.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <cmath>
+
+/**
+ * Compares MaskedImageToListSampleAdaptor with the list sample produced by
+ * ImageToListSampleFilter for the same image and mask: same size, same
+ * measurement vectors in the same order, through both GetMeasurementVector()
+ * and the ConstIterator, and the same Gaussian fitted by
+ * GaussianListSampleFunction.
+ */
+
+int main( int argc, char *argv[] )
+{
+  const unsigned int ImageDimension = 3;
+
+  typedef itk::Image<float, ImageDimension> ImageType;
+  typedef itk::Image<unsigned char, ImageDimension> MaskImageType;
+
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 17;
+  size[1] = 12;
+  size[2] = 9;
+  region.SetSize( size );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( region );
+  mask->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  itk::ImageRegionIterator<ImageType> It( image, region );
+  itk::ImageRegionIterator<MaskImageType> ItM( mask, region );
+  for ( It.GoToBegin(), ItM.GoToBegin(); !It.IsAtEnd(); ++It, ++ItM )
+    {
+    It.Set( static_cast<float>( generator->GetNormalVariate( 10.0, 4.0 ) ) );
+    ItM.Set( static_cast<unsigned char>( generator->GetIntegerVariate( 2 ) ) );
+    }
+
+  const MaskImageType::PixelType maskValue = 1;
+
+  typedef itk::Statistics::ImageToListSampleFilter
+    <ImageType, MaskImageType> SamplerType;
+  SamplerType::Pointer sampler = SamplerType::New();
+  sampler->SetInput( image );
+  sampler->SetMaskImage( mask );
+  sampler->SetMaskValue( maskValue );
+  sampler->Update();
+  typedef SamplerType::ListSampleType ListSampleType;
+  const ListSampleType *listSample = sampler->GetOutput();
+
+  typedef itk::Statistics::MaskedImageToListSampleAdaptor
+    <ImageType, MaskImageType> AdaptorType;
+  AdaptorType::Pointer adaptor = AdaptorType::New();
+  adaptor->SetImage( image );
+  adaptor->SetMaskValue( maskValue );
+  adaptor->SetMaskImage( mask );
+
+  if ( adaptor->Size() != listSample->Size() || listSample->Size() == 0 )
+    {
+    std::cerr << "Size " << adaptor->Size() << " instead of "
+      << listSample->Size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( adaptor->GetMeasurementVectorSize() !=
+    listSample->GetMeasurementVectorSize() )
+    {
+    std::cerr << "Measurement vector size "
+      << adaptor->GetMeasurementVectorSize() << " instead of "
+      << listSample->GetMeasurementVectorSize() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( adaptor->GetTotalFrequency() != listSample->GetTotalFrequency() )
+    {
+    std::cerr << "Total frequency " << adaptor->GetTotalFrequency()
+      << " instead of " << listSample->GetTotalFrequency() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  AdaptorType::ConstIterator ItA = adaptor->Begin();
+  ListSampleType::ConstIterator ItL = listSample->Begin();
+  for ( unsigned int n = 0; n < listSample->Size(); n++, ++ItA, ++ItL )
+    {
+    const float expected = listSample->GetMeasurementVector( n )[0];
+    if ( adaptor->GetMeasurementVector( n )[0] != expected ||
+      ItA.GetMeasurementVector()[0] != ItL.GetMeasurementVector()[0] ||
+      ItA.GetInstanceIdentifier() != ItL.GetInstanceIdentifier() ||
+      ItA.GetFrequency() != ItL.GetFrequency() )
+      {
+      std::cerr << "Instance " << n << ": "
+        << adaptor->GetMeasurementVector( n )[0] << " instead of "
+        << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if ( ItA != adaptor->End() || ItL != listSample->End() )
+    {
+    std::cerr << "The iterators do not end together." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::Statistics::GaussianListSampleFunction
+    <ListSampleType, double> ListSampleFunctionType;
+  ListSampleFunctionType::Pointer listSampleFunction =
+    ListSampleFunctionType::New();
+  listSampleFunction->SetInputListSample( listSample );
+
+  typedef itk::Statistics::GaussianListSampleFunction
+    <AdaptorType, double> AdaptorFunctionType;
+  AdaptorFunctionType::Pointer adaptorFunction = AdaptorFunctionType::New();
+  adaptorFunction->SetInputListSample( adaptor );
+
+  for ( unsigned int n = 0; n < 5; n++ )
+    {
+    ListSampleType::MeasurementVectorType measurement;
+    measurement[0] = static_cast<float>( 2.0 + 4.0 * n );
+
+    const double expected = listSampleFunction->Evaluate( measurement );
+    const double value = adaptorFunction->Evaluate( measurement );
+    if ( std::fabs( value - expected ) > 1e-6 * std::fabs( expected ) )
+      {
+      std::cerr << "Gaussian at " << measurement[0] << ": " << value
+        << " instead of " << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -391,6 +391,22 @@ int ApocritaSegmentation( itk::CommandLineParser *parser )
       }
     }
 
+  typename itk::CommandLineParser::OptionType::Pointer mrfUpdateOption =
+    parser->GetOption( "mrf-update-strategy" );
+  if( mrfUpdateOption && mrfUpdateOption->GetNumberOfValues() )
+    {
+    std::string strategy = mrfUpdateOption->GetValue();
+    ConvertToLowerCase( strategy );
+    if( !strategy.compare( std::string( "checkerboard" ) ) )
+      {
+      segmenter->SetMRFUpdateStrategy( SegmentationFilterType::Checkerboard );
+      }
+    else
+      {
+      segmenter->SetMRFUpdateStrategy( SegmentationFilterType::Synchronous );
+      }
+    }
+
   /**
    * euclidean distance
    */
@@ -609,6 +625,17 @@ void InitializeCommandLineOptions( itk::CommandLineParser *parser )
   parser->AddOption( option );
   }
 
+  {
+  std::string description =
+    std::string( "synchronous or checkerboard -- the latter relabels the " ) +
+    std::string( "voxels in place, one color class at a time, in parallel." );
+
+  OptionType::Pointer option = OptionType::New();
+  option->SetLongName( "mrf-update-strategy" );
+  option->SetDescription( description );
+  parser->AddOption( option );
+  }
+
   {
   std::string description
     = std::string( "[classifiedImage," )
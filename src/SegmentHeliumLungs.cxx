@@ -3,7 +3,6 @@
 //#include "itkBinaryMorphologicalClosingImageFilter.h"
 #include "itkBSplineScatteredDataPointSetToImageFilter.h"
 #include "itkConfidenceConnectedImageFilter.h"
-#include "itkConnectedComponentImageFilter.h"
 #include "itkExtractImageFilter.h"
 #include "itkGradientAnisotropicDiffusionImageFilter.h"
 #include "itkGridImageSource.h"
@@ -18,10 +17,10 @@
 #include "itkOtsuThresholdImageFilter.h"
 #include "itkPathIterator.h"
 #include "itkPointSet.h"
-#include "itkRelabelComponentImageFilter.h"
 #include "itkRescaleIntensityImageFilter.h"
 #include "itkSignedMaurerDistanceMapImageFilter.h"
 #include "itkThresholdImageFilter.h"
+#include "itkUnionFindConnectedComponentImageFilter.h"
 
 #include "itkVector.h"
 #include "itkVectorContainer.h"
@@ -158,15 +157,11 @@ int SegmentHeliumLungs3D( int argc, char *argv[] )
    * Step 3:  Get connected components.
    */
 
-  typedef itk::ConnectedComponentImageFilter
+  typedef itk::UnionFindConnectedComponentImageFilter
     <RealImageType, ImageType> ConnectedComponentType;
-  typename ConnectedComponentType::Pointer connecter
+  typename ConnectedComponentType::Pointer relabeler
     = ConnectedComponentType::New();
-  connecter->SetInput( reader->GetOutput() );
-
-  typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelerType;
-  typename RelabelerType::Pointer relabeler = RelabelerType::New();
-  relabeler->SetInput( connecter->GetOutput() );
+  relabeler->SetInput( reader->GetOutput() );
   relabeler->Update();
 
 //		{
@@ -0,0 +1,129 @@
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkSlidingWindowFirstOrderStatisticsImageFilter.h"
+#include "itkVectorImage.h"
+
+#include <cmath>
+#include <vector>
+
+/**
+ * Compares the moments and extrema of SlidingWindowFirstOrderStatistics-
+ * ImageFilter with those of a direct visit of each box, on an image which
+ * is 0 on one half and random integers on the other.  The boxes of the
+ * constant half must have a variance, skewness and kurtosis of exactly 0.
+ */
+
+int main( int argc, char *argv[] )
+{
+  const unsigned int ImageDimension = 3;
+
+  typedef itk::Image<short, ImageDimension> ImageType;
+  typedef itk::VectorImage<float, ImageDimension> VectorImageType;
+
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 30 );
+  region.SetSize( size );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  itk::ImageRegionIteratorWithIndex<ImageType> It( image, region );
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    short value = 0;
+    if ( It.GetIndex()[0] >= static_cast<long>( size[0] / 2 ) )
+      {
+      value = static_cast<short>( generator->GetIntegerVariate( 255 ) );
+      }
+    It.Set( value );
+    }
+
+  typedef itk::SlidingWindowFirstOrderStatisticsImageFilter
+    <ImageType, VectorImageType> FilterType;
+  FilterType::SizeType radius;
+  radius.Fill( 5 );
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetRadius( radius );
+  filter->ComputeHistogramStatisticsOff();
+  filter->Update();
+
+  const char *names[] = { "mean", "minimum", "maximum", "variance",
+    "sigma", "skewness", "kurtosis" };
+
+  std::vector<double> values;
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    const ImageType::IndexType index = It.GetIndex();
+
+    ImageType::RegionType box;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      const long first = vnl_math_max( index[d] - 5L, 0L );
+      const long last = vnl_math_min( index[d] + 5L,
+        static_cast<long>( size[d] ) - 1 );
+      box.SetIndex( d, first );
+      box.SetSize( d, last - first + 1 );
+      }
+
+    values.clear();
+    itk::ImageRegionIteratorWithIndex<ImageType> ItB( image, box );
+    double mean = 0.0;
+    double minimum = itk::NumericTraits<double>::max();
+    double maximum = itk::NumericTraits<double>::NonpositiveMin();
+    for ( ItB.GoToBegin(); !ItB.IsAtEnd(); ++ItB )
+      {
+      values.push_back( ItB.Get() );
+      mean += ItB.Get();
+      minimum = vnl_math_min( minimum, static_cast<double>( ItB.Get() ) );
+      maximum = vnl_math_max( maximum, static_cast<double>( ItB.Get() ) );
+      }
+    const double N = static_cast<double>( values.size() );
+    mean /= N;
+
+    double m2 = 0.0;
+    double m3 = 0.0;
+    double m4 = 0.0;
+    for ( unsigned int n = 0; n < values.size(); n++ )
+      {
+      const double y = values[n] - mean;
+      m2 += y * y / N;
+      m3 += y * y * y / N;
+      m4 += y * y * y * y / N;
+      }
+    const double variance = m2 * N / ( N - 1.0 );
+    double expected[7] = { mean, minimum, maximum, variance,
+      std::sqrt( variance ), 0.0, 0.0 };
+    if ( variance > 0.0 )
+      {
+      expected[5] = m3 / ( variance * std::sqrt( variance ) );
+      expected[6] = m4 / ( variance * variance ) - 3.0;
+      }
+
+    const VectorImageType::PixelType statistics =
+      filter->GetOutput()->GetPixel( index );
+    const bool isFlat = ( maximum == minimum );
+    for ( unsigned int c = 0; c < 7; c++ )
+      {
+      const double difference = std::fabs( statistics[c] - expected[c] );
+      if ( ( isFlat && c >= 3 && statistics[c] != 0.0f ) ||
+        difference > 1e-4 * vnl_math_max( 1.0, std::fabs( expected[c] ) ) )
+        {
+        std::cerr << names[c] << " at " << index << ": " << statistics[c]
+          << " instead of " << expected[c] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
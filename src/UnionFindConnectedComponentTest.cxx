@@ -0,0 +1,135 @@
+#include "itkConnectedComponentImageFilter.h"
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkMultiThreader.h"
+#include "itkRelabelComponentImageFilter.h"
+#include "itkUnionFindConnectedComponentImageFilter.h"
+
+/**
+ * Compares the labels of UnionFindConnectedComponentImageFilter with those
+ * of ConnectedComponentImageFilter followed by RelabelComponentImageFilter
+ * on a random binary volume, for both connectivities and with more threads
+ * requested than the multithreader runs.
+ */
+
+template <class ImageType, class FeatureImageType>
+int CompareConnectedComponents( typename ImageType::Pointer image,
+  typename FeatureImageType::Pointer feature, bool fullyConnected,
+  itk::ThreadIdType numberOfThreads )
+{
+  typedef itk::ConnectedComponentImageFilter<ImageType, ImageType>
+    ReferenceFilterType;
+  typename ReferenceFilterType::Pointer reference = ReferenceFilterType::New();
+  reference->SetInput( image );
+  reference->SetFullyConnected( fullyConnected );
+
+  typedef itk::RelabelComponentImageFilter<ImageType, ImageType>
+    RelabelerType;
+  typename RelabelerType::Pointer relabeler = RelabelerType::New();
+  relabeler->SetInput( reference->GetOutput() );
+  relabeler->Update();
+
+  typedef itk::UnionFindConnectedComponentImageFilter
+    <ImageType, ImageType, FeatureImageType> FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetFeatureImage( feature );
+  filter->SetFullyConnected( fullyConnected );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+
+  if ( filter->GetNumberOfObjects() != relabeler->GetNumberOfObjects() )
+    {
+    std::cerr << "Fully connected " << fullyConnected << ", "
+      << numberOfThreads << " threads: " << filter->GetNumberOfObjects()
+      << " objects instead of " << relabeler->GetNumberOfObjects()
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::ImageRegionConstIterator<ImageType> ItR( relabeler->GetOutput(),
+    relabeler->GetOutput()->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<ImageType> ItF( filter->GetOutput(),
+    filter->GetOutput()->GetLargestPossibleRegion() );
+  for ( ItR.GoToBegin(), ItF.GoToBegin(); !ItR.IsAtEnd(); ++ItR, ++ItF )
+    {
+    if ( ItR.Get() != ItF.Get() )
+      {
+      std::cerr << "Fully connected " << fullyConnected << ", "
+        << numberOfThreads << " threads: label " << ItF.Get()
+        << " instead of " << ItR.Get() << " at " << ItR.GetIndex()
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  for ( unsigned long k = 1; k <= filter->GetNumberOfObjects(); k++ )
+    {
+    if ( filter->GetObjectStatistics( k ).NumberOfPixels !=
+      relabeler->GetSizeOfObjectsInPixels()[k - 1] )
+      {
+      std::cerr << "Fully connected " << fullyConnected << ", "
+        << numberOfThreads << " threads: wrong size of object " << k
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int main( int argc, char *argv[] )
+{
+  const unsigned int ImageDimension = 3;
+
+  typedef itk::Image<unsigned int, ImageDimension> ImageType;
+  typedef itk::Image<float, ImageDimension> FeatureImageType;
+
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 41;
+  size[1] = 33;
+  size[2] = 27;
+  region.SetSize( size );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  FeatureImageType::Pointer feature = FeatureImageType::New();
+  feature->SetRegions( region );
+  feature->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  itk::ImageRegionIterator<ImageType> ItI( image, region );
+  itk::ImageRegionIterator<FeatureImageType> ItF( feature, region );
+  for ( ItI.GoToBegin(), ItF.GoToBegin(); !ItI.IsAtEnd(); ++ItI, ++ItF )
+    {
+    ItI.Set( generator->GetUniformVariate( 0.0, 1.0 ) < 0.3 ? 1 : 0 );
+    ItF.Set( static_cast<float>( generator->GetUniformVariate( 0.0, 100.0 ) ) );
+    }
+
+  // Fewer threads than slabs are requested from the filter
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( 3 );
+
+  const itk::ThreadIdType numberOfThreads[] = { 1, 2, 8, 64 };
+  for ( unsigned int c = 0; c < 2; c++ )
+    {
+    for ( unsigned int t = 0; t < 4; t++ )
+      {
+      if ( CompareConnectedComponents<ImageType, FeatureImageType>( image,
+        feature, c > 0, numberOfThreads[t] ) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}